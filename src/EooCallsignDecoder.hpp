@@ -9,7 +9,8 @@
  *   - Golden-prime interleaver/deinterleaver (N=56, b=37)
  *   - phi0 lookup table
  *   - QPSK soft demodulator (Demod2D / Somap)
- *   - Sum-product belief-propagation LDPC decoder
+ *   - Sum-product belief-propagation LDPC decoder (reference)
+ *   - Flattened layered min-sum LDPC decoder, batched across frames
  *   - Systematic LDPC encoder
  *   - rade_text CRC-8 and 6-bit OTA character mapping
  *
@@ -21,6 +22,10 @@
  *   if (dec.decode(eooOut, rade_n_eoo_bits(dv) / 2, callsign))
  *       std::cout << callsign << "\n";
  *
+ * Usage (decode many channels):
+ *   const float *bufs[n]; int sizes[n]; std::string calls[n]; bool ok[n];
+ *   dec.decodeBatch(bufs, sizes, n, calls, ok);
+ *
  * Usage (encode):
  *   EooCallsignDecoder dec;
  *   std::vector<float> eooOut(rade_n_eoo_bits(dv));
@@ -544,6 +549,163 @@ static int eoo_run_ldpc_decoder(uint8_t out_char[], float input[],
     return iter;
 }
 
+// ---------------------------------------------------------------------------
+// 6b. Flattened layered min-sum decoder
+//
+//    The same HRA_56_56 graph as eoo_init_graph(), flattened at compile time
+//    into one edge list per check node (CSR), so decoding touches no
+//    allocated sub-nodes.  Each check is updated in turn with normalised
+//    min-sum, folding its new messages straight into the variable totals
+//    (layered schedule), which converges in about half the iterations of
+//    the flooding sum-product above.
+//
+//    The frame is the innermost array dimension: N frames from N channels
+//    are decoded in lock step, so every lane runs the same graph and the
+//    lane loops vectorise (SSE/AVX/NEON) without gathers.  Decoding stops
+//    as soon as every lane satisfies all parity checks.
+//
+//    Min-sum finds a codeword more readily than sum-product, and when it
+//    doesn't, its hard decisions on noise often still satisfy 45+ checks, so
+//    callers only accept valid codewords rather than the 0.2 BER gate.  With
+//    alpha = 7/8 that matches the reference's sensitivity and false decode
+//    rate on noise, at about a tenth of the cost.
+// ---------------------------------------------------------------------------
+static const int   kMaxCheckDeg     = kMaxRowWeight + 2;
+static const int   kNumEdges        = kNumParityBits * kMaxCheckDeg - 1;   // c-node 0 has one ladder edge
+static const int   kMinSumMaxIter   = kMaxIter / 2;
+static const float kMinSumAlpha     = 0.875f;
+
+struct EooLdpcGraph {
+    uint16_t start[kNumParityBits + 1];   // edges of check c: [start[c], start[c+1])
+    uint8_t  var[kNumEdges];              // variable node of each edge
+};
+
+// Edge order within a check matches the c-node sub-nodes in eoo_init_graph()
+static constexpr EooLdpcGraph eoo_make_graph()
+{
+    EooLdpcGraph g{};
+    int e = 0;
+    for (int c = 0; c < kNumParityBits; c++) {
+        g.start[c] = static_cast<uint16_t>(e);
+        for (int j = 0; j < kMaxRowWeight; j++)
+            g.var[e++] = static_cast<uint8_t>(kHra5656Rows[c + j * kNumParityBits] - 1);
+        if (c > 0)
+            g.var[e++] = static_cast<uint8_t>((kCodeLength - kNumParityBits) + c - 1);
+        g.var[e++] = static_cast<uint8_t>((kCodeLength - kNumParityBits) + c);
+    }
+    g.start[kNumParityBits] = static_cast<uint16_t>(e);
+    return g;
+}
+
+static constexpr EooLdpcGraph kLdpcGraph = eoo_make_graph();
+static_assert(kLdpcGraph.start[kNumParityBits] == kNumEdges, "HRA_56_56 edge count");
+
+// Number of satisfied parity checks of the hard decisions in Q, per lane
+template <int N>
+static void eoo_count_checks(int sat[N], const float Q[][N])
+{
+    for (int n = 0; n < N; n++) sat[n] = 0;
+    for (int c = 0; c < kNumParityBits; c++) {
+        int par[N] = {};
+        for (int e = kLdpcGraph.start[c]; e < kLdpcGraph.start[c + 1]; e++) {
+            const float *q = Q[kLdpcGraph.var[e]];
+            for (int n = 0; n < N; n++) par[n] ^= (q[n] < 0.0f);
+        }
+        for (int n = 0; n < N; n++) sat[n] += !par[n];
+    }
+}
+
+// Decode N frames.  llr[v][n] is the LLR of bit v of frame n (positive =
+// bit 0 more likely); lanes with active[n] false are skipped (left zeroed).
+// out[n] gets the hard decisions, parityChecks[n] the satisfied checks.
+// Returns the iterations run.
+template <int N>
+static int eoo_minsum_decode(uint8_t out[][kCodeLength], int parityChecks[N],
+                             const float llr[][N], const bool active[N])
+{
+    alignas(32) float Q[kCodeLength][N];
+    alignas(32) float c2v[kNumEdges][N];
+    std::memcpy(Q, llr, sizeof(Q));
+    std::memset(c2v, 0, sizeof(c2v));
+
+    bool done[N];
+    int  n_done = 0;
+    for (int n = 0; n < N; n++) {
+        done[n] = !active[n];
+        n_done += done[n];
+        parityChecks[n] = 0;
+        std::memset(out[n], 0, kCodeLength);
+    }
+
+    int iter = 0;
+    int sat[N];
+    while (n_done < N && iter < kMinSumMaxIter) {
+        iter++;
+        for (int c = 0; c < kNumParityBits; c++) {
+            const int e0  = kLdpcGraph.start[c];
+            const int deg = kLdpcGraph.start[c + 1] - e0;
+
+            // variable to check messages, sign parity and the two smallest
+            // magnitudes (and where the smallest was)
+            alignas(32) float v2c[kMaxCheckDeg][N];
+            float min1[N], min2[N];
+            int   imin[N], sgn[N];
+            for (int n = 0; n < N; n++) {
+                min1[n] = min2[n] = 1e30f;
+                imin[n] = 0;
+                sgn[n]  = 0;
+            }
+            for (int k = 0; k < deg; k++) {
+                const float *q = Q[kLdpcGraph.var[e0 + k]];
+                const float *r = c2v[e0 + k];
+                for (int n = 0; n < N; n++) {
+                    const float t = q[n] - r[n];
+                    const float a = std::fabs(t);
+                    const bool  lt = a < min1[n];
+                    v2c[k][n] = t;
+                    min2[n] = lt ? min1[n] : std::fmin(min2[n], a);
+                    min1[n] = lt ? a : min1[n];
+                    imin[n] = lt ? k : imin[n];
+                    sgn[n] ^= (t < 0.0f);
+                }
+            }
+
+            // new check to variable messages, folded into the totals
+            for (int k = 0; k < deg; k++) {
+                float *q = Q[kLdpcGraph.var[e0 + k]];
+                float *r = c2v[e0 + k];
+                for (int n = 0; n < N; n++) {
+                    const float mag = kMinSumAlpha * ((imin[n] == k) ? min2[n] : min1[n]);
+                    const float m   = (sgn[n] ^ (v2c[k][n] < 0.0f)) ? -mag : mag;
+                    r[n] = m;
+                    q[n] = v2c[k][n] + m;
+                }
+            }
+        }
+
+        // early termination, per lane: keep the first valid codeword
+        eoo_count_checks<N>(sat, Q);
+        for (int n = 0; n < N; n++) {
+            if (done[n] || sat[n] != kNumParityBits) continue;
+            for (int v = 0; v < kCodeLength; v++) out[n][v] = (Q[v][n] < 0.0f);
+            parityChecks[n] = sat[n];
+            done[n] = true;
+            n_done++;
+        }
+    }
+
+    // lanes that never converged report where they ended up
+    if (n_done < N) {
+        if (iter == 0) eoo_count_checks<N>(sat, Q);
+        for (int n = 0; n < N; n++) {
+            if (done[n]) continue;
+            for (int v = 0; v < kCodeLength; v++) out[n][v] = (Q[v][n] < 0.0f);
+            parityChecks[n] = sat[n];
+        }
+    }
+    return iter;
+}
+
 // ---------------------------------------------------------------------------
 // 7. LDPC encoder  (encode() in codec2/src/mpdecode_core.c)
 //
@@ -624,59 +786,69 @@ public:
      */
     bool decode(const float *syms, int symSize, std::string &callsign) const
     {
-        // --- Step 1: deinterleave the first 56 QPSK symbols ---
-        EooComp pending[56];
-        gp_deinterleave_56(pending, reinterpret_cast<const EooComp*>(syms));
-
-        // --- Step 2: RMS over the 56 deinterleaved symbols ----------------
-        //   The denominator is the full symSize (matches rade_text_rx behaviour:
-        //   only the LDPC symbols contribute to the numerator, but the total
-        //   symbol count is used to normalise).
-        float rms = 0.0f;
-        for (int i = 0; i < 56; i++)
-            rms += pending[i].real * pending[i].real
-                 + pending[i].imag * pending[i].imag;
-        rms = std::sqrt(rms / static_cast<float>(symSize));
-
-        // Guard against zero-amplitude input (no signal → can't decode)
-        if (rms < 1e-10f) return false;
+        float llr[kCodeLength][1];
+        if (!symbolsToLlrs(syms, symSize, &llr[0][0], 1)) return false;
+
+        const bool active[1] = {true};
+        uint8_t decoded[1][kCodeLength];
+        int     parityChecks[1];
+        eoo_minsum_decode<1>(decoded, parityChecks, llr, active);
+        return unpack(decoded[0], parityChecks[0], kNumParityBits, callsign);
+    }
 
-        // --- Step 3: soft-decision LDPC decode ----------------------------
-        float amps[56];
-        for (int i = 0; i < 56; i++) amps[i] = rms;
+    /**
+     * decode() using the codec2 flooding sum-product LDPC decoder, kept as
+     * the reference for the min-sum decoder.
+     */
+    bool decodeReference(const float *syms, int symSize, std::string &callsign) const
+    {
+        float llr[kCodeLength];
+        if (!symbolsToLlrs(syms, symSize, llr, 1)) return false;
 
-        float   llr[112];
-        uint8_t decoded[112] = {};
+        uint8_t decoded[kCodeLength] = {};
         int     parityChecks = 0;
-
-        eoo_symbols_to_llrs(llr, pending, amps, /*EsNo=*/3.0f, rms, 56);
         eoo_run_ldpc_decoder(decoded, llr, &parityChecks);
+        return unpack(decoded, parityChecks, kMinParityChecks, callsign);
+    }
 
-        // --- Step 4: BER gate (threshold 0.2, matching rade_text_rx) ------
-        const float ber = static_cast<float>(kNumParityBits - parityChecks)
-                        / static_cast<float>(kNumParityBits);
-        if (ber >= 0.2f) return false;
+    /** Frames decoded in lock step by decodeBatch() */
+    static const int kBatchLanes = 8;
 
-        // --- Step 5: unpack 56 info bits into 9 raw bytes -----------------
-        //   rawStr[0]    = CRC-8  (bits 0–7, standard 8-bit packing)
-        //   rawStr[1..8] = OTA-encoded callsign chars (bits 8–55, 6 bits each)
-        char rawStr[9] = {};
-        for (int b = 0; b < 8; b++)
-            if (decoded[b]) rawStr[0] |= static_cast<char>(1 << b);
-        for (int b = 8; b < 56; b++) {
-            const int off = b - 8;
-            if (decoded[b])
-                rawStr[1 + off / 6] |= static_cast<char>(1 << (off % 6));
+    /**
+     * Decode the EOO buffers of n channels at once, kBatchLanes at a time.
+     * Same result per channel as decode().
+     *
+     * @param syms      syms[i] is channel i's rade_rx() eooOut buffer.
+     * @param symSize   symSize[i] as for decode().
+     * @param n         Number of channels.
+     * @param callsigns callsigns[i] is set for each channel that decodes.
+     * @param ok        ok[i] is set to whether channel i decoded.
+     * @return          Number of channels decoded.
+     */
+    int decodeBatch(const float *const syms[], const int symSize[], int n,
+                    std::string callsigns[], bool ok[]) const
+    {
+        const int N = kBatchLanes;
+        int n_ok = 0;
+        for (int start = 0; start < n; start += N) {
+            const int nb = (n - start < N) ? n - start : N;
+
+            alignas(32) float llr[kCodeLength][N] = {};
+            bool active[N] = {};
+            for (int i = 0; i < nb; i++)
+                active[i] = symbolsToLlrs(syms[start + i], symSize[start + i], &llr[0][i], N);
+
+            uint8_t decoded[N][kCodeLength];
+            int     parityChecks[N];
+            eoo_minsum_decode<N>(decoded, parityChecks, llr, active);
+
+            for (int i = 0; i < nb; i++) {
+                ok[start + i] = active[i] &&
+                    unpack(decoded[i], parityChecks[i], kNumParityBits, callsigns[start + i]);
+                n_ok += ok[start + i];
+            }
         }
-
-        // --- Step 6: CRC-8 check (over OTA bytes, not ASCII) --------------
-        const uint8_t rxCrc   = static_cast<uint8_t>(rawStr[0]);
-        const uint8_t calcCrc = crc8(rawStr + 1, 8);
-        if (rxCrc != calcCrc) return false;
-
-        // --- Step 7: decode OTA values to ASCII callsign ------------------
-        callsign = otaToAscii(rawStr + 1, 8);
-        return true;
+        return n_ok;
     }
 
     /**
@@ -752,6 +924,70 @@ public:
     }
 
 private:
+    // Steps 1-3 of decoding: deinterleave the first 56 QPSK symbols and
+    // turn them into 112 LLRs, written to llr[v * stride].  False if there
+    // is no signal.
+    static bool symbolsToLlrs(const float *syms, int symSize, float *llr, int stride)
+    {
+        // --- Step 1: deinterleave the first 56 QPSK symbols ---
+        EooComp pending[56];
+        gp_deinterleave_56(pending, reinterpret_cast<const EooComp*>(syms));
+
+        // --- Step 2: RMS over the 56 deinterleaved symbols ----------------
+        //   The denominator is the full symSize (matches rade_text_rx behaviour:
+        //   only the LDPC symbols contribute to the numerator, but the total
+        //   symbol count is used to normalise).
+        float rms = 0.0f;
+        for (int i = 0; i < 56; i++)
+            rms += pending[i].real * pending[i].real
+                 + pending[i].imag * pending[i].imag;
+        rms = std::sqrt(rms / static_cast<float>(symSize));
+
+        // Guard against zero-amplitude input (no signal → can't decode)
+        if (rms < 1e-10f) return false;
+
+        // --- Step 3: soft-decision LLRs -----------------------------------
+        float amps[56];
+        for (int i = 0; i < 56; i++) amps[i] = rms;
+
+        float l[kCodeLength];
+        eoo_symbols_to_llrs(l, pending, amps, /*EsNo=*/3.0f, rms, 56);
+        for (int v = 0; v < kCodeLength; v++) llr[v * stride] = l[v];
+        return true;
+    }
+
+    // BER < 0.2 gate of rade_text_rx, as satisfied parity checks
+    static const int kMinParityChecks = 45;
+
+    // Steps 4-7 of decoding: parity gate, unpack, CRC and OTA -> ASCII
+    static bool unpack(const uint8_t decoded[], int parityChecks, int minParityChecks,
+                       std::string &callsign)
+    {
+        // --- Step 4: parity gate ------------------------------------------
+        if (parityChecks < minParityChecks) return false;
+
+        // --- Step 5: unpack 56 info bits into 9 raw bytes -----------------
+        //   rawStr[0]    = CRC-8  (bits 0–7, standard 8-bit packing)
+        //   rawStr[1..8] = OTA-encoded callsign chars (bits 8–55, 6 bits each)
+        char rawStr[9] = {};
+        for (int b = 0; b < 8; b++)
+            if (decoded[b]) rawStr[0] |= static_cast<char>(1 << b);
+        for (int b = 8; b < 56; b++) {
+            const int off = b - 8;
+            if (decoded[b])
+                rawStr[1 + off / 6] |= static_cast<char>(1 << (off % 6));
+        }
+
+        // --- Step 6: CRC-8 check (over OTA bytes, not ASCII) --------------
+        const uint8_t rxCrc   = static_cast<uint8_t>(rawStr[0]);
+        const uint8_t calcCrc = crc8(rawStr + 1, 8);
+        if (rxCrc != calcCrc) return false;
+
+        // --- Step 7: decode OTA values to ASCII callsign ------------------
+        callsign = otaToAscii(rawStr + 1, 8);
+        return true;
+    }
+
     // CRC-8 with generator 0x1D  (calculateCRC8_ in rade_text.c).
     // Stops at the first null byte.
     static uint8_t crc8(const char *data, int maxLen)
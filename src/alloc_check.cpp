@@ -0,0 +1,84 @@
+#include "alloc_check.h"
+
+#ifdef RADAE_ALLOC_CHECK
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+/* ── per-thread state ────────────────────────────────────────────────── */
+
+static thread_local bool          t_active = false;
+static thread_local unsigned long t_count  = 0;
+static std::atomic<unsigned long> g_count  {0};
+
+static inline void note_alloc()
+{
+    if (t_active) {
+        t_count++;
+        g_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void alloc_check_begin()
+{
+    t_count  = 0;
+    t_active = true;
+}
+
+void alloc_check_end(const char* where)
+{
+    t_active = false;
+    if (t_count != 0) {
+        std::fprintf(stderr, "alloc_check: %lu heap allocations in %s steady state\n",
+                     t_count, where);
+        assert(t_count == 0);
+    }
+}
+
+unsigned long alloc_check_count()
+{
+    return g_count.load(std::memory_order_relaxed);
+}
+
+AllocCheckPause::AllocCheckPause()  : was_active_(t_active) { t_active = false; }
+AllocCheckPause::~AllocCheckPause() { t_active = was_active_; }
+
+/* ── global operator new / delete replacements ───────────────────────── */
+
+void* operator new(std::size_t n)
+{
+    note_alloc();
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t n)
+{
+    note_alloc();
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept
+{
+    note_alloc();
+    return std::malloc(n ? n : 1);
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept
+{
+    note_alloc();
+    return std::malloc(n ? n : 1);
+}
+
+void operator delete(void* p) noexcept                   { std::free(p); }
+void operator delete[](void* p) noexcept                 { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept      { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept    { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept   { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif /* RADAE_ALLOC_CHECK */
@@ -0,0 +1,41 @@
+#pragma once
+
+/* ── alloc_check ───────────────────────────────────────────────────────────
+ *
+ *  Debug hook that counts C++ heap allocations made by the real-time
+ *  audio threads once they reach steady state.  Each loop sets up its
+ *  buffers, calls alloc_check_begin(), and calls alloc_check_end() on
+ *  exit; any operator new in between is counted and alloc_check_end()
+ *  reports it and asserts.
+ *
+ *  Configure with -DRADAE_ALLOC_CHECK=ON to enable.  Otherwise the calls
+ *  compile to nothing and the global operator new is untouched.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+#ifdef RADAE_ALLOC_CHECK
+
+void          alloc_check_begin();          // start counting on this thread
+void          alloc_check_end(const char* where);
+unsigned long alloc_check_count();          // allocations counted, all threads
+
+/* Allow allocations in an event path (e.g. EOO callsign decode) */
+class AllocCheckPause {
+public:
+    AllocCheckPause();
+    ~AllocCheckPause();
+private:
+    bool was_active_;
+};
+
+#else
+
+inline void          alloc_check_begin()           {}
+inline void          alloc_check_end(const char*)  {}
+inline unsigned long alloc_check_count()           { return 0; }
+
+class AllocCheckPause {
+public:
+    AllocCheckPause() {}
+};
+
+#endif
@@ -18,6 +18,28 @@ enum AudioError {
     AUDIO_ERROR    = -1,
 };
 
+/* ── sample formats ─────────────────────────────────────────────────────── */
+
+enum AudioFormat {
+    AUDIO_S16 = 0,         // int16_t, full scale 32767
+    AUDIO_F32 = 1,         // float, full scale 1.0
+};
+
+/* ── device tuning ──────────────────────────────────────────────────────────
+ *
+ *  Optional, set with AudioStream::set_tuning() before open().  Zero (or
+ *  false) leaves that choice to the backend.  period_frames is honoured by
+ *  every backend; the rest only by ALSA.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+struct AudioTuning {
+    unsigned long period_frames = 0;      // replaces open()'s frames_per_buffer
+    unsigned int  periods       = 0;      // device buffer = periods * period
+    unsigned long avail_min     = 0;      // wake a blocked read/write once this many
+                                          // frames are ready, default one period
+    bool          mmap          = false;  // transfer through the mmap'ed DMA buffer
+};
+
 /* ── global init / terminate ────────────────────────────────────────────── */
 
 void audio_init();
@@ -39,26 +61,53 @@ public:
     AudioStream& operator=(const AudioStream&) = delete;
 
     /* Open a stream for capture (is_input=true) or playback (is_input=false).
-       device_id is a string from AudioDevice::hw_id.
+       device_id is a string from AudioDevice::hw_id.  frames_per_buffer is
+       the period (PipeWire: quantum) asked of the device; period_frames()
+       says what we actually got.  Samples are read and written in format.
        Returns true on success.  The stream is started immediately. */
     bool open(const std::string& device_id, bool is_input,
               int channels, unsigned int sample_rate,
-              unsigned long frames_per_buffer);
+              unsigned long frames_per_buffer,
+              AudioFormat format = AUDIO_S16);
 
     void close();
 
+    /* applied by the next open() */
+    void               set_tuning(const AudioTuning& t) { tuning_ = t; }
+    const AudioTuning& tuning() const                   { return tuning_; }
+
     /* stop & restart an already-opened stream */
     void stop();
     void start();
 
-    /* Blocking read/write of S16 mono/stereo interleaved samples.
+    /* Blocking read/write of mono/stereo interleaved samples in the format
+       given to open().
        Returns AUDIO_OK, AUDIO_OVERFLOW (read only), or AUDIO_ERROR. */
     AudioError read(void* buffer, unsigned long frames);
     AudioError write(const void* buffer, unsigned long frames);
 
+    /* Zero-copy capture, for streams where capture_in_place() (ALSA with
+       AudioTuning::mmap, when the device takes the format asked for).  capture_begin() waits for up to *frames frames
+       and points *data at them where the device left them, setting *frames
+       to how many there are (fewer at the end of the device buffer).  Hand
+       them back with capture_end() before the next capture_begin().
+       Returns AUDIO_OK, AUDIO_OVERFLOW or AUDIO_ERROR, like read(). */
+    bool       capture_in_place() const;
+    AudioError capture_begin(const void** data, unsigned long* frames);
+    void       capture_end(unsigned long frames);
+
+    /* Frames held by the device: for playback written but not yet played,
+       for capture captured but not yet read.  -1 if the backend can't
+       tell.  Call from the thread doing the reads or writes. */
+    long delay_frames() const;
+
+    /* Frames the device moves per wakeup, 0 if the backend can't tell */
+    unsigned long period_frames() const;
+
     bool is_open() const { return impl_ != nullptr; }
 
 private:
     struct Impl;
-    Impl* impl_ = nullptr;
+    Impl*       impl_ = nullptr;
+    AudioTuning tuning_;
 };
@@ -1,6 +1,8 @@
 #include "audio_stream.h"
 
 #include <alsa/asoundlib.h>
+#include <cmath>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <cstdio>
@@ -67,16 +69,70 @@ std::vector<AudioDevice> audio_enumerate_playback_devices()
 /* ── AudioStream implementation ─────────────────────────────────────────── */
 
 struct AudioStream::Impl {
-    snd_pcm_t* pcm      = nullptr;
-    int        channels = 1;
+    snd_pcm_t*        pcm         = nullptr;
+    int               channels    = 1;
+    bool              is_input    = false;
+    bool              mmap        = false;   // MMAP_INTERLEAVED access
+    snd_pcm_uframes_t period      = 0;
+    snd_pcm_uframes_t mmap_offset = 0;       // of the frames capture_begin() handed out
+
+    /* AUDIO_F32 asked of a device that only takes S16 (most hw: devices):
+       read()/write() convert through s16 */
+    bool                 f32_via_s16 = false;
+    std::vector<int16_t> s16;
 };
 
+/* explicit hardware set up for AudioTuning: exact rate (the pipelines'
+   resamplers assume it), period near the one asked for, and periods of
+   them in the buffer (default 4, as snd_pcm_set_params() would) */
+static int set_hw_params(snd_pcm_t* pcm, snd_pcm_format_t format, int channels,
+                         unsigned int rate, snd_pcm_uframes_t period,
+                         unsigned int periods, bool mmap)
+{
+    snd_pcm_hw_params_t* hw;
+    snd_pcm_hw_params_alloca(&hw);
+
+    int err;
+    if ((err = snd_pcm_hw_params_any(pcm, hw)) < 0) return err;
+    if ((err = snd_pcm_hw_params_set_rate_resample(pcm, hw, 1)) < 0) return err;
+    if ((err = snd_pcm_hw_params_set_access(pcm, hw,
+                   mmap ? SND_PCM_ACCESS_MMAP_INTERLEAVED
+                        : SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) return err;
+    if ((err = snd_pcm_hw_params_set_format(pcm, hw, format)) < 0) return err;
+    if ((err = snd_pcm_hw_params_set_channels(pcm, hw,
+                   static_cast<unsigned int>(channels))) < 0) return err;
+    if ((err = snd_pcm_hw_params_set_rate(pcm, hw, rate, 0)) < 0) return err;
+    if ((err = snd_pcm_hw_params_set_period_size_near(pcm, hw, &period, nullptr)) < 0) return err;
+    if (periods == 0) periods = 4;
+    if ((err = snd_pcm_hw_params_set_periods_near(pcm, hw, &periods, nullptr)) < 0) return err;
+    return snd_pcm_hw_params(pcm, hw);
+}
+
+/* wake a blocked transfer once avail_min frames are ready; capture starts
+   on the first read, playback once the buffer has been filled */
+static int set_sw_params(snd_pcm_t* pcm, bool is_input, snd_pcm_uframes_t avail_min)
+{
+    snd_pcm_uframes_t buffer_size = 0, period_size = 0;
+    int err = snd_pcm_get_params(pcm, &buffer_size, &period_size);
+    if (err < 0) return err;
+    if (avail_min == 0) avail_min = period_size;
+
+    snd_pcm_sw_params_t* sw;
+    snd_pcm_sw_params_alloca(&sw);
+    if ((err = snd_pcm_sw_params_current(pcm, sw)) < 0) return err;
+    if ((err = snd_pcm_sw_params_set_avail_min(pcm, sw, avail_min)) < 0) return err;
+    if ((err = snd_pcm_sw_params_set_start_threshold(pcm, sw,
+                   is_input ? 1 : buffer_size / avail_min * avail_min)) < 0) return err;
+    return snd_pcm_sw_params(pcm, sw);
+}
+
 AudioStream::AudioStream()  = default;
 AudioStream::~AudioStream() { close(); }
 
 bool AudioStream::open(const std::string& device_id, bool is_input,
                        int channels, unsigned int sample_rate,
-                       unsigned long frames_per_buffer)
+                       unsigned long frames_per_buffer,
+                       AudioFormat format)
 {
     fprintf(stderr, "ALSA open\n");
 
@@ -92,27 +148,66 @@ bool AudioStream::open(const std::string& device_id, bool is_input,
         return false;
     }
 
-    /* Convert frames_per_buffer to microseconds for the latency hint */
-    unsigned int latency_us = static_cast<unsigned int>(
-        (unsigned long long)frames_per_buffer * 1000000ULL / sample_rate);
-
-    int err = snd_pcm_set_params(pcm,
-                                 SND_PCM_FORMAT_S16_LE,
-                                 SND_PCM_ACCESS_RW_INTERLEAVED,
-                                 static_cast<unsigned int>(channels),
-                                 sample_rate,
-                                 1,           /* allow software resampling */
-                                 latency_us);
+    const AudioTuning& t = tuning_;
+    bool tuned = t.period_frames || t.periods || t.avail_min || t.mmap;
+
+    auto set_params = [&](snd_pcm_format_t fmt) {
+        int err;
+        if (!tuned) {
+            /* Convert frames_per_buffer to microseconds for the latency hint */
+            unsigned int latency_us = static_cast<unsigned int>(
+                (unsigned long long)frames_per_buffer * 1000000ULL / sample_rate);
+
+            err = snd_pcm_set_params(pcm,
+                                     fmt,
+                                     SND_PCM_ACCESS_RW_INTERLEAVED,
+                                     static_cast<unsigned int>(channels),
+                                     sample_rate,
+                                     1,           /* allow software resampling */
+                                     latency_us);
+        } else {
+            snd_pcm_uframes_t period = t.period_frames ? t.period_frames : frames_per_buffer;
+            err = set_hw_params(pcm, fmt, channels, sample_rate, period, t.periods, t.mmap);
+            if (err >= 0)
+                err = set_sw_params(pcm, is_input, t.avail_min);
+        }
+        return err;
+    };
+
+    /* plug devices convert to anything, but hw: ones mostly take only
+       their native S16; then convert float32 here instead */
+    bool f32_via_s16 = false;
+    int err = set_params(format == AUDIO_F32 ? SND_PCM_FORMAT_FLOAT_LE
+                                             : SND_PCM_FORMAT_S16_LE);
+    if (err < 0 && format == AUDIO_F32) {
+        int err_s16 = set_params(SND_PCM_FORMAT_S16_LE);
+        if (err_s16 >= 0) {
+            fprintf(stderr, "ALSA: '%s' has no float32, converting from S16\n", dev);
+            f32_via_s16 = true;
+            err = err_s16;
+        }
+    }
     if (err < 0) {
-        fprintf(stderr, "ALSA: snd_pcm_set_params failed: %s\n",
-                snd_strerror(err));
+        fprintf(stderr, "ALSA: setting up '%s' failed: %s\n", dev, snd_strerror(err));
         snd_pcm_close(pcm);
         return false;
     }
 
+    snd_pcm_uframes_t buffer_size = 0, period_size = 0;
+    if (snd_pcm_get_params(pcm, &buffer_size, &period_size) < 0)
+        period_size = 0;
+    if (tuned)
+        fprintf(stderr, "ALSA: '%s' period %lu, buffer %lu frames%s\n", dev,
+                static_cast<unsigned long>(period_size),
+                static_cast<unsigned long>(buffer_size), t.mmap ? ", mmap" : "");
+
     impl_           = new Impl;
     impl_->pcm      = pcm;
     impl_->channels = channels;
+    impl_->is_input = is_input;
+    impl_->mmap     = t.mmap;
+    impl_->period   = period_size;
+    impl_->f32_via_s16 = f32_via_s16;
     return true;
 }
 
@@ -143,7 +238,13 @@ AudioError AudioStream::read(void* buffer, unsigned long frames)
 {
     if (!impl_ || !impl_->pcm) return AUDIO_ERROR;
 
-    snd_pcm_sframes_t n = snd_pcm_readi(impl_->pcm, buffer, frames);
+    void* dst = buffer;
+    if (impl_->f32_via_s16) {
+        impl_->s16.resize(frames * impl_->channels);
+        dst = impl_->s16.data();
+    }
+    snd_pcm_sframes_t n = impl_->mmap ? snd_pcm_mmap_readi(impl_->pcm, dst, frames)
+                                      : snd_pcm_readi(impl_->pcm, dst, frames);
     if (n == -EPIPE) {
         /* overrun – recover and signal the caller */
         snd_pcm_prepare(impl_->pcm);
@@ -153,6 +254,11 @@ AudioError AudioStream::read(void* buffer, unsigned long frames)
         snd_pcm_recover(impl_->pcm, static_cast<int>(n), 0);
         return AUDIO_ERROR;
     }
+    if (impl_->f32_via_s16) {
+        float* out = static_cast<float*>(buffer);
+        for (size_t i = 0; i < impl_->s16.size(); i++)
+            out[i] = impl_->s16[i] * (1.0f / 32768.0f);
+    }
     return AUDIO_OK;
 }
 
@@ -160,7 +266,19 @@ AudioError AudioStream::write(const void* buffer, unsigned long frames)
 {
     if (!impl_ || !impl_->pcm) return AUDIO_ERROR;
 
-    snd_pcm_sframes_t n = snd_pcm_writei(impl_->pcm, buffer, frames);
+    const void* src = buffer;
+    if (impl_->f32_via_s16) {
+        const float* in = static_cast<const float*>(buffer);
+        impl_->s16.resize(frames * impl_->channels);
+        for (size_t i = 0; i < impl_->s16.size(); i++) {
+            float v = std::floor(in[i] * 32768.0f + 0.5f);
+            impl_->s16[i] = static_cast<int16_t>(v > 32767.0f ? 32767.0f
+                                               : v < -32768.0f ? -32768.0f : v);
+        }
+        src = impl_->s16.data();
+    }
+    snd_pcm_sframes_t n = impl_->mmap ? snd_pcm_mmap_writei(impl_->pcm, src, frames)
+                                      : snd_pcm_writei(impl_->pcm, src, frames);
     if (n == -EPIPE) {
         /* underrun – recover */
         snd_pcm_prepare(impl_->pcm);
@@ -172,3 +290,70 @@ AudioError AudioStream::write(const void* buffer, unsigned long frames)
     }
     return AUDIO_OK;
 }
+
+bool AudioStream::capture_in_place() const
+{
+    return impl_ && impl_->mmap && impl_->is_input && !impl_->f32_via_s16;
+}
+
+AudioError AudioStream::capture_begin(const void** data, unsigned long* frames)
+{
+    if (!capture_in_place()) return AUDIO_ERROR;
+
+    snd_pcm_t* pcm  = impl_->pcm;
+    AudioError ret  = AUDIO_OK;
+    auto       want = static_cast<snd_pcm_uframes_t>(*frames);
+
+    /* mmap capture isn't started by a read, start it ourselves */
+    if (snd_pcm_state(pcm) == SND_PCM_STATE_PREPARED)
+        snd_pcm_start(pcm);
+
+    for (;;) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+        int err = avail < 0 ? static_cast<int>(avail) : 0;
+        if (err == 0) {
+            if (static_cast<snd_pcm_uframes_t>(avail) >= want) break;
+            err = snd_pcm_wait(pcm, 1000);
+            if (err == 0) return AUDIO_ERROR;          // no data for a second
+            if (err > 0) continue;
+        }
+        /* overrun (or suspend): recover, restart and tell the caller */
+        if (snd_pcm_recover(pcm, err, 1) < 0) return AUDIO_ERROR;
+        snd_pcm_start(pcm);
+        ret = AUDIO_OVERFLOW;
+    }
+
+    const snd_pcm_channel_area_t* areas = nullptr;
+    snd_pcm_uframes_t offset = 0, n = want;
+    if (snd_pcm_mmap_begin(pcm, &areas, &offset, &n) < 0) return AUDIO_ERROR;
+
+    /* interleaved: every channel shares one area, frame i at first + i * step bits */
+    *data  = static_cast<const char*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+    *frames = static_cast<unsigned long>(n);
+    impl_->mmap_offset = offset;
+    return ret;
+}
+
+void AudioStream::capture_end(unsigned long frames)
+{
+    if (!capture_in_place()) return;
+
+    snd_pcm_sframes_t n = snd_pcm_mmap_commit(impl_->pcm, impl_->mmap_offset,
+                                              static_cast<snd_pcm_uframes_t>(frames));
+    if (n < 0 || static_cast<unsigned long>(n) != frames)
+        snd_pcm_recover(impl_->pcm, n < 0 ? static_cast<int>(n) : -EPIPE, 1);
+}
+
+long AudioStream::delay_frames() const
+{
+    if (!impl_ || !impl_->pcm) return -1;
+
+    snd_pcm_sframes_t d = 0;
+    if (snd_pcm_delay(impl_->pcm, &d) < 0 || d < 0) return -1;
+    return static_cast<long>(d);
+}
+
+unsigned long AudioStream::period_frames() const
+{
+    return impl_ ? static_cast<unsigned long>(impl_->period) : 0;
+}
@@ -0,0 +1,410 @@
+#include "audio_stream.h"
+#include "spsc_ring.h"
+
+#include <pipewire/pipewire.h>
+#include <spa/param/audio/format-utils.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <semaphore.h>
+#include <string>
+#include <vector>
+
+/* ── global init / terminate ────────────────────────────────────────────── */
+
+void audio_init()      { pw_init(nullptr, nullptr); }
+void audio_terminate() { pw_deinit(); }
+
+/* ── device enumeration via the registry ────────────────────────────────── */
+
+struct EnumCtx {
+    std::vector<AudioDevice>* devices;
+    const char*               media_class;   // "Audio/Source" or "Audio/Sink"
+    pw_main_loop*             loop;
+    int                       pending;
+};
+
+static void registry_global(void* userdata, uint32_t /*id*/, uint32_t /*permissions*/,
+                            const char* type, uint32_t /*version*/,
+                            const struct spa_dict* props)
+{
+    auto* ctx = static_cast<EnumCtx*>(userdata);
+    if (!props || std::strcmp(type, PW_TYPE_INTERFACE_Node) != 0) return;
+
+    const char* cls  = spa_dict_lookup(props, PW_KEY_MEDIA_CLASS);
+    const char* name = spa_dict_lookup(props, PW_KEY_NODE_NAME);
+    if (!cls || !name || std::strcmp(cls, ctx->media_class) != 0) return;
+
+    const char* desc = spa_dict_lookup(props, PW_KEY_NODE_DESCRIPTION);
+    AudioDevice ad;
+    ad.name  = desc ? desc : name;
+    ad.hw_id = name;
+    ctx->devices->push_back(std::move(ad));
+}
+
+/* the sync we sent after asking for the registry has come back, so every
+   global that existed then has been announced */
+static void core_done(void* userdata, uint32_t id, int seq)
+{
+    auto* ctx = static_cast<EnumCtx*>(userdata);
+    if (id == PW_ID_CORE && seq == ctx->pending)
+        pw_main_loop_quit(ctx->loop);
+}
+
+static std::vector<AudioDevice> enumerate_pipewire(bool capture)
+{
+    fprintf(stderr, "Enumerating PipeWire devices\n");
+
+    std::vector<AudioDevice> devices;
+
+    pw_main_loop* ml = pw_main_loop_new(nullptr);
+    if (!ml) return devices;
+    pw_context* context = pw_context_new(pw_main_loop_get_loop(ml), nullptr, 0);
+    pw_core*    core    = context ? pw_context_connect(context, nullptr, 0) : nullptr;
+    if (!core) {
+        if (context) pw_context_destroy(context);
+        pw_main_loop_destroy(ml);
+        return devices;
+    }
+
+    EnumCtx ectx{&devices, capture ? "Audio/Source" : "Audio/Sink", ml, 0};
+
+    pw_registry* registry = pw_core_get_registry(core, PW_VERSION_REGISTRY, 0);
+    pw_registry_events registry_events{};
+    registry_events.version = PW_VERSION_REGISTRY_EVENTS;
+    registry_events.global  = registry_global;
+    spa_hook registry_listener;
+    spa_zero(registry_listener);
+    pw_registry_add_listener(registry, &registry_listener, &registry_events, &ectx);
+
+    pw_core_events core_events{};
+    core_events.version = PW_VERSION_CORE_EVENTS;
+    core_events.done    = core_done;
+    spa_hook core_listener;
+    spa_zero(core_listener);
+    pw_core_add_listener(core, &core_listener, &core_events, &ectx);
+
+    ectx.pending = pw_core_sync(core, PW_ID_CORE, 0);
+    pw_main_loop_run(ml);
+
+    spa_hook_remove(&core_listener);
+    spa_hook_remove(&registry_listener);
+    pw_proxy_destroy(reinterpret_cast<pw_proxy*>(registry));
+    pw_core_disconnect(core);
+    pw_context_destroy(context);
+    pw_main_loop_destroy(ml);
+
+    return devices;
+}
+
+std::vector<AudioDevice> audio_enumerate_capture_devices()
+{
+    return enumerate_pipewire(true);
+}
+
+std::vector<AudioDevice> audio_enumerate_playback_devices()
+{
+    return enumerate_pipewire(false);
+}
+
+/* ── AudioStream implementation via pw_stream ───────────────────────────────
+ *
+ *  The PipeWire data thread calls on_process() once per graph cycle
+ *  (quantum) and moves samples between the stream buffer and a byte-wide
+ *  SpscRing; it never blocks or allocates.  read()/write() keep the
+ *  blocking API by waiting on a semaphore posted from on_process().
+ *
+ *  The quantum is requested with node.latency = frames_per_buffer/rate,
+ *  and the playback ring only holds a couple of quanta, so the device
+ *  latency we report is most of the latency there is.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+static constexpr long WAIT_TIMEOUT_NS = 200000000;   // read/write give up after 200 ms
+
+/* everything the data thread callbacks touch; they can't name the private
+   AudioStream::Impl, which is just this */
+struct PwStream {
+    pw_thread_loop*  loop        = nullptr;
+    pw_stream*       stream      = nullptr;
+    bool             is_input    = false;
+    unsigned int     rate        = 0;
+    size_t           frame_bytes = 2;
+
+    SpscRing<uint8_t>               ring;             // interleaved samples, whole frames
+    sem_t                           wake;             // posted once per cycle
+    std::atomic<int>                state    {PW_STREAM_STATE_UNCONNECTED};
+    std::atomic<bool>               overflow {false}; // capture ring was full
+    std::atomic<unsigned long>      period   {0};     // frames in the last cycle
+};
+
+struct AudioStream::Impl : PwStream {};
+
+static void on_state_changed(void* userdata, enum pw_stream_state /*old*/,
+                             enum pw_stream_state state, const char* error)
+{
+    auto* impl = static_cast<PwStream*>(userdata);
+    if (state == PW_STREAM_STATE_ERROR)
+        fprintf(stderr, "PipeWire: stream error: %s\n", error ? error : "unknown");
+    impl->state.store(state, std::memory_order_release);
+    sem_post(&impl->wake);
+    pw_thread_loop_signal(impl->loop, false);
+}
+
+static void on_process(void* userdata)
+{
+    auto* impl = static_cast<PwStream*>(userdata);
+
+    pw_buffer* b = pw_stream_dequeue_buffer(impl->stream);
+    if (!b) return;
+
+    spa_data& d  = b->buffer->datas[0];
+    auto*     p  = static_cast<uint8_t*>(d.data);
+    size_t    fb = impl->frame_bytes;
+
+    if (p && impl->is_input) {
+        uint32_t offset = std::min(d.chunk->offset, d.maxsize);
+        size_t   bytes  = std::min<size_t>(d.chunk->size, d.maxsize - offset) / fb * fb;
+        size_t   space  = impl->ring.space() / fb * fb;
+        if (bytes > space) impl->overflow.store(true, std::memory_order_relaxed);
+        impl->ring.write(p + offset, std::min(bytes, space));
+        impl->period.store(bytes / fb, std::memory_order_relaxed);
+    } else if (p) {
+        uint64_t frames = d.maxsize / fb;
+#if PW_CHECK_VERSION(0, 3, 49)
+        if (b->requested) frames = std::min<uint64_t>(frames, b->requested);
+#endif
+        size_t bytes = static_cast<size_t>(frames) * fb;
+        size_t got   = impl->ring.read(p, bytes);
+        std::memset(p + got, 0, bytes - got);   // ran dry: play silence
+
+        d.chunk->offset = 0;
+        d.chunk->stride = static_cast<int32_t>(fb);
+        d.chunk->size   = static_cast<uint32_t>(bytes);
+        impl->period.store(static_cast<unsigned long>(frames), std::memory_order_relaxed);
+    }
+
+    pw_stream_queue_buffer(impl->stream, b);
+    sem_post(&impl->wake);
+}
+
+/* wait for the next cycle, false on timeout or once the stream has failed */
+static bool wait_cycle(PwStream* impl)
+{
+    if (impl->state.load(std::memory_order_acquire) == PW_STREAM_STATE_ERROR)
+        return false;
+
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += WAIT_TIMEOUT_NS;
+    if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+
+    while (sem_timedwait(&impl->wake, &ts) != 0)
+        if (errno != EINTR) return false;
+    return true;
+}
+
+AudioStream::AudioStream()  = default;
+AudioStream::~AudioStream() { close(); }
+
+bool AudioStream::open(const std::string& device_id, bool is_input,
+                       int channels, unsigned int sample_rate,
+                       unsigned long frames_per_buffer,
+                       AudioFormat format)
+{
+    fprintf(stderr, "PipeWire open\n");
+
+    close();
+
+    if (tuning_.period_frames) frames_per_buffer = tuning_.period_frames;
+
+    auto* impl = new Impl;
+    impl->is_input    = is_input;
+    impl->rate        = sample_rate;
+    impl->frame_bytes = static_cast<size_t>(channels)
+                      * (format == AUDIO_F32 ? sizeof(float) : sizeof(int16_t));
+
+    /* capture has room for a DSP thread that's a few quanta late, playback
+       only double buffers so write() paces the caller */
+    impl->ring.reset((is_input ? 8 : 2) * frames_per_buffer * impl->frame_bytes);
+    sem_init(&impl->wake, 0, 0);
+
+    impl->loop = pw_thread_loop_new("radae-audio", nullptr);
+    if (!impl->loop) {
+        sem_destroy(&impl->wake);
+        delete impl;
+        return false;
+    }
+
+    pw_properties* props = pw_properties_new(
+        PW_KEY_MEDIA_TYPE,     "Audio",
+        PW_KEY_MEDIA_CATEGORY, is_input ? "Capture" : "Playback",
+        PW_KEY_MEDIA_ROLE,     "Communication",
+        nullptr);
+    pw_properties_setf(props, PW_KEY_NODE_LATENCY, "%lu/%u", frames_per_buffer, sample_rate);
+    if (!device_id.empty()) {
+#ifdef PW_KEY_TARGET_OBJECT
+        pw_properties_set(props, PW_KEY_TARGET_OBJECT, device_id.c_str());
+#else
+        pw_properties_set(props, PW_KEY_NODE_TARGET, device_id.c_str());
+#endif
+    }
+
+    static const pw_stream_events events = [] {
+        pw_stream_events ev{};
+        ev.version       = PW_VERSION_STREAM_EVENTS;
+        ev.state_changed = on_state_changed;
+        ev.process       = on_process;
+        return ev;
+    }();
+
+    spa_audio_info_raw info{};
+    info.format   = format == AUDIO_F32 ? SPA_AUDIO_FORMAT_F32 : SPA_AUDIO_FORMAT_S16;
+    info.rate     = sample_rate;
+    info.channels = static_cast<uint32_t>(channels);
+    if (channels == 1) {
+        info.position[0] = SPA_AUDIO_CHANNEL_MONO;
+    } else if (channels == 2) {
+        info.position[0] = SPA_AUDIO_CHANNEL_FL;
+        info.position[1] = SPA_AUDIO_CHANNEL_FR;
+    }
+
+    uint8_t pod_buf[1024];
+    spa_pod_builder builder;
+    spa_pod_builder_init(&builder, pod_buf, sizeof pod_buf);
+    const spa_pod* params[1];
+    params[0] = spa_format_audio_raw_build(&builder, SPA_PARAM_EnumFormat, &info);
+
+    pw_thread_loop_start(impl->loop);
+    pw_thread_loop_lock(impl->loop);
+
+    impl->stream = pw_stream_new_simple(pw_thread_loop_get_loop(impl->loop),
+                                        is_input ? "capture" : "playback",
+                                        props, &events, impl);
+    int err = impl->stream ? pw_stream_connect(
+        impl->stream,
+        is_input ? PW_DIRECTION_INPUT : PW_DIRECTION_OUTPUT,
+        PW_ID_ANY,
+        static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT |
+                                     PW_STREAM_FLAG_MAP_BUFFERS |
+                                     PW_STREAM_FLAG_RT_PROCESS),
+        params, 1) : -1;
+
+    /* wait for the format to be negotiated and the node to be linked */
+    while (err >= 0) {
+        int st = impl->state.load(std::memory_order_acquire);
+        if (st == PW_STREAM_STATE_PAUSED || st == PW_STREAM_STATE_STREAMING) break;
+        if (st == PW_STREAM_STATE_ERROR || pw_thread_loop_timed_wait(impl->loop, 2) != 0)
+            err = -1;
+    }
+    pw_thread_loop_unlock(impl->loop);
+
+    impl_ = impl;
+    if (err < 0) {
+        fprintf(stderr, "PipeWire: failed to open '%s'\n",
+                device_id.empty() ? "default" : device_id.c_str());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AudioStream::close()
+{
+    if (!impl_) return;
+    pw_thread_loop_stop(impl_->loop);
+    if (impl_->stream) pw_stream_destroy(impl_->stream);
+    pw_thread_loop_destroy(impl_->loop);
+    sem_destroy(&impl_->wake);
+    delete impl_;
+    impl_ = nullptr;
+}
+
+void AudioStream::stop()
+{
+    if (!impl_ || !impl_->stream) return;
+    pw_thread_loop_lock(impl_->loop);
+    pw_stream_set_active(impl_->stream, false);
+    pw_thread_loop_unlock(impl_->loop);
+
+    /* capture: nothing captured before the stop should be read after it.
+       We're the ring's consumer, so drop it from here */
+    if (impl_->is_input) {
+        uint8_t scratch[256];
+        while (impl_->ring.read(scratch, sizeof scratch) > 0) {}
+    }
+}
+
+void AudioStream::start()
+{
+    if (!impl_ || !impl_->stream) return;
+    pw_thread_loop_lock(impl_->loop);
+    pw_stream_set_active(impl_->stream, true);
+    pw_thread_loop_unlock(impl_->loop);
+}
+
+AudioError AudioStream::read(void* buffer, unsigned long frames)
+{
+    if (!impl_ || !impl_->stream || !impl_->is_input) return AUDIO_ERROR;
+
+    auto*  dst  = static_cast<uint8_t*>(buffer);
+    size_t need = frames * impl_->frame_bytes;
+    while (need > 0) {
+        size_t n = impl_->ring.read(dst, need);
+        dst  += n;
+        need -= n;
+        if (need > 0 && !wait_cycle(impl_)) return AUDIO_ERROR;
+    }
+    return impl_->overflow.exchange(false, std::memory_order_relaxed) ? AUDIO_OVERFLOW
+                                                                      : AUDIO_OK;
+}
+
+AudioError AudioStream::write(const void* buffer, unsigned long frames)
+{
+    if (!impl_ || !impl_->stream || impl_->is_input) return AUDIO_ERROR;
+
+    auto*  src  = static_cast<const uint8_t*>(buffer);
+    size_t left = frames * impl_->frame_bytes;
+    while (left > 0) {
+        size_t n = impl_->ring.write(src, left);
+        src  += n;
+        left -= n;
+        if (left > 0 && !wait_cycle(impl_)) return AUDIO_ERROR;
+    }
+    return AUDIO_OK;
+}
+
+long AudioStream::delay_frames() const
+{
+    if (!impl_ || !impl_->stream) return -1;
+
+    pw_time t{};
+#if PW_CHECK_VERSION(0, 3, 50)
+    if (pw_stream_get_time_n(impl_->stream, &t, sizeof t) < 0) return -1;
+#else
+    if (pw_stream_get_time(impl_->stream, &t) < 0) return -1;
+#endif
+    if (t.rate.denom == 0) return -1;
+
+    /* graph delay to or from the device, plus what sits in our ring */
+    double dev_s  = static_cast<double>(t.delay) * t.rate.num / t.rate.denom;
+    long   frames = static_cast<long>(dev_s * impl_->rate + 0.5);
+    return frames + static_cast<long>(impl_->ring.size() / impl_->frame_bytes);
+}
+
+unsigned long AudioStream::period_frames() const
+{
+    return impl_ ? impl_->period.load(std::memory_order_relaxed) : 0;
+}
+
+bool AudioStream::capture_in_place() const { return false; }
+
+AudioError AudioStream::capture_begin(const void** /*data*/, unsigned long* /*frames*/)
+{
+    return AUDIO_ERROR;
+}
+
+void AudioStream::capture_end(unsigned long /*frames*/) {}
@@ -45,7 +45,9 @@ std::vector<AudioDevice> audio_enumerate_playback_devices()
 /* ── AudioStream implementation ─────────────────────────────────────────── */
 
 struct AudioStream::Impl {
-    PaStream* stream = nullptr;
+    PaStream*     stream   = nullptr;
+    bool          is_input = false;
+    unsigned long period   = 0;
 };
 
 AudioStream::AudioStream()  = default;
@@ -53,12 +55,15 @@ AudioStream::~AudioStream() { close(); }
 
 bool AudioStream::open(const std::string& device_id, bool is_input,
                        int channels, unsigned int sample_rate,
-                       unsigned long frames_per_buffer)
+                       unsigned long frames_per_buffer,
+                       AudioFormat format)
 {
     fprintf(stderr, "PortAudio open\n");
 
     close();
 
+    if (tuning_.period_frames) frames_per_buffer = tuning_.period_frames;
+
     PaDeviceIndex dev = static_cast<PaDeviceIndex>(std::stoi(device_id));
     const PaDeviceInfo* info = Pa_GetDeviceInfo(dev);
     if (!info) return false;
@@ -66,7 +71,7 @@ bool AudioStream::open(const std::string& device_id, bool is_input,
     PaStreamParameters params{};
     params.device                    = dev;
     params.channelCount              = channels;
-    params.sampleFormat              = paInt16;
+    params.sampleFormat              = format == AUDIO_F32 ? paFloat32 : paInt16;
     params.suggestedLatency          = is_input ? info->defaultLowInputLatency
                                                 : info->defaultHighOutputLatency;
     params.hostApiSpecificStreamInfo = nullptr;
@@ -90,7 +95,9 @@ bool AudioStream::open(const std::string& device_id, bool is_input,
     }
 
     impl_ = new Impl;
-    impl_->stream = stream;
+    impl_->stream   = stream;
+    impl_->is_input = is_input;
+    impl_->period   = frames_per_buffer;
     return true;
 }
 
@@ -129,3 +136,33 @@ AudioError AudioStream::write(const void* buffer, unsigned long frames)
     if (err == paNoError) return AUDIO_OK;
     return AUDIO_ERROR;
 }
+
+long AudioStream::delay_frames() const
+{
+    if (!impl_) return -1;
+    const PaStreamInfo* info = Pa_GetStreamInfo(impl_->stream);
+    if (!info) return -1;
+
+    /* host latency, plus what is queued in PortAudio's own buffer */
+    double latency = impl_->is_input ? info->inputLatency : info->outputLatency;
+    long   frames  = static_cast<long>(latency * info->sampleRate + 0.5);
+    if (impl_->is_input) {
+        long avail = Pa_GetStreamReadAvailable(impl_->stream);
+        if (avail > 0) frames += avail;
+    }
+    return frames;
+}
+
+unsigned long AudioStream::period_frames() const
+{
+    return impl_ ? impl_->period : 0;
+}
+
+bool AudioStream::capture_in_place() const { return false; }
+
+AudioError AudioStream::capture_begin(const void** /*data*/, unsigned long* /*frames*/)
+{
+    return AUDIO_ERROR;
+}
+
+void AudioStream::capture_end(unsigned long /*frames*/) {}
@@ -111,7 +111,10 @@ std::vector<AudioDevice> audio_enumerate_playback_devices()
 /* ── AudioStream implementation via pa_simple ───────────────────────────── */
 
 struct AudioStream::Impl {
-    pa_simple* simple = nullptr;
+    pa_simple*    simple      = nullptr;
+    unsigned int  rate        = 0;
+    size_t        frame_bytes = 2;
+    unsigned long period      = 0;   // capture fragment we asked for
 };
 
 AudioStream::AudioStream()  = default;
@@ -119,14 +122,17 @@ AudioStream::~AudioStream() { close(); }
 
 bool AudioStream::open(const std::string& device_id, bool is_input,
                        int channels, unsigned int sample_rate,
-                       unsigned long frames_per_buffer)
+                       unsigned long frames_per_buffer,
+                       AudioFormat format)
 {
     fprintf(stderr, "PulseAudio open\n");
 
     close();
 
+    if (tuning_.period_frames) frames_per_buffer = tuning_.period_frames;
+
     pa_sample_spec ss{};
-    ss.format   = PA_SAMPLE_S16LE;
+    ss.format   = format == AUDIO_F32 ? PA_SAMPLE_FLOAT32LE : PA_SAMPLE_S16LE;
     ss.rate     = sample_rate;
     ss.channels = static_cast<uint8_t>(channels);
 
@@ -161,7 +167,10 @@ bool AudioStream::open(const std::string& device_id, bool is_input,
     if (!s) return false;
 
     impl_ = new Impl;
-    impl_->simple = s;
+    impl_->simple      = s;
+    impl_->rate        = sample_rate;
+    impl_->frame_bytes = pa_frame_size(&ss);
+    impl_->period      = is_input ? frames_per_buffer : 0;
     return true;
 }
 
@@ -189,9 +198,7 @@ AudioError AudioStream::read(void* buffer, unsigned long frames)
     if (!impl_ || !impl_->simple) return AUDIO_ERROR;
 
     /* pa_simple_read takes byte count */
-    size_t bytes = frames * 2;   /* S16 mono = 2 bytes per frame */
-    /* Note: for stereo the caller should account for channels in the buffer,
-       but pa_simple handles it automatically via the sample spec */
+    size_t bytes = frames * impl_->frame_bytes;
     int error = 0;
     if (pa_simple_read(impl_->simple, buffer, bytes, &error) < 0)
         return AUDIO_ERROR;
@@ -202,9 +209,34 @@ AudioError AudioStream::write(const void* buffer, unsigned long frames)
 {
     if (!impl_ || !impl_->simple) return AUDIO_ERROR;
 
-    size_t bytes = frames * 2;   /* S16 mono = 2 bytes per frame */
+    size_t bytes = frames * impl_->frame_bytes;
     int error = 0;
     if (pa_simple_write(impl_->simple, buffer, bytes, &error) < 0)
         return AUDIO_ERROR;
     return AUDIO_OK;
 }
+
+long AudioStream::delay_frames() const
+{
+    if (!impl_ || !impl_->simple) return -1;
+
+    int error = 0;
+    pa_usec_t us = pa_simple_get_latency(impl_->simple, &error);
+    if (us == static_cast<pa_usec_t>(-1)) return -1;
+    return static_cast<long>(us * impl_->rate / 1000000);
+}
+
+unsigned long AudioStream::period_frames() const
+{
+    /* pa_simple doesn't say what the server picked, playback is unknown */
+    return impl_ ? impl_->period : 0;
+}
+
+bool AudioStream::capture_in_place() const { return false; }
+
+AudioError AudioStream::capture_begin(const void** /*data*/, unsigned long* /*frames*/)
+{
+    return AUDIO_ERROR;
+}
+
+void AudioStream::capture_end(unsigned long /*frames*/) {}
@@ -0,0 +1,282 @@
+#include "feature_stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char kMagic[4]   = {'R', 'A', 'D', 'F'};
+static constexpr uint8_t kVersion = 2;
+
+/* ── wire format ─────────────────────────────────────────────────────── */
+
+/* little endian byte by byte, floats as their IEEE 754 bits */
+static void put_u32(uint8_t* buf, size_t off, uint32_t v)
+{
+    for (int i = 0; i < 4; i++) buf[off + i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t* buf, size_t off)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(buf[off + i]) << (8 * i);
+    return v;
+}
+
+static void put_f32(uint8_t* buf, size_t off, float f)
+{
+    uint32_t v;
+    std::memcpy(&v, &f, sizeof v);
+    put_u32(buf, off, v);
+}
+
+static float get_f32(const uint8_t* buf, size_t off)
+{
+    uint32_t v = get_u32(buf, off);
+    float    f;
+    std::memcpy(&f, &v, sizeof f);
+    return f;
+}
+
+/* payload bytes for n frames */
+static size_t payload_size(FeatEncoding enc, int n)
+{
+    if (n == 0) return 0;
+    if (enc == FEAT_Q8)
+        return FEATSTREAM_NB_FEATURES * 2 * sizeof(float)
+             + static_cast<size_t>(n) * FEATSTREAM_NB_FEATURES;
+    return static_cast<size_t>(n) * FEATSTREAM_NB_FEATURES * sizeof(float);
+}
+
+size_t featstream_encode(const FeaturePacket& p, FeatEncoding enc, uint8_t* buf, size_t cap)
+{
+    if (p.n_frames < 0 || p.n_frames > FEATSTREAM_MAX_FRAMES) return 0;
+    size_t len = FEATSTREAM_HEADER + payload_size(enc, p.n_frames);
+    if (len > cap) return 0;
+
+    std::memcpy(buf, kMagic, 4);
+    buf[4] = kVersion;
+    buf[5] = enc;
+    buf[6] = p.flags;
+    buf[7] = static_cast<uint8_t>(p.n_frames);
+    put_u32(buf, 8,  p.seq);
+    put_u32(buf, 12, p.mf);
+    put_f32(buf, 16, p.snr_dB);
+    put_f32(buf, 20, p.freq_offset);
+    std::memset(buf + 24, 0, 16);
+    if (p.flags & FEATPKT_CALLSIGN)
+        std::memcpy(buf + 24, p.callsign, strnlen(p.callsign, 15));
+    put_u32(buf, 40, p.session);
+
+    uint8_t* out = buf + FEATSTREAM_HEADER;
+    if (enc == FEAT_F32) {
+        for (int f = 0; f < p.n_frames; f++)
+            for (int d = 0; d < FEATSTREAM_NB_FEATURES; d++)
+                put_f32(out, (f * FEATSTREAM_NB_FEATURES + d) * sizeof(float), p.feat[f][d]);
+        return len;
+    }
+
+    /* Q8: each feature spans its own range over the modem frame */
+    if (p.n_frames == 0) return len;
+    uint8_t* q = out + FEATSTREAM_NB_FEATURES * 2 * sizeof(float);
+    for (int d = 0; d < FEATSTREAM_NB_FEATURES; d++) {
+        float lo = p.feat[0][d], hi = lo;
+        for (int f = 1; f < p.n_frames; f++) {
+            lo = std::min(lo, p.feat[f][d]);
+            hi = std::max(hi, p.feat[f][d]);
+        }
+        float step = (hi - lo) / 255.0f;
+        put_f32(out, d * 2 * sizeof(float),     lo);
+        put_f32(out, d * 2 * sizeof(float) + 4, step);
+        for (int f = 0; f < p.n_frames; f++) {
+            long v = step > 0.0f ? std::lrint((p.feat[f][d] - lo) / step) : 0;
+            q[f * FEATSTREAM_NB_FEATURES + d] = static_cast<uint8_t>(std::max(0L, std::min(255L, v)));
+        }
+    }
+    return len;
+}
+
+bool featstream_decode(const uint8_t* buf, size_t len, FeaturePacket* p)
+{
+    if (len < FEATSTREAM_HEADER || std::memcmp(buf, kMagic, 4) != 0 || buf[4] != kVersion)
+        return false;
+    FeatEncoding enc = static_cast<FeatEncoding>(buf[5]);
+    int n = buf[7];
+    if ((enc != FEAT_F32 && enc != FEAT_Q8) || n > FEATSTREAM_MAX_FRAMES ||
+        len != FEATSTREAM_HEADER + payload_size(enc, n))
+        return false;
+
+    p->flags       = buf[6];
+    p->n_frames    = n;
+    p->seq         = get_u32(buf, 8);
+    p->mf          = get_u32(buf, 12);
+    p->snr_dB      = get_f32(buf, 16);
+    p->freq_offset = get_f32(buf, 20);
+    std::memcpy(p->callsign, buf + 24, 15);
+    p->callsign[15] = '\0';
+    p->session     = get_u32(buf, 40);
+
+    const uint8_t* in = buf + FEATSTREAM_HEADER;
+    if (enc == FEAT_F32) {
+        for (int f = 0; f < n; f++)
+            for (int d = 0; d < FEATSTREAM_NB_FEATURES; d++)
+                p->feat[f][d] = get_f32(in, (f * FEATSTREAM_NB_FEATURES + d) * sizeof(float));
+        return true;
+    }
+
+    if (n == 0) return true;
+    const uint8_t* q = in + FEATSTREAM_NB_FEATURES * 2 * sizeof(float);
+    for (int d = 0; d < FEATSTREAM_NB_FEATURES; d++) {
+        float lo   = get_f32(in, d * 2 * sizeof(float));
+        float step = get_f32(in, d * 2 * sizeof(float) + 4);
+        for (int f = 0; f < n; f++)
+            p->feat[f][d] = lo + step * q[f * FEATSTREAM_NB_FEATURES + d];
+    }
+    return true;
+}
+
+FeatEncoding featstream_parse_encoding(const std::string& s, bool* ok)
+{
+    *ok = true;
+    if (s == "f32") return FEAT_F32;
+    if (s == "q8")  return FEAT_Q8;
+    *ok = false;
+    return FEAT_F32;
+}
+
+const char* featstream_encoding_name(FeatEncoding enc)
+{
+    return enc == FEAT_Q8 ? "q8" : "f32";
+}
+
+/* ── sockets ─────────────────────────────────────────────────────────── */
+
+/* UDP socket bound (passive) or connected to addr:port, -1 on error */
+static int open_udp(const std::string& addr, int port, bool passive)
+{
+    addrinfo hints {};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags    = passive ? AI_PASSIVE : 0;
+
+    addrinfo* res = nullptr;
+    std::string service = std::to_string(port);
+    int err = getaddrinfo(addr.empty() ? nullptr : addr.c_str(), service.c_str(), &hints, &res);
+    if (err != 0) {
+        std::fprintf(stderr, "features: %s:%d: %s\n", addr.c_str(), port, gai_strerror(err));
+        return -1;
+    }
+
+    int fd = -1;
+    for (addrinfo* ai = res; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        /* fcntl() rather than SOCK_CLOEXEC | SOCK_NONBLOCK, which are Linux
+           only */
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int ok;
+        if (passive) {
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+            ok = bind(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+        } else {
+            ok = connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+        }
+        if (!ok) { ::close(fd); fd = -1; }
+    }
+    if (fd < 0)
+        std::fprintf(stderr, "features: %s:%d: %s\n", addr.c_str(), port, std::strerror(errno));
+    freeaddrinfo(res);
+    return fd;
+}
+
+/* ── FeatureSender ───────────────────────────────────────────────────── */
+
+bool FeatureSender::open(const std::string& host, int port, FeatEncoding enc)
+{
+    close();
+    fd_  = open_udp(host, port, false);
+    enc_ = enc;
+    session_ = std::random_device{}();
+    seq_ = 0;
+    sent_ = dropped_ = 0;
+    return fd_ >= 0;
+}
+
+void FeatureSender::close()
+{
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+void FeatureSender::send(FeaturePacket& p)
+{
+    if (fd_ < 0) return;
+    p.session = session_;
+    p.seq     = seq_++;
+    size_t len = featstream_encode(p, enc_, buf_, sizeof buf_);
+    /* connected UDP: ECONNREFUSED just means nobody is listening yet.  UDP
+       never raises SIGPIPE, so no MSG_NOSIGNAL, which isn't portable */
+    if (len == 0 || ::send(fd_, buf_, len, MSG_DONTWAIT) != static_cast<ssize_t>(len))
+        dropped_++;
+    else
+        sent_++;
+}
+
+/* ── FeatureReceiver ─────────────────────────────────────────────────── */
+
+bool FeatureReceiver::open(const std::string& addr, int port)
+{
+    close();
+    reset();
+    fd_ = open_udp(addr, port, true);
+    return fd_ >= 0;
+}
+
+void FeatureReceiver::close()
+{
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+bool FeatureReceiver::receive(FeaturePacket* p, int timeout_ms)
+{
+    if (fd_ < 0) return false;
+    for (;;) {
+        ssize_t n = ::recv(fd_, buf_, sizeof buf_, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            pollfd pfd { fd_, POLLIN, 0 };
+            if (timeout_ms <= 0 || poll(&pfd, 1, timeout_ms) <= 0) return false;
+            timeout_ms = 0;   /* one wait, then whatever is queued */
+            n = ::recv(fd_, buf_, sizeof buf_, MSG_DONTWAIT);
+            if (n < 0) return false;
+        }
+        if (!featstream_decode(buf_, static_cast<size_t>(n), p)) continue;
+
+        /* a new session is a restarted sender, follow it from here */
+        if (have_seq_ && p->session != session_)
+            have_seq_ = false;
+        int32_t ahead = static_cast<int32_t>(p->seq - next_seq_);
+        if (have_seq_ && ahead < 0) {
+            late_++;
+            continue;
+        }
+        if (have_seq_ && ahead > 0)
+            lost_ += static_cast<uint64_t>(ahead);
+        have_seq_ = true;
+        session_  = p->session;
+        next_seq_ = p->seq + 1;
+        received_++;
+        return true;
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* ── Feature stream ────────────────────────────────────────────────────────
+ *
+ *  Carries the receiver's decoded vocoder features over UDP, so the demod
+ *  and neural decoder can run on one machine (e.g. next to the SDR) and
+ *  FARGAN on another.  One datagram per modem frame, every field little
+ *  endian whatever the host:
+ *
+ *      0  "RADF"            4  version        5  encoding
+ *      6  flags             7  n_frames       8  uint32 seq
+ *     12  uint32 mf        16  float snr_dB  20  float freq_offset
+ *     24  char callsign[16], NUL padded, valid with FEATPKT_CALLSIGN
+ *     40  uint32 session
+ *     44  n_frames feature frames of FEATSTREAM_NB_FEATURES
+ *
+ *  Only the FEATSTREAM_NB_FEATURES FARGAN reads of each 36 float frame are
+ *  sent.  FEAT_F32 sends them as floats, 1004 bytes per 120 ms modem frame
+ *  with the header (67 kb/s, bit exact).  FEAT_Q8 sends a float offset and
+ *  step for each feature then one byte per feature per frame, 444 bytes
+ *  (30 kb/s), against 256 kb/s for the 16 kHz S16 speech.
+ *
+ *  A lost datagram is a 120 ms gap in the speech; seq lets the receiver
+ *  count them and drop anything that arrives out of order.  session is
+ *  picked afresh each time a sender opens, so a restarted sender, whose
+ *  seq starts again from 0, is followed at once rather than taken as late.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+constexpr int FEATSTREAM_NB_FEATURES = 20;    // NB_FEATURES, what fargan_synthesize() uses
+constexpr int FEATSTREAM_MAX_FRAMES  = 16;    // 12 at the current model
+constexpr int FEATSTREAM_HEADER      = 44;
+constexpr int FEATSTREAM_MAX_PACKET  = FEATSTREAM_HEADER + FEATSTREAM_MAX_FRAMES * FEATSTREAM_NB_FEATURES * 4;
+
+enum FeatEncoding : uint8_t {
+    FEAT_F32,
+    FEAT_Q8,
+};
+
+enum : uint8_t {
+    FEATPKT_SYNCED    = 0x01,   // receiver in sync after this modem frame
+    FEATPKT_LOST_SYNC = 0x02,   // ... and it lost sync on it, reset the vocoder
+    FEATPKT_EOO       = 0x04,   // an end of over frame was received
+    FEATPKT_CALLSIGN  = 0x08,   // ... and its callsign decoded
+};
+
+struct FeaturePacket {
+    uint32_t session     = 0;
+    uint32_t seq         = 0;
+    uint32_t mf          = 0;   // modem frame number, low 32 bits
+    uint8_t  flags       = 0;   // FEATPKT_xxx
+    float    snr_dB      = 0.0f;
+    float    freq_offset = 0.0f;
+    char     callsign[16] = {};
+    int      n_frames    = 0;   // 0: no speech this modem frame
+    float    feat[FEATSTREAM_MAX_FRAMES][FEATSTREAM_NB_FEATURES] = {};
+};
+
+/* Serialise p into buf, returns the datagram length, 0 if cap is too
+   small or there are too many frames */
+size_t featstream_encode(const FeaturePacket& p, FeatEncoding enc, uint8_t* buf, size_t cap);
+
+/* Parse one datagram, false if it isn't a valid feature packet */
+bool   featstream_decode(const uint8_t* buf, size_t len, FeaturePacket* p);
+
+FeatEncoding featstream_parse_encoding(const std::string& s, bool* ok);
+const char*  featstream_encoding_name(FeatEncoding enc);
+
+/* ── FeatureSender ─────────────────────────────────────────────────────────
+ *
+ *  Non-blocking UDP sender, safe to call from the DSP thread: send()
+ *  numbers the packet, encodes it into a fixed buffer and makes one
+ *  send(), dropping (and counting) it if the socket buffer is full.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+class FeatureSender {
+public:
+    FeatureSender() = default;
+    ~FeatureSender() { close(); }
+
+    FeatureSender(const FeatureSender&)            = delete;
+    FeatureSender& operator=(const FeatureSender&) = delete;
+
+    bool open(const std::string& host, int port, FeatEncoding enc);
+    void close();
+    bool is_open() const { return fd_ >= 0; }
+
+    void     send(FeaturePacket& p);   // fills in p.session and p.seq
+    uint64_t sent()    const { return sent_; }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    int          fd_  = -1;
+    FeatEncoding enc_ = FEAT_F32;
+    uint32_t     session_ = 0;
+    uint32_t     seq_ = 0;
+    uint64_t     sent_ = 0, dropped_ = 0;
+    uint8_t      buf_[FEATSTREAM_MAX_PACKET];
+};
+
+/* ── FeatureReceiver ───────────────────────────────────────────────────────
+ *
+ *  Bound UDP socket for the far end.  receive() waits up to timeout_ms for
+ *  the next in order packet; datagrams that aren't feature packets, and
+ *  ones older than the last accepted, are discarded.  A sender restart
+ *  (a new session) is followed rather than treated as stale.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+class FeatureReceiver {
+public:
+    FeatureReceiver() = default;
+    ~FeatureReceiver() { close(); }
+
+    FeatureReceiver(const FeatureReceiver&)            = delete;
+    FeatureReceiver& operator=(const FeatureReceiver&) = delete;
+
+    /* addr "" for every address */
+    bool open(const std::string& addr, int port);
+    void close();
+    bool is_open() const { return fd_ >= 0; }
+
+    bool     receive(FeaturePacket* p, int timeout_ms);
+    uint64_t received() const { return received_; }
+    uint64_t lost()     const { return lost_; }   // seq gaps
+    uint64_t late()     const { return late_; }   // out of order, discarded
+
+    void reset() { have_seq_ = false; received_ = lost_ = late_ = 0; }
+
+private:
+    int      fd_       = -1;
+    bool     have_seq_ = false;
+    uint32_t session_  = 0;
+    uint32_t next_seq_ = 0;
+    uint64_t received_ = 0, lost_ = 0, late_ = 0;
+    uint8_t  buf_[FEATSTREAM_MAX_PACKET + 1];
+};
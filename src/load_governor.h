@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+#include "rade_api.h"
+}
+
+/* ── LoadGovernor ──────────────────────────────────────────────────────────
+ *
+ *  Sheds optional work from the receiver when the DSP thread is close to
+ *  falling behind real time, so a slow host drops display detail and
+ *  acquisition speed rather than audio.  Fed once per modem frame with
+ *  the frame's DSP time and the capture backlog, it steps through the
+ *  levels below one at a time, each keeping what the one before shed:
+ *
+ *    0 normal         everything
+ *    1 spectrum       input spectrum on every other frame
+ *    2 thin search    pilot search on every other frame while searching
+ *    3 noise freeze   no noise floor refresh in rade_acq_check_pilots()
+ *                     while in sync
+ *    4 display        spectrum every 8th frame, telemetry every 4th
+ *
+ *  It steps up when the smoothed load (DSP time over audio time) passes
+ *  HIGH_LOAD or more than a modem frame of input is queued, at most once
+ *  every HOLD_FRAMES so the last step has time to show, and back down
+ *  after CALM_FRAMES below LOW_LOAD.  None of it touches the demod, the
+ *  neural decoder or FARGAN.  Used only by the DSP thread.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+class LoadGovernor {
+public:
+    enum Level { NORMAL, SPECTRUM, THIN_SEARCH, NOISE_FREEZE, DISPLAY, N_LEVELS };
+
+    static constexpr float HIGH_LOAD   = 0.8f;
+    static constexpr float LOW_LOAD    = 0.5f;
+    static constexpr int   HOLD_FRAMES = 4;     // ~0.5 s between steps up
+    static constexpr int   CALM_FRAMES = 40;    // ~5 s quiet before a step down
+
+    static const char* level_name(int level)
+    {
+        static const char* const names[N_LEVELS] = {
+            "normal", "spectrum", "thin_search", "noise_freeze", "display"
+        };
+        return (level >= 0 && level < N_LEVELS) ? names[level] : "?";
+    }
+
+    void set_enabled(bool on) { enabled_ = on; if (!on) reset(); }
+    bool enabled() const      { return enabled_; }
+
+    /* back to normal, e.g. on start() */
+    void reset() { level_ = NORMAL; load_ = 0.0f; hold_ = 0; calm_ = 0; }
+
+    /* one call per modem frame: DSP time spent on it, the audio time it
+       covered, and the input samples still queued behind it.  Returns
+       true if the level changed */
+    bool update(uint64_t busy_ns, uint64_t audio_ns, size_t backlog, size_t frame)
+    {
+        if (!enabled_ || audio_ns == 0) return false;
+        float load = static_cast<float>(busy_ns) / static_cast<float>(audio_ns);
+        load_ += (load - load_) * 0.25f;
+
+        if (hold_ > 0) hold_--;
+        int level = level_;
+        if ((load_ > HIGH_LOAD || backlog > frame) && level_ < N_LEVELS - 1) {
+            calm_ = 0;
+            if (hold_ == 0) {
+                level_++;
+                hold_ = HOLD_FRAMES;
+            }
+        } else if (load_ < LOW_LOAD && level_ > NORMAL) {
+            if (++calm_ >= CALM_FRAMES) {
+                level_--;
+                calm_ = 0;
+            }
+        } else {
+            calm_ = 0;
+        }
+        return level_ != level;
+    }
+
+    int   level() const { return level_; }
+    float load()  const { return load_; }    // smoothed real-time factor
+
+    /* what to run at this level, in modem frames between runs */
+    int spectrum_every()  const { return level_ >= DISPLAY ? 8 : level_ >= SPECTRUM ? 2 : 1; }
+    int telemetry_every() const { return level_ >= DISPLAY ? 4 : 1; }
+
+    /* for rade_set_load_shed() */
+    int rade_flags() const
+    {
+        return (level_ >= THIN_SEARCH  ? RADE_SHED_THIN_SEARCH  : 0) |
+               (level_ >= NOISE_FREEZE ? RADE_SHED_NOISE_FREEZE : 0);
+    }
+
+private:
+    bool  enabled_ = true;
+    int   level_   = NORMAL;
+    float load_    = 0.0f;
+    int   hold_    = 0;
+    int   calm_    = 0;
+};
@@ -2,7 +2,11 @@
 #include <vector>
 #include <string>
 #include <cstdio>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <atomic>
+#include <thread>
 #include <sys/stat.h>
 
 #include "audio_input.h"
@@ -35,10 +39,19 @@ static GtkWidget*               g_status             = nullptr;   // status labe
 static GtkWidget*               g_settings_dlg       = nullptr;   // settings dialog
 static GtkWidget*               g_callsign_entry     = nullptr;   // station callsign
 static GtkWidget*               g_gridsquare_entry   = nullptr;   // station gridsquare
+static GtkWidget*               g_rt_priority_spin   = nullptr;   // real-time priority, 0 = off
+static GtkWidget*               g_rt_cpus_entry      = nullptr;   // CPU affinity list
+static GtkWidget*               g_rt_mlock_switch    = nullptr;   // lock memory
 static GtkWidget*               g_mic_slider         = nullptr;   // TX mic input level slider
 static GtkWidget*               g_tx_slider          = nullptr;   // TX output level slider
-static guint                    g_timer              = 0;         // meter update timer
+static GtkWidget*               g_overs_mi           = nullptr;   // File > Go to Over
+static GtkWidget*               g_window             = nullptr;   // main window, owns the frame clock
+static guint                    g_tick               = 0;         // display update tick callback
+static bool                     g_iconified          = false;     // window minimised: draw nothing
 static bool                     g_updating_combos    = false;     // guard programmatic changes
+static std::thread              g_scan_thread;                    // file scan worker, owns g_decoder
+static std::atomic<bool>        g_scan_cancel{false};             // ask the worker to give up
+static unsigned                 g_scan_gen           = 0;         // bumped per scan, drops stale reports
 
 /* ── config persistence ─────────────────────────────────────────────────── */
 
@@ -84,6 +97,11 @@ static void save_config()
         f << "callsign=" << cs << '\n';
         const char* gs = g_gridsquare_entry ? gtk_entry_get_text(GTK_ENTRY(g_gridsquare_entry)) : "";
         f << "gridsquare=" << gs << '\n';
+        if (g_rt_priority_spin)
+            f << "rt_priority=" << gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(g_rt_priority_spin)) << '\n';
+        const char* cpus = g_rt_cpus_entry ? gtk_entry_get_text(GTK_ENTRY(g_rt_cpus_entry)) : "";
+        f << "cpus=" << cpus << '\n';
+        f << "mlock=" << (g_rt_mlock_switch && gtk_switch_get_active(GTK_SWITCH(g_rt_mlock_switch)) ? 1 : 0) << '\n';
     }
 }
 
@@ -97,6 +115,9 @@ static bool restore_config()
     int saved_tx_level = -1;
     int saved_mic_level = -1;
     int saved_bpf_enabled = -1;
+    int saved_rt_priority = -1;
+    int saved_mlock = -1;
+    std::string saved_cpus;
     std::string line;
     while (std::getline(f, line)) {
         if (line.compare(0, 6, "input=") == 0)
@@ -117,6 +138,12 @@ static bool restore_config()
             saved_callsign = line.substr(9);
         else if (line.compare(0, 11, "gridsquare=") == 0)
             saved_gridsquare = line.substr(11);
+        else if (line.compare(0, 12, "rt_priority=") == 0)
+            saved_rt_priority = std::stoi(line.substr(12));
+        else if (line.compare(0, 5, "cpus=") == 0)
+            saved_cpus = line.substr(5);
+        else if (line.compare(0, 6, "mlock=") == 0)
+            saved_mlock = std::stoi(line.substr(6));
     }
 
     if (saved_in.empty() && saved_out.empty()) return false;
@@ -166,17 +193,48 @@ static bool restore_config()
         gtk_entry_set_text(GTK_ENTRY(g_callsign_entry), saved_callsign.c_str());
     if (!saved_gridsquare.empty() && g_gridsquare_entry)
         gtk_entry_set_text(GTK_ENTRY(g_gridsquare_entry), saved_gridsquare.c_str());
+    if (saved_rt_priority >= 0 && saved_rt_priority <= 99 && g_rt_priority_spin)
+        gtk_spin_button_set_value(GTK_SPIN_BUTTON(g_rt_priority_spin), saved_rt_priority);
+    if (!saved_cpus.empty() && g_rt_cpus_entry)
+        gtk_entry_set_text(GTK_ENTRY(g_rt_cpus_entry), saved_cpus.c_str());
+    if (saved_mlock >= 0 && g_rt_mlock_switch)
+        gtk_switch_set_active(GTK_SWITCH(g_rt_mlock_switch), saved_mlock != 0);
 
     return (in_idx >= 0 && out_idx >= 0);
 }
 
 /* ── helpers ────────────────────────────────────────────────────────────── */
 
+/* the same text again would still cost a relayout of the window */
 static void set_status(const char* msg)
 {
+    if (std::strcmp(gtk_label_get_text(GTK_LABEL(g_status)), msg) == 0) return;
     gtk_label_set_text(GTK_LABEL(g_status), msg);
 }
 
+/* per-stage timing table as the status line tooltip, refreshed about once a
+   second; works for RadaeDecoder and RadaeEncoder */
+template <typename Pipeline>
+static void update_stage_tooltip(const Pipeline& p)
+{
+    static gint64 last_us = 0;
+    gint64 now_us = g_get_monotonic_time();
+    if (now_us - last_us < G_USEC_PER_SEC) return;
+    last_us = now_us;
+
+    std::string text = "stage            p50 / p99 / max (us)";
+    for (int i = 0; i < p.n_stages(); i++) {
+        rade_stage_stats st;
+        if (!p.stage_stats(i, &st) || st.count == 0) continue;
+        char line[128];
+        std::snprintf(line, sizeof line, "\n%-14s %7.0f / %7.0f / %7.0f",
+                      p.stage_name(i), static_cast<double>(st.p50_us),
+                      static_cast<double>(st.p99_us), static_cast<double>(st.max_us));
+        text += line;
+    }
+    gtk_widget_set_tooltip_text(g_status, text.c_str());
+}
+
 /* change the button label AND its CSS class in one shot */
 static void set_btn_state(bool capturing)
 {
@@ -212,11 +270,17 @@ static void on_tx_level_changed(GtkRange* range, gpointer /*data*/)
 
 /* ── decoder control ───────────────────────────────────────────────────── */
 
+static void set_overs_menu(const std::vector<RadaeDecoder::Over>* overs);
+static void stop_display_updates();
+static void cancel_scan();
+
 static void stop_all()
 {
+    cancel_scan();
     if (g_decoder) { g_decoder->stop(); g_decoder->close(); }
+    set_overs_menu(nullptr);
     if (g_encoder) { g_encoder->stop(); g_encoder->close(); }
-    if (g_timer)   { g_source_remove(g_timer); g_timer = 0; }
+    stop_display_updates();
     if (g_meter_in)  meter_widget_update(g_meter_in, 0.f);
     if (g_meter_out) meter_widget_update(g_meter_out, 0.f);
     if (g_spectrum)  spectrum_widget_update(g_spectrum, nullptr, 0, 8000.f);
@@ -224,92 +288,175 @@ static void stop_all()
     set_btn_state(false);
 }
 
-/* timer tick – update meter + status at ~30 fps */
-static gboolean on_meter_tick(gpointer /*data*/)
+/* ── display updates ──────────────────────────────────────────────────────
+ *
+ *  Driven by the main window's frame clock rather than a free-running timer,
+ *  so GTK paces us to the display and stops ticking while the window isn't
+ *  mapped.  The meters step at about 30 fps for their peak-hold ballistics;
+ *  everything else only changes when the pipeline publishes a new modem
+ *  frame (~8 per second), so the spectrum, waterfall and status line are
+ *  left alone until the telemetry frame counter moves.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+static constexpr gint64 METER_INTERVAL_US = 30000;       // every other 60 Hz frame
+static gint64           g_meter_us        = 0;           // frame time of the last meter step
+static uint64_t         g_shown_frame     = UINT64_MAX;  // telemetry frame on screen
+static uint64_t         g_shown_spectrum  = UINT64_MAX;  // ... and its spectrum
+
+/* forget what's on screen, the next tick redraws everything */
+static void invalidate_display()
 {
-    /* ── TX mode ─────────────────────────────────────────────────────── */
-    if (g_encoder && g_encoder->is_running()) {
-        if (g_meter_in)
-            meter_widget_update(g_meter_in, g_encoder->get_input_level());
-        if (g_meter_out)
-            meter_widget_update(g_meter_out, g_encoder->get_output_level());
-
-        /* update spectrum and waterfall with TX output FFT */
-        {
-            float spec[RadaeEncoder::SPECTRUM_BINS];
-            g_encoder->get_spectrum(spec, RadaeEncoder::SPECTRUM_BINS);
-            if (g_spectrum)
-                spectrum_widget_update(g_spectrum, spec, RadaeEncoder::SPECTRUM_BINS,
-                                       g_encoder->spectrum_sample_rate());
-            if (g_waterfall)
-                waterfall_widget_update(g_waterfall, spec, RadaeEncoder::SPECTRUM_BINS,
-                                        g_encoder->spectrum_sample_rate());
-        }
-
-        set_status("Transmitting\xe2\x80\xa6");
-        return TRUE;
-    }
-
-    /* ── RX mode ─────────────────────────────────────────────────────── */
-    if (!g_decoder) return TRUE;
-    std::string cs = g_decoder->last_callsign();
-    char buf[256];
-    if (!g_decoder->is_running()) {
-        /* decoder stopped itself (e.g. file playback finished) */
-        stop_all();
-        std::snprintf(buf, sizeof buf,
-                          "Playback finished. %s", cs.c_str());
-        set_status(buf);
-        return FALSE;
-    }
+    g_meter_us       = 0;
+    g_shown_frame    = UINT64_MAX;
+    g_shown_spectrum = UINT64_MAX;
+}
 
-    /* update level meters */
+/* meters step on their own clock so the peak keeps falling between frames;
+   a meter that has settled doesn't redraw */
+static void update_meters(const Telemetry& tel, gint64 frame_us)
+{
+    if (frame_us - g_meter_us < METER_INTERVAL_US) return;
+    g_meter_us = frame_us;
     if (g_meter_in)
-        meter_widget_update(g_meter_in, g_decoder->get_input_level());
+        meter_widget_update(g_meter_in, tel.input_level);
     if (g_meter_out)
-        meter_widget_update(g_meter_out, g_decoder->get_output_level_left());
+        meter_widget_update(g_meter_out, tel.output_level);
+}
 
-    /* update spectrum and waterfall with input audio FFT */
-    {
-        float spec[RadaeDecoder::SPECTRUM_BINS];
-        g_decoder->get_spectrum(spec, RadaeDecoder::SPECTRUM_BINS);
-        if (g_spectrum)
-            spectrum_widget_update(g_spectrum, spec, RadaeDecoder::SPECTRUM_BINS,
-                                   g_decoder->spectrum_sample_rate());
-        if (g_waterfall)
-            waterfall_widget_update(g_waterfall, spec, RadaeDecoder::SPECTRUM_BINS,
-                                    g_decoder->spectrum_sample_rate());
-    }
+/* one waterfall line per spectrum, which is every modem frame unless the
+   receiver is shedding load */
+static void update_spectrum(const Telemetry& tel, float sample_rate)
+{
+    if (tel.spectrum_frame == g_shown_spectrum) return;
+    g_shown_spectrum = tel.spectrum_frame;
+    if (g_spectrum)
+        spectrum_widget_update(g_spectrum, tel.spectrum, Telemetry::SPECTRUM_BINS,
+                               sample_rate);
+    if (g_waterfall)
+        waterfall_widget_update(g_waterfall, tel.spectrum, Telemetry::SPECTRUM_BINS,
+                                sample_rate);
+}
 
-    /* update status with sync info */
-    
-    if (g_decoder->is_synced()) {
-        
-        if (cs.empty()) {
+static void set_rx_status(const Telemetry& tel)
+{
+    const char* cs = tel.callsign;
+    char buf[256];
+    if (tel.synced) {
+        if (cs[0] == '\0') {
             std::snprintf(buf, sizeof buf,
                           "Synced \xe2\x80\x94 SNR: %.0f dB  Freq: %+.1f Hz",
-                          static_cast<double>(g_decoder->snr_dB()),
-                          static_cast<double>(g_decoder->freq_offset()));
+                          static_cast<double>(tel.snr_dB),
+                          static_cast<double>(tel.freq_offset));
         } else {
             std::snprintf(buf, sizeof buf,
                           "Synced \xe2\x80\x94 SNR: %.0f dB  Freq: %+.1f Hz  Callsign: %s",
-                          static_cast<double>(g_decoder->snr_dB()),
-                          static_cast<double>(g_decoder->freq_offset()),
-                          cs.c_str());
+                          static_cast<double>(tel.snr_dB),
+                          static_cast<double>(tel.freq_offset),
+                          cs);
         }
-        set_status(buf);
     } else {
-        if (cs.empty()) {
+        if (cs[0] == '\0') {
             std::snprintf(buf, sizeof buf,
                           "Searching for signal\xe2\x80\xa6");
         } else {
             std::snprintf(buf, sizeof buf,
-                          "Searching for signal\xe2\x80\xa6 Last heard: %s", cs.c_str());
+                          "Searching for signal\xe2\x80\xa6 Last heard: %s", cs);
         }
+    }
+    if (tel.shed_level > 0) {
+        size_t len = std::strlen(buf);
+        std::snprintf(buf + len, sizeof buf - len, "  [CPU: shedding %s]",
+                      LoadGovernor::level_name(tel.shed_level));
+    }
+    set_status(buf);
+}
+
+/* frame clock tick, once per displayed frame while the window is mapped */
+static gboolean on_display_tick(GtkWidget* /*w*/, GdkFrameClock* clock, gpointer /*data*/)
+{
+    gint64 frame_us = gdk_frame_clock_get_frame_time(clock);
+
+    /* ── TX mode ─────────────────────────────────────────────────────── */
+    if (g_encoder && g_encoder->is_running()) {
+        if (g_iconified) return G_SOURCE_CONTINUE;
+
+        /* one snapshot per tick, never blocks the DSP thread */
+        Telemetry tel = g_encoder->telemetry();
+        update_meters(tel, frame_us);
+        if (tel.frame == g_shown_frame) return G_SOURCE_CONTINUE;
+        g_shown_frame = tel.frame;
+
+        /* update spectrum and waterfall with TX output FFT */
+        update_spectrum(tel, g_encoder->spectrum_sample_rate());
+        set_status("Transmitting\xe2\x80\xa6");
+        update_stage_tooltip(*g_encoder);
+        return G_SOURCE_CONTINUE;
+    }
+
+    /* ── RX mode ─────────────────────────────────────────────────────── */
+    if (!g_decoder) return G_SOURCE_CONTINUE;
+    Telemetry tel = g_decoder->telemetry();
+    if (!g_decoder->is_running()) {
+        /* decoder stopped itself (e.g. file playback finished); returning
+           G_SOURCE_REMOVE takes this callback down, so stop_all() mustn't */
+        g_tick = 0;
+        stop_all();
+        char buf[256];
+        std::snprintf(buf, sizeof buf,
+                          "Playback finished. %s", tel.callsign);
         set_status(buf);
+        return G_SOURCE_REMOVE;
     }
+    if (g_iconified) return G_SOURCE_CONTINUE;
 
-    return TRUE;
+    update_meters(tel, frame_us);
+    if (tel.frame == g_shown_frame) return G_SOURCE_CONTINUE;
+    g_shown_frame = tel.frame;
+
+    /* update spectrum and waterfall with input audio FFT */
+    update_spectrum(tel, g_decoder->spectrum_sample_rate());
+    set_rx_status(tel);
+    update_stage_tooltip(*g_decoder);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void start_display_updates()
+{
+    invalidate_display();
+    if (!g_tick && g_window)
+        g_tick = gtk_widget_add_tick_callback(g_window, on_display_tick, nullptr, nullptr);
+}
+
+static void stop_display_updates()
+{
+    if (g_tick && g_window) gtk_widget_remove_tick_callback(g_window, g_tick);
+    g_tick = 0;
+}
+
+/* minimised (or withdrawn) windows may still get frame clock ticks on some
+   backends; draw nothing until the window comes back, then redraw the lot */
+static gboolean on_window_state(GtkWidget* /*w*/, GdkEventWindowState* event, gpointer /*data*/)
+{
+    bool hidden = (event->new_window_state &
+                   (GDK_WINDOW_STATE_ICONIFIED | GDK_WINDOW_STATE_WITHDRAWN)) != 0;
+    if (g_iconified && !hidden) invalidate_display();
+    g_iconified = hidden;
+    return FALSE;
+}
+
+/* Thread policy from the Performance settings, taking effect on the next
+   start.  A bad CPU list means any CPU */
+static RtPolicy settings_rt_policy()
+{
+    RtPolicy p;
+    if (g_rt_priority_spin)
+        p.priority = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(g_rt_priority_spin));
+    if (g_rt_cpus_entry && !rt_parse_cpus(gtk_entry_get_text(GTK_ENTRY(g_rt_cpus_entry)), &p.cpus))
+        p.cpus = 0;
+    if (g_rt_mlock_switch)
+        p.lock_memory = gtk_switch_get_active(GTK_SWITCH(g_rt_mlock_switch));
+    return p;
 }
 
 static void start_decoder(int in_idx, int out_idx)
@@ -320,6 +467,7 @@ static void start_decoder(int in_idx, int out_idx)
     stop_all();
 
     if (!g_decoder) g_decoder = new RadaeDecoder();
+    g_decoder->set_rt_policy(settings_rt_policy());
 
     if (!g_decoder->open(g_input_devices[in_idx].hw_id,
                          g_output_devices[out_idx].hw_id)) {
@@ -330,8 +478,10 @@ static void start_decoder(int in_idx, int out_idx)
 
     g_decoder->start();
     set_btn_state(true);
-    set_status("Searching for signal\xe2\x80\xa6");
-    g_timer = g_timeout_add(33, on_meter_tick, nullptr);   // ~30 fps
+    set_status(g_decoder->rt_denied()
+               ? "Searching for signal\xe2\x80\xa6 (real-time settings refused, see terminal)"
+               : "Searching for signal\xe2\x80\xa6");
+    start_display_updates();
 }
 
 static void start_encoder(int mic_idx, int radio_idx)
@@ -342,6 +492,7 @@ static void start_encoder(int mic_idx, int radio_idx)
     stop_all();
 
     if (!g_encoder) g_encoder = new RadaeEncoder();
+    g_encoder->set_rt_policy(settings_rt_policy());
 
     if (!g_encoder->open(g_tx_input_devices[mic_idx].hw_id,
                          g_tx_output_devices[radio_idx].hw_id)) {
@@ -358,8 +509,10 @@ static void start_encoder(int mic_idx, int radio_idx)
     }
     g_encoder->start();
     set_btn_state(true);
-    set_status("Transmitting\xe2\x80\xa6");
-    g_timer = g_timeout_add(33, on_meter_tick, nullptr);
+    set_status(g_encoder->rt_denied()
+               ? "Transmitting\xe2\x80\xa6 (real-time settings refused, see terminal)"
+               : "Transmitting\xe2\x80\xa6");
+    start_display_updates();
 }
 
 /* ── signal handlers ────────────────────────────────────────────────────── */
@@ -405,6 +558,19 @@ static void on_gridsquare_changed(GtkEditable* /*e*/, gpointer /*data*/)
     save_config();
 }
 
+/* Performance settings changed: save config, applied on the next start */
+static void on_rt_setting_changed(GtkWidget* /*w*/, gpointer /*data*/)
+{
+    save_config();
+}
+
+static gboolean on_rt_mlock_changed(GtkSwitch* sw, gboolean state, gpointer /*data*/)
+{
+    gtk_switch_set_state(sw, state);
+    save_config();
+    return TRUE;
+}
+
 /* TX switch toggled: stop current mode and start the new one */
 static gboolean on_tx_switch_changed(GtkSwitch* sw, gboolean state, gpointer /*data*/)
 {
@@ -450,7 +616,8 @@ static gboolean on_bpf_switch_changed(GtkSwitch* sw, gboolean state, gpointer /*
 static void on_start_stop(GtkButton* /*btn*/, gpointer /*data*/)
 {
     bool running = (g_decoder && g_decoder->is_running()) ||
-                   (g_encoder && g_encoder->is_running());
+                   (g_encoder && g_encoder->is_running()) ||
+                   g_scan_thread.joinable();
     if (running) {
         stop_all();
         set_status("Stopped.");
@@ -482,7 +649,8 @@ static void on_start_stop(GtkButton* /*btn*/, gpointer /*data*/)
 static void on_refresh(GtkButton* /*btn*/, gpointer /*data*/)
 {
     bool running = (g_decoder && g_decoder->is_running()) ||
-                   (g_encoder && g_encoder->is_running());
+                   (g_encoder && g_encoder->is_running()) ||
+                   g_scan_thread.joinable();
     if (running) stop_all();
 
     g_input_devices    = AudioInput::enumerate_devices();
@@ -527,13 +695,99 @@ static void on_refresh(GtkButton* /*btn*/, gpointer /*data*/)
 static void on_window_destroy(GtkWidget* /*w*/, gpointer /*data*/)
 {
     save_config();
-    if (g_timer)   { g_source_remove(g_timer); g_timer = 0; }
+    stop_display_updates();
+    cancel_scan();
+    g_window = nullptr;
     if (g_decoder) { g_decoder->stop(); g_decoder->close(); delete g_decoder; g_decoder = nullptr; }
     if (g_encoder) { g_encoder->stop(); g_encoder->close(); delete g_encoder; g_encoder = nullptr; }
 }
 
 /* ── file playback ─────────────────────────────────────────────────────── */
 
+/* File > Go to Over > entry */
+static void on_goto_over(GtkMenuItem* /*item*/, gpointer data)
+{
+    size_t i = GPOINTER_TO_SIZE(data);
+    if (!g_decoder || !g_decoder->seek_over(i)) return;
+
+    set_btn_state(true);
+    start_display_updates();
+}
+
+/* one menu entry per over found by RadaeDecoder::scan_file(), or an
+   empty, insensitive menu when no file is open */
+static void set_overs_menu(const std::vector<RadaeDecoder::Over>* overs)
+{
+    if (!g_overs_mi) return;
+
+    GtkWidget* menu = gtk_menu_new();
+    size_t n = overs ? overs->size() : 0;
+    for (size_t i = 0; i < n; i++) {
+        const RadaeDecoder::Over& o = (*overs)[i];
+        int  t = static_cast<int>(o.start_s);
+        char label[128];
+        std::snprintf(label, sizeof label, "%d:%02d  %.0f s  %.0f dB  %s",
+                      t / 60, t % 60, o.end_s - o.start_s, o.snr_dB, o.callsign.c_str());
+        GtkWidget* mi = gtk_menu_item_new_with_label(label);
+        g_signal_connect(mi, "activate", G_CALLBACK(on_goto_over), GSIZE_TO_POINTER(i));
+        gtk_menu_shell_append(GTK_MENU_SHELL(menu), mi);
+    }
+    gtk_widget_show_all(menu);
+    gtk_menu_item_set_submenu(GTK_MENU_ITEM(g_overs_mi), menu);
+    gtk_widget_set_sensitive(g_overs_mi, n > 0);
+}
+
+/* ── file scan ──────────────────────────────────────────────────────────
+ *
+ *  scan_file() reads the whole recording, which takes a few seconds for a
+ *  long one, so it runs on a worker thread and the window stays live.  The
+ *  worker has g_decoder to itself until it is joined, and reports back
+ *  through g_idle_add(), so only the main thread touches GTK.  stop_all()
+ *  cancels a scan; reports tagged with an older g_scan_gen are dropped.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+struct ScanReport {
+    unsigned gen;
+    int      pct;     // progress, 0-100
+    bool     done;    // the worker has finished and can be joined
+    bool     ok;      // ... and scan_file() succeeded
+};
+
+static void cancel_scan()
+{
+    if (!g_scan_thread.joinable()) return;
+    g_scan_cancel.store(true, std::memory_order_relaxed);
+    g_scan_thread.join();
+    g_scan_gen++;
+}
+
+static gboolean on_scan_report(gpointer data)
+{
+    ScanReport rep = *static_cast<ScanReport*>(data);
+    delete static_cast<ScanReport*>(data);
+    if (rep.gen != g_scan_gen || !g_scan_thread.joinable()) return G_SOURCE_REMOVE;
+
+    if (!rep.done) {
+        char buf[64];
+        std::snprintf(buf, sizeof buf, "Scanning file\xe2\x80\xa6 %d%%", rep.pct);
+        set_status(buf);
+        return G_SOURCE_REMOVE;
+    }
+
+    g_scan_thread.join();
+    g_scan_gen++;
+    if (rep.ok)
+        set_overs_menu(&g_decoder->overs());
+
+    g_decoder->start();
+    char buf[128];
+    std::snprintf(buf, sizeof buf, "Playing file\xe2\x80\xa6 %zu overs found.",
+                  g_decoder->overs().size());
+    set_status(buf);
+    start_display_updates();
+    return G_SOURCE_REMOVE;
+}
+
 static void start_decoder_file(const std::string& wav_path, int out_idx)
 {
     if (out_idx < 0 || out_idx >= static_cast<int>(g_output_devices.size())) return;
@@ -549,10 +803,24 @@ static void start_decoder_file(const std::string& wav_path, int out_idx)
         return;
     }
 
-    g_decoder->start();
+    /* index the overs first, this runs much faster than real time; the
+       Stop button cancels it.  Playback starts from on_scan_report() */
+    set_status("Scanning file\xe2\x80\xa6");
     set_btn_state(true);
-    set_status("Playing file\xe2\x80\xa6");
-    g_timer = g_timeout_add(33, on_meter_tick, nullptr);
+    g_scan_cancel.store(false, std::memory_order_relaxed);
+    g_scan_thread = std::thread([gen = g_scan_gen, dur = g_decoder->file_duration()] {
+        int  last_pct = -1;
+        auto progress = [&](double t) {
+            int pct = dur > 0.0 ? static_cast<int>(100.0 * t / dur) : 0;
+            if (pct != last_pct) {
+                last_pct = pct;
+                g_idle_add(on_scan_report, new ScanReport{gen, pct, false, false});
+            }
+            return !g_scan_cancel.load(std::memory_order_relaxed);
+        };
+        bool ok = g_decoder->scan_file(progress);
+        g_idle_add(on_scan_report, new ScanReport{gen, 100, true, ok});
+    });
 }
 
 /* File > Open */
@@ -646,6 +914,8 @@ static void activate(GtkApplication* app, gpointer /*data*/)
     gtk_window_set_default_size  (GTK_WINDOW(window), 500, 400);
     gtk_window_set_resizable     (GTK_WINDOW(window), TRUE);
     g_signal_connect(window, "destroy", G_CALLBACK(on_window_destroy), NULL);
+    g_signal_connect(window, "window-state-event", G_CALLBACK(on_window_state), NULL);
+    g_window = window;
 
     /* ── menu bar ──────────────────────────────────────────────────── */
     GtkWidget* outer_vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
@@ -664,6 +934,10 @@ static void activate(GtkApplication* app, gpointer /*data*/)
                                GDK_KEY_o, GDK_CONTROL_MASK, GTK_ACCEL_VISIBLE);
     gtk_menu_shell_append(GTK_MENU_SHELL(file_menu), open_mi);
 
+    g_overs_mi = gtk_menu_item_new_with_label("Go to Over");
+    gtk_menu_shell_append(GTK_MENU_SHELL(file_menu), g_overs_mi);
+    set_overs_menu(nullptr);
+
     gtk_menu_shell_append(GTK_MENU_SHELL(file_menu), gtk_separator_menu_item_new());
 
     GtkWidget* quit_mi  = gtk_menu_item_new_with_label("Quit");
@@ -851,6 +1125,75 @@ static void activate(GtkApplication* app, gpointer /*data*/)
 
     gtk_box_pack_start(GTK_BOX(scontent), gridsquare_hbox, FALSE, FALSE, 0);
 
+    /* ── separator between Station and Performance sections ───────── */
+    gtk_box_pack_start(GTK_BOX(scontent),
+                       gtk_separator_new(GTK_ORIENTATION_HORIZONTAL), FALSE, FALSE, 4);
+
+    GtkWidget* perf_heading = gtk_label_new(nullptr);
+    gtk_label_set_markup(GTK_LABEL(perf_heading), "<b>Performance</b>");
+    gtk_label_set_xalign(GTK_LABEL(perf_heading), 0.0);
+    gtk_box_pack_start(GTK_BOX(scontent), perf_heading, FALSE, FALSE, 0);
+
+    /* ── real-time priority row ───────────────────────────────────── */
+    GtkWidget* rt_prio_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+
+    GtkWidget* rt_prio_label = gtk_label_new("Real-time priority:");
+    gtk_widget_set_size_request(rt_prio_label, 50, -1);
+    gtk_label_set_xalign(GTK_LABEL(rt_prio_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(rt_prio_hbox), rt_prio_label, FALSE, FALSE, 0);
+
+    g_rt_priority_spin = gtk_spin_button_new_with_range(0, 99, 1);
+    gtk_widget_set_tooltip_text(g_rt_priority_spin,
+        "SCHED_FIFO priority for the audio threads, 0 = normal scheduling.\n"
+        "Needs an rtprio limit or CAP_SYS_NICE; applied on the next start");
+    g_signal_connect(g_rt_priority_spin, "value-changed", G_CALLBACK(on_rt_setting_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(rt_prio_hbox), g_rt_priority_spin, TRUE, TRUE, 0);
+
+    /* spacer to align with refresh button above */
+    GtkWidget* rt_prio_spacer = gtk_label_new("");
+    gtk_widget_set_size_request(rt_prio_spacer, 28, -1);
+    gtk_box_pack_start(GTK_BOX(rt_prio_hbox), rt_prio_spacer, FALSE, FALSE, 0);
+
+    gtk_box_pack_start(GTK_BOX(scontent), rt_prio_hbox, FALSE, FALSE, 0);
+
+    /* ── CPU affinity row ─────────────────────────────────────────── */
+    GtkWidget* rt_cpus_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+
+    GtkWidget* rt_cpus_label = gtk_label_new("CPUs:");
+    gtk_widget_set_size_request(rt_cpus_label, 50, -1);
+    gtk_label_set_xalign(GTK_LABEL(rt_cpus_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(rt_cpus_hbox), rt_cpus_label, FALSE, FALSE, 0);
+
+    g_rt_cpus_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(g_rt_cpus_entry), "any, or e.g. 2-3");
+    gtk_widget_set_tooltip_text(g_rt_cpus_entry, "Pin the audio and DSP threads to these CPUs");
+    g_signal_connect(g_rt_cpus_entry, "changed", G_CALLBACK(on_rt_setting_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(rt_cpus_hbox), g_rt_cpus_entry, TRUE, TRUE, 0);
+
+    /* spacer to align with refresh button above */
+    GtkWidget* rt_cpus_spacer = gtk_label_new("");
+    gtk_widget_set_size_request(rt_cpus_spacer, 28, -1);
+    gtk_box_pack_start(GTK_BOX(rt_cpus_hbox), rt_cpus_spacer, FALSE, FALSE, 0);
+
+    gtk_box_pack_start(GTK_BOX(scontent), rt_cpus_hbox, FALSE, FALSE, 0);
+
+    /* ── lock memory row ──────────────────────────────────────────── */
+    GtkWidget* rt_mlock_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+
+    GtkWidget* rt_mlock_label = gtk_label_new("Lock memory:");
+    gtk_widget_set_size_request(rt_mlock_label, 50, -1);
+    gtk_label_set_xalign(GTK_LABEL(rt_mlock_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(rt_mlock_hbox), rt_mlock_label, FALSE, FALSE, 0);
+
+    g_rt_mlock_switch = gtk_switch_new();
+    gtk_widget_set_tooltip_text(g_rt_mlock_switch,
+        "Keep the model weights and thread stacks in RAM (mlockall).\n"
+        "Needs an unlimited memlock limit; applied on the next start");
+    g_signal_connect(g_rt_mlock_switch, "state-set", G_CALLBACK(on_rt_mlock_changed), NULL);
+    gtk_box_pack_end(GTK_BOX(rt_mlock_hbox), g_rt_mlock_switch, FALSE, FALSE, 28);
+
+    gtk_box_pack_start(GTK_BOX(scontent), rt_mlock_hbox, FALSE, FALSE, 0);
+
     /* ── layout ────────────────────────────────────────────────────── */
     GtkWidget* vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
     gtk_container_set_border_width(GTK_CONTAINER(vbox), 12);
@@ -178,6 +178,7 @@ void meter_widget_update(GtkWidget* widget, float level)
         g_object_get_data(G_OBJECT(widget), STATE_KEY));
     if (!st) return;
 
+    float old_level = st->level, old_peak = st->peak;
     st->level = level;
 
     /* peak-hold / fall logic */
@@ -190,5 +191,7 @@ void meter_widget_update(GtkWidget* widget, float level)
         if (st->peak < 1e-7f) st->peak = 0.f;
     }
 
+    /* a silent meter with the peak already down stays as drawn */
+    if (st->level == old_level && st->peak == old_peak) return;
     gtk_widget_queue_draw(widget);
 }
@@ -2,9 +2,10 @@
 #include <gtk/gtk.h>
 
 /* Create a mono bar-meter GtkDrawingArea.
- *   - Call meter_widget_update() regularly (e.g. from a g_timeout_add callback)
- *     to push a fresh RMS level in.
+ *   - Call meter_widget_update() regularly (about 30 times a second, the
+ *     peak ballistics count calls) to push a fresh RMS level in.
  *   - Peak-hold and peak-fall logic is handled internally.
+ *   - Only redraws when the bar or the peak marker moved.
  */
 GtkWidget* meter_widget_new(void);
 void       meter_widget_update(GtkWidget* widget, float level);
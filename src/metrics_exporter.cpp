@@ -0,0 +1,378 @@
+#include "metrics_exporter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <utility>
+
+/* no MSG_NOSIGNAL on macOS, where accepted sockets get SO_NOSIGPIPE */
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* ── construction ────────────────────────────────────────────────────── */
+
+MetricsExporter::MetricsExporter(const std::string& mode, Source source,
+                                 const std::vector<std::string>& stage_names)
+    : mode_(mode), source_(std::move(source)), stage_names_(stage_names)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+    if (http_fd_   >= 0) ::close(http_fd_);
+    if (statsd_fd_ >= 0) ::close(statsd_fd_);
+}
+
+bool metrics_parse_endpoint(const std::string& s, const std::string& def_addr,
+                            std::string* addr, int* port)
+{
+    size_t colon = s.rfind(':');
+    std::string host = colon == std::string::npos ? "" : s.substr(0, colon);
+    std::string num  = colon == std::string::npos ? s  : s.substr(colon + 1);
+
+    char* end = nullptr;
+    long p = std::strtol(num.c_str(), &end, 10);
+    if (num.empty() || *end || p < 1 || p > 65535) return false;
+
+    *addr = host.empty() ? def_addr : host;
+    *port = static_cast<int>(p);
+    return true;
+}
+
+/* socket bound (passive) or connected to addr:port, -1 on error */
+static int open_socket(const std::string& addr, int port, int type, bool passive)
+{
+    addrinfo hints {};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = type;
+    hints.ai_flags    = passive ? AI_PASSIVE : 0;
+
+    addrinfo* res = nullptr;
+    std::string service = std::to_string(port);
+    int err = getaddrinfo(addr.empty() ? nullptr : addr.c_str(), service.c_str(), &hints, &res);
+    if (err != 0) {
+        std::fprintf(stderr, "metrics: %s:%d: %s\n", addr.c_str(), port, gai_strerror(err));
+        return -1;
+    }
+
+    int fd = -1;
+    for (addrinfo* ai = res; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        fcntl(fd, F_SETFD, FD_CLOEXEC);   /* SOCK_CLOEXEC is Linux only */
+        int ok;
+        if (passive) {
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+            ok = bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 8) == 0;
+        } else {
+            ok = connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+        }
+        if (!ok) { ::close(fd); fd = -1; }
+    }
+    if (fd < 0)
+        std::fprintf(stderr, "metrics: %s:%d: %s\n", addr.c_str(), port, std::strerror(errno));
+    freeaddrinfo(res);
+    return fd;
+}
+
+bool MetricsExporter::listen_http(const std::string& addr, int port)
+{
+    if (http_fd_ >= 0) ::close(http_fd_);
+    http_fd_ = open_socket(addr, port, SOCK_STREAM, true);
+    return http_fd_ >= 0;
+}
+
+bool MetricsExporter::push_statsd(const std::string& host, int port, int interval_ms)
+{
+    if (statsd_fd_ >= 0) ::close(statsd_fd_);
+    statsd_fd_       = open_socket(host, port, SOCK_DGRAM, false);
+    statsd_every_ms_ = std::max(100, interval_ms);
+    return statsd_fd_ >= 0;
+}
+
+/* ── thread ──────────────────────────────────────────────────────────── */
+
+void MetricsExporter::start()
+{
+    if (running_ || (http_fd_ < 0 && statsd_fd_ < 0)) return;
+    last_push_ = source_();
+    running_ = true;
+    thread_ = std::thread(&MetricsExporter::run, this);
+}
+
+void MetricsExporter::stop()
+{
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+void MetricsExporter::run()
+{
+    using clock = std::chrono::steady_clock;
+    auto next_push = clock::now() + std::chrono::milliseconds(statsd_every_ms_);
+
+    while (running_.load(std::memory_order_relaxed)) {
+        /* wake at least every 200 ms so stop() doesn't wait long */
+        int timeout = 200;
+        if (statsd_fd_ >= 0) {
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          next_push - clock::now()).count();
+            timeout = static_cast<int>(std::max<long long>(0, std::min<long long>(timeout, ms)));
+        }
+
+        pollfd pfd { http_fd_, POLLIN, 0 };
+        int n = poll(&pfd, http_fd_ >= 0 ? 1 : 0, timeout);
+        if (n > 0 && (pfd.revents & POLLIN))
+            serve_one();
+
+        if (statsd_fd_ >= 0 && clock::now() >= next_push) {
+            push_once(source_());
+            next_push += std::chrono::milliseconds(statsd_every_ms_);
+            if (next_push < clock::now())
+                next_push = clock::now() + std::chrono::milliseconds(statsd_every_ms_);
+        }
+    }
+}
+
+/* ── HTTP ────────────────────────────────────────────────────────────── */
+
+static bool send_all(int fd, const char* p, size_t n)
+{
+    while (n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w <= 0) {
+            if (w < 0 && errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+/* One request per connection, with short timeouts so a stuck client
+   can't hold up the next scrape or a statsd push */
+void MetricsExporter::serve_one()
+{
+    int fd = accept(http_fd_, nullptr, nullptr);
+    if (fd < 0) return;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof one);
+#endif
+
+    timeval tv { 0, 500000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+
+    char req[2048];
+    size_t len = 0;
+    while (len < sizeof req - 1) {
+        ssize_t r = recv(fd, req + len, sizeof req - 1 - len, 0);
+        if (r <= 0) break;
+        len += static_cast<size_t>(r);
+        req[len] = 0;
+        if (std::strstr(req, "\r\n\r\n") || std::strstr(req, "\n\n")) break;
+    }
+    req[len] = 0;
+
+    std::string body, status = "200 OK";
+    if (std::strncmp(req, "GET /metrics", 12) == 0 || std::strncmp(req, "GET / ", 6) == 0) {
+        body = prometheus_text(source_());
+    } else {
+        status = "404 Not Found";
+        body   = "try /metrics\n";
+    }
+
+    char head[160];
+    int hn = std::snprintf(head, sizeof head,
+                           "HTTP/1.0 %s\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: %zu\r\n"
+                           "Connection: close\r\n\r\n",
+                           status.c_str(), body.size());
+    if (send_all(fd, head, static_cast<size_t>(hn)))
+        send_all(fd, body.data(), body.size());
+    ::close(fd);
+}
+
+/* ── rendering ───────────────────────────────────────────────────────── */
+
+static void appendf(std::string& out, const char* fmt, ...)
+{
+    char line[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = std::vsnprintf(line, sizeof line, fmt, ap);
+    va_end(ap);
+    if (n > 0) out.append(line, static_cast<size_t>(std::min<int>(n, sizeof line - 1)));
+}
+
+/* DSP time over audio time since the counts in audio_ns and busy_ns,
+   which are then advanced.  The whole run if nothing new was processed */
+float MetricsExporter::realtime_factor(const Telemetry& t, uint64_t* audio_ns, uint64_t* busy_ns)
+{
+    if (t.audio_ns < *audio_ns || t.busy_ns < *busy_ns)   // pipeline restarted
+        *audio_ns = *busy_ns = 0;
+    uint64_t da = t.audio_ns - *audio_ns;
+    uint64_t db = t.busy_ns  - *busy_ns;
+    if (da == 0) {
+        da = t.audio_ns;
+        db = t.busy_ns;
+    } else {
+        *audio_ns = t.audio_ns;
+        *busy_ns  = t.busy_ns;
+    }
+    return da ? static_cast<float>(static_cast<double>(db) / static_cast<double>(da)) : 0.0f;
+}
+
+std::string MetricsExporter::prometheus_text(const Telemetry& t)
+{
+    const char* m  = mode_.c_str();
+    const bool  rx = mode_ == "rx";
+    std::string out;
+    out.reserve(4096);
+
+    auto head = [&](const char* name, const char* type, const char* help) {
+        appendf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    };
+    auto value = [&](const char* name, const char* type, const char* help, double v) {
+        head(name, type, help);
+        appendf(out, "%s{mode=\"%s\"} %.9g\n", name, m, v);
+    };
+    auto summary = [&](const char* stage, const rade_stage_stats& st) {
+        const char* name = stage ? "rade_stage_seconds" : "rade_latency_seconds";
+        char sl[80] = "";
+        if (stage) std::snprintf(sl, sizeof sl, ",stage=\"%s\"", stage);
+        appendf(out, "%s{mode=\"%s\"%s,quantile=\"0.5\"} %.9g\n",  name, m, sl, st.p50_us * 1e-6);
+        appendf(out, "%s{mode=\"%s\"%s,quantile=\"0.99\"} %.9g\n", name, m, sl, st.p99_us * 1e-6);
+        appendf(out, "%s{mode=\"%s\"%s,quantile=\"1\"} %.9g\n",    name, m, sl, st.max_us * 1e-6);
+        appendf(out, "%s_sum{mode=\"%s\"%s} %.9g\n", name, m, sl,
+                static_cast<double>(st.mean_us) * st.count * 1e-6);
+        appendf(out, "%s_count{mode=\"%s\"%s} %u\n", name, m, sl, st.count);
+    };
+
+    value("rade_frames_total", "counter", "Modem frames processed", static_cast<double>(t.frame));
+    value("rade_audio_seconds_total", "counter", "Modem audio processed by the DSP thread",
+          t.audio_ns * 1e-9);
+    value("rade_busy_seconds_total", "counter", "DSP thread time spent processing it",
+          t.busy_ns * 1e-9);
+    value("rade_realtime_factor", "gauge",
+          "DSP time over audio time since the last scrape, above 1 is not keeping up",
+          realtime_factor(t, &http_audio_ns_, &http_busy_ns_));
+    value("rade_capture_overruns_total", "counter", "Capture ring overruns", t.capture_overruns);
+    value("rade_playback_underruns_total", "counter", "Playback ring underruns", t.playback_underruns);
+    value("rade_input_level", "gauge", "Input RMS level, 0..1", t.input_level);
+    value("rade_output_level", "gauge", "Output RMS level, 0..1", t.output_level);
+
+    if (rx) {
+        value("rade_synced", "gauge", "1 while the receiver is in sync", t.synced ? 1 : 0);
+        value("rade_snr_db", "gauge", "SNR estimate in 3 kHz, last while in sync", t.snr_dB);
+        value("rade_freq_offset_hz", "gauge", "Frequency offset, last while in sync", t.freq_offset);
+        value("rade_syncs_total", "counter", "Times sync was gained", t.syncs);
+        if (t.first_sync_s >= 0.0f)
+            value("rade_first_sync_seconds", "gauge", "Audio time from start to first sync",
+                  t.first_sync_s);
+        value("rade_resyncs_total", "counter", "Re-syncs after a fade", t.resync.count);
+        value("rade_resyncs_warm_total", "counter", "... of which by the warm search", t.resync.warm);
+        head("rade_resync_seconds", "gauge", "Time to re-sync after a fade");
+        appendf(out, "rade_resync_seconds{mode=\"%s\",stat=\"last\"} %.9g\n", m, t.resync.last_s);
+        appendf(out, "rade_resync_seconds{mode=\"%s\",stat=\"mean\"} %.9g\n", m, t.resync.mean_s);
+        appendf(out, "rade_resync_seconds{mode=\"%s\",stat=\"max\"} %.9g\n",  m, t.resync.max_s);
+        value("rade_eoo_frames_total", "counter", "End of over frames received", t.eoo_frames);
+        value("rade_eoo_callsigns_total", "counter", "... with a callsign that decoded",
+              t.eoo_callsigns);
+        value("rade_shed_level", "gauge", "Load shedding level, 0 = nothing shed", t.shed_level);
+        value("rade_shed_changes_total", "counter", "Load shedding level changes", t.shed_changes);
+        head("rade_latency_seconds", "summary", "End to end latency, antenna sample to speaker sample");
+        summary(nullptr, t.latency);
+    }
+
+    head("rade_stage_seconds", "summary", "Time per call of each pipeline stage");
+    for (int i = 0; i < t.n_stages && i < static_cast<int>(stage_names_.size()); i++)
+        summary(stage_names_[static_cast<size_t>(i)].c_str(), t.stages[i]);
+
+    return out;
+}
+
+/* ── statsd ──────────────────────────────────────────────────────────── */
+
+/* Gauges for levels and timers, counters as the increase since the last
+   push, batched into datagrams that fit an Ethernet MTU */
+void MetricsExporter::push_once(const Telemetry& t)
+{
+    const Telemetry& p = last_push_;
+    const bool rx = mode_ == "rx";
+    std::string pkt;
+    pkt.reserve(1500);
+
+    auto flush = [&] {
+        if (!pkt.empty()) send(statsd_fd_, pkt.data(), pkt.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        pkt.clear();
+    };
+    auto line = [&](const char* fmt, ...) {
+        char buf[160];
+        va_list ap;
+        va_start(ap, fmt);
+        int n = std::vsnprintf(buf, sizeof buf, fmt, ap);
+        va_end(ap);
+        if (n <= 0) return;
+        if (pkt.size() + static_cast<size_t>(n) > 1400) flush();
+        pkt.append(buf, static_cast<size_t>(std::min<int>(n, sizeof buf - 1)));
+    };
+    auto delta = [](uint64_t now, uint64_t before) { return now >= before ? now - before : now; };
+    const char* m = mode_.c_str();
+
+    uint64_t audio = p.audio_ns, busy = p.busy_ns;
+    line("rade.%s.realtime_factor:%.4f|g\n", m, realtime_factor(t, &audio, &busy));
+    line("rade.%s.frames:%llu|c\n", m, static_cast<unsigned long long>(delta(t.frame, p.frame)));
+    line("rade.%s.capture_overruns:%llu|c\n", m,
+         static_cast<unsigned long long>(delta(t.capture_overruns, p.capture_overruns)));
+    line("rade.%s.playback_underruns:%llu|c\n", m,
+         static_cast<unsigned long long>(delta(t.playback_underruns, p.playback_underruns)));
+    line("rade.%s.input_level:%.4f|g\n", m, t.input_level);
+    line("rade.%s.output_level:%.4f|g\n", m, t.output_level);
+
+    if (rx) {
+        line("rade.rx.synced:%d|g\n", t.synced ? 1 : 0);
+        line("rade.rx.snr_db:%.1f|g\n", t.snr_dB);
+        line("rade.rx.freq_offset_hz:%.2f|g\n", t.freq_offset);
+        line("rade.rx.syncs:%llu|c\n", static_cast<unsigned long long>(delta(t.syncs, p.syncs)));
+        if (t.first_sync_s >= 0.0f)
+            line("rade.rx.first_sync_s:%.3f|g\n", t.first_sync_s);
+        line("rade.rx.resyncs:%llu|c\n",
+             static_cast<unsigned long long>(delta(t.resync.count, p.resync.count)));
+        line("rade.rx.resync_last_s:%.3f|g\n", t.resync.last_s);
+        line("rade.rx.eoo_frames:%llu|c\n",
+             static_cast<unsigned long long>(delta(t.eoo_frames, p.eoo_frames)));
+        line("rade.rx.eoo_callsigns:%llu|c\n",
+             static_cast<unsigned long long>(delta(t.eoo_callsigns, p.eoo_callsigns)));
+        line("rade.rx.shed_level:%d|g\n", t.shed_level);
+        line("rade.rx.latency.p50_ms:%.2f|g\n", t.latency.p50_us * 1e-3f);
+        line("rade.rx.latency.p99_ms:%.2f|g\n", t.latency.p99_us * 1e-3f);
+    }
+
+    for (int i = 0; i < t.n_stages && i < static_cast<int>(stage_names_.size()); i++) {
+        const char* s = stage_names_[static_cast<size_t>(i)].c_str();
+        line("rade.%s.stage.%s.p50_us:%.1f|g\n", m, s, t.stages[i].p50_us);
+        line("rade.%s.stage.%s.p99_us:%.1f|g\n", m, s, t.stages[i].p99_us);
+        line("rade.%s.stage.%s.max_us:%.1f|g\n", m, s, t.stages[i].max_us);
+    }
+    flush();
+
+    last_push_ = t;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "telemetry.h"
+
+/* ── MetricsExporter ───────────────────────────────────────────────────────
+ *
+ *  Serves a running pipeline's Telemetry to monitoring, from its own
+ *  thread: Prometheus text at http://ADDR:PORT/metrics, and/or statsd
+ *  gauges and counters pushed over UDP every interval.  It only ever
+ *  reads the lock-free snapshot, so a scrape never waits on, or is
+ *  waited on by, the DSP thread.
+ *
+ *  Stage timers are exported as Prometheus summaries (p50, p99 and max
+ *  quantiles, sum and count in seconds).  rade_realtime_factor is DSP
+ *  time over audio time since the previous scrape or push; above 1 the
+ *  node is not keeping up.
+ *
+ *      MetricsExporter m("rx", [&] { return dec.telemetry(); }, names);
+ *      m.listen_http("0.0.0.0", 9464);
+ *      m.push_statsd("127.0.0.1", 8125, 10000);
+ *      m.start();
+ * ──────────────────────────────────────────────────────────────────────── */
+
+class MetricsExporter {
+public:
+    using Source = std::function<Telemetry()>;
+
+    /* mode is the "mode" label (rx, tx), stage_names as stage_name(i) */
+    MetricsExporter(const std::string& mode, Source source,
+                    const std::vector<std::string>& stage_names);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&)            = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /* call before start(), false if the socket can't be set up */
+    bool listen_http(const std::string& addr, int port);
+    bool push_statsd(const std::string& host, int port, int interval_ms);
+
+    void start();
+    void stop();
+
+    /* the Prometheus page for t, e.g. for another transport */
+    std::string prometheus_text(const Telemetry& t);
+
+private:
+    void run();
+    void serve_one();
+    void push_once(const Telemetry& t);
+    static float realtime_factor(const Telemetry& t, uint64_t* audio_ns, uint64_t* busy_ns);
+
+    std::string              mode_;
+    Source                   source_;
+    std::vector<std::string> stage_names_;
+
+    int http_fd_         = -1;
+    int statsd_fd_       = -1;
+    int statsd_every_ms_ = 0;
+
+    /* last values seen, for the real-time factor and the statsd counter
+       deltas; only the exporter thread touches these */
+    uint64_t  http_audio_ns_ = 0, http_busy_ns_ = 0;
+    Telemetry last_push_ {};
+
+    std::atomic<bool> running_ {false};
+    std::thread       thread_;
+};
+
+/* "PORT", ":PORT" or "ADDR:PORT" to addr and port, addr defaulting to
+   def_addr.  False if the port isn't 1..65535 */
+bool metrics_parse_endpoint(const std::string& s, const std::string& def_addr,
+                            std::string* addr, int* port);
@@ -34,15 +34,33 @@
 */
 
 #include "rade_acq.h"
+#include "rade_tables.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <assert.h>
 
+/* Linear congruential generator (Numerical Recipes constants), returns 0..32767 */
+static int acq_rand(rade_acq *acq) {
+    acq->rand_state = acq->rand_state * 1664525u + 1013904223u;
+    return (int)((acq->rand_state >> 16) & 0x7fff);
+}
+
+/* Noise estimate from the mean |Dt| over the correlation grid, assuming a
+   Rayleigh distribution (mean = sigma*sqrt(pi/2)).  The rows span every
+   window searched */
+static float acq_sigma_r(const rade_acq *acq) {
+    float count = (float)acq->nmf * (float)(acq->n_fcoarse * acq->n_win);
+    float sigma_r1 = ((float)acq->sum_abs_Dt1 / count) / sqrtf(M_PI / 2.0f);
+    float sigma_r2 = ((float)acq->sum_abs_Dt2 / count) / sqrtf(M_PI / 2.0f);
+    return (sigma_r1 + sigma_r2) / 2.0f;
+}
+
 /*---------------------------------------------------------------------------*\
                            INITIALIZATION
 \*---------------------------------------------------------------------------*/
 
-void rade_acq_init(rade_acq *acq, const rade_ofdm *ofdm, float frange, float fstep) {
+void rade_acq_init(rade_acq *acq, const rade_ofdm *ofdm, int engine) {
     memset(acq, 0, sizeof(rade_acq));
 
     acq->fs = RADE_FS;
@@ -52,102 +70,424 @@ void rade_acq_init(rade_acq *acq, const rade_ofdm *ofdm, float frange, float fst
 
     acq->Pacq_error1 = RADE_ACQ_PACQ_ERR1;
     acq->Pacq_error2 = RADE_ACQ_PACQ_ERR2;
+    acq->rand_state = 1;
+    acq->n_refresh = RADE_ACQ_NREFRESH;
+    acq->kern = rade_kernels_get();
+
+    /* Pilots from OFDM, the search grid from the shared tables */
+    acq->p = ofdm->p;
+    acq->pend = ofdm->pend;
+    acq->sigma_p = rade_acq_tab.sigma_p;
+    acq->fcoarse_range = rade_acq_tab.fcoarse_range;
+    acq->n_fcoarse = rade_acq_tab.n_fcoarse;
+    acq->p_w_re = rade_acq_tab.p_w_re;
+    acq->p_w_im = rade_acq_tab.p_w_im;
+
+    /* One window around zero until rade_acq_set_range() */
+    acq->n_win = 1;
+    acq->win_k[0] = 0;
+    acq->wide_nwin = 1;
+
+    acq->engine = RADE_ACQ_ENGINE_DIRECT;
+    if (engine == RADE_ACQ_ENGINE_FFT) {
+        if (rade_acq_tab.nfft > 0) {
+            acq->engine = RADE_ACQ_ENGINE_FFT;
+            acq->nfft = rade_acq_tab.nfft;
+            acq->k_fcoarse = rade_acq_tab.k_fcoarse;
+            acq->fft = &rade_fft_acq;
+            acq->P_conj = rade_acq_tab.P_conj;
+
+            /* RADE band for the wide search's coarse stage, the carriers
+               +/- Rs'/2 */
+            float bin_Hz = (float)acq->fs / acq->nfft;
+            float Rs_dash = (float)acq->fs / acq->m;
+            float f_lo = ofdm->w[0] * acq->fs / (2.0f * M_PI) - Rs_dash / 2.0f;
+            float f_hi = ofdm->w[RADE_NC - 1] * acq->fs / (2.0f * M_PI) + Rs_dash / 2.0f;
+            acq->band_lo = (int)floorf(f_lo / bin_Hz);
+            acq->band_hi = (int)ceilf(f_hi / bin_Hz);
+        } else {
+            fprintf(stderr, "rade_acq_init: fstep=%f not supported by FFT engine, using direct search\n",
+                    (double)RADE_ACQ_FSTEP);
+        }
+    }
+}
 
-    /* Copy pilot symbols from OFDM */
-    memcpy(acq->p, ofdm->p, sizeof(RADE_COMP) * RADE_M);
-    memcpy(acq->pend, ofdm->pend, sizeof(RADE_COMP) * RADE_M);
-
-    /* Calculate pilot power */
-    RADE_COMP p_dot = rade_cdot(ofdm->p, ofdm->p, RADE_M);
-    acq->sigma_p = sqrtf(p_dot.real);
+void rade_acq_set_range(rade_acq *acq, float range_Hz, int nwin) {
+    acq->wide_bins = 0;
+    acq->wide_nwin = 1;
+    acq->n_win = 1;
+    acq->win_k[0] = 0;
 
-    /* Set up frequency search range */
-    acq->n_fcoarse = 0;
-    for (float f = -frange / 2.0f; f < frange / 2.0f && acq->n_fcoarse < RADE_ACQ_NFREQ; f += fstep) {
-        acq->fcoarse_range[acq->n_fcoarse++] = f;
+    if (range_Hz <= RADE_ACQ_FRANGE / 2.0f || nwin < 2) {
+        return;
+    }
+    if (acq->engine != RADE_ACQ_ENGINE_FFT) {
+        fprintf(stderr, "rade_acq_set_range: wide search needs the FFT engine, searching +/- %.0f Hz\n",
+                (double)(RADE_ACQ_FRANGE / 2.0f));
+        return;
     }
 
-    /* Pre-compute frequency-shifted pilots: p_w[n][f_idx] = p[n] * exp(j*w*n)
-       where w = 2*pi*f/Fs */
-    for (int f_idx = 0; f_idx < acq->n_fcoarse; f_idx++) {
-        float f = acq->fcoarse_range[f_idx];
-        float w = 2.0f * M_PI * f / acq->fs;
-
-        for (int n = 0; n < RADE_M; n++) {
-            RADE_COMP w_vec = rade_cexp(w * n);
-            acq->p_w[n][f_idx] = rade_cmul(w_vec, acq->p[n]);
-        }
+    /* The band shifted by up to wide_bins has to stay inside the FFT (the
+       coarse stage doesn't wrap), and nominated windows need room clear of
+       the one around zero */
+    float bin_Hz = (float)acq->fs / acq->nfft;
+    int bins = (int)ceilf(range_Hz / bin_Hz);
+    int bins_max = acq->band_lo;
+    if (acq->nfft - 1 - acq->band_hi < bins_max) {
+        bins_max = acq->nfft - 1 - acq->band_hi;
+    }
+    if (bins > bins_max) {
+        bins = bins_max;
+    }
+    if (bins - acq->n_fcoarse / 2 < acq->n_fcoarse) {
+        return;
     }
+
+    acq->wide_bins = bins;
+    acq->wide_nwin = (nwin < RADE_ACQ_WIDE_NWIN_MAX) ? nwin : RADE_ACQ_WIDE_NWIN_MAX;
 }
 
 /*---------------------------------------------------------------------------*\
                            PILOT DETECTION
 \*---------------------------------------------------------------------------*/
 
-int rade_acq_detect_pilots(rade_acq *acq, const RADE_COMP *rx, int *tmax, float *fmax) {
-    int M = acq->m;
+/* Peak of the combined metric |Dt1| + |Dt2|.  The grid is visited in a
+   different order by each engine, so ties go to the smallest (t, f) as
+   they would in a t-major scan */
+static void acq_peak(float Dt12, int t, int f_idx, float *Dtmax12, int *t_max, int *f_ind_max) {
+    if (Dt12 > *Dtmax12 ||
+        (Dt12 == *Dtmax12 && (t < *t_max || (t == *t_max && f_idx < *f_ind_max)))) {
+        *Dtmax12 = Dt12;
+        *t_max = t;
+        *f_ind_max = f_idx;
+    }
+}
+
+/* One row of the correlation grid, Dt1[t][:] and Dt2[t][:], from the M
+   samples at the first pilot (rx1 = &rx[t]) and one modem frame later */
+static void acq_grid_row(const rade_acq *acq, const RADE_COMP *rx1, const RADE_COMP *rx2,
+                         float *Dt1_re, float *Dt1_im, float *Dt2_re, float *Dt2_im) {
+    /* Note: Python uses np.conj(rx) first, then matmul
+       So Dt1[t] = conj(rx[t:t+M]) . p_w */
+    acq->kern->cvmmul_split(Dt1_re, Dt1_im, rx1, &acq->p_w_re[0][0], &acq->p_w_im[0][0],
+                            RADE_ACQ_NFREQ, acq->m, acq->n_fcoarse, 1);
+    acq->kern->cvmmul_split(Dt2_re, Dt2_im, rx2, &acq->p_w_re[0][0], &acq->p_w_im[0][0],
+                            RADE_ACQ_NFREQ, acq->m, acq->n_fcoarse, 1);
+}
+
+/* Brute force correlation search over rows t0 <= t < t1:
+   Dt1[t][f] = sum(conj(rx[t:t+M]) * p_w[:][f]), Dt2 one modem frame later.
+   Only the row sums of |Dt1|, |Dt2| and the peak are kept */
+static void acq_search_direct(rade_acq *acq, const RADE_COMP *rx, int t0, int t1,
+                              float *Dtmax12, int *t_max, int *f_ind_max) {
     int Nmf = acq->nmf;
     int n_fcoarse = acq->n_fcoarse;
+    float Dt1_re[RADE_ACQ_NFREQ], Dt1_im[RADE_ACQ_NFREQ];
+    float Dt2_re[RADE_ACQ_NFREQ], Dt2_im[RADE_ACQ_NFREQ];
 
-    /* We need buffer of 2*Nmf + M + Ncp samples */
-    /* Search over one modem frame for maxima */
+    for (int t = t0; t < t1; t++) {
+        float row_abs_Dt1 = 0.0f;
+        float row_abs_Dt2 = 0.0f;
 
-    float Dtmax12 = 0.0f;
-    int f_ind_max = 0;
-    int t_max = 0;
-    float f_max = 0.0f;
+        acq_grid_row(acq, &rx[t], &rx[t + Nmf], Dt1_re, Dt1_im, Dt2_re, Dt2_im);
+        for (int f_idx = 0; f_idx < n_fcoarse; f_idx++) {
+            float abs_Dt1 = rade_cabs(rade_cmplx(Dt1_re[f_idx], Dt1_im[f_idx]));
+            float abs_Dt2 = rade_cabs(rade_cmplx(Dt2_re[f_idx], Dt2_im[f_idx]));
+            acq_peak(abs_Dt1 + abs_Dt2, t, f_idx, Dtmax12, t_max, f_ind_max);
+            row_abs_Dt1 += abs_Dt1;
+            row_abs_Dt2 += abs_Dt2;
+        }
+
+        acq->row_abs_Dt1[t] = row_abs_Dt1;
+        acq->row_abs_Dt2[t] = row_abs_Dt2;
+    }
+}
 
-    /* Clear correlation grids */
-    memset(acq->Dt1, 0, sizeof(acq->Dt1));
-    memset(acq->Dt2, 0, sizeof(acq->Dt2));
+/* Coarse stage of the wide search, on the rx spectrum R.  Each window
+   centre kc within range is scored by the rx energy in the RADE band
+   shifted by kc, a sliding sum over |R|^2.  A signal lifts the score of
+   every centre that overlaps its band, most where they line up, so the
+   best one is within a window of it at SNRs the pilot search works at.
+   Windows go to the best scoring centres at least a window clear of zero
+   and of each other, so no bin is searched twice */
+static void acq_wide_windows(rade_acq *acq) {
+    int n = acq->n_fcoarse;
+    int kmax = acq->wide_bins - n / 2;
+    const RADE_COMP *R = acq->R;
+    float *score = &acq->wide_score[kmax];
+
+    double e = 0.0;
+    for (int m = acq->band_lo - kmax; m <= acq->band_hi - kmax; m++) {
+        e += rade_cabs2(R[m]);
+    }
+    for (int kc = -kmax; kc <= kmax; kc++) {
+        score[kc] = (float)e;
+        if (kc < kmax) {
+            e += (double)rade_cabs2(R[acq->band_hi + kc + 1]) - rade_cabs2(R[acq->band_lo + kc]);
+        }
+    }
 
-    /* Search over time and frequency */
-    for (int t = 0; t < Nmf; t++) {
-        for (int f_idx = 0; f_idx < n_fcoarse; f_idx++) {
-            /* Correlate with frequency-shifted pilot at time t
-               Dt1 = sum(conj(rx[t:t+M]) * p_w[:][f_idx]) */
-            RADE_COMP Dt1 = rade_czero();
-            RADE_COMP Dt2 = rade_czero();
-
-            for (int n = 0; n < M; n++) {
-                /* Note: Python uses np.conj(rx) first, then matmul
-                   So Dt1[t] = conj(rx[t:t+M]) . p_w */
-                Dt1 = rade_cadd(Dt1, rade_cmul(rade_cconj(rx[t + n]), acq->p_w[n][f_idx]));
-                Dt2 = rade_cadd(Dt2, rade_cmul(rade_cconj(rx[t + Nmf + n]), acq->p_w[n][f_idx]));
+    acq->n_win = 1;
+    acq->win_k[0] = 0;
+    while (acq->n_win < acq->wide_nwin) {
+        int k_best = 0;
+        float score_best = -1.0f;
+        for (int kc = -kmax; kc <= kmax; kc++) {
+            int clear = 1;
+            for (int j = 0; j < acq->n_win; j++) {
+                if (abs(kc - acq->win_k[j]) < n) {
+                    clear = 0;
+                }
+            }
+            if (clear && score[kc] > score_best) {
+                score_best = score[kc];
+                k_best = kc;
             }
+        }
+        if (score_best < 0.0f) {
+            break;
+        }
+        acq->win_k[acq->n_win++] = k_best;
+    }
+}
+
+/* Same search via FFT cross-correlation.  With q[n] = p[n]*exp(j*2*pi*k*n/N),
+   c[t] = sum(rx[t+n] * conj(q[n])) = IFFT(R * conj(Q))[t] / N, and
+   Dt1[t] = conj(c[t]), Dt2[t] = conj(c[t+Nmf]).  N covers the whole rx
+   buffer so the circular correlation never wraps for the lags we use.
+   Each IFFT gives one frequency column, which we fold into the row sums
+   straight away.  The columns are the n_fcoarse offsets around each
+   window centre, f_idx counting on through the windows in turn */
+static void acq_fft_spectrum(rade_acq *acq, const RADE_COMP *rx) {
+    int N = acq->nfft;
+    int buf_len = 2 * acq->nmf + acq->m + acq->ncp;
+
+    memset(acq->X, 0, sizeof(RADE_COMP) * N);
+    memcpy(acq->X, rx, sizeof(RADE_COMP) * buf_len);
+    rade_fft(acq->fft, acq->R, acq->X);
+
+    if (acq->wide_bins > 0) {
+        acq_wide_windows(acq);
+    }
+}
 
-            acq->Dt1[t][f_idx] = Dt1;
-            acq->Dt2[t][f_idx] = Dt2;
+/* Cross correlation c for grid column f_idx, X is scratch */
+static void acq_fft_column(const rade_acq *acq, int f_idx, RADE_COMP *X, RADE_COMP *c) {
+    int N = acq->nfft;
+    int k = acq->win_k[f_idx / acq->n_fcoarse] + acq->k_fcoarse[f_idx % acq->n_fcoarse];
 
-            /* Combined metric: |Dt1| + |Dt2| */
-            float Dt12 = rade_cabs(Dt1) + rade_cabs(Dt2);
+    /* X[m] = R[m] * conj(P[(m-k) mod N]), split to avoid the modulo */
+    int k0 = (k >= 0) ? k : N + k;
+    acq->kern->cvmul(X, acq->R, &acq->P_conj[N - k0], k0, 0);
+    acq->kern->cvmul(&X[k0], &acq->R[k0], acq->P_conj, N - k0, 0);
 
-            if (Dt12 > Dtmax12) {
-                Dtmax12 = Dt12;
-                f_ind_max = f_idx;
-                f_max = acq->fcoarse_range[f_idx];
-                t_max = t;
-            }
+    rade_ifft(acq->fft, c, X);
+}
+
+static void acq_search_fft(rade_acq *acq, const RADE_COMP *rx,
+                           float *Dtmax12, int *t_max, int *f_ind_max) {
+    int Nmf = acq->nmf;
+    float scale = 1.0f / acq->nfft;
+
+    acq_fft_spectrum(acq, rx);
+
+    memset(acq->row_abs_Dt1, 0, sizeof(float) * Nmf);
+    memset(acq->row_abs_Dt2, 0, sizeof(float) * Nmf);
+
+    for (int f_idx = 0; f_idx < acq->n_fcoarse * acq->n_win; f_idx++) {
+        acq_fft_column(acq, f_idx, acq->X, acq->c);
+
+        for (int t = 0; t < Nmf; t++) {
+            float abs_Dt1 = rade_cabs(rade_cscale(acq->c[t], scale));
+            float abs_Dt2 = rade_cabs(rade_cscale(acq->c[t + Nmf], scale));
+            acq_peak(abs_Dt1 + abs_Dt2, t, f_idx, Dtmax12, t_max, f_ind_max);
+            acq->row_abs_Dt1[t] += abs_Dt1;
+            acq->row_abs_Dt2[t] += abs_Dt2;
         }
     }
+}
 
-    /* Calculate threshold based on noise statistics
-       Ref: radae.pdf "Pilot Detection over Multiple Frames" */
-    float sum_abs_Dt1 = 0.0f;
-    float sum_abs_Dt2 = 0.0f;
-    int count = 0;
+/*---------------------------------------------------------------------------*\
+                           THREADED SEARCH
+\*---------------------------------------------------------------------------*/
 
-    for (int t = 0; t < Nmf; t++) {
-        for (int f_idx = 0; f_idx < n_fcoarse; f_idx++) {
-            sum_abs_Dt1 += rade_cabs(acq->Dt1[t][f_idx]);
-            sum_abs_Dt2 += rade_cabs(acq->Dt2[t][f_idx]);
-            count++;
+/* Worker i of n takes the i-th of n near equal slices of [0, len) */
+#define ACQ_SLICE_LO(len, i, n) ((len) * (i) / (n))
+#define ACQ_SLICE_HI(len, i, n) ((len) * ((i) + 1) / (n))
+
+struct rade_acq_worker {
+    RADE_COMP X[RADE_ACQ_NFFT_MAX];            /* Scratch: cross spectrum */
+    RADE_COMP c[RADE_ACQ_NFFT_MAX];            /* Scratch: cross correlation */
+    float Dtmax12;                              /* Peak over this worker's slice */
+    int t_max;
+    int f_ind_max;
+};
+
+typedef struct {
+    rade_acq *acq;
+    const RADE_COMP *rx;
+} acq_job;
+
+static void acq_worker_start(struct rade_acq_worker *w) {
+    w->Dtmax12 = 0.0f;
+    w->t_max = 0;
+    w->f_ind_max = 0;
+}
+
+/* Direct engine: rows are independent, each worker takes a slice of t */
+static void acq_direct_worker(void *arg, int i, int n) {
+    const acq_job *job = (const acq_job *)arg;
+    rade_acq *acq = job->acq;
+    struct rade_acq_worker *w = &acq->workers[i];
+
+    acq_worker_start(w);
+    acq_search_direct(acq, job->rx,
+                      ACQ_SLICE_LO(acq->nmf, i, n), ACQ_SLICE_HI(acq->nmf, i, n),
+                      &w->Dtmax12, &w->t_max, &w->f_ind_max);
+}
+
+/* FFT engine, first pass: a slice of the columns, |Dt1| and |Dt2| */
+static void acq_fft_col_worker(void *arg, int i, int n) {
+    rade_acq *acq = ((const acq_job *)arg)->acq;
+    struct rade_acq_worker *w = &acq->workers[i];
+    int Nmf = acq->nmf;
+    int n_col = acq->n_fcoarse * acq->n_win;
+    float scale = 1.0f / acq->nfft;
+
+    for (int f_idx = ACQ_SLICE_LO(n_col, i, n); f_idx < ACQ_SLICE_HI(n_col, i, n); f_idx++) {
+        float *col_Dt1 = &acq->col_abs_Dt1[f_idx * Nmf];
+        float *col_Dt2 = &acq->col_abs_Dt2[f_idx * Nmf];
+
+        acq_fft_column(acq, f_idx, w->X, w->c);
+        for (int t = 0; t < Nmf; t++) {
+            col_Dt1[t] = rade_cabs(rade_cscale(w->c[t], scale));
+            col_Dt2[t] = rade_cabs(rade_cscale(w->c[t + Nmf], scale));
+        }
+    }
+}
+
+/* Second pass: the row sums and peak over a slice of t, adding the
+   columns in f_idx order as acq_search_fft() does */
+static void acq_fft_row_worker(void *arg, int i, int n) {
+    rade_acq *acq = ((const acq_job *)arg)->acq;
+    struct rade_acq_worker *w = &acq->workers[i];
+    int Nmf = acq->nmf;
+    int n_col = acq->n_fcoarse * acq->n_win;
+    int t0 = ACQ_SLICE_LO(Nmf, i, n);
+    int t1 = ACQ_SLICE_HI(Nmf, i, n);
+
+    acq_worker_start(w);
+    for (int t = t0; t < t1; t++) {
+        acq->row_abs_Dt1[t] = 0.0f;
+        acq->row_abs_Dt2[t] = 0.0f;
+    }
+    for (int f_idx = 0; f_idx < n_col; f_idx++) {
+        const float *col_Dt1 = &acq->col_abs_Dt1[f_idx * Nmf];
+        const float *col_Dt2 = &acq->col_abs_Dt2[f_idx * Nmf];
+        for (int t = t0; t < t1; t++) {
+            acq_peak(col_Dt1[t] + col_Dt2[t], t, f_idx, &w->Dtmax12, &w->t_max, &w->f_ind_max);
+            acq->row_abs_Dt1[t] += col_Dt1[t];
+            acq->row_abs_Dt2[t] += col_Dt2[t];
+        }
+    }
+}
+
+/* Either engine on the pool.  acq_peak() picks the smallest (t, f) on a
+   tie, so folding the workers' peaks in any order gives the serial one */
+static void acq_search_threads(rade_acq *acq, const RADE_COMP *rx,
+                               float *Dtmax12, int *t_max, int *f_ind_max) {
+    acq_job job = { acq, rx };
+
+    if (acq->engine == RADE_ACQ_ENGINE_FFT) {
+        acq_fft_spectrum(acq, rx);
+        rade_pool_run(acq->pool, acq_fft_col_worker, &job);
+        rade_pool_run(acq->pool, acq_fft_row_worker, &job);
+    } else {
+        rade_pool_run(acq->pool, acq_direct_worker, &job);
+    }
+
+    for (int i = 0; i < rade_pool_size(acq->pool); i++) {
+        const struct rade_acq_worker *w = &acq->workers[i];
+        acq_peak(w->Dtmax12, w->t_max, w->f_ind_max, Dtmax12, t_max, f_ind_max);
+    }
+}
+
+int rade_acq_set_threads(rade_acq *acq, int n_threads) {
+    rade_acq_close(acq);
+    if (n_threads <= 1) {
+        return 1;
+    }
+    if (n_threads > RADE_ACQ_MAX_THREADS) {
+        n_threads = RADE_ACQ_MAX_THREADS;
+    }
+
+    int ok = 1;
+    acq->workers = (struct rade_acq_worker *)malloc(sizeof(struct rade_acq_worker) * n_threads);
+    ok = ok && acq->workers != NULL;
+    if (acq->engine == RADE_ACQ_ENGINE_FFT) {
+        /* room for the widest search rade_acq_set_range() allows */
+        size_t n_grid = (size_t)acq->n_fcoarse * RADE_ACQ_WIDE_NWIN_MAX * acq->nmf;
+        acq->col_abs_Dt1 = (float *)malloc(sizeof(float) * n_grid);
+        acq->col_abs_Dt2 = (float *)malloc(sizeof(float) * n_grid);
+        ok = ok && acq->col_abs_Dt1 != NULL && acq->col_abs_Dt2 != NULL;
+    }
+    if (ok) {
+        acq->pool = rade_pool_create(n_threads);
+    }
+    if (acq->pool == NULL) {
+        fprintf(stderr, "rade_acq_set_threads: can't start %d threads, searching on one\n", n_threads);
+        rade_acq_close(acq);
+        return 1;
+    }
+    return n_threads;
+}
+
+void rade_acq_close(rade_acq *acq) {
+    rade_pool_destroy(acq->pool);
+    free(acq->workers);
+    free(acq->col_abs_Dt1);
+    free(acq->col_abs_Dt2);
+    acq->pool = NULL;
+    acq->workers = NULL;
+    acq->col_abs_Dt1 = NULL;
+    acq->col_abs_Dt2 = NULL;
+}
+
+int rade_acq_detect_pilots(rade_acq *acq, const RADE_COMP *rx, int *tmax, float *fmax) {
+    int Nmf = acq->nmf;
+
+    /* We need buffer of 2*Nmf + M + Ncp samples */
+    /* Search over one modem frame for the peak of |Dt1| + |Dt2|, and sum
+       the grid for the threshold calculation (Ref: radae.pdf "Pilot
+       Detection over Multiple Frames") */
+    float Dtmax12 = 0.0f;
+    int f_ind_max = 0;
+    int t_max = 0;
+
+    if (acq->pool != NULL) {
+        acq_search_threads(acq, rx, &Dtmax12, &t_max, &f_ind_max);
+    } else if (acq->engine == RADE_ACQ_ENGINE_FFT) {
+        acq_search_fft(acq, rx, &Dtmax12, &t_max, &f_ind_max);
+    } else {
+        acq_search_direct(acq, rx, 0, Nmf, &Dtmax12, &t_max, &f_ind_max);
+    }
+    float f_max = 0.0f;
+    if (Dtmax12 > 0.0f) {
+        int win = f_ind_max / acq->n_fcoarse;
+        f_max = acq->fcoarse_range[f_ind_max % acq->n_fcoarse];
+        if (win > 0) {
+            f_max += acq->win_k[win] * ((float)acq->fs / acq->nfft);
         }
     }
 
-    float sigma_r1 = (sum_abs_Dt1 / count) / sqrtf(M_PI / 2.0f);
-    float sigma_r2 = (sum_abs_Dt2 / count) / sqrtf(M_PI / 2.0f);
-    float sigma_r = (sigma_r1 + sigma_r2) / 2.0f;
+    acq->sum_abs_Dt1 = 0.0;
+    acq->sum_abs_Dt2 = 0.0;
+    for (int t = 0; t < Nmf; t++) {
+        acq->sum_abs_Dt1 += acq->row_abs_Dt1[t];
+        acq->sum_abs_Dt2 += acq->row_abs_Dt2[t];
+    }
+
+    float sigma_r = acq_sigma_r(acq);
 
     /* Threshold for detection */
     acq->Dthresh = 2.0f * sigma_r * sqrtf(-logf(acq->Pacq_error1 / 5.0f));
@@ -160,10 +500,12 @@ int rade_acq_detect_pilots(rade_acq *acq, const RADE_COMP *rx, int *tmax, float
     return (Dtmax12 > acq->Dthresh) ? 1 : 0;
 }
 
-void rade_acq_refine(rade_acq *acq, const RADE_COMP *rx,
-                     int *tmax, float *fmax,
-                     int tfine_range_start, int tfine_range_end,
-                     float ffine_range_start, float ffine_range_end, float ffine_step) {
+/* Fine search with the rotators computed on the fly, used for grids too
+   wide for the power series (e.g. the +/- 10 Hz search on a candidate) */
+static void acq_refine_direct(rade_acq *acq, const RADE_COMP *rx,
+                              int *tmax, float *fmax,
+                              int tfine_range_start, int tfine_range_end,
+                              float ffine_range_start, float ffine_range_end, float ffine_step) {
     int M = acq->m;
     int Nmf = acq->nmf;
 
@@ -189,13 +531,8 @@ void rade_acq_refine(rade_acq *acq, const RADE_COMP *rx,
 
         for (int t = tfine_range_start; t < tfine_range_end; t++) {
             /* Correlate at this time/freq */
-            RADE_COMP Dt1 = rade_czero();
-            RADE_COMP Dt2 = rade_czero();
-
-            for (int n = 0; n < M; n++) {
-                Dt1 = rade_cadd(Dt1, rade_cmul(rx[t + n], w_vec1_p[n]));
-                Dt2 = rade_cadd(Dt2, rade_cmul(rx[t + Nmf + n], w_vec2_p[n]));
-            }
+            RADE_COMP Dt1 = acq->kern->cdot(&rx[t], w_vec1_p, M, 0);
+            RADE_COMP Dt2 = acq->kern->cdot(&rx[t + Nmf], w_vec2_p, M, 0);
 
             /* Combined metric: |Dt1 + Dt2| */
             RADE_COMP Dt_sum = rade_cadd(Dt1, Dt2);
@@ -213,49 +550,180 @@ void rade_acq_refine(rade_acq *acq, const RADE_COMP *rx,
     *fmax = f_best;
 }
 
-int rade_acq_check_pilots(rade_acq *acq, const RADE_COMP *rx,
-                          int tmax, float fmax,
-                          int *valid, int *endofover) {
+/* Fine search on a narrow grid of nf frequencies from ffine_range_start.
+   Relative to the grid centre fc the k-th frequency is kc = k - (nf-1)/2
+   steps away, and with nc = (M-1)/2 the correlation at the first pilot is
+
+     Dt1[t][k] = exp(-j*kc*dw*nc) * sum_m kc^m * S1_m[t]
+     S1_m[t]   = sum(rx[t+n] * exp(-j*wc*n) * refine_basis[m][n])
+
+   Dt2 is the same one modem frame later, rotated by exp(-j*w*Nmf).  The
+   leading phase is common to Dt1 and Dt2 so drops out of |Dt1 + Dt2|.
+   Truncation error is below phi^NTERMS/NTERMS! with phi the largest
+   kc*dw*(n-nc), about 1E-7 at RADE_ACQ_REFINE_MAXPHI */
+static void acq_refine_series(rade_acq *acq, const RADE_COMP *rx,
+                              int *tmax, float *fmax,
+                              int tfine_range_start, int tfine_range_end,
+                              float ffine_range_start, float ffine_step, int nf) {
     int M = acq->m;
-    int Ncp = acq->ncp;
     int Nmf = acq->nmf;
     float Fs = (float)acq->fs;
+    float nc = 0.5f * (M - 1);
 
-    /* Update 5% of the correlation grid for noise estimation */
-    int Nupdate = (int)(0.05f * Nmf);
-    for (int i = 0; i < Nupdate; i++) {
-        int t = rand() % Nmf;
+    if (acq->refine_step != ffine_step) {
+        float dw = 2.0f * M_PI * ffine_step / Fs;
+        for (int n = 0; n < M; n++) {
+            /* (-j*x)^m/m! by recurrence */
+            RADE_COMP b = rade_cconj(acq->p[n]);
+            RADE_COMP mjx = rade_cmplx(0.0f, -dw * (n - nc));
+            for (int m = 0; m < RADE_ACQ_REFINE_NTERMS; m++) {
+                acq->refine_basis[m][n] = b;
+                b = rade_cscale(rade_cmul(b, mjx), 1.0f / (m + 1));
+            }
+        }
+        acq->refine_step = ffine_step;
+    }
 
-        for (int f_idx = 0; f_idx < acq->n_fcoarse; f_idx++) {
-            RADE_COMP Dt1 = rade_czero();
-            RADE_COMP Dt2 = rade_czero();
+    /* Basis rotated to the grid centre, shared by every timing offset */
+    float kmid = 0.5f * (nf - 1);
+    float wc = 2.0f * M_PI * (ffine_range_start + kmid * ffine_step) / Fs;
+    RADE_COMP basis[RADE_ACQ_REFINE_NTERMS][RADE_M];
+    for (int n = 0; n < M; n++) {
+        RADE_COMP wc_vec = rade_cexp(-wc * n);
+        for (int m = 0; m < RADE_ACQ_REFINE_NTERMS; m++) {
+            basis[m][n] = rade_cmul(wc_vec, acq->refine_basis[m][n]);
+        }
+    }
 
-            for (int n = 0; n < M; n++) {
-                Dt1 = rade_cadd(Dt1, rade_cmul(rade_cconj(rx[t + n]), acq->p_w[n][f_idx]));
-                Dt2 = rade_cadd(Dt2, rade_cmul(rade_cconj(rx[t + Nmf + n]), acq->p_w[n][f_idx]));
+    /* Phase advance of the second pilot at the first frequency, and the
+       increment per frequency step */
+    float w0 = 2.0f * M_PI * ffine_range_start / Fs;
+    RADE_COMP ph_Nmf_0 = rade_cexp(-w0 * Nmf);
+    RADE_COMP ph_Nmf_step = rade_cexp(-2.0f * M_PI * ffine_step / Fs * Nmf);
+
+    float Dtmax = 0.0f;
+    int t_best = *tmax;
+    float f_best = *fmax;
+    int k_best = -1;
+
+    for (int t = tfine_range_start; t < tfine_range_end; t++) {
+        RADE_COMP ph_Nmf = ph_Nmf_0;
+        RADE_COMP S1[RADE_ACQ_REFINE_NTERMS];
+        RADE_COMP S2[RADE_ACQ_REFINE_NTERMS];
+        for (int m = 0; m < RADE_ACQ_REFINE_NTERMS; m++) {
+            S1[m] = acq->kern->cdot(&rx[t], basis[m], M, 0);
+            S2[m] = acq->kern->cdot(&rx[t + Nmf], basis[m], M, 0);
+        }
+
+        for (int k = 0; k < nf; k++) {
+            float kc = k - kmid;
+
+            /* Horner's rule in kc */
+            RADE_COMP Dt1 = S1[RADE_ACQ_REFINE_NTERMS - 1];
+            RADE_COMP Dt2 = S2[RADE_ACQ_REFINE_NTERMS - 1];
+            for (int m = RADE_ACQ_REFINE_NTERMS - 2; m >= 0; m--) {
+                Dt1 = rade_cadd(rade_cscale(Dt1, kc), S1[m]);
+                Dt2 = rade_cadd(rade_cscale(Dt2, kc), S2[m]);
             }
 
-            acq->Dt1[t][f_idx] = Dt1;
-            acq->Dt2[t][f_idx] = Dt2;
+            /* Combined metric: |Dt1 + Dt2|, ties go to the lowest frequency
+               then earliest time as in the frequency-major direct search */
+            float Dt = rade_cabs(rade_cadd(Dt1, rade_cmul(Dt2, ph_Nmf)));
+            ph_Nmf = rade_cmul(ph_Nmf, ph_Nmf_step);
+            if (Dt > Dtmax || (Dt == Dtmax && k < k_best)) {
+                Dtmax = Dt;
+                t_best = t;
+                k_best = k;
+            }
         }
     }
 
-    /* Recalculate noise statistics */
-    float sum_abs_Dt1 = 0.0f;
-    float sum_abs_Dt2 = 0.0f;
-    int count = 0;
+    if (k_best >= 0) {
+        f_best = ffine_range_start + k_best * ffine_step;
+    }
 
-    for (int t = 0; t < Nmf; t++) {
+    *tmax = t_best;
+    *fmax = f_best;
+}
+
+void rade_acq_refine(rade_acq *acq, const RADE_COMP *rx,
+                     int *tmax, float *fmax,
+                     int tfine_range_start, int tfine_range_end,
+                     float ffine_range_start, float ffine_range_end, float ffine_step) {
+    /* Number of grid points, counted the same way the direct search steps */
+    int nf = 0;
+    for (float f = ffine_range_start; f < ffine_range_end; f += ffine_step) {
+        nf++;
+    }
+
+    /* Largest rotator phase over the grid, relative to its centre */
+    float phi = 0.5f * (nf - 1) * 2.0f * M_PI * ffine_step / acq->fs * 0.5f * (acq->m - 1);
+
+    if (nf > 0 && phi <= RADE_ACQ_REFINE_MAXPHI) {
+        acq_refine_series(acq, rx, tmax, fmax, tfine_range_start, tfine_range_end,
+                          ffine_range_start, ffine_step, nf);
+    } else {
+        acq_refine_direct(acq, rx, tmax, fmax, tfine_range_start, tfine_range_end,
+                          ffine_range_start, ffine_range_end, ffine_step);
+    }
+}
+
+int rade_acq_check_pilots(rade_acq *acq, const RADE_COMP *rx,
+                          int tmax, float fmax,
+                          int *valid, int *endofover) {
+    int M = acq->m;
+    int Ncp = acq->ncp;
+    int Nmf = acq->nmf;
+    float Fs = (float)acq->fs;
+
+    /* Refresh n_refresh (5%) of the correlation grid rows for noise
+       estimation.  The noise floor sums are updated by the change in each
+       refreshed row, so we don't rescan the whole grid every frame */
+    int Nupdate = acq->n_refresh;
+    float Dt1_re[RADE_ACQ_NFREQ], Dt1_im[RADE_ACQ_NFREQ];
+    float Dt2_re[RADE_ACQ_NFREQ], Dt2_im[RADE_ACQ_NFREQ];
+
+    /* After a wide search the rows cover n_win windows.  We refresh them
+       over one, centred on fmax once it is outside the window around zero
+       (rx shifted down to it), and scale that up to stand in for them all */
+    int kc = 0;
+    if (acq->wide_bins > 0 &&
+        (fmax < acq->fcoarse_range[0] || fmax > acq->fcoarse_range[acq->n_fcoarse - 1])) {
+        kc = (int)lroundf(fmax * acq->nfft / Fs);
+    }
+    RADE_COMP rot[RADE_M];
+    RADE_COMP rx1[RADE_M], rx2[RADE_M];
+    for (int n = 0; n < M && kc != 0; n++) {
+        rot[n] = rade_cexp(-2.0f * M_PI * kc * n / acq->nfft);
+    }
+    float row_scale = (float)acq->n_win;
+
+    for (int i = 0; i < Nupdate; i++) {
+        int t = acq_rand(acq) % Nmf;
+        float row_abs_Dt1 = 0.0f;
+        float row_abs_Dt2 = 0.0f;
+
+        if (kc != 0) {
+            acq->kern->cvmul(rx1, &rx[t], rot, M, 0);
+            acq->kern->cvmul(rx2, &rx[t + Nmf], rot, M, 0);
+            acq_grid_row(acq, rx1, rx2, Dt1_re, Dt1_im, Dt2_re, Dt2_im);
+        } else {
+            acq_grid_row(acq, &rx[t], &rx[t + Nmf], Dt1_re, Dt1_im, Dt2_re, Dt2_im);
+        }
         for (int f_idx = 0; f_idx < acq->n_fcoarse; f_idx++) {
-            sum_abs_Dt1 += rade_cabs(acq->Dt1[t][f_idx]);
-            sum_abs_Dt2 += rade_cabs(acq->Dt2[t][f_idx]);
-            count++;
+            row_abs_Dt1 += rade_cabs(rade_cmplx(Dt1_re[f_idx], Dt1_im[f_idx]));
+            row_abs_Dt2 += rade_cabs(rade_cmplx(Dt2_re[f_idx], Dt2_im[f_idx]));
         }
+        row_abs_Dt1 *= row_scale;
+        row_abs_Dt2 *= row_scale;
+
+        acq->sum_abs_Dt1 += (double)row_abs_Dt1 - acq->row_abs_Dt1[t];
+        acq->sum_abs_Dt2 += (double)row_abs_Dt2 - acq->row_abs_Dt2[t];
+        acq->row_abs_Dt1[t] = row_abs_Dt1;
+        acq->row_abs_Dt2[t] = row_abs_Dt2;
     }
 
-    float sigma_r1 = (sum_abs_Dt1 / count) / sqrtf(M_PI / 2.0f);
-    float sigma_r2 = (sum_abs_Dt2 / count) / sqrtf(M_PI / 2.0f);
-    float sigma_r = (sigma_r1 + sigma_r2) / 2.0f;
+    float sigma_r = acq_sigma_r(acq);
 
     acq->Dthresh = 2.0f * sigma_r * sqrtf(-logf(acq->Pacq_error2 / 5.0f));
     float Dthresh_eoo = 2.0f * sigma_r * sqrtf(-logf(acq->Pacq_error1 / 5.0f));
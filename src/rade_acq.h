@@ -38,6 +38,9 @@
 
 #include "rade_dsp.h"
 #include "rade_ofdm.h"
+#include "rade_fft.h"
+#include "rade_kernels.h"
+#include "rade_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -47,6 +50,18 @@ extern "C" {
                            ACQUISITION STATE
 \*---------------------------------------------------------------------------*/
 
+/* Coarse search engines for rade_acq_detect_pilots() */
+#define RADE_ACQ_ENGINE_DIRECT  0       /* Brute force correlation at every t, f */
+#define RADE_ACQ_ENGINE_FFT     1       /* FFT cross-correlation, one IFFT per f */
+
+#define RADE_ACQ_NFFT_MAX       RADE_FFT_MAX_N
+#define RADE_ACQ_REFINE_NTERMS  6       /* Taylor terms for the fine search rotators */
+#define RADE_ACQ_REFINE_MAXPHI  0.2f    /* Largest rotator phase (rad) the expansion covers */
+#define RADE_ACQ_WIDE_NWIN      2       /* Windows searched in wide mode, including zero */
+#define RADE_ACQ_WIDE_NWIN_MAX  4
+#define RADE_ACQ_NREFRESH       (RADE_NMF / 20)     /* Grid rows check_pilots refreshes, 5% */
+#define RADE_ACQ_MAX_THREADS    RADE_POOL_MAX_THREADS
+
 typedef struct {
     /* Configuration */
     int fs;                                     /* Sample rate */
@@ -54,23 +69,66 @@ typedef struct {
     int ncp;                                    /* Cyclic prefix samples */
     int nmf;                                    /* Samples per modem frame */
 
-    /* Frequency search range */
-    float fcoarse_range[RADE_ACQ_NFREQ];       /* Frequency offsets to search */
+    /* The coarse search grid, pre-computed pilots and pilot spectrum depend
+       only on compile time constants, they point into the read only tables
+       generated at build time (rade_tables.h) */
+    const float *fcoarse_range;                 /* Frequency offsets to search */
     int n_fcoarse;                              /* Number of frequency steps */
 
-    /* Pre-computed frequency-shifted pilots: p_w[M][n_freq] */
-    RADE_COMP p_w[RADE_M][RADE_ACQ_NFREQ];
+    /* Pre-computed frequency-shifted pilots p_w[M][n_freq], split into
+       real and imag so the direct search runs across f with unit stride */
+    const float (*p_w_re)[RADE_ACQ_NFREQ];
+    const float (*p_w_im)[RADE_ACQ_NFREQ];
+
+    const rade_kernels *kern;                   /* SIMD kernels for this CPU */
 
     /* Pilot power for normalization */
     float sigma_p;
 
     /* Pilot reference (from OFDM) */
-    RADE_COMP p[RADE_M];                        /* Time-domain pilot */
-    RADE_COMP pend[RADE_M];                     /* EOO pilot */
-
-    /* Correlation grid (for threshold calculation) */
-    RADE_COMP Dt1[RADE_NMF][RADE_ACQ_NFREQ];   /* Correlation at first pilot */
-    RADE_COMP Dt2[RADE_NMF][RADE_ACQ_NFREQ];   /* Correlation at second pilot */
+    const RADE_COMP *p;                         /* Time-domain pilot */
+    const RADE_COMP *pend;                      /* EOO pilot */
+
+    /* Noise floor statistics.  The Dt1[t][f]/Dt2[t][f] correlation grid
+       (at the first pilot and one modem frame later) isn't stored, bar
+       by the threaded FFT search below.  The search streams through it
+       keeping the peak and these sums: |Dt1|, |Dt2| summed over f for
+       each row t, and the totals, so rade_acq_check_pilots() only pays
+       for the rows it refreshes */
+    float row_abs_Dt1[RADE_NMF];
+    float row_abs_Dt2[RADE_NMF];
+    double sum_abs_Dt1;
+    double sum_abs_Dt2;
+
+    /* FFT search engine: with N = Fs/fstep every coarse frequency offset is
+       a whole number of bins, so one pilot spectrum serves all offsets */
+    int engine;                                 /* RADE_ACQ_ENGINE_xxx in use */
+    int nfft;                                   /* FFT size N */
+    const int *k_fcoarse;                       /* Frequency offsets in FFT bins */
+    const rade_fft_state *fft;
+    const RADE_COMP *P_conj;                    /* conj(FFT(p)), zero padded to N */
+    RADE_COMP R[RADE_ACQ_NFFT_MAX];            /* FFT of rx buffer */
+    RADE_COMP X[RADE_ACQ_NFFT_MAX];            /* Scratch: cross spectrum */
+    RADE_COMP c[RADE_ACQ_NFFT_MAX];            /* Scratch: cross correlation */
+
+    /* Wide range search (rade_acq_set_range(), FFT engine only).  The
+       pilot search covers n_fcoarse bins around each of n_win window
+       centres: zero, then offsets nominated by a coarse stage that scores
+       every shift within +/- wide_bins by the rx energy falling in the
+       RADE band.  Without it there is one window, centred on zero */
+    int wide_bins;                              /* 0 = off */
+    int wide_nwin;                              /* windows to search when on */
+    int band_lo, band_hi;                       /* RADE band in FFT bins, inclusive */
+    int n_win;                                  /* windows searched last time */
+    int win_k[RADE_ACQ_WIDE_NWIN_MAX];          /* their centres, FFT bins */
+    float wide_score[RADE_ACQ_NFFT_MAX];        /* Scratch: band energy per shift */
+
+    /* Fine search rotators for rade_acq_refine().  Over a narrow grid the
+       rotator exp(-j*k*dw*(n-nc)) is expanded as a power series in k, and
+       refine_basis[m][n] = conj(p[n])*(-j*dw*(n-nc))^m/m!, dw = 2*pi*step/Fs.
+       Rebuilt only when the step changes */
+    float refine_step;                          /* Step cached (Hz), 0 if none */
+    RADE_COMP refine_basis[RADE_ACQ_REFINE_NTERMS][RADE_M];
 
     /* Detection thresholds and results */
     float Dthresh;
@@ -82,17 +140,59 @@ typedef struct {
     float Pacq_error1;
     float Pacq_error2;
 
+    /* Per-instance PRNG state for picking the grid rows refreshed in
+       rade_acq_check_pilots() (no shared rand() state) */
+    unsigned int rand_state;
+
+    /* Grid rows rade_acq_check_pilots() refreshes per call, 0 holds the
+       noise floor where it is */
+    int n_refresh;
+
+    /* Parallel coarse search (rade_acq_set_threads()), NULL pool when
+       single threaded.  Each worker has its own FFT scratch and peak.  The
+       FFT engine computes its columns on all workers into col_abs_Dt1/2
+       [f_idx][t], then each worker sums its rows in f order as the serial
+       search does, so the result is bit identical for any thread count */
+    rade_pool *pool;
+    struct rade_acq_worker *workers;
+    float *col_abs_Dt1;
+    float *col_abs_Dt2;
+
 } rade_acq;
 
 /*---------------------------------------------------------------------------*\
                            INITIALIZATION
 \*---------------------------------------------------------------------------*/
 
-/* Initialize acquisition state
+/* Initialize acquisition state, searching RADE_ACQ_FRANGE Hz in
+   RADE_ACQ_FSTEP Hz steps
    ofdm: pointer to OFDM state (for pilot symbols)
-   frange: frequency search range in Hz (e.g., 100)
-   fstep: frequency search step in Hz (e.g., 2.5) */
-void rade_acq_init(rade_acq *acq, const rade_ofdm *ofdm, float frange, float fstep);
+   engine: RADE_ACQ_ENGINE_DIRECT or RADE_ACQ_ENGINE_FFT.  The FFT engine
+           needs Fs/fstep to be an integer FFT size that covers the rx
+           buffer, otherwise we fall back to the direct engine (check
+           acq->engine after init) */
+void rade_acq_init(rade_acq *acq, const rade_ofdm *ofdm, int engine);
+
+/* Search frequency offsets up to +/- range_Hz, in nwin windows of
+   RADE_ACQ_FRANGE Hz (at most RADE_ACQ_WIDE_NWIN_MAX), so the cost grows
+   with nwin rather than the range.  The window around zero is always
+   searched, wide or not, and the others go where the coarse stage finds
+   the most energy in the RADE band.  range_Hz <= RADE_ACQ_FRANGE/2 or
+   nwin < 2 restores the single window search.  The range is limited to
+   keep the RADE band inside the FFT, and needs the FFT engine; with the
+   direct engine the call is ignored */
+void rade_acq_set_range(rade_acq *acq, float range_Hz, int nwin);
+
+/* Run the coarse search in rade_acq_detect_pilots() on n_threads threads,
+   the caller's included, at most RADE_ACQ_MAX_THREADS.  The extra threads
+   are started here and take this thread's scheduling and CPU affinity.
+   n_threads <= 1 stops them.  Returns the threads in use, 1 if they can't
+   be started */
+int rade_acq_set_threads(rade_acq *acq, int n_threads);
+
+/* Stops any search threads and frees their scratch; call before freeing
+   or re-initialising an acq that has used rade_acq_set_threads() */
+void rade_acq_close(rade_acq *acq);
 
 /*---------------------------------------------------------------------------*\
                            PILOT DETECTION
@@ -110,7 +210,10 @@ int rade_acq_detect_pilots(rade_acq *acq, const RADE_COMP *rx, int *tmax, float
    tmax: input/output timing estimate
    fmax: input/output frequency estimate
    tfine_range_start, tfine_range_end: timing search range
-   ffine_range_start, ffine_range_end, ffine_step: frequency search range */
+   ffine_range_start, ffine_range_end, ffine_step: frequency search range
+   Narrow grids (e.g. +/- 1 Hz in sync) use a cached power series for the
+   rotators, so each timing offset costs RADE_ACQ_REFINE_NTERMS correlations
+   per pilot rather than one per frequency */
 void rade_acq_refine(rade_acq *acq, const RADE_COMP *rx,
                      int *tmax, float *fmax,
                      int tfine_range_start, int tfine_range_end,
@@ -34,16 +34,54 @@
   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#define VERSION 2  /* Bump when API changes; version 2 = Python-free */
+#define VERSION 16 /* Bump when API changes; version 2 = Python-free, 3 = Rx/Tx only contexts,
+                      4 = stage timers, 5 = rade_rx_scan(), 6 = acquisition squelch,
+                      7 = warm re-acquire, 8 = int8 weights,
+                      9 = model_file weights blobs, 10 = rade_tx_stride(),
+                      11 = rade_prefault(), 12 = rade_set_acq_range(),
+                      13 = rade_trace_start()/rade_trace_write(),
+                      14 = rade_set_load_shed(), 15 = rade_snapshot()/rade_restore(),
+                      16 = rade_set_acq_threads() */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 #include "rade_api.h"
 #include "rade_tx.h"
 #include "rade_rx.h"
+#include "rade_trace.h"
+#include "rade_weights.h"
+#include "cpu_support.h"
+
+/* The rade_rx library is built with RADE_NO_TX and the rade_tx library with
+   RADE_NO_RX, each leaving out the other half's weights and code.  Only the
+   matching rade_open_*_only() and the functions for that half are defined */
+#if defined(RADE_NO_TX) && defined(RADE_NO_RX)
+#error "RADE_NO_TX and RADE_NO_RX are exclusive"
+#endif
+
+#ifdef RADE_NO_TX
+#define RADE_HAVE_TX 0
+#define RADE_BUILTIN_ENC_ARRAYS NULL
+#else
+#define RADE_HAVE_TX 1
+#define RADE_BUILTIN_ENC_ARRAYS radeenc_arrays
+#endif
+#ifdef RADE_NO_RX
+#define RADE_HAVE_RX 0
+#define RADE_BUILTIN_DEC_ARRAYS NULL
+#else
+#define RADE_HAVE_RX 1
+#define RADE_BUILTIN_DEC_ARRAYS radedec_arrays
+#endif
 
 /*---------------------------------------------------------------------------*\
                            RADE CONTEXT
@@ -53,30 +91,226 @@ struct rade {
     int flags;
     int auxdata;
     int bottleneck;
+    int arch;             /* CPU feature level from opus_select_arch() */
 
-    /* Transmitter state */
-    rade_tx_state tx;
+    const struct rade_models *models;   /* shared weights the layers read */
 
-    /* Receiver state */
-    rade_rx_state rx;
+    /* Transmitter state (NULL for Rx only contexts) */
+    rade_tx_state *tx;
+
+    /* Receiver state (NULL for Tx only contexts) */
+    rade_rx_state *rx;
 };
 
+/* Encoder and decoder layers initialised from one set of weight tables,
+   float and int8 (RADE_INT8_WEIGHTS).  In a build with the float tables
+   compiled out (RADE_INT8_WEIGHTS CMake option), or from an int8 only
+   blob, both are int8 */
+typedef struct rade_models {
+    RADEEnc enc, enc_int8;
+    RADEDec dec, dec_int8;
+    const WeightArray *enc_arrays;    /* tables they were initialised from, */
+    const WeightArray *dec_arrays;    /* for rade_prefault() */
+} rade_models;
+
+/* Built-in model weights.  Set up once by rade_initialize() then only read,
+   every context references these rather than holding its own copy */
+static rade_models rade_builtin_models;
+static int rade_builtin_models_ok = 0;
+
+/* Models loaded from weights blobs named by rade_open()'s model_file.  Each
+   file is mapped and parsed the first time a context asks for it, then
+   shared by every later context naming the same file.  Entries are keyed on
+   the file's inode, so a new blob renamed over the old one is picked up by
+   the next rade_open() while contexts already open keep the old mapping.
+   All are released by rade_finalize() */
+#define RADE_MAX_MODEL_FILES 8
+
+typedef struct {
+    dev_t             dev;
+    ino_t             ino;
+    rade_weights_blob blob;
+    rade_models       models;
+} rade_model_file;
+
+static rade_model_file *rade_model_files[RADE_MAX_MODEL_FILES];
+
+/* Files that failed to map or parse, so every rade_open() naming one isn't
+   another mmap and parse.  Size and mtime catch a file rewritten in place,
+   the oldest entry makes way for the next failure */
+typedef struct {
+    dev_t  dev;
+    ino_t  ino;
+    off_t  size;
+    time_t mtime;
+} rade_model_bad;
+
+static rade_model_bad rade_model_bad_files[RADE_MAX_MODEL_FILES];
+static int rade_model_n_bad = 0;
+static pthread_mutex_t rade_model_files_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*---------------------------------------------------------------------------*\
                         INITIALIZATION
 \*---------------------------------------------------------------------------*/
 
+/* Either half may be NULL (left uninitialised), for Rx or Tx only builds */
+static int rade_models_init(rade_models *m, const WeightArray *enc_arrays,
+                            const WeightArray *dec_arrays) {
+    /* rade_open() always runs with auxdata enabled */
+    int n_in = RADE_NUM_FEATURES_AUX * RADE_FRAMES_PER_STEP;
+    int ret = 0;
+
+    /* one half or the other is compiled out of Rx or Tx only builds */
+    (void)m;
+    (void)n_in;
+    (void)enc_arrays;
+    (void)dec_arrays;
+
+    m->enc_arrays = enc_arrays;
+    m->dec_arrays = dec_arrays;
+
+    /* The layers keep pointers to the table data, not to the filtered lists */
+#ifndef RADE_NO_TX
+    if (enc_arrays != NULL) {
+        WeightArray *enc_int8 = rade_weights_int8(enc_arrays);
+        if (enc_int8 == NULL ||
+            init_radeenc(&m->enc, enc_arrays, n_in) != 0 ||
+            init_radeenc(&m->enc_int8, enc_int8, n_in) != 0) {
+            ret = -1;
+        }
+        free(enc_int8);
+    }
+#endif
+#ifndef RADE_NO_RX
+    if (dec_arrays != NULL && ret == 0) {
+        WeightArray *dec_int8 = rade_weights_int8(dec_arrays);
+        if (dec_int8 == NULL ||
+            init_radedec(&m->dec, dec_arrays, n_in) != 0 ||
+            init_radedec(&m->dec_int8, dec_int8, n_in) != 0) {
+            ret = -1;
+        }
+        free(dec_int8);
+    }
+#endif
+    return ret;
+}
+
 void rade_initialize(void) {
-    /* No initialization needed without Python */
+    if (rade_builtin_models_ok) {
+        return;
+    }
+    if (rade_models_init(&rade_builtin_models, RADE_BUILTIN_ENC_ARRAYS,
+                         RADE_BUILTIN_DEC_ARRAYS) != 0) {
+        fprintf(stderr, "rade_initialize: failed to initialize built-in weights\n");
+        return;
+    }
+    rade_builtin_models_ok = 1;
 }
 
 void rade_finalize(void) {
-    /* No finalization needed without Python */
+    /* Built-in weights are static, only the mapped blobs are released */
+    pthread_mutex_lock(&rade_model_files_lock);
+    for (int i = 0; i < RADE_MAX_MODEL_FILES; i++) {
+        if (rade_model_files[i] != NULL) {
+            rade_weights_unmap(&rade_model_files[i]->blob);
+            free(rade_model_files[i]);
+            rade_model_files[i] = NULL;
+        }
+    }
+    rade_model_n_bad = 0;
+    pthread_mutex_unlock(&rade_model_files_lock);
 }
 
-struct rade *rade_open(char model_file[], int flags) {
+static int rade_model_is_bad(const struct stat *st) {
+    int n = (rade_model_n_bad < RADE_MAX_MODEL_FILES) ? rade_model_n_bad : RADE_MAX_MODEL_FILES;
+    for (int i = 0; i < n; i++) {
+        const rade_model_bad *b = &rade_model_bad_files[i];
+        if (b->dev == st->st_dev && b->ino == st->st_ino && b->size == st->st_size &&
+            b->mtime == st->st_mtime) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void rade_model_set_bad(const struct stat *st) {
+    rade_model_bad *b = &rade_model_bad_files[rade_model_n_bad++ % RADE_MAX_MODEL_FILES];
+    b->dev = st->st_dev;
+    b->ino = st->st_ino;
+    b->size = st->st_size;
+    b->mtime = st->st_mtime;
+}
+
+/* Models for the blob at path, mapping it on first use.  NULL if it can't
+   be loaded, the caller falls back to the built-in weights */
+static const rade_models *rade_model_file_get(const char *func, const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "%s: can't open model_file %s\n", func, path);
+        return NULL;
+    }
+
+    const rade_models *models = NULL;
+    pthread_mutex_lock(&rade_model_files_lock);
+    if (rade_model_is_bad(&st)) {
+        pthread_mutex_unlock(&rade_model_files_lock);
+        fprintf(stderr, "%s: %s failed to load before\n", func, path);
+        return NULL;
+    }
+
+    int slot = -1;
+    for (int i = 0; i < RADE_MAX_MODEL_FILES; i++) {
+        rade_model_file *mf = rade_model_files[i];
+        if (mf != NULL && mf->dev == st.st_dev && mf->ino == st.st_ino) {
+            models = &mf->models;
+            break;
+        }
+        if (mf == NULL && slot < 0) {
+            slot = i;
+        }
+    }
+
+    if (models == NULL) {
+        rade_model_file *mf = NULL;
+        if (slot < 0) {
+            fprintf(stderr, "%s: more than %d model files in use\n", func, RADE_MAX_MODEL_FILES);
+        } else if ((mf = (rade_model_file *)calloc(1, sizeof(rade_model_file))) == NULL) {
+            fprintf(stderr, "%s: failed to allocate memory\n", func);
+        } else if (rade_weights_map(&mf->blob, path) != 0) {
+            fprintf(stderr, "%s: %s is not a RADE weights blob\n", func, path);
+            rade_model_set_bad(&st);
+            free(mf);
+        } else if (rade_models_init(&mf->models,
+                                    RADE_HAVE_TX ? mf->blob.list : NULL,
+                                    RADE_HAVE_RX ? mf->blob.list : NULL) != 0) {
+            fprintf(stderr, "%s: %s doesn't match this model\n", func, path);
+            rade_model_set_bad(&st);
+            rade_weights_unmap(&mf->blob);
+            free(mf);
+        } else {
+            mf->dev = st.st_dev;
+            mf->ino = st.st_ino;
+            rade_model_files[slot] = mf;
+            models = &mf->models;
+        }
+    }
+
+    pthread_mutex_unlock(&rade_model_files_lock);
+    return models;
+}
+
+static struct rade *rade_open_common(const char *func, char model_file[], int flags,
+                                     int want_tx, int want_rx) {
+    if (!rade_builtin_models_ok) {
+        rade_initialize();
+        if (!rade_builtin_models_ok) {
+            return NULL;
+        }
+    }
+
     struct rade *r = (struct rade *)malloc(sizeof(struct rade));
     if (r == NULL) {
-        fprintf(stderr, "rade_open: failed to allocate memory\n");
+        fprintf(stderr, "%s: failed to allocate memory\n", func);
         return NULL;
     }
     memset(r, 0, sizeof(struct rade));
@@ -84,44 +318,125 @@ struct rade *rade_open(char model_file[], int flags) {
     r->flags = flags;
     r->auxdata = 1;
     r->bottleneck = 3;
-
-    /* Note: model_file is ignored in this implementation
-       Weights are compiled in via rade_enc_data.c and rade_dec_data.c */
-    fprintf(stderr, "rade_open: model_file=%s (ignored, using built-in weights)\n", model_file);
-
-    /* Initialize transmitter
-       RADE_USE_C_ENCODER flag is now always implicitly set */
-    int bpf_en = 0;  /* BPF disabled by default */
-    if (rade_tx_init(&r->tx, NULL, r->bottleneck, r->auxdata, bpf_en) != 0) {
-        fprintf(stderr, "rade_open: failed to initialize transmitter\n");
-        free(r);
-        return NULL;
+    r->arch = opus_select_arch();
+
+    /* model_file names a weights blob (see rade_weights_dump), NULL or ""
+       uses the weights compiled in via rade_enc_data.c and rade_dec_data.c.
+       Callers written when model_file was ignored pass a PyTorch .pth
+       checkpoint name, which quietly gets the built-in weights; only the
+       verbose message below says so */
+    const rade_models *models = NULL;
+    size_t len = (model_file != NULL) ? strlen(model_file) : 0;
+    if (len > 0 && !(len >= 4 && strcmp(model_file + len - 4, ".pth") == 0)) {
+        models = rade_model_file_get(func, model_file);
     }
-
-    /* Initialize receiver
-       RADE_USE_C_DECODER flag is now always implicitly set */
-    if (rade_rx_init(&r->rx, NULL, r->bottleneck, r->auxdata, 1) != 0) {
-        fprintf(stderr, "rade_open: failed to initialize receiver\n");
-        free(r);
-        return NULL;
+    if (!(flags & RADE_VERBOSE_0))
+        fprintf(stderr, "%s: using %s %s weights\n", func,
+                models ? model_file : "built-in",
+                (flags & RADE_INT8_WEIGHTS) ? "int8" : "float");
+    if (models == NULL) {
+        models = &rade_builtin_models;
     }
-
-    /* Set verbosity based on flags */
-    if (flags & RADE_VERBOSE_0) {
-        r->rx.verbose = 0;
+    r->models = models;
+
+
+#ifndef RADE_NO_TX
+    if (want_tx) {
+        /* Initialize transmitter
+           RADE_USE_C_ENCODER flag is now always implicitly set */
+        const RADEEnc *enc_model = (flags & RADE_INT8_WEIGHTS) ? &models->enc_int8 : &models->enc;
+        int bpf_en = 0;  /* BPF disabled by default */
+        r->tx = (rade_tx_state *)malloc(sizeof(rade_tx_state));
+        if (r->tx == NULL ||
+            rade_tx_init(r->tx, enc_model, r->bottleneck, r->auxdata, bpf_en) != 0) {
+            fprintf(stderr, "%s: failed to initialize transmitter\n", func);
+            rade_close(r);
+            return NULL;
+        }
+
+        /* Use the optimized dnn kernels for this CPU */
+        r->tx->arch = r->arch;
+
+        /* Reference direct DFT modulator */
+        if (flags & RADE_OFDM_DIRECT) {
+            rade_ofdm_init(&r->tx->ofdm, r->bottleneck, RADE_OFDM_ENGINE_DIRECT);
+        }
+    }
+#endif
+
+#ifndef RADE_NO_RX
+    if (want_rx) {
+        /* Initialize receiver
+           RADE_USE_C_DECODER flag is now always implicitly set */
+        const RADEDec *dec_model = (flags & RADE_INT8_WEIGHTS) ? &models->dec_int8 : &models->dec;
+        r->rx = (rade_rx_state *)malloc(sizeof(rade_rx_state));
+        if (r->rx == NULL ||
+            rade_rx_init(r->rx, dec_model, r->bottleneck, r->auxdata, 1) != 0) {
+            fprintf(stderr, "%s: failed to initialize receiver\n", func);
+            rade_close(r);
+            return NULL;
+        }
+
+        r->rx->arch = r->arch;
+
+        /* Reference brute force acquisition, e.g. for comparing against the
+           default FFT engine */
+        if (flags & RADE_ACQ_DIRECT) {
+            rade_acq_init(&r->rx->acq, &r->rx->ofdm, RADE_ACQ_ENGINE_DIRECT);
+        }
+
+        /* Reference direct DFT demodulator.  The pilots don't depend on the
+           engine, so the acquisition state set up above is still valid */
+        if (flags & RADE_OFDM_DIRECT) {
+            rade_ofdm_init(&r->rx->ofdm, r->bottleneck, RADE_OFDM_ENGINE_DIRECT);
+        }
+
+        /* Set verbosity based on flags */
+        if (flags & RADE_VERBOSE_0) {
+            r->rx->verbose = 0;
+        }
     }
+#endif
 
-    fprintf(stderr, "rade_open: n_features_in=%d Nmf=%d Neoo=%d n_eoo_bits=%d\n",
-            rade_tx_n_features_in(&r->tx),
-            rade_tx_n_samples_out(&r->tx),
-            rade_tx_n_eoo_out(&r->tx),
-            rade_tx_n_eoo_bits(&r->tx));
+    if (!(flags & RADE_VERBOSE_0))
+        fprintf(stderr, "%s: tx=%d rx=%d n_features_in=%d Nmf=%d Neoo=%d n_eoo_bits=%d arch=%d\n",
+                func, want_tx, want_rx,
+                rade_n_features_in_out(r),
+                RADE_NMF,
+                RADE_NEOO,
+                rade_n_eoo_bits(r),
+                r->arch);
 
     return r;
 }
 
+#if !defined(RADE_NO_TX) && !defined(RADE_NO_RX)
+struct rade *rade_open(char model_file[], int flags) {
+    return rade_open_common("rade_open", model_file, flags, 1, 1);
+}
+#endif
+
+#ifndef RADE_NO_RX
+struct rade *rade_open_rx_only(char model_file[], int flags) {
+    return rade_open_common("rade_open_rx_only", model_file, flags, 0, 1);
+}
+#endif
+
+#ifndef RADE_NO_TX
+struct rade *rade_open_tx_only(char model_file[], int flags) {
+    return rade_open_common("rade_open_tx_only", model_file, flags, 1, 0);
+}
+#endif
+
 void rade_close(struct rade *r) {
     if (r != NULL) {
+#ifndef RADE_NO_RX
+        if (r->rx != NULL) {
+            rade_acq_close(&r->rx->acq);
+        }
+#endif
+        free(r->tx);
+        free(r->rx);
         free(r);
     }
 }
@@ -134,71 +449,130 @@ int rade_version(void) {
     return VERSION;
 }
 
-int rade_n_tx_out(struct rade *r) {
+long rade_prefault(struct rade *r) {
     assert(r != NULL);
-    return rade_tx_n_samples_out(&r->tx);
+    int int8 = (r->flags & RADE_INT8_WEIGHTS) != 0;
+    long bytes = 0;
+    if (r->tx && r->models->enc_arrays) {
+        bytes += rade_weights_prefault(r->models->enc_arrays, int8);
+    }
+    if (r->rx && r->models->dec_arrays) {
+        bytes += rade_weights_prefault(r->models->dec_arrays, int8);
+    }
+    return bytes;
+}
+
+#ifndef RADE_NO_TX
+int rade_n_tx_out(struct rade *r) {
+    assert(r != NULL && r->tx != NULL);
+    return rade_tx_n_samples_out(r->tx);
 }
 
 int rade_n_tx_eoo_out(struct rade *r) {
-    assert(r != NULL);
-    return rade_tx_n_eoo_out(&r->tx);
+    assert(r != NULL && r->tx != NULL);
+    return rade_tx_n_eoo_out(r->tx);
 }
+#endif
 
+#ifndef RADE_NO_RX
 int rade_nin_max(struct rade *r) {
-    assert(r != NULL);
-    return rade_rx_nin_max(&r->rx);
+    assert(r != NULL && r->rx != NULL);
+    return rade_rx_nin_max(r->rx);
 }
 
 int rade_nin(struct rade *r) {
-    assert(r != NULL);
-    return rade_rx_nin(&r->rx);
+    assert(r != NULL && r->rx != NULL);
+    return rade_rx_nin(r->rx);
 }
+#endif
 
+/* Same for Tx and Rx, so works with Tx or Rx only contexts */
 int rade_n_features_in_out(struct rade *r) {
     assert(r != NULL);
-    return rade_tx_n_features_in(&r->tx);
+#ifndef RADE_NO_TX
+    if (r->tx != NULL) {
+        return rade_tx_n_features_in(r->tx);
+    }
+#endif
+#ifndef RADE_NO_RX
+    if (r->rx != NULL) {
+        return rade_rx_n_features_out(r->rx);
+    }
+#endif
+    return 0;
 }
 
 int rade_n_eoo_bits(struct rade *r) {
     assert(r != NULL);
-    return rade_tx_n_eoo_bits(&r->tx);
+#ifndef RADE_NO_TX
+    if (r->tx != NULL) {
+        return rade_tx_n_eoo_bits(r->tx);
+    }
+#endif
+#ifndef RADE_NO_RX
+    if (r->rx != NULL) {
+        return rade_rx_n_eoo_bits(r->rx);
+    }
+#endif
+    return 0;
 }
 
 /*---------------------------------------------------------------------------*\
                          TRANSMISSION
 \*---------------------------------------------------------------------------*/
 
+#ifndef RADE_NO_TX
+
 RADE_EXPORT void rade_tx_set_eoo_bits(struct rade *r, float eoo_bits[]) {
-    assert(r != NULL);
+    assert(r != NULL && r->tx != NULL);
     assert(eoo_bits != NULL);
-    rade_tx_state_set_eoo_bits(&r->tx, eoo_bits);
+    rade_tx_state_set_eoo_bits(r->tx, eoo_bits);
 }
 
 int rade_tx(struct rade *r, RADE_COMP tx_out[], float features_in[]) {
-    assert(r != NULL);
+    assert(r != NULL && r->tx != NULL);
     assert(features_in != NULL);
     assert(tx_out != NULL);
 
-    return rade_tx_process(&r->tx, tx_out, features_in);
+    return rade_tx_process(r->tx, tx_out, features_in);
+}
+
+int rade_n_features_in_stride(struct rade *r) {
+    assert(r != NULL && r->tx != NULL);
+    return rade_tx_n_features_stride();
+}
+
+int rade_tx_stride(struct rade *r, RADE_COMP tx_out[], float features_in[]) {
+    assert(r != NULL && r->tx != NULL);
+    assert(features_in != NULL);
+    assert(tx_out != NULL);
+
+    if (!rade_tx_encode_stride(r->tx, features_in)) {
+        return 0;
+    }
+    return rade_tx_mod(r->tx, tx_out);
 }
 
 int rade_tx_eoo(struct rade *r, RADE_COMP tx_eoo_out[]) {
-    assert(r != NULL);
+    assert(r != NULL && r->tx != NULL);
     assert(tx_eoo_out != NULL);
 
-    return rade_tx_state_eoo(&r->tx, tx_eoo_out);
+    return rade_tx_state_eoo(r->tx, tx_eoo_out);
 }
+#endif
 
 /*---------------------------------------------------------------------------*\
                          RECEPTION
 \*---------------------------------------------------------------------------*/
 
+#ifndef RADE_NO_RX
+
 int rade_rx(struct rade *r, float features_out[], int *has_eoo_out, float eoo_out[], RADE_COMP rx_in[]) {
-    assert(r != NULL);
+    assert(r != NULL && r->rx != NULL);
     assert(features_out != NULL);
     assert(rx_in != NULL);
 
-    int ret = rade_rx_process(&r->rx, features_out, eoo_out, rx_in);
+    int ret = rade_rx_process(r->rx, features_out, eoo_out, rx_in);
 
     int valid_out = ret & 0x1;
     int endofover = ret & 0x2;
@@ -206,28 +580,224 @@ int rade_rx(struct rade *r, float features_out[], int *has_eoo_out, float eoo_ou
     *has_eoo_out = endofover ? 1 : 0;
 
     if (valid_out) {
-        return rade_rx_n_features_out(&r->rx);
+        return rade_rx_n_features_out(r->rx);
     } else {
         return 0;
     }
 }
 
+int rade_rx_scan(struct rade *r, int *has_eoo_out, float eoo_out[], RADE_COMP rx_in[]) {
+    assert(r != NULL && r->rx != NULL);
+    assert(rx_in != NULL);
+
+    /* latents are discarded, the neural decoder never runs */
+    float z_hat[RADE_NZMF * RADE_LATENT_DIM];
+    int ret = rade_rx_demod(r->rx, z_hat, eoo_out, rx_in);
+
+    *has_eoo_out = (ret & 0x2) ? 1 : 0;
+    return ret & 0x1;
+}
+
+int rade_rx_batch(struct rade *r[], int n, float *features_out[], int n_features_out[],
+                  int has_eoo_out[], float *eoo_out[], RADE_COMP *rx_in[]) {
+    assert(r != NULL || n == 0);
+    int n_valid_total = 0;
+
+    for (int start = 0; start < n; start += RADE_DEC_BATCH_MAX) {
+        int nb = n - start;
+        if (nb > RADE_DEC_BATCH_MAX) nb = RADE_DEC_BATCH_MAX;
+
+        float z_hat[RADE_DEC_BATCH_MAX][RADE_NZMF * RADE_LATENT_DIM];
+        int valid_idx[RADE_DEC_BATCH_MAX];
+        int n_valid = 0;
+
+        /* Acquisition, tracking and OFDM demod, one channel at a time */
+        for (int i = 0; i < nb; i++) {
+            int k = start + i;
+            assert(r[k] != NULL && r[k]->rx != NULL);
+            assert(features_out[k] != NULL && rx_in[k] != NULL);
+
+            int ret = rade_rx_demod(r[k]->rx, z_hat[i], eoo_out[k], rx_in[k]);
+            has_eoo_out[k] = (ret & 0x2) ? 1 : 0;
+            n_features_out[k] = 0;
+            if (ret & 0x1) {
+                valid_idx[n_valid++] = i;
+            }
+        }
+
+        /* Neural decoder for all channels with valid latents, batched over
+           channels that share a model (normally all of them) */
+        int done[RADE_DEC_BATCH_MAX] = {0};
+        for (int v = 0; v < n_valid; v++) {
+            if (done[v]) continue;
+
+            rade_rx_state *rx[RADE_DEC_BATCH_MAX];
+            float *features[RADE_DEC_BATCH_MAX];
+            const float *z[RADE_DEC_BATCH_MAX];
+            int nd = 0;
+
+            const rade_rx_state *first = r[start + valid_idx[v]]->rx;
+            for (int w = v; w < n_valid; w++) {
+                int k = start + valid_idx[w];
+                if (done[w] || r[k]->rx->dec_model != first->dec_model ||
+                    r[k]->rx->arch != first->arch) {
+                    continue;
+                }
+                rx[nd] = r[k]->rx;
+                features[nd] = features_out[k];
+                z[nd] = z_hat[valid_idx[w]];
+                nd++;
+                done[w] = 1;
+                n_features_out[k] = rade_rx_n_features_out(r[k]->rx);
+            }
+
+            rade_rx_decode_batch(rx, nd, features, z);
+            n_valid_total += nd;
+        }
+    }
+
+    return n_valid_total;
+}
+
 int rade_sync(struct rade *r) {
-    assert(r != NULL);
-    return rade_rx_sync(&r->rx);
+    assert(r != NULL && r->rx != NULL);
+    return rade_rx_sync(r->rx);
 }
 
 float rade_freq_offset(struct rade *r) {
-    assert(r != NULL);
-    return rade_rx_freq_offset(&r->rx);
+    assert(r != NULL && r->rx != NULL);
+    return rade_rx_freq_offset(r->rx);
 }
 
 int rade_snrdB_3k_est(struct rade *r) {
-    assert(r != NULL);
-    return (int)rade_rx_snrdB_3k_est(&r->rx);
+    assert(r != NULL && r->rx != NULL);
+    return (int)rade_rx_snrdB_3k_est(r->rx);
 }
 
 void rade_set_disable_unsync(struct rade *r, float seconds) {
-    assert(r != NULL);
-    r->rx.disable_unsync = seconds;
+    assert(r != NULL && r->rx != NULL);
+    r->rx->disable_unsync = seconds;
+}
+
+void rade_set_acq_squelch(struct rade *r, float open_dB, int hang, int search_every) {
+    assert(r != NULL && r->rx != NULL);
+    rade_sql_config(&r->rx->sql, open_dB, hang, search_every);
+}
+
+int rade_acq_squelched(struct rade *r) {
+    assert(r != NULL && r->rx != NULL);
+    return r->rx->acq_squelched;
+}
+
+void rade_set_warm_reacquire(struct rade *r, float seconds) {
+    assert(r != NULL && r->rx != NULL);
+    rade_rx_set_warm(r->rx, seconds);
+}
+
+float rade_set_acq_range(struct rade *r, float max_offset_Hz) {
+    assert(r != NULL && r->rx != NULL);
+    rade_rx_set_acq_range(r->rx, max_offset_Hz);
+    return rade_rx_acq_range(r->rx);
+}
+
+void rade_set_load_shed(struct rade *r, int flags) {
+    assert(r != NULL && r->rx != NULL);
+    rade_rx_set_shed(r->rx, ((flags & RADE_SHED_THIN_SEARCH) ? RADE_RX_SHED_THIN_SEARCH : 0) |
+                            ((flags & RADE_SHED_NOISE_FREEZE) ? RADE_RX_SHED_NOISE_FREEZE : 0));
+}
+
+int rade_set_acq_threads(struct rade *r, int n_threads) {
+    assert(r != NULL && r->rx != NULL);
+    return rade_acq_set_threads(&r->rx->acq, n_threads);
+}
+
+int rade_snapshot_size(struct rade *r) {
+    assert(r != NULL && r->rx != NULL);
+    return (int)rade_rx_snapshot_size();
+}
+
+int rade_snapshot(struct rade *r, void *buf, int len) {
+    assert(r != NULL && r->rx != NULL && buf != NULL);
+    size_t n = rade_rx_snapshot(r->rx, buf, len > 0 ? (size_t)len : 0);
+    return n > 0 ? (int)n : -1;
+}
+
+int rade_restore(struct rade *r, const void *buf, int len) {
+    assert(r != NULL && r->rx != NULL && buf != NULL);
+    return rade_rx_restore(r->rx, buf, len > 0 ? (size_t)len : 0);
+}
+
+int rade_get_resync_stats(struct rade *r, struct rade_resync_stats *st) {
+    assert(r != NULL && st != NULL);
+    memset(st, 0, sizeof(*st));
+    if (r->rx == NULL) {
+        return -1;
+    }
+
+    const rade_rx_state *rx = r->rx;
+    float frame_s = (float)RADE_NMF / RADE_FS;
+    uint32_t count = __atomic_load_n(&rx->resync_count, __ATOMIC_RELAXED);
+    uint64_t sum = __atomic_load_n(&rx->resync_sum, __ATOMIC_RELAXED);
+
+    st->count = count;
+    st->warm = __atomic_load_n(&rx->resync_warm, __ATOMIC_RELAXED);
+    st->last_s = __atomic_load_n(&rx->resync_last, __ATOMIC_RELAXED) * frame_s;
+    st->max_s = __atomic_load_n(&rx->resync_max, __ATOMIC_RELAXED) * frame_s;
+    st->mean_s = count ? (float)sum / count * frame_s : 0.0f;
+    return 0;
+}
+#endif
+
+/*---------------------------------------------------------------------------*\
+                         STAGE TIMERS
+\*---------------------------------------------------------------------------*/
+
+static const char *rade_stage_names[RADE_NSTAGES] = {
+    "rx_bpf", "rx_acq", "rx_demod", "rx_decoder", "tx_encoder", "tx_mod"
+};
+
+const char *rade_stage_name(int stage) {
+    if (stage < 0 || stage >= RADE_NSTAGES) {
+        return NULL;
+    }
+    return rade_stage_names[stage];
+}
+
+int rade_get_stage_stats(struct rade *r, int stage, struct rade_stage_stats *st) {
+    assert(r != NULL && st != NULL);
+    const rade_hist *h = NULL;
+
+    switch (stage) {
+    case RADE_STAGE_RX_BPF:     h = r->rx ? &r->rx->hist_bpf : NULL; break;
+    case RADE_STAGE_RX_ACQ:     h = r->rx ? &r->rx->hist_acq : NULL; break;
+    case RADE_STAGE_RX_DEMOD:   h = r->rx ? &r->rx->hist_demod : NULL; break;
+    case RADE_STAGE_RX_DECODER: h = r->rx ? &r->rx->hist_decoder : NULL; break;
+    case RADE_STAGE_TX_ENCODER: h = r->tx ? &r->tx->hist_encoder : NULL; break;
+    case RADE_STAGE_TX_MOD:     h = r->tx ? &r->tx->hist_mod : NULL; break;
+    default: break;
+    }
+
+    if (h == NULL) {
+        memset(st, 0, sizeof(*st));
+        return -1;
+    }
+    rade_hist_read(h, st);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*\
+                         TRACING
+\*---------------------------------------------------------------------------*/
+
+void rade_set_trace(int events_per_thread) {
+    if (events_per_thread < 0) {
+        rade_trace_stop();
+    } else {
+        rade_trace_start(events_per_thread);
+    }
+}
+
+long rade_write_trace(const char *json_path) {
+    assert(json_path != NULL);
+    return rade_trace_write(json_path);
 }
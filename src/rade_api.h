@@ -76,21 +76,56 @@ extern "C" {
 #define RADE_USE_C_DECODER 0x2
 #define RADE_FOFF_TEST     0x4                // test mode used only by developers
 #define RADE_VERBOSE_0     0x8                // reduce verbosity to "quiet"
+#define RADE_ACQ_DIRECT    0x10               // brute force pilot acquisition (default is FFT)
+#define RADE_OFDM_DIRECT   0x20               // direct OFDM DFT/IDFT (default is FFT)
+#define RADE_INT8_WEIGHTS  0x40               // int8 quantised network weights (default is float)
 
 // Must be called BEFORE any other RADE functions as this
-// initializes internal library state.
+// initializes internal library state (the shared model weights).  Call it
+// from one thread before opening contexts on others; repeat calls are no-ops.
 RADE_EXPORT void rade_initialize(void);
 
-// Should be called when done with RADE.
+// Should be called when done with RADE, after every context is closed.
+// Unmaps the weights blobs loaded by rade_open().
 RADE_EXPORT void rade_finalize(void);
 
-// note single context only in this version, one context has one Tx, and one Rx
+// Contexts are independent and may be used from different threads (one
+// thread per context).  Model weights are shared read-only between contexts,
+// each context holds only its own DSP and GRU/conv state.  A context from
+// rade_open() has one Tx and one Rx.
+//
+// model_file is a weights blob written by rade_weights_dump, or NULL/"" for
+// the built-in weights.  A blob is memory mapped on first use and shared by
+// every context (and, through the page cache, every process) using it.  If it
+// can't be loaded, or doesn't match the model, a message is printed and the
+// built-in weights are used; a file that failed once isn't tried again until
+// it changes.  A name ending .pth (a PyTorch checkpoint, as callers from
+// before weights blobs pass) quietly selects the built-in weights.
 RADE_EXPORT struct rade *rade_open(char model_file[], int flags);
+
+// Rx only and Tx only contexts, these don't allocate the unused half.  Only
+// call the rade_rx*()/rade_tx*() functions that match the context type;
+// rade_n_features_in_out() and rade_n_eoo_bits() work with either.
+//
+// The rade_rx and rade_tx libraries are receive only and transmit only builds
+// of this API without the other half's weights.  rade_rx has
+// rade_open_rx_only() and the Rx functions, rade_tx has rade_open_tx_only()
+// and the Tx functions; rade_open() is only in the full rade library.
+RADE_EXPORT struct rade *rade_open_rx_only(char model_file[], int flags);
+RADE_EXPORT struct rade *rade_open_tx_only(char model_file[], int flags);
+
 RADE_EXPORT void rade_close(struct rade *r);
 
 // Allows API users to determine if the API has changed
 RADE_EXPORT int rade_version(void);
 
+// Reads every page of the weight tables this context's layers use, so a
+// real-time caller doesn't take page faults on them (e.g. on a blob just
+// mapped, or built-in tables not yet paged in from the binary) in its first
+// frames.  Call after rade_open*(), with mlockall() if they must also stay
+// resident.  Returns the number of bytes touched.
+RADE_EXPORT long rade_prefault(struct rade *r);
+
 // helpers to set up arrays
 RADE_EXPORT int rade_n_tx_out(struct rade *r);
 RADE_EXPORT int rade_n_tx_eoo_out(struct rade *r);
@@ -102,6 +137,16 @@ RADE_EXPORT int rade_n_eoo_bits(struct rade *r);
 // returns number of RADE_COMP samples written to tx_out[]
 RADE_EXPORT int rade_tx(struct rade *r, RADE_COMP tx_out[], float features_in[]);
 
+// Streaming alternative to rade_tx(): call once per encoder stride with
+// rade_n_features_in_stride() features as soon as they are extracted, so the
+// neural encoder runs every 40 ms rather than in a burst every modem frame.
+// Returns 0 until a modem frame is complete, then the number of RADE_COMP
+// samples written to tx_out[] (rade_n_tx_out()).  rade_tx() and
+// rade_tx_eoo() discard any partial frame, leaving the encoder as if its
+// strides had never been passed in.
+RADE_EXPORT int rade_n_features_in_stride(struct rade *r);
+RADE_EXPORT int rade_tx_stride(struct rade *r, RADE_COMP tx_out[], float features_in[]);
+
 // Set the rade_n_eoo_bits() bits to be sent in the EOO frame, which are
 // in +/- 1 float form (note NOT 1 or 0)
 RADE_EXPORT void rade_tx_set_eoo_bits(struct rade *r, float eoo_bits[]);
@@ -119,6 +164,25 @@ RADE_EXPORT int rade_nin(struct rade *r);
 // from QPSK symbols in ..IQIQI... order
 RADE_EXPORT int rade_rx(struct rade *r, float features_out[], int *has_eoo_out, float eoo_out[], RADE_COMP rx_in[]);
 
+// Batched rade_rx() over n independent Rx contexts, e.g. one per channel of
+// a wideband receiver.  Channel k reads rade_nin(r[k]) samples from rx_in[k];
+// features_out[k], has_eoo_out[k] and eoo_out[k] are as for rade_rx(), and
+// n_features_out[k] is set to rade_rx()'s return value.  The neural decoder
+// runs layer by layer across all channels with valid frames, so each layer's
+// weights are fetched once per batch instead of once per channel.  Output is
+// bit exact with calling rade_rx() on each context.  Returns the number of
+// channels with valid features_out[].
+RADE_EXPORT int rade_rx_batch(struct rade *r[], int n, float *features_out[], int n_features_out[],
+                              int has_eoo_out[], float *eoo_out[], RADE_COMP *rx_in[]);
+
+// rade_rx() without the neural decoder, for quickly indexing a recording:
+// runs acquisition, tracking and OFDM demod only and returns non-zero when
+// rade_rx() would have output valid features.  has_eoo_out/eoo_out are as
+// for rade_rx().  The decoder state isn't advanced and the unique word check
+// (which needs decoded features) is skipped, so a false sync is only dropped
+// by the pilot checks.  Don't mix with rade_rx() calls on one context.
+RADE_EXPORT int rade_rx_scan(struct rade *r, int *has_eoo_out, float eoo_out[], RADE_COMP rx_in[]);
+
 // returns non-zero if Rx is currently in sync
 RADE_EXPORT int rade_sync(struct rade *r);
 
@@ -131,6 +195,123 @@ RADE_EXPORT int rade_snrdB_3k_est(struct rade *r);
 // test mode: disable unsync after this many seconds (0 = disabled)
 RADE_EXPORT void rade_set_disable_unsync(struct rade *r, float seconds);
 
+// Energy squelch on acquisition, off by default.  While searching, each
+// frame is checked for flat power in the RADE band open_dB above its
+// noise-only level (relative to guard bands either side, so it is level
+// independent); frames without it skip the pilot search.  After a
+// detection the search runs for at least hang frames, and a squelched
+// receiver still searches every search_every frames (0 = never) for
+// signals too weak for the detector.  open_dB <= 0 disables.  Suggested:
+// 3.0 dB, hang 25 (3 s), search_every 10 (1.2 s).
+RADE_EXPORT void rade_set_acq_squelch(struct rade *r, float open_dB, int hang, int search_every);
+
+// returns non-zero if the squelch skipped the pilot search in the last rade_rx()
+RADE_EXPORT int rade_acq_squelched(struct rade *r);
+
+// Warm re-acquire, off by default (5 s is a good window).  When sync is
+// lost because the pilots faded out (not at an end of over or on UW
+// errors), the receiver also looks for the signal near its last timing
+// and frequency, alongside the usual full search, re-syncing on two
+// consecutive detections there that agree in timing and frequency.
+// After this many seconds only the full search is used.  0, the default,
+// disables
+RADE_EXPORT void rade_set_warm_reacquire(struct rade *r, float seconds);
+
+// Acquisition frequency range, +/- 50 Hz by default.  Wider ranges are
+// searched hierarchically: a coarse look at where the RADE band's energy
+// is picks one 100 Hz window besides the one around 0 Hz, and only those
+// two get the full pilot search, so the cost is about twice the default
+// at any range.  Limited to about +/- 700 Hz.  Widens the squelch band
+// and Rx BPF to match; call before the first rade_rx().  Returns the
+// range in use, Hz
+RADE_EXPORT float rade_set_acq_range(struct rade *r, float max_offset_Hz);
+
+// Load shedding for hosts that can't keep up, none by default.  Flags:
+// RADE_SHED_THIN_SEARCH runs the pilot search on every other frame while
+// searching (a signal takes up to 120 ms longer to find),
+// RADE_SHED_NOISE_FREEZE stops refreshing the noise floor estimate while
+// in sync.  Neither touches the demod or decoder once synced.  Safe to
+// change between rade_rx() calls, 0 restores full acquisition
+#define RADE_SHED_THIN_SEARCH   0x1
+#define RADE_SHED_NOISE_FREEZE  0x2
+RADE_EXPORT void rade_set_load_shed(struct rade *r, int flags);
+
+// Coarse acquisition on n_threads threads, 1 (the rade_rx() caller only)
+// by default.  The pilot search over timing and frequency is split across
+// a pool of workers started here, which sleep between searches; results
+// are bit identical to the single threaded search, only the time to find
+// a signal changes.  Workers take the scheduling and CPU affinity of the
+// thread calling this, so call it from one free to use several cores,
+// before the first rade_rx().  1 stops them.  Returns the threads in use,
+// at most 16
+RADE_EXPORT int rade_set_acq_threads(struct rade *r, int n_threads);
+
+// Receiver snapshots, for moving a live decode to another context (thread,
+// process or host) without a resync.  rade_snapshot() saves the receiver
+// between two rade_rx() calls: sync state, tracking, the receive window
+// and the decoder's recurrent state, about 36 kB and no weights.
+// rade_restore() loads one into an Rx context opened with the same flags
+// and acquisition range; fed the same input from there on it decodes bit
+// exact with the original, keeping its own squelch, warm re-acquire and
+// load shedding settings.  Both ends must be the same build on the same
+// architecture.  rade_snapshot() returns the bytes written, -1 if len is
+// less than rade_snapshot_size(); rade_restore() returns 0, or -1 with
+// the receiver unchanged if buf isn't a compatible snapshot
+RADE_EXPORT int rade_snapshot_size(struct rade *r);
+RADE_EXPORT int rade_snapshot(struct rade *r, void *buf, int len);
+RADE_EXPORT int rade_restore(struct rade *r, const void *buf, int len);
+
+// Time to re-sync after losing sync in a fade, since rade_open().  Sync
+// lost at an end of over or on UW errors is not counted
+struct rade_resync_stats {
+  unsigned int count;                         // number of re-syncs
+  unsigned int warm;                          // ... of which by the warm search
+  float last_s;                               // most recent, seconds
+  float mean_s;                               // mean, seconds
+  float max_s;                                // longest, seconds
+};
+
+// returns 0 and fills st, -1 if this context has no Rx half.  Safe to call
+// from another thread, like rade_get_stage_stats()
+RADE_EXPORT int rade_get_resync_stats(struct rade *r, struct rade_resync_stats *st);
+
+// Per-stage processing time, accumulated since rade_open().  Rx stages need
+// an Rx context and Tx stages a Tx context.  The timers are always on and
+// only ever written by the thread calling rade_rx()/rade_tx(), so reading
+// them from another thread (e.g. a GUI) is safe and never blocks the caller
+#define RADE_STAGE_RX_BPF      0              // Rx input bandpass filter
+#define RADE_STAGE_RX_ACQ      1              // pilot acquisition, refine and pilot check
+#define RADE_STAGE_RX_DEMOD    2              // frequency correction and OFDM demod
+#define RADE_STAGE_RX_DECODER  3              // neural decoder (rade_core_decoder)
+#define RADE_STAGE_TX_ENCODER  4              // neural encoder (rade_core_encoder)
+#define RADE_STAGE_TX_MOD      5              // OFDM mod and Tx bandpass filter
+#define RADE_NSTAGES           6
+
+struct rade_stage_stats {
+  unsigned int count;                         // number of times the stage ran
+  float p50_us;                               // median time, us
+  float p99_us;                               // 99th percentile time, us
+  float max_us;                               // longest time, us
+  float mean_us;                              // mean time, us
+};
+
+// returns 0 and fills st on success, -1 if the stage is unknown or this
+// context has no Rx (or Tx) half
+RADE_EXPORT int rade_get_stage_stats(struct rade *r, int stage, struct rade_stage_stats *st);
+
+// short name for a RADE_STAGE_xxx, e.g. "rx_acq", or NULL if out of range
+RADE_EXPORT const char *rade_stage_name(int stage);
+
+// Timeline tracing, off by default.  rade_set_trace(n) starts recording
+// begin/end times of the acquisition, OFDM demod, neural encoder/decoder
+// and Tx mod stages of every context, keeping the last n (0 = 65536) of
+// each thread; -1 stops.  rade_write_trace() writes what has been recorded
+// as Chrome trace JSON (chrome://tracing, ui.perfetto.dev) and returns the
+// number of events, or -1 if the file can't be written.  Safe to call
+// from any thread while tracing
+RADE_EXPORT void rade_set_trace(int events_per_thread);
+RADE_EXPORT long rade_write_trace(const char *json_path);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +34,7 @@
 */
 
 #include "rade_bpf.h"
+#include "rade_tables.h"
 #include <string.h>
 #include <assert.h>
 
@@ -42,13 +43,16 @@
 \*---------------------------------------------------------------------------*/
 
 void rade_bpf_init(rade_bpf *bpf, int ntap, float Fs_Hz, float bandwidth_Hz,
-                   float centre_freq_Hz, int max_len) {
+                   float centre_freq_Hz, int max_len, int mode) {
     assert(ntap <= RADE_BPF_NTAP);
     assert(ntap % 2 == 1);  /* ntap should be odd for symmetric filter */
+    assert(mode == RADE_BPF_DIRECT || mode == RADE_BPF_FFT);
 
     bpf->ntap = ntap;
+    bpf->mode = mode;
     bpf->alpha = 2.0f * M_PI * centre_freq_Hz / Fs_Hz;
     bpf->max_len = max_len;
+    bpf->kern = rade_kernels_get();
 
     /* Generate lowpass filter coefficients using sinc function
        Bandwidth B = bandwidth_Hz / Fs_Hz (normalized)
@@ -61,6 +65,17 @@ void rade_bpf_init(rade_bpf *bpf, int ntap, float Fs_Hz, float bandwidth_Hz,
         bpf->h[i] = B * rade_sinc(n * B);
     }
 
+    /* Overlap-save filter response, with the 1/N of the inverse FFT
+       folded in */
+    bpf->fft = &rade_fft_bpf;
+    if (mode == RADE_BPF_FFT) {
+        RADE_COMP h_pad[RADE_BPF_NFFT];
+        memset(h_pad, 0, sizeof(h_pad));
+        for (int i = 0; i < ntap; i++)
+            h_pad[i].real = bpf->h[i] / RADE_BPF_NFFT;
+        rade_fft(bpf->fft, bpf->H, h_pad);
+    }
+
     /* Initialize state */
     rade_bpf_reset(bpf);
 
@@ -70,50 +85,106 @@ void rade_bpf_init(rade_bpf *bpf, int ntap, float Fs_Hz, float bandwidth_Hz,
 
 void rade_bpf_reset(rade_bpf *bpf) {
     /* Clear filter memory */
-    memset(bpf->mem, 0, sizeof(RADE_COMP) * bpf->ntap);
+    memset(bpf->mem_re, 0, sizeof(bpf->mem_re));
+    memset(bpf->mem_im, 0, sizeof(bpf->mem_im));
+    memset(bpf->seg, 0, sizeof(bpf->seg));
 
     /* Reset mixer phase */
     bpf->phase = rade_cone();
 }
 
+void rade_bpf_get_state(const rade_bpf *bpf, RADE_COMP hist[], RADE_COMP *phase) {
+    int nh = bpf->ntap - 1;
+    if (bpf->mode == RADE_BPF_FFT) {
+        memcpy(hist, bpf->seg, (size_t)nh * sizeof(RADE_COMP));
+    } else {
+        rade_cjoin(hist, bpf->mem_re, bpf->mem_im, nh);
+    }
+    *phase = bpf->phase;
+}
+
+void rade_bpf_set_state(rade_bpf *bpf, const RADE_COMP hist[], RADE_COMP phase) {
+    int nh = bpf->ntap - 1;
+    if (bpf->mode == RADE_BPF_FFT) {
+        memcpy(bpf->seg, hist, (size_t)nh * sizeof(RADE_COMP));
+    } else {
+        rade_csplit(bpf->mem_re, bpf->mem_im, hist, nh);
+    }
+    bpf->phase = phase;
+}
+
 /*---------------------------------------------------------------------------*\
                               PROCESSING
 \*---------------------------------------------------------------------------*/
 
+/* Direct mode, nb <= RADE_BPF_BLOCK samples.  x is read in full before
+   y is written so the two may alias. */
+static void bpf_block_direct(rade_bpf *bpf, RADE_COMP *y, const RADE_COMP *x, int nb) {
+    int nh = bpf->ntap - 1;
+    float *re = bpf->mem_re;
+    float *im = bpf->mem_im;
+    RADE_COMP ph[RADE_BPF_BLOCK];
+    RADE_COMP x_bb[RADE_BPF_BLOCK];
+    float yr[RADE_BPF_BLOCK], yi[RADE_BPF_BLOCK];
+
+    /* Mix down to baseband: x_bb = x * exp(-j*alpha*(i+1)) */
+    bpf->kern->rotate(x_bb, ph, x, &bpf->phase, bpf->phase_inc, nb);
+    rade_csplit(&re[nh], &im[nh], x_bb, nb);
+
+    /* FIR filter, output i = sum(h[k] * x_bb[nh+i-k]).  h is symmetric
+       so h[k] and h[nh-k] fold into one multiply of the sample pair */
+    bpf->kern->fir_sym_split(yr, yi, re, im, bpf->h, bpf->ntap, nb);
+
+    /* Mix back up to centre frequency: y = y_bb * conj(phase) */
+    rade_cjoin(x_bb, yr, yi, nb);
+    bpf->kern->cvmul(y, x_bb, ph, nb, 1);
+
+    /* Keep the newest ntap-1 baseband samples as history */
+    memmove(re, &re[nb], (size_t)nh * sizeof(float));
+    memmove(im, &im[nb], (size_t)nh * sizeof(float));
+}
+
+/* FFT overlap-save, nb <= RADE_BPF_NFFT - (ntap-1) samples.  The segment
+   is history + block + zero pad; the circular wrap only reaches the first
+   ntap-1 outputs, which are discarded, so any block length works. */
+static void bpf_block_fft(rade_bpf *bpf, RADE_COMP *y, const RADE_COMP *x, int nb) {
+    int nh = bpf->ntap - 1;
+    RADE_COMP *seg = bpf->seg;
+    RADE_COMP *X = bpf->X;
+    RADE_COMP ph[RADE_BPF_NFFT];
+    RADE_COMP y_bb[RADE_BPF_NFFT];
+
+    /* Mix down to baseband after the history */
+    bpf->kern->rotate(&seg[nh], ph, x, &bpf->phase, bpf->phase_inc, nb);
+    memset(&seg[nh + nb], 0, (size_t)(RADE_BPF_NFFT - nh - nb) * sizeof(RADE_COMP));
+
+    rade_fft(bpf->fft, X, seg);
+    bpf->kern->cvmul(X, X, bpf->H, RADE_BPF_NFFT, 0);
+    rade_ifft(bpf->fft, y_bb, X);
+
+    bpf->kern->cvmul(y, &y_bb[nh], ph, nb, 1);
+
+    memmove(seg, &seg[nb], (size_t)nh * sizeof(RADE_COMP));
+}
+
 void rade_bpf_process(rade_bpf *bpf, RADE_COMP *y, const RADE_COMP *x, int n) {
     assert(n <= bpf->max_len);
 
-    int ntap = bpf->ntap;
-    RADE_COMP phase = bpf->phase;
-    RADE_COMP phase_inc = bpf->phase_inc;
-
-    /* Process each sample */
-    for (int i = 0; i < n; i++) {
-        /* Mix down to baseband: x_bb = x * exp(-j*alpha*(i+1)) */
-        phase = rade_cmul(phase, phase_inc);
-        RADE_COMP x_bb = rade_cmul(x[i], phase);
-
-        /* Shift filter memory and add new sample */
-        for (int j = ntap - 1; j > 0; j--) {
-            bpf->mem[j] = bpf->mem[j - 1];
-        }
-        bpf->mem[0] = x_bb;
-
-        /* FIR filter: y_bb = sum(h[k] * mem[k])
-           Since h is real and symmetric, we can optimize but keep simple for now */
-        RADE_COMP y_bb = rade_czero();
-        for (int k = 0; k < ntap; k++) {
-            y_bb.real += bpf->h[k] * bpf->mem[k].real;
-            y_bb.imag += bpf->h[k] * bpf->mem[k].imag;
-        }
-
-        /* Mix back up to centre frequency: y = y_bb * conj(phase) */
-        y[i] = rade_cmul(y_bb, rade_cconj(phase));
+    int block = (bpf->mode == RADE_BPF_FFT) ? RADE_BPF_NFFT - (bpf->ntap - 1)
+                                            : RADE_BPF_BLOCK;
+    while (n > 0) {
+        int nb = (n < block) ? n : block;
+        if (bpf->mode == RADE_BPF_FFT)
+            bpf_block_fft(bpf, y, x, nb);
+        else
+            bpf_block_direct(bpf, y, x, nb);
+        x += nb;
+        y += nb;
+        n -= nb;
     }
 
-    /* Save phase state for next call
-       Normalize to prevent drift */
-    float phase_mag = rade_cabs(phase);
-    bpf->phase.real = phase.real / phase_mag;
-    bpf->phase.imag = phase.imag / phase_mag;
+    /* Normalize phase to prevent drift */
+    float phase_mag = rade_cabs(bpf->phase);
+    bpf->phase.real = bpf->phase.real / phase_mag;
+    bpf->phase.imag = bpf->phase.imag / phase_mag;
 }
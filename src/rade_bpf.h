@@ -38,6 +38,8 @@
 #define __RADE_BPF__
 
 #include "rade_dsp.h"
+#include "rade_fft.h"
+#include "rade_kernels.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -47,13 +49,34 @@ extern "C" {
                               BPF STATE
 \*---------------------------------------------------------------------------*/
 
+#define RADE_BPF_DIRECT     0       /* folded time domain FIR */
+#define RADE_BPF_FFT        1       /* FFT overlap-save */
+
+#define RADE_BPF_BLOCK      256     /* direct mode samples per inner pass */
+#define RADE_BPF_NFFT       512     /* overlap-save transform length */
+
 typedef struct {
     int ntap;                               /* Number of filter taps */
+    int mode;                               /* RADE_BPF_DIRECT or RADE_BPF_FFT */
     float alpha;                            /* 2*pi*centre_freq/Fs (rad/sample) */
     float h[RADE_BPF_NTAP];                /* Filter coefficients (real, symmetric) */
-    RADE_COMP mem[RADE_BPF_NTAP];          /* Filter memory/state */
+
+    /* Direct mode: baseband history (ntap-1 samples) followed by the
+       current block, oldest first, split into real and imag so the
+       folded FIR loops are unit stride */
+    float mem_re[RADE_BPF_NTAP - 1 + RADE_BPF_BLOCK];
+    float mem_im[RADE_BPF_NTAP - 1 + RADE_BPF_BLOCK];
+
+    /* FFT mode: history + block in the time domain, and the filter
+       response scaled by 1/NFFT.  The plan is shared (rade_tables.h) */
+    const rade_fft_state *fft;
+    RADE_COMP H[RADE_BPF_NFFT];
+    RADE_COMP seg[RADE_BPF_NFFT];
+    RADE_COMP X[RADE_BPF_NFFT];
+
     RADE_COMP phase;                        /* Mixer phase state */
     RADE_COMP phase_inc;                    /* Phase increment per sample */
+    const rade_kernels *kern;               /* SIMD kernels for this CPU */
     int max_len;                            /* Maximum input length */
 } rade_bpf;
 
@@ -66,20 +89,30 @@ typedef struct {
    Fs_Hz: sample rate in Hz
    bandwidth_Hz: filter bandwidth in Hz
    centre_freq_Hz: centre frequency in Hz
-   max_len: maximum input block length */
+   max_len: maximum input block length
+   mode: RADE_BPF_DIRECT or RADE_BPF_FFT.  Both give the same output (to
+         float rounding).  FFT needs fewer multiplies on long blocks such as
+         the 960 sample Tx frames, but once the compiler vectorises the
+         direct loops (-O3) direct is faster at the block sizes RADE uses */
 void rade_bpf_init(rade_bpf *bpf, int ntap, float Fs_Hz, float bandwidth_Hz,
-                   float centre_freq_Hz, int max_len);
+                   float centre_freq_Hz, int max_len, int mode);
 
 /* Reset BPF state (clear memory and phase) */
 void rade_bpf_reset(rade_bpf *bpf);
 
+/* The filter state, for saving a receiver: the last ntap-1 baseband
+   samples, oldest first, and the mixer phase.  Setting it on a filter
+   initialised the same way carries on exactly where the other left off */
+void rade_bpf_get_state(const rade_bpf *bpf, RADE_COMP hist[], RADE_COMP *phase);
+void rade_bpf_set_state(rade_bpf *bpf, const RADE_COMP hist[], RADE_COMP phase);
+
 /*---------------------------------------------------------------------------*\
                               PROCESSING
 \*---------------------------------------------------------------------------*/
 
 /* Process samples through the BPF
    x: input samples (complex)
-   y: output samples (complex)
+   y: output samples (complex), may be the same buffer as x
    n: number of samples to process (must be <= max_len)
 
    The filter:
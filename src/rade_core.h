@@ -45,6 +45,12 @@ void rade_core_encoder(RADEEncState *enc_state, const RADEEnc *model, float *z,
 void rade_init_decoder(RADEDecState *dec_state);
 void rade_core_decoder(RADEDecState *dec_state, const RADEDec *model, float *features, const float *z_hat, int arch);
 
+/* Decode n streams sharing one model, layer by layer across the streams.
+   scratch[] is RADE_DEC_SCRATCH floats per stream (rade_dec.h) */
+#define RADE_DEC_BATCH_MAX 32
+void rade_core_decoder_batch(RADEDecState *dec_states[], const RADEDec *model, float *features[], const float *z_hat[],
+                             float *scratch[], int n, int arch);
+
 extern const WeightArray radeenc_arrays[];
 extern const WeightArray radedec_arrays[];
 
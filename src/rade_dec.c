@@ -29,6 +29,8 @@
 #include "config.h"
 #endif
 
+#include <assert.h>
+
 #include "rade_dec.h"
 #include "rade_constants.h"
 #include "os_support.h"
@@ -47,56 +49,81 @@ static void conv1_cond_init(float *mem, int len, int dilation, int *init)
     *init = 1;
 }
 
+static float *dec_gru_state(RADEDecState *dec_state, int stage)
+{
+    switch (stage) {
+        case 0:  return dec_state->gru1_state;
+        case 1:  return dec_state->gru2_state;
+        case 2:  return dec_state->gru3_state;
+        case 3:  return dec_state->gru4_state;
+        default: return dec_state->gru5_state;
+    }
+}
+
+static float *dec_conv_state(RADEDecState *dec_state, int stage)
+{
+    switch (stage) {
+        case 0:  return dec_state->conv1_state;
+        case 1:  return dec_state->conv2_state;
+        case 2:  return dec_state->conv3_state;
+        case 3:  return dec_state->conv4_state;
+        default: return dec_state->conv5_state;
+    }
+}
+
+/* Decode n independent streams, run layer by layer across the streams so
+   each layer's weights are fetched once per batch.  Each stream sees the
+   same sequence of kernel calls whatever n is, so the output is bit
+   exact with decoding it alone. */
+void rade_core_decoder_batch(
+    RADEDecState  *dec_states[],
+    const RADEDec *model,
+    float         *features[],      /* o: n x four concatenated feature vecs */
+    const float   *latents[],       /* i: n latent vectors */
+    float         *buffer[],        /* scratch: n x RADE_DEC_SCRATCH floats */
+    int n,
+    int arch
+    )
+{
+    const LinearLayer *gru_input[5] = {&model->dec_gru1_input, &model->dec_gru2_input, &model->dec_gru3_input,
+                                       &model->dec_gru4_input, &model->dec_gru5_input};
+    const LinearLayer *gru_recurrent[5] = {&model->dec_gru1_recurrent, &model->dec_gru2_recurrent, &model->dec_gru3_recurrent,
+                                           &model->dec_gru4_recurrent, &model->dec_gru5_recurrent};
+    const LinearLayer *glu[5] = {&model->dec_glu1, &model->dec_glu2, &model->dec_glu3, &model->dec_glu4, &model->dec_glu5};
+    const LinearLayer *conv[5] = {&model->dec_conv1, &model->dec_conv2, &model->dec_conv3, &model->dec_conv4, &model->dec_conv5};
+    const int gru_out_size[5] = {DEC_GRU1_OUT_SIZE, DEC_GRU2_OUT_SIZE, DEC_GRU3_OUT_SIZE, DEC_GRU4_OUT_SIZE, DEC_GRU5_OUT_SIZE};
+    const int conv_out_size[5] = {DEC_CONV1_OUT_SIZE, DEC_CONV2_OUT_SIZE, DEC_CONV3_OUT_SIZE, DEC_CONV4_OUT_SIZE, DEC_CONV5_OUT_SIZE};
+    int output_index;
+    int i, s;
+
+    assert(n >= 0 && n <= RADE_DEC_BATCH_MAX);
+
+    for (i=0;i<n;i++) compute_generic_dense(&model->dec_dense1, buffer[i], latents[i], ACTIVATION_TANH, arch);
+    output_index = DEC_DENSE1_OUT_SIZE;
+
+    for (s=0;s<5;s++) {
+        for (i=0;i<n;i++) compute_generic_gru(gru_input[s], gru_recurrent[s], dec_gru_state(dec_states[i], s), buffer[i], arch);
+        for (i=0;i<n;i++) compute_glu(glu[s], &buffer[i][output_index], dec_gru_state(dec_states[i], s), arch);
+        output_index += gru_out_size[s];
+        for (i=0;i<n;i++) {
+            conv1_cond_init(dec_conv_state(dec_states[i], s), output_index, 1, &dec_states[i]->initialized);
+            compute_generic_conv1d(conv[s], &buffer[i][output_index], dec_conv_state(dec_states[i], s), buffer[i], output_index, ACTIVATION_TANH, arch);
+        }
+        output_index += conv_out_size[s];
+    }
+
+    for (i=0;i<n;i++) compute_generic_dense(&model->dec_output, features[i], buffer[i], ACTIVATION_LINEAR, arch);
+}
+
 void rade_core_decoder(
-    RADEDecState  *dec_state,      
+    RADEDecState  *dec_state,
     const RADEDec *model,
-    float         *features,        /* i: four concatentated feature vecs */
+    float         *features,        /* o: four concatenated feature vecs */
     const float   *latents,         /* i: latent vector */
     int arch
     )
 {
-    float buffer[DEC_DENSE1_OUT_SIZE + DEC_GRU1_OUT_SIZE + DEC_GRU2_OUT_SIZE + DEC_GRU3_OUT_SIZE + DEC_GRU4_OUT_SIZE + DEC_GRU5_OUT_SIZE
-                 + DEC_CONV1_OUT_SIZE + DEC_CONV2_OUT_SIZE + DEC_CONV3_OUT_SIZE + DEC_CONV4_OUT_SIZE + DEC_CONV5_OUT_SIZE];
-    int output_index = 0;
-
-    /* run encoder stack and concatenate output in buffer*/
-    compute_generic_dense(&model->dec_dense1, &buffer[output_index], latents, ACTIVATION_TANH, arch);
-    output_index += DEC_DENSE1_OUT_SIZE;
-
-    compute_generic_gru(&model->dec_gru1_input, &model->dec_gru1_recurrent, dec_state->gru1_state, buffer, arch);
-    compute_glu(&model->dec_glu1, &buffer[output_index], dec_state->gru1_state, arch);
-    output_index += DEC_GRU1_OUT_SIZE;
-    conv1_cond_init(dec_state->conv1_state, output_index, 1, &dec_state->initialized);
-    compute_generic_conv1d(&model->dec_conv1, &buffer[output_index], dec_state->conv1_state, buffer, output_index, ACTIVATION_TANH, arch);
-    output_index += DEC_CONV1_OUT_SIZE;
-
-    compute_generic_gru(&model->dec_gru2_input, &model->dec_gru2_recurrent, dec_state->gru2_state, buffer, arch);
-    compute_glu(&model->dec_glu2, &buffer[output_index], dec_state->gru2_state, arch);
-    output_index += DEC_GRU2_OUT_SIZE;
-    conv1_cond_init(dec_state->conv2_state, output_index, 1, &dec_state->initialized);
-    compute_generic_conv1d(&model->dec_conv2, &buffer[output_index], dec_state->conv2_state, buffer, output_index, ACTIVATION_TANH, arch);
-    output_index += DEC_CONV2_OUT_SIZE;
-
-    compute_generic_gru(&model->dec_gru3_input, &model->dec_gru3_recurrent, dec_state->gru3_state, buffer, arch);
-    compute_glu(&model->dec_glu3, &buffer[output_index], dec_state->gru3_state, arch);
-    output_index += DEC_GRU3_OUT_SIZE;
-    conv1_cond_init(dec_state->conv3_state, output_index, 1, &dec_state->initialized);
-    compute_generic_conv1d(&model->dec_conv3, &buffer[output_index], dec_state->conv3_state, buffer, output_index, ACTIVATION_TANH, arch);
-    output_index += DEC_CONV3_OUT_SIZE;
-
-    compute_generic_gru(&model->dec_gru4_input, &model->dec_gru4_recurrent, dec_state->gru4_state, buffer, arch);
-    compute_glu(&model->dec_glu4, &buffer[output_index], dec_state->gru4_state, arch);
-    output_index += DEC_GRU4_OUT_SIZE;
-    conv1_cond_init(dec_state->conv4_state, output_index, 1, &dec_state->initialized);
-    compute_generic_conv1d(&model->dec_conv4, &buffer[output_index], dec_state->conv4_state, buffer, output_index, ACTIVATION_TANH, arch);
-    output_index += DEC_CONV4_OUT_SIZE;
-
-    compute_generic_gru(&model->dec_gru5_input, &model->dec_gru5_recurrent, dec_state->gru5_state, buffer, arch);
-    compute_glu(&model->dec_glu5, &buffer[output_index], dec_state->gru5_state, arch);
-    output_index += DEC_GRU5_OUT_SIZE;
-    conv1_cond_init(dec_state->conv5_state, output_index, 1, &dec_state->initialized);
-    compute_generic_conv1d(&model->dec_conv5, &buffer[output_index], dec_state->conv5_state, buffer, output_index, ACTIVATION_TANH, arch);
-    output_index += DEC_CONV5_OUT_SIZE;
-
-    compute_generic_dense(&model->dec_output, features, buffer, ACTIVATION_LINEAR, arch);
+    float buffer[RADE_DEC_SCRATCH];
+    float *scratch = buffer;
+    rade_core_decoder_batch(&dec_state, model, &features, &latents, &scratch, 1, arch);
 }
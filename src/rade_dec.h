@@ -31,6 +31,11 @@
 #include "rade_core.h"
 #include "rade_dec_data.h"
 
+/* Floats of scratch rade_core_decoder_batch() needs per stream, for the
+   concatenated layer outputs */
+#define RADE_DEC_SCRATCH (DEC_DENSE1_OUT_SIZE + DEC_GRU1_OUT_SIZE + DEC_GRU2_OUT_SIZE + DEC_GRU3_OUT_SIZE + DEC_GRU4_OUT_SIZE + DEC_GRU5_OUT_SIZE \
+                          + DEC_CONV1_OUT_SIZE + DEC_CONV2_OUT_SIZE + DEC_CONV3_OUT_SIZE + DEC_CONV4_OUT_SIZE + DEC_CONV5_OUT_SIZE)
+
 struct RADEDecStruct {
   int initialized;
   float gru1_state[DEC_GRU1_STATE_SIZE];
@@ -1,17 +1,19 @@
 #include "rade_decoder.h"
 #include "EooCallsignDecoder.hpp"
+#include "alloc_check.h"
 
 #include <cmath>
 #include <cstring>
-#include <complex>
 #include <vector>
 #include <algorithm>
-#include <mutex>
+#include <chrono>
+#include <thread>
 
 /* ── C headers from RADE / Opus (wrapped for C++ linkage) ────────────── */
 extern "C" {
 #include "rade_api.h"
 #include "rade_dsp.h"
+#include "rade_trace.h"
 #include "fargan.h"
 #include "lpcnet.h"
 }
@@ -20,241 +22,260 @@ extern "C" {
 #define M_PI 3.14159265358979323846
 #endif
 
+/* ── trace events, next to the library's (see rade_trace.h) ─────────── */
+
+static const int TR_AUDIO_READ   = rade_trace_register("audio_read");
+static const int TR_RESAMPLE_IN  = rade_trace_register("resample_in");
+static const int TR_HILBERT      = rade_trace_register("hilbert");
+static const int TR_RADE_RX      = rade_trace_register("rade_rx");
+static const int TR_FARGAN       = rade_trace_register("fargan_synthesize");
+static const int TR_RESAMPLE_OUT = rade_trace_register("resample_out");
+static const int TR_AUDIO_WRITE  = rade_trace_register("audio_write");
+
 /* ── construction / destruction ──────────────────────────────────────── */
 
 RadaeDecoder::RadaeDecoder()  = default;
 RadaeDecoder::~RadaeDecoder() { stop(); close(); }
 
-/* ── Hilbert coefficient initialisation (matches rade_demod.c) ───────── */
+/* ── telemetry ───────────────────────────────────────────────────────── */
 
-static void init_hilbert_coeffs(float coeffs[], int ntaps) {
-    int center = (ntaps - 1) / 2;
-    for (int i = 0; i < ntaps; i++) {
-        int n = i - center;
-        if (n == 0 || (n & 1) == 0) {
-            coeffs[i] = 0.0f;
-        } else {
-            float h = 2.0f / (static_cast<float>(M_PI) * n);
-            float w = 0.54f - 0.46f * std::cos(2.0f * static_cast<float>(M_PI) * i / (ntaps - 1));
-            coeffs[i] = h * w;
-        }
-    }
+void RadaeDecoder::get_spectrum(float* out, int n) const
+{
+    Telemetry t = telemetry_.read();
+    int count = std::min(n, SPECTRUM_BINS);
+    std::memcpy(out, t.spectrum, static_cast<size_t>(count) * sizeof(float));
 }
 
-/* ── WAV file I/O (adapted from rade_demod.c) ────────────────────────── */
-
-#define WAV_FMT_PCM   1
-#define WAV_FMT_FLOAT 3
+std::string RadaeDecoder::last_callsign() const
+{
+    Telemetry t = telemetry_.read();
+    return std::string(t.callsign);
+}
 
-struct wav_info {
-    int      sample_rate;
-    int      num_channels;
-    int      bits_per_sample;
-    bool     is_float;
-    long     data_offset;
-    uint32_t data_size;
-};
+/* snapshot of this frame's status for the readers, the spectrum and
+   callsign are already in tel_ */
+void RadaeDecoder::publish_telemetry(uint64_t mf)
+{
+    tel_.frame        = mf;
+    tel_.synced       = synced_.load(std::memory_order_relaxed);
+    tel_.snr_dB       = snr_dB_.load(std::memory_order_relaxed);
+    tel_.freq_offset  = freq_offset_.load(std::memory_order_relaxed);
+    tel_.input_level  = input_level_.load(std::memory_order_relaxed);
+    tel_.output_level = output_level_.load(std::memory_order_relaxed);
+
+    tel_.n_stages = std::min(n_stages(), static_cast<int>(Telemetry::MAX_STAGES));
+    for (int i = 0; i < tel_.n_stages; i++)
+        if (!stage_stats(i, &tel_.stages[i]))
+            tel_.stages[i] = rade_stage_stats{};
+
+    tel_.capture_overruns   = capture_overruns_.load(std::memory_order_relaxed);
+    tel_.playback_underruns = playback_underruns_.load(std::memory_order_relaxed);
+    if (!resync_stats(&tel_.resync))
+        tel_.resync = rade_resync_stats{};
+    rade_hist_read(&latency_hist_, &tel_.latency);
+
+    telemetry_.publish(tel_);
+}
 
-static bool wav_read_header(FILE* f, wav_info& info)
+/* only while the DSP thread is stopped */
+void RadaeDecoder::clear_telemetry()
 {
-    char     tag[4];
-    uint32_t riff_size;
+    tel_ = Telemetry{};
+    telemetry_.publish(tel_);
+}
 
-    if (std::fread(tag, 1, 4, f) != 4 || std::memcmp(tag, "RIFF", 4)) return false;
-    if (std::fread(&riff_size, 4, 1, f) != 1) return false;
-    if (std::fread(tag, 1, 4, f) != 4 || std::memcmp(tag, "WAVE", 4)) return false;
+/* ── stage timers ────────────────────────────────────────────────────── */
 
-    info.data_offset = -1;
+static const char* const kAppStageNames[] = {
+    "resample_in", "hilbert", "rade_rx", "fargan", "resample_out", "audio_write"
+};
+static const int kRadeRxStages[] = {
+    RADE_STAGE_RX_BPF, RADE_STAGE_RX_ACQ, RADE_STAGE_RX_DEMOD, RADE_STAGE_RX_DECODER
+};
+static constexpr int N_RADE_RX_STAGES = sizeof(kRadeRxStages) / sizeof(kRadeRxStages[0]);
 
-    while (true) {
-        char     chunk_id[4];
-        uint32_t chunk_size;
-        if (std::fread(chunk_id, 1, 4, f) != 4) break;
-        if (std::fread(&chunk_size, 4, 1, f) != 1) break;
+int RadaeDecoder::n_stages() const
+{
+    return N_APP_STAGES + N_RADE_RX_STAGES;
+}
 
-        if (std::memcmp(chunk_id, "fmt ", 4) == 0) {
-            if (chunk_size < 16) return false;
-            uint8_t buf[16];
-            if (std::fread(buf, 1, 16, f) != 16) return false;
+const char* RadaeDecoder::stage_name(int i) const
+{
+    if (i < 0 || i >= n_stages()) return nullptr;
+    if (i < N_APP_STAGES) return kAppStageNames[i];
+    return rade_stage_name(kRadeRxStages[i - N_APP_STAGES]);
+}
 
-            uint16_t audio_fmt, nch, bps;
-            uint32_t sr;
-            std::memcpy(&audio_fmt, buf + 0,  2);
-            std::memcpy(&nch,       buf + 2,  2);
-            std::memcpy(&sr,        buf + 4,  4);
-            std::memcpy(&bps,       buf + 14, 2);
+bool RadaeDecoder::stage_stats(int i, rade_stage_stats* st) const
+{
+    if (i < 0 || i >= n_stages()) return false;
+    if (i < N_APP_STAGES) {
+        rade_hist_read(&stage_hist_[i], st);
+        return true;
+    }
+    return rade_ && rade_get_stage_stats(rade_, kRadeRxStages[i - N_APP_STAGES], st) == 0;
+}
 
-            info.sample_rate     = static_cast<int>(sr);
-            info.num_channels    = static_cast<int>(nch);
-            info.bits_per_sample = static_cast<int>(bps);
-            info.is_float        = (audio_fmt == WAV_FMT_FLOAT);
+bool RadaeDecoder::resync_stats(rade_resync_stats* st) const
+{
+    return rade_ && rade_get_resync_stats(rade_, st) == 0;
+}
 
-            if (chunk_size > 16)
-                std::fseek(f, static_cast<long>(chunk_size - 16), SEEK_CUR);
+bool RadaeDecoder::latency_stats(rade_stage_stats* st) const
+{
+    rade_hist_read(&latency_hist_, st);
+    return st->count > 0;
+}
 
-        } else if (std::memcmp(chunk_id, "data", 4) == 0) {
-            info.data_offset = std::ftell(f);
-            info.data_size   = chunk_size;
-            break;
-        } else {
-            std::fseek(f, static_cast<long>((chunk_size + 1) & ~1u), SEEK_CUR);
-        }
-    }
-    return (info.data_offset >= 0);
-}
-
-static std::vector<float> wav_read_mono_float(FILE* f, const wav_info& info)
-{
-    int  bps  = info.bits_per_sample;
-    int  nch  = info.num_channels;
-    long total = static_cast<long>(info.data_size) / (bps / 8);
-    long mono  = total / nch;
-
-    std::vector<float> buf(static_cast<size_t>(mono));
-
-    for (long i = 0; i < mono; i++) {
-        float sum = 0.0f;
-        for (int ch = 0; ch < nch; ch++) {
-            float v = 0.0f;
-            if (info.is_float && bps == 32) {
-                float tmp; if (std::fread(&tmp, 4, 1, f) == 1) v = tmp;
-            } else if (info.is_float && bps == 64) {
-                double tmp; if (std::fread(&tmp, 8, 1, f) == 1) v = static_cast<float>(tmp);
-            } else if (bps == 16) {
-                int16_t tmp; if (std::fread(&tmp, 2, 1, f) == 1) v = tmp / 32768.0f;
-            } else if (bps == 24) {
-                uint8_t b[3]; if (std::fread(b, 1, 3, f) == 3) {
-                    int32_t raw = (static_cast<int32_t>(b[2]) << 16) | (b[1] << 8) | b[0];
-                    if (raw & 0x800000) raw |= static_cast<int32_t>(0xFF000000);
-                    v = raw / 8388608.0f;
-                }
-            } else if (bps == 32) {
-                int32_t tmp; if (std::fread(&tmp, 4, 1, f) == 1) v = tmp / 2147483648.0f;
-            } else {
-                return {};
-            }
-            sum += v;
-        }
-        buf[static_cast<size_t>(i)] = sum / nch;
-    }
-    return buf;
+float RadaeDecoder::input_delay_ms() const
+{
+    if (rate_in_ == 0) return 0.0f;
+    return static_cast<float>(in_dev_delay_.load(std::memory_order_relaxed)) * 1e3f
+         / static_cast<float>(rate_in_);
 }
 
-static std::vector<float> resample_batch(const std::vector<float>& in,
-                                         int in_rate, int out_rate)
+float RadaeDecoder::output_delay_ms() const
 {
-    if (in_rate == out_rate) return in;
+    if (rate_out_ == 0) return 0.0f;
+    return static_cast<float>(std::max(0L, out_dev_delay_.load(std::memory_order_relaxed))) * 1e3f
+         / static_cast<float>(rate_out_);
+}
 
-    auto n_in = static_cast<long>(in.size());
-    if (n_in < 2) return {};
+/* ── thread and memory policy ────────────────────────────────────────── */
 
-    long n_out = static_cast<long>(static_cast<double>(n_in) * out_rate / in_rate);
-    std::vector<float> out(static_cast<size_t>(n_out));
+void RadaeDecoder::set_acq_threads(int n)
+{
+    acq_threads_ = std::max(1, n);
+    if (rade_ && !running_) acq_threads_ = rade_set_acq_threads(rade_, acq_threads_);
+}
 
-    double step = static_cast<double>(in_rate) / static_cast<double>(out_rate);
-    for (long i = 0; i < n_out; i++) {
-        double pos  = i * step;
-        long   idx  = static_cast<long>(pos);
-        float  frac = static_cast<float>(pos - idx);
-        if (idx + 1 >= n_in) { idx = n_in - 2; frac = 1.0f; }
-        out[static_cast<size_t>(i)] = in[static_cast<size_t>(idx)]
-            + frac * (in[static_cast<size_t>(idx + 1)] - in[static_cast<size_t>(idx)]);
-    }
-    return out;
+void RadaeDecoder::set_warm_reacquire(float seconds)
+{
+    warm_s_ = std::max(0.0f, seconds);
+    if (rade_ && !running_) rade_set_warm_reacquire(rade_, warm_s_);
 }
 
-/* ── radix-2 Cooley-Tukey FFT (in-place, N must be power of 2) ────────── */
+/* the receiver options above, on each newly opened receiver */
+void RadaeDecoder::configure_rx(struct rade* r)
+{
+    if (acq_threads_ > 1) acq_threads_ = rade_set_acq_threads(r, acq_threads_);
+    if (warm_s_ > 0.0f)   rade_set_warm_reacquire(r, warm_s_);
+}
 
-static void fft_radix2(std::complex<float>* x, int N)
+void RadaeDecoder::apply_memory_policy()
 {
-    /* bit-reversal permutation */
-    for (int i = 1, j = 0; i < N; i++) {
-        int bit = N >> 1;
-        for (; j & bit; bit >>= 1) j ^= bit;
-        j ^= bit;
-        if (i < j) std::swap(x[i], x[j]);
-    }
-    /* butterfly passes */
-    for (int len = 2; len <= N; len <<= 1) {
-        float ang = -2.0f * static_cast<float>(M_PI) / len;
-        std::complex<float> wlen(std::cos(ang), std::sin(ang));
-        for (int i = 0; i < N; i += len) {
-            std::complex<float> w(1.0f, 0.0f);
-            for (int j = 0; j < len / 2; j++) {
-                auto u = x[i + j];
-                auto v = x[i + j + len / 2] * w;
-                x[i + j]             = u + v;
-                x[i + j + len / 2]   = u - v;
-                w *= wlen;
-            }
-        }
-    }
+    rt_denied_ = false;
+    if (rt_policy_.lock_memory && !rt_lock_memory())
+        rt_denied_ = true;
+    if (rade_ && (rt_policy_.lock_memory || rt_policy_.prefault))
+        rade_prefault(rade_);
 }
 
-/* ── get_spectrum (thread-safe read) ─────────────────────────────────── */
+/* first thing on each pipeline thread */
+void RadaeDecoder::apply_thread_policy(RtRole role, const char* name)
+{
+    if (!rt_apply_thread(rt_policy_, role, name))
+        rt_denied_ = true;
+}
 
-void RadaeDecoder::get_spectrum(float* out, int n) const
+/* ── open / close ────────────────────────────────────────────────────── */
+
+/* "shm:NAME" is a shared memory ring rather than an audio device */
+static bool shm_device(const std::string& id, std::string* name)
 {
-    std::lock_guard<std::mutex> lock(spectrum_mutex_);
-    int count = std::min(n, SPECTRUM_BINS);
-    std::memcpy(out, spectrum_mag_, static_cast<size_t>(count) * sizeof(float));
+    if (id.compare(0, 4, "shm:") != 0) return false;
+    *name = id.substr(4);
+    return true;
 }
 
-std::string RadaeDecoder::last_callsign() const
+/* Playback (mono, 16 kHz): a sound card, or a ring of S16 samples */
+bool RadaeDecoder::open_output(const std::string& output_hw_id)
 {
-    std::lock_guard<std::mutex> lock(callsign_mutex_);
-    return last_callsign_;
+    rate_out_ = RADE_FS_SPEECH;
+    std::string name;
+    if (shm_device(output_hw_id, &name)) {
+        if (rade_shm_create(&shm_out_, name.c_str(), RADE_SHM_S16, 1,
+                            RADE_FS_SPEECH, RADE_FS_SPEECH) != 0) {
+            std::fprintf(stderr, "RadaeDecoder: can't create shared memory ring %s\n", name.c_str());
+            return false;
+        }
+    } else if (!stream_out_.open(output_hw_id, false, 1, rate_out_, 512, AUDIO_F32)) {
+        return false;
+    }
+    resamp_out_.init(RADE_FS_SPEECH, rate_out_);
+    return true;
 }
 
-/* ── open / close ────────────────────────────────────────────────────── */
+/* rade_open() takes a non-const path, NULL for the built-in weights */
+char* RadaeDecoder::model_arg()
+{
+    return model_file_.empty() ? nullptr : &model_file_[0];
+}
 
 bool RadaeDecoder::open(const std::string& input_hw_id,
                         const std::string& output_hw_id)
 {
     close();
 
-    /* ── audio capture (mono, 8 kHz) ────────────────────────────────── */
-    rate_in_ = RADE_FS;
-    if (!stream_in_.open(input_hw_id, true, 1, rate_in_, 512))
+    /* ── audio capture (mono, 8 kHz), or a ring at the writer's rate ── */
+    std::string shm_name;
+    if (shm_device(input_hw_id, &shm_name)) {
+        if (rade_shm_attach(&shm_in_, shm_name.c_str()) != 0 || shm_in_.hdr->channels != 1) {
+            std::fprintf(stderr, "RadaeDecoder: no mono shared memory ring %s\n", shm_name.c_str());
+            rade_shm_close(&shm_in_);
+            return false;
+        }
+        rate_in_ = shm_in_.hdr->sample_rate;
+    } else {
+        rate_in_ = RADE_FS;
+        if (!stream_in_.open(input_hw_id, true, 1, rate_in_, 512, AUDIO_F32))
+            return false;
+    }
+    if (!resamp_in_.init(rate_in_, RADE_FS)) {
+        std::fprintf(stderr, "RadaeDecoder: can't resample %u Hz input\n", rate_in_);
+        stream_in_.close();
+        rade_shm_close(&shm_in_);
         return false;
+    }
 
-    /* ── audio playback (mono, 16 kHz) ───────────────────────────────── */
+    /* ── audio playback (mono, 16 kHz), none if only sending features ── */
     rate_out_ = RADE_FS_SPEECH;
-    if (!stream_out_.open(output_hw_id, false, 1, rate_out_, 512)) {
+    if ((!output_hw_id.empty() || sink_host_.empty()) && !open_output(output_hw_id)) {
         stream_in_.close();
+        rade_shm_close(&shm_in_);
         return false;
     }
 
     /* ── RADE receiver ──────────────────────────────────────────────── */
     rade_initialize();
-    rade_ = rade_open(nullptr, RADE_VERBOSE_0);
-    if (!rade_) {
-        stream_in_.close();
-        stream_out_.close();
+    rade_ = rade_open_rx_only(model_arg(), RADE_VERBOSE_0);
+    if (!rade_ || !open_feature_sink()) {
+        close();
         return false;
     }
+    configure_rx(rade_);
+    apply_memory_policy();
 
     /* ── FARGAN vocoder ─────────────────────────────────────────────── */
     fargan_ = new FARGANState;
     fargan_init(static_cast<FARGANState*>(fargan_));
     fargan_ready_ = false;
     warmup_count_ = 0;
+    fargan_snap_  = new FARGANState;
+    snap_valid_   = false;
 
     /* ── Hilbert coefficients ───────────────────────────────────────── */
-    init_hilbert_coeffs(hilbert_coeffs_, HILBERT_NTAPS);
-    std::memset(hilbert_hist_, 0, sizeof(hilbert_hist_));
-    hilbert_pos_ = 0;
-    std::memset(delay_buf_, 0, sizeof(delay_buf_));
-    delay_pos_ = 0;
+    rade_hilbert_init(&hilbert_);
+
+    for (auto& h : stage_hist_) rade_hist_init(&h);
+    rade_hist_init(&latency_hist_);
 
-    /* ── Resampler state ────────────────────────────────────────────── */
-    resamp_in_frac_ = 0.0;
-    resamp_in_prev_ = 0.0f;
+    /* ── Output resampler ───────────────────────────────────────── */
+    resamp_out_.init(RADE_FS_SPEECH, rate_out_);
 
-    /* ── Hanning window for FFT ─────────────────────────────────────── */
-    for (int i = 0; i < FFT_SIZE; i++)
-        fft_window_[i] = 0.5f * (1.0f - std::cos(2.0f * static_cast<float>(M_PI) * i / (FFT_SIZE - 1)));
-    std::memset(spectrum_mag_, 0, sizeof(spectrum_mag_));
+    /* ── Hann windowed spectrum of the input ────────────────────────── */
+    rade_spectrum_init(&spectrum_, FFT_SIZE);
+    clear_telemetry();
 
     return true;
 }
@@ -264,59 +285,51 @@ bool RadaeDecoder::open_file(const std::string& wav_path,
 {
     close();
 
-    /* ── Read and parse WAV file ────────────────────────────────── */
-    FILE* f = std::fopen(wav_path.c_str(), "rb");
-    if (!f) return false;
-
-    wav_info wav{};
-    if (!wav_read_header(f, wav)) {
-        std::fclose(f);
+    /* ── Parse the WAV header, the samples are streamed later ──── */
+    if (rade_wav_open(&file_, wav_path.c_str()) != 0) return false;
+    if (file_.frames == 0 ||
+        !resamp_in_.init(static_cast<unsigned int>(file_.sample_rate), RADE_FS)) {
+        rade_wav_close(&file_);
         return false;
     }
 
-    auto mono = wav_read_mono_float(f, wav);
-    std::fclose(f);
-    if (mono.empty()) return false;
-
-    /* ── Resample to 8 kHz ──────────────────────────────────────── */
-    if (wav.sample_rate != RADE_FS) {
-        file_audio_8k_ = resample_batch(mono, wav.sample_rate, RADE_FS);
-    } else {
-        file_audio_8k_ = std::move(mono);
-    }
-    if (file_audio_8k_.empty()) return false;
-    file_pos_ = 0;
-
     /* ── audio playback only (no capture) ─────────────────────────── */
-    rate_out_ = RADE_FS_SPEECH;
-    if (!stream_out_.open(output_hw_id, false, 1, rate_out_, 512))
+    if (!open_output(output_hw_id))
         return false;
 
     /* ── RADE receiver ──────────────────────────────────────────── */
     rade_initialize();
-    rade_ = rade_open(nullptr, RADE_VERBOSE_0);
-    if (!rade_) {
-        stream_out_.close();
+    rade_ = rade_open_rx_only(model_arg(), RADE_VERBOSE_0);
+    if (!rade_ || !open_feature_sink()) {
+        close();
         return false;
     }
+    configure_rx(rade_);
+    apply_memory_policy();
+
+    /* ── File buffers: one chunk of samples, and room for its 8 kHz
+          output on top of a partly used modem frame ─────────────── */
+    file_mono_.resize(FILE_CHUNK);
+    file_8k_.resize(static_cast<size_t>(rade_nin_max(rade_) + resamp_in_.max_output(FILE_CHUNK)));
+    file_8k_len_ = 0;
 
     /* ── FARGAN vocoder ─────────────────────────────────────────── */
     fargan_ = new FARGANState;
     fargan_init(static_cast<FARGANState*>(fargan_));
     fargan_ready_ = false;
     warmup_count_ = 0;
+    fargan_snap_  = new FARGANState;
+    snap_valid_   = false;
 
     /* ── Hilbert coefficients ───────────────────────────────────── */
-    init_hilbert_coeffs(hilbert_coeffs_, HILBERT_NTAPS);
-    std::memset(hilbert_hist_, 0, sizeof(hilbert_hist_));
-    hilbert_pos_ = 0;
-    std::memset(delay_buf_, 0, sizeof(delay_buf_));
-    delay_pos_ = 0;
+    rade_hilbert_init(&hilbert_);
 
-    /* ── Hanning window for FFT ─────────────────────────────────── */
-    for (int i = 0; i < FFT_SIZE; i++)
-        fft_window_[i] = 0.5f * (1.0f - std::cos(2.0f * static_cast<float>(M_PI) * i / (FFT_SIZE - 1)));
-    std::memset(spectrum_mag_, 0, sizeof(spectrum_mag_));
+    for (auto& h : stage_hist_) rade_hist_init(&h);
+    rade_hist_init(&latency_hist_);
+
+    /* ── Hann windowed spectrum of the input ────────────────────── */
+    rade_spectrum_init(&spectrum_, FFT_SIZE);
+    clear_telemetry();
 
     file_mode_ = true;
     rate_in_ = RADE_FS;
@@ -324,19 +337,72 @@ bool RadaeDecoder::open_file(const std::string& wav_path,
     return true;
 }
 
+/* Remote end of a split receiver: FARGAN and playback only, fed by the
+   feature stream instead of a capture device and rade_rx() */
+bool RadaeDecoder::open_remote(const std::string& listen_addr, int port,
+                               const std::string& output_hw_id)
+{
+    close();
+
+    if (!feat_rx_.open(listen_addr, port))
+        return false;
+
+    /* ── audio playback (mono, 16 kHz) ───────────────────────────── */
+    if (!open_output(output_hw_id)) {
+        feat_rx_.close();
+        return false;
+    }
+    apply_memory_policy();
+
+    /* ── FARGAN vocoder ─────────────────────────────────────────── */
+    fargan_ = new FARGANState;
+    fargan_init(static_cast<FARGANState*>(fargan_));
+    fargan_ready_ = false;
+    warmup_count_ = 0;
+    fargan_snap_  = new FARGANState;
+    snap_valid_   = false;
+
+    for (auto& h : stage_hist_) rade_hist_init(&h);
+    rade_hist_init(&latency_hist_);
+    clear_telemetry();
+
+    remote_mode_ = true;
+    return true;
+}
+
+bool RadaeDecoder::open_feature_sink()
+{
+    if (sink_host_.empty()) return true;
+    if (!feat_tx_.open(sink_host_, sink_port_, sink_enc_)) {
+        std::fprintf(stderr, "RadaeDecoder: can't send features to %s:%d\n",
+                     sink_host_.c_str(), sink_port_);
+        return false;
+    }
+    return true;
+}
+
 void RadaeDecoder::close()
 {
     stop();
 
     if (rade_) { rade_close(rade_); rade_ = nullptr; }
     if (fargan_) { delete static_cast<FARGANState*>(fargan_); fargan_ = nullptr; }
+    if (fargan_snap_) { delete static_cast<FARGANState*>(fargan_snap_); fargan_snap_ = nullptr; }
+    snap_valid_ = false;
 
     stream_in_.close();
     stream_out_.close();
-
-    file_audio_8k_.clear();
-    file_audio_8k_.shrink_to_fit();
-    file_pos_  = 0;
+    rade_shm_close(&shm_in_);
+    rade_shm_close(&shm_out_);
+    feat_tx_.close();
+    feat_rx_.close();
+    remote_mode_ = false;
+
+    rade_wav_close(&file_);
+    overs_.clear();
+    file_mono_.clear();  file_mono_.shrink_to_fit();
+    file_8k_.clear();    file_8k_.shrink_to_fit();
+    file_8k_len_ = 0;
     file_mode_ = false;
 
     synced_       = false;
@@ -345,110 +411,469 @@ void RadaeDecoder::close()
     input_level_  = 0.0f;
     output_level_ = 0.0f;
 
-    {
-        std::lock_guard<std::mutex> lk(callsign_mutex_);
-        last_callsign_.clear();
-    }
+    clear_telemetry();
 }
 
 /* ── start / stop ────────────────────────────────────────────────────── */
 
 void RadaeDecoder::start()
 {
-    if ((!stream_in_.is_open() && !file_mode_) || !stream_out_.is_open() || !rade_ || running_) return;
+    if (running_) return;
+    if (remote_mode_ ? !feat_rx_.is_open()
+                     : (!stream_in_.is_open() && !shm_in_.hdr && !file_mode_) || !rade_) return;
+    if (!stream_out_.is_open() && !shm_out_.hdr && !feat_tx_.is_open()) return;
+
+    /* ~1 s of audio each way; playback starts once one modem frame of
+       speech is buffered */
+    int frames_per_mf = remote_mode_ ? RADE_NZMF * RADE_FRAMES_PER_STEP
+                                     : rade_n_features_in_out(rade_) / RADE_NB_TOTAL_FEATURES;
+    in_ring_.reset(RADE_FS);
+    out_ring_.reset(rate_out_);
+    feat_ring_.reset(FEAT_RING_FRAMES);
+    lost_pending_ = false;
+    out_start_level_ = frames_per_mf * LPCNET_FRAME_SIZE * static_cast<int>(rate_out_) / RADE_FS_SPEECH;
+    capture_overruns_   = 0;
+    playback_underruns_ = 0;
+    in_dev_delay_       = 0;
+    out_dev_delay_      = 0;
+    latency_ms_         = 0.0f;
+    file_eof_           = false;
+    dsp_eof_            = false;
+
+    net_packets_        = 0;
+    net_lost_           = 0;
+    feat_rx_.reset();
+
+    iq_frames_ = 0;
+    if (!iq_path_.empty() && !remote_mode_ &&
+        rade_iq_create(&iq_, iq_path_.c_str(), rade_version(), RADE_VERBOSE_0,
+                       warm_s_, acq_threads_) != 0)
+        std::fprintf(stderr, "RadaeDecoder: can't create IQ capture %s\n", iq_path_.c_str());
+
     running_ = true;
-    thread_  = std::thread(&RadaeDecoder::processing_loop, this);
+    if (remote_mode_) {
+        thread_ = std::thread([this] { apply_thread_policy(RT_IO, "rade-rx-net"); network_loop(); });
+    } else {
+        if (!file_mode_)
+            capture_thread_ = std::thread([this] { apply_thread_policy(RT_IO,  "rade-rx-capture"); capture_loop(); });
+        thread_ = std::thread([this] { apply_thread_policy(RT_DSP, "rade-rx-dsp"); processing_loop(); });
+    }
+    if (stream_out_.is_open() || shm_out_.hdr)
+        synth_thread_    = std::thread([this] { apply_thread_policy(RT_DSP, "rade-rx-synth"); synth_loop(); });
+    if (stream_out_.is_open())
+        playback_thread_ = std::thread([this] { apply_thread_policy(RT_IO,  "rade-rx-play");  playback_loop(); });
 }
 
 void RadaeDecoder::stop()
 {
     running_ = false;
 
-    if (thread_.joinable()) thread_.join();
+    if (capture_thread_.joinable())  capture_thread_.join();
+    if (thread_.joinable())          thread_.join();
+    if (synth_thread_.joinable())    synth_thread_.join();
+    if (playback_thread_.joinable()) playback_thread_.join();
+
+    if (iq_.f && rade_iq_close(&iq_) != 0)
+        std::fprintf(stderr, "RadaeDecoder: IQ capture %s incomplete\n", iq_path_.c_str());
 
     input_level_  = 0.0f;
     output_level_ = 0.0f;
     synced_       = false;
 }
 
-/* ── streaming Hilbert transform ─────────────────────────────────────
+/* ── receiver snapshot ───────────────────────────────────────────────── */
+
+static const char     DEC_SNAP_MAGIC[8] = "RADEDEC";
+static const uint32_t DEC_SNAP_VERSION  = 1;
+
+/* FARGANState less model and arch, field by field: the weights are
+   pointers into this process and arch is the host's own */
+template <typename F>
+static void fargan_fields(FARGANState* st, F&& f)
+{
+    f(&st->cont_initialized, sizeof st->cont_initialized);
+    f(&st->deemph_mem,       sizeof st->deemph_mem);
+    f(st->pitch_buf,         sizeof st->pitch_buf);
+    f(st->cond_conv1_state,  sizeof st->cond_conv1_state);
+    f(st->fwc0_mem,          sizeof st->fwc0_mem);
+    f(st->gru1_state,        sizeof st->gru1_state);
+    f(st->gru2_state,        sizeof st->gru2_state);
+    f(st->gru3_state,        sizeof st->gru3_state);
+    f(&st->last_period,      sizeof st->last_period);
+}
+
+bool RadaeDecoder::save_state(std::vector<uint8_t>& out) const
+{
+    if (running_ || !rade_ || !fargan_) return false;
+
+    int n_rade = rade_snapshot_size(rade_);
+    std::vector<uint8_t> rx(static_cast<size_t>(n_rade));
+    if (rade_snapshot(rade_, rx.data(), n_rade) != n_rade) return false;
+
+    out.clear();
+    auto put = [&out](const void* p, size_t n) {
+        const uint8_t* b = static_cast<const uint8_t*>(p);
+        out.insert(out.end(), b, b + n);
+    };
+    uint32_t rx_bytes = static_cast<uint32_t>(n_rade);
+    put(DEC_SNAP_MAGIC, sizeof DEC_SNAP_MAGIC);
+    put(&DEC_SNAP_VERSION, sizeof DEC_SNAP_VERSION);
+    put(&rx_bytes, sizeof rx_bytes);
+    put(rx.data(), rx.size());
+    fargan_fields(static_cast<FARGANState*>(fargan_), put);
+    uint8_t ready = fargan_ready_ ? 1 : 0;
+    put(&ready, sizeof ready);
+    put(&warmup_count_, sizeof warmup_count_);
+    put(warmup_buf_, sizeof warmup_buf_);
+    put(hilbert_.x, (RADE_HILBERT_NTAPS - 1) * sizeof(float));
+    return true;
+}
+
+bool RadaeDecoder::restore_state(const std::vector<uint8_t>& in)
+{
+    if (running_ || !rade_ || !fargan_) return false;
+
+    size_t pos = 0;
+    auto get = [&in, &pos](void* p, size_t n) {
+        if (in.size() - pos < n) return false;
+        std::memcpy(p, in.data() + pos, n);
+        pos += n;
+        return true;
+    };
+    char     magic[sizeof DEC_SNAP_MAGIC];
+    uint32_t version = 0, rx_bytes = 0;
+    if (!get(magic, sizeof magic) || std::memcmp(magic, DEC_SNAP_MAGIC, sizeof magic) != 0 ||
+        !get(&version, sizeof version) || version != DEC_SNAP_VERSION ||
+        !get(&rx_bytes, sizeof rx_bytes) || in.size() - pos < rx_bytes)
+        return false;
+    size_t rx_pos = pos;
+    pos += rx_bytes;
+
+    /* everything else into temporaries first, so a short buffer or a
+       mismatched receiver leaves this decoder as it was */
+    FARGANState fargan = *static_cast<FARGANState*>(fargan_);
+    bool ok = true;
+    fargan_fields(&fargan, [&](void* p, size_t n) { ok = ok && get(p, n); });
+    uint8_t ready = 0;
+    int     count = 0;
+    float   warmup[sizeof warmup_buf_ / sizeof(float)];
+    float   hist[RADE_HILBERT_NTAPS - 1];
+    if (!ok || !get(&ready, sizeof ready) || !get(&count, sizeof count) ||
+        !get(warmup, sizeof warmup) || !get(hist, sizeof hist) ||
+        pos != in.size() || count < 0 || count > 5)
+        return false;
+    if (rade_restore(rade_, in.data() + rx_pos, static_cast<int>(rx_bytes)) != 0)
+        return false;
+
+    *static_cast<FARGANState*>(fargan_) = fargan;
+    fargan_ready_ = ready != 0;
+    warmup_count_ = count;
+    std::memcpy(warmup_buf_, warmup, sizeof warmup_buf_);
+    std::memcpy(hilbert_.x, hist, sizeof hist);
+    snap_valid_   = false;
+    clear_telemetry();
+    return true;
+}
+
+/* ── low latency mode tuning ─────────────────────────────────────────── */
+
+static constexpr int    LL_FLOOR_MS        = 10;    /* device queue kept before padding */
+static constexpr double FARGAN_RESUME_S    = 5.0;   /* longest drop resumed from a snapshot */
+static constexpr float  FARGAN_SNAP_SNR_DB = 2.0f;  /* only snapshot a decent signal */
+
+/* ── capture loop (dedicated thread) ─────────────────────────────────
  *
- *  For each input sample at 8 kHz, produce one RADE_COMP:
- *    .real = sample delayed by HILBERT_DELAY (63 samples)
- *    .imag = Hilbert-filtered sample
+ *  Reads the sound card, resamples to 8 kHz and pushes into in_ring_.
+ *  Never waits on the DSP thread: if the ring is full the block is
+ *  dropped and counted as an overrun.  A shared memory ring is resampled
+ *  where the writer left it, and its writer closing it ends the run.
  * ──────────────────────────────────────────────────────────────────── */
 
-static void hilbert_process(const float* in, RADE_COMP* out, int n,
-                            const float coeffs[], float hist[], int& pos,
-                            float delay[], int& dpos, int ntaps, int delay_n)
+void RadaeDecoder::capture_loop()
 {
-    for (int i = 0; i < n; i++) {
-        float sample = in[i];
+    /* capture read buffer (float mono, at rate_in_) */
+    constexpr int READ_FRAMES = 512;
+    std::vector<float> f_in(READ_FRAMES);
+
+    /* temporary buffer for resampled input */
+    int resamp_out_max = resamp_in_.max_output(READ_FRAMES);
+    std::vector<float> resamp_tmp(static_cast<size_t>(resamp_out_max));
 
-        /* store in history ring buffer */
-        hist[pos] = sample;
+    /* ALSA mmap: resample straight out of the device's DMA buffer */
+    bool in_place = stream_in_.capture_in_place();
+    bool shm      = shm_in_.hdr != nullptr;
+    bool shm_f32  = shm && shm_in_.hdr->format == RADE_SHM_F32;
 
-        /* FIR convolution for imaginary part */
-        float imag = 0.0f;
-        for (int k = 0; k < ntaps; k++) {
-            int idx = pos - k;
-            if (idx < 0) idx += ntaps;
-            imag += coeffs[k] * hist[idx];
+    alloc_check_begin();
+    while (running_.load(std::memory_order_relaxed)) {
+        const float*  in = f_in.data();
+        unsigned long n  = READ_FRAMES;
+        if (shm) {
+            int avail = rade_shm_read_wait(&shm_in_, READ_FRAMES, 100);
+            if (avail < 0) {
+                running_ = false;
+                break;
+            }
+            if (avail == 0)
+                continue;
+            const void* p = rade_shm_read_ptr(&shm_in_);
+            if (shm_f32) {
+                in = static_cast<const float*>(p);
+            } else {
+                const int16_t* s16 = static_cast<const int16_t*>(p);
+                for (int i = 0; i < READ_FRAMES; i++)
+                    f_in[static_cast<size_t>(i)] = s16[i] / 32768.0f;
+            }
+            in_dev_delay_.store(avail - READ_FRAMES, std::memory_order_relaxed);
+        } else {
+            uint64_t tt = rade_trace_begin();
+            AudioError err = in_place
+                ? stream_in_.capture_begin(reinterpret_cast<const void**>(&in), &n)
+                : stream_in_.read(f_in.data(), READ_FRAMES);
+            rade_trace_end(TR_AUDIO_READ, tt);
+            if (err == AUDIO_ERROR)
+                continue;
+            if (err == AUDIO_OVERFLOW)
+                capture_overruns_.fetch_add(1, std::memory_order_relaxed);
+            long dev_delay = stream_in_.delay_frames();
+            in_dev_delay_.store(dev_delay > 0 ? dev_delay : 0, std::memory_order_relaxed);
         }
 
-        /* delayed real part */
-        delay[dpos] = sample;
-        int read_pos = dpos - delay_n;
-        if (read_pos < 0) read_pos += ntaps;
-        out[i].real = delay[read_pos];
-        out[i].imag = imag;
+        /* resample to 8 kHz */
+        uint64_t t0 = rade_time_ns();
+        int got = resamp_in_.process(in, static_cast<int>(n),
+                                     resamp_tmp.data(), resamp_out_max);
+        uint64_t t1 = rade_time_ns();
+        rade_hist_add(&stage_hist_[ST_RESAMPLE_IN], t1 - t0);
+        rade_trace_span(TR_RESAMPLE_IN, t0, t1);
+        if (in_place)
+            stream_in_.capture_end(n);
+        else if (shm)
+            rade_shm_read_end(&shm_in_, READ_FRAMES);
+
+        if (in_ring_.write(resamp_tmp.data(), static_cast<size_t>(got))
+                < static_cast<size_t>(got))
+            capture_overruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    alloc_check_end("RadaeDecoder::capture_loop");
+}
 
-        pos = (pos + 1) % ntaps;
-        dpos = (dpos + 1) % ntaps;
+/* ── playback loop (dedicated thread) ────────────────────────────────
+ *
+ *  Keeps the sound card fed from out_ring_, padding with silence when
+ *  there is no decoded speech.  Playback of each over starts once
+ *  out_start_level_ samples are buffered, which absorbs the one modem
+ *  frame (120 ms) burst in which the DSP thread produces speech.
+ * ──────────────────────────────────────────────────────────────────── */
+
+void RadaeDecoder::playback_loop()
+{
+    constexpr int WRITE_FRAMES = 256;
+    float buf[WRITE_FRAMES];
+    bool  playing = false;
+
+    /* low latency mode starts on the first block rather than a whole
+       modem frame of speech */
+    size_t start_level = low_latency_ ? static_cast<size_t>(WRITE_FRAMES)
+                                      : static_cast<size_t>(out_start_level_);
+    long   floor       = static_cast<long>(LL_FLOOR_MS * rate_out_ / 1000);
+
+    alloc_check_begin();
+    while (running_.load(std::memory_order_relaxed)) {
+        bool   eof   = file_eof_.load(std::memory_order_acquire);
+        size_t avail = out_ring_.size();
+
+        if (eof && avail == 0) {
+            /* file mode: everything decoded has been played */
+            running_ = false;
+            break;
+        }
+        if (!playing && (avail >= start_level || eof))
+            playing = true;
+
+        /* low latency: ride out a short ring on what the device has queued,
+           only padding with silence when that is about to run out too */
+        if (playing && low_latency_ && !eof && avail < static_cast<size_t>(WRITE_FRAMES) &&
+            out_dev_delay_.load(std::memory_order_relaxed) > floor) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            out_dev_delay_.store(stream_out_.delay_frames(), std::memory_order_relaxed);
+            continue;
+        }
+
+        size_t n = 0;
+        if (playing) {
+            n = out_ring_.read(buf, WRITE_FRAMES);
+            if (n < static_cast<size_t>(WRITE_FRAMES)) {
+                /* ran dry: an underrun if we are still mid-over */
+                if (synced_.load(std::memory_order_relaxed) && !eof)
+                    playback_underruns_.fetch_add(1, std::memory_order_relaxed);
+                playing = false;
+            }
+        }
+        std::memset(buf + n, 0, (WRITE_FRAMES - n) * sizeof(float));
+
+        uint64_t t0 = rade_time_ns();
+        stream_out_.write(buf, WRITE_FRAMES);
+        uint64_t t1 = rade_time_ns();
+        rade_hist_add(&stage_hist_[ST_AUDIO_WRITE], t1 - t0);
+        rade_trace_span(TR_AUDIO_WRITE, t0, t1);
+        out_dev_delay_.store(stream_out_.delay_frames(), std::memory_order_relaxed);
     }
+    alloc_check_end("RadaeDecoder::playback_loop");
 }
 
-/* ── streaming linear-interpolation resampler ────────────────────────
+/* ── file reader (DSP thread) ────────────────────────────────────────
  *
- *  Converts from rate_in to rate_out.  Maintains fractional position
- *  across calls via frac and prev.
- *  Returns number of output samples written.
+ *  Fills out with n samples at 8 kHz, reading, converting and resampling
+ *  the WAV one FILE_CHUNK at a time so memory use doesn't depend on the
+ *  length of the recording.  Returns false once the file has fewer than
+ *  n samples left.
  * ──────────────────────────────────────────────────────────────────── */
 
-static int resample_linear_stream(const float* in, int n_in,
-                                  float* out, int max_out,
-                                  unsigned int rate_in, unsigned int rate_out,
-                                  double& frac, float& prev)
+bool RadaeDecoder::file_read_8k(float* out, int n)
 {
-    if (rate_in == rate_out) {
-        int n = std::min(n_in, max_out);
-        std::memcpy(out, in, static_cast<size_t>(n) * sizeof(float));
-        if (n_in > 0) prev = in[n_in - 1];
-        return n;
+    while (file_8k_len_ < static_cast<size_t>(n)) {
+        long got = rade_wav_read(&file_, file_mono_.data(), FILE_CHUNK);
+        if (got == 0) return false;
+
+        uint64_t t0 = rade_time_ns();
+        file_8k_len_ += static_cast<size_t>(
+            resamp_in_.process(file_mono_.data(), static_cast<int>(got), &file_8k_[file_8k_len_],
+                               static_cast<int>(file_8k_.size() - file_8k_len_)));
+        uint64_t t1 = rade_time_ns();
+        rade_hist_add(&stage_hist_[ST_RESAMPLE_IN], t1 - t0);
+        rade_trace_span(TR_RESAMPLE_IN, t0, t1);
     }
 
-    double step = static_cast<double>(rate_in) / static_cast<double>(rate_out);
-    int n_out = 0;
+    std::memcpy(out, file_8k_.data(), static_cast<size_t>(n) * sizeof(float));
+    file_8k_len_ -= static_cast<size_t>(n);
+    std::memmove(file_8k_.data(), &file_8k_[static_cast<size_t>(n)], file_8k_len_ * sizeof(float));
+    return true;
+}
+
+/* position the file reader at frame, discarding anything buffered */
+void RadaeDecoder::file_rewind(uint64_t frame)
+{
+    rade_wav_seek(&file_, frame);
+    file_8k_len_ = 0;
+    resamp_in_.reset();
+}
+
+/* ── file scan and seek ──────────────────────────────────────────────
+ *
+ *  The scan uses its own receiver through rade_rx_scan(), so the neural
+ *  decoder never runs, and isn't paced by playback.  An over is a run of
+ *  modem frames in sync; the unique word check needs decoded features
+ *  so is skipped, which can let a false sync run on until the pilot
+ *  checks drop it.
+ * ──────────────────────────────────────────────────────────────────── */
+
+double RadaeDecoder::file_duration() const
+{
+    return file_.sample_rate ? static_cast<double>(file_.frames) / file_.sample_rate : 0.0;
+}
+
+bool RadaeDecoder::scan_file(const ScanProgress& progress)
+{
+    overs_.clear();
+    if (!file_mode_ || running_) return false;
+
+    struct rade* r = rade_open_rx_only(model_arg(), RADE_VERBOSE_0);
+    if (!r) return false;
+    configure_rx(r);
+
+    int nin_max    = rade_nin_max(r);
+    int n_eoo_bits = rade_n_eoo_bits(r);
+    std::vector<float>     in_8k(static_cast<size_t>(nin_max));
+    std::vector<RADE_COMP> rx_buf(static_cast<size_t>(nin_max));
+    std::vector<float>     eoo_buf(static_cast<size_t>(n_eoo_bits));
+
+    rade_hilbert       hb;
+    EooCallsignDecoder eoo_decoder;
+    rade_hilbert_init(&hb);
+
+    file_rewind(0);
+    uint64_t pos     = 0;        // 8 kHz samples consumed
+    bool     in_over = false;
+    Over     cur;
+    double   snr_sum = 0.0;
+    int      snr_n   = 0;
 
-    while (n_out < max_out) {
-        int idx = static_cast<int>(frac);
-        if (idx >= n_in) break;
+    auto end_over = [&](double t) {
+        cur.end_s  = t;
+        cur.snr_dB = snr_n ? static_cast<float>(snr_sum / snr_n) : 0.0f;
+        overs_.push_back(cur);
+        in_over = false;
+    };
 
-        float f = static_cast<float>(frac - idx);
-        float s0 = (idx == 0) ? prev : in[idx - 1];
-        float s1 = in[idx];
-        out[n_out++] = s0 + f * (s1 - s0);
+    for (int nin = rade_nin(r); file_read_8k(in_8k.data(), nin); nin = rade_nin(r)) {
+        rade_hilbert_process(&hb, rx_buf.data(), in_8k.data(), nin);
 
-        frac += step;
+        int has_eoo = 0;
+        rade_rx_scan(r, &has_eoo, eoo_buf.data(), rx_buf.data());
+        pos += static_cast<uint64_t>(nin);
+        double t = static_cast<double>(pos) / RADE_FS;
+
+        if (rade_sync(r)) {
+            if (!in_over) {
+                cur         = Over();
+                cur.start_s = static_cast<double>(pos - static_cast<uint64_t>(nin)) / RADE_FS;
+                snr_sum     = 0.0;
+                snr_n       = 0;
+                in_over     = true;
+            }
+            snr_sum += rade_snrdB_3k_est(r);
+            snr_n++;
+        }
+        if (has_eoo && in_over) {
+            std::string callsign;
+            if (eoo_decoder.decode(eoo_buf.data(), n_eoo_bits / 2, callsign))
+                cur.callsign = callsign;
+        }
+        if (in_over && (has_eoo || !rade_sync(r)))
+            end_over(t);
+        if (progress && !progress(t)) {
+            overs_.clear();
+            rade_close(r);
+            file_rewind(0);
+            return false;
+        }
     }
+    if (in_over) end_over(static_cast<double>(pos) / RADE_FS);
+
+    rade_close(r);
+    file_rewind(0);
+    return true;
+}
 
-    /* save last sample for next block interpolation */
-    if (n_in > 0) prev = in[n_in - 1];
+bool RadaeDecoder::seek(double seconds)
+{
+    if (!file_mode_ || !stream_out_.is_open()) return false;
+    stop();
+
+    /* a fresh receiver and vocoder, as if the file started here */
+    if (rade_) rade_close(rade_);
+    rade_ = rade_open_rx_only(model_arg(), RADE_VERBOSE_0);
+    if (!rade_) return false;
+    configure_rx(rade_);
+    fargan_init(static_cast<FARGANState*>(fargan_));
+    fargan_ready_ = false;
+    warmup_count_ = 0;
+    snap_valid_   = false;
+    rade_hilbert_init(&hilbert_);
+    clear_telemetry();
 
-    /* adjust frac so it's relative to the next block */
-    frac -= n_in;
+    file_rewind(static_cast<uint64_t>(std::max(0.0, seconds) * file_.sample_rate));
+    start();
+    return true;
+}
 
-    return n_out;
+bool RadaeDecoder::seek_over(size_t i)
+{
+    /* acquisition takes a few modem frames, start a second early */
+    constexpr double PREROLL_S = 1.0;
+    if (i >= overs_.size()) return false;
+    return seek(overs_[i].start_s - PREROLL_S);
 }
 
 /* ── processing loop (dedicated thread) ──────────────────────────────── */
@@ -462,98 +887,69 @@ void RadaeDecoder::processing_loop()
     EooCallsignDecoder eoo_decoder;
 
     /* allocate working buffers */
+    std::vector<float>     in_8k(static_cast<size_t>(nin_max));
     std::vector<RADE_COMP> rx_buf(static_cast<size_t>(nin_max));
     std::vector<float>     feat_buf(static_cast<size_t>(n_features_out));
     std::vector<float>     eoo_buf(static_cast<size_t>(n_eoo_bits));
 
-    /* accumulation buffer for 8 kHz mono float samples */
-    std::vector<float> acc_8k;
-    acc_8k.reserve(static_cast<size_t>(nin_max * 2));
-
-    /* capture read buffer (S16 mono, at rate_in_) */
-    constexpr int READ_FRAMES = 512;
-    std::vector<int16_t> capture_buf(READ_FRAMES);
-
-    /* temporary buffer for resampled input */
-    int resamp_out_max = READ_FRAMES + 2;
-    std::vector<float> resamp_tmp(static_cast<size_t>(resamp_out_max));
+    /* most recent FFT_SIZE input samples, for the spectrum display */
+    std::vector<float> spec_hist(FFT_SIZE, 0.0f);
 
-    /* output resample state (16 kHz → rate_out_) */
-    double resamp_out_frac = 0.0;
-    float  resamp_out_prev = 0.0f;
+    bool     was_synced = false;
+    uint64_t mf         = 0;   /* modem frames processed */
+    size_t   n_frames_max = static_cast<size_t>(n_features_out / RADE_NB_TOTAL_FEATURES);
+    FeaturePacket pkt;         /* feature stream, if sending */
 
-    bool was_synced = false;
-    bool output_primed = false;
+    governor_.reset();
+    rade_set_load_shed(rade_, 0);
+    tel_.shed_level = LoadGovernor::NORMAL;
 
+    alloc_check_begin();
     while (running_.load(std::memory_order_relaxed)) {
 
         int nin = rade_nin(rade_);
-
-        /* ── accumulate enough 8 kHz samples ─────────────────────────── */
-        while (static_cast<int>(acc_8k.size()) < nin &&
-               running_.load(std::memory_order_relaxed))
-        {
-            if (file_mode_) {
-                /* ── file mode: copy from pre-loaded buffer ───────── */
-                size_t remaining = file_audio_8k_.size() - file_pos_;
-                if (remaining == 0) {
-                    running_ = false;
-                    break;
-                }
-                size_t need  = static_cast<size_t>(nin) - acc_8k.size();
-                size_t chunk = std::min(need, remaining);
-                acc_8k.insert(acc_8k.end(),
-                              file_audio_8k_.begin() + static_cast<ptrdiff_t>(file_pos_),
-                              file_audio_8k_.begin() + static_cast<ptrdiff_t>(file_pos_ + chunk));
-                file_pos_ += chunk;
-            } else {
-                /* ── live mode: read from audio capture ──────────────── */
-                AudioError err = stream_in_.read(capture_buf.data(), READ_FRAMES);
-                if (err == AUDIO_ERROR) {
-                    if (!running_.load(std::memory_order_relaxed)) break;
-                    continue;
-                }
-
-                int n = READ_FRAMES;
-
-                /* convert S16 → float */
-                std::vector<float> f_in(static_cast<size_t>(n));
-                for (int i = 0; i < n; i++)
-                    f_in[static_cast<size_t>(i)] = capture_buf[static_cast<size_t>(i)] / 32768.0f;
-
-                /* resample to 8 kHz */
-                int got = resample_linear_stream(
-                    f_in.data(), n,
-                    resamp_tmp.data(), resamp_out_max,
-                    rate_in_, RADE_FS,
-                    resamp_in_frac_, resamp_in_prev_);
-
-                acc_8k.insert(acc_8k.end(), resamp_tmp.begin(),
-                              resamp_tmp.begin() + got);
+        size_t   in_backlog = 0;   /* 8 kHz samples queued behind this frame */
+        uint64_t t_in       = 0;
+
+        /* ── fetch nin 8 kHz samples ─────────────────────────────────── */
+        if (file_mode_) {
+            /* ── file mode: stream from the WAV, paced by playback ──── */
+            while (feat_ring_.space() < n_frames_max + 1 &&
+                   running_.load(std::memory_order_relaxed))
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            if (!file_read_8k(in_8k.data(), nin)) {
+                dsp_eof_.store(true, std::memory_order_release);
+                break;
             }
+        } else {
+            /* ── live mode: wait for the capture thread ──────────────── */
+            while (in_ring_.size() < static_cast<size_t>(nin) &&
+                   running_.load(std::memory_order_relaxed))
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            in_ring_.read(in_8k.data(), static_cast<size_t>(nin));
+            in_backlog = in_ring_.size();
+            t_in       = rade_time_ns();
         }
+        mf++;
 
         if (!running_.load(std::memory_order_relaxed)) break;
+        uint64_t t_busy = rade_time_ns();
 
         /* ── FFT spectrum of input 8 kHz audio ───────────────────────── */
-        if (static_cast<int>(acc_8k.size()) >= FFT_SIZE) {
-            std::complex<float> fft_buf[FFT_SIZE];
-            int offset = static_cast<int>(acc_8k.size()) - FFT_SIZE;
-            for (int i = 0; i < FFT_SIZE; i++)
-                fft_buf[i] = acc_8k[static_cast<size_t>(offset + i)] * fft_window_[i];
-
-            fft_radix2(fft_buf, FFT_SIZE);
-
-            float tmp[SPECTRUM_BINS];
-            for (int i = 0; i < SPECTRUM_BINS; i++) {
-                float mag = std::abs(fft_buf[i]) / (FFT_SIZE * 0.5f);
-                tmp[i] = (mag > 1e-10f)
-                       ? 20.0f * std::log10(mag)
-                       : -200.0f;
+        {
+            if (nin >= FFT_SIZE) {
+                std::memcpy(spec_hist.data(), &in_8k[static_cast<size_t>(nin - FFT_SIZE)],
+                            FFT_SIZE * sizeof(float));
+            } else {
+                std::memmove(spec_hist.data(), &spec_hist[static_cast<size_t>(nin)],
+                             static_cast<size_t>(FFT_SIZE - nin) * sizeof(float));
+                std::memcpy(&spec_hist[static_cast<size_t>(FFT_SIZE - nin)], in_8k.data(),
+                            static_cast<size_t>(nin) * sizeof(float));
             }
-            {
-                std::lock_guard<std::mutex> lock(spectrum_mutex_);
-                std::memcpy(spectrum_mag_, tmp, sizeof(spectrum_mag_));
+
+            if (mf % static_cast<uint64_t>(governor_.spectrum_every()) == 0) {
+                rade_spectrum_db(&spectrum_, tel_.spectrum, spec_hist.data());
+                tel_.spectrum_frame = mf;
             }
         }
 
@@ -561,31 +957,40 @@ void RadaeDecoder::processing_loop()
         {
             double sum2 = 0.0;
             for (int i = 0; i < nin; i++)
-                sum2 += static_cast<double>(acc_8k[static_cast<size_t>(i)])
-                      * static_cast<double>(acc_8k[static_cast<size_t>(i)]);
+                sum2 += static_cast<double>(in_8k[static_cast<size_t>(i)])
+                      * static_cast<double>(in_8k[static_cast<size_t>(i)]);
             input_level_.store(std::sqrt(static_cast<float>(sum2 / nin)),
                                std::memory_order_relaxed);
         }
 
         /* ── Hilbert transform: real 8 kHz → complex IQ ──────────────── */
-        hilbert_process(acc_8k.data(), rx_buf.data(), nin,
-                        hilbert_coeffs_, hilbert_hist_, hilbert_pos_,
-                        delay_buf_, delay_pos_, HILBERT_NTAPS, HILBERT_DELAY);
+        uint64_t t0 = rade_time_ns();
+        rade_hilbert_process(&hilbert_, rx_buf.data(), in_8k.data(), nin);
+        uint64_t t1 = rade_time_ns();
+        rade_hist_add(&stage_hist_[ST_HILBERT], t1 - t0);
+        rade_trace_span(TR_HILBERT, t0, t1);
 
-        /* consume nin samples from accumulator */
-        acc_8k.erase(acc_8k.begin(), acc_8k.begin() + nin);
+        if (iq_.f && rade_iq_write(&iq_, rx_buf.data(), nin) == 0)
+            iq_frames_.store(iq_.frames, std::memory_order_relaxed);
 
         /* ── RADE Rx ─────────────────────────────────────────────────── */
         int has_eoo = 0;
         int n_out = rade_rx(rade_, feat_buf.data(), &has_eoo,
                             eoo_buf.data(), rx_buf.data());
+        uint64_t t2 = rade_time_ns();
+        rade_hist_add(&stage_hist_[ST_RADE_RX], t2 - t1);
+        rade_trace_span(TR_RADE_RX, t1, t2);
 
         /* decode EOO callsign if present */
+        bool got_callsign = false;
         if (has_eoo) {
+            AllocCheckPause pause;   /* once per over, not steady state */
             std::string callsign;
+            tel_.eoo_frames++;
             if (eoo_decoder.decode(eoo_buf.data(), n_eoo_bits / 2, callsign)) {
-                std::lock_guard<std::mutex> lk(callsign_mutex_);
-                last_callsign_ = callsign;
+                std::snprintf(tel_.callsign, sizeof tel_.callsign, "%s", callsign.c_str());
+                tel_.eoo_callsigns++;
+                got_callsign = true;
             }
         }
 
@@ -599,104 +1004,349 @@ void RadaeDecoder::processing_loop()
             freq_offset_.store(rade_freq_offset(rade_),
                                std::memory_order_relaxed);
         }
+        tel_.audio_ns += static_cast<uint64_t>(nin) * (1000000000ull / RADE_FS);
+        if (now_synced && !was_synced) {
+            tel_.syncs++;
+            if (tel_.first_sync_s < 0.0f)
+                tel_.first_sync_s = static_cast<float>(tel_.audio_ns * 1e-9);
+        }
+        uint64_t busy = rade_time_ns() - t_busy;
+        tel_.busy_ns += busy;
+
+        /* ── shed load if we're getting close to real time ───────────── */
+        bool shed_changed = governor_.update(busy, static_cast<uint64_t>(nin) * (1000000000ull / RADE_FS),
+                                             in_backlog, static_cast<size_t>(nin));
+        if (shed_changed) {
+            rade_set_load_shed(rade_, governor_.rade_flags());
+            if (iq_.f) rade_iq_write_load_shed(&iq_, governor_.rade_flags());
+            tel_.shed_level = governor_.level();
+            tel_.shed_changes++;
+        }
+        tel_.dsp_load = governor_.load();
+        if (shed_changed || now_synced != was_synced ||
+            mf % static_cast<uint64_t>(governor_.telemetry_every()) == 0)
+            publish_telemetry(mf);
+
+        int n_frames = n_out / RADE_NB_TOTAL_FEATURES;
+
+        /* ── send them to a remote vocoder ──────────────────────────── */
+        if (feat_tx_.is_open()) {
+            pkt.mf          = static_cast<uint32_t>(mf);
+            pkt.flags       = (now_synced ? FEATPKT_SYNCED : 0)
+                            | (was_synced && !now_synced ? FEATPKT_LOST_SYNC : 0)
+                            | (has_eoo ? FEATPKT_EOO : 0)
+                            | (got_callsign ? FEATPKT_CALLSIGN : 0);
+            pkt.snr_dB      = snr_dB_.load(std::memory_order_relaxed);
+            pkt.freq_offset = freq_offset_.load(std::memory_order_relaxed);
+            std::memcpy(pkt.callsign, tel_.callsign, sizeof pkt.callsign - 1);
+            pkt.n_frames    = std::min(n_frames, FEATSTREAM_MAX_FRAMES);
+            for (int fi = 0; fi < pkt.n_frames; fi++)
+                std::memcpy(pkt.feat[fi], &feat_buf[static_cast<size_t>(fi * RADE_NB_TOTAL_FEATURES)],
+                            sizeof pkt.feat[fi]);
+            feat_tx_.send(pkt);
+            net_packets_.store(feat_tx_.sent(),    std::memory_order_relaxed);
+            net_lost_.store(feat_tx_.dropped(), std::memory_order_relaxed);
+        }
+        if (!stream_out_.is_open()) {
+            /* demod only, nothing synthesises here */
+            was_synced = now_synced;
+            continue;
+        }
 
-        /* handle sync transitions */
-        if (was_synced && !now_synced) {
+        /* ── hand the features to the synthesis thread ───────────────── */
+        FeatFrame ff{};
+        ff.mf   = mf;
+        if (!file_mode_) {
+            ff.t_in = t_in;
+            ff.in_s = static_cast<double>(in_dev_delay_.load(std::memory_order_relaxed)) / rate_in_
+                    + static_cast<double>(static_cast<size_t>(nin) + in_backlog) / RADE_FS;
+        }
+        if (was_synced && !now_synced)
+            lost_pending_ = true;
+        was_synced = now_synced;
+        if (!send_lost_sync(ff))
+            continue;
+
+        if (n_frames == 0) {
+            ff.kind = FeatFrame::NO_OUTPUT;
+            feat_ring_.write(&ff, 1);
+        }
+        ff.kind = FeatFrame::FEATURES;
+        for (int fi = 0; fi < n_frames; fi++) {
+            ff.first = (fi == 0);
+            ff.last  = (fi == n_frames - 1);
+            std::memcpy(ff.feat, &feat_buf[static_cast<size_t>(fi * RADE_NB_TOTAL_FEATURES)],
+                        sizeof(ff.feat));
+            /* live mode drops rather than block if synthesis has stalled */
+            feat_ring_.write(&ff, 1);
+        }
+    }
+    alloc_check_end("RadaeDecoder::processing_loop");
+}
+
+/* LOST_SYNC resets FARGAN, so unlike features it is never dropped: with
+   the ring full it stays pending, and goes out ahead of the next modem
+   frame's records, which are held back until it has.  DSP or network
+   thread only */
+bool RadaeDecoder::send_lost_sync(FeatFrame ff)
+{
+    if (!lost_pending_) return true;
+    ff.kind = FeatFrame::LOST_SYNC;
+    lost_pending_ = feat_ring_.write(&ff, 1) == 0;
+    return !lost_pending_;
+}
+
+/* ── network loop (dedicated thread, remote mode) ────────────────────
+ *
+ *  Stands in for capture and DSP: each feature packet becomes the same
+ *  FeatFrames and status updates processing_loop() would have made from
+ *  its rade_rx() call.  A sender that goes quiet for NET_TIMEOUT_MS while
+ *  in sync is treated as a loss of sync, so the vocoder is reset and the
+ *  display doesn't freeze on the last packet.
+ * ──────────────────────────────────────────────────────────────────── */
+
+void RadaeDecoder::network_loop()
+{
+    constexpr int NET_POLL_MS    = 100;
+    constexpr int NET_TIMEOUT_MS = 1000;
+
+    FeaturePacket pkt;
+    bool     was_synced = false;
+    uint64_t n          = 0;   /* packets received */
+    uint64_t last_mf    = 0;   /* sender's modem frame of the last one */
+    int      quiet_ms   = 0;
+
+    alloc_check_begin();
+    while (running_.load(std::memory_order_relaxed)) {
+        FeatFrame ff{};
+
+        if (!feat_rx_.receive(&pkt, NET_POLL_MS)) {
+            quiet_ms += NET_POLL_MS;
+            if (was_synced && quiet_ms >= NET_TIMEOUT_MS) {
+                synced_.store(false, std::memory_order_relaxed);
+                ff.mf   = last_mf + static_cast<uint64_t>(quiet_ms) * RADE_FS / (1000 * RADE_NMF);
+                lost_pending_ = true;
+                send_lost_sync(ff);
+                was_synced = false;
+                publish_telemetry(n);
+            }
+            continue;
+        }
+        quiet_ms = 0;
+        n++;
+
+        bool now_synced = (pkt.flags & FEATPKT_SYNCED) != 0;
+        synced_.store(now_synced, std::memory_order_relaxed);
+        if (now_synced) {
+            snr_dB_.store(pkt.snr_dB, std::memory_order_relaxed);
+            freq_offset_.store(pkt.freq_offset, std::memory_order_relaxed);
+        }
+        if (pkt.flags & FEATPKT_EOO) {
+            tel_.eoo_frames++;
+            if (pkt.flags & FEATPKT_CALLSIGN) {
+                std::snprintf(tel_.callsign, sizeof tel_.callsign, "%s", pkt.callsign);
+                tel_.eoo_callsigns++;
+            }
+        }
+        if (now_synced && !was_synced)
+            tel_.syncs++;
+        net_packets_.store(feat_rx_.received(), std::memory_order_relaxed);
+        net_lost_.store(feat_rx_.lost(), std::memory_order_relaxed);
+        publish_telemetry(n);
+
+        /* the sender's modem frame count, so a resume after a drop is
+           timed by the radio signal rather than by what got through */
+        ff.mf   = pkt.mf;
+        last_mf = pkt.mf;
+        if ((was_synced && !now_synced) || (pkt.flags & FEATPKT_LOST_SYNC))
+            lost_pending_ = true;
+        was_synced = now_synced;
+        if (!send_lost_sync(ff))
+            continue;
+
+        if (pkt.n_frames == 0) {
+            ff.kind = FeatFrame::NO_OUTPUT;
+            feat_ring_.write(&ff, 1);
+        }
+        ff.kind = FeatFrame::FEATURES;
+        for (int fi = 0; fi < pkt.n_frames; fi++) {
+            ff.first = (fi == 0);
+            ff.last  = (fi == pkt.n_frames - 1);
+            std::memcpy(ff.feat, pkt.feat[fi], sizeof pkt.feat[fi]);
+            feat_ring_.write(&ff, 1);
+        }
+    }
+    alloc_check_end("RadaeDecoder::network_loop");
+}
+
+/* ── synthesis loop (dedicated thread) ───────────────────────────────
+ *
+ *  Second stage of the Rx pipeline: FARGAN synthesis of the features
+ *  the DSP thread queues in feat_ring_, resampling to the output rate
+ *  and handing the speech to the playback thread.  Running it on its
+ *  own core overlaps synthesis of one modem frame with the demod and
+ *  neural decoder of the next, instead of 12 FARGAN frames back to back
+ *  after each rade_rx().
+ * ──────────────────────────────────────────────────────────────────── */
+
+void RadaeDecoder::synth_loop()
+{
+    /* output buffers for one 10-ms speech frame at rate_out_ */
+    int out_max = resamp_out_.max_output(LPCNET_FRAME_SIZE);
+    std::vector<float> out_f(static_cast<size_t>(out_max));
+    std::vector<int16_t> out_s16(shm_out_.hdr ? static_cast<size_t>(out_max) : 0);
+
+    uint64_t resume_mf = static_cast<uint64_t>(FARGAN_RESUME_S * RADE_FS / RADE_NMF);
+
+    double   rms_sum = 0.0;
+    int      rms_n   = 0;
+    uint64_t t_fargan = 0, t_resamp = 0;   /* summed over the modem frame */
+
+    alloc_check_begin();
+    while (running_.load(std::memory_order_relaxed)) {
+        FeatFrame ff;
+        if (feat_ring_.read(&ff, 1) == 0) {
+            if (dsp_eof_.load(std::memory_order_acquire)) {
+                /* file mode: everything decoded has been synthesised */
+                file_eof_.store(true, std::memory_order_release);
+                if (!stream_out_.is_open())
+                    running_ = false;  /* no playback thread to finish it */
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        if (ff.kind == FeatFrame::LOST_SYNC) {
             /* lost sync — reset FARGAN for next sync */
             fargan_init(static_cast<FARGANState*>(fargan_));
             fargan_ready_ = false;
             warmup_count_ = 0;
-            output_primed = false;
+            lost_mf_      = ff.mf;
+            continue;
+        }
+        if (ff.kind == FeatFrame::NO_OUTPUT) {
+            /* no decoded output this frame — decay level toward zero */
+            float lvl = output_level_.load(std::memory_order_relaxed);
+            output_level_.store(lvl * 0.9f, std::memory_order_relaxed);
+            continue;
         }
-        was_synced = now_synced;
 
-        /* ── synthesise decoded speech ───────────────────────────────── */
-        if (n_out > 0) {
-            int n_frames = n_out / RADE_NB_TOTAL_FEATURES;
-            double rms_sum = 0.0;
-            int    rms_n   = 0;
-
-            for (int fi = 0; fi < n_frames; fi++) {
-                float* feat = &feat_buf[static_cast<size_t>(fi * RADE_NB_TOTAL_FEATURES)];
-
-                /* ── FARGAN warmup: buffer first 5 frames ─────────────── */
-                if (!fargan_ready_) {
-                    std::memcpy(&warmup_buf_[warmup_count_ * NB_TOTAL_FEAT],
-                                feat,
-                                static_cast<size_t>(NB_TOTAL_FEAT) * sizeof(float));
-
-                    if (++warmup_count_ >= 5) {
-                        /* pack to NB_FEATURES stride for fargan_cont */
-                        float packed[5 * NB_FEATURES];
-                        for (int i = 0; i < 5; i++)
-                            std::memcpy(&packed[i * NB_FEATURES],
-                                        &warmup_buf_[i * NB_TOTAL_FEAT],
-                                        static_cast<size_t>(NB_FEATURES) * sizeof(float));
-
-                        float zeros[FARGAN_CONT_SAMPLES] = {};
-                        fargan_cont(static_cast<FARGANState*>(fargan_),
-                                    zeros, packed);
-                        fargan_ready_ = true;
-
-                        /* pre-fill output buffer with silence so it has
-                           enough headroom for the bursty write pattern */
-                        if (!output_primed) {
-                            int prefill = 2 * 12 * LPCNET_FRAME_SIZE
-                                * static_cast<int>(rate_out_) / RADE_FS_SPEECH;
-                            std::vector<int16_t> silence(static_cast<size_t>(prefill), 0);
-                            stream_out_.write(silence.data(),
-                                              static_cast<unsigned long>(prefill));
-                            output_primed = true;
-                        }
-                    }
-                    continue;   /* warmup frames not synthesised */
-                }
+        float* feat = ff.feat;
 
-                /* ── synthesise one 10-ms speech frame ────────────────── */
-                float fpcm[LPCNET_FRAME_SIZE];
-                fargan_synthesize(static_cast<FARGANState*>(fargan_),
-                                  fpcm, feat);
-
-                /* accumulate RMS of output */
-                for (int s = 0; s < LPCNET_FRAME_SIZE; s++)
-                    rms_sum += static_cast<double>(fpcm[s]) * fpcm[s];
-                rms_n += LPCNET_FRAME_SIZE;
-
-                /* ── resample 16 kHz → output rate & write ────────────── */
-                /* max output samples: LPCNET_FRAME_SIZE * (rate_out/16000) + 2 */
-                int out_max = LPCNET_FRAME_SIZE * static_cast<int>(rate_out_) / RADE_FS_SPEECH + 4;
-                std::vector<float> out_f(static_cast<size_t>(out_max));
-
-                int n_resamp = resample_linear_stream(
-                    fpcm, LPCNET_FRAME_SIZE,
-                    out_f.data(), out_max,
-                    RADE_FS_SPEECH, rate_out_,
-                    resamp_out_frac, resamp_out_prev);
-
-                /* float → S16 */
-                std::vector<int16_t> out_pcm(static_cast<size_t>(n_resamp));
-                for (int s = 0; s < n_resamp; s++) {
-                    float v = out_f[static_cast<size_t>(s)] * 32768.0f;
-                    if (v >  32767.0f) v =  32767.0f;
-                    if (v < -32767.0f) v = -32767.0f;
-                    out_pcm[static_cast<size_t>(s)] = static_cast<int16_t>(
-                        std::floor(0.5 + static_cast<double>(v)));
-                }
+        /* ── warm resume after a short drop (low latency mode) ──────── */
+        if (!fargan_ready_ && warmup_count_ == 0 && snap_valid_) {
+            if (low_latency_ && ff.mf - lost_mf_ <= resume_mf) {
+                /* carry on from the last good state, no warm-up */
+                std::memcpy(fargan_, fargan_snap_, sizeof(FARGANState));
+                fargan_ready_ = true;
+            } else {
+                snap_valid_ = false;
+            }
+        }
 
-                /* write to audio output */
-                stream_out_.write(out_pcm.data(),
-                                  static_cast<unsigned long>(n_resamp));
+        /* ── FARGAN warmup: buffer first 5 frames ─────────────────────── */
+        if (!fargan_ready_) {
+            std::memcpy(&warmup_buf_[warmup_count_ * NB_TOTAL_FEAT],
+                        feat,
+                        static_cast<size_t>(NB_TOTAL_FEAT) * sizeof(float));
+
+            if (++warmup_count_ >= 5) {
+                /* pack to NB_FEATURES stride for fargan_cont */
+                float packed[5 * NB_FEATURES];
+                for (int i = 0; i < 5; i++)
+                    std::memcpy(&packed[i * NB_FEATURES],
+                                &warmup_buf_[i * NB_TOTAL_FEAT],
+                                static_cast<size_t>(NB_FEATURES) * sizeof(float));
+
+                float zeros[FARGAN_CONT_SAMPLES] = {};
+                fargan_cont(static_cast<FARGANState*>(fargan_),
+                            zeros, packed);
+                fargan_ready_ = true;
+            }
+        } else {
+            /* ── synthesise one 10-ms speech frame ────────────────────── */
+            float fpcm[LPCNET_FRAME_SIZE];
+            uint64_t t0 = rade_time_ns();
+            fargan_synthesize(static_cast<FARGANState*>(fargan_),
+                              fpcm, feat);
+            uint64_t t1 = rade_time_ns();
+            t_fargan += t1 - t0;
+            rade_trace_span(TR_FARGAN, t0, t1);
+
+            /* accumulate RMS of output */
+            for (int s = 0; s < LPCNET_FRAME_SIZE; s++)
+                rms_sum += static_cast<double>(fpcm[s]) * fpcm[s];
+            rms_n += LPCNET_FRAME_SIZE;
+
+            /* ── resample 16 kHz → output rate ────────────────────── */
+            uint64_t tt = rade_trace_begin();
+            int n_resamp = resamp_out_.process(fpcm, LPCNET_FRAME_SIZE,
+                                               out_f.data(), out_max);
+            rade_trace_end(TR_RESAMPLE_OUT, tt);
+            t_resamp += rade_time_ns() - t1;
+
+            /* the device takes float, just keep it in range */
+            for (int s = 0; s < n_resamp; s++) {
+                float& v = out_f[static_cast<size_t>(s)];
+                v = std::max(-1.0f, std::min(1.0f, v));
             }
 
+            /* end to end latency of the first speech sample of the
+               modem frame, which was ff.in_s old when it was read */
+            if (ff.first && ff.t_in != 0) {
+                double lat_s = ff.in_s
+                             + static_cast<double>(rade_time_ns() - ff.t_in) * 1e-9
+                             + static_cast<double>(out_ring_.size()) / rate_out_
+                             + static_cast<double>(std::max(0L, out_dev_delay_.load(std::memory_order_relaxed))) / rate_out_;
+                latency_ms_.store(static_cast<float>(lat_s * 1e3), std::memory_order_relaxed);
+                rade_hist_add(&latency_hist_, static_cast<uint64_t>(lat_s * 1e9));
+            }
+
+            /* file mode is paced by playback (or the ring's reader), live
+               mode drops if it has stalled */
+            if (shm_out_.hdr) {
+                for (int s = 0; s < n_resamp; s++)
+                    out_s16[static_cast<size_t>(s)] =
+                        static_cast<int16_t>(std::lrint(out_f[static_cast<size_t>(s)] * 32767.0f));
+                if (file_mode_) {
+                    while (rade_shm_write_wait(&shm_out_, n_resamp, 100) == 0 &&
+                           running_.load(std::memory_order_relaxed)) {}
+                }
+                rade_shm_write(&shm_out_, out_s16.data(), n_resamp);
+            } else {
+                if (file_mode_) {
+                    while (out_ring_.space() < static_cast<size_t>(n_resamp) &&
+                           running_.load(std::memory_order_relaxed))
+                        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+                out_ring_.write(out_f.data(), static_cast<size_t>(n_resamp));
+            }
+        }
+
+        if (!ff.last) continue;
+
+        /* ── end of the modem frame's speech ──────────────────────────── */
+        if (rms_n > 0) {
+            rade_hist_add(&stage_hist_[ST_FARGAN], t_fargan);
+            rade_hist_add(&stage_hist_[ST_RESAMPLE_OUT], t_resamp);
+
             /* update output level */
-            if (rms_n > 0)
-                output_level_.store(
-                    static_cast<float>(std::sqrt(rms_sum / rms_n)),
-                    std::memory_order_relaxed);
-        } else {
-            /* no decoded output this frame — decay level toward zero */
-            float lvl = output_level_.load(std::memory_order_relaxed);
-            output_level_.store(lvl * 0.9f, std::memory_order_relaxed);
+            output_level_.store(
+                static_cast<float>(std::sqrt(rms_sum / rms_n)),
+                std::memory_order_relaxed);
+
+            /* keep a copy of a good FARGAN state to resume from */
+            if (low_latency_ && fargan_ready_ &&
+                snr_dB_.load(std::memory_order_relaxed) >= FARGAN_SNAP_SNR_DB) {
+                std::memcpy(fargan_snap_, fargan_, sizeof(FARGANState));
+                snap_valid_ = true;
+            }
         }
+        rms_sum  = 0.0;
+        rms_n    = 0;
+        t_fargan = 0;
+        t_resamp = 0;
     }
+    alloc_check_end("RadaeDecoder::synth_loop");
 }
@@ -1,11 +1,28 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <atomic>
-#include <mutex>
+#include <functional>
 #include <thread>
 #include "audio_stream.h"
+#include "feature_stream.h"
+#include "load_governor.h"
+#include "spsc_ring.h"
+#include "resampler.h"
+#include "rt_policy.h"
+#include "telemetry.h"
+
+extern "C" {
+#include "rade_hilbert.h"
+#include "rade_iq.h"
+#include "rade_shm.h"
+#include "rade_spectrum.h"
+#include "rade_stats.h"
+#include "rade_wav.h"
+}
 
 /* Forward declaration — avoids exposing RADE/FARGAN C headers in this header */
 struct rade;
@@ -13,9 +30,25 @@ struct rade;
 /* ── RadaeDecoder ──────────────────────────────────────────────────────────
  *
  *  Real-time RADAE decoder pipeline:
- *    PortAudio capture → resample → Hilbert → RADE Rx → FARGAN → resample → PortAudio playback
+ *    PortAudio capture → resample → [ring] → Hilbert → RADE Rx → [features]
+ *      → FARGAN → resample → [ring] → PortAudio playback
+ *
+ *  Capture, DSP, synthesis and playback each run on their own thread,
+ *  connected by lock-free SPSC rings, so a slow modem frame (e.g. a
+ *  search-mode acquisition) doesn't overrun capture or underrun playback,
+ *  and FARGAN synthesis of one modem frame overlaps the demod and neural
+ *  decoder of the next.  Status is exposed via atomics.
  *
- *  All processing runs on a dedicated thread.  Status is exposed via atomics.
+ *  The pipeline can also be split at [features] across two machines (see
+ *  feature_stream.h): with a feature sink the DSP thread sends each modem
+ *  frame's features over UDP, and open_remote() runs only FARGAN and
+ *  playback on what arrives, a network thread taking the place of capture
+ *  and DSP.
+ *
+ *  A device id of "shm:NAME" is a shared memory ring (see rade_shm.h)
+ *  rather than a sound card: for input an existing mono ring at any rate,
+ *  read in place; for output a new ring of S16 speech at 16 kHz, written
+ *  by the synthesis thread with no playback thread behind it.
  * ──────────────────────────────────────────────────────────────────────── */
 
 class RadaeDecoder {
@@ -26,10 +59,15 @@ public:
     /* lifecycle -------------------------------------------------------------- */
     bool open(const std::string& input_hw_id, const std::string& output_hw_id);
     bool open_file(const std::string& wav_path, const std::string& output_hw_id);
+    bool open_remote(const std::string& listen_addr, int port, const std::string& output_hw_id);
     void close();
     void start();
     void stop();
 
+    /* weights blob passed to rade_open(), "" for the built-in weights (call
+       before open()).  Contexts naming the same blob share one mapping */
+    void set_model_file(const std::string& path) { model_file_ = path; }
+
     /* status queries (thread-safe) ------------------------------------------ */
     bool  is_running()            const { return running_.load(std::memory_order_relaxed); }
     bool  is_synced()             const { return synced_.load(std::memory_order_relaxed); }
@@ -39,19 +77,160 @@ public:
     float get_output_level_left() const { return output_level_.load(std::memory_order_relaxed); }
     float get_output_level_right()const { return output_level_.load(std::memory_order_relaxed); } // mono
 
-    /* spectrum (thread-safe via mutex) --------------------------------------- */
+    /* spectrum (thread-safe, lock-free) -------------------------------------- */
     static constexpr int FFT_SIZE      = 512;
     static constexpr int SPECTRUM_BINS = FFT_SIZE / 2;   // 256
+    static_assert(SPECTRUM_BINS == Telemetry::SPECTRUM_BINS, "telemetry spectrum size");
 
     void get_spectrum(float* out, int n) const;           // copies up to n bins (dB)
     int  spectrum_bins()          const { return SPECTRUM_BINS; }
     float spectrum_sample_rate()  const { return 8000.f; } // always at modem rate
 
-    /* callsign (thread-safe via mutex) --------------------------------------- */
+    /* callsign (thread-safe, lock-free) -------------------------------------- */
     std::string last_callsign() const;
 
+    /* everything above plus the stage timers as one consistent snapshot,
+       published by the DSP thread once per modem frame.  Wait-free for the
+       DSP thread, never blocks on the caller (thread-safe) ---------------- */
+    Telemetry   telemetry() const { return telemetry_.read(); }
+
+    /* audio buffering (thread-safe) ------------------------------------------ */
+    float    input_fill()         const { return in_ring_.fill(); }    // 0..1
+    float    output_fill()        const { return out_ring_.fill(); }   // 0..1
+    unsigned capture_overruns()   const { return capture_overruns_.load(std::memory_order_relaxed); }
+    unsigned playback_underruns() const { return playback_underruns_.load(std::memory_order_relaxed); }
+
+    /* audio device period, buffer and transfer mode, see AudioTuning (call
+       before open()) */
+    void set_audio_tuning(const AudioTuning& t) { stream_in_.set_tuning(t); stream_out_.set_tuning(t); }
+
+    /* scheduling, CPU affinity and memory locking for the pipeline threads,
+       see RtPolicy (call before open()).  rt_denied() is set if the system
+       refused any of it, the pipeline runs on without */
+    void set_rt_policy(const RtPolicy& p) { rt_policy_ = p; }
+    bool rt_denied() const { return rt_denied_.load(std::memory_order_relaxed); }
+
+    /* low latency output (call before start()) ------------------------------ */
+    /* Playback starts as soon as there is anything to play, and while the
+       ring is short mid-over it waits on the device's own queue rather than
+       padding with silence.  FARGAN's state is also snapshotted while the
+       signal is good and restored if sync comes back within a few seconds,
+       so a short drop doesn't pay for a cold warm-up. */
+    void  set_low_latency(bool on) { low_latency_ = on; }
+    bool  low_latency()       const { return low_latency_; }
+
+    /* load shedding (call before start()) ---------------------------------- */
+    /* On by default: when the DSP thread gets close to real time the
+       spectrum, acquisition and display work is cut back in steps (see
+       LoadGovernor) before capture can overrun.  The level is reported in
+       telemetry().shed_level */
+    void  set_load_shedding(bool on) { governor_.set_enabled(on); }
+    bool  load_shedding()     const  { return governor_.enabled(); }
+
+    /* parallel acquisition (call before start()) --------------------------- */
+    /* Splits the pilot search across n threads (rade_set_acq_threads()), so
+       a single channel locks sooner at the cost of more CPU while it's
+       searching; also used by scan_file().  1, the default, keeps it on the
+       DSP thread.  The workers start from the calling thread, so they take
+       its scheduling rather than the DSP thread's */
+    void  set_acq_threads(int n);
+    int   acq_threads()       const { return acq_threads_; }
+
+    /* warm re-acquire (call before start()) -------------------------------- */
+    /* After a fade, also look for the signal near where it was for this
+       many seconds (rade_set_warm_reacquire()), 0, the default, is off */
+    void  set_warm_reacquire(float seconds);
+    float warm_reacquire()    const { return warm_s_; }
+
+    /* receiver snapshot (stopped, between open() and start()) -------------- */
+    /* save_state() captures the receiver (rade_snapshot()), FARGAN's state
+       less its weights, the warm-up frames and the Hilbert history;
+       restore_state() loads them into a decoder opened the same way on the
+       same build, so a live decode carries on in another process or host
+       with no re-acquisition or FARGAN warm-up.  Audio still queued in the
+       rings when it stopped isn't included. */
+    bool  save_state(std::vector<uint8_t>& out) const;
+    bool  restore_state(const std::vector<uint8_t>& in);
+
+    /* end to end latency, antenna sample to speaker sample (live mode) ----- */
+    /* Sum of the capture device queue, the input ring, one modem frame, the
+       DSP time, the output ring and the playback device queue, for the first
+       speech sample of each modem frame.  Stats in us, like stage_stats(). */
+    float latency_ms()        const { return latency_ms_.load(std::memory_order_relaxed); }
+    bool  latency_stats(rade_stage_stats* st) const;
+
+    /* the device queues in that sum as last measured (snd_pcm_delay() on
+       ALSA) and the periods the devices settled on */
+    float input_delay_ms()  const;
+    float output_delay_ms() const;
+    unsigned long input_period()  const { return stream_in_.period_frames(); }
+    unsigned long output_period() const { return stream_out_.period_frames(); }
+
+    /* feature streaming (call before open()) ------------------------------- */
+    /* Sends every modem frame's decoded features, sync, SNR and callsign to
+       host:port for a decoder opened with open_remote() to synthesise.  With
+       a sink, open() takes "" for the output device to skip local playback
+       and FARGAN altogether, leaving only the demod and neural decoder on
+       this machine.  feature_packets() counts datagrams sent (receiving
+       when remote), feature_lost() ones dropped on a full socket (lost in
+       transit when remote). */
+    void  set_feature_sink(const std::string& host, int port, FeatEncoding enc)
+          { sink_host_ = host; sink_port_ = port; sink_enc_ = enc; }
+    bool     is_remote()       const { return remote_mode_; }
+    uint64_t feature_packets() const { return net_packets_.load(std::memory_order_relaxed); }
+    uint64_t feature_lost()    const { return net_lost_.load(std::memory_order_relaxed); }
+
+    /* IQ capture (call before start()) ------------------------------------ */
+    /* Records the rx_buf handed to rade_rx() every modem frame to path (see
+       rade_iq.h), recreated on each start(), "" to stop recording.  Replay
+       it with rade_iq_replay to rerun the receiver on the exact samples,
+       without the audio device, resampler or Hilbert transform. */
+    void  set_iq_capture(const std::string& path) { iq_path_ = path; }
+    uint64_t iq_frames() const { return iq_frames_.load(std::memory_order_relaxed); }
+
+    /* file scan and seek (file mode, call from the thread that opened) ----- */
+    /* scan_file() runs the whole file through acquisition and demod only
+       (no neural decoder or FARGAN) as fast as the CPU allows, and indexes
+       each over it finds.  It may run on a worker thread, so long as
+       nothing else touches the decoder until it returns; progress, if
+       given, is called once per modem frame with the seconds scanned so
+       far, and returning false abandons the scan.  seek() restarts
+       playback from a point in the file with a fresh receiver; seek_over()
+       starts just before an over so the receiver has time to acquire it. */
+    struct Over {
+        double      start_s  = 0.0;   // first modem frame in sync
+        double      end_s    = 0.0;   // sync lost or end of over
+        float       snr_dB   = 0.0f;  // mean SNR estimate while in sync
+        std::string callsign;         // from the EOO, empty if none decoded
+    };
+    using ScanProgress = std::function<bool(double scanned_s)>;
+    bool  scan_file(const ScanProgress& progress = nullptr);
+    const std::vector<Over>& overs() const { return overs_; }
+    bool  seek(double seconds);
+    bool  seek_over(size_t i);
+    double file_duration() const;
+
+    /* stage timers (thread-safe, never blocks the DSP) ---------------------- */
+    /* Stages are this pipeline's own (resample, Hilbert, FARGAN, audio write,
+       ...) followed by the RADE Rx internals from rade_get_stage_stats().
+       Times accumulate from open(). */
+    int         n_stages() const;
+    const char* stage_name(int i) const;
+    bool        stage_stats(int i, rade_stage_stats* st) const;
+
+    /* time to re-sync after fades, see rade_get_resync_stats() */
+    bool        resync_stats(rade_resync_stats* st) const;
+
 private:
+    void capture_loop();
     void processing_loop();
+    void synth_loop();
+    void playback_loop();
+    void network_loop();
+    bool open_feature_sink();
+    bool open_output(const std::string& output_hw_id);
+    bool file_read_8k(float* out, int n);
+    void file_rewind(uint64_t frame);
 
     /* ── audio stream handles ────────────────────────────────────────────── */
     AudioStream  stream_in_;
@@ -59,44 +238,105 @@ private:
     unsigned int rate_in_  = 0;   // capture rate
     unsigned int rate_out_ = 0;   // playback rate
 
+    /* ── shared memory rings in their place, for "shm:NAME" ───────────────── */
+    rade_shm     shm_in_  {};     // read by the capture thread
+    rade_shm     shm_out_ {};     // written by the synthesis thread
+
     /* ── RADE receiver (opaque) ───────────────────────────────────────────── */
     struct rade*  rade_     = nullptr;
+    std::string   model_file_;
+    char*         model_arg();
+
+    /* ── Feature stream: sender on the DSP thread, or receiver on the
+       network thread in remote mode ──────────────────────────────────────── */
+    std::string           sink_host_;
+    int                   sink_port_   = 0;
+    FeatEncoding          sink_enc_    = FEAT_F32;
+    FeatureSender         feat_tx_;
+    FeatureReceiver       feat_rx_;
+    bool                  remote_mode_ = false;
+    std::atomic<uint64_t> net_packets_ {0};
+    std::atomic<uint64_t> net_lost_    {0};
+
+    /* ── IQ capture, written by the DSP thread ─────────────────────────────── */
+    std::string           iq_path_;
+    rade_iq_writer        iq_ {};
+    std::atomic<uint64_t> iq_frames_ {0};
+
+    /* ── thread and memory policy ─────────────────────────────────────────── */
+    RtPolicy          rt_policy_;
+    std::atomic<bool> rt_denied_ {false};
+    void              apply_memory_policy();              // after rade_open()
+    void              apply_thread_policy(RtRole role, const char* name);
 
     /* ── FARGAN vocoder (opaque void* to avoid C header in .h) ────────────── */
     void*         fargan_   = nullptr;
 
-    /* ── Hilbert transform (127-tap FIR) ──────────────────────────────────── */
-    static constexpr int HILBERT_NTAPS = 127;
-    static constexpr int HILBERT_DELAY = (HILBERT_NTAPS - 1) / 2;  /* 63 */
-    float hilbert_coeffs_[HILBERT_NTAPS] = {};
-    float hilbert_hist_[HILBERT_NTAPS]   = {};   // history for FIR
-    int   hilbert_pos_                   = 0;    // write position in history
+    /* ── Hilbert transform (127-tap FIR, real → IQ) ───────────────────────── */
+    rade_hilbert  hilbert_;
+
+    /* ── Features from the DSP thread to the synthesis thread ─────────────── */
+    struct FeatFrame {
+        enum Kind : uint32_t { FEATURES, LOST_SYNC, NO_OUTPUT };
+        uint32_t kind  = FEATURES;
+        bool     first = false;    // first/last feature frame of its modem frame
+        bool     last  = false;
+        uint64_t mf    = 0;        // modem frame number
+        uint64_t t_in  = 0;        // when the modem frame was read (ns), 0 in file mode
+        double   in_s  = 0.0;      // age of its first sample at t_in
+        float    feat[36] = {};    // NB_TOTAL_FEATURES
+    };
+    static constexpr size_t FEAT_RING_FRAMES = 256;   // ~2.5 s of speech
+    SpscRing<FeatFrame>     feat_ring_;
+    bool                    lost_pending_ = false;   // LOST_SYNC not yet queued
+    bool                    send_lost_sync(FeatFrame ff);
 
-    /* ── FARGAN warmup state ──────────────────────────────────────────────── */
+    /* ── FARGAN warmup state (synthesis thread) ─────────────────────────── */
     static constexpr int NB_TOTAL_FEAT = 36;
     bool  fargan_ready_    = false;
     int   warmup_count_    = 0;
     float warmup_buf_[5 * 36] = {};   // 5 frames × NB_TOTAL_FEATURES
 
-    /* ── Resampler state (input) ──────────────────────────────────────────── */
-    double resamp_in_frac_ = 0.0;   // fractional sample position for input resampler
-    float  resamp_in_prev_ = 0.0f;  // previous input sample for linear interpolation
+    /* ── FARGAN snapshot for warm resume (low latency mode, synthesis thread) */
+    void*    fargan_snap_   = nullptr;   // FARGANState, as fargan_
+    bool     snap_valid_    = false;
+    uint64_t lost_mf_       = 0;         // modem frame sync was lost at
+    bool     low_latency_   = false;
 
-    /* ── Delay buffer for Hilbert real part ────────────────────────────────── */
-    float delay_buf_[HILBERT_NTAPS] = {};
-    int   delay_pos_                = 0;
+    /* ── Resamplers (capture rate → 8 kHz, 16 kHz → playback rate) ─────────── */
+    Resampler resamp_in_;
+    Resampler resamp_out_;
 
     /* ── FFT / spectrum ────────────────────────────────────────────────────── */
-    float              fft_window_[FFT_SIZE]      = {};
-    float              spectrum_mag_[SPECTRUM_BINS] = {};   // dB magnitudes
-    mutable std::mutex spectrum_mutex_;
+    rade_spectrum      spectrum_;              // DSP thread
+
+    /* ── Load shedding, DSP thread ───────────────────────────────────────── */
+    LoadGovernor       governor_;
+
+    /* ── Receiver options, applied to every receiver opened ─────────────── */
+    int                acq_threads_ = 1;
+    float              warm_s_      = 0.0f;
+    void               configure_rx(struct rade* r);
 
-    /* ── EOO callsign ───────────────────────────────────────────────────────── */
-    std::string        last_callsign_;
-    mutable std::mutex callsign_mutex_;
+    /* ── Telemetry: built by the DSP thread, or by open/close/seek while it
+       is stopped, and published once per modem frame ────────────────────── */
+    Telemetry                 tel_;
+    SnapshotBuffer<Telemetry> telemetry_;
+    void                      publish_telemetry(uint64_t mf);
+    void                      clear_telemetry();
+
+    /* ── Audio rings: capture → DSP (8 kHz float), DSP → playback (S16) ──── */
+    SpscRing<float>    in_ring_;
+    SpscRing<float>    out_ring_;
+    int                out_start_level_ = 0;   // samples buffered before playback starts
 
     /* ── Thread & atomics ─────────────────────────────────────────────────── */
-    std::thread        thread_;
+    std::thread        capture_thread_;
+    std::thread        thread_;                // DSP, or network in remote mode
+    std::thread        synth_thread_;          // FARGAN
+    std::thread        playback_thread_;
+    std::atomic<unsigned> capture_overruns_   {0};
+    std::atomic<unsigned> playback_underruns_ {0};
     std::atomic<bool>  running_     {false};
     std::atomic<bool>  synced_      {false};
     std::atomic<float> snr_dB_      {0.0f};
@@ -104,8 +344,29 @@ private:
     std::atomic<float> input_level_ {0.0f};
     std::atomic<float> output_level_{0.0f};
 
+    /* ── Latency: device queues (written by capture/playback), total ─── */
+    std::atomic<long>  in_dev_delay_  {0};   // frames at rate_in_
+    std::atomic<long>  out_dev_delay_ {0};   // frames at rate_out_
+    std::atomic<float> latency_ms_    {0.0f};
+    rade_hist          latency_hist_;        // synthesis thread
+
+    /* ── Stage timers, each written by one thread only ─────────────────── */
+    enum { ST_RESAMPLE_IN,         // capture thread
+           ST_HILBERT, ST_RADE_RX, // DSP thread
+           ST_FARGAN, ST_RESAMPLE_OUT,   // synthesis thread
+           ST_AUDIO_WRITE,         // playback thread
+                                   // (in file mode ST_RESAMPLE_IN is the DSP thread)
+           N_APP_STAGES };
+    rade_hist           stage_hist_[N_APP_STAGES];
+
     /* ── File playback mode ────────────────────────────────────────────── */
-    bool                file_mode_      = false;
-    std::vector<float>  file_audio_8k_;          // pre-loaded 8 kHz mono audio
-    size_t              file_pos_       = 0;      // read position in file_audio_8k_
+    static constexpr int FILE_CHUNK = 4096;      // frames per WAV read
+    bool                 file_mode_      = false;
+    rade_wav_reader      file_{};                    // WAV, positioned at the next sample
+    std::vector<float>   file_mono_;                 // one chunk mixed to mono
+    std::vector<float>   file_8k_;                   // resampled, waiting for rade_rx()
+    size_t               file_8k_len_    = 0;
+    std::atomic<bool>    dsp_eof_        {false};    // DSP reached end of file
+    std::atomic<bool>    file_eof_       {false};    // ... and it has all been synthesised
+    std::vector<Over>    overs_;                     // from scan_file()
 };
@@ -34,50 +34,32 @@
 */
 
 #include "rade_dsp.h"
+#include "rade_kernels.h"
 #include <string.h>
 
 /*---------------------------------------------------------------------------*\
                            VECTOR OPERATIONS
 \*---------------------------------------------------------------------------*/
 
+/* These go through the SIMD kernels (rade_kernels.h) selected for this CPU */
+
 /* Complex dot product: sum(conj(a[i]) * b[i]) */
 RADE_COMP rade_cdot(const RADE_COMP *a, const RADE_COMP *b, int n) {
-    RADE_COMP result = rade_czero();
-    for (int i = 0; i < n; i++) {
-        /* result += conj(a[i]) * b[i] */
-        result.real += a[i].real * b[i].real + a[i].imag * b[i].imag;
-        result.imag += a[i].real * b[i].imag - a[i].imag * b[i].real;
-    }
-    return result;
+    return rade_kernels_get()->cdot(a, b, n, 1);
 }
 
 /* Complex matrix-vector multiply: y = A * x
    A is [rows x cols], x is [cols], y is [rows]
    Matrix A is stored row-major: A[row][col] = A[row*cols + col] */
 void rade_cmvmul(RADE_COMP *y, const RADE_COMP *A, const RADE_COMP *x, int rows, int cols) {
-    for (int r = 0; r < rows; r++) {
-        RADE_COMP sum = rade_czero();
-        const RADE_COMP *row = &A[r * cols];
-        for (int c = 0; c < cols; c++) {
-            sum = rade_cadd(sum, rade_cmul(row[c], x[c]));
-        }
-        y[r] = sum;
-    }
+    rade_kernels_get()->cmvmul(y, A, x, rows, cols);
 }
 
 /* Complex matrix-vector multiply with real matrix: y = A * x
    A is [rows x cols] (real), x is [cols] (complex), y is [rows] (complex)
    Matrix A is stored row-major */
 void rade_cmvmul_real(RADE_COMP *y, const float *A, const RADE_COMP *x, int rows, int cols) {
-    for (int r = 0; r < rows; r++) {
-        RADE_COMP sum = rade_czero();
-        const float *row = &A[r * cols];
-        for (int c = 0; c < cols; c++) {
-            sum.real += row[c] * x[c].real;
-            sum.imag += row[c] * x[c].imag;
-        }
-        y[r] = sum;
-    }
+    rade_kernels_get()->cmvmul_real(y, A, x, rows, cols);
 }
 
 /*---------------------------------------------------------------------------*\
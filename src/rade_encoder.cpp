@@ -1,89 +1,60 @@
 #include "rade_encoder.h"
 
-#include <complex>
 #include <cmath>
 #include <cstring>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 /* ── C headers from RADE / Opus (wrapped for C++ linkage) ────────────── */
 extern "C" {
 #include "rade_api.h"
 #include "rade_dsp.h"
+#include "rade_trace.h"
 #include "lpcnet.h"
 #include "cpu_support.h"
 }
 
 #include "EooCallsignDecoder.hpp"
+#include "alloc_check.h"
 
-/* ── streaming linear-interpolation resampler (same as rade_decoder.cpp) */
+/* ── trace events, next to the library's (see rade_trace.h) ─────────── */
 
-static int resample_linear_stream(const float* in, int n_in,
-                                  float* out, int max_out,
-                                  unsigned int rate_in, unsigned int rate_out,
-                                  double& frac, float& prev)
-{
-    if (rate_in == rate_out) {
-        int n = std::min(n_in, max_out);
-        std::memcpy(out, in, static_cast<size_t>(n) * sizeof(float));
-        if (n_in > 0) prev = in[n_in - 1];
-        return n;
-    }
-
-    double step = static_cast<double>(rate_in) / static_cast<double>(rate_out);
-    int n_out = 0;
-
-    while (n_out < max_out) {
-        int idx = static_cast<int>(frac);
-        if (idx >= n_in) break;
+static const int TR_AUDIO_READ   = rade_trace_register("audio_read");
+static const int TR_RESAMPLE_IN  = rade_trace_register("resample_in");
+static const int TR_FEATURES     = rade_trace_register("lpcnet_features");
+static const int TR_RADE_TX      = rade_trace_register("rade_tx");
+static const int TR_TX_BPF       = rade_trace_register("tx_bpf");
+static const int TR_RESAMPLE_OUT = rade_trace_register("resample_out");
+static const int TR_AUDIO_WRITE  = rade_trace_register("audio_write");
 
-        float f = static_cast<float>(frac - idx);
-        float s0 = (idx == 0) ? prev : in[idx - 1];
-        float s1 = in[idx];
-        out[n_out++] = s0 + f * (s1 - s0);
+/* ── telemetry ───────────────────────────────────────────────────────── */
 
-        frac += step;
-    }
-
-    if (n_in > 0) prev = in[n_in - 1];
-    frac -= n_in;
-
-    return n_out;
+void RadaeEncoder::get_spectrum(float* out, int n) const
+{
+    Telemetry t = telemetry_.read();
+    int count = std::min(n, SPECTRUM_BINS);
+    std::memcpy(out, t.spectrum, static_cast<size_t>(count) * sizeof(float));
 }
 
-/* ── in-place radix-2 FFT ────────────────────────────────────────────── */
-
-static void fft_radix2(std::complex<float>* x, int N)
+/* snapshot of this frame's status for the readers, the spectrum is
+   already in tel_ */
+void RadaeEncoder::publish_telemetry()
 {
-    for (int i = 1, j = 0; i < N; i++) {
-        int bit = N >> 1;
-        for (; j & bit; bit >>= 1) j ^= bit;
-        j ^= bit;
-        if (i < j) std::swap(x[i], x[j]);
-    }
-    for (int len = 2; len <= N; len <<= 1) {
-        float ang = -2.0f * static_cast<float>(M_PI) / len;
-        std::complex<float> wlen(std::cos(ang), std::sin(ang));
-        for (int i = 0; i < N; i += len) {
-            std::complex<float> w(1.0f, 0.0f);
-            for (int j = 0; j < len / 2; j++) {
-                auto u = x[i + j];
-                auto v = x[i + j + len / 2] * w;
-                x[i + j]           = u + v;
-                x[i + j + len / 2] = u - v;
-                w *= wlen;
-            }
-        }
-    }
-}
+    tel_.frame++;
+    tel_.input_level  = input_level_.load(std::memory_order_relaxed);
+    tel_.output_level = output_level_.load(std::memory_order_relaxed);
 
-/* ── get_spectrum (thread-safe read) ─────────────────────────────────── */
+    tel_.n_stages = std::min(n_stages(), static_cast<int>(Telemetry::MAX_STAGES));
+    for (int i = 0; i < tel_.n_stages; i++)
+        if (!stage_stats(i, &tel_.stages[i]))
+            tel_.stages[i] = rade_stage_stats{};
 
-void RadaeEncoder::get_spectrum(float* out, int n) const
-{
-    std::lock_guard<std::mutex> lock(spectrum_mutex_);
-    int count = std::min(n, SPECTRUM_BINS);
-    std::memcpy(out, spectrum_mag_, static_cast<size_t>(count) * sizeof(float));
+    tel_.capture_overruns   = capture_overruns_.load(std::memory_order_relaxed);
+    tel_.playback_underruns = playback_underruns_.load(std::memory_order_relaxed);
+
+    telemetry_.publish(tel_);
 }
 
 /* ── construction / destruction ──────────────────────────────────────── */
@@ -109,8 +80,64 @@ void RadaeEncoder::apply_callsign()
     rade_tx_set_eoo_bits(rade_, bits.data());
 }
 
+/* ── stage timers ────────────────────────────────────────────────────── */
+
+static const char* const kAppStageNames[] = {
+    "resample_in", "features", "rade_tx", "bpf", "resample_out", "audio_write"
+};
+static const int kRadeTxStages[] = {
+    RADE_STAGE_TX_ENCODER, RADE_STAGE_TX_MOD
+};
+static constexpr int N_RADE_TX_STAGES = sizeof(kRadeTxStages) / sizeof(kRadeTxStages[0]);
+
+int RadaeEncoder::n_stages() const
+{
+    return N_APP_STAGES + N_RADE_TX_STAGES;
+}
+
+const char* RadaeEncoder::stage_name(int i) const
+{
+    if (i < 0 || i >= n_stages()) return nullptr;
+    if (i < N_APP_STAGES) return kAppStageNames[i];
+    return rade_stage_name(kRadeTxStages[i - N_APP_STAGES]);
+}
+
+bool RadaeEncoder::stage_stats(int i, rade_stage_stats* st) const
+{
+    if (i < 0 || i >= n_stages()) return false;
+    if (i < N_APP_STAGES) {
+        rade_hist_read(&stage_hist_[i], st);
+        return true;
+    }
+    return rade_ && rade_get_stage_stats(rade_, kRadeTxStages[i - N_APP_STAGES], st) == 0;
+}
+
+/* ── thread and memory policy ────────────────────────────────────────── */
+
+void RadaeEncoder::apply_memory_policy()
+{
+    rt_denied_ = false;
+    if (rt_policy_.lock_memory && !rt_lock_memory())
+        rt_denied_ = true;
+    if (rt_policy_.lock_memory || rt_policy_.prefault)
+        rade_prefault(rade_);
+}
+
+/* first thing on each pipeline thread */
+void RadaeEncoder::apply_thread_policy(RtRole role, const char* name)
+{
+    if (!rt_apply_thread(rt_policy_, role, name))
+        rt_denied_ = true;
+}
+
 /* ── open / close ────────────────────────────────────────────────────── */
 
+/* rade_open() takes a non-const path, NULL for the built-in weights */
+char* RadaeEncoder::model_arg()
+{
+    return model_file_.empty() ? nullptr : &model_file_[0];
+}
+
 bool RadaeEncoder::open(const std::string& mic_hw_id,
                         const std::string& radio_hw_id)
 {
@@ -118,24 +145,25 @@ bool RadaeEncoder::open(const std::string& mic_hw_id,
 
     /* ── audio capture (mic, 16 kHz) ────────────────────────────────── */
     rate_in_ = RADE_FS_SPEECH;
-    if (!stream_in_.open(mic_hw_id, true, 1, rate_in_, 160))
+    if (!stream_in_.open(mic_hw_id, true, 1, rate_in_, 160, AUDIO_F32))
         return false;
 
     /* ── audio playback (radio, 8 kHz) ───────────────────────────────── */
     rate_out_ = RADE_FS;
-    if (!stream_out_.open(radio_hw_id, false, 1, rate_out_, 512)) {
+    if (!stream_out_.open(radio_hw_id, false, 1, rate_out_, 512, AUDIO_F32)) {
         stream_in_.close();
         return false;
     }
 
     /* ── RADE transmitter ────────────────────────────────────────────── */
     rade_initialize();
-    rade_ = rade_open(nullptr, RADE_VERBOSE_0);
+    rade_ = rade_open_tx_only(model_arg(), RADE_VERBOSE_0);
     if (!rade_) {
         stream_in_.close();
         stream_out_.close();
         return false;
     }
+    apply_memory_policy();
 
     /* ── EOO callsign ────────────────────────────────────────────────── */
     apply_callsign();
@@ -149,21 +177,21 @@ bool RadaeEncoder::open(const std::string& mic_hw_id,
         return false;
     }
 
-    /* ── Resampler state ─────────────────────────────────────────────── */
-    resamp_in_frac_  = 0.0;
-    resamp_in_prev_  = 0.0f;
-    resamp_out_frac_ = 0.0;
-    resamp_out_prev_ = 0.0f;
+    /* ── Resamplers ──────────────────────────────────────────────────── */
+    resamp_in_.init(rate_in_, RADE_FS_SPEECH);
+    resamp_out_.init(RADE_FS, rate_out_);
 
     /* ── TX output bandpass filter (700–2300 Hz) ─────────────────────── */
     int n_eoo = rade_n_tx_eoo_out(rade_);
     rade_bpf_init(&bpf_, RADE_BPF_NTAP, static_cast<float>(RADE_FS),
-                  1600.0f, 1500.0f, n_eoo);
+                  1600.0f, 1500.0f, n_eoo, RADE_BPF_DIRECT);
 
-    /* ── FFT window (Hann) for TX output spectrum ────────────────────── */
-    for (int i = 0; i < FFT_SIZE; i++)
-        fft_window_[i] = 0.5f * (1.0f - std::cos(2.0f * static_cast<float>(M_PI)
-                                                   * i / (FFT_SIZE - 1)));
+    /* ── Hann windowed spectrum of the TX output ─────────────────────── */
+    rade_spectrum_init(&spectrum_, FFT_SIZE);
+    tel_ = Telemetry{};
+    telemetry_.publish(tel_);
+
+    for (auto& h : stage_hist_) rade_hist_init(&h);
 
     return true;
 }
@@ -187,8 +215,27 @@ void RadaeEncoder::close()
 void RadaeEncoder::start()
 {
     if (!stream_in_.is_open() || !stream_out_.is_open() || !rade_ || !lpcnet_ || running_) return;
+
+    /* ~1 s of audio each way; playback starts once one modem frame is
+       buffered so the 120 ms bursts from the DSP thread play smoothly */
+    in_ring_.reset(RADE_FS_SPEECH);
+    out_ring_.reset(rate_out_);
+    out_start_level_ = rade_n_tx_out(rade_) * static_cast<int>(rate_out_) / RADE_FS;
+    if (tx_pipeline_)
+        feat_ring_.reset(FEAT_RING_FRAMES * NB_TOTAL_FEAT);
+    capture_overruns_   = 0;
+    playback_underruns_ = 0;
+    dsp_done_           = false;
+    tel_.frame          = 0;
+    tel_.audio_ns       = 0;
+    tel_.busy_ns        = 0;
+
     running_ = true;
-    thread_  = std::thread(&RadaeEncoder::processing_loop, this);
+    capture_thread_  = std::thread([this] { apply_thread_policy(RT_IO,  "rade-tx-capture"); capture_loop(); });
+    if (tx_pipeline_)
+        features_thread_ = std::thread([this] { apply_thread_policy(RT_DSP, "rade-tx-feat"); features_loop(); });
+    thread_          = std::thread([this] { apply_thread_policy(RT_DSP, "rade-tx-dsp");     processing_loop(); });
+    playback_thread_ = std::thread([this] { apply_thread_policy(RT_IO,  "rade-tx-play");    playback_loop(); });
 }
 
 void RadaeEncoder::stop()
@@ -196,25 +243,39 @@ void RadaeEncoder::stop()
     if (!running_) return;
     running_ = false;
 
-    if (thread_.joinable()) thread_.join();
+    /* the DSP thread queues the EOO frame on exit, playback drains it */
+    if (capture_thread_.joinable())  capture_thread_.join();
+    if (features_thread_.joinable()) features_thread_.join();
+    if (thread_.joinable())          thread_.join();
+    if (playback_thread_.joinable()) playback_thread_.join();
 
     input_level_  = 0.0f;
     output_level_ = 0.0f;
 }
 
-/* ── helper: write IQ real part to audio output ──────────────────────── */
+/* ── helper: queue IQ real part for audio output ─────────────────────── */
 
-static void write_real_to_output(AudioStream& stream, const RADE_COMP* iq, int n_iq,
-                                  unsigned int rate_modem, unsigned int rate_out,
-                                  double& resamp_frac, float& resamp_prev,
+/* Scratch buffers for write_real_to_output(), sized once for the largest
+   (EOO) frame so the processing loop never allocates */
+struct TxOutScratch {
+    std::vector<float> real_8k;
+    std::vector<float> out_f;
+
+    TxOutScratch(int n_iq_max, const Resampler& resamp)
+    {
+        int out_max = resamp.max_output(n_iq_max);
+        real_8k.resize(static_cast<size_t>(n_iq_max));
+        out_f.resize(static_cast<size_t>(out_max));
+    }
+};
+
+static void write_real_to_output(SpscRing<float>& ring, const RADE_COMP* iq, int n_iq,
+                                  Resampler& resamp,
                                   std::atomic<float>& output_level,
-                                  const std::atomic<bool>& running,
-                                  float tx_scale)
+                                  float tx_scale, TxOutScratch& scratch)
 {
-    (void)running;
-
     /* convert IQ → real float and compute RMS */
-    std::vector<float> real_8k(static_cast<size_t>(n_iq));
+    std::vector<float>& real_8k = scratch.real_8k;
     double rms_sum = 0.0;
     for (int i = 0; i < n_iq; i++) {
         real_8k[static_cast<size_t>(i)] = iq[i].real;
@@ -224,26 +285,190 @@ static void write_real_to_output(AudioStream& stream, const RADE_COMP* iq, int n
                        std::memory_order_relaxed);
 
     /* resample 8 kHz → output device rate */
-    int out_max = n_iq * static_cast<int>(rate_out) / static_cast<int>(rate_modem) + 4;
-    std::vector<float> out_f(static_cast<size_t>(out_max));
-    int n_resamp = resample_linear_stream(
-        real_8k.data(), n_iq,
-        out_f.data(), out_max,
-        rate_modem, rate_out,
-        resamp_frac, resamp_prev);
-
-    /* float → S16 with caller-supplied scale */
-    std::vector<int16_t> out_pcm(static_cast<size_t>(n_resamp));
+    int out_max = static_cast<int>(scratch.out_f.size());
+    std::vector<float>& out_f = scratch.out_f;
+    int n_resamp = resamp.process(real_8k.data(), n_iq, out_f.data(), out_max);
+
+    /* caller-supplied scale, which is in S16 units, clipped to float full scale */
+    float gain = tx_scale / 32768.0f;
     for (int s = 0; s < n_resamp; s++) {
-        float v = out_f[static_cast<size_t>(s)] * tx_scale;
+        float& v = out_f[static_cast<size_t>(s)];
+        v = std::max(-1.0f, std::min(1.0f, v * gain));
+    }
+
+    /* hand to the playback thread; dropped if it has stalled */
+    ring.write(out_f.data(), static_cast<size_t>(n_resamp));
+}
+
+/* ── capture loop (dedicated thread) ─────────────────────────────────
+ *
+ *  Reads the mic, applies gain, resamples to 16 kHz and pushes into
+ *  in_ring_.  If the DSP thread falls a full ring behind the block is
+ *  dropped and counted as an overrun.
+ * ──────────────────────────────────────────────────────────────────── */
+
+void RadaeEncoder::capture_loop()
+{
+    /* capture read buffer */
+    constexpr int READ_FRAMES = 160;
+    std::vector<float> f_in(READ_FRAMES);
+
+    /* temporary buffer for resampled input */
+    int resamp_out_max = resamp_in_.max_output(READ_FRAMES);
+    std::vector<float> resamp_tmp(static_cast<size_t>(resamp_out_max));
+
+    alloc_check_begin();
+    while (running_.load(std::memory_order_relaxed)) {
+        uint64_t tt = rade_trace_begin();
+        AudioError err = stream_in_.read(f_in.data(), READ_FRAMES);
+        rade_trace_end(TR_AUDIO_READ, tt);
+        if (err == AUDIO_ERROR)
+            continue;
+        if (err == AUDIO_OVERFLOW)
+            capture_overruns_.fetch_add(1, std::memory_order_relaxed);
+
+        /* apply mic gain */
+        float gain = mic_gain_.load(std::memory_order_relaxed);
+        for (int i = 0; i < READ_FRAMES; i++)
+            f_in[static_cast<size_t>(i)] *= gain;
+
+        /* resample to 16 kHz if needed */
+        uint64_t t0 = rade_time_ns();
+        int got = resamp_in_.process(f_in.data(), READ_FRAMES,
+                                     resamp_tmp.data(), resamp_out_max);
+        uint64_t t1 = rade_time_ns();
+        rade_hist_add(&stage_hist_[ST_RESAMPLE_IN], t1 - t0);
+        rade_trace_span(TR_RESAMPLE_IN, t0, t1);
+
+        if (in_ring_.write(resamp_tmp.data(), static_cast<size_t>(got))
+                < static_cast<size_t>(got))
+            capture_overruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    alloc_check_end("RadaeEncoder::capture_loop");
+}
+
+/* ── playback loop (dedicated thread) ────────────────────────────────
+ *
+ *  Keeps the radio output fed from out_ring_, padding with silence when
+ *  it runs dry.  Runs until the DSP thread has queued the EOO frame and
+ *  it has all been written, then drains the device.
+ * ──────────────────────────────────────────────────────────────────── */
+
+void RadaeEncoder::playback_loop()
+{
+    constexpr int WRITE_FRAMES = 256;
+    float buf[WRITE_FRAMES];
+    bool  playing = false;
+
+    alloc_check_begin();
+    while (true) {
+        bool   done  = dsp_done_.load(std::memory_order_acquire);
+        size_t avail = out_ring_.size();
+
+        if (done && avail == 0) break;
+        if (!playing && (avail >= static_cast<size_t>(out_start_level_) || done))
+            playing = true;
+
+        size_t n = 0;
+        if (playing) {
+            n = out_ring_.read(buf, WRITE_FRAMES);
+            if (n < static_cast<size_t>(WRITE_FRAMES)) {
+                if (!done)
+                    playback_underruns_.fetch_add(1, std::memory_order_relaxed);
+                playing = false;
+            }
+        }
+        std::memset(buf + n, 0, (WRITE_FRAMES - n) * sizeof(float));
+
+        uint64_t t0 = rade_time_ns();
+        stream_out_.write(buf, WRITE_FRAMES);
+        uint64_t t1 = rade_time_ns();
+        rade_hist_add(&stage_hist_[ST_AUDIO_WRITE], t1 - t0);
+        rade_trace_span(TR_AUDIO_WRITE, t0, t1);
+    }
+    alloc_check_end("RadaeEncoder::playback_loop");
+
+    /* drain the output buffer */
+    stream_out_.stop();
+    stream_out_.start();
+}
+
+/* ── LPCNet features of one 10 ms frame ──────────────────────────────
+ *
+ *  Updates the input level, returns the LPCNet time (ns).  Runs on the
+ *  DSP thread, or the features thread in pipeline mode.
+ * ──────────────────────────────────────────────────────────────────── */
+
+uint64_t RadaeEncoder::extract_features(const float* frame_16k, float* features, int arch)
+{
+    /* input RMS level (of this 10 ms frame) */
+    {
+        double sum2 = 0.0;
+        for (int i = 0; i < LPCNET_FRAME_SIZE; i++) {
+            float s = frame_16k[i];
+            sum2 += static_cast<double>(s) * s;
+        }
+        input_level_.store(std::sqrt(static_cast<float>(sum2 / LPCNET_FRAME_SIZE)),
+                           std::memory_order_relaxed);
+    }
+
+    /* convert float → int16 for LPCNet */
+    int16_t pcm_frame[LPCNET_FRAME_SIZE];
+    for (int i = 0; i < LPCNET_FRAME_SIZE; i++) {
+        float v = frame_16k[i] * 32768.0f;
         if (v >  32767.0f) v =  32767.0f;
         if (v < -32767.0f) v = -32767.0f;
-        out_pcm[static_cast<size_t>(s)] = static_cast<int16_t>(v);
+        pcm_frame[i] = static_cast<int16_t>(v);
     }
 
-    /* write to audio output */
-    stream.write(out_pcm.data(),
-                 static_cast<unsigned long>(n_resamp));
+    /* extract features */
+    uint64_t t0 = rade_time_ns();
+    lpcnet_compute_single_frame_features(lpcnet_, pcm_frame, features, arch);
+    uint64_t t1 = rade_time_ns();
+    rade_trace_span(TR_FEATURES, t0, t1);
+    return t1 - t0;
+}
+
+/* ── features loop (dedicated thread, pipeline mode) ─────────────────
+ *
+ *  Turns each 10 ms of 16 kHz audio from in_ring_ into a feature frame
+ *  for the DSP thread as soon as it arrives.  Frames are only queued
+ *  whole, if the DSP thread falls a full ring behind the frame is
+ *  dropped and counted as an overrun.
+ * ──────────────────────────────────────────────────────────────────── */
+
+void RadaeEncoder::features_loop()
+{
+    static_assert(NB_TOTAL_FEAT == NB_TOTAL_FEATURES, "feature frame size");
+    int arch = opus_select_arch();
+    int frames_per_modem = rade_n_features_in_out(rade_) / NB_TOTAL_FEATURES;   /* 12 */
+
+    float frame_16k[LPCNET_FRAME_SIZE];
+    float frame_features[NB_TOTAL_FEATURES];
+    int      feat_count = 0;
+    uint64_t t_features = 0;   /* summed over the modem frame, as the DSP thread does */
+
+    alloc_check_begin();
+    while (running_.load(std::memory_order_relaxed)) {
+        if (in_ring_.size() < static_cast<size_t>(LPCNET_FRAME_SIZE)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        in_ring_.read(frame_16k, LPCNET_FRAME_SIZE);
+
+        t_features += extract_features(frame_16k, frame_features, arch);
+        if (++feat_count >= frames_per_modem) {
+            rade_hist_add(&stage_hist_[ST_FEATURES], t_features);
+            t_features = 0;
+            feat_count = 0;
+        }
+
+        if (feat_ring_.space() < static_cast<size_t>(NB_TOTAL_FEATURES))
+            capture_overruns_.fetch_add(1, std::memory_order_relaxed);
+        else
+            feat_ring_.write(frame_features, NB_TOTAL_FEATURES);
+    }
+    alloc_check_end("RadaeEncoder::features_loop");
 }
 
 /* ── processing loop (dedicated thread) ──────────────────────────────── */
@@ -253,6 +478,7 @@ void RadaeEncoder::processing_loop()
     int arch = opus_select_arch();
 
     int n_features_in = rade_n_features_in_out(rade_);   /* 432 */
+    int n_stride      = rade_n_features_in_stride(rade_); /* 144 */
     int n_tx_out      = rade_n_tx_out(rade_);            /* 960 */
     int n_eoo_out     = rade_n_tx_eoo_out(rade_);        /* 1152 */
 
@@ -263,153 +489,110 @@ void RadaeEncoder::processing_loop()
     std::vector<float>     features(static_cast<size_t>(n_features_in));
     std::vector<RADE_COMP> tx_out(static_cast<size_t>(n_tx_out));
     std::vector<RADE_COMP> eoo_out(static_cast<size_t>(n_eoo_out));
+    TxOutScratch           out_scratch(std::max(n_tx_out, n_eoo_out), resamp_out_);
 
     int feat_count = 0;   /* how many feature frames accumulated */
+    uint64_t t_features = 0;   /* feature extraction time for this modem frame */
+    uint64_t t_tx = 0;         /* rade_tx_stride() time for this modem frame */
 
-    /* capture read buffer */
-    constexpr int READ_FRAMES = 160;
-    std::vector<int16_t> capture_buf(READ_FRAMES);
-
-    /* accumulator for 16 kHz mono float samples */
-    std::vector<float> acc_16k;
-    acc_16k.reserve(1024);
-
-    /* temporary buffer for resampled input */
-    int resamp_out_max = READ_FRAMES + 2;
-    std::vector<float> resamp_tmp(static_cast<size_t>(resamp_out_max));
-
-    /* ── Pre-fill output buffer with silence so the PortAudio playback buffer
-     *    has enough headroom to survive the ~120 ms gap between modem frame
-     *    writes (each modem frame requires accumulating 12 feature frames
-     *    of mic input before any output is produced). ──────────────────── */
-    {
-        const int prefill_frames = 2 * n_tx_out;              /* 2 modem frames */
-        int prefill_out = prefill_frames
-            * static_cast<int>(rate_out_) / static_cast<int>(RADE_FS);
-        std::vector<int16_t> silence(static_cast<size_t>(prefill_out), 0);
-        stream_out_.write(silence.data(),
-                          static_cast<unsigned long>(prefill_out));
-    }
+    /* one 10 ms frame of 16 kHz mono float samples */
+    float frame_16k[LPCNET_FRAME_SIZE];
 
+    alloc_check_begin();
     while (running_.load(std::memory_order_relaxed)) {
+        int      n_out = 0;
+        uint64_t t0, t1;
 
-        /* ── accumulate at least LPCNET_FRAME_SIZE (160) samples at 16 kHz ── */
-        while (static_cast<int>(acc_16k.size()) < LPCNET_FRAME_SIZE &&
-               running_.load(std::memory_order_relaxed))
-        {
-            AudioError err = stream_in_.read(capture_buf.data(), READ_FRAMES);
-            if (err == AUDIO_ERROR) {
-                if (!running_.load(std::memory_order_relaxed)) break;
+        if (tx_pipeline_) {
+            /* ── pipeline mode: encode each stride as it arrives ─────── */
+            if (feat_ring_.size() < static_cast<size_t>(n_stride)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
                 continue;
             }
-
-            int n = READ_FRAMES;
-
-            /* convert S16 → float, apply mic gain */
-            float gain = mic_gain_.load(std::memory_order_relaxed);
-            std::vector<float> f_in(static_cast<size_t>(n));
-            for (int i = 0; i < n; i++)
-                f_in[static_cast<size_t>(i)] = capture_buf[static_cast<size_t>(i)] / 32768.0f * gain;
-
-            /* resample to 16 kHz if needed */
-            int got = resample_linear_stream(
-                f_in.data(), n,
-                resamp_tmp.data(), resamp_out_max,
-                rate_in_, RADE_FS_SPEECH,
-                resamp_in_frac_, resamp_in_prev_);
-
-            acc_16k.insert(acc_16k.end(), resamp_tmp.begin(),
-                           resamp_tmp.begin() + got);
-        }
-
-        if (!running_.load(std::memory_order_relaxed)) break;
-
-        /* ── process complete 160-sample frames ──────────────────────────── */
-        while (static_cast<int>(acc_16k.size()) >= LPCNET_FRAME_SIZE) {
-
-            /* input RMS level (of this 10 ms frame) */
-            {
-                double sum2 = 0.0;
-                for (int i = 0; i < LPCNET_FRAME_SIZE; i++) {
-                    float s = acc_16k[static_cast<size_t>(i)];
-                    sum2 += static_cast<double>(s) * s;
-                }
-                input_level_.store(std::sqrt(static_cast<float>(sum2 / LPCNET_FRAME_SIZE)),
-                                   std::memory_order_relaxed);
+            feat_ring_.read(features.data(), static_cast<size_t>(n_stride));
+
+            t0 = rade_time_ns();
+            n_out = rade_tx_stride(rade_, tx_out.data(), features.data());
+            t1 = rade_time_ns();
+            rade_trace_span(TR_RADE_TX, t0, t1);
+            t_tx += t1 - t0;
+            tel_.busy_ns += t1 - t0;
+            if (n_out == 0) continue;
+
+            rade_hist_add(&stage_hist_[ST_RADE_TX], t_tx);
+            t_tx = 0;
+        } else {
+            /* ── wait for LPCNET_FRAME_SIZE (160) samples at 16 kHz ───── */
+            if (in_ring_.size() < static_cast<size_t>(LPCNET_FRAME_SIZE)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                continue;
             }
+            in_ring_.read(frame_16k, LPCNET_FRAME_SIZE);
 
-            /* convert float → int16 for LPCNet */
-            int16_t pcm_frame[LPCNET_FRAME_SIZE];
-            for (int i = 0; i < LPCNET_FRAME_SIZE; i++) {
-                float v = acc_16k[static_cast<size_t>(i)] * 32768.0f;
-                if (v >  32767.0f) v =  32767.0f;
-                if (v < -32767.0f) v = -32767.0f;
-                pcm_frame[i] = static_cast<int16_t>(v);
-            }
+            /* append to modem frame feature buffer */
+            uint64_t t_frame = extract_features(
+                frame_16k, &features[static_cast<size_t>(feat_count * NB_TOTAL_FEATURES)], arch);
+            t_features   += t_frame;
+            tel_.busy_ns += t_frame;
+            if (++feat_count < frames_per_modem) continue;
+            feat_count = 0;
+
+            rade_hist_add(&stage_hist_[ST_FEATURES], t_features);
+            t_features = 0;
+
+            /* ── full modem frame: encode ────────────────────────────── */
+            t0 = rade_time_ns();
+            n_out = rade_tx(rade_, tx_out.data(), features.data());
+            t1 = rade_time_ns();
+            rade_trace_span(TR_RADE_TX, t0, t1);
+            rade_hist_add(&stage_hist_[ST_RADE_TX], t1 - t0);
+            tel_.busy_ns += t1 - t0;
+        }
 
-            /* extract features */
-            float frame_features[NB_TOTAL_FEATURES];
-            lpcnet_compute_single_frame_features(lpcnet_, pcm_frame,
-                                                  frame_features, arch);
+        /* ── output ──────────────────────────────────────────────────── */
+        if (bpf_enabled_.load(std::memory_order_relaxed)) {
+            rade_bpf_process(&bpf_, tx_out.data(), tx_out.data(), n_out);
+            uint64_t tb = rade_time_ns();
+            rade_hist_add(&stage_hist_[ST_BPF], tb - t1);
+            rade_trace_span(TR_TX_BPF, t1, tb);
+        }
 
-            /* append to modem frame feature buffer */
-            std::memcpy(&features[static_cast<size_t>(feat_count * NB_TOTAL_FEATURES)],
-                        frame_features,
-                        static_cast<size_t>(NB_TOTAL_FEATURES) * sizeof(float));
-            feat_count++;
-
-            /* consume 160 samples */
-            acc_16k.erase(acc_16k.begin(),
-                          acc_16k.begin() + LPCNET_FRAME_SIZE);
-
-            /* ── full modem frame: encode and output ─────────────────────── */
-            if (feat_count >= frames_per_modem) {
-                int n_out = rade_tx(rade_, tx_out.data(), features.data());
-                if (bpf_enabled_.load(std::memory_order_relaxed))
-                    rade_bpf_process(&bpf_, tx_out.data(), tx_out.data(), n_out);
-
-                /* FFT spectrum of TX output (real part, last FFT_SIZE samples) */
-                if (n_out >= FFT_SIZE) {
-                    std::complex<float> fft_buf[FFT_SIZE];
-                    int off = n_out - FFT_SIZE;
-                    for (int i = 0; i < FFT_SIZE; i++)
-                        fft_buf[i] = tx_out[static_cast<size_t>(off + i)].real
-                                     * fft_window_[i];
-                    fft_radix2(fft_buf, FFT_SIZE);
-                    float tmp[SPECTRUM_BINS];
-                    for (int i = 0; i < SPECTRUM_BINS; i++) {
-                        float mag = std::abs(fft_buf[i]) / (FFT_SIZE * 0.5f);
-                        tmp[i] = (mag > 1e-10f)
-                               ? 20.0f * std::log10(mag) : -200.0f;
-                    }
-                    {
-                        std::lock_guard<std::mutex> lock(spectrum_mutex_);
-                        std::memcpy(spectrum_mag_, tmp, sizeof(spectrum_mag_));
-                    }
-                }
-
-                write_real_to_output(stream_out_, tx_out.data(), n_out,
-                                     RADE_FS, rate_out_,
-                                     resamp_out_frac_, resamp_out_prev_,
-                                     output_level_, running_,
-                                     tx_scale_.load(std::memory_order_relaxed));
-                feat_count = 0;
-            }
+        /* FFT spectrum of TX output (real part, last FFT_SIZE samples) */
+        if (n_out >= FFT_SIZE) {
+            float real[FFT_SIZE];
+            int off = n_out - FFT_SIZE;
+            for (int i = 0; i < FFT_SIZE; i++)
+                real[i] = tx_out[static_cast<size_t>(off + i)].real;
+            rade_spectrum_db(&spectrum_, tel_.spectrum, real);
+            tel_.spectrum_frame = tel_.frame + 1;
         }
+
+        t0 = rade_time_ns();
+        write_real_to_output(out_ring_, tx_out.data(), n_out,
+                             resamp_out_,
+                             output_level_,
+                             tx_scale_.load(std::memory_order_relaxed),
+                             out_scratch);
+        uint64_t t2 = rade_time_ns();
+        rade_hist_add(&stage_hist_[ST_RESAMPLE_OUT], t2 - t0);
+        rade_trace_span(TR_RESAMPLE_OUT, t0, t2);
+        tel_.busy_ns  += t2 - t1;
+        tel_.audio_ns += static_cast<uint64_t>(n_out) * (1000000000ull / RADE_FS);
+
+        publish_telemetry();
     }
+    alloc_check_end("RadaeEncoder::processing_loop");
 
-    /* ── send end-of-over frame ──────────────────────────────────────── */
+    /* ── queue end-of-over frame ─────────────────────────────────────── */
     if (rade_ && stream_out_.is_open()) {
         int n_out = rade_tx_eoo(rade_, eoo_out.data());
         if (bpf_enabled_.load(std::memory_order_relaxed))
             rade_bpf_process(&bpf_, eoo_out.data(), eoo_out.data(), n_out);
-        write_real_to_output(stream_out_, eoo_out.data(), n_out,
-                             RADE_FS, rate_out_,
-                             resamp_out_frac_, resamp_out_prev_,
-                             output_level_, running_,
-                             tx_scale_.load(std::memory_order_relaxed));
-        /* drain the output buffer */
-        stream_out_.stop();
-        stream_out_.start();
+        write_real_to_output(out_ring_, eoo_out.data(), n_out,
+                             resamp_out_,
+                             output_level_,
+                             tx_scale_.load(std::memory_order_relaxed),
+                             out_scratch);
     }
+    dsp_done_.store(true, std::memory_order_release);
 }
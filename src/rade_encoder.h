@@ -2,9 +2,12 @@
 
 #include <string>
 #include <atomic>
-#include <mutex>
 #include <thread>
 #include "audio_stream.h"
+#include "spsc_ring.h"
+#include "resampler.h"
+#include "rt_policy.h"
+#include "telemetry.h"
 
 /* Forward declarations — avoids exposing C headers in this header */
 struct rade;
@@ -12,14 +15,24 @@ struct LPCNetEncState;
 
 extern "C" {
 #include "rade_bpf.h"
+#include "rade_spectrum.h"
+#include "rade_stats.h"
 }
 
 /* ── RadaeEncoder ──────────────────────────────────────────────────────────
  *
  *  Real-time RADAE encoder pipeline:
- *    PortAudio capture (mic 16 kHz) → LPCNet features → RADE Tx → real → PortAudio playback (radio 8 kHz)
+ *    PortAudio capture (mic 16 kHz) → [ring] → LPCNet features → RADE Tx → real
+ *      → [ring] → PortAudio playback (radio 8 kHz)
  *
- *  All processing runs on a dedicated thread.  Status is exposed via atomics.
+ *  Capture, DSP and playback each run on their own thread, connected by
+ *  lock-free SPSC rings.  Status is exposed via atomics.
+ *
+ *  In TX pipeline mode LPCNet feature extraction gets a thread of its own,
+ *  feeding the DSP thread through a third ring, and the DSP thread runs the
+ *  neural encoder on each 40 ms stride as soon as it is ready
+ *  (rade_tx_stride()).  Only the last stride's encode and the OFDM mod are
+ *  left when a modem frame completes, and the CPU load is spread out.
  * ──────────────────────────────────────────────────────────────────────── */
 
 class RadaeEncoder {
@@ -33,6 +46,24 @@ public:
     void start();
     void stop();
 
+    /* weights blob passed to rade_open(), "" for the built-in weights (call
+       before open()) */
+    void set_model_file(const std::string& path) { model_file_ = path; }
+
+    /* audio device period, buffer and transfer mode, see AudioTuning (call
+       before open()) */
+    void set_audio_tuning(const AudioTuning& t) { stream_in_.set_tuning(t); stream_out_.set_tuning(t); }
+
+    /* scheduling, CPU affinity and memory locking for the pipeline threads,
+       see RtPolicy (call before open()).  rt_denied() is set if the system
+       refused any of it, the pipeline runs on without */
+    void set_rt_policy(const RtPolicy& p) { rt_policy_ = p; }
+    bool rt_denied() const { return rt_denied_.load(std::memory_order_relaxed); }
+
+    /* TX pipeline mode, see above (call before start()) */
+    void set_tx_pipeline(bool en) { tx_pipeline_ = en; }
+    bool get_tx_pipeline() const  { return tx_pipeline_; }
+
     /* status queries (thread-safe) ------------------------------------------ */
     bool  is_running()       const { return running_.load(std::memory_order_relaxed); }
     float get_input_level()  const { return input_level_.load(std::memory_order_relaxed); }
@@ -51,15 +82,38 @@ public:
     /* EOO callsign (applied to rade_ immediately if open, stored for next open()) */
     void set_callsign(const std::string& cs);
 
-    /* spectrum of TX output (thread-safe via mutex) ------------------------- */
+    /* spectrum of TX output (thread-safe, lock-free) ------------------------ */
     static constexpr int FFT_SIZE      = 512;
     static constexpr int SPECTRUM_BINS = FFT_SIZE / 2;   // 256
+    static_assert(SPECTRUM_BINS == Telemetry::SPECTRUM_BINS, "telemetry spectrum size");
 
     void  get_spectrum(float* out, int n) const;
     float spectrum_sample_rate() const { return 8000.f; }
 
+    /* levels, spectrum and stage timers as one snapshot, published by the
+       DSP thread once per modem frame (thread-safe, never blocks the DSP) */
+    Telemetry telemetry() const { return telemetry_.read(); }
+
+    /* audio buffering (thread-safe) ----------------------------------------- */
+    float    input_fill()         const { return in_ring_.fill(); }    // 0..1
+    float    output_fill()        const { return out_ring_.fill(); }   // 0..1
+    unsigned capture_overruns()   const { return capture_overruns_.load(std::memory_order_relaxed); }
+    unsigned playback_underruns() const { return playback_underruns_.load(std::memory_order_relaxed); }
+
+    /* stage timers (thread-safe, never blocks the DSP) ---------------------- */
+    /* Stages are this pipeline's own (resample, LPCNet features, BPF, audio
+       write, ...) followed by the RADE Tx internals from
+       rade_get_stage_stats().  Times accumulate from open(). */
+    int         n_stages() const;
+    const char* stage_name(int i) const;
+    bool        stage_stats(int i, rade_stage_stats* st) const;
+
 private:
+    void capture_loop();
+    void features_loop();
     void processing_loop();
+    void playback_loop();
+    uint64_t extract_features(const float* frame_16k, float* features, int arch);
 
     /* ── audio stream handles ────────────────────────────────────────────── */
     AudioStream  stream_in_;     // capture (mic)
@@ -69,18 +123,39 @@ private:
 
     /* ── RADE transmitter (opaque) ────────────────────────────────────────── */
     struct rade*        rade_    = nullptr;
+    std::string         model_file_;
+    char*               model_arg();
+
+    /* ── thread and memory policy ─────────────────────────────────────────── */
+    RtPolicy            rt_policy_;
+    std::atomic<bool>   rt_denied_ {false};
+    void                apply_memory_policy();            // after rade_open()
+    void                apply_thread_policy(RtRole role, const char* name);
     LPCNetEncState*     lpcnet_  = nullptr;
 
-    /* ── Resampler state (capture rate → 16 kHz) ─────────────────────────── */
-    double resamp_in_frac_  = 0.0;
-    float  resamp_in_prev_  = 0.0f;
+    /* ── Resamplers (capture rate → 16 kHz, 8 kHz → playback rate) ───────── */
+    Resampler resamp_in_;
+    Resampler resamp_out_;
+
+    /* ── Audio rings: capture → DSP (16 kHz float), DSP → playback (S16) ─── */
+    SpscRing<float>    in_ring_;
+    SpscRing<float>    out_ring_;
+    int                out_start_level_ = 0;   // samples buffered before playback starts
 
-    /* ── Resampler state (8 kHz → playback rate) ─────────────────────────── */
-    double resamp_out_frac_ = 0.0;
-    float  resamp_out_prev_ = 0.0f;
+    /* ── Features from the features thread to the DSP thread (pipeline mode) */
+    static constexpr int    NB_TOTAL_FEAT    = 36;              // NB_TOTAL_FEATURES
+    static constexpr size_t FEAT_RING_FRAMES = 256;             // ~2.5 s of speech
+    SpscRing<float>    feat_ring_;             // whole feature frames only
+    bool               tx_pipeline_ = false;
 
     /* ── Thread & atomics ─────────────────────────────────────────────────── */
-    std::thread        thread_;
+    std::thread        capture_thread_;
+    std::thread        features_thread_;       // LPCNet, pipeline mode only
+    std::thread        thread_;                // DSP
+    std::thread        playback_thread_;
+    std::atomic<bool>  dsp_done_     {false};  // EOO queued, playback may finish
+    std::atomic<unsigned> capture_overruns_   {0};
+    std::atomic<unsigned> playback_underruns_ {0};
     std::atomic<bool>  running_      {false};
     std::atomic<float> input_level_  {0.0f};
     std::atomic<float> output_level_ {0.0f};
@@ -88,13 +163,24 @@ private:
     std::atomic<float> mic_gain_     {1.0f};
     std::atomic<bool>  bpf_enabled_  {false};
 
+    /* ── Stage timers, each written by one thread only ───────────────────── */
+    enum { ST_RESAMPLE_IN,         // capture thread
+           ST_FEATURES,            // DSP thread, features thread in pipeline mode
+           ST_RADE_TX, ST_BPF, ST_RESAMPLE_OUT,   // DSP thread
+           ST_AUDIO_WRITE,         // playback thread
+           N_APP_STAGES };
+    rade_hist          stage_hist_[N_APP_STAGES];
+
     /* ── TX output bandpass filter ───────────────────────────────────────── */
     rade_bpf           bpf_;
 
     /* ── FFT / spectrum of TX output ─────────────────────────────────────── */
-    float              fft_window_[FFT_SIZE]       = {};
-    float              spectrum_mag_[SPECTRUM_BINS] = {};
-    mutable std::mutex spectrum_mutex_;
+    rade_spectrum      spectrum_;              // DSP thread
+
+    /* ── Telemetry, built and published by the DSP thread ────────────────── */
+    Telemetry                 tel_;
+    SnapshotBuffer<Telemetry> telemetry_;
+    void                      publish_telemetry();
 
     /* ── EOO callsign ────────────────────────────────────────────────────── */
     std::string        callsign_;
@@ -0,0 +1,322 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_fft.c
+
+  Mixed-radix complex FFT for RADAE.  Recursive decimation in time with
+  dedicated radix 2, 3, 4 and 5 butterflies, in the style of KISS FFT.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "rade_fft.h"
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+
+/*---------------------------------------------------------------------------*\
+                           INITIALIZATION
+\*---------------------------------------------------------------------------*/
+
+int rade_fft_init(rade_fft_state *st, int n) {
+    memset(st, 0, sizeof(rade_fft_state));
+
+    if (n < 1 || n > RADE_FFT_MAX_N) {
+        fprintf(stderr, "rade_fft_init: unsupported size n=%d\n", n);
+        return -1;
+    }
+    st->n = n;
+
+    for (int k = 0; k < n; k++) {
+        double phase = -2.0 * M_PI * (double)k / (double)n;
+        st->twiddles[k] = rade_cmplx((float)cos(phase), (float)sin(phase));
+    }
+
+    /* Factor n, taking out 4s first, then 2s, then odd factors */
+    int p = 4;
+    int remaining = n;
+    int floor_sqrt = (int)floor(sqrt((double)n));
+    while (remaining > 1) {
+        while (remaining % p) {
+            switch (p) {
+                case 4:  p = 2; break;
+                case 2:  p = 3; break;
+                default: p += 2; break;
+            }
+            if (p > floor_sqrt) {
+                p = remaining;
+            }
+        }
+        if (p > RADE_FFT_MAX_RADIX || st->nfactors >= RADE_FFT_MAX_FACTORS) {
+            fprintf(stderr, "rade_fft_init: can't factor n=%d\n", n);
+            return -1;
+        }
+        remaining /= p;
+        st->factors[2 * st->nfactors] = p;
+        st->factors[2 * st->nfactors + 1] = remaining;
+        st->nfactors++;
+    }
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*\
+                           BUTTERFLIES
+\*---------------------------------------------------------------------------*/
+
+/* Twiddle k, conjugated for the inverse transform */
+static inline RADE_COMP fft_tw(const rade_fft_state *st, int k, int inverse) {
+    RADE_COMP t = st->twiddles[k];
+    if (inverse) {
+        t.imag = -t.imag;
+    }
+    return t;
+}
+
+static void fft_bfly2(RADE_COMP *out, int fstride, const rade_fft_state *st, int m, int inverse) {
+    RADE_COMP *out2 = out + m;
+    for (int k = 0; k < m; k++) {
+        RADE_COMP t = rade_cmul(out2[k], fft_tw(st, k * fstride, inverse));
+        out2[k] = rade_csub(out[k], t);
+        out[k] = rade_cadd(out[k], t);
+    }
+}
+
+static void fft_bfly3(RADE_COMP *out, int fstride, const rade_fft_state *st, int m, int inverse) {
+    float epi3 = fft_tw(st, fstride * m, inverse).imag;   /* -/+ sin(2*pi/3) */
+
+    for (int k = 0; k < m; k++) {
+        RADE_COMP s1 = rade_cmul(out[m + k], fft_tw(st, k * fstride, inverse));
+        RADE_COMP s2 = rade_cmul(out[2 * m + k], fft_tw(st, 2 * k * fstride, inverse));
+        RADE_COMP s3 = rade_cadd(s1, s2);
+        RADE_COMP s0 = rade_cscale(rade_csub(s1, s2), epi3);
+
+        RADE_COMP a = rade_csub(out[k], rade_cscale(s3, 0.5f));
+        out[k] = rade_cadd(out[k], s3);
+
+        out[2 * m + k] = rade_cmplx(a.real + s0.imag, a.imag - s0.real);
+        out[m + k] = rade_cmplx(a.real - s0.imag, a.imag + s0.real);
+    }
+}
+
+static void fft_bfly4(RADE_COMP *out, int fstride, const rade_fft_state *st, int m, int inverse) {
+    for (int k = 0; k < m; k++) {
+        RADE_COMP s0 = rade_cmul(out[m + k], fft_tw(st, k * fstride, inverse));
+        RADE_COMP s1 = rade_cmul(out[2 * m + k], fft_tw(st, 2 * k * fstride, inverse));
+        RADE_COMP s2 = rade_cmul(out[3 * m + k], fft_tw(st, 3 * k * fstride, inverse));
+
+        RADE_COMP s5 = rade_csub(out[k], s1);
+        RADE_COMP f0 = rade_cadd(out[k], s1);
+        RADE_COMP s3 = rade_cadd(s0, s2);
+        RADE_COMP s4 = rade_csub(s0, s2);
+
+        out[2 * m + k] = rade_csub(f0, s3);
+        out[k] = rade_cadd(f0, s3);
+
+        if (inverse) {
+            out[m + k] = rade_cmplx(s5.real - s4.imag, s5.imag + s4.real);
+            out[3 * m + k] = rade_cmplx(s5.real + s4.imag, s5.imag - s4.real);
+        } else {
+            out[m + k] = rade_cmplx(s5.real + s4.imag, s5.imag - s4.real);
+            out[3 * m + k] = rade_cmplx(s5.real - s4.imag, s5.imag + s4.real);
+        }
+    }
+}
+
+static void fft_bfly5(RADE_COMP *out, int fstride, const rade_fft_state *st, int m, int inverse) {
+    RADE_COMP ya = fft_tw(st, fstride * m, inverse);
+    RADE_COMP yb = fft_tw(st, 2 * fstride * m, inverse);
+
+    RADE_COMP *f0 = out;
+    RADE_COMP *f1 = out + m;
+    RADE_COMP *f2 = out + 2 * m;
+    RADE_COMP *f3 = out + 3 * m;
+    RADE_COMP *f4 = out + 4 * m;
+
+    for (int u = 0; u < m; u++) {
+        RADE_COMP s0 = f0[u];
+        RADE_COMP s1 = rade_cmul(f1[u], fft_tw(st, u * fstride, inverse));
+        RADE_COMP s2 = rade_cmul(f2[u], fft_tw(st, 2 * u * fstride, inverse));
+        RADE_COMP s3 = rade_cmul(f3[u], fft_tw(st, 3 * u * fstride, inverse));
+        RADE_COMP s4 = rade_cmul(f4[u], fft_tw(st, 4 * u * fstride, inverse));
+
+        RADE_COMP s7 = rade_cadd(s1, s4);
+        RADE_COMP s10 = rade_csub(s1, s4);
+        RADE_COMP s8 = rade_cadd(s2, s3);
+        RADE_COMP s9 = rade_csub(s2, s3);
+
+        f0[u] = rade_cadd(s0, rade_cadd(s7, s8));
+
+        RADE_COMP s5 = rade_cmplx(s0.real + s7.real * ya.real + s8.real * yb.real,
+                                  s0.imag + s7.imag * ya.real + s8.imag * yb.real);
+        RADE_COMP s6 = rade_cmplx(s10.imag * ya.imag + s9.imag * yb.imag,
+                                  -s10.real * ya.imag - s9.real * yb.imag);
+        f1[u] = rade_csub(s5, s6);
+        f4[u] = rade_cadd(s5, s6);
+
+        RADE_COMP s11 = rade_cmplx(s0.real + s7.real * yb.real + s8.real * ya.real,
+                                   s0.imag + s7.imag * yb.real + s8.imag * ya.real);
+        RADE_COMP s12 = rade_cmplx(-s10.imag * yb.imag + s9.imag * ya.imag,
+                                   s10.real * yb.imag - s9.real * ya.imag);
+        f2[u] = rade_cadd(s11, s12);
+        f3[u] = rade_csub(s11, s12);
+    }
+}
+
+/* Generic radix p butterfly, O(p^2) per output group */
+static void fft_bfly_generic(RADE_COMP *out, int fstride, const rade_fft_state *st,
+                             int m, int p, int inverse) {
+    int n = st->n;
+    RADE_COMP scratch[RADE_FFT_MAX_RADIX];
+
+    for (int u = 0; u < m; u++) {
+        int k = u;
+        for (int q1 = 0; q1 < p; q1++) {
+            scratch[q1] = out[k];
+            k += m;
+        }
+
+        k = u;
+        for (int q1 = 0; q1 < p; q1++) {
+            int twidx = 0;
+            RADE_COMP acc = scratch[0];
+            for (int q = 1; q < p; q++) {
+                twidx += fstride * k;
+                if (twidx >= n) twidx -= n;
+                acc = rade_cadd(acc, rade_cmul(scratch[q], fft_tw(st, twidx, inverse)));
+            }
+            out[k] = acc;
+            k += m;
+        }
+    }
+}
+
+static void fft_work(const rade_fft_state *st, RADE_COMP *out, const RADE_COMP *in,
+                     int fstride, const int *factors, int inverse) {
+    RADE_COMP *out_beg = out;
+    int p = *factors++;     /* radix */
+    int m = *factors++;     /* stage length / p */
+    const RADE_COMP *out_end = out + p * m;
+
+    if (m == 1) {
+        do {
+            *out = *in;
+            in += fstride;
+        } while (++out != out_end);
+    } else {
+        do {
+            fft_work(st, out, in, fstride * p, factors, inverse);
+            in += fstride;
+        } while ((out += m) != out_end);
+    }
+
+    out = out_beg;
+    switch (p) {
+        case 2:  fft_bfly2(out, fstride, st, m, inverse); break;
+        case 3:  fft_bfly3(out, fstride, st, m, inverse); break;
+        case 4:  fft_bfly4(out, fstride, st, m, inverse); break;
+        case 5:  fft_bfly5(out, fstride, st, m, inverse); break;
+        default: fft_bfly_generic(out, fstride, st, m, p, inverse); break;
+    }
+}
+
+/*---------------------------------------------------------------------------*\
+                           TRANSFORMS
+\*---------------------------------------------------------------------------*/
+
+void rade_fft(const rade_fft_state *st, RADE_COMP *out, const RADE_COMP *in) {
+    assert(st->n > 0);
+    assert(out != in);
+    if (st->n == 1) {
+        out[0] = in[0];
+        return;
+    }
+    fft_work(st, out, in, 1, st->factors, 0);
+}
+
+void rade_ifft(const rade_fft_state *st, RADE_COMP *out, const RADE_COMP *in) {
+    assert(st->n > 0);
+    assert(out != in);
+    if (st->n == 1) {
+        out[0] = in[0];
+        return;
+    }
+    fft_work(st, out, in, 1, st->factors, 1);
+}
+
+/*---------------------------------------------------------------------------*\
+                           REAL INPUT TRANSFORM
+\*---------------------------------------------------------------------------*/
+
+int rade_fft_real_init(rade_fft_real_state *st, int n) {
+    memset(st, 0, sizeof(rade_fft_real_state));
+
+    if (n < 2 || (n & 1) || n > 2 * RADE_FFT_MAX_N) {
+        fprintf(stderr, "rade_fft_real_init: unsupported size n=%d\n", n);
+        return -1;
+    }
+    st->n = n;
+
+    for (int k = 0; k <= n / 4; k++) {
+        double phase = -2.0 * M_PI * (double)k / (double)n;
+        st->split[k] = rade_cmplx((float)cos(phase), (float)sin(phase));
+    }
+
+    return rade_fft_init(&st->fft, n / 2);
+}
+
+/* With z[m] = x[2m] + j*x[2m+1] and Z its n/2 point FFT, the even and odd
+   sample spectra are E[k] = (Z[k] + conj(Z[n/2-k]))/2 and
+   O[k] = -j*(Z[k] - conj(Z[n/2-k]))/2, then X[k] = E[k] + W^k*O[k] and
+   X[n/2-k] = conj(E[k] - W^k*O[k]), so each pass makes two bins */
+void rade_fft_real(const rade_fft_real_state *st, RADE_COMP *out, const float *in) {
+    int half = st->n / 2;
+    RADE_COMP z[RADE_FFT_MAX_N];
+
+    assert(st->n > 0);
+    for (int m = 0; m < half; m++) {
+        z[m] = rade_cmplx(in[2 * m], in[2 * m + 1]);
+    }
+    rade_fft(&st->fft, out, z);
+
+    float dc = out[0].real, nyq = out[0].imag;
+    out[0] = rade_cmplx(dc + nyq, 0.0f);
+    out[half] = rade_cmplx(dc - nyq, 0.0f);
+
+    for (int k = 1; k <= half / 2; k++) {
+        RADE_COMP a = out[k];
+        RADE_COMP b = rade_cconj(out[half - k]);
+        RADE_COMP e = rade_cscale(rade_cadd(a, b), 0.5f);
+        RADE_COMP d = rade_cscale(rade_csub(a, b), 0.5f);
+        RADE_COMP o = rade_cmul(rade_cmplx(d.imag, -d.real), st->split[k]);
+        out[k] = rade_cadd(e, o);
+        if (k != half - k) {
+            out[half - k] = rade_cconj(rade_csub(e, o));
+        }
+    }
+}
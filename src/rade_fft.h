@@ -0,0 +1,98 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_fft.h
+
+  Mixed-radix complex FFT for RADAE (radix 2, 3, 4, 5 and generic odd
+  factors), with fixed-size state so it can be embedded in other states.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_FFT__
+#define __RADE_FFT__
+
+#include "rade_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                           FFT STATE
+\*---------------------------------------------------------------------------*/
+
+#define RADE_FFT_MAX_N          4096    /* Largest supported transform */
+#define RADE_FFT_MAX_FACTORS    16      /* Max number of radix stages */
+#define RADE_FFT_MAX_RADIX      32      /* Largest generic (odd) radix */
+
+typedef struct {
+    int n;                                      /* Transform length */
+    int nfactors;                               /* Number of radix stages */
+    int factors[2 * RADE_FFT_MAX_FACTORS];      /* (radix, stage length) pairs */
+    RADE_COMP twiddles[RADE_FFT_MAX_N];         /* exp(-j*2*pi*k/n) */
+} rade_fft_state;
+
+/* Real input transform of even length n, done as an n/2 point complex FFT
+   of the even/odd sample pairs followed by a split step */
+typedef struct {
+    int n;                                      /* Real transform length */
+    rade_fft_state fft;                         /* n/2 point complex FFT */
+    RADE_COMP split[RADE_FFT_MAX_N / 2 + 1];    /* exp(-j*2*pi*k/n), k <= n/4 */
+} rade_fft_real_state;
+
+/*---------------------------------------------------------------------------*\
+                           FUNCTIONS
+\*---------------------------------------------------------------------------*/
+
+/* Initialize FFT state for an n point transform
+   Returns 0 on success, -1 if n is too large or has a prime factor
+   bigger than RADE_FFT_MAX_RADIX */
+int rade_fft_init(rade_fft_state *st, int n);
+
+/* Forward transform: out[k] = sum(in[n] * exp(-j*2*pi*k*n/N))
+   Unscaled, out and in must not overlap */
+void rade_fft(const rade_fft_state *st, RADE_COMP *out, const RADE_COMP *in);
+
+/* Inverse transform: out[n] = sum(in[k] * exp(j*2*pi*k*n/N))
+   Unscaled (caller divides by N), out and in must not overlap */
+void rade_ifft(const rade_fft_state *st, RADE_COMP *out, const RADE_COMP *in);
+
+/* Initialize a real input transform, n even and no larger than
+   2*RADE_FFT_MAX_N.  Returns 0 on success, -1 as rade_fft_init() */
+int rade_fft_real_init(rade_fft_real_state *st, int n);
+
+/* Forward transform of n real samples, out[k] for k = 0..n/2 (the rest
+   are conj(out[n-k])).  Unscaled, as rade_fft() */
+void rade_fft_real(const rade_fft_real_state *st, RADE_COMP *out, const float *in);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_FFT__ */
@@ -0,0 +1,98 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_hilbert.c
+
+  Streaming block Hilbert transformer: real 8 kHz audio to complex IQ.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "rade_hilbert.h"
+#include "rade_tables.h"
+#include <string.h>
+
+/*---------------------------------------------------------------------------*\
+                           INITIALIZATION
+\*---------------------------------------------------------------------------*/
+
+void rade_hilbert_init(rade_hilbert *hb) {
+    rade_hilbert_reset(hb);
+}
+
+void rade_hilbert_reset(rade_hilbert *hb) {
+    memset(hb->x, 0, sizeof(hb->x));
+}
+
+/*---------------------------------------------------------------------------*\
+                              PROCESSING
+\*---------------------------------------------------------------------------*/
+
+/* One pass over up to RADE_HILBERT_BLOCK samples already appended after
+   the history in hb->x.  The loops run over output samples innermost so
+   they are unit stride and vectorise. */
+static void hilbert_block(const rade_hilbert *hb, RADE_COMP out[], int n) {
+    /* output i is centred on x[D + i], D = RADE_HILBERT_DELAY */
+    const float *xc = &hb->x[RADE_HILBERT_DELAY];
+    float imag[RADE_HILBERT_BLOCK];
+
+    for (int i = 0; i < n; i++)
+        imag[i] = 0.0f;
+
+    for (int j = 0; j < RADE_HILBERT_NFOLD; j++) {
+        int k = 2 * j + 1;
+        float c = rade_hilbert_c[j];
+        const float *older = xc - k;
+        const float *newer = xc + k;
+        for (int i = 0; i < n; i++)
+            imag[i] += c * (older[i] - newer[i]);
+    }
+
+    for (int i = 0; i < n; i++) {
+        out[i].real = xc[i];
+        out[i].imag = imag[i];
+    }
+}
+
+void rade_hilbert_process(rade_hilbert *hb, RADE_COMP out[], const float in[], int n) {
+    const int nhist = RADE_HILBERT_NTAPS - 1;
+
+    while (n > 0) {
+        int nb = (n < RADE_HILBERT_BLOCK) ? n : RADE_HILBERT_BLOCK;
+
+        memcpy(&hb->x[nhist], in, (size_t)nb * sizeof(float));
+        hilbert_block(hb, out, nb);
+
+        /* keep the newest NTAPS-1 samples as history for the next block */
+        memmove(hb->x, &hb->x[nb], (size_t)nhist * sizeof(float));
+
+        in  += nb;
+        out += nb;
+        n   -= nb;
+    }
+}
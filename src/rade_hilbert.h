@@ -0,0 +1,84 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_hilbert.h
+
+  Streaming block Hilbert transformer: real 8 kHz audio to complex IQ.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_HILBERT__
+#define __RADE_HILBERT__
+
+#include "rade_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                              HILBERT STATE
+\*---------------------------------------------------------------------------*/
+
+#define RADE_HILBERT_NTAPS  127                             /* odd length FIR */
+#define RADE_HILBERT_DELAY  ((RADE_HILBERT_NTAPS - 1) / 2)  /* 63 */
+#define RADE_HILBERT_NFOLD  ((RADE_HILBERT_DELAY + 1) / 2)  /* 32 non-zero tap pairs */
+#define RADE_HILBERT_BLOCK  256                             /* samples per inner pass */
+
+/* The Hamming windowed 2/(pi*n) filter is zero for even n and
+   antisymmetric, so only the 32 taps at n = 1,3,..,63 are stored and
+   each is applied once to the difference of the two samples it pairs.
+   The taps are shared by every instance (rade_hilbert_c in rade_tables.h) */
+typedef struct {
+    /* last NTAPS-1 input samples followed by the current block, oldest
+       first, so the filter never wraps an index */
+    float x[RADE_HILBERT_NTAPS - 1 + RADE_HILBERT_BLOCK];
+} rade_hilbert;
+
+/*---------------------------------------------------------------------------*\
+                                FUNCTIONS
+\*---------------------------------------------------------------------------*/
+
+/* Clear the history; the taps are generated at build time and match the
+   original real2iq.c */
+void rade_hilbert_init(rade_hilbert *hb);
+
+/* Clear the history, as if preceded by silence */
+void rade_hilbert_reset(rade_hilbert *hb);
+
+/* Convert n real samples to n IQ samples, any n.
+   out[i].real = in[i] delayed by RADE_HILBERT_DELAY samples
+   out[i].imag = Hilbert filtered in[i] */
+void rade_hilbert_process(rade_hilbert *hb, RADE_COMP out[], const float in[], int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_HILBERT__ */
@@ -0,0 +1,193 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_iq.c
+
+  IQ capture file recording and replay.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "rade_iq.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*---------------------------------------------------------------------------*\
+                                RECORDING
+\*---------------------------------------------------------------------------*/
+
+int rade_iq_create(rade_iq_writer *w, const char *path, int rade_version, int flags,
+                   float warm_reacquire, int acq_threads) {
+    memset(w, 0, sizeof(*w));
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    w->buf = (char *)malloc(RADE_IQ_WRITE_BUF);
+    if (w->buf != NULL) {
+        setvbuf(f, w->buf, _IOFBF, RADE_IQ_WRITE_BUF);
+    }
+
+    rade_iq_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, RADE_IQ_MAGIC, sizeof(hdr.magic));
+    hdr.version = RADE_IQ_VERSION;
+    hdr.sample_rate = RADE_FS;
+    hdr.rade_version = (uint32_t)rade_version;
+    hdr.flags = (uint32_t)flags;
+    hdr.warm_reacquire = warm_reacquire;
+    hdr.acq_threads = acq_threads > 0 ? (uint32_t)acq_threads : 0;
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1) {
+        fclose(f);
+        free(w->buf);
+        memset(w, 0, sizeof(*w));
+        return -1;
+    }
+
+    w->f = f;
+    return 0;
+}
+
+int rade_iq_write(rade_iq_writer *w, const RADE_COMP rx[], int nin) {
+    if (w->f == NULL || w->error || nin < 0) {
+        return -1;
+    }
+    uint32_t rec[2] = { (uint32_t)nin, RADE_IQ_FRAME };
+    if (fwrite(rec, sizeof(rec), 1, w->f) != 1 ||
+        fwrite(rx, sizeof(RADE_COMP), (size_t)nin, w->f) != (size_t)nin) {
+        w->error = 1;
+        return -1;
+    }
+    w->frames++;
+    w->samples += (uint64_t)nin;
+    return 0;
+}
+
+int rade_iq_write_load_shed(rade_iq_writer *w, int flags) {
+    if (w->f == NULL || w->error) {
+        return -1;
+    }
+    uint32_t rec[2] = { (uint32_t)flags, RADE_IQ_LOAD_SHED };
+    if (fwrite(rec, sizeof(rec), 1, w->f) != 1) {
+        w->error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+int rade_iq_close(rade_iq_writer *w) {
+    int ret = w->error ? -1 : 0;
+    if (w->f != NULL && fclose(w->f) != 0) {
+        ret = -1;
+    }
+    free(w->buf);
+    memset(w, 0, sizeof(*w));
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*\
+                                 REPLAY
+\*---------------------------------------------------------------------------*/
+
+int rade_iq_map(rade_iq_file *f, const char *path) {
+    memset(f, 0, sizeof(*f));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(rade_iq_header)) {
+        close(fd);
+        return -1;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    const rade_iq_header *hdr = (const rade_iq_header *)data;
+    if (memcmp(hdr->magic, RADE_IQ_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version < 1 || hdr->version > RADE_IQ_VERSION || hdr->sample_rate != RADE_FS) {
+        munmap(data, (size_t)st.st_size);
+        return -1;
+    }
+
+    /* replay streams through the file once, front to back */
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    f->data = data;
+    f->len = (size_t)st.st_size;
+    f->header = hdr;
+    f->pos = sizeof(rade_iq_header);
+    return 0;
+}
+
+const RADE_COMP *rade_iq_next(rade_iq_file *f, int *nin) {
+    const uint8_t *p;
+    uint32_t rec[2];
+    for (;;) {
+        if (f->data == NULL || f->len - f->pos < sizeof(rec)) {
+            return NULL;
+        }
+        p = (const uint8_t *)f->data + f->pos;
+        memcpy(rec, p, sizeof(rec));
+        if (rec[1] != RADE_IQ_LOAD_SHED) {
+            break;
+        }
+        f->load_shed = (int)rec[0];
+        f->pos += sizeof(rec);
+    }
+    uint32_t n = rec[0];
+    size_t bytes = (size_t)n * sizeof(RADE_COMP);
+    if (rec[1] != RADE_IQ_FRAME || n > (uint32_t)RADE_NMF * 4 ||
+        f->len - f->pos - sizeof(rec) < bytes) {
+        return NULL;
+    }
+    f->pos += sizeof(rec) + bytes;
+    *nin = (int)n;
+    return (const RADE_COMP *)(p + sizeof(rec));
+}
+
+void rade_iq_rewind(rade_iq_file *f) {
+    f->pos = sizeof(rade_iq_header);
+    f->load_shed = 0;
+}
+
+void rade_iq_unmap(rade_iq_file *f) {
+    if (f->data != NULL) {
+        munmap(f->data, f->len);
+    }
+    memset(f, 0, sizeof(*f));
+}
@@ -0,0 +1,145 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_iq.h
+
+  IQ capture files: the complex 8 kHz samples handed to rade_rx(), one
+  record per modem frame, for replaying a receiver run exactly.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_IQ__
+#define __RADE_IQ__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "rade_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                               FILE FORMAT
+\*---------------------------------------------------------------------------*/
+
+/* Little endian.  A 32 byte header holding the receiver settings that
+   change what it decodes, then a record per rade_rx() call:
+
+     uint32 nin, uint32 RADE_IQ_FRAME, nin x { float real, float imag }
+
+   and one each time the recorder changed its load shedding, which applies
+   from the next frame on:
+
+     uint32 flags, uint32 RADE_IQ_LOAD_SHED
+
+   The record header keeps the samples 8 byte aligned, so a mapped file is
+   read in place.  There is no frame count, a capture cut short by a crash
+   or kill is still valid up to its last whole record.  Version 1 files
+   have no settings and no load shed records. */
+
+#define RADE_IQ_MAGIC    "RADE_IQ"          /* 8 bytes with the NUL */
+#define RADE_IQ_VERSION  2
+
+#define RADE_IQ_FRAME      0                /* record types */
+#define RADE_IQ_LOAD_SHED  1
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;                       /* RADE_IQ_VERSION */
+    uint32_t sample_rate;                   /* RADE_FS */
+    uint32_t rade_version;                  /* rade_version() of the recorder */
+    uint32_t flags;                         /* rade_open() flags of the recorder */
+    float    warm_reacquire;                /* rade_set_warm_reacquire() s, 0 off */
+    uint32_t acq_threads;                   /* rade_set_acq_threads(), 0 or 1 off */
+} rade_iq_header;
+
+/*---------------------------------------------------------------------------*\
+                                RECORDING
+\*---------------------------------------------------------------------------*/
+
+typedef struct {
+    FILE     *f;
+    char     *buf;                          /* stdio buffer, RADE_IQ_WRITE_BUF */
+    uint64_t  frames;
+    uint64_t  samples;
+    int       error;                        /* a write failed, later ones are dropped */
+} rade_iq_writer;
+
+#define RADE_IQ_WRITE_BUF  (256 * 1024)
+
+/* Create path and write the header, recording the receiver's rade_open()
+   flags and the settings it was given.  Returns 0, or -1 with w zeroed */
+int rade_iq_create(rade_iq_writer *w, const char *path, int rade_version, int flags,
+                   float warm_reacquire, int acq_threads);
+
+/* Append one frame of nin samples.  Buffered, so a write() reaches the
+   kernel every few tens of frames.  Returns 0, or -1 once any write has
+   failed (e.g. disk full) */
+int rade_iq_write(rade_iq_writer *w, const RADE_COMP rx[], int nin);
+
+/* Record a rade_set_load_shed(flags) made before the next rade_rx().
+   Returns 0, or -1 as for rade_iq_write() */
+int rade_iq_write_load_shed(rade_iq_writer *w, int flags);
+
+/* Flush and close, 0 if everything was written */
+int rade_iq_close(rade_iq_writer *w);
+
+/*---------------------------------------------------------------------------*\
+                                 REPLAY
+\*---------------------------------------------------------------------------*/
+
+typedef struct {
+    void                 *data;             /* whole file, mapped read only */
+    size_t                len;
+    const rade_iq_header *header;
+    size_t                pos;              /* offset of the next record */
+    int                   load_shed;        /* flags in force for the last frame */
+} rade_iq_file;
+
+/* Map path and check the header.  Returns 0, or -1 with f zeroed */
+int rade_iq_map(rade_iq_file *f, const char *path);
+
+/* The next frame's samples, in place in the mapping, and its nin.  Load
+   shed records on the way update f->load_shed, which the replay should
+   rade_set_load_shed() before feeding the frame.  NULL at the end of the
+   file or at a truncated or unknown record */
+const RADE_COMP *rade_iq_next(rade_iq_file *f, int *nin);
+
+/* Back to the first frame */
+void rade_iq_rewind(rade_iq_file *f);
+
+void rade_iq_unmap(rade_iq_file *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_IQ__ */
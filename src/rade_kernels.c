@@ -0,0 +1,1134 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_kernels.c
+
+  Scalar, SSE, AVX2 and NEON versions of the RADAE DSP kernels, and the
+  run time selection between them.  See rade_kernels.h for the lane
+  layout that keeps every version bit identical.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "rade_kernels.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#define RADE_KERNELS_HAVE_SSE 1
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define RADE_KERNELS_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define RADE_KERNELS_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+/*---------------------------------------------------------------------------*\
+                                 SCALAR
+\*---------------------------------------------------------------------------*/
+
+/* The SIMD versions run their vector loops then hand the lanes and the
+   remaining elements to these, so the tails and lane sums are shared */
+
+/* ((l0+l4)+(l2+l6)) and ((l1+l5)+(l3+l7)), the order halving a 256 bit
+   register and then a 128 bit one gives */
+static inline void lanes_even_odd(const float l[8], float *even, float *odd) {
+    *even = (l[0] + l[4]) + (l[2] + l[6]);
+    *odd  = (l[1] + l[5]) + (l[3] + l[7]);
+}
+
+static inline float lanes_sum(const float l[8]) {
+    float even, odd;
+    lanes_even_odd(l, &even, &odd);
+    return even + odd;
+}
+
+/* P holds a*b and Q a*swap(b) per float, for floats i0..nf-1.  Whole
+   blocks first, so the compiler can keep the lanes in registers */
+static void cdot_lanes(float P[8], float Q[8], const float *a, const float *b, int i0, int nf) {
+    int i = i0;
+    if ((i & 7) == 0) {
+        float p[8], q[8];
+        memcpy(p, P, sizeof(p));
+        memcpy(q, Q, sizeof(q));
+        for (; i + 8 <= nf; i += 8) {
+            for (int l = 0; l < 8; l += 2) {
+                p[l]     += a[i + l] * b[i + l];
+                p[l + 1] += a[i + l + 1] * b[i + l + 1];
+                q[l]     += a[i + l] * b[i + l + 1];
+                q[l + 1] += a[i + l + 1] * b[i + l];
+            }
+        }
+        memcpy(P, p, sizeof(p));
+        memcpy(Q, q, sizeof(q));
+    }
+    for (; i < nf; i += 2) {
+        int l = i & 7;
+        P[l]     += a[i] * b[i];
+        P[l + 1] += a[i + 1] * b[i + 1];
+        Q[l]     += a[i] * b[i + 1];
+        Q[l + 1] += a[i + 1] * b[i];
+    }
+}
+
+static RADE_COMP cdot_finish(const float P[8], const float Q[8], int conj_a) {
+    float rr, ii, ri, ir;
+    lanes_even_odd(P, &rr, &ii);
+    lanes_even_odd(Q, &ri, &ir);
+    return conj_a ? rade_cmplx(rr + ii, ri - ir) : rade_cmplx(rr - ii, ri + ir);
+}
+
+static RADE_COMP cdot_c(const RADE_COMP *a, const RADE_COMP *b, int n, int conj_a) {
+    float P[8] = {0}, Q[8] = {0};
+    cdot_lanes(P, Q, (const float *)a, (const float *)b, 0, 2 * n);
+    return cdot_finish(P, Q, conj_a);
+}
+
+static void cmvmul_c(RADE_COMP *y, const RADE_COMP *A, const RADE_COMP *x, int rows, int cols) {
+    for (int r = 0; r < rows; r++) {
+        y[r] = cdot_c(&A[r * cols], x, cols, 0);
+    }
+}
+
+/* Real row times complex x, columns c0..cols-1 */
+static void rmv_lanes(float P[8], const float *A, const float *x, int c0, int cols) {
+    for (int c = c0; c < cols; c++) {
+        int l = (2 * c) & 7;
+        P[l]     += A[c] * x[2 * c];
+        P[l + 1] += A[c] * x[2 * c + 1];
+    }
+}
+
+static void cmvmul_real_c(RADE_COMP *y, const float *A, const RADE_COMP *x, int rows, int cols) {
+    for (int r = 0; r < rows; r++) {
+        float P[8] = {0};
+        rmv_lanes(P, &A[r * cols], (const float *)x, 0, cols);
+        lanes_even_odd(P, &y[r].real, &y[r].imag);
+    }
+}
+
+/* Split row dot product, s = -1 conjugates the row */
+static void smv_lanes(float R[8], float I[8], const float *Ar, const float *Ai,
+                      const float *xr, const float *xi, int c0, int cols, float s) {
+    int c = c0;
+    if ((c & 7) == 0) {
+        float r8[8], i8[8];
+        memcpy(r8, R, sizeof(r8));
+        memcpy(i8, I, sizeof(i8));
+        for (; c + 8 <= cols; c += 8) {
+            for (int l = 0; l < 8; l++) {
+                float ai = s * Ai[c + l];
+                r8[l] += Ar[c + l] * xr[c + l] - ai * xi[c + l];
+                i8[l] += Ar[c + l] * xi[c + l] + ai * xr[c + l];
+            }
+        }
+        memcpy(R, r8, sizeof(r8));
+        memcpy(I, i8, sizeof(i8));
+    }
+    for (; c < cols; c++) {
+        int l = c & 7;
+        float ai = s * Ai[c];
+        R[l] += Ar[c] * xr[c] - ai * xi[c];
+        I[l] += Ar[c] * xi[c] + ai * xr[c];
+    }
+}
+
+static void cmvmul_split_c(float *yr, float *yi, const float *Ar, const float *Ai, int lda,
+                           const float *xr, const float *xi, int rows, int cols, int conj_a) {
+    float s = conj_a ? -1.0f : 1.0f;
+    for (int r = 0; r < rows; r++) {
+        float R[8] = {0}, I[8] = {0};
+        smv_lanes(R, I, &Ar[r * lda], &Ai[r * lda], xr, xi, 0, cols, s);
+        yr[r] = lanes_sum(R);
+        yi[r] = lanes_sum(I);
+    }
+}
+
+/* Columns c0..cols-1 of the vector matrix product, one at a time */
+static void vmm_cols(float *yr, float *yi, const RADE_COMP *x, const float *Ar, const float *Ai,
+                     int lda, int rows, int c0, int cols, float s) {
+    for (int c = c0; c < cols; c++) {
+        float accr = 0.0f, acci = 0.0f;
+        for (int r = 0; r < rows; r++) {
+            float xr = x[r].real, xi = s * x[r].imag;
+            float ar = Ar[r * lda + c], ai = Ai[r * lda + c];
+            accr += xr * ar - xi * ai;
+            acci += xr * ai + xi * ar;
+        }
+        yr[c] = accr;
+        yi[c] = acci;
+    }
+}
+
+static void cvmmul_split_c(float *yr, float *yi, const RADE_COMP *x, const float *Ar, const float *Ai,
+                           int lda, int rows, int cols, int conj_x) {
+    vmm_cols(yr, yi, x, Ar, Ai, lda, rows, 0, cols, conj_x ? -1.0f : 1.0f);
+}
+
+static void cvmul_c(RADE_COMP *y, const RADE_COMP *a, const RADE_COMP *b, int n, int conj_b) {
+    float s = conj_b ? -1.0f : 1.0f;
+    for (int i = 0; i < n; i++) {
+        float ar = a[i].real, ai = a[i].imag;
+        float br = b[i].real, bi = s * b[i].imag;
+        y[i].real = ar * br - ai * bi;
+        y[i].imag = ar * bi + ai * br;
+    }
+}
+
+/* Outputs i0..n-1 of the folded FIR */
+static void fir_outputs(float *yr, float *yi, const float *xr, const float *xi,
+                        const float *h, int ntap, int i0, int n) {
+    int nh = ntap - 1;
+    int c = nh / 2;
+    for (int i = i0; i < n; i++) {
+        float accr = h[c] * xr[i + c];
+        float acci = h[c] * xi[i + c];
+        for (int k = 0; k < c; k++) {
+            accr += h[k] * (xr[i + nh - k] + xr[i + k]);
+            acci += h[k] * (xi[i + nh - k] + xi[i + k]);
+        }
+        yr[i] = accr;
+        yi[i] = acci;
+    }
+}
+
+static void fir_sym_split_c(float *yr, float *yi, const float *xr, const float *xi,
+                            const float *h, int ntap, int n) {
+    fir_outputs(yr, yi, xr, xi, h, ntap, 0, n);
+}
+
+/* inc, inc^2, inc^3, inc^4 for the 4 sample phase steps */
+static void rotate_powers(RADE_COMP incp[4], RADE_COMP inc) {
+    incp[0] = inc;
+    for (int l = 1; l < 4; l++) {
+        incp[l] = rade_cmul(incp[l - 1], inc);
+    }
+}
+
+/* Single steps for samples i0..n-1 */
+static void rotate_samples(RADE_COMP *y, RADE_COMP *ph, const RADE_COMP *x,
+                           RADE_COMP *phase, RADE_COMP inc, int i0, int n) {
+    RADE_COMP p = *phase;
+    for (int i = i0; i < n; i++) {
+        p = rade_cmul(p, inc);
+        ph[i] = p;
+        y[i] = rade_cmul(x[i], p);
+    }
+    *phase = p;
+}
+
+static void rotate_c(RADE_COMP *y, RADE_COMP *ph, const RADE_COMP *x,
+                     RADE_COMP *phase, RADE_COMP inc, int n) {
+    RADE_COMP incp[4];
+    rotate_powers(incp, inc);
+
+    RADE_COMP p = *phase;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int l = 0; l < 4; l++) {
+            ph[i + l] = rade_cmul(p, incp[l]);
+            y[i + l] = rade_cmul(x[i + l], ph[i + l]);
+        }
+        p = ph[i + 3];
+    }
+    *phase = p;
+    rotate_samples(y, ph, x, phase, inc, i, n);
+}
+
+/* PA model gain tanh(r)/r = P(r^2)/Q(r^2), the odd [13/6] rational
+   approximation Eigen uses for float tanh() divided through by r (relative
+   error < 4e-7).  Past r = 7.9 tanh(r) is 1 to float precision and the
+   gain is just 1/r.  The SIMD versions evaluate both and select */
+#define CLIMIT_R2_MAX   62.4939f        /* 7.90531^2 */
+#define CLIMIT_A1       4.89352455891786e-03f
+#define CLIMIT_A3       6.37261928875436e-04f
+#define CLIMIT_A5       1.48572235717979e-05f
+#define CLIMIT_A7       5.12229709037114e-08f
+#define CLIMIT_A9       -8.60467152213735e-11f
+#define CLIMIT_A11      2.00018790482477e-13f
+#define CLIMIT_A13      -2.76076847742355e-16f
+#define CLIMIT_B0       4.89352518554385e-03f
+#define CLIMIT_B2       2.26843463243900e-03f
+#define CLIMIT_B4       1.18534705686654e-04f
+#define CLIMIT_B6       1.19825839466702e-06f
+
+static inline float climit_gain(float r2) {
+    if (r2 > CLIMIT_R2_MAX) {
+        return 1.0f / sqrtf(r2);
+    }
+    float p = CLIMIT_A13;
+    p = p * r2 + CLIMIT_A11;
+    p = p * r2 + CLIMIT_A9;
+    p = p * r2 + CLIMIT_A7;
+    p = p * r2 + CLIMIT_A5;
+    p = p * r2 + CLIMIT_A3;
+    p = p * r2 + CLIMIT_A1;
+    float q = CLIMIT_B6;
+    q = q * r2 + CLIMIT_B4;
+    q = q * r2 + CLIMIT_B2;
+    q = q * r2 + CLIMIT_B0;
+    return p / q;
+}
+
+static void climit_c(RADE_COMP *y, const RADE_COMP *x, int n) {
+    for (int i = 0; i < n; i++) {
+        float xr = x[i].real, xi = x[i].imag;
+        float g = climit_gain(xr * xr + xi * xi);
+        y[i].real = xr * g;
+        y[i].imag = xi * g;
+    }
+}
+
+static void s16_to_float_c(float *y, const int16_t *x, float scale, int n) {
+    for (int i = 0; i < n; i++) {
+        y[i] = x[i] * scale;
+    }
+}
+
+/* floor(v + 0.5) as floor(v), plus one where v - floor(v) >= 0.5.  The
+   sum v + 0.5f isn't exact (0.49999997f + 0.5f rounds to 1.0f) but the
+   difference is, bar -0.5 < v < 0 where it still rounds the right side
+   of 0.5, so every version matches floor(0.5 + (double)v) */
+static void float_to_s16_c(int16_t *y, const float *x, float scale, int n) {
+    for (int i = 0; i < n; i++) {
+        float v = x[i] * scale;
+        if (v > 32767.0f) v = 32767.0f;
+        if (v < -32767.0f) v = -32767.0f;
+        float fl = floorf(v);
+        y[i] = (int16_t)((v - fl >= 0.5f) ? fl + 1.0f : fl);
+    }
+}
+
+static const rade_kernels kernels_c = {
+    RADE_KERNELS_SCALAR, "scalar",
+    cdot_c, cmvmul_c, cmvmul_real_c, cmvmul_split_c, cvmmul_split_c,
+    cvmul_c, fir_sym_split_c, rotate_c, climit_c,
+    s16_to_float_c, float_to_s16_c
+};
+
+/*---------------------------------------------------------------------------*\
+                                  SSE
+\*---------------------------------------------------------------------------*/
+
+#ifdef RADE_KERNELS_HAVE_SSE
+
+#define SSE_SWAP(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))
+
+/* Two complex products a * b, with sign odd/even set up for op(b) as in
+   cvmul_c: (-1, 1) for b, (1, -1) for conj(b) */
+static inline __m128 sse_cmul(__m128 a, __m128 b, __m128 sign) {
+    __m128 br = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 bi = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1));
+    return _mm_add_ps(_mm_mul_ps(a, br), _mm_mul_ps(_mm_mul_ps(SSE_SWAP(a), bi), sign));
+}
+
+static inline __m128 sse_cmul_sign(int conj_b) {
+    return conj_b ? _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f) : _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+}
+
+static RADE_COMP cdot_sse(const RADE_COMP *a, const RADE_COMP *b, int n, int conj_a) {
+    const float *af = (const float *)a;
+    const float *bf = (const float *)b;
+    __m128 p0 = _mm_setzero_ps(), p1 = _mm_setzero_ps();
+    __m128 q0 = _mm_setzero_ps(), q1 = _mm_setzero_ps();
+    int nf = 2 * n;
+    int i = 0;
+    for (; i + 8 <= nf; i += 8) {
+        __m128 a0 = _mm_loadu_ps(af + i), a1 = _mm_loadu_ps(af + i + 4);
+        __m128 b0 = _mm_loadu_ps(bf + i), b1 = _mm_loadu_ps(bf + i + 4);
+        p0 = _mm_add_ps(p0, _mm_mul_ps(a0, b0));
+        p1 = _mm_add_ps(p1, _mm_mul_ps(a1, b1));
+        q0 = _mm_add_ps(q0, _mm_mul_ps(a0, SSE_SWAP(b0)));
+        q1 = _mm_add_ps(q1, _mm_mul_ps(a1, SSE_SWAP(b1)));
+    }
+    float P[8], Q[8];
+    _mm_storeu_ps(P, p0);
+    _mm_storeu_ps(P + 4, p1);
+    _mm_storeu_ps(Q, q0);
+    _mm_storeu_ps(Q + 4, q1);
+    cdot_lanes(P, Q, af, bf, i, nf);
+    return cdot_finish(P, Q, conj_a);
+}
+
+static void cmvmul_sse(RADE_COMP *y, const RADE_COMP *A, const RADE_COMP *x, int rows, int cols) {
+    for (int r = 0; r < rows; r++) {
+        y[r] = cdot_sse(&A[r * cols], x, cols, 0);
+    }
+}
+
+static void cmvmul_real_sse(RADE_COMP *y, const float *A, const RADE_COMP *x, int rows, int cols) {
+    const float *xf = (const float *)x;
+    for (int r = 0; r < rows; r++) {
+        const float *row = &A[r * cols];
+        __m128 p0 = _mm_setzero_ps(), p1 = _mm_setzero_ps();
+        int c = 0;
+        for (; c + 4 <= cols; c += 4) {
+            __m128 a = _mm_loadu_ps(row + c);
+            p0 = _mm_add_ps(p0, _mm_mul_ps(_mm_unpacklo_ps(a, a), _mm_loadu_ps(xf + 2 * c)));
+            p1 = _mm_add_ps(p1, _mm_mul_ps(_mm_unpackhi_ps(a, a), _mm_loadu_ps(xf + 2 * c + 4)));
+        }
+        float P[8];
+        _mm_storeu_ps(P, p0);
+        _mm_storeu_ps(P + 4, p1);
+        rmv_lanes(P, row, xf, c, cols);
+        lanes_even_odd(P, &y[r].real, &y[r].imag);
+    }
+}
+
+static void cmvmul_split_sse(float *yr, float *yi, const float *Ar, const float *Ai, int lda,
+                             const float *xr, const float *xi, int rows, int cols, int conj_a) {
+    float s = conj_a ? -1.0f : 1.0f;
+    __m128 vs = _mm_set1_ps(s);
+    for (int r = 0; r < rows; r++) {
+        const float *ar = &Ar[r * lda], *ai = &Ai[r * lda];
+        __m128 R[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+        __m128 I[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+        int c = 0;
+        for (; c + 8 <= cols; c += 8) {
+            for (int h = 0; h < 2; h++) {
+                int k = c + 4 * h;
+                __m128 vr = _mm_loadu_ps(ar + k);
+                __m128 vi = _mm_mul_ps(vs, _mm_loadu_ps(ai + k));
+                __m128 wr = _mm_loadu_ps(xr + k), wi = _mm_loadu_ps(xi + k);
+                R[h] = _mm_add_ps(R[h], _mm_sub_ps(_mm_mul_ps(vr, wr), _mm_mul_ps(vi, wi)));
+                I[h] = _mm_add_ps(I[h], _mm_add_ps(_mm_mul_ps(vr, wi), _mm_mul_ps(vi, wr)));
+            }
+        }
+        float Rl[8], Il[8];
+        _mm_storeu_ps(Rl, R[0]);
+        _mm_storeu_ps(Rl + 4, R[1]);
+        _mm_storeu_ps(Il, I[0]);
+        _mm_storeu_ps(Il + 4, I[1]);
+        smv_lanes(Rl, Il, ar, ai, xr, xi, c, cols, s);
+        yr[r] = lanes_sum(Rl);
+        yi[r] = lanes_sum(Il);
+    }
+}
+
+static void cvmmul_split_sse(float *yr, float *yi, const RADE_COMP *x, const float *Ar, const float *Ai,
+                             int lda, int rows, int cols, int conj_x) {
+    float s = conj_x ? -1.0f : 1.0f;
+    int c = 0;
+    for (; c + 4 <= cols; c += 4) {
+        __m128 accr = _mm_setzero_ps(), acci = _mm_setzero_ps();
+        for (int r = 0; r < rows; r++) {
+            __m128 xr = _mm_set1_ps(x[r].real), xi = _mm_set1_ps(s * x[r].imag);
+            __m128 ar = _mm_loadu_ps(&Ar[r * lda + c]), ai = _mm_loadu_ps(&Ai[r * lda + c]);
+            accr = _mm_add_ps(accr, _mm_sub_ps(_mm_mul_ps(xr, ar), _mm_mul_ps(xi, ai)));
+            acci = _mm_add_ps(acci, _mm_add_ps(_mm_mul_ps(xr, ai), _mm_mul_ps(xi, ar)));
+        }
+        _mm_storeu_ps(yr + c, accr);
+        _mm_storeu_ps(yi + c, acci);
+    }
+    vmm_cols(yr, yi, x, Ar, Ai, lda, rows, c, cols, s);
+}
+
+static void cvmul_sse(RADE_COMP *y, const RADE_COMP *a, const RADE_COMP *b, int n, int conj_b) {
+    __m128 sign = sse_cmul_sign(conj_b);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128 va = _mm_loadu_ps((const float *)&a[i]);
+        __m128 vb = _mm_loadu_ps((const float *)&b[i]);
+        _mm_storeu_ps((float *)&y[i], sse_cmul(va, vb, sign));
+    }
+    cvmul_c(&y[i], &a[i], &b[i], n - i, conj_b);
+}
+
+static void fir_sym_split_sse(float *yr, float *yi, const float *xr, const float *xi,
+                              const float *h, int ntap, int n) {
+    int nh = ntap - 1;
+    int c = nh / 2;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 hc = _mm_set1_ps(h[c]);
+        __m128 accr = _mm_mul_ps(hc, _mm_loadu_ps(xr + i + c));
+        __m128 acci = _mm_mul_ps(hc, _mm_loadu_ps(xi + i + c));
+        for (int k = 0; k < c; k++) {
+            __m128 hk = _mm_set1_ps(h[k]);
+            accr = _mm_add_ps(accr, _mm_mul_ps(hk, _mm_add_ps(_mm_loadu_ps(xr + i + nh - k),
+                                                               _mm_loadu_ps(xr + i + k))));
+            acci = _mm_add_ps(acci, _mm_mul_ps(hk, _mm_add_ps(_mm_loadu_ps(xi + i + nh - k),
+                                                               _mm_loadu_ps(xi + i + k))));
+        }
+        _mm_storeu_ps(yr + i, accr);
+        _mm_storeu_ps(yi + i, acci);
+    }
+    fir_outputs(yr, yi, xr, xi, h, ntap, i, n);
+}
+
+static void rotate_sse(RADE_COMP *y, RADE_COMP *ph, const RADE_COMP *x,
+                       RADE_COMP *phase, RADE_COMP inc, int n) {
+    RADE_COMP incp[4];
+    rotate_powers(incp, inc);
+    __m128 sign = sse_cmul_sign(0);
+    __m128 inc01 = _mm_loadu_ps((const float *)&incp[0]);
+    __m128 inc23 = _mm_loadu_ps((const float *)&incp[2]);
+
+    RADE_COMP p = *phase;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 vp = _mm_setr_ps(p.real, p.imag, p.real, p.imag);
+        __m128 ph01 = sse_cmul(vp, inc01, sign);
+        __m128 ph23 = sse_cmul(vp, inc23, sign);
+        __m128 x01 = _mm_loadu_ps((const float *)&x[i]);
+        __m128 x23 = _mm_loadu_ps((const float *)&x[i + 2]);
+        _mm_storeu_ps((float *)&ph[i], ph01);
+        _mm_storeu_ps((float *)&ph[i + 2], ph23);
+        _mm_storeu_ps((float *)&y[i], sse_cmul(x01, ph01, sign));
+        _mm_storeu_ps((float *)&y[i + 2], sse_cmul(x23, ph23, sign));
+        p = ph[i + 3];
+    }
+    *phase = p;
+    rotate_samples(y, ph, x, phase, inc, i, n);
+}
+
+/* Two samples, |x|^2 in both floats of each */
+static void climit_sse(RADE_COMP *y, const RADE_COMP *x, int n) {
+    const __m128 r2_max = _mm_set1_ps(CLIMIT_R2_MAX);
+    const __m128 one = _mm_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128 v = _mm_loadu_ps((const float *)&x[i]);
+        __m128 sq = _mm_mul_ps(v, v);
+        __m128 r2 = _mm_add_ps(sq, SSE_SWAP(sq));
+
+        __m128 p = _mm_set1_ps(CLIMIT_A13);
+        p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(CLIMIT_A11));
+        p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(CLIMIT_A9));
+        p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(CLIMIT_A7));
+        p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(CLIMIT_A5));
+        p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(CLIMIT_A3));
+        p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(CLIMIT_A1));
+        __m128 q = _mm_set1_ps(CLIMIT_B6);
+        q = _mm_add_ps(_mm_mul_ps(q, r2), _mm_set1_ps(CLIMIT_B4));
+        q = _mm_add_ps(_mm_mul_ps(q, r2), _mm_set1_ps(CLIMIT_B2));
+        q = _mm_add_ps(_mm_mul_ps(q, r2), _mm_set1_ps(CLIMIT_B0));
+
+        __m128 big = _mm_cmpgt_ps(r2, r2_max);
+        __m128 g = _mm_or_ps(_mm_and_ps(big, _mm_div_ps(one, _mm_sqrt_ps(r2))),
+                             _mm_andnot_ps(big, _mm_div_ps(p, q)));
+        _mm_storeu_ps((float *)&y[i], _mm_mul_ps(v, g));
+    }
+    climit_c(&y[i], &x[i], n - i);
+}
+
+static void s16_to_float_sse(float *y, const int16_t *x, float scale, int n) {
+    const __m128 s = _mm_set1_ps(scale);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&x[i]);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(&y[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(&y[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+    s16_to_float_c(&y[i], &x[i], scale, n - i);
+}
+
+/* float_to_s16_c() rounding of four clamped samples without SSE4.1:
+   floor() by truncating, then stepping down where that rounded a negative
+   value up, then up one where the fraction is >= 0.5 */
+static inline __m128i sse_round_s16(__m128 x, __m128 s) {
+    __m128 v = _mm_mul_ps(x, s);
+    v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-32767.0f)), _mm_set1_ps(32767.0f));
+    __m128i t = _mm_cvttps_epi32(v);
+    t = _mm_add_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(t), v)));
+    __m128 frac = _mm_sub_ps(v, _mm_cvtepi32_ps(t));
+    return _mm_sub_epi32(t, _mm_castps_si128(_mm_cmpge_ps(frac, _mm_set1_ps(0.5f))));
+}
+
+static void float_to_s16_sse(int16_t *y, const float *x, float scale, int n) {
+    const __m128 s = _mm_set1_ps(scale);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = sse_round_s16(_mm_loadu_ps(&x[i]), s);
+        __m128i hi = sse_round_s16(_mm_loadu_ps(&x[i + 4]), s);
+        _mm_storeu_si128((__m128i *)&y[i], _mm_packs_epi32(lo, hi));
+    }
+    float_to_s16_c(&y[i], &x[i], scale, n - i);
+}
+
+static const rade_kernels kernels_sse = {
+    RADE_KERNELS_SSE, "sse",
+    cdot_sse, cmvmul_sse, cmvmul_real_sse, cmvmul_split_sse, cvmmul_split_sse,
+    cvmul_sse, fir_sym_split_sse, rotate_sse, climit_sse,
+    s16_to_float_sse, float_to_s16_sse
+};
+
+#endif /* RADE_KERNELS_HAVE_SSE */
+
+/*---------------------------------------------------------------------------*\
+                                  AVX2
+\*---------------------------------------------------------------------------*/
+
+#ifdef RADE_KERNELS_HAVE_AVX2
+
+/* AVX2 but not FMA, which would round differently to the other versions */
+#define AVX2_FN __attribute__((target("avx2")))
+
+/* The shared scalar helpers are SSE code, so each function clears the
+   upper halves (vzeroupper) before calling them, or the SSE instructions
+   pay for a false dependency on the 256 bit registers */
+
+#define AVX_SWAP(v) _mm256_permute_ps(v, 0xB1)
+
+/* Four complex products, sign as sse_cmul() */
+static inline AVX2_FN __m256 avx_cmul(__m256 a, __m256 b, __m256 sign) {
+    __m256 br = _mm256_permute_ps(b, 0xA0);
+    __m256 bi = _mm256_permute_ps(b, 0xF5);
+    return _mm256_add_ps(_mm256_mul_ps(a, br), _mm256_mul_ps(_mm256_mul_ps(AVX_SWAP(a), bi), sign));
+}
+
+static inline AVX2_FN __m256 avx_cmul_sign(int conj_b) {
+    return conj_b ? _mm256_setr_ps(1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f)
+                  : _mm256_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+}
+
+static AVX2_FN RADE_COMP cdot_avx2(const RADE_COMP *a, const RADE_COMP *b, int n, int conj_a) {
+    const float *af = (const float *)a;
+    const float *bf = (const float *)b;
+    __m256 p = _mm256_setzero_ps(), q = _mm256_setzero_ps();
+    int nf = 2 * n;
+    int i = 0;
+    for (; i + 8 <= nf; i += 8) {
+        __m256 va = _mm256_loadu_ps(af + i), vb = _mm256_loadu_ps(bf + i);
+        p = _mm256_add_ps(p, _mm256_mul_ps(va, vb));
+        q = _mm256_add_ps(q, _mm256_mul_ps(va, AVX_SWAP(vb)));
+    }
+    float P[8], Q[8];
+    _mm256_storeu_ps(P, p);
+    _mm256_storeu_ps(Q, q);
+    _mm256_zeroupper();
+    cdot_lanes(P, Q, af, bf, i, nf);
+    return cdot_finish(P, Q, conj_a);
+}
+
+static AVX2_FN void cmvmul_avx2(RADE_COMP *y, const RADE_COMP *A, const RADE_COMP *x, int rows, int cols) {
+    for (int r = 0; r < rows; r++) {
+        y[r] = cdot_avx2(&A[r * cols], x, cols, 0);
+    }
+}
+
+static AVX2_FN void cmvmul_real_avx2(RADE_COMP *y, const float *A, const RADE_COMP *x, int rows, int cols) {
+    const float *xf = (const float *)x;
+    for (int r = 0; r < rows; r++) {
+        const float *row = &A[r * cols];
+        __m256 p = _mm256_setzero_ps();
+        int c = 0;
+        for (; c + 4 <= cols; c += 4) {
+            __m128 a = _mm_loadu_ps(row + c);
+            __m256 aa = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_unpacklo_ps(a, a)),
+                                             _mm_unpackhi_ps(a, a), 1);
+            p = _mm256_add_ps(p, _mm256_mul_ps(aa, _mm256_loadu_ps(xf + 2 * c)));
+        }
+        float P[8];
+        _mm256_storeu_ps(P, p);
+        _mm256_zeroupper();
+        rmv_lanes(P, row, xf, c, cols);
+        lanes_even_odd(P, &y[r].real, &y[r].imag);
+    }
+}
+
+static AVX2_FN void cmvmul_split_avx2(float *yr, float *yi, const float *Ar, const float *Ai, int lda,
+                                      const float *xr, const float *xi, int rows, int cols, int conj_a) {
+    float s = conj_a ? -1.0f : 1.0f;
+    __m256 vs = _mm256_set1_ps(s);
+    for (int r = 0; r < rows; r++) {
+        const float *ar = &Ar[r * lda], *ai = &Ai[r * lda];
+        __m256 R = _mm256_setzero_ps(), I = _mm256_setzero_ps();
+        int c = 0;
+        for (; c + 8 <= cols; c += 8) {
+            __m256 vr = _mm256_loadu_ps(ar + c);
+            __m256 vi = _mm256_mul_ps(vs, _mm256_loadu_ps(ai + c));
+            __m256 wr = _mm256_loadu_ps(xr + c), wi = _mm256_loadu_ps(xi + c);
+            R = _mm256_add_ps(R, _mm256_sub_ps(_mm256_mul_ps(vr, wr), _mm256_mul_ps(vi, wi)));
+            I = _mm256_add_ps(I, _mm256_add_ps(_mm256_mul_ps(vr, wi), _mm256_mul_ps(vi, wr)));
+        }
+        float Rl[8], Il[8];
+        _mm256_storeu_ps(Rl, R);
+        _mm256_storeu_ps(Il, I);
+        _mm256_zeroupper();
+        smv_lanes(Rl, Il, ar, ai, xr, xi, c, cols, s);
+        yr[r] = lanes_sum(Rl);
+        yi[r] = lanes_sum(Il);
+    }
+}
+
+/* Two column blocks at a time where there are enough columns, the
+   accumulators only depend on themselves so this hides the add latency */
+static AVX2_FN void cvmmul_split_avx2(float *yr, float *yi, const RADE_COMP *x, const float *Ar,
+                                      const float *Ai, int lda, int rows, int cols, int conj_x) {
+    float s = conj_x ? -1.0f : 1.0f;
+    int c = 0;
+    for (; c + 16 <= cols; c += 16) {
+        __m256 accr0 = _mm256_setzero_ps(), acci0 = _mm256_setzero_ps();
+        __m256 accr1 = _mm256_setzero_ps(), acci1 = _mm256_setzero_ps();
+        for (int r = 0; r < rows; r++) {
+            __m256 xr = _mm256_set1_ps(x[r].real), xi = _mm256_set1_ps(s * x[r].imag);
+            const float *ar = &Ar[r * lda + c], *ai = &Ai[r * lda + c];
+            __m256 ar0 = _mm256_loadu_ps(ar), ai0 = _mm256_loadu_ps(ai);
+            __m256 ar1 = _mm256_loadu_ps(ar + 8), ai1 = _mm256_loadu_ps(ai + 8);
+            accr0 = _mm256_add_ps(accr0, _mm256_sub_ps(_mm256_mul_ps(xr, ar0), _mm256_mul_ps(xi, ai0)));
+            acci0 = _mm256_add_ps(acci0, _mm256_add_ps(_mm256_mul_ps(xr, ai0), _mm256_mul_ps(xi, ar0)));
+            accr1 = _mm256_add_ps(accr1, _mm256_sub_ps(_mm256_mul_ps(xr, ar1), _mm256_mul_ps(xi, ai1)));
+            acci1 = _mm256_add_ps(acci1, _mm256_add_ps(_mm256_mul_ps(xr, ai1), _mm256_mul_ps(xi, ar1)));
+        }
+        _mm256_storeu_ps(yr + c, accr0);
+        _mm256_storeu_ps(yi + c, acci0);
+        _mm256_storeu_ps(yr + c + 8, accr1);
+        _mm256_storeu_ps(yi + c + 8, acci1);
+    }
+    for (; c + 8 <= cols; c += 8) {
+        __m256 accr = _mm256_setzero_ps(), acci = _mm256_setzero_ps();
+        for (int r = 0; r < rows; r++) {
+            __m256 xr = _mm256_set1_ps(x[r].real), xi = _mm256_set1_ps(s * x[r].imag);
+            __m256 ar = _mm256_loadu_ps(&Ar[r * lda + c]), ai = _mm256_loadu_ps(&Ai[r * lda + c]);
+            accr = _mm256_add_ps(accr, _mm256_sub_ps(_mm256_mul_ps(xr, ar), _mm256_mul_ps(xi, ai)));
+            acci = _mm256_add_ps(acci, _mm256_add_ps(_mm256_mul_ps(xr, ai), _mm256_mul_ps(xi, ar)));
+        }
+        _mm256_storeu_ps(yr + c, accr);
+        _mm256_storeu_ps(yi + c, acci);
+    }
+    _mm256_zeroupper();
+    vmm_cols(yr, yi, x, Ar, Ai, lda, rows, c, cols, s);
+}
+
+static AVX2_FN void cvmul_avx2(RADE_COMP *y, const RADE_COMP *a, const RADE_COMP *b, int n, int conj_b) {
+    __m256 sign = avx_cmul_sign(conj_b);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256 va = _mm256_loadu_ps((const float *)&a[i]);
+        __m256 vb = _mm256_loadu_ps((const float *)&b[i]);
+        _mm256_storeu_ps((float *)&y[i], avx_cmul(va, vb, sign));
+    }
+    _mm256_zeroupper();
+    cvmul_c(&y[i], &a[i], &b[i], n - i, conj_b);
+}
+
+static AVX2_FN void fir_sym_split_avx2(float *yr, float *yi, const float *xr, const float *xi,
+                                       const float *h, int ntap, int n) {
+    int nh = ntap - 1;
+    int c = nh / 2;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 hc = _mm256_set1_ps(h[c]);
+        __m256 accr = _mm256_mul_ps(hc, _mm256_loadu_ps(xr + i + c));
+        __m256 acci = _mm256_mul_ps(hc, _mm256_loadu_ps(xi + i + c));
+        for (int k = 0; k < c; k++) {
+            __m256 hk = _mm256_set1_ps(h[k]);
+            accr = _mm256_add_ps(accr, _mm256_mul_ps(hk, _mm256_add_ps(_mm256_loadu_ps(xr + i + nh - k),
+                                                                        _mm256_loadu_ps(xr + i + k))));
+            acci = _mm256_add_ps(acci, _mm256_mul_ps(hk, _mm256_add_ps(_mm256_loadu_ps(xi + i + nh - k),
+                                                                        _mm256_loadu_ps(xi + i + k))));
+        }
+        _mm256_storeu_ps(yr + i, accr);
+        _mm256_storeu_ps(yi + i, acci);
+    }
+    _mm256_zeroupper();
+    fir_outputs(yr, yi, xr, xi, h, ntap, i, n);
+}
+
+static AVX2_FN void rotate_avx2(RADE_COMP *y, RADE_COMP *ph, const RADE_COMP *x,
+                                RADE_COMP *phase, RADE_COMP inc, int n) {
+    RADE_COMP incp[4];
+    rotate_powers(incp, inc);
+    __m256 sign = avx_cmul_sign(0);
+    __m256 vinc = _mm256_loadu_ps((const float *)incp);
+
+    RADE_COMP p = *phase;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256 vp = _mm256_setr_ps(p.real, p.imag, p.real, p.imag, p.real, p.imag, p.real, p.imag);
+        __m256 vph = avx_cmul(vp, vinc, sign);
+        __m256 vx = _mm256_loadu_ps((const float *)&x[i]);
+        _mm256_storeu_ps((float *)&ph[i], vph);
+        _mm256_storeu_ps((float *)&y[i], avx_cmul(vx, vph, sign));
+        p = ph[i + 3];
+    }
+    _mm256_zeroupper();
+    *phase = p;
+    rotate_samples(y, ph, x, phase, inc, i, n);
+}
+
+static AVX2_FN void climit_avx2(RADE_COMP *y, const RADE_COMP *x, int n) {
+    const __m256 r2_max = _mm256_set1_ps(CLIMIT_R2_MAX);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256 v = _mm256_loadu_ps((const float *)&x[i]);
+        __m256 sq = _mm256_mul_ps(v, v);
+        __m256 r2 = _mm256_add_ps(sq, AVX_SWAP(sq));
+
+        __m256 p = _mm256_set1_ps(CLIMIT_A13);
+        p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(CLIMIT_A11));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(CLIMIT_A9));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(CLIMIT_A7));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(CLIMIT_A5));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(CLIMIT_A3));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r2), _mm256_set1_ps(CLIMIT_A1));
+        __m256 q = _mm256_set1_ps(CLIMIT_B6);
+        q = _mm256_add_ps(_mm256_mul_ps(q, r2), _mm256_set1_ps(CLIMIT_B4));
+        q = _mm256_add_ps(_mm256_mul_ps(q, r2), _mm256_set1_ps(CLIMIT_B2));
+        q = _mm256_add_ps(_mm256_mul_ps(q, r2), _mm256_set1_ps(CLIMIT_B0));
+
+        __m256 big = _mm256_cmp_ps(r2, r2_max, _CMP_GT_OQ);
+        __m256 g = _mm256_blendv_ps(_mm256_div_ps(p, q), _mm256_div_ps(one, _mm256_sqrt_ps(r2)), big);
+        _mm256_storeu_ps((float *)&y[i], _mm256_mul_ps(v, g));
+    }
+    _mm256_zeroupper();
+    climit_c(&y[i], &x[i], n - i);
+}
+
+static AVX2_FN void s16_to_float_avx2(float *y, const int16_t *x, float scale, int n) {
+    const __m256 s = _mm256_set1_ps(scale);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)&x[i]));
+        _mm256_storeu_ps(&y[i], _mm256_mul_ps(_mm256_cvtepi32_ps(v), s));
+    }
+    _mm256_zeroupper();
+    s16_to_float_c(&y[i], &x[i], scale, n - i);
+}
+
+static AVX2_FN void float_to_s16_avx2(int16_t *y, const float *x, float scale, int n) {
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 lo = _mm256_set1_ps(-32767.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(&x[i]), s);
+        v = _mm256_min_ps(_mm256_max_ps(v, lo), hi);
+        __m256 fl = _mm256_floor_ps(v);
+        __m256 up = _mm256_cmp_ps(_mm256_sub_ps(v, fl), half, _CMP_GE_OQ);
+        __m256i t = _mm256_cvttps_epi32(_mm256_add_ps(fl, _mm256_and_ps(up, one)));
+        _mm_storeu_si128((__m128i *)&y[i], _mm_packs_epi32(_mm256_castsi256_si128(t),
+                                                           _mm256_extracti128_si256(t, 1)));
+    }
+    _mm256_zeroupper();
+    float_to_s16_c(&y[i], &x[i], scale, n - i);
+}
+
+static const rade_kernels kernels_avx2 = {
+    RADE_KERNELS_AVX2, "avx2",
+    cdot_avx2, cmvmul_avx2, cmvmul_real_avx2, cmvmul_split_avx2, cvmmul_split_avx2,
+    cvmul_avx2, fir_sym_split_avx2, rotate_avx2, climit_avx2,
+    s16_to_float_avx2, float_to_s16_avx2
+};
+
+#endif /* RADE_KERNELS_HAVE_AVX2 */
+
+/*---------------------------------------------------------------------------*\
+                                  NEON
+\*---------------------------------------------------------------------------*/
+
+#ifdef RADE_KERNELS_HAVE_NEON
+
+/* Two complex products, sign as sse_cmul() */
+static inline float32x4_t neon_cmul(float32x4_t a, float32x4_t b, float32x4_t sign) {
+    float32x4_t br = vtrn1q_f32(b, b);
+    float32x4_t bi = vtrn2q_f32(b, b);
+    return vaddq_f32(vmulq_f32(a, br), vmulq_f32(vmulq_f32(vrev64q_f32(a), bi), sign));
+}
+
+static inline float32x4_t neon_cmul_sign(int conj_b) {
+    static const float sign[2][4] = {{-1.0f, 1.0f, -1.0f, 1.0f}, {1.0f, -1.0f, 1.0f, -1.0f}};
+    return vld1q_f32(sign[conj_b ? 1 : 0]);
+}
+
+static RADE_COMP cdot_neon(const RADE_COMP *a, const RADE_COMP *b, int n, int conj_a) {
+    const float *af = (const float *)a;
+    const float *bf = (const float *)b;
+    float32x4_t p0 = vdupq_n_f32(0.0f), p1 = vdupq_n_f32(0.0f);
+    float32x4_t q0 = vdupq_n_f32(0.0f), q1 = vdupq_n_f32(0.0f);
+    int nf = 2 * n;
+    int i = 0;
+    for (; i + 8 <= nf; i += 8) {
+        float32x4_t a0 = vld1q_f32(af + i), a1 = vld1q_f32(af + i + 4);
+        float32x4_t b0 = vld1q_f32(bf + i), b1 = vld1q_f32(bf + i + 4);
+        p0 = vaddq_f32(p0, vmulq_f32(a0, b0));
+        p1 = vaddq_f32(p1, vmulq_f32(a1, b1));
+        q0 = vaddq_f32(q0, vmulq_f32(a0, vrev64q_f32(b0)));
+        q1 = vaddq_f32(q1, vmulq_f32(a1, vrev64q_f32(b1)));
+    }
+    float P[8], Q[8];
+    vst1q_f32(P, p0);
+    vst1q_f32(P + 4, p1);
+    vst1q_f32(Q, q0);
+    vst1q_f32(Q + 4, q1);
+    cdot_lanes(P, Q, af, bf, i, nf);
+    return cdot_finish(P, Q, conj_a);
+}
+
+static void cmvmul_neon(RADE_COMP *y, const RADE_COMP *A, const RADE_COMP *x, int rows, int cols) {
+    for (int r = 0; r < rows; r++) {
+        y[r] = cdot_neon(&A[r * cols], x, cols, 0);
+    }
+}
+
+static void cmvmul_real_neon(RADE_COMP *y, const float *A, const RADE_COMP *x, int rows, int cols) {
+    const float *xf = (const float *)x;
+    for (int r = 0; r < rows; r++) {
+        const float *row = &A[r * cols];
+        float32x4_t p0 = vdupq_n_f32(0.0f), p1 = vdupq_n_f32(0.0f);
+        int c = 0;
+        for (; c + 4 <= cols; c += 4) {
+            float32x4_t a = vld1q_f32(row + c);
+            p0 = vaddq_f32(p0, vmulq_f32(vzip1q_f32(a, a), vld1q_f32(xf + 2 * c)));
+            p1 = vaddq_f32(p1, vmulq_f32(vzip2q_f32(a, a), vld1q_f32(xf + 2 * c + 4)));
+        }
+        float P[8];
+        vst1q_f32(P, p0);
+        vst1q_f32(P + 4, p1);
+        rmv_lanes(P, row, xf, c, cols);
+        lanes_even_odd(P, &y[r].real, &y[r].imag);
+    }
+}
+
+static void cmvmul_split_neon(float *yr, float *yi, const float *Ar, const float *Ai, int lda,
+                              const float *xr, const float *xi, int rows, int cols, int conj_a) {
+    float s = conj_a ? -1.0f : 1.0f;
+    float32x4_t vs = vdupq_n_f32(s);
+    for (int r = 0; r < rows; r++) {
+        const float *ar = &Ar[r * lda], *ai = &Ai[r * lda];
+        float32x4_t R[2] = {vdupq_n_f32(0.0f), vdupq_n_f32(0.0f)};
+        float32x4_t I[2] = {vdupq_n_f32(0.0f), vdupq_n_f32(0.0f)};
+        int c = 0;
+        for (; c + 8 <= cols; c += 8) {
+            for (int h = 0; h < 2; h++) {
+                int k = c + 4 * h;
+                float32x4_t vr = vld1q_f32(ar + k);
+                float32x4_t vi = vmulq_f32(vs, vld1q_f32(ai + k));
+                float32x4_t wr = vld1q_f32(xr + k), wi = vld1q_f32(xi + k);
+                R[h] = vaddq_f32(R[h], vsubq_f32(vmulq_f32(vr, wr), vmulq_f32(vi, wi)));
+                I[h] = vaddq_f32(I[h], vaddq_f32(vmulq_f32(vr, wi), vmulq_f32(vi, wr)));
+            }
+        }
+        float Rl[8], Il[8];
+        vst1q_f32(Rl, R[0]);
+        vst1q_f32(Rl + 4, R[1]);
+        vst1q_f32(Il, I[0]);
+        vst1q_f32(Il + 4, I[1]);
+        smv_lanes(Rl, Il, ar, ai, xr, xi, c, cols, s);
+        yr[r] = lanes_sum(Rl);
+        yi[r] = lanes_sum(Il);
+    }
+}
+
+static void cvmmul_split_neon(float *yr, float *yi, const RADE_COMP *x, const float *Ar, const float *Ai,
+                              int lda, int rows, int cols, int conj_x) {
+    float s = conj_x ? -1.0f : 1.0f;
+    int c = 0;
+    for (; c + 4 <= cols; c += 4) {
+        float32x4_t accr = vdupq_n_f32(0.0f), acci = vdupq_n_f32(0.0f);
+        for (int r = 0; r < rows; r++) {
+            float32x4_t xr = vdupq_n_f32(x[r].real), xi = vdupq_n_f32(s * x[r].imag);
+            float32x4_t ar = vld1q_f32(&Ar[r * lda + c]), ai = vld1q_f32(&Ai[r * lda + c]);
+            accr = vaddq_f32(accr, vsubq_f32(vmulq_f32(xr, ar), vmulq_f32(xi, ai)));
+            acci = vaddq_f32(acci, vaddq_f32(vmulq_f32(xr, ai), vmulq_f32(xi, ar)));
+        }
+        vst1q_f32(yr + c, accr);
+        vst1q_f32(yi + c, acci);
+    }
+    vmm_cols(yr, yi, x, Ar, Ai, lda, rows, c, cols, s);
+}
+
+static void cvmul_neon(RADE_COMP *y, const RADE_COMP *a, const RADE_COMP *b, int n, int conj_b) {
+    float32x4_t sign = neon_cmul_sign(conj_b);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float32x4_t va = vld1q_f32((const float *)&a[i]);
+        float32x4_t vb = vld1q_f32((const float *)&b[i]);
+        vst1q_f32((float *)&y[i], neon_cmul(va, vb, sign));
+    }
+    cvmul_c(&y[i], &a[i], &b[i], n - i, conj_b);
+}
+
+static void fir_sym_split_neon(float *yr, float *yi, const float *xr, const float *xi,
+                               const float *h, int ntap, int n) {
+    int nh = ntap - 1;
+    int c = nh / 2;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t hc = vdupq_n_f32(h[c]);
+        float32x4_t accr = vmulq_f32(hc, vld1q_f32(xr + i + c));
+        float32x4_t acci = vmulq_f32(hc, vld1q_f32(xi + i + c));
+        for (int k = 0; k < c; k++) {
+            float32x4_t hk = vdupq_n_f32(h[k]);
+            accr = vaddq_f32(accr, vmulq_f32(hk, vaddq_f32(vld1q_f32(xr + i + nh - k), vld1q_f32(xr + i + k))));
+            acci = vaddq_f32(acci, vmulq_f32(hk, vaddq_f32(vld1q_f32(xi + i + nh - k), vld1q_f32(xi + i + k))));
+        }
+        vst1q_f32(yr + i, accr);
+        vst1q_f32(yi + i, acci);
+    }
+    fir_outputs(yr, yi, xr, xi, h, ntap, i, n);
+}
+
+static void rotate_neon(RADE_COMP *y, RADE_COMP *ph, const RADE_COMP *x,
+                        RADE_COMP *phase, RADE_COMP inc, int n) {
+    RADE_COMP incp[4];
+    rotate_powers(incp, inc);
+    float32x4_t sign = neon_cmul_sign(0);
+    float32x4_t inc01 = vld1q_f32((const float *)&incp[0]);
+    float32x4_t inc23 = vld1q_f32((const float *)&incp[2]);
+
+    RADE_COMP p = *phase;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float pp[4] = {p.real, p.imag, p.real, p.imag};
+        float32x4_t vp = vld1q_f32(pp);
+        float32x4_t ph01 = neon_cmul(vp, inc01, sign);
+        float32x4_t ph23 = neon_cmul(vp, inc23, sign);
+        float32x4_t x01 = vld1q_f32((const float *)&x[i]);
+        float32x4_t x23 = vld1q_f32((const float *)&x[i + 2]);
+        vst1q_f32((float *)&ph[i], ph01);
+        vst1q_f32((float *)&ph[i + 2], ph23);
+        vst1q_f32((float *)&y[i], neon_cmul(x01, ph01, sign));
+        vst1q_f32((float *)&y[i + 2], neon_cmul(x23, ph23, sign));
+        p = ph[i + 3];
+    }
+    *phase = p;
+    rotate_samples(y, ph, x, phase, inc, i, n);
+}
+
+static void climit_neon(RADE_COMP *y, const RADE_COMP *x, int n) {
+    const float32x4_t r2_max = vdupq_n_f32(CLIMIT_R2_MAX);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float32x4_t v = vld1q_f32((const float *)&x[i]);
+        float32x4_t sq = vmulq_f32(v, v);
+        float32x4_t r2 = vaddq_f32(sq, vrev64q_f32(sq));
+
+        float32x4_t p = vdupq_n_f32(CLIMIT_A13);
+        p = vaddq_f32(vmulq_f32(p, r2), vdupq_n_f32(CLIMIT_A11));
+        p = vaddq_f32(vmulq_f32(p, r2), vdupq_n_f32(CLIMIT_A9));
+        p = vaddq_f32(vmulq_f32(p, r2), vdupq_n_f32(CLIMIT_A7));
+        p = vaddq_f32(vmulq_f32(p, r2), vdupq_n_f32(CLIMIT_A5));
+        p = vaddq_f32(vmulq_f32(p, r2), vdupq_n_f32(CLIMIT_A3));
+        p = vaddq_f32(vmulq_f32(p, r2), vdupq_n_f32(CLIMIT_A1));
+        float32x4_t q = vdupq_n_f32(CLIMIT_B6);
+        q = vaddq_f32(vmulq_f32(q, r2), vdupq_n_f32(CLIMIT_B4));
+        q = vaddq_f32(vmulq_f32(q, r2), vdupq_n_f32(CLIMIT_B2));
+        q = vaddq_f32(vmulq_f32(q, r2), vdupq_n_f32(CLIMIT_B0));
+
+        uint32x4_t big = vcgtq_f32(r2, r2_max);
+        float32x4_t g = vbslq_f32(big, vdivq_f32(one, vsqrtq_f32(r2)), vdivq_f32(p, q));
+        vst1q_f32((float *)&y[i], vmulq_f32(v, g));
+    }
+    climit_c(&y[i], &x[i], n - i);
+}
+
+static void s16_to_float_neon(float *y, const int16_t *x, float scale, int n) {
+    const float32x4_t s = vdupq_n_f32(scale);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(&x[i]);
+        vst1q_f32(&y[i], vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), s));
+        vst1q_f32(&y[i + 4], vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), s));
+    }
+    s16_to_float_c(&y[i], &x[i], scale, n - i);
+}
+
+static inline int32x4_t neon_round_s16(float32x4_t x, float32x4_t s) {
+    float32x4_t v = vmulq_f32(x, s);
+    v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(-32767.0f)), vdupq_n_f32(32767.0f));
+    float32x4_t fl = vrndmq_f32(v);
+    uint32x4_t up = vcgeq_f32(vsubq_f32(v, fl), vdupq_n_f32(0.5f));
+    return vsubq_s32(vcvtq_s32_f32(fl), vreinterpretq_s32_u32(up));
+}
+
+static void float_to_s16_neon(int16_t *y, const float *x, float scale, int n) {
+    const float32x4_t s = vdupq_n_f32(scale);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t lo = neon_round_s16(vld1q_f32(&x[i]), s);
+        int32x4_t hi = neon_round_s16(vld1q_f32(&x[i + 4]), s);
+        vst1q_s16(&y[i], vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    float_to_s16_c(&y[i], &x[i], scale, n - i);
+}
+
+static const rade_kernels kernels_neon = {
+    RADE_KERNELS_NEON, "neon",
+    cdot_neon, cmvmul_neon, cmvmul_real_neon, cmvmul_split_neon, cvmmul_split_neon,
+    cvmul_neon, fir_sym_split_neon, rotate_neon, climit_neon,
+    s16_to_float_neon, float_to_s16_neon
+};
+
+#endif /* RADE_KERNELS_HAVE_NEON */
+
+/*---------------------------------------------------------------------------*\
+                              SELECTION
+\*---------------------------------------------------------------------------*/
+
+const rade_kernels *rade_kernels_arch(int arch) {
+    switch (arch) {
+    case RADE_KERNELS_SCALAR:
+        return &kernels_c;
+#ifdef RADE_KERNELS_HAVE_SSE
+    case RADE_KERNELS_SSE:
+        return &kernels_sse;
+#endif
+#ifdef RADE_KERNELS_HAVE_AVX2
+    case RADE_KERNELS_AVX2:
+        return __builtin_cpu_supports("avx2") ? &kernels_avx2 : NULL;
+#endif
+#ifdef RADE_KERNELS_HAVE_NEON
+    case RADE_KERNELS_NEON:
+        return &kernels_neon;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+static const rade_kernels *kernels_best = &kernels_c;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static void kernels_select(void) {
+    static const int order[] = {RADE_KERNELS_AVX2, RADE_KERNELS_SSE, RADE_KERNELS_NEON};
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        const rade_kernels *k = rade_kernels_arch(order[i]);
+        if (k) {
+            kernels_best = k;
+            return;
+        }
+    }
+}
+
+const rade_kernels *rade_kernels_get(void) {
+    pthread_once(&kernels_once, kernels_select);
+    return kernels_best;
+}
@@ -0,0 +1,155 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_kernels.h
+
+  SIMD kernel library for the RADAE DSP: complex dot products, matrix
+  vector multiplies, the folded BPF FIR and the mixer rotator, with
+  scalar, SSE, AVX2 and NEON versions selected at run time.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_KERNELS__
+#define __RADE_KERNELS__
+
+#include "rade_dsp.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                              KERNEL TABLE
+\*---------------------------------------------------------------------------*/
+
+/*
+  Every implementation of a kernel gives bit identical results.  The
+  reductions (cdot, cmvmul, cmvmul_real, cmvmul_split) accumulate in 8
+  float lanes, lane l taking float l of each 8 float block, and combine
+  the lanes in a fixed order; the scalar code uses the same lanes.  The
+  other kernels keep the element order of a plain C loop.  This needs no
+  contraction of a*b+c into FMA, so rade_kernels.c is built with
+  -ffp-contract=off (and -fno-tree-vectorize on GCC, see CMakeLists.txt).
+
+  Complex buffers are either interleaved RADE_COMP or split into real and
+  imag float arrays ("split"), which need no shuffles and suit the kernels
+  that vectorise across a matrix row.
+*/
+
+#define RADE_KERNELS_SCALAR     0
+#define RADE_KERNELS_SSE        1       /* x86 SSE2 */
+#define RADE_KERNELS_AVX2       2       /* x86 AVX2, checked at run time */
+#define RADE_KERNELS_NEON       3       /* aarch64 Advanced SIMD */
+#define RADE_KERNELS_N          4
+
+typedef struct {
+    int arch;                               /* RADE_KERNELS_xxx */
+    const char *name;
+
+    /* sum(op(a[i]) * b[i]), op() is conj() if conj_a */
+    RADE_COMP (*cdot)(const RADE_COMP *a, const RADE_COMP *b, int n, int conj_a);
+
+    /* y = A * x, A is [rows x cols] row major */
+    void (*cmvmul)(RADE_COMP *y, const RADE_COMP *A, const RADE_COMP *x, int rows, int cols);
+
+    /* y = A * x, A is [rows x cols] real, row major */
+    void (*cmvmul_real)(RADE_COMP *y, const float *A, const RADE_COMP *x, int rows, int cols);
+
+    /* y[r] = sum_c(op(A[r][c]) * x[c]), op() is conj() if conj_a.  A is
+       split with row stride lda, x and y are split */
+    void (*cmvmul_split)(float *yr, float *yi, const float *Ar, const float *Ai, int lda,
+                         const float *xr, const float *xi, int rows, int cols, int conj_a);
+
+    /* y[c] = sum_r(op(x[r]) * A[r][c]), op() is conj() if conj_x.  A is
+       split with row stride lda, y is split */
+    void (*cvmmul_split)(float *yr, float *yi, const RADE_COMP *x, const float *Ar, const float *Ai,
+                         int lda, int rows, int cols, int conj_x);
+
+    /* y[i] = a[i] * op(b[i]), op() is conj() if conj_b.  y may alias a or b */
+    void (*cvmul)(RADE_COMP *y, const RADE_COMP *a, const RADE_COMP *b, int n, int conj_b);
+
+    /* Symmetric complex FIR on split samples, ntap odd:
+       y[i] = sum_k(h[k] * x[i + ntap-1 - k]), with x the ntap-1 samples of
+       history followed by the n new ones.  h[k] and h[ntap-1-k] are folded
+       into one multiply of the sample pair */
+    void (*fir_sym_split)(float *yr, float *yi, const float *xr, const float *xi,
+                          const float *h, int ntap, int n);
+
+    /* Mixer: ph[i] = *phase * inc^(i+1), y[i] = x[i] * ph[i], then *phase =
+       ph[n-1].  The phase steps 4 samples at a time, ph[4b+l] =
+       ph[4b-1] * inc^(l+1), with single steps for the last n % 4 samples.
+       y may alias x */
+    void (*rotate)(RADE_COMP *y, RADE_COMP *ph, const RADE_COMP *x,
+                   RADE_COMP *phase, RADE_COMP inc, int n);
+
+    /* PA model y[i] = tanh(|x[i]|) * x[i]/|x[i]|, rade_tanh_limit() without
+       the polar conversion: the gain tanh(r)/r is a rational function of
+       |x|^2, within 4e-7 of tanhf().  y may alias x */
+    void (*climit)(RADE_COMP *y, const RADE_COMP *x, int n);
+
+    /* PCM samples to float, y[i] = x[i] * scale.  With a power of two
+       scale (1/32768) this is exactly x[i] / 32768 */
+    void (*s16_to_float)(float *y, const int16_t *x, float scale, int n);
+
+    /* Float to PCM, y[i] = floor(v + 0.5) with v = x[i] * scale clamped to
+       +/- 32767, the rounding lpcnet_demo uses.  x must be finite */
+    void (*float_to_s16)(int16_t *y, const float *x, float scale, int n);
+} rade_kernels;
+
+/* Best kernels for this CPU, chosen on the first call */
+const rade_kernels *rade_kernels_get(void);
+
+/* A particular implementation, NULL if it isn't built in or this CPU
+   doesn't support it.  For benchmarks and cross checks */
+const rade_kernels *rade_kernels_arch(int arch);
+
+/*---------------------------------------------------------------------------*\
+                            SPLIT BUFFERS
+\*---------------------------------------------------------------------------*/
+
+static inline void rade_csplit(float *re, float *im, const RADE_COMP *x, int n) {
+    for (int i = 0; i < n; i++) {
+        re[i] = x[i].real;
+        im[i] = x[i].imag;
+    }
+}
+
+static inline void rade_cjoin(RADE_COMP *x, const float *re, const float *im, int n) {
+    for (int i = 0; i < n; i++) {
+        x[i].real = re[i];
+        x[i].imag = im[i];
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_KERNELS__ */
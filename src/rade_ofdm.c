@@ -34,6 +34,7 @@
 */
 
 #include "rade_ofdm.h"
+#include "rade_tables.h"
 #include <string.h>
 #include <assert.h>
 
@@ -41,167 +42,65 @@
                            INITIALIZATION
 \*---------------------------------------------------------------------------*/
 
-void rade_ofdm_init(rade_ofdm *ofdm, int bottleneck) {
-    int Nc = RADE_NC;
-    int M = RADE_M;
-    int Ncp = RADE_NCP;
-    int Ns = RADE_NS;
-    float Fs = (float)RADE_FS;
-
-    ofdm->nc = Nc;
-    ofdm->m = M;
-    ofdm->ncp = Ncp;
-    ofdm->ns = Ns;
-    ofdm->bottleneck = bottleneck;
-    ofdm->local_path_delay_s = 0.0025f;  /* 2.5ms assumed path delay */
-
-    /* Calculate carrier frequencies
-       Centre signal on 1500 Hz (middle of SSB passband)
-       Rs' = Fs/M is the symbol rate with pilots and CP */
-    float Rs_dash = Fs / M;
-    float carrier_1_freq = 1500.0f - Rs_dash * Nc / 2.0f;
-    int carrier_1_index = (int)roundf(carrier_1_freq / Rs_dash);
-
-    for (int c = 0; c < Nc; c++) {
-        ofdm->w[c] = 2.0f * M_PI * (carrier_1_index + c) / M;
-    }
-
-    /* Compute IDFT matrix (Tx): Winv[c][n] = exp(j*w[c]*n) / M
-       freq_in[Nc] * Winv[Nc][M] -> time_out[M] */
-    for (int c = 0; c < Nc; c++) {
-        for (int n = 0; n < M; n++) {
-            float theta = ofdm->w[c] * n;
-            ofdm->Winv[c][n] = rade_cscale(rade_cexp(theta), 1.0f / M);
-        }
-    }
-
-    /* Compute DFT matrix (Rx): Wfwd[n][c] = exp(-j*w[c]*n)
-       time_in[M] * Wfwd[M][Nc] -> freq_out[Nc] */
-    for (int n = 0; n < M; n++) {
-        for (int c = 0; c < Nc; c++) {
-            float theta = -ofdm->w[c] * n;
-            ofdm->Wfwd[n][c] = rade_cexp(theta);
-        }
-    }
-
-    /* Generate pilot symbols */
-    rade_barker_pilots(ofdm->P, Nc);
-    rade_eoo_pilots(ofdm->Pend, ofdm->P, Nc);
-
-    /* Compute pilot gain for bottleneck 3 (PA saturation) */
-    if (bottleneck == 3) {
-        float pilot_backoff = powf(10.0f, -2.0f / 20.0f);  /* -2 dB backoff */
-        ofdm->pilot_gain = pilot_backoff * M / sqrtf((float)Nc);
-    } else {
-        ofdm->pilot_gain = 1.0f;
-    }
+/* Direct DFT engine, rade_tables_gen computes the pilots the same way so
+   they are independent of the engine selected */
+static void ofdm_idft_direct(const rade_ofdm *ofdm, RADE_COMP *time_out, const RADE_COMP *freq_in) {
+    int M = ofdm->m;
+    float re[RADE_M], im[RADE_M];
 
-    /* Compute time-domain pilots: p = P * Winv^T */
-    memset(ofdm->p, 0, sizeof(ofdm->p));
-    memset(ofdm->pend, 0, sizeof(ofdm->pend));
+    /* time_out[n] = sum(freq_in[c] * Wc[c][n]) / M */
+    ofdm->kern->cvmmul_split(re, im, freq_in, &ofdm->Wc_re[0][0], &ofdm->Wc_im[0][0],
+                             RADE_M, ofdm->nc, M, 0);
     for (int n = 0; n < M; n++) {
-        for (int c = 0; c < Nc; c++) {
-            ofdm->p[n] = rade_cadd(ofdm->p[n], rade_cmul(ofdm->P[c], ofdm->Winv[c][n]));
-            ofdm->pend[n] = rade_cadd(ofdm->pend[n], rade_cmul(ofdm->Pend[c], ofdm->Winv[c][n]));
-        }
-    }
-
-    /* Compute time-domain pilots with cyclic prefix */
-    if (Ncp > 0) {
-        /* Copy pilot to p_cp with CP at front */
-        for (int n = 0; n < M; n++) {
-            ofdm->p_cp[Ncp + n] = ofdm->p[n];
-            ofdm->pend_cp[Ncp + n] = ofdm->pend[n];
-        }
-        /* Cyclic prefix is last Ncp samples copied to front */
-        for (int n = 0; n < Ncp; n++) {
-            ofdm->p_cp[n] = ofdm->p[M - Ncp + n];
-            ofdm->pend_cp[n] = ofdm->pend[M - Ncp + n];
-        }
-    }
-
-    /* Pre-compute EOO frame:
-       Normal frame: ...PDDDDP...
-       EOO frame:    ...PE000E... (P=pilot, E=EOO pilot, D=data, 0=zeros)
-       Frame structure: [p_cp][pend_cp][zeros...][pend_cp] */
-    int Nmf = (Ns + 1) * (M + Ncp);
-    memset(ofdm->eoo, 0, sizeof(ofdm->eoo));
-
-    /* First pilot symbol */
-    for (int n = 0; n < M + Ncp; n++) {
-        ofdm->eoo[n] = rade_cscale(ofdm->p_cp[n], ofdm->pilot_gain);
-    }
-    /* Second symbol is EOO pilot */
-    for (int n = 0; n < M + Ncp; n++) {
-        ofdm->eoo[M + Ncp + n] = rade_cscale(ofdm->pend_cp[n], ofdm->pilot_gain);
-    }
-    /* Last symbol is EOO pilot */
-    for (int n = 0; n < M + Ncp; n++) {
-        ofdm->eoo[Nmf + n] = rade_cscale(ofdm->pend_cp[n], ofdm->pilot_gain);
-    }
-
-    /* Apply PA saturation to EOO frame if bottleneck == 3 */
-    if (bottleneck == 3) {
-        for (int n = 0; n < RADE_NEOO; n++) {
-            ofdm->eoo[n] = rade_tanh_limit(ofdm->eoo[n]);
-        }
+        time_out[n] = rade_cscale(rade_cmplx(re[n], im[n]), 1.0f / M);
     }
-    ofdm->n_eoo = Nmf + M + Ncp;
-
-    /* Pre-compute equalization matrices for 3-pilot LS fit
-       For each carrier c, we fit: h = g0 + g1*exp(-j*w[c]*a)
-       where a = local_path_delay_s * Fs
-       Using pilots at c-1, c, c+1 (edge carriers use adjusted indices) */
-    float a = ofdm->local_path_delay_s * Fs;
+}
 
-    for (int c = 0; c < Nc; c++) {
-        int c_mid = c;
-        /* Handle edge carriers */
-        if (c == 0) c_mid = 1;
-        if (c == Nc - 1) c_mid = Nc - 2;
-
-        /* Build 3x2 matrix A for LS fit */
-        /* A = [[1, exp(-j*w[c_mid-1]*a)],
-               [1, exp(-j*w[c_mid]*a)],
-               [1, exp(-j*w[c_mid+1]*a)]] */
-        RADE_COMP A[3][2];
-        for (int i = 0; i < 3; i++) {
-            A[i][0] = rade_cone();
-            A[i][1] = rade_cexp(-ofdm->w[c_mid - 1 + i] * a);
-        }
+static void ofdm_dft_direct(const rade_ofdm *ofdm, RADE_COMP *freq_out, const RADE_COMP *time_in) {
+    int M = ofdm->m;
+    int Nc = ofdm->nc;
+    float re[RADE_M], im[RADE_M];
+    float fre[RADE_NC], fim[RADE_NC];
+
+    /* freq_out[c] = sum(conj(Wc[c][n]) * time_in[n]) */
+    rade_csplit(re, im, time_in, M);
+    ofdm->kern->cmvmul_split(fre, fim, &ofdm->Wc_re[0][0], &ofdm->Wc_im[0][0], RADE_M,
+                             re, im, Nc, M, 1);
+    rade_cjoin(freq_out, fre, fim, Nc);
+}
 
-        /* Compute A^H * A (2x2 Hermitian matrix) */
-        RADE_COMP AHA[2][2];
-        for (int i = 0; i < 2; i++) {
-            for (int j = 0; j < 2; j++) {
-                AHA[i][j] = rade_czero();
-                for (int k = 0; k < 3; k++) {
-                    /* AHA[i][j] += conj(A[k][i]) * A[k][j] */
-                    AHA[i][j] = rade_cadd(AHA[i][j], rade_cmul(rade_cconj(A[k][i]), A[k][j]));
-                }
-            }
-        }
+void rade_ofdm_init(rade_ofdm *ofdm, int bottleneck, int engine) {
+    const rade_ofdm_tables *tab = &rade_ofdm_tab;
+    const rade_eoo_tables *eoo = bottleneck == 3 ? &rade_eoo_limited : &rade_eoo_linear;
 
-        /* Compute (A^H * A)^-1 (2x2 inverse) */
-        RADE_COMP det = rade_csub(rade_cmul(AHA[0][0], AHA[1][1]), rade_cmul(AHA[0][1], AHA[1][0]));
-        RADE_COMP AHAinv[2][2];
-        AHAinv[0][0] = rade_cdiv(AHA[1][1], det);
-        AHAinv[0][1] = rade_cdiv(rade_cscale(AHA[0][1], -1.0f), det);
-        AHAinv[1][0] = rade_cdiv(rade_cscale(AHA[1][0], -1.0f), det);
-        AHAinv[1][1] = rade_cdiv(AHA[0][0], det);
-
-        /* Compute Pmat = (A^H * A)^-1 * A^H (2x3 matrix) */
-        for (int i = 0; i < 2; i++) {
-            for (int j = 0; j < 3; j++) {
-                ofdm->Pmat[c][i][j] = rade_czero();
-                for (int k = 0; k < 2; k++) {
-                    /* Pmat[i][j] += AHAinv[i][k] * conj(A[j][k]) */
-                    ofdm->Pmat[c][i][j] = rade_cadd(ofdm->Pmat[c][i][j],
-                        rade_cmul(AHAinv[i][k], rade_cconj(A[j][k])));
-                }
-            }
-        }
-    }
+    ofdm->nc = RADE_NC;
+    ofdm->m = RADE_M;
+    ofdm->ncp = RADE_NCP;
+    ofdm->ns = RADE_NS;
+    ofdm->bottleneck = bottleneck;
+    ofdm->local_path_delay_s = tab->local_path_delay_s;
+
+    ofdm->k0 = tab->k0;
+    ofdm->W = tab->W;
+    ofdm->Wc_re = tab->Wc_re;
+    ofdm->Wc_im = tab->Wc_im;
+    ofdm->kern = rade_kernels_get();
+    ofdm->fft = &rade_fft_ofdm;
+    ofdm->engine = engine == RADE_OFDM_ENGINE_FFT ? RADE_OFDM_ENGINE_FFT : RADE_OFDM_ENGINE_DIRECT;
+
+    ofdm->w = tab->w;
+    ofdm->P = tab->P;
+    ofdm->Pend = tab->Pend;
+    ofdm->p = tab->p;
+    ofdm->pend = tab->pend;
+    ofdm->p_cp = tab->p_cp;
+    ofdm->pend_cp = tab->pend_cp;
+    ofdm->Pmat = tab->Pmat;
+
+    /* Pilot gain and PA saturation for bottleneck 3 */
+    ofdm->pilot_gain = eoo->pilot_gain;
+    ofdm->eoo = eoo->eoo;
+    ofdm->n_eoo = eoo->n_eoo;
 }
 
 /*---------------------------------------------------------------------------*\
@@ -213,11 +112,21 @@ void rade_ofdm_idft(const rade_ofdm *ofdm, RADE_COMP *time_out, const RADE_COMP
     int M = ofdm->m;
     int Nc = ofdm->nc;
 
+    if (ofdm->engine != RADE_OFDM_ENGINE_FFT) {
+        ofdm_idft_direct(ofdm, time_out, freq_in);
+        return;
+    }
+
+    /* Carriers into their bins, all other bins empty */
+    RADE_COMP X[RADE_M];
+    memset(X, 0, sizeof(RADE_COMP) * M);
+    for (int c = 0; c < Nc; c++) {
+        X[ofdm->k0 + c] = freq_in[c];
+    }
+
+    rade_ifft(ofdm->fft, time_out, X);
     for (int n = 0; n < M; n++) {
-        time_out[n] = rade_czero();
-        for (int c = 0; c < Nc; c++) {
-            time_out[n] = rade_cadd(time_out[n], rade_cmul(freq_in[c], ofdm->Winv[c][n]));
-        }
+        time_out[n] = rade_cscale(time_out[n], 1.0f / M);
     }
 }
 
@@ -236,8 +145,53 @@ void rade_ofdm_insert_cp(const rade_ofdm *ofdm, RADE_COMP *time_out, const RADE_
     }
 }
 
+/* FFT engine modulator.  Each symbol's IFFT lands straight in tx_out
+   after its CP, and the CP is copied back from its tail, the 1/M is
+   folded into the Nc carriers rather than the M outputs, and the PA model
+   runs over the whole frame with the polar free kernel.  The pilot symbol
+   never changes, so it comes from the EOO frame, which starts with it */
+static int ofdm_mod_frame_fft(const rade_ofdm *ofdm, RADE_COMP *tx_out, const float *z) {
+    int Nc = ofdm->nc;
+    int M = ofdm->m;
+    int Ncp = ofdm->ncp;
+    int Ns = ofdm->ns;
+    int Nsym = M + Ncp;
+
+    memcpy(tx_out, ofdm->eoo, sizeof(RADE_COMP) * Nsym);
+
+    RADE_COMP X[RADE_M];
+    memset(X, 0, sizeof(RADE_COMP) * M);
+    RADE_COMP *bins = &X[ofdm->k0];
+
+    for (int s = 0; s < Ns; s++) {
+        const float *zs = &z[2 * Nc * s];
+        for (int c = 0; c < Nc; c++) {
+            bins[c] = rade_cmplx(zs[2 * c], zs[2 * c + 1]);
+        }
+        if (ofdm->bottleneck == 2) {
+            ofdm->kern->climit(bins, bins, Nc);
+        }
+        for (int c = 0; c < Nc; c++) {
+            bins[c] = rade_cscale(bins[c], 1.0f / M);
+        }
+
+        RADE_COMP *sym = &tx_out[(s + 1) * Nsym];
+        rade_ifft(ofdm->fft, &sym[Ncp], X);
+        memcpy(sym, &sym[M], sizeof(RADE_COMP) * Ncp);
+    }
+
+    if (ofdm->bottleneck == 3) {
+        ofdm->kern->climit(&tx_out[Nsym], &tx_out[Nsym], Ns * Nsym);
+    }
+    return (Ns + 1) * Nsym;
+}
+
 /* Modulate one modem frame */
 int rade_ofdm_mod_frame(const rade_ofdm *ofdm, RADE_COMP *tx_out, const float *z) {
+    if (ofdm->engine == RADE_OFDM_ENGINE_FFT) {
+        return ofdm_mod_frame_fft(ofdm, tx_out, z);
+    }
+
     int Nc = ofdm->nc;
     int M = ofdm->m;
     int Ncp = ofdm->ncp;
@@ -325,14 +279,17 @@ int rade_ofdm_mod_frame(const rade_ofdm *ofdm, RADE_COMP *tx_out, const float *z
 
 /* DFT: time_in[M] -> freq_out[Nc] */
 void rade_ofdm_dft(const rade_ofdm *ofdm, RADE_COMP *freq_out, const RADE_COMP *time_in) {
-    int M = ofdm->m;
     int Nc = ofdm->nc;
 
+    if (ofdm->engine != RADE_OFDM_ENGINE_FFT) {
+        ofdm_dft_direct(ofdm, freq_out, time_in);
+        return;
+    }
+
+    RADE_COMP X[RADE_M];
+    rade_fft(ofdm->fft, X, time_in);
     for (int c = 0; c < Nc; c++) {
-        freq_out[c] = rade_czero();
-        for (int n = 0; n < M; n++) {
-            freq_out[c] = rade_cadd(freq_out[c], rade_cmul(time_in[n], ofdm->Wfwd[n][c]));
-        }
+        freq_out[c] = X[ofdm->k0 + c];
     }
 }
 
@@ -38,6 +38,8 @@
 #define __RADE_OFDM__
 
 #include "rade_dsp.h"
+#include "rade_fft.h"
+#include "rade_kernels.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -47,6 +49,10 @@ extern "C" {
                               OFDM STATE
 \*---------------------------------------------------------------------------*/
 
+/* DFT/IDFT engines for rade_ofdm_dft() and rade_ofdm_idft() */
+#define RADE_OFDM_ENGINE_DIRECT 0       /* Nc x M complex MACs per symbol */
+#define RADE_OFDM_ENGINE_FFT    1       /* M point mixed radix FFT, Nc bins used */
+
 typedef struct {
     /* Configuration */
     int nc;                                     /* Number of carriers */
@@ -55,29 +61,42 @@ typedef struct {
     int ns;                                     /* Data symbols per modem frame */
     int bottleneck;                             /* Bottleneck mode (1, 2, or 3) */
 
-    /* DFT matrices - pre-computed at init */
-    RADE_COMP Winv[RADE_NC][RADE_M];           /* IDFT matrix (Tx): Nc freq -> M time */
-    RADE_COMP Wfwd[RADE_M][RADE_NC];           /* DFT matrix (Rx): M time -> Nc freq */
+    /* DFT engine.  The carriers sit on integer bins k0..k0+Nc-1 of an M
+       point DFT, so the direct engine only needs the M roots of unity
+       (indexed by k*n mod M) and the FFT engine can use the full transform.
+       The direct engine reads them through the carrier matrix Wc, split
+       into real and imag for the SIMD kernels.
+
+       The tables below depend only on compile time constants, they point
+       into the read only tables generated at build time (rade_tables.h)
+       and are shared by every context */
+    int engine;                                 /* RADE_OFDM_ENGINE_xxx in use */
+    int k0;                                     /* DFT bin of first carrier */
+    const RADE_COMP *W;                         /* W[n] = exp(j*2*pi*n/M) */
+    const float (*Wc_re)[RADE_M];               /* Wc[c][n] = W[(k0+c)*n mod M] */
+    const float (*Wc_im)[RADE_M];
+    const rade_kernels *kern;                   /* SIMD kernels for this CPU */
+    const rade_fft_state *fft;                  /* M point FFT (FFT engine) */
 
     /* Carrier frequencies */
-    float w[RADE_NC];                           /* Angular frequency per carrier */
+    const float *w;                             /* Angular frequency per carrier */
 
     /* Pilot symbols */
-    RADE_COMP P[RADE_NC];                       /* Normal pilot symbols (Barker) */
-    RADE_COMP Pend[RADE_NC];                    /* End-of-over pilot symbols */
-    RADE_COMP p[RADE_M];                        /* Time-domain pilot (no CP) */
-    RADE_COMP pend[RADE_M];                     /* Time-domain EOO pilot (no CP) */
-    RADE_COMP p_cp[RADE_M + RADE_NCP];          /* Time-domain pilot with CP */
-    RADE_COMP pend_cp[RADE_M + RADE_NCP];       /* Time-domain EOO pilot with CP */
+    const RADE_COMP *P;                         /* Normal pilot symbols (Barker) */
+    const RADE_COMP *Pend;                      /* End-of-over pilot symbols */
+    const RADE_COMP *p;                         /* Time-domain pilot (no CP) */
+    const RADE_COMP *pend;                      /* Time-domain EOO pilot (no CP) */
+    const RADE_COMP *p_cp;                      /* Time-domain pilot with CP */
+    const RADE_COMP *pend_cp;                   /* Time-domain EOO pilot with CP */
     float pilot_gain;                           /* Pilot amplitude scaling */
 
-    /* Pre-computed EOO frame */
-    RADE_COMP eoo[RADE_NEOO];                   /* Complete EOO frame */
+    /* Pre-computed EOO frame, for this bottleneck */
+    const RADE_COMP *eoo;                       /* Complete EOO frame */
     int n_eoo;                                  /* EOO frame length */
 
-    /* Equalization matrices - pre-computed at init */
+    /* Equalization matrices */
     /* For 3-pilot least-squares fit: Pmat[c] = (A^H A)^-1 A^H */
-    RADE_COMP Pmat[RADE_NC][2][3];              /* Per-carrier EQ matrices */
+    const RADE_COMP (*Pmat)[2][3];              /* Per-carrier EQ matrices */
     float local_path_delay_s;                   /* Assumed path delay for LS EQ */
 
 } rade_ofdm;
@@ -87,11 +106,11 @@ typedef struct {
 \*---------------------------------------------------------------------------*/
 
 /* Initialize OFDM state with default parameters
-   - Computes DFT matrices
-   - Generates pilot symbols
-   - Pre-computes EOO frame
-   - Pre-computes equalization matrices */
-void rade_ofdm_init(rade_ofdm *ofdm, int bottleneck);
+   - Selects the DFT engine
+   - Points at the shared pilot, EOO frame and equalization tables
+   engine: RADE_OFDM_ENGINE_DIRECT or RADE_OFDM_ENGINE_FFT.  Pilots and the
+           EOO frame are identical for both. */
+void rade_ofdm_init(rade_ofdm *ofdm, int bottleneck, int engine);
 
 /*---------------------------------------------------------------------------*\
                            MODULATION (TX)
@@ -107,6 +126,10 @@ void rade_ofdm_insert_cp(const rade_ofdm *ofdm, RADE_COMP *time_out, const RADE_
 
 /* Modulate one modem frame of latent vectors to time-domain samples
    z[nzmf][latent_dim] -> tx_out[nmf]
+   The direct engine is the reference, symbol by symbol with exact tanhf()
+   PA saturation.  The FFT engine assembles the frame in place and uses the
+   rade_kernels climit() PA model, the same to float rounding (rel err
+   ~1e-6, see rade_ofdm_bench).
    Returns number of output samples */
 int rade_ofdm_mod_frame(const rade_ofdm *ofdm, RADE_COMP *tx_out, const float *z);
 
@@ -0,0 +1,156 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_pool.c
+
+  Small fork/join worker pool, see rade_pool.h.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "rade_pool.h"
+
+/* Each run bumps gen under the lock and wakes the workers, who note the
+   gen they've run and count themselves back in through pending.  The
+   mutex orders everything either side of a run */
+struct rade_pool {
+    int n;                                      /* workers including the caller */
+    pthread_t thread[RADE_POOL_MAX_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned gen;                               /* runs so far */
+    int pending;                                /* workers still in this run */
+    int quit;
+    rade_pool_fn fn;
+    void *arg;
+    struct pool_worker {
+        struct rade_pool *pool;
+        int i;
+    } worker[RADE_POOL_MAX_THREADS];
+};
+
+static void *pool_thread(void *p) {
+    struct pool_worker *w = (struct pool_worker *)p;
+    rade_pool *pool = w->pool;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->gen == seen && !pool->quit) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen = pool->gen;
+        rade_pool_fn fn = pool->fn;
+        void *arg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        fn(arg, w->i, pool->n);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+rade_pool *rade_pool_create(int n_threads) {
+    if (n_threads < 1 || n_threads > RADE_POOL_MAX_THREADS) {
+        return NULL;
+    }
+    rade_pool *pool = (rade_pool *)calloc(1, sizeof(rade_pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    pool->n = 1;
+    for (int i = 1; i < n_threads; i++) {
+        pool->worker[i].pool = pool;
+        pool->worker[i].i = i;
+        if (pthread_create(&pool->thread[i], NULL, pool_thread, &pool->worker[i]) != 0) {
+            rade_pool_destroy(pool);
+            return NULL;
+        }
+        pool->n++;
+    }
+    return pool;
+}
+
+void rade_pool_destroy(rade_pool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->n; i++) {
+        pthread_join(pool->thread[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+int rade_pool_size(const rade_pool *pool) {
+    return pool->n;
+}
+
+void rade_pool_run(rade_pool *pool, rade_pool_fn fn, void *arg) {
+    if (pool->n > 1) {
+        pthread_mutex_lock(&pool->lock);
+        pool->fn = fn;
+        pool->arg = arg;
+        pool->pending = pool->n - 1;
+        pool->gen++;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    fn(arg, 0, pool->n);
+
+    if (pool->n > 1) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->pending > 0) {
+            pthread_cond_wait(&pool->done, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
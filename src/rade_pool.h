@@ -0,0 +1,72 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_pool.h
+
+  Small fork/join worker pool: runs one function on every worker and
+  waits for them all, for splitting a per frame search across cores.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_POOL__
+#define __RADE_POOL__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADE_POOL_MAX_THREADS   16
+
+/* fn(arg, i, n) runs once for each worker i of n */
+typedef void (*rade_pool_fn)(void *arg, int i, int n);
+
+typedef struct rade_pool rade_pool;
+
+/* A pool of n_threads workers, the thread calling rade_pool_run() being
+   worker 0, so n_threads - 1 threads are started.  They take the
+   scheduling policy and CPU affinity of the thread creating the pool and
+   sleep between runs.  Returns NULL if n_threads is out of range or the
+   threads can't be started */
+rade_pool *rade_pool_create(int n_threads);
+
+/* Stops and joins the workers, NULL is fine */
+void rade_pool_destroy(rade_pool *pool);
+
+int rade_pool_size(const rade_pool *pool);
+
+/* Calls fn(arg, i, n) on every worker, i = 0 on this thread, and returns
+   once all have returned.  Everything written before the call is visible
+   to fn, and everything fn writes is visible after.  One caller at a time */
+void rade_pool_run(rade_pool *pool, rade_pool_fn fn, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_POOL__ */
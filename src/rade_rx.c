@@ -34,15 +34,46 @@
 */
 
 #include "rade_rx.h"
-#include "rade_dec_data.h"
+#include "rade_trace.h"
+#include <stddef.h>
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
 
+/* Samples per step of the frequency correction phase recurrence */
+#define RX_ROT_BLOCK 8
+
 /*---------------------------------------------------------------------------*\
                            INITIALIZATION
 \*---------------------------------------------------------------------------*/
 
+/* Squelch and Rx BPF (if enabled) for signals within +/- frange Hz of
+   the carriers.  The BPF passes 1.2x the carriers' span, plus bpf_extra
+   Hz either side for a wide acquisition range.  A configured squelch
+   keeps its settings */
+static void rx_band_init(rade_rx_state *rx, float frange, float bpf_extra) {
+    float w_min = rx->ofdm.w[0];
+    float w_max = rx->ofdm.w[RADE_NC - 1];
+    float Rs_dash = (float)RADE_FS / RADE_M;
+
+    float open_dB = rx->sql.open_dB;
+    int hang = rx->sql.hang;
+    int search_every = rx->sql.search_every;
+    rade_sql_init(&rx->sql, RADE_FS,
+                  w_min * RADE_FS / (2.0f * M_PI) - Rs_dash / 2.0f,
+                  w_max * RADE_FS / (2.0f * M_PI) + Rs_dash / 2.0f,
+                  frange);
+    if (open_dB > 0.0f) {
+        rade_sql_config(&rx->sql, open_dB, hang, search_every);
+    }
+
+    if (rx->bpf_en) {
+        float bandwidth = 1.2f * (w_max - w_min) * RADE_FS / (2.0f * M_PI) + 2.0f * bpf_extra;
+        float centre = (w_max + w_min) * RADE_FS / (2.0f * M_PI) / 2.0f;
+        rade_bpf_init(&rx->bpf, RADE_BPF_NTAP, RADE_FS, bandwidth, centre, RADE_FS, RADE_BPF_DIRECT);
+    }
+}
+
 int rade_rx_init(rade_rx_state *rx, const RADEDec *dec_model, int bottleneck, int auxdata, int bpf_en) {
     memset(rx, 0, sizeof(rade_rx_state));
 
@@ -55,31 +86,22 @@ int rade_rx_init(rade_rx_state *rx, const RADEDec *dec_model, int bottleneck, in
     rx->verbose = 2;
 
     /* Initialize OFDM demodulator */
-    rade_ofdm_init(&rx->ofdm, bottleneck);
+    rade_ofdm_init(&rx->ofdm, bottleneck, RADE_OFDM_ENGINE_FFT);
 
     /* Initialize acquisition */
-    rade_acq_init(&rx->acq, &rx->ofdm, RADE_ACQ_FRANGE, RADE_ACQ_FSTEP);
+    rade_acq_init(&rx->acq, &rx->ofdm, RADE_ACQ_ENGINE_FFT);
 
-    /* Initialize decoder if model provided */
-    if (dec_model != NULL) {
-        memcpy(&rx->dec_model, dec_model, sizeof(RADEDec));
-    } else {
-        /* Use built-in weights */
-        int output_dim = rx->num_features * RADE_FRAMES_PER_STEP;
-        if (init_radedec(&rx->dec_model, radedec_arrays, output_dim) != 0) {
-            return -1;
-        }
-    }
-    rade_init_decoder(&rx->dec_state);
+    /* Acquisition squelch over the carriers' band (disabled until
+       configured), and the Rx BPF if enabled */
+    rx_band_init(rx, RADE_ACQ_FRANGE, 0.0f);
 
-    /* Initialize Rx BPF if enabled */
-    if (bpf_en) {
-        float w_min = rx->ofdm.w[0];
-        float w_max = rx->ofdm.w[RADE_NC - 1];
-        float bandwidth = 1.2f * (w_max - w_min) * RADE_FS / (2.0f * M_PI);
-        float centre = (w_max + w_min) * RADE_FS / (2.0f * M_PI) / 2.0f;
-        rade_bpf_init(&rx->bpf, RADE_BPF_NTAP, RADE_FS, bandwidth, centre, RADE_FS);
+    /* Decoder weights are shared, we only keep the recurrent state */
+    if (dec_model == NULL) {
+        fprintf(stderr, "rade_rx_init: no decoder model\n");
+        return -1;
     }
+    rx->dec_model = dec_model;
+    rade_init_decoder(&rx->dec_state);
 
     /* Initialize state machine */
     rx->state = RADE_STATE_SEARCH;
@@ -90,9 +112,12 @@ int rade_rx_init(rade_rx_state *rx, const RADEDec *dec_model, int bottleneck, in
     /* Calculate unsync timeout (modem frames) */
     rx->Nmf_unsync = (int)(RADE_TUNSYNC * RADE_FS / RADE_NMF);
     rx->synced_count_one_sec = RADE_FS / RADE_NMF;
+    rx->fade_count = -1;
+    rade_rx_set_warm(rx, 0.0f);
 
     /* Clear receive buffer */
     memset(rx->rx_buf, 0, sizeof(rx->rx_buf));
+    rx->rx_buf_start = 0;
 
     return 0;
 }
@@ -105,11 +130,45 @@ void rade_rx_reset(rade_rx_state *rx) {
     rx->uw_errors = 0;
     rx->rx_phase = rade_cone();
     rx->snrdB_3k_est = 0.0f;
+    rx->acq_squelched = 0;
+    rx->warm_count = 0;
+    rx->warm_hits = 0;
+    rx->fade_count = -1;
+    rade_sql_reset(&rx->sql);
     rade_init_decoder(&rx->dec_state);
     if (rx->bpf_en) {
         rade_bpf_reset(&rx->bpf);
     }
     memset(rx->rx_buf, 0, sizeof(rx->rx_buf));
+    rx->rx_buf_start = 0;
+}
+
+void rade_rx_set_warm(rade_rx_state *rx, float seconds) {
+    rx->warm_frames = (seconds > 0.0f) ? (int)(seconds * RADE_FS / RADE_NMF + 0.5f) : 0;
+    if (rx->warm_count > rx->warm_frames) {
+        rx->warm_count = rx->warm_frames;
+    }
+}
+
+void rade_rx_set_acq_range(rade_rx_state *rx, float range_Hz) {
+    rade_acq_set_range(&rx->acq, range_Hz, RADE_ACQ_WIDE_NWIN);
+
+    /* The squelch band and BPF follow the range actually searched */
+    if (rx->acq.wide_bins > 0) {
+        float range = rade_rx_acq_range(rx);
+        rx_band_init(rx, range, range);
+    } else {
+        rx_band_init(rx, RADE_ACQ_FRANGE, 0.0f);
+    }
+}
+
+float rade_rx_acq_range(const rade_rx_state *rx) {
+    return (rx->acq.wide_bins > 0) ? rx->acq.wide_bins * RADE_ACQ_FSTEP : RADE_ACQ_FRANGE / 2.0f;
+}
+
+void rade_rx_set_shed(rade_rx_state *rx, int flags) {
+    rx->shed = flags;
+    rx->acq.n_refresh = (flags & RADE_RX_SHED_NOISE_FREEZE) ? 0 : RADE_ACQ_NREFRESH;
 }
 
 /*---------------------------------------------------------------------------*\
@@ -148,7 +207,39 @@ void rade_rx_sum_uw_errors(rade_rx_state *rx, int new_uw_errors) {
     rx->uw_errors += new_uw_errors;
 }
 
-int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, const RADE_COMP *rx_in) {
+/* Look for the signal we just lost near its last timing and frequency,
+   returns 1 if the pilots are there and updates the warm estimates */
+static int rx_warm_search(rade_rx_state *rx, const RADE_COMP *rx_buf) {
+    int t = rx->tmax_warm;
+    float f = rx->fmax_warm;
+    int tstart = (t > RADE_WARM_TRANGE) ? (t - RADE_WARM_TRANGE) : 0;
+    int tend = (t + RADE_WARM_TRANGE < RADE_NMF) ? (t + RADE_WARM_TRANGE) : RADE_NMF;
+
+    rade_acq_refine(&rx->acq, rx_buf, &t, &f, tstart, tend,
+                    f - RADE_WARM_FRANGE, f + RADE_WARM_FRANGE, 0.5f);
+
+    int hit = 0, endofover = 0;
+    rade_acq_check_pilots(&rx->acq, rx_buf, t, f, &hit, &endofover);
+    if (hit && !endofover) {
+        rx->tmax_warm = t;
+        rx->fmax_warm = f;
+        return 1;
+    }
+    return 0;
+}
+
+static void rx_resync_stats(rade_rx_state *rx, int warm) {
+    uint32_t frames = (uint32_t)rx->fade_count;
+    __atomic_store_n(&rx->resync_count, rx->resync_count + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&rx->resync_warm, rx->resync_warm + (warm ? 1 : 0), __ATOMIC_RELAXED);
+    __atomic_store_n(&rx->resync_last, frames, __ATOMIC_RELAXED);
+    if (frames > rx->resync_max) {
+        __atomic_store_n(&rx->resync_max, frames, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&rx->resync_sum, rx->resync_sum + frames, __ATOMIC_RELAXED);
+}
+
+int rade_rx_demod(rade_rx_state *rx, float *z_hat, float *eoo_out, const RADE_COMP *rx_in) {
     int M = RADE_M;
     int Ncp = RADE_NCP;
     int Nmf = RADE_NMF;
@@ -159,27 +250,87 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
     int endofover = 0;
     int uw_fail = 0;
 
-    /* Apply BPF if enabled */
-    RADE_COMP rx_filtered[RADE_NMF + RADE_M];
-    const RADE_COMP *rx_samples = rx_in;
+    /* Update receive buffer: slide the window on by nin samples, moving
+       it back to the start of rx_buf when we run out of slack */
+    int buf_size = RADE_RX_BUF_SIZE;
+    int keep = buf_size - rx->nin;
+    int start = rx->rx_buf_start + rx->nin;
+    if (start + buf_size > RADE_RX_BUF_SIZE + RADE_RX_BUF_SLACK) {
+        memmove(rx->rx_buf, &rx->rx_buf[start], sizeof(RADE_COMP) * keep);
+        start = 0;
+    }
+    rx->rx_buf_start = start;
+    const RADE_COMP *rx_buf = &rx->rx_buf[start];
 
+    /* New samples, through the BPF if enabled, go straight into the window */
+    uint64_t t0 = rade_time_ns();
     if (rx->bpf_en) {
-        rade_bpf_process(&rx->bpf, rx_filtered, rx_in, rx->nin);
-        rx_samples = rx_filtered;
+        uint64_t tt = rade_trace_begin();
+        rade_bpf_process(&rx->bpf, &rx->rx_buf[start + keep], rx_in, rx->nin);
+        rade_trace_end(RADE_TRACE_RX_BPF, tt);
+        rade_hist_add(&rx->hist_bpf, rade_time_ns() - t0);
+    } else {
+        memcpy(&rx->rx_buf[start + keep], rx_in, sizeof(RADE_COMP) * rx->nin);
     }
 
-    /* Update receive buffer: shift out old samples, add new */
-    int buf_size = RADE_RX_BUF_SIZE;
-    memmove(rx->rx_buf, &rx->rx_buf[rx->nin], sizeof(RADE_COMP) * (buf_size - rx->nin));
-    memcpy(&rx->rx_buf[buf_size - rx->nin], rx_samples, sizeof(RADE_COMP) * rx->nin);
-
-    /* State machine processing */
+    /* State machine processing.  Time spent in acquisition this frame is
+       summed in t_acq, so it includes the candidate -> sync refine below */
     int candidate = 0;
     int valid = 0;
+    uint64_t t_acq = 0;
+
+    t0 = rade_time_ns();
+    rx->acq_squelched = 0;
+    int warm_sync = 0;
+    if (rx->fade_count >= 0 && rx->state != RADE_STATE_SYNC) {
+        rx->fade_count++;
+    }
 
-    if (rx->state == RADE_STATE_SEARCH || rx->state == RADE_STATE_CANDIDATE) {
+    if (rx->state != RADE_STATE_SYNC && rx->warm_count > 0) {
+        /* Warm re-acquire: two hits in a row at the same timing and
+           frequency re-sync without waiting for candidate confirmation.
+           Noise peaks land anywhere in the +/- RADE_WARM_TRANGE window, so
+           the second hit has to be within RADE_WARM_TAGREE samples and
+           RADE_WARM_FAGREE Hz of the first.  It costs a small fraction of
+           the full search, which still runs below so a signal that came
+           back somewhere else is found as quickly as ever */
+        int tprev = rx->tmax_warm;
+        float fprev = rx->fmax_warm;
+        uint64_t tt = rade_trace_begin();
+        int hit = rx_warm_search(rx, rx_buf);
+        rade_trace_end(RADE_TRACE_ACQ_WARM, tt);
+        if (hit) {
+            if (rx->warm_hits > 0 && abs(rx->tmax_warm - tprev) <= RADE_WARM_TAGREE &&
+                fabsf(rx->fmax_warm - fprev) <= RADE_WARM_FAGREE) {
+                warm_sync = 1;
+            }
+            rx->warm_hits++;
+        } else {
+            rx->warm_hits = 0;
+        }
+        rx->warm_count--;
+        t_acq += rade_time_ns() - t0;
+        t0 = rade_time_ns();
+    }
+
+    if (warm_sync) {
+        /* Found it, no need for the full search */
+    } else if (rx->state == RADE_STATE_SEARCH && !rade_sql_process(&rx->sql, rx_in, rx->nin)) {
+        /* Nothing like a RADE signal in the band, skip the pilot search */
+        rx->acq_squelched = 1;
+        t_acq += rade_time_ns() - t0;
+    } else if (rx->state == RADE_STATE_SEARCH && (rx->shed & RADE_RX_SHED_THIN_SEARCH) &&
+               (rx->shed_phase ^= 1)) {
+        /* Shedding load, search on the next frame instead.  The window
+           spans two modem frames so no timing is missed, only a frame of
+           acquisition time */
+        t_acq += rade_time_ns() - t0;
+    } else if (rx->state == RADE_STATE_SEARCH || rx->state == RADE_STATE_CANDIDATE) {
         /* Acquisition mode: detect pilots */
-        candidate = rade_acq_detect_pilots(&rx->acq, rx->rx_buf, &rx->tmax, &rx->fmax);
+        uint64_t tt = rade_trace_begin();
+        candidate = rade_acq_detect_pilots(&rx->acq, rx_buf, &rx->tmax, &rx->fmax);
+        rade_trace_end(RADE_TRACE_ACQ_DETECT, tt);
+        t_acq += rade_time_ns() - t0;
     } else {
         /* Sync mode: refine timing/freq and check pilots */
         float ffine_start = rx->fmax - 1.0f;
@@ -188,14 +339,21 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
         int tfine_end = rx->tmax + 8;
 
         float fmax_hat = rx->fmax;
-        rade_acq_refine(&rx->acq, rx->rx_buf, &rx->tmax, &fmax_hat,
+        uint64_t tt = rade_trace_begin();
+        rade_acq_refine(&rx->acq, rx_buf, &rx->tmax, &fmax_hat,
                        tfine_start, tfine_end, ffine_start, ffine_end, 0.1f);
+        rade_trace_end(RADE_TRACE_ACQ_REFINE, tt);
 
         /* Low-pass filter frequency estimate */
         rx->fmax = 0.9f * rx->fmax + 0.1f * fmax_hat;
 
         /* Check pilots */
-        rade_acq_check_pilots(&rx->acq, rx->rx_buf, rx->tmax, rx->fmax, &candidate, &endofover);
+        tt = rade_trace_begin();
+        rade_acq_check_pilots(&rx->acq, rx_buf, rx->tmax, rx->fmax, &candidate, &endofover);
+        rade_trace_end(RADE_TRACE_ACQ_CHECK, tt);
+        uint64_t t1 = rade_time_ns();
+        t_acq += t1 - t0;
+        t0 = t1;
 
         /* Handle timing slips */
         rx->nin = Nmf;
@@ -218,13 +376,34 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
             rx->uw_errors = 0;
         }
 
-        /* Frequency offset correction */
+        /* Frequency offset correction, rx_phase advances by exp(-j*w) per
+           sample.  We step it RX_ROT_BLOCK samples at a time and rotate each
+           block by a table of the powers of exp(-j*w), so the samples in a
+           block are independent and the loop vectorises */
         float w = 2.0f * M_PI * rx->fmax / Fs;
         RADE_COMP rx_corrected[RADE_NMF + RADE_M + RADE_NCP];
+        RADE_COMP rot[RX_ROT_BLOCK];
 
-        for (int n = 0; n < Nmf + M + Ncp; n++) {
-            rx->rx_phase = rade_cmul(rx->rx_phase, rade_cexp(-w));
-            rx_corrected[n] = rade_cmul(rx->rx_buf[rx->tmax - Ncp + n], rx->rx_phase);
+        rot[0] = rade_cexp(-w);
+        for (int i = 1; i < RX_ROT_BLOCK; i++) {
+            rot[i] = rade_cmul(rot[i - 1], rot[0]);
+        }
+        RADE_COMP rot_block = rot[RX_ROT_BLOCK - 1];
+
+        const RADE_COMP *rx_sym = &rx_buf[rx->tmax - Ncp];
+        int n_corr = Nmf + M + Ncp;
+        int n = 0;
+        for (; n + RX_ROT_BLOCK <= n_corr; n += RX_ROT_BLOCK) {
+            for (int i = 0; i < RX_ROT_BLOCK; i++) {
+                rx_corrected[n + i] = rade_cmul(rx_sym[n + i], rade_cmul(rx->rx_phase, rot[i]));
+            }
+            rx->rx_phase = rade_cmul(rx->rx_phase, rot_block);
+        }
+        for (int i = 0; n < n_corr; n++, i++) {
+            rx_corrected[n] = rade_cmul(rx_sym[n], rade_cmul(rx->rx_phase, rot[i]));
+        }
+        if (n_corr % RX_ROT_BLOCK) {
+            rx->rx_phase = rade_cmul(rx->rx_phase, rot[n_corr % RX_ROT_BLOCK - 1]);
         }
 
         /* Normalize phase to prevent drift */
@@ -232,61 +411,18 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
         rx->rx_phase = rade_cscale(rx->rx_phase, 1.0f / phase_mag);
 
         /* Demodulate OFDM frame */
-        float z_hat[RADE_NZMF * RADE_LATENT_DIM];
         float snr_est = 0.0f;
 
+        tt = rade_trace_begin();
         rade_ofdm_demod_frame(&rx->ofdm, z_hat, rx_corrected,
                               rx->time_offset, endofover, rx->coarse_mag, &snr_est);
+        rade_trace_end(RADE_TRACE_OFDM_DEMOD, tt);
 
         /* Update SNR estimate with moving average */
         rx->snrdB_3k_est = 0.9f * rx->snrdB_3k_est + 0.1f * snr_est;
 
         valid_output = !endofover;
 
-        if (valid_output) {
-            /* Decode latents to features */
-            int Nzmf = RADE_NZMF;
-            int latent_dim = RADE_LATENT_DIM;
-            int dec_stride = RADE_FRAMES_PER_STEP;
-            int num_used_features = RADE_NUM_FEATURES;
-            int nb_total_features = RADE_NB_TOTAL_FEATURES;
-            int num_features = rx->num_features;
-            int arch = 0;
-
-            /* Zero output buffer */
-            int n_features_out = rade_rx_n_features_out(rx);
-            memset(features_out, 0, sizeof(float) * n_features_out);
-
-            int uw_errors_total = 0;
-
-            for (int c = 0; c < Nzmf; c++) {
-                float dec_features[RADE_FRAMES_PER_STEP * RADE_NUM_FEATURES_AUX];
-
-                rade_core_decoder(&rx->dec_state, &rx->dec_model,
-                                 dec_features, &z_hat[c * latent_dim], arch);
-
-                /* Copy decoded features to output (with padding) */
-                for (int i = 0; i < dec_stride; i++) {
-                    int out_idx = (c * dec_stride + i) * nb_total_features;
-                    for (int j = 0; j < num_used_features; j++) {
-                        features_out[out_idx + j] = dec_features[i * num_features + j];
-                    }
-                }
-
-                /* Check auxiliary data for unique word errors */
-                if (rx->auxdata) {
-                    /* Use first aux symbol of each group (they repeat) */
-                    if (dec_features[num_used_features] > 0) {
-                        uw_errors_total++;
-                    }
-                }
-            }
-
-            if (rx->auxdata) {
-                rx->uw_errors += uw_errors_total;
-            }
-        }
-
         if (endofover) {
             /* Copy EOO symbols to output */
             float z_hat_eoo[(RADE_NS - 1) * RADE_NC * 2];
@@ -295,6 +431,8 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
             int n_eoo_bits = rade_rx_n_eoo_bits(rx);
             memcpy(eoo_out, z_hat_eoo, sizeof(float) * n_eoo_bits);
         }
+
+        rade_hist_add(&rx->hist_demod, rade_time_ns() - t0);
     }
 
     /* Verbose output */
@@ -309,6 +447,10 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
         fprintf(stderr, "Dtmax12: %8.2f %8.2f tmax: %4d fmax: %6.2f",
                 rx->acq.Dtmax12, rx->acq.Dtmax12_eoo, rx->tmax, rx->fmax);
         fprintf(stderr, " SNRdB: %5.2f", rx->snrdB_3k_est);
+        if (rx->sql.open_dB > 0.0f && rx->state == RADE_STATE_SEARCH) {
+            fprintf(stderr, " sql: %5.2f %4.2f%s", rx->sql.ratio_dB - rx->sql.base_dB,
+                    rx->sql.flatness, rx->acq_squelched ? " skip" : "");
+        }
         if (rx->auxdata && rx->state == RADE_STATE_SYNC) {
             fprintf(stderr, " uw_err: %d", rx->uw_errors);
         }
@@ -318,7 +460,29 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
     /* State machine transitions */
     int next_state = rx->state;
 
-    if (rx->state == RADE_STATE_SEARCH) {
+    if (warm_sync) {
+        next_state = RADE_STATE_SYNC;
+        rade_init_decoder(&rx->dec_state);  /* Reset decoder state */
+        rx->synced_count = 0;
+        rx->uw_errors = 0;
+        rx->valid_count = rx->Nmf_unsync;
+        rx->tmax = rx->tmax_warm;
+        rx->fmax = rx->fmax_warm;
+
+        /* The warm search stepped 0.5 Hz, finish off as a full acquisition would */
+        int tfine_start = (rx->tmax > 1) ? (rx->tmax - 1) : 0;
+        t0 = rade_time_ns();
+        uint64_t tt = rade_trace_begin();
+        rade_acq_refine(&rx->acq, rx_buf, &rx->tmax, &rx->fmax,
+                       tfine_start, rx->tmax + 2, rx->fmax - 1.0f, rx->fmax + 1.0f, 0.25f);
+        rade_trace_end(RADE_TRACE_ACQ_REFINE, tt);
+        t_acq += rade_time_ns() - t0;
+
+        rx->warm_count = 0;
+        rx->warm_hits = 0;
+        rx_resync_stats(rx, 1);
+        rx->fade_count = -1;
+    } else if (rx->state == RADE_STATE_SEARCH) {
         if (candidate) {
             next_state = RADE_STATE_CANDIDATE;
             rx->tmax_candidate = rx->tmax;
@@ -341,8 +505,18 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
                 int tfine_start = (rx->tmax > 1) ? (rx->tmax - 1) : 0;
                 int tfine_end = rx->tmax + 2;
 
-                rade_acq_refine(&rx->acq, rx->rx_buf, &rx->tmax, &rx->fmax,
+                t0 = rade_time_ns();
+                uint64_t tt = rade_trace_begin();
+                rade_acq_refine(&rx->acq, rx_buf, &rx->tmax, &rx->fmax,
                                tfine_start, tfine_end, ffine_start, ffine_end, 0.25f);
+                rade_trace_end(RADE_TRACE_ACQ_REFINE, tt);
+                t_acq += rade_time_ns() - t0;
+
+                rx->warm_count = 0;
+                if (rx->fade_count >= 0) {
+                    rx_resync_stats(rx, 0);
+                    rx->fade_count = -1;
+                }
             }
         } else {
             next_state = RADE_STATE_SEARCH;
@@ -369,8 +543,26 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
         if (unsync_enable && (endofover || uw_fail)) {
             next_state = RADE_STATE_SEARCH;
         }
+
+        /* Lost sync because the pilots went away: most likely a fade, and
+           the same signal will be back at about the same place.  Not after
+           an end of over, or UW errors which say we were locked wrongly */
+        if (next_state == RADE_STATE_SEARCH) {
+            if (endofover || uw_fail) {
+                rx->warm_count = 0;
+                rx->fade_count = -1;
+            } else {
+                rx->warm_count = rx->warm_frames;
+                rx->warm_hits = 0;
+                rx->tmax_warm = rx->tmax;
+                rx->fmax_warm = rx->fmax;
+                rx->fade_count = 0;
+            }
+        }
     }
 
+    rade_hist_add(&rx->hist_acq, t_acq);
+
     rx->state = next_state;
     if (rx->state == RADE_STATE_SEARCH) {
         rx->nin = Nmf;  /* Reset nin when not synced */
@@ -380,3 +572,365 @@ int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, cons
     /* Return flags */
     return (valid_output ? 0x1 : 0) | (endofover ? 0x2 : 0);
 }
+
+void rade_rx_decode_batch(rade_rx_state *rx[], int n, float *features_out[], const float *z_hat[]) {
+    int Nzmf = RADE_NZMF;
+    int latent_dim = RADE_LATENT_DIM;
+    int dec_stride = RADE_FRAMES_PER_STEP;
+    int num_used_features = RADE_NUM_FEATURES;
+    int nb_total_features = RADE_NB_TOTAL_FEATURES;
+
+    assert(n >= 1 && n <= RADE_DEC_BATCH_MAX);
+
+    const RADEDec *model = rx[0]->dec_model;
+    int arch = rx[0]->arch;
+
+    RADEDecState *dec_states[RADE_DEC_BATCH_MAX];
+    float *dec_scratch[RADE_DEC_BATCH_MAX];
+    float dec_features[RADE_DEC_BATCH_MAX][RADE_FRAMES_PER_STEP * RADE_NUM_FEATURES_AUX];
+    float *dec_features_ptr[RADE_DEC_BATCH_MAX];
+    const float *z_ptr[RADE_DEC_BATCH_MAX];
+    int uw_errors_total[RADE_DEC_BATCH_MAX];
+    uint64_t t0 = rade_time_ns();
+
+    for (int i = 0; i < n; i++) {
+        assert(rx[i]->dec_model == model);
+        dec_states[i] = &rx[i]->dec_state;
+        dec_scratch[i] = rx[i]->dec_scratch;
+        dec_features_ptr[i] = dec_features[i];
+        uw_errors_total[i] = 0;
+
+        /* Zero output buffer */
+        memset(features_out[i], 0, sizeof(float) * rade_rx_n_features_out(rx[i]));
+    }
+
+    for (int c = 0; c < Nzmf; c++) {
+        for (int i = 0; i < n; i++) {
+            z_ptr[i] = &z_hat[i][c * latent_dim];
+        }
+
+        uint64_t tt = rade_trace_begin();
+        rade_core_decoder_batch(dec_states, model, dec_features_ptr, z_ptr, dec_scratch, n, arch);
+        if (tt != 0) {
+            rade_trace_add(RADE_TRACE_CORE_DECODER, tt, rade_time_ns(), n);
+        }
+
+        for (int i = 0; i < n; i++) {
+            int num_features = rx[i]->num_features;
+
+            /* Copy decoded features to output (with padding) */
+            for (int k = 0; k < dec_stride; k++) {
+                int out_idx = (c * dec_stride + k) * nb_total_features;
+                for (int j = 0; j < num_used_features; j++) {
+                    features_out[i][out_idx + j] = dec_features[i][k * num_features + j];
+                }
+            }
+
+            /* Check auxiliary data for unique word errors */
+            if (rx[i]->auxdata) {
+                /* Use first aux symbol of each group (they repeat) */
+                if (dec_features[i][num_used_features] > 0) {
+                    uw_errors_total[i]++;
+                }
+            }
+        }
+    }
+
+    /* The batch shares one pass through the network, so each receiver is
+       charged the whole batch time, which is what it had to wait for */
+    uint64_t t_dec = rade_time_ns() - t0;
+    for (int i = 0; i < n; i++) {
+        if (rx[i]->auxdata) {
+            rx[i]->uw_errors += uw_errors_total[i];
+        }
+        rade_hist_add(&rx[i]->hist_decoder, t_dec);
+    }
+}
+
+void rade_rx_decode(rade_rx_state *rx, float *features_out, const float *z_hat) {
+    rade_rx_decode_batch(&rx, 1, &features_out, &z_hat);
+}
+
+int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, const RADE_COMP *rx_in) {
+    float z_hat[RADE_NZMF * RADE_LATENT_DIM];
+
+    int ret = rade_rx_demod(rx, z_hat, eoo_out, rx_in);
+    if (ret & 0x1) {
+        rade_rx_decode(rx, features_out, z_hat);
+    }
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*\
+                              SNAPSHOTS
+\*---------------------------------------------------------------------------*/
+
+#define RX_SNAP_BYTE_ORDER 0x01020304u
+
+/* Snapshot layout.  Fields have the same types as the receiver's, and are
+   copied in and out with memcpy() at their offsets so the caller's buffer
+   needn't be aligned */
+typedef struct {
+    char      magic[8];
+    uint32_t  version;
+    uint32_t  bytes;                            /* sizeof(rx_snap) */
+    uint32_t  byte_order;                       /* RX_SNAP_BYTE_ORDER */
+
+    /* must match the receiver it is restored into */
+    int       bottleneck;
+    int       auxdata;
+    int       bpf_en;
+    int       wide_bins;
+
+    /* state machine and tracking */
+    int       state;
+    int       valid_count;
+    int       synced_count;
+    int       uw_errors;
+    int       tmax;
+    int       tmax_candidate;
+    float     fmax;
+    RADE_COMP rx_phase;
+    int       nin;
+    int       mf;
+    float     snrdB_3k_est;
+    int       acq_squelched;
+    int       shed_phase;
+
+    /* warm re-acquire */
+    int       warm_count;
+    int       warm_hits;
+    int       tmax_warm;
+    float     fmax_warm;
+    int       fade_count;
+
+    /* squelch */
+    float     sql_base_dB;
+    int       sql_frames;
+    int       sql_hang_count;
+    int       sql_skip_count;
+
+    /* acquisition noise floor and last detection */
+    float     row_abs_Dt1[RADE_NMF];
+    float     row_abs_Dt2[RADE_NMF];
+    double    sum_abs_Dt1;
+    double    sum_abs_Dt2;
+    float     Dthresh;
+    float     Dtmax12;
+    float     Dtmax12_eoo;
+    int       f_ind_max;
+    int       n_win;
+    int       win_k[RADE_ACQ_WIDE_NWIN_MAX];
+    unsigned  rand_state;
+
+    /* BPF history, and the receive window from rx_buf_start */
+    RADE_COMP bpf_hist[RADE_BPF_NTAP - 1];
+    RADE_COMP bpf_phase;
+    RADE_COMP rx_buf[RADE_RX_BUF_SIZE];
+
+    RADEDecState dec_state;
+} rx_snap;
+
+#define SNAP_PUT(p, field, v) \
+    memcpy((char *)(p) + offsetof(rx_snap, field), &(v), sizeof(((rx_snap *)0)->field))
+#define SNAP_GET(p, field, v) \
+    memcpy(&(v), (const char *)(p) + offsetof(rx_snap, field), sizeof(((rx_snap *)0)->field))
+
+size_t rade_rx_snapshot_size(void) {
+    return sizeof(rx_snap);
+}
+
+size_t rade_rx_snapshot(const rade_rx_state *rx, void *buf, size_t len) {
+    if (len < sizeof(rx_snap)) {
+        return 0;
+    }
+    memset(buf, 0, sizeof(rx_snap));
+
+    char magic[8] = RADE_RX_SNAP_MAGIC;
+    uint32_t version = RADE_RX_SNAP_VERSION;
+    uint32_t bytes = sizeof(rx_snap);
+    uint32_t byte_order = RX_SNAP_BYTE_ORDER;
+    SNAP_PUT(buf, magic, magic);
+    SNAP_PUT(buf, version, version);
+    SNAP_PUT(buf, bytes, bytes);
+    SNAP_PUT(buf, byte_order, byte_order);
+
+    SNAP_PUT(buf, bottleneck, rx->bottleneck);
+    SNAP_PUT(buf, auxdata, rx->auxdata);
+    SNAP_PUT(buf, bpf_en, rx->bpf_en);
+    SNAP_PUT(buf, wide_bins, rx->acq.wide_bins);
+
+    SNAP_PUT(buf, state, rx->state);
+    SNAP_PUT(buf, valid_count, rx->valid_count);
+    SNAP_PUT(buf, synced_count, rx->synced_count);
+    SNAP_PUT(buf, uw_errors, rx->uw_errors);
+    SNAP_PUT(buf, tmax, rx->tmax);
+    SNAP_PUT(buf, tmax_candidate, rx->tmax_candidate);
+    SNAP_PUT(buf, fmax, rx->fmax);
+    SNAP_PUT(buf, rx_phase, rx->rx_phase);
+    SNAP_PUT(buf, nin, rx->nin);
+    SNAP_PUT(buf, mf, rx->mf);
+    SNAP_PUT(buf, snrdB_3k_est, rx->snrdB_3k_est);
+    SNAP_PUT(buf, acq_squelched, rx->acq_squelched);
+    SNAP_PUT(buf, shed_phase, rx->shed_phase);
+
+    SNAP_PUT(buf, warm_count, rx->warm_count);
+    SNAP_PUT(buf, warm_hits, rx->warm_hits);
+    SNAP_PUT(buf, tmax_warm, rx->tmax_warm);
+    SNAP_PUT(buf, fmax_warm, rx->fmax_warm);
+    SNAP_PUT(buf, fade_count, rx->fade_count);
+
+    SNAP_PUT(buf, sql_base_dB, rx->sql.base_dB);
+    SNAP_PUT(buf, sql_frames, rx->sql.frames);
+    SNAP_PUT(buf, sql_hang_count, rx->sql.hang_count);
+    SNAP_PUT(buf, sql_skip_count, rx->sql.skip_count);
+
+    SNAP_PUT(buf, row_abs_Dt1, rx->acq.row_abs_Dt1);
+    SNAP_PUT(buf, row_abs_Dt2, rx->acq.row_abs_Dt2);
+    SNAP_PUT(buf, sum_abs_Dt1, rx->acq.sum_abs_Dt1);
+    SNAP_PUT(buf, sum_abs_Dt2, rx->acq.sum_abs_Dt2);
+    SNAP_PUT(buf, Dthresh, rx->acq.Dthresh);
+    SNAP_PUT(buf, Dtmax12, rx->acq.Dtmax12);
+    SNAP_PUT(buf, Dtmax12_eoo, rx->acq.Dtmax12_eoo);
+    SNAP_PUT(buf, f_ind_max, rx->acq.f_ind_max);
+    SNAP_PUT(buf, n_win, rx->acq.n_win);
+    SNAP_PUT(buf, win_k, rx->acq.win_k);
+    SNAP_PUT(buf, rand_state, rx->acq.rand_state);
+
+    if (rx->bpf_en) {
+        RADE_COMP hist[RADE_BPF_NTAP - 1];
+        RADE_COMP phase;
+        rade_bpf_get_state(&rx->bpf, hist, &phase);
+        SNAP_PUT(buf, bpf_hist, hist);
+        SNAP_PUT(buf, bpf_phase, phase);
+    }
+    SNAP_PUT(buf, rx_buf, rx->rx_buf[rx->rx_buf_start]);
+    SNAP_PUT(buf, dec_state, rx->dec_state);
+
+    return sizeof(rx_snap);
+}
+
+int rade_rx_restore(rade_rx_state *rx, const void *buf, size_t len) {
+    if (len < sizeof(rx_snap)) {
+        return -1;
+    }
+
+    char magic[8];
+    uint32_t version, bytes, byte_order;
+    SNAP_GET(buf, magic, magic);
+    SNAP_GET(buf, version, version);
+    SNAP_GET(buf, bytes, bytes);
+    SNAP_GET(buf, byte_order, byte_order);
+    if (memcmp(magic, RADE_RX_SNAP_MAGIC, sizeof(magic)) != 0 || version != RADE_RX_SNAP_VERSION ||
+        bytes != sizeof(rx_snap) || byte_order != RX_SNAP_BYTE_ORDER) {
+        return -1;
+    }
+
+    int bottleneck, auxdata, bpf_en, wide_bins;
+    SNAP_GET(buf, bottleneck, bottleneck);
+    SNAP_GET(buf, auxdata, auxdata);
+    SNAP_GET(buf, bpf_en, bpf_en);
+    SNAP_GET(buf, wide_bins, wide_bins);
+    if (bottleneck != rx->bottleneck || auxdata != rx->auxdata || bpf_en != rx->bpf_en ||
+        wide_bins != rx->acq.wide_bins) {
+        return -1;
+    }
+
+    /* Anything that indexes the receive window or the search grid, or
+       that the state machine counts down, has to be in range, the
+       snapshot may have come over a network */
+    int state, tmax, tmax_warm, nin, n_win, f_ind_max, valid_count;
+    int win_k[RADE_ACQ_WIDE_NWIN_MAX];
+    int sql_frames, sql_hang_count, sql_skip_count;
+    SNAP_GET(buf, state, state);
+    SNAP_GET(buf, tmax, tmax);
+    SNAP_GET(buf, tmax_warm, tmax_warm);
+    SNAP_GET(buf, nin, nin);
+    SNAP_GET(buf, n_win, n_win);
+    SNAP_GET(buf, f_ind_max, f_ind_max);
+    SNAP_GET(buf, win_k, win_k);
+    SNAP_GET(buf, valid_count, valid_count);
+    SNAP_GET(buf, sql_frames, sql_frames);
+    SNAP_GET(buf, sql_hang_count, sql_hang_count);
+    SNAP_GET(buf, sql_skip_count, sql_skip_count);
+    int valid_max = (rx->Nmf_unsync > 3) ? rx->Nmf_unsync : 3;
+    if (state < RADE_STATE_SEARCH || state > RADE_STATE_SYNC ||
+        tmax < 0 || tmax >= RADE_NMF + RADE_M || tmax_warm < 0 || tmax_warm >= RADE_NMF ||
+        (nin != RADE_NMF && nin != RADE_NMF - RADE_M && nin != RADE_NMF + RADE_M) ||
+        n_win < 1 || n_win > RADE_ACQ_WIDE_NWIN_MAX || (wide_bins == 0 && n_win != 1) ||
+        f_ind_max < 0 || f_ind_max >= rx->acq.n_fcoarse * n_win ||
+        valid_count < 0 || valid_count > valid_max ||
+        (state == RADE_STATE_SYNC && valid_count < 1) ||
+        sql_frames < 0 || sql_hang_count < 0 || sql_skip_count < 0) {
+        return -1;
+    }
+
+    /* window centres as acq_wide_windows() places them, the first on zero */
+    int kmax = (wide_bins > 0) ? wide_bins - rx->acq.n_fcoarse / 2 : 0;
+    if (win_k[0] != 0) {
+        return -1;
+    }
+    for (int i = 1; i < n_win; i++) {
+        if (win_k[i] < -kmax || win_k[i] > kmax) {
+            return -1;
+        }
+    }
+
+    rx->state = state;
+    rx->tmax = tmax;
+    rx->tmax_warm = tmax_warm;
+    rx->nin = nin;
+    rx->valid_count = valid_count;
+    SNAP_GET(buf, synced_count, rx->synced_count);
+    SNAP_GET(buf, uw_errors, rx->uw_errors);
+    SNAP_GET(buf, tmax_candidate, rx->tmax_candidate);
+    SNAP_GET(buf, fmax, rx->fmax);
+    SNAP_GET(buf, rx_phase, rx->rx_phase);
+    SNAP_GET(buf, mf, rx->mf);
+    SNAP_GET(buf, snrdB_3k_est, rx->snrdB_3k_est);
+    SNAP_GET(buf, acq_squelched, rx->acq_squelched);
+    SNAP_GET(buf, shed_phase, rx->shed_phase);
+
+    SNAP_GET(buf, warm_count, rx->warm_count);
+    SNAP_GET(buf, warm_hits, rx->warm_hits);
+    SNAP_GET(buf, fmax_warm, rx->fmax_warm);
+    SNAP_GET(buf, fade_count, rx->fade_count);
+    if (rx->warm_count > rx->warm_frames) {
+        rx->warm_count = rx->warm_frames;
+    }
+
+    SNAP_GET(buf, sql_base_dB, rx->sql.base_dB);
+    /* the hang and search interval are this receiver's own */
+    rx->sql.frames = sql_frames;
+    rx->sql.hang_count = (sql_hang_count > rx->sql.hang) ? rx->sql.hang : sql_hang_count;
+    rx->sql.skip_count = sql_skip_count;
+    if (rx->sql.search_every > 0 && rx->sql.skip_count >= rx->sql.search_every) {
+        rx->sql.skip_count = rx->sql.search_every - 1;
+    }
+
+    SNAP_GET(buf, row_abs_Dt1, rx->acq.row_abs_Dt1);
+    SNAP_GET(buf, row_abs_Dt2, rx->acq.row_abs_Dt2);
+    SNAP_GET(buf, sum_abs_Dt1, rx->acq.sum_abs_Dt1);
+    SNAP_GET(buf, sum_abs_Dt2, rx->acq.sum_abs_Dt2);
+    SNAP_GET(buf, Dthresh, rx->acq.Dthresh);
+    SNAP_GET(buf, Dtmax12, rx->acq.Dtmax12);
+    SNAP_GET(buf, Dtmax12_eoo, rx->acq.Dtmax12_eoo);
+    rx->acq.f_ind_max = f_ind_max;
+    rx->acq.n_win = n_win;
+    memcpy(rx->acq.win_k, win_k, sizeof(win_k));
+    SNAP_GET(buf, rand_state, rx->acq.rand_state);
+
+    if (rx->bpf_en) {
+        RADE_COMP hist[RADE_BPF_NTAP - 1];
+        RADE_COMP phase;
+        SNAP_GET(buf, bpf_hist, hist);
+        SNAP_GET(buf, bpf_phase, phase);
+        rade_bpf_set_state(&rx->bpf, hist, phase);
+    }
+    rx->rx_buf_start = 0;
+    SNAP_GET(buf, rx_buf, rx->rx_buf[0]);
+    SNAP_GET(buf, dec_state, rx->dec_state);
+
+    return 0;
+}
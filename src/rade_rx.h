@@ -41,8 +41,10 @@
 #include "rade_ofdm.h"
 #include "rade_bpf.h"
 #include "rade_acq.h"
+#include "rade_sql.h"
 #include "rade_dec.h"
 #include "rade_core.h"
+#include "rade_stats.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,16 +57,38 @@ extern "C" {
 /* Receive buffer size: 2*Nmf + M + Ncp */
 #define RADE_RX_BUF_SIZE (2 * RADE_NMF + RADE_M + RADE_NCP)
 
+/* Warm re-acquire (off unless rade_rx_set_warm()): after the pilots fade
+   out, search near the last timing and frequency as well as the full
+   search.  RADE_WARM_S is a suggested window.  Two hits in a row re-sync
+   only if they agree to within RADE_WARM_TAGREE samples and
+   RADE_WARM_FAGREE Hz, much tighter than the window searched */
+#define RADE_WARM_S             5.0f
+#define RADE_WARM_TRANGE        RADE_NCP  /* +/- samples */
+#define RADE_WARM_FRANGE        3.0f      /* +/- Hz */
+#define RADE_WARM_TAGREE        2         /* samples */
+#define RADE_WARM_FAGREE        1.0f      /* Hz */
+
+/* Load shedding, for hosts that can't keep up (rade_rx_set_shed()) */
+#define RADE_RX_SHED_THIN_SEARCH   0x1    /* pilot search every other frame in search */
+#define RADE_RX_SHED_NOISE_FREEZE  0x2    /* no noise floor refresh while in sync */
+
+/* Room to append new samples after the receive window before it has to be
+   moved back to the start of rx_buf, about four modem frames */
+#define RADE_RX_BUF_SLACK (4 * (RADE_NMF + RADE_M))
+
 typedef struct {
     /* DSP components */
     rade_ofdm ofdm;
     rade_bpf bpf;
     rade_acq acq;
+    rade_sql sql;             /* acquisition squelch, off unless configured */
     int bpf_en;
 
-    /* Core decoder */
-    RADEDec dec_model;
+    /* Core decoder, weights are shared read only between receivers */
+    const RADEDec *dec_model;
     RADEDecState dec_state;
+    float dec_scratch[RADE_DEC_SCRATCH];    /* layer outputs, only used during a decode */
+    int arch;                 /* CPU feature level for dnn kernels (0 = generic C) */
 
     /* Configuration */
     int bottleneck;
@@ -88,8 +112,34 @@ typedef struct {
     RADE_COMP rx_phase;
     int nin;                  /* Samples needed for next call */
 
-    /* Receive buffer */
-    RADE_COMP rx_buf[RADE_RX_BUF_SIZE];
+    /* Receive buffer, the current window is rx_buf[rx_buf_start] onwards
+       for RADE_RX_BUF_SIZE samples.  New samples are appended after it so
+       we only compact once the slack is used up */
+    RADE_COMP rx_buf[RADE_RX_BUF_SIZE + RADE_RX_BUF_SLACK];
+    int rx_buf_start;
+
+    /* Warm re-acquire state */
+    int warm_frames;          /* frames to try it after losing sync, 0 = off */
+    int warm_count;           /* frames of it left */
+    int warm_hits;            /* consecutive detections near the last sync */
+    int tmax_warm;
+    float fmax_warm;
+    int fade_count;           /* frames since sync was lost, -1 if not in a fade */
+
+    /* Re-sync after a fade, in modem frames.  Written only by the thread
+       running the receiver, read elsewhere with relaxed atomics */
+    uint32_t resync_count;
+    uint32_t resync_warm;     /* ... of which found by the warm search */
+    uint32_t resync_last;
+    uint32_t resync_max;
+    uint64_t resync_sum;
+
+    /* Non-zero if the squelch skipped this frame's pilot search */
+    int acq_squelched;
+
+    /* Load shedding flags, and which search frame is thinned out next */
+    int shed;
+    int shed_phase;
 
     /* SNR estimate */
     float snrdB_3k_est;
@@ -103,6 +153,12 @@ typedef struct {
     /* Test mode: disable unsync after this many seconds (0 = disabled) */
     float disable_unsync;
 
+    /* Stage timers, written only by the thread running the receiver */
+    rade_hist hist_bpf;
+    rade_hist hist_acq;
+    rade_hist hist_demod;
+    rade_hist hist_decoder;
+
 } rade_rx_state;
 
 /*---------------------------------------------------------------------------*\
@@ -110,16 +166,38 @@ typedef struct {
 \*---------------------------------------------------------------------------*/
 
 /* Initialize receiver
-   dec_model: pointer to decoder model weights (can be NULL to use built-in)
+   dec_model: decoder model weights, used by reference (not copied) so one
+              model can serve many receivers; must outlive rx
    bottleneck: 1, 2, or 3
    auxdata: 1 to enable auxiliary data decoding
    bpf_en: 1 to enable input bandpass filter
    Returns 0 on success */
 int rade_rx_init(rade_rx_state *rx, const RADEDec *dec_model, int bottleneck, int auxdata, int bpf_en);
 
-/* Reset receiver state (go back to search mode) */
+/* Reset receiver state (go back to search mode), forgets the last sync
+   point so the next acquisition is a full search */
 void rade_rx_reset(rade_rx_state *rx);
 
+/* Warm re-acquire window in seconds after losing sync, 0 disables */
+void rade_rx_set_warm(rade_rx_state *rx, float seconds);
+
+/* Search frequency offsets up to +/- range_Hz while acquiring, using the
+   wide range search (rade_acq_set_range()) beyond RADE_ACQ_FRANGE/2.  The
+   squelch band and BPF widen to match, so set it before the first
+   rade_rx_process() */
+void rade_rx_set_acq_range(rade_rx_state *rx, float range_Hz);
+
+/* Largest frequency offset searched (Hz), after any limit on the range */
+float rade_rx_acq_range(const rade_rx_state *rx);
+
+/* Trade acquisition for CPU, RADE_RX_SHED_xxx flags or 0 for none.  Thin
+   search runs the pilot search on every other frame while searching, so a
+   signal takes up to a frame longer to find; noise freeze stops
+   rade_acq_check_pilots() refreshing the noise floor while in sync, which
+   holds the detection threshold where it was.  Takes effect on the next
+   frame */
+void rade_rx_set_shed(rade_rx_state *rx, int flags);
+
 /*---------------------------------------------------------------------------*\
                            RECEPTION
 \*---------------------------------------------------------------------------*/
@@ -155,10 +233,52 @@ float rade_rx_freq_offset(const rade_rx_state *rx);
    - bit 1 (0x2): end-of-over detected, eoo_out contains soft decision bits */
 int rade_rx_process(rade_rx_state *rx, float *features_out, float *eoo_out, const RADE_COMP *rx_in);
 
+/* rade_rx_process() in two halves, so the neural decoder can be batched
+   across receivers.  rade_rx_demod() runs acquisition, tracking and OFDM
+   demod; when it returns with bit 0 set, z_hat[RADE_NZMF*RADE_LATENT_DIM]
+   holds latents that must be passed to rade_rx_decode() (or
+   rade_rx_decode_batch()) before the next rade_rx_demod() call. */
+int rade_rx_demod(rade_rx_state *rx, float *z_hat, float *eoo_out, const RADE_COMP *rx_in);
+void rade_rx_decode(rade_rx_state *rx, float *features_out, const float *z_hat);
+
+/* Decode latents for n receivers (1..RADE_DEC_BATCH_MAX) that share the
+   same decoder model; bit exact with n calls to rade_rx_decode() */
+void rade_rx_decode_batch(rade_rx_state *rx[], int n, float *features_out[], const float *z_hat[]);
+
 /* Report unique word errors (called externally if C decoder is used)
    This is used by the state machine for unsync detection */
 void rade_rx_sum_uw_errors(rade_rx_state *rx, int new_uw_errors);
 
+/*---------------------------------------------------------------------------*\
+                              SNAPSHOTS
+\*---------------------------------------------------------------------------*/
+
+/* A snapshot is everything rade_rx_process() carries from one frame to
+   the next: the state machine, timing and frequency tracking, the receive
+   window, BPF and squelch history, the acquisition noise floor and the
+   core decoder's recurrent state.  Not the weights, the tables or the
+   search scratch, and not configuration (warm re-acquire, squelch
+   thresholds, load shedding, verbosity) or the stage and resync stats,
+   which stay with the receiver it is restored into.
+
+   Restored between two frames into a receiver with the same bottleneck,
+   auxdata, BPF and acquisition range, decoding carries on bit exact as
+   if the input had gone to that receiver all along.  Host byte order and
+   struct layout: the same build on the same architecture */
+
+#define RADE_RX_SNAP_MAGIC    "RADESNP"           /* 8 bytes with the NUL */
+#define RADE_RX_SNAP_VERSION  1
+
+/* Bytes in a snapshot */
+size_t rade_rx_snapshot_size(void);
+
+/* Write a snapshot to buf, returns its size or 0 if len is too small */
+size_t rade_rx_snapshot(const rade_rx_state *rx, void *buf, size_t len);
+
+/* Returns 0, or -1 with rx unchanged if buf isn't a snapshot of this
+   version, layout and receiver configuration */
+int rade_rx_restore(rade_rx_state *rx, const void *buf, size_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,354 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_shm.c
+
+  Shared memory sample rings.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "rade_shm.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+_Static_assert(sizeof(rade_shm_header) == 192, "rade_shm_header layout");
+_Static_assert(offsetof(rade_shm_header, write_idx) == 64, "rade_shm_header layout");
+_Static_assert(offsetof(rade_shm_header, read_idx) == 128, "rade_shm_header layout");
+
+#define LOAD(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/*---------------------------------------------------------------------------*\
+                                 WAITING
+\*---------------------------------------------------------------------------*/
+
+#ifdef __linux__
+static void shm_futex_wait(uint32_t *addr, uint32_t val, int timeout_ms) {
+    struct timespec ts, *tp = NULL;
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        tp = &ts;
+    }
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, tp, NULL, 0);
+}
+
+static void shm_futex_wake(uint32_t *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+#else
+/* No futex, poll every millisecond */
+static void shm_futex_wait(uint32_t *addr, uint32_t val, int timeout_ms) {
+    struct timespec ts = {0, 1000000L};
+    (void)addr; (void)val; (void)timeout_ms;
+    nanosleep(&ts, NULL);
+}
+
+static void shm_futex_wake(uint32_t *addr) {
+    (void)addr;
+}
+#endif
+
+static int64_t shm_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* The other side's index is in the shared header and may be anything, so
+   clamp to our own capacity: a read or write of that much from any slot
+   stays inside the double mapping */
+static int shm_avail(const rade_shm *r) {
+    const rade_shm_header *h = r->hdr;
+    uint64_t n = LOAD(&h->write_idx) - LOAD(&h->read_idx);
+    return n > (uint64_t)r->mask ? (int)r->mask + 1 : (int)n;
+}
+
+static int shm_space(const rade_shm *r) {
+    return (int)r->mask + 1 - shm_avail(r);
+}
+
+/* Publish a new index and wake the other side if it is asleep on seq */
+static void shm_publish(uint64_t *idx, uint64_t v, uint32_t *seq, uint32_t *waiting) {
+    STORE(idx, v);
+    __atomic_fetch_add(seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST))
+        shm_futex_wake(seq);
+}
+
+/* Wait for avail() >= want.  The waiting flag is set before seq is read
+   and the count checked again, so a publish between the check and the
+   futex either sees the flag or changes seq and the futex returns at
+   once */
+static int shm_wait(rade_shm *r, int want, int timeout_ms, int reading) {
+    rade_shm_header *h = r->hdr;
+    uint32_t *seq     = reading ? &h->write_seq      : &h->read_seq;
+    uint32_t *waiting = reading ? &h->reader_waiting : &h->writer_waiting;
+    int64_t deadline  = timeout_ms >= 0 ? shm_now_ms() + timeout_ms : 0;
+
+    if (want > (int)r->mask + 1) want = (int)r->mask + 1;
+    for (;;) {
+        int n = reading ? shm_avail(r) : shm_space(r);
+        if (n >= want) return n;
+        if (reading && LOAD(&h->closed)) {
+            n = shm_avail(r);
+            return n >= want ? n : -1;
+        }
+
+        int left = -1;
+        if (timeout_ms >= 0) {
+            left = (int)(deadline - shm_now_ms());
+            if (left <= 0) return 0;
+        }
+
+        __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+        uint32_t s = __atomic_load_n(seq, __ATOMIC_SEQ_CST);
+        n = reading ? shm_avail(r) : shm_space(r);
+        if (n < want && !(reading && LOAD(&h->closed)))
+            shm_futex_wait(seq, s, left);
+        __atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+    }
+}
+
+/*---------------------------------------------------------------------------*\
+                                 MAPPING
+\*---------------------------------------------------------------------------*/
+
+/* Header and data, then the data again straight after, so a run of
+   frames that wraps the end of the ring is still contiguous */
+static int shm_map(rade_shm *r, int fd, uint32_t data_offset, size_t data_len) {
+    size_t total = data_offset + 2 * data_len;
+    uint8_t *base = mmap(NULL, total, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+    if (mmap(base, data_offset + data_len, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(base + data_offset + data_len, data_len, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, fd, (off_t)data_offset) == MAP_FAILED) {
+        munmap(base, total);
+        return -1;
+    }
+
+    r->hdr = (rade_shm_header *)base;
+    r->data = base + data_offset;
+    r->map_len = total;
+    return 0;
+}
+
+static void shm_name(char *out, size_t len, const char *name) {
+    snprintf(out, len, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+static int shm_sample_bytes(uint32_t format) {
+    return format == RADE_SHM_S16 ? 2 : format == RADE_SHM_F32 ? 4 : 0;
+}
+
+/*---------------------------------------------------------------------------*\
+                              OPEN AND CLOSE
+\*---------------------------------------------------------------------------*/
+
+int rade_shm_create(rade_shm *r, const char *name, int format, int channels,
+                    int sample_rate, int min_frames) {
+    memset(r, 0, sizeof(*r));
+
+    int sample_bytes = shm_sample_bytes((uint32_t)format);
+    if (sample_bytes == 0 || channels < 1 || channels > 2 || sample_rate <= 0) {
+        return -1;
+    }
+    uint32_t frame_bytes = (uint32_t)(sample_bytes * channels);
+    uint32_t page = (uint32_t)sysconf(_SC_PAGESIZE);
+
+    /* a power of two at least one page, so the data is whole pages */
+    uint32_t capacity = page / frame_bytes;
+    while (capacity < (uint32_t)min_frames && capacity < (1u << 28))
+        capacity *= 2;
+    size_t data_len = (size_t)capacity * frame_bytes;
+
+    /* Only ever map a segment we made ourselves, readable by us alone.  A
+       name left behind by a writer of ours that didn't close is replaced,
+       one belonging to anyone else is an error */
+    shm_name(r->name, sizeof(r->name), name);
+    int fd = shm_open(r->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        struct stat st;
+        int old = shm_open(r->name, O_RDONLY, 0);
+        int ours = old >= 0 && fstat(old, &st) == 0 && st.st_uid == geteuid();
+        if (old >= 0) close(old);
+        if (ours && shm_unlink(r->name) == 0)
+            fd = shm_open(r->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    if (fd < 0) {
+        memset(r, 0, sizeof(*r));
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)(page + data_len)) != 0 ||
+        shm_map(r, fd, page, data_len) != 0) {
+        close(fd);
+        shm_unlink(r->name);
+        memset(r, 0, sizeof(*r));
+        return -1;
+    }
+    close(fd);
+
+    /* the segment starts out zeroed, which is an empty ring; the magic
+       goes in last so a reader never sees a half written header */
+    rade_shm_header *h = r->hdr;
+    h->version = RADE_SHM_VERSION;
+    h->format = (uint32_t)format;
+    h->channels = (uint32_t)channels;
+    h->sample_rate = (uint32_t)sample_rate;
+    h->frame_bytes = frame_bytes;
+    h->capacity = capacity;
+    h->data_offset = page;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(h->magic, RADE_SHM_MAGIC, sizeof(h->magic));
+
+    r->mask = capacity - 1;
+    r->frame_bytes = frame_bytes;
+    r->owner = 1;
+    return 0;
+}
+
+int rade_shm_attach(rade_shm *r, const char *name) {
+    memset(r, 0, sizeof(*r));
+    shm_name(r->name, sizeof(r->name), name);
+
+    int fd = shm_open(r->name, O_RDWR, 0);
+    if (fd < 0) {
+        memset(r, 0, sizeof(*r));
+        return -1;
+    }
+
+    struct stat st;
+    rade_shm_header h;
+    int ok = fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(h) &&
+             pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h);
+    size_t data_len = 0;
+    if (ok) {
+        data_len = (size_t)h.capacity * h.frame_bytes;
+        ok = memcmp(h.magic, RADE_SHM_MAGIC, sizeof(h.magic)) == 0 &&
+             h.version == RADE_SHM_VERSION &&
+             h.sample_rate != 0 &&
+             h.channels >= 1 && h.channels <= 2 &&
+             h.frame_bytes == h.channels * (uint32_t)shm_sample_bytes(h.format) &&
+             h.capacity != 0 && (h.capacity & (h.capacity - 1)) == 0 &&
+             h.data_offset % (uint32_t)sysconf(_SC_PAGESIZE) == 0 &&
+             data_len % (size_t)sysconf(_SC_PAGESIZE) == 0 &&
+             (size_t)st.st_size >= h.data_offset + data_len;
+    }
+    if (!ok || shm_map(r, fd, h.data_offset, data_len) != 0) {
+        close(fd);
+        memset(r, 0, sizeof(*r));
+        return -1;
+    }
+    close(fd);
+
+    r->mask = h.capacity - 1;
+    r->frame_bytes = h.frame_bytes;
+    return 0;
+}
+
+void rade_shm_close(rade_shm *r) {
+    if (r->hdr == NULL) {
+        return;
+    }
+    if (r->owner) {
+        rade_shm_header *h = r->hdr;
+        STORE(&h->closed, 1);
+        shm_publish(&h->write_idx, LOAD(&h->write_idx), &h->write_seq, &h->reader_waiting);
+        shm_unlink(r->name);
+    }
+    munmap(r->hdr, r->map_len);
+    memset(r, 0, sizeof(*r));
+}
+
+/*---------------------------------------------------------------------------*\
+                                 READER
+\*---------------------------------------------------------------------------*/
+
+int rade_shm_read_wait(rade_shm *r, int want, int timeout_ms) {
+    return shm_wait(r, want, timeout_ms, 1);
+}
+
+const void *rade_shm_read_ptr(const rade_shm *r) {
+    uint64_t i = r->hdr->read_idx;
+    return r->data + (size_t)(i & r->mask) * r->frame_bytes;
+}
+
+void rade_shm_read_end(rade_shm *r, int n) {
+    rade_shm_header *h = r->hdr;
+    shm_publish(&h->read_idx, h->read_idx + (uint64_t)n, &h->read_seq, &h->writer_waiting);
+}
+
+/*---------------------------------------------------------------------------*\
+                                 WRITER
+\*---------------------------------------------------------------------------*/
+
+int rade_shm_write(rade_shm *r, const void *x, int n) {
+    rade_shm_header *h = r->hdr;
+    int space = shm_space(r);
+    int m = n < space ? n : space;
+    if (m > 0) {
+        memcpy(rade_shm_write_ptr(r), x, (size_t)m * r->frame_bytes);
+        rade_shm_write_end(r, m);
+    }
+    if (m < n)
+        __atomic_store_n(&h->dropped, h->dropped + (uint64_t)(n - m), __ATOMIC_RELAXED);
+    return m;
+}
+
+int rade_shm_write_wait(rade_shm *r, int want, int timeout_ms) {
+    return shm_wait(r, want, timeout_ms, 0);
+}
+
+void *rade_shm_write_ptr(const rade_shm *r) {
+    uint64_t i = r->hdr->write_idx;
+    return r->data + (size_t)(i & r->mask) * r->frame_bytes;
+}
+
+void rade_shm_write_end(rade_shm *r, int n) {
+    rade_shm_header *h = r->hdr;
+    shm_publish(&h->write_idx, h->write_idx + (uint64_t)n, &h->write_seq, &h->reader_waiting);
+}
+
+uint64_t rade_shm_dropped(const rade_shm *r) {
+    return __atomic_load_n(&r->hdr->dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,165 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_shm.h
+
+  Shared memory sample rings: a POSIX shared memory segment holding one
+  single producer, single consumer ring of audio or IQ samples, so a
+  decoder running next to an SDR server reads its input where the server
+  wrote it, with no pipe in between.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_SHM__
+#define __RADE_SHM__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                              SEGMENT LAYOUT
+\*---------------------------------------------------------------------------*/
+
+/* Host byte order.  The segment (shm_open() name, e.g. "/webrx0") is a
+   rade_shm_header then, from data_offset, capacity frames of samples.  A
+   frame is one sample of each channel, interleaved (I then Q for IQ).
+
+   write_idx and read_idx count frames since the ring was created and only
+   increase; frame i is at data_offset + (i & (capacity-1)) * frame_bytes,
+   and write_idx - read_idx frames are waiting.  The writer only writes
+   into the capacity - (write_idx - read_idx) free frames, then stores
+   write_idx with release ordering, increments write_seq and, if
+   reader_waiting is set, FUTEX_WAKEs write_seq.  It never waits for the
+   reader: frames that don't fit are dropped and added to dropped.  The
+   reader does the same with read_idx, read_seq and writer_waiting once it
+   has finished with the frames.
+
+   A side with nothing to do sets its waiting flag, re-checks the indexes
+   and FUTEX_WAITs on the other side's seq (not FUTEX_PRIVATE, the segment
+   is shared between processes).  The writer sets closed when the stream
+   ends; the reader drains what is left, then stops.
+
+   capacity is a power of two and capacity * frame_bytes a whole number of
+   pages, so a reader may map the data twice back to back and see every
+   run of up to capacity frames contiguously, as rade_shm_attach() does. */
+
+#define RADE_SHM_MAGIC    "RADESHM"             /* 8 bytes with the NUL */
+#define RADE_SHM_VERSION  1
+
+#define RADE_SHM_S16      1                     /* int16_t, full scale 32767 */
+#define RADE_SHM_F32      2                     /* float, full scale 1.0 */
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;                           /* RADE_SHM_VERSION */
+    uint32_t format;                            /* RADE_SHM_S16 or RADE_SHM_F32 */
+    uint32_t channels;                          /* 1 real, 2 interleaved IQ */
+    uint32_t sample_rate;                       /* Hz */
+    uint32_t frame_bytes;                       /* channels x sample size */
+    uint32_t capacity;                          /* frames, a power of two */
+    uint32_t data_offset;                       /* page aligned */
+    uint32_t reserved0[7];
+
+    /* 64: written by the writer */
+    uint64_t write_idx;
+    uint32_t write_seq;
+    uint32_t closed;
+    uint64_t dropped;                           /* frames that didn't fit */
+    uint32_t writer_waiting;
+    uint32_t reserved1[9];
+
+    /* 128: written by the reader */
+    uint64_t read_idx;
+    uint32_t read_seq;
+    uint32_t reader_waiting;
+    uint32_t reserved2[12];
+} rade_shm_header;
+
+/*---------------------------------------------------------------------------*\
+                                  RINGS
+\*---------------------------------------------------------------------------*/
+
+typedef struct {
+    rade_shm_header *hdr;                       /* NULL when not open */
+    uint8_t         *data;                      /* capacity frames, mapped twice */
+    size_t           map_len;
+    uint32_t         mask;                      /* capacity - 1 */
+    uint32_t         frame_bytes;
+    int              owner;                     /* created it, unlinks on close */
+    char             name[64];
+} rade_shm;
+
+/* Create the segment name as the writer, mode 0600, for at least
+   min_frames frames of channels x format samples at sample_rate.  An old
+   segment of that name is replaced if it is ours, otherwise it's an error.
+   Returns 0, or -1 with r zeroed */
+int rade_shm_create(rade_shm *r, const char *name, int format, int channels,
+                    int sample_rate, int min_frames);
+
+/* Attach to an existing segment as the reader.  Returns 0, or -1 with r
+   zeroed if it doesn't exist or isn't a ring of this version (including
+   one with no sample rate) */
+int rade_shm_attach(rade_shm *r, const char *name);
+
+/* Unmap; the writer also marks the ring closed and unlinks the name */
+void rade_shm_close(rade_shm *r);
+
+/* Reader.  rade_shm_read_wait() waits up to timeout_ms (-1 forever) for
+   at least want frames and returns how many are waiting (all of them, no
+   more than capacity), 0 on a timeout, or -1 once the writer has closed
+   and fewer than want are left.  rade_shm_read_ptr() is the oldest
+   waiting frame, in place in the segment with the rest following it
+   contiguously.  rade_shm_read_end() hands n of them back to the writer */
+int         rade_shm_read_wait(rade_shm *r, int want, int timeout_ms);
+const void *rade_shm_read_ptr(const rade_shm *r);
+void        rade_shm_read_end(rade_shm *r, int n);
+
+/* Writer.  rade_shm_write() copies in up to n frames without waiting and
+   returns how many fit, counting the rest as dropped.  For writing in
+   place, rade_shm_write_wait() waits like rade_shm_read_wait() for want
+   free frames (returning the free count, 0 on a timeout),
+   rade_shm_write_ptr() is where the next frame goes and
+   rade_shm_write_end() publishes n frames written there */
+int   rade_shm_write(rade_shm *r, const void *x, int n);
+int   rade_shm_write_wait(rade_shm *r, int want, int timeout_ms);
+void *rade_shm_write_ptr(const rade_shm *r);
+void  rade_shm_write_end(rade_shm *r, int n);
+
+/* Frames the writer has dropped on a full ring */
+uint64_t rade_shm_dropped(const rade_shm *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_SHM__ */
@@ -0,0 +1,100 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_spectrum.c
+
+  Windowed log magnitude spectrum of real audio, for the GUI displays.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "rade_spectrum.h"
+#include <string.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*---------------------------------------------------------------------------*\
+                           INITIALIZATION
+\*---------------------------------------------------------------------------*/
+
+int rade_spectrum_init(rade_spectrum *sp, int n) {
+    memset(sp, 0, sizeof(rade_spectrum));
+
+    if (n < 2 || (n & 1) || n > RADE_SPECTRUM_MAX_N) {
+        fprintf(stderr, "rade_spectrum_init: unsupported size n=%d\n", n);
+        return -1;
+    }
+    sp->n = n;
+
+    for (int i = 0; i < n; i++) {
+        sp->window[i] = 0.5f * (1.0f - cosf(2.0f * (float)M_PI * i / (n - 1)));
+    }
+
+    return rade_fft_real_init(&sp->fft, n);
+}
+
+/*---------------------------------------------------------------------------*\
+                             LOG MAGNITUDE
+\*---------------------------------------------------------------------------*/
+
+/* log2(x) for normal x > 0: split off the exponent, fold the mantissa into
+   [sqrt(1/2), sqrt(2)) and use the atanh series in t = (m-1)/(m+1), which
+   with |t| < 0.172 is within 1e-6 after three terms.  Branch free so the
+   compiler can vectorise the loop below */
+static inline float fast_log2(float x) {
+    union { float f; uint32_t i; } u = { x };
+    int e = (int)((u.i >> 23) & 0xff) - 127;
+    u.i = (u.i & 0x007fffff) | 0x3f800000;         /* m in [1, 2) */
+    int big = u.f > 1.41421356f;
+    float m = big ? 0.5f * u.f : u.f;
+    e += big;
+
+    float t = (m - 1.0f) / (m + 1.0f);
+    float t2 = t * t;
+    return (float)e + t * (2.88539008f + t2 * (0.96179669f + t2 * 0.57707802f));
+}
+
+void rade_spectrum_db(const rade_spectrum *sp, float *db, const float *x) {
+    int n = sp->n;
+    float xw[RADE_SPECTRUM_MAX_N];
+    RADE_COMP X[RADE_SPECTRUM_MAX_N / 2 + 1];
+
+    for (int i = 0; i < n; i++) {
+        xw[i] = x[i] * sp->window[i];
+    }
+    rade_fft_real(&sp->fft, X, xw);
+
+    /* 20*log10(|X|/(n/2)) = 10*log10(2)*log2(|X|^2) - 20*log10(n/2), no sqrt */
+    float scale = 4.0f / ((float)n * (float)n);
+    float pmin = 1e-20f;
+    for (int k = 0; k < n / 2; k++) {
+        float p = (X[k].real * X[k].real + X[k].imag * X[k].imag) * scale;
+        float d = 3.01029996f * fast_log2(p > pmin ? p : pmin);
+        db[k] = p > pmin ? d : RADE_SPECTRUM_FLOOR_DB;
+    }
+}
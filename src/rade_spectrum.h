@@ -0,0 +1,76 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_spectrum.h
+
+  Windowed log magnitude spectrum of real audio, for the GUI displays.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef __RADE_SPECTRUM__
+#define __RADE_SPECTRUM__
+
+#include "rade_dsp.h"
+#include "rade_fft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                             SPECTRUM STATE
+\*---------------------------------------------------------------------------*/
+
+#define RADE_SPECTRUM_MAX_N     RADE_FFT_MAX_N
+#define RADE_SPECTRUM_FLOOR_DB  (-200.0f)       /* Reported for empty bins */
+
+typedef struct {
+    int n;                                      /* Samples per spectrum */
+    float window[RADE_SPECTRUM_MAX_N];          /* Hann window */
+    rade_fft_real_state fft;
+} rade_spectrum;
+
+/*---------------------------------------------------------------------------*\
+                               FUNCTIONS
+\*---------------------------------------------------------------------------*/
+
+/* Initialize for n samples (even, at most RADE_SPECTRUM_MAX_N), n/2 bins.
+   Returns 0 on success, -1 if n is unsupported */
+int rade_spectrum_init(rade_spectrum *sp, int n);
+
+/* Log magnitude spectrum of n samples x[n]: for k = 0..n/2-1
+   db[k] = 20*log10(|X[k]|/(n/2)) with a Hann window, or
+   RADE_SPECTRUM_FLOOR_DB if |X[k]|/(n/2) <= 1e-10.  The log is a
+   polynomial approximation good to 0.001 dB, plenty for a display */
+void rade_spectrum_db(const rade_spectrum *sp, float *db, const float *x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_SPECTRUM__ */
@@ -0,0 +1,178 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_sql.c
+
+  Energy squelch for RADAE acquisition.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "rade_sql.h"
+#include <math.h>
+#include <assert.h>
+
+/*---------------------------------------------------------------------------*\
+                           INITIALIZATION
+
+  The detector looks for what an OFDM signal adds to the spectrum: power
+  in the RADE band, spread flat across it.  Each frame gives the ratio of
+  mean power in the band to mean power in guard bands either side, which
+  doesn't depend on level or AGC.  On noise alone the ratio settles at
+  whatever the radio's filtering makes it, so it is compared against a
+  tracked noise-only value rather than a fixed one.  A frame opens the
+  squelch when the ratio is open_dB above that value and the band's
+  spectral flatness rules out speech or carriers.
+
+\*---------------------------------------------------------------------------*/
+
+void rade_sql_init(rade_sql *sql, float Fs_Hz, float f_lo_Hz, float f_hi_Hz, float frange_Hz) {
+    int N = RADE_SQL_NFFT;
+    float bin_Hz = Fs_Hz / N;
+
+    int ret = rade_fft_init(&sql->fft, N);
+    assert(ret == 0);
+    (void)ret;
+
+    for (int i = 0; i < N; i++) {
+        sql->window[i] = 0.5f - 0.5f * cosf(2.0f * M_PI * i / N);
+    }
+
+    /* Hann main lobe is +/- 2 bins, so keep the guards clear of the band */
+    sql->band_lo = (int)floorf((f_lo_Hz - frange_Hz) / bin_Hz);
+    sql->band_hi = (int)ceilf((f_hi_Hz + frange_Hz) / bin_Hz);
+    sql->guard1_lo = (int)ceilf(RADE_SQL_GUARD_LO_HZ / bin_Hz);
+    sql->guard1_hi = (int)floorf((RADE_SQL_GUARD_LO_HZ + RADE_SQL_GUARD_BW_HZ) / bin_Hz);
+    sql->guard2_lo = (int)ceilf((RADE_SQL_GUARD_HI_HZ - RADE_SQL_GUARD_BW_HZ) / bin_Hz);
+    sql->guard2_hi = (int)floorf(RADE_SQL_GUARD_HI_HZ / bin_Hz);
+
+    /* The guards keep their full width, they are the noise reference.  A
+       wide acquisition range would run the band into them, so the band
+       stops a main lobe short of each guard instead, and a signal out
+       towards the ends of the range only opens the squelch on the in band
+       part of its power.  The periodic search (search_every) still finds
+       it however far out it is */
+    if (sql->band_lo < sql->guard1_hi + 2) sql->band_lo = sql->guard1_hi + 2;
+    if (sql->band_hi > sql->guard2_lo - 2) sql->band_hi = sql->guard2_lo - 2;
+    assert(sql->guard1_lo >= 1 && sql->guard1_lo <= sql->guard1_hi);
+    assert(sql->guard2_lo <= sql->guard2_hi && sql->guard2_hi < N / 2);
+
+    sql->open_dB = 0.0f;
+    sql->hang = RADE_SQL_HANG;
+    sql->search_every = RADE_SQL_SEARCH_EVERY;
+    rade_sql_reset(sql);
+}
+
+void rade_sql_config(rade_sql *sql, float open_dB, int hang, int search_every) {
+    sql->open_dB = open_dB;
+    sql->hang = (hang > 0) ? hang : 0;
+    sql->search_every = (search_every > 0) ? search_every : 0;
+    rade_sql_reset(sql);
+}
+
+void rade_sql_reset(rade_sql *sql) {
+    sql->base_dB = 0.0f;
+    sql->frames = 0;
+    sql->hang_count = 0;
+    sql->skip_count = 0;
+    sql->ratio_dB = 0.0f;
+    sql->flatness = 0.0f;
+}
+
+/*---------------------------------------------------------------------------*\
+                              PROCESSING
+\*---------------------------------------------------------------------------*/
+
+int rade_sql_process(rade_sql *sql, const RADE_COMP *x, int n) {
+    int N = RADE_SQL_NFFT;
+    int nblocks = n / N;
+
+    if (sql->open_dB <= 0.0f || nblocks == 0) {
+        return 1;
+    }
+
+    /* Averaged periodogram of the frame, positive frequencies only as the
+       input is analytic */
+    float P[RADE_SQL_NFFT / 2] = {0};
+    for (int b = 0; b < nblocks; b++) {
+        RADE_COMP in[RADE_SQL_NFFT], X[RADE_SQL_NFFT];
+        for (int i = 0; i < N; i++) {
+            in[i] = rade_cscale(x[b * N + i], sql->window[i]);
+        }
+        rade_fft(&sql->fft, X, in);
+        for (int k = sql->guard1_lo; k <= sql->guard2_hi; k++) {
+            P[k] += X[k].real * X[k].real + X[k].imag * X[k].imag;
+        }
+    }
+
+    const float eps = 1e-20f;
+    float band = 0.0f, log_band = 0.0f, guard = 0.0f;
+    for (int k = sql->band_lo; k <= sql->band_hi; k++) {
+        band += P[k];
+        log_band += logf(P[k] + eps);
+    }
+    for (int k = sql->guard1_lo; k <= sql->guard1_hi; k++) guard += P[k];
+    for (int k = sql->guard2_lo; k <= sql->guard2_hi; k++) guard += P[k];
+
+    int n_band = sql->band_hi - sql->band_lo + 1;
+    int n_guard = (sql->guard1_hi - sql->guard1_lo + 1) + (sql->guard2_hi - sql->guard2_lo + 1);
+    band /= n_band;
+    guard /= n_guard;
+
+    sql->ratio_dB = 10.0f * log10f((band + eps) / (guard + eps));
+    sql->flatness = expf(log_band / n_band) / (band + eps);
+
+    sql->frames++;
+
+    int detect = sql->frames > RADE_SQL_TRAIN &&
+                 sql->ratio_dB > sql->base_dB + sql->open_dB &&
+                 sql->flatness > RADE_SQL_FLAT_MIN;
+
+    if (detect) {
+        sql->hang_count = sql->hang;
+    } else if (sql->hang_count == 0) {
+        /* Noise-only ratio: the mean over the training frames, then a slow
+           (~6 s) average of the frames that don't open the squelch */
+        float a = (sql->frames <= RADE_SQL_TRAIN) ? 1.0f / sql->frames : 0.02f;
+        sql->base_dB += a * (sql->ratio_dB - sql->base_dB);
+    }
+
+    if (detect || sql->frames <= RADE_SQL_TRAIN || sql->hang_count > 0) {
+        if (!detect && sql->hang_count > 0) sql->hang_count--;
+        sql->skip_count = 0;
+        return 1;
+    }
+
+    /* Squelched, but still search now and then for signals too weak for
+       the detector */
+    if (sql->search_every > 0 && ++sql->skip_count >= sql->search_every) {
+        sql->skip_count = 0;
+        return 1;
+    }
+    return 0;
+}
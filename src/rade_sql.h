@@ -0,0 +1,116 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_sql.h
+
+  Energy squelch for RADAE acquisition: a cheap spectral detector that
+  decides whether a frame is worth a full pilot search.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_SQL__
+#define __RADE_SQL__
+
+#include "rade_dsp.h"
+#include "rade_fft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                              SQUELCH STATE
+\*---------------------------------------------------------------------------*/
+
+#define RADE_SQL_NFFT           128     /* 62.5 Hz bins at 8 kHz */
+#define RADE_SQL_GUARD_LO_HZ    300.0f  /* guard bands either side of the RADE */
+#define RADE_SQL_GUARD_HI_HZ    2700.0f /* band, inside a typical SSB passband */
+#define RADE_SQL_GUARD_BW_HZ    250.0f
+#define RADE_SQL_FLAT_MIN       0.5f    /* in band spectral flatness to open */
+#define RADE_SQL_TRAIN          8       /* frames always searched at start */
+
+/* Defaults for rade_set_acq_squelch() */
+#define RADE_SQL_OPEN_DB        3.0f
+#define RADE_SQL_HANG           25      /* ~3 s */
+#define RADE_SQL_SEARCH_EVERY   10      /* ~1.2 s */
+
+typedef struct {
+    rade_fft_state fft;
+    float window[RADE_SQL_NFFT];
+    int band_lo, band_hi;                   /* RADE band bins (inclusive), */
+    int guard1_lo, guard1_hi;               /* including the acquisition */
+    int guard2_lo, guard2_hi;               /* frequency range */
+
+    /* configuration, open_dB <= 0 disables the squelch */
+    float open_dB;
+    int hang;
+    int search_every;
+
+    /* state */
+    float base_dB;                          /* band/guard ratio on noise */
+    int frames;                             /* frames measured */
+    int hang_count;                         /* frames left open */
+    int skip_count;                         /* frames since the last search */
+
+    /* last measurement, for verbose output */
+    float ratio_dB;
+    float flatness;
+} rade_sql;
+
+/*---------------------------------------------------------------------------*\
+                           INITIALIZATION
+\*---------------------------------------------------------------------------*/
+
+/* Initialize the squelch (disabled) for a signal with carriers from
+   f_lo_Hz to f_hi_Hz, searched over +/- frange_Hz.  The band stops two
+   bins short of the guard bands' far edges */
+void rade_sql_init(rade_sql *sql, float Fs_Hz, float f_lo_Hz, float f_hi_Hz, float frange_Hz);
+
+/* Set open threshold (dB above the noise-only band/guard ratio, <= 0
+   disables), frames to hold open after a detection, and how often a
+   squelched receiver still runs a full search (frames, 0 = never) */
+void rade_sql_config(rade_sql *sql, float open_dB, int hang, int search_every);
+
+/* Forget the noise estimate and start training again */
+void rade_sql_reset(rade_sql *sql);
+
+/*---------------------------------------------------------------------------*\
+                              PROCESSING
+\*---------------------------------------------------------------------------*/
+
+/* Measure n samples of input (before any BPF, the guard bands must be
+   unfiltered) and return non-zero if the pilot search should run on
+   this frame.  Always 1 when disabled. */
+int rade_sql_process(rade_sql *sql, const RADE_COMP *x, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_SQL__ */
@@ -0,0 +1,157 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_stats.c
+
+  Stage timers and lock-free latency histograms.
+
+\*---------------------------------------------------------------------------*/
+
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include <string.h>
+
+#include "rade_stats.h"
+
+/* Single writer, so plain load/add/store is enough on the writer side;
+   the atomics only stop the compiler tearing or caching the words a
+   reader is looking at */
+#if defined(__GNUC__) || defined(__clang__)
+#define HIST_LOAD(p)     __atomic_load_n((p), __ATOMIC_RELAXED)
+#define HIST_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#else
+#define HIST_LOAD(p)     (*(volatile __typeof__(*(p)) *)(p))
+#define HIST_STORE(p, v) (*(p) = (v))
+#endif
+
+/*---------------------------------------------------------------------------*\
+                           CLOCK
+\*---------------------------------------------------------------------------*/
+
+uint64_t rade_time_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER t;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&t);
+    return (uint64_t)((double)t.QuadPart * 1E9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/*---------------------------------------------------------------------------*\
+                           HISTOGRAM
+\*---------------------------------------------------------------------------*/
+
+static int hist_bin(uint64_t ns) {
+    if (ns < (RADE_HIST_NLIN << 7)) {
+        return (int)(ns >> 7);
+    }
+
+    int msb = 63;
+    while (!(ns >> msb)) msb--;
+    int oct = msb - 10;
+    if (oct >= RADE_HIST_NOCT) {
+        return RADE_HIST_NBINS - 1;
+    }
+    int sub = (int)(ns >> (msb - 3)) & (RADE_HIST_NSUB - 1);
+    return RADE_HIST_NLIN + oct * RADE_HIST_NSUB + sub;
+}
+
+/* Centre of bin b in ns */
+static float hist_bin_centre(int b) {
+    if (b < RADE_HIST_NLIN) {
+        return (float)(b * 128 + 64);
+    }
+    int oct = (b - RADE_HIST_NLIN) / RADE_HIST_NSUB;
+    int sub = (b - RADE_HIST_NLIN) % RADE_HIST_NSUB;
+    float width = (float)(1u << (oct + 7));
+    return (float)(RADE_HIST_NSUB + sub) * width + 0.5f * width;
+}
+
+void rade_hist_init(rade_hist *h) {
+    memset(h, 0, sizeof(rade_hist));
+}
+
+void rade_hist_add(rade_hist *h, uint64_t ns) {
+    int b = hist_bin(ns);
+    HIST_STORE(&h->bins[b], HIST_LOAD(&h->bins[b]) + 1);
+    HIST_STORE(&h->sum_ns, HIST_LOAD(&h->sum_ns) + ns);
+
+    uint32_t ns32 = (ns > 0xffffffffULL) ? 0xffffffffu : (uint32_t)ns;
+    if (ns32 > HIST_LOAD(&h->max_ns)) {
+        HIST_STORE(&h->max_ns, ns32);
+    }
+}
+
+void rade_hist_read(const rade_hist *h, struct rade_stage_stats *st) {
+    uint32_t bins[RADE_HIST_NBINS];
+    uint64_t count = 0;
+
+    for (int b = 0; b < RADE_HIST_NBINS; b++) {
+        bins[b] = HIST_LOAD(&h->bins[b]);
+        count += bins[b];
+    }
+
+    memset(st, 0, sizeof(*st));
+    st->count = (unsigned int)count;
+    if (count == 0) {
+        return;
+    }
+
+    /* Smallest bins holding at least half and 99% of the samples */
+    uint64_t rank50 = (count + 1) / 2;
+    uint64_t rank99 = (count * 99 + 99) / 100;
+    uint64_t cum = 0;
+    int b50 = -1, b99 = -1;
+    for (int b = 0; b < RADE_HIST_NBINS && b99 < 0; b++) {
+        cum += bins[b];
+        if (b50 < 0 && cum >= rank50) b50 = b;
+        if (cum >= rank99) b99 = b;
+    }
+
+    float max_us = (float)HIST_LOAD(&h->max_ns) * 1E-3f;
+    st->p50_us = hist_bin_centre(b50) * 1E-3f;
+    st->p99_us = hist_bin_centre(b99) * 1E-3f;
+    st->max_us = max_us;
+    st->mean_us = (float)((double)HIST_LOAD(&h->sum_ns) / (double)count * 1E-3);
+
+    /* Bin centres can overshoot the largest sample we've actually seen */
+    if (st->p50_us > max_us) st->p50_us = max_us;
+    if (st->p99_us > max_us) st->p99_us = max_us;
+}
@@ -0,0 +1,88 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_stats.h
+
+  Lightweight always-on stage timers for RADAE.  A monotonic clock plus a
+  fixed size log-linear latency histogram that one thread writes and any
+  thread may read without locking.
+
+\*---------------------------------------------------------------------------*/
+
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_STATS__
+#define __RADE_STATS__
+
+#include <stdint.h>
+#include "rade_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                           HISTOGRAM
+\*---------------------------------------------------------------------------*/
+
+/* Bins are 128 ns wide up to 1 us, then eight per octave (about 9%
+   resolution) up to 4 s.  Anything slower lands in the top bin */
+#define RADE_HIST_NLIN      8     /* Linear bins below 1024 ns */
+#define RADE_HIST_NSUB      8     /* Bins per octave above that */
+#define RADE_HIST_NOCT      22    /* Octaves 2^10 .. 2^31 ns */
+#define RADE_HIST_NBINS     (RADE_HIST_NLIN + RADE_HIST_NOCT * RADE_HIST_NSUB)
+
+typedef struct {
+    uint32_t bins[RADE_HIST_NBINS];
+    uint32_t max_ns;
+    uint64_t sum_ns;
+} rade_hist;
+
+/*---------------------------------------------------------------------------*\
+                           FUNCTIONS
+\*---------------------------------------------------------------------------*/
+
+/* Monotonic time in ns, for timing stages */
+uint64_t rade_time_ns(void);
+
+/* Clear a histogram, not thread safe */
+void rade_hist_init(rade_hist *h);
+
+/* Record one sample.  Only one thread may add to a given histogram */
+void rade_hist_add(rade_hist *h, uint64_t ns);
+
+/* Summarise into count/p50/p99/max/mean.  Safe from any thread while the
+   writer is running, the result is a snapshot that may be a sample or two
+   behind.  Percentiles are quoted at bin centres */
+void rade_hist_read(const rade_hist *h, struct rade_stage_stats *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_STATS__ */
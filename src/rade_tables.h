@@ -0,0 +1,119 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_tables.h
+
+  Read only DSP tables shared by every RADE context.  The OFDM carrier
+  matrix, pilots, EOO frames, LS equaliser matrices, acquisition pilot
+  grid, FFT plans and Hilbert taps depend only on the constants in
+  rade_dsp.h, so tools/rade_tables_gen.c computes them once at build time
+  into rade_tables.c and the init functions just point at them.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_TABLES__
+#define __RADE_TABLES__
+
+#include "rade_dsp.h"
+#include "rade_fft.h"
+#include "rade_hilbert.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                              OFDM TABLES
+\*---------------------------------------------------------------------------*/
+
+typedef struct {
+    int k0;                                     /* DFT bin of first carrier */
+    float w[RADE_NC];                           /* Angular frequency per carrier */
+    RADE_COMP W[RADE_M];                        /* W[n] = exp(j*2*pi*n/M) */
+    float Wc_re[RADE_NC][RADE_M];               /* Wc[c][n] = W[(k0+c)*n mod M] */
+    float Wc_im[RADE_NC][RADE_M];
+
+    RADE_COMP P[RADE_NC];                       /* Normal pilot symbols (Barker) */
+    RADE_COMP Pend[RADE_NC];                    /* End-of-over pilot symbols */
+    RADE_COMP p[RADE_M];                        /* Time-domain pilot (no CP) */
+    RADE_COMP pend[RADE_M];                     /* Time-domain EOO pilot (no CP) */
+    RADE_COMP p_cp[RADE_M + RADE_NCP];          /* Time-domain pilot with CP */
+    RADE_COMP pend_cp[RADE_M + RADE_NCP];       /* Time-domain EOO pilot with CP */
+
+    /* 3-pilot least-squares fit: Pmat[c] = (A^H A)^-1 A^H */
+    float local_path_delay_s;                   /* Assumed path delay for LS EQ */
+    RADE_COMP Pmat[RADE_NC][2][3];
+} rade_ofdm_tables;
+
+/* The EOO frame is the only table that depends on the bottleneck */
+typedef struct {
+    float pilot_gain;                           /* Pilot amplitude scaling */
+    int n_eoo;                                  /* EOO frame length */
+    RADE_COMP eoo[RADE_NEOO];                   /* Complete EOO frame */
+} rade_eoo_tables;
+
+/*---------------------------------------------------------------------------*\
+                          ACQUISITION TABLES
+\*---------------------------------------------------------------------------*/
+
+/* For the RADE_ACQ_FRANGE/RADE_ACQ_FSTEP coarse search grid */
+typedef struct {
+    int n_fcoarse;                              /* Number of frequency steps */
+    float fcoarse_range[RADE_ACQ_NFREQ];        /* Frequency offsets to search */
+    float p_w_re[RADE_M][RADE_ACQ_NFREQ];       /* p[n]*exp(j*2*pi*f*n/Fs) */
+    float p_w_im[RADE_M][RADE_ACQ_NFREQ];
+    float sigma_p;                              /* |p| */
+
+    /* FFT search engine, nfft is 0 if the grid doesn't land on whole bins */
+    int nfft;
+    int k_fcoarse[RADE_ACQ_NFREQ];              /* Frequency offsets in FFT bins */
+    RADE_COMP P_conj[RADE_FFT_MAX_N];           /* conj(FFT(p)), zero padded to N */
+} rade_acq_tables;
+
+/*---------------------------------------------------------------------------*\
+                                 TABLES
+\*---------------------------------------------------------------------------*/
+
+extern const rade_ofdm_tables rade_ofdm_tab;
+extern const rade_eoo_tables  rade_eoo_linear;      /* bottleneck 1 and 2 */
+extern const rade_eoo_tables  rade_eoo_limited;     /* bottleneck 3, -2 dB pilots, tanh PA model */
+extern const rade_acq_tables  rade_acq_tab;
+
+extern const rade_fft_state   rade_fft_ofdm;        /* RADE_M points */
+extern const rade_fft_state   rade_fft_acq;         /* rade_acq_tab.nfft points */
+extern const rade_fft_state   rade_fft_bpf;         /* RADE_BPF_NFFT points */
+
+/* rade_hilbert c[j] = h[n], n = 2j+1 */
+extern const float            rade_hilbert_c[RADE_HILBERT_NFOLD];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_TABLES__ */
@@ -0,0 +1,301 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_trace.c
+
+  Opt in timeline tracing, see rade_trace.h.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE             /* pthread_getname_np() */
+#endif
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "rade_trace.h"
+
+/* Each thread writes its own ring: event i goes in ev[i & mask], then
+   head = i + 1 is stored with release ordering.  A reader loads head
+   with acquire, copies, loads it again and drops anything the writer
+   may have wrapped over in between.  Rings are pushed onto a list
+   with a CAS.  When its thread exits a ring is marked dead, and the next
+   rade_trace_write() writes it out, unlinks it and frees it; that is the
+   only place rings leave the list, under trace_write_lock */
+typedef struct rade_trace_ring {
+    struct rade_trace_ring *next;
+    uint64_t head;
+    int      dead;
+    uint32_t mask;
+    long     tid;
+    char     name[16];
+    rade_trace_event ev[];
+} rade_trace_ring;
+
+int rade_trace_on;
+
+static int              trace_events = RADE_TRACE_DEFAULT_EVENTS;
+static rade_trace_ring *trace_rings;
+static const char      *trace_names[RADE_TRACE_MAX_IDS] = {
+    "rx_bpf",
+    "acq_detect_pilots",
+    "acq_refine",
+    "acq_check_pilots",
+    "acq_warm_search",
+    "ofdm_demod_frame",
+    "core_decoder",
+    "core_encoder",
+    "tx_mod",
+};
+static int trace_n_names = RADE_TRACE_NLIB;
+
+static pthread_once_t  trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   trace_key;
+static pthread_mutex_t trace_write_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local rade_trace_ring *my_ring;
+static _Thread_local char            my_name[16];
+
+static long trace_tid(void) {
+#if defined(SYS_gettid)
+    return (long)syscall(SYS_gettid);
+#else
+    return (long)(uintptr_t)pthread_self();
+#endif
+}
+
+/*---------------------------------------------------------------------------*\
+                                RECORDING
+\*---------------------------------------------------------------------------*/
+
+void rade_trace_start(int events_per_thread) {
+    int n = 256;
+    int want = events_per_thread > 0 ? events_per_thread : RADE_TRACE_DEFAULT_EVENTS;
+    while (n < want && n < (1 << 24)) {
+        n <<= 1;
+    }
+    __atomic_store_n(&trace_events, n, __ATOMIC_RELAXED);
+    __atomic_store_n(&rade_trace_on, 1, __ATOMIC_RELEASE);
+}
+
+void rade_trace_stop(void) {
+    __atomic_store_n(&rade_trace_on, 0, __ATOMIC_RELEASE);
+}
+
+void rade_trace_thread_name(const char *name) {
+    snprintf(my_name, sizeof(my_name), "%s", name ? name : "");
+    rade_trace_ring *r = my_ring;
+    if (r != NULL) {
+        memcpy(r->name, my_name, sizeof(r->name));
+    }
+}
+
+/* Thread exit, via trace_key */
+static void trace_ring_retire(void *arg) {
+    rade_trace_ring *r = (rade_trace_ring *)arg;
+    my_ring = NULL;
+    __atomic_store_n(&r->dead, 1, __ATOMIC_RELEASE);
+}
+
+static void trace_key_init(void) {
+    pthread_key_create(&trace_key, trace_ring_retire);
+}
+
+/* The calling thread's ring, NULL if it can't be allocated */
+static rade_trace_ring *trace_ring(void) {
+    if (my_ring != NULL) {
+        return my_ring;
+    }
+    pthread_once(&trace_key_once, trace_key_init);
+    int n = __atomic_load_n(&trace_events, __ATOMIC_RELAXED);
+    rade_trace_ring *r = (rade_trace_ring *)calloc(1, sizeof(*r) + (size_t)n * sizeof(rade_trace_event));
+    if (r == NULL) {
+        return NULL;
+    }
+    if (pthread_setspecific(trace_key, r) != 0) {
+        free(r);
+        return NULL;
+    }
+    r->mask = (uint32_t)n - 1;
+    r->tid = trace_tid();
+    memcpy(r->name, my_name, sizeof(r->name));
+#if defined(__GLIBC__)
+    if (r->name[0] == '\0') {
+        pthread_getname_np(pthread_self(), r->name, sizeof(r->name));
+    }
+#endif
+
+    rade_trace_ring *old = __atomic_load_n(&trace_rings, __ATOMIC_RELAXED);
+    do {
+        r->next = old;
+    } while (!__atomic_compare_exchange_n(&trace_rings, &old, r, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    my_ring = r;
+    return r;
+}
+
+void rade_trace_add(int id, uint64_t t0_ns, uint64_t t1_ns, int arg) {
+    rade_trace_ring *r = id >= 0 ? trace_ring() : NULL;
+    if (r == NULL) {
+        return;
+    }
+    uint64_t i = r->head;
+    rade_trace_event *e = &r->ev[i & r->mask];
+    e->t_ns = t0_ns;
+    e->dur_ns = (t1_ns - t0_ns) > UINT32_MAX ? UINT32_MAX : (uint32_t)(t1_ns - t0_ns);
+    e->id = (uint16_t)id;
+    e->arg = (uint16_t)arg;
+    __atomic_store_n(&r->head, i + 1, __ATOMIC_RELEASE);
+}
+
+int rade_trace_register(const char *name) {
+    static int lock;
+    while (__atomic_exchange_n(&lock, 1, __ATOMIC_ACQUIRE)) {
+        /* registration is rare and quick */
+    }
+    int id = -1;
+    for (int i = 0; i < trace_n_names; i++) {
+        if (strcmp(trace_names[i], name) == 0) {
+            id = i;
+        }
+    }
+    if (id < 0 && trace_n_names < RADE_TRACE_MAX_IDS) {
+        id = trace_n_names;
+        trace_names[id] = name;
+        __atomic_store_n(&trace_n_names, id + 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&lock, 0, __ATOMIC_RELEASE);
+    return id;
+}
+
+/*---------------------------------------------------------------------------*\
+                                 WRITING
+\*---------------------------------------------------------------------------*/
+
+/* Names and thread names are ours or short C identifiers, but quote
+   anything that would break the JSON */
+static void json_str(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fprintf(f, "\\%c", *s);
+        } else if ((unsigned char)*s < 0x20) {
+            fprintf(f, "\\u%04x", (unsigned char)*s);
+        } else {
+            fputc(*s, f);
+        }
+    }
+    fputc('"', f);
+}
+
+/* Take r, dead and already written out, off the list and free it.  New
+   rings only ever go on at the head, so only unlinking the head can race
+   with them */
+static void trace_ring_free(rade_trace_ring *r) {
+    rade_trace_ring *head = r;
+    if (!__atomic_compare_exchange_n(&trace_rings, &head, r->next, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        rade_trace_ring *p = head;
+        while (p->next != r) {
+            p = p->next;
+        }
+        p->next = r->next;
+    }
+    free(r);
+}
+
+long rade_trace_write(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&trace_write_lock);
+    long pid = (long)getpid();
+    int n_names = __atomic_load_n(&trace_n_names, __ATOMIC_ACQUIRE);
+    long n_out = 0;
+    const char *sep = "\n";
+
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    rade_trace_ring *next;
+    for (rade_trace_ring *r = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE); r; r = next) {
+        next = r->next;
+        int dead = __atomic_load_n(&r->dead, __ATOMIC_ACQUIRE);
+        uint32_t n = r->mask + 1;
+        rade_trace_event *copy = (rade_trace_event *)malloc((size_t)n * sizeof(rade_trace_event));
+        if (copy == NULL) {
+            continue;
+        }
+        uint64_t h1 = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        uint64_t first = h1 > n ? h1 - n : 0;
+        for (uint64_t i = first; i < h1; i++) {
+            copy[i & r->mask] = r->ev[i & r->mask];
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint64_t h2 = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+        if (h2 > n && h2 - n > first) {
+            first = h2 - n;         /* overwritten while we copied */
+        }
+
+        fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":",
+                sep, pid, r->tid);
+        json_str(f, r->name[0] ? r->name : "thread");
+        fprintf(f, "}}");
+        sep = ",\n";
+
+        for (uint64_t i = first; i < h1; i++) {
+            const rade_trace_event *e = &copy[i & r->mask];
+            const char *name = e->id < n_names ? trace_names[e->id] : "?";
+            fprintf(f, "%s{\"ph\":\"X\",\"name\":", sep);
+            json_str(f, name);
+            fprintf(f, ",\"pid\":%ld,\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f",
+                    pid, r->tid, (double)e->t_ns * 1e-3, (double)e->dur_ns * 1e-3);
+            if (e->arg) {
+                fprintf(f, ",\"args\":{\"n\":%u}", (unsigned)e->arg);
+            }
+            fputc('}', f);
+            n_out++;
+        }
+        free(copy);
+        if (dead) {
+            trace_ring_free(r);
+        }
+    }
+    pthread_mutex_unlock(&trace_write_lock);
+    fprintf(f, "\n]}\n");
+
+    if (fclose(f) != 0) {
+        return -1;
+    }
+    return n_out;
+}
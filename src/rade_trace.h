@@ -0,0 +1,128 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_trace.h
+
+  Opt in timeline tracing: begin/end times of the DSP stages recorded into
+  per thread lock-free rings and written out as Chrome trace JSON, to see
+  how the stages of a pipeline interleave across its threads.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_TRACE__
+#define __RADE_TRACE__
+
+#include <stdint.h>
+#include "rade_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*\
+                                  EVENTS
+\*---------------------------------------------------------------------------*/
+
+/* Library events.  Applications add their own with rade_trace_register() */
+#define RADE_TRACE_RX_BPF           0
+#define RADE_TRACE_ACQ_DETECT       1       /* rade_acq_detect_pilots() */
+#define RADE_TRACE_ACQ_REFINE       2       /* rade_acq_refine() */
+#define RADE_TRACE_ACQ_CHECK        3       /* rade_acq_check_pilots() */
+#define RADE_TRACE_ACQ_WARM         4       /* warm re-acquire search */
+#define RADE_TRACE_OFDM_DEMOD       5       /* rade_ofdm_demod_frame() */
+#define RADE_TRACE_CORE_DECODER     6       /* each rade_core_decoder(_batch)() call */
+#define RADE_TRACE_CORE_ENCODER     7       /* each rade_core_encoder() call */
+#define RADE_TRACE_TX_MOD           8       /* OFDM mod and Tx BPF */
+#define RADE_TRACE_NLIB             9
+#define RADE_TRACE_MAX_IDS          64
+
+#define RADE_TRACE_DEFAULT_EVENTS   (1 << 16)   /* per thread, 1 MB */
+
+typedef struct {
+    uint64_t t_ns;                          /* begin, rade_time_ns() */
+    uint32_t dur_ns;
+    uint16_t id;
+    uint16_t arg;                           /* shown as args.n, e.g. batch size */
+} rade_trace_event;
+
+/* Set while tracing, read by every trace point */
+extern int rade_trace_on;
+
+/* Start recording, keeping the most recent events_per_thread (rounded up
+   to a power of two, 0 for the default) begin/end pairs of each thread.
+   A thread's ring is allocated at its first event and kept after the
+   thread exits, until rade_trace_write() has written it out and frees it */
+void rade_trace_start(int events_per_thread);
+
+/* Stop recording, events recorded so far are kept */
+void rade_trace_stop(void);
+
+/* Write every thread's events as a Chrome trace (chrome://tracing or
+   ui.perfetto.dev).  Safe while tracing, events wrapped over during the
+   copy are left out.  The rings of threads that have exited are freed once
+   written.  Returns the number of events written, -1 if path can't be
+   written */
+long rade_trace_write(const char *path);
+
+/* An event id for name (a string that outlives tracing, e.g. a literal),
+   the same id for the same name.  -1 once RADE_TRACE_MAX_IDS are taken */
+int rade_trace_register(const char *name);
+
+/* Name the calling thread in the trace, at most 15 characters.  Cheap,
+   can be called whether or not tracing is on */
+void rade_trace_thread_name(const char *name);
+
+/* Record an event on the calling thread's ring */
+void rade_trace_add(int id, uint64_t t0_ns, uint64_t t1_ns, int arg);
+
+/* Trace points.  t = rade_trace_begin() ... rade_trace_end(id, t) costs a
+   load and a branch when tracing is off */
+static inline uint64_t rade_trace_begin(void) {
+    return __atomic_load_n(&rade_trace_on, __ATOMIC_RELAXED) ? rade_time_ns() : 0;
+}
+
+static inline void rade_trace_end(int id, uint64_t t0) {
+    if (t0 != 0) {
+        rade_trace_add(id, t0, rade_time_ns(), 0);
+    }
+}
+
+/* For a stage already timed for its histogram, from the same timestamps */
+static inline void rade_trace_span(int id, uint64_t t0, uint64_t t1) {
+    if (__atomic_load_n(&rade_trace_on, __ATOMIC_RELAXED)) {
+        rade_trace_add(id, t0, t1, 0);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_TRACE__ */
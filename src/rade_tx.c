@@ -34,8 +34,9 @@
 */
 
 #include "rade_tx.h"
-#include "rade_enc_data.h"
+#include "rade_trace.h"
 #include <string.h>
+#include <stdio.h>
 #include <assert.h>
 
 /*---------------------------------------------------------------------------*\
@@ -51,18 +52,14 @@ int rade_tx_init(rade_tx_state *tx, const RADEEnc *enc_model, int bottleneck, in
     tx->bpf_en = bpf_en;
 
     /* Initialize OFDM modulator */
-    rade_ofdm_init(&tx->ofdm, bottleneck);
-
-    /* Initialize encoder if model provided */
-    if (enc_model != NULL) {
-        memcpy(&tx->enc_model, enc_model, sizeof(RADEEnc));
-    } else {
-        /* Use built-in weights */
-        int input_dim = tx->num_features * RADE_FRAMES_PER_STEP;
-        if (init_radeenc(&tx->enc_model, radeenc_arrays, input_dim) != 0) {
-            return -1;
-        }
+    rade_ofdm_init(&tx->ofdm, bottleneck, RADE_OFDM_ENGINE_FFT);
+
+    /* Encoder weights are shared, we only keep the recurrent state */
+    if (enc_model == NULL) {
+        fprintf(stderr, "rade_tx_init: no encoder model\n");
+        return -1;
     }
+    tx->enc_model = enc_model;
     rade_init_encoder(&tx->enc_state);
 
     /* Initialize Tx BPF if enabled */
@@ -72,7 +69,7 @@ int rade_tx_init(rade_tx_state *tx, const RADEEnc *enc_model, int bottleneck, in
         float w_max = tx->ofdm.w[RADE_NC - 1];
         float bandwidth = 1.2f * (w_max - w_min) * RADE_FS / (2.0f * M_PI);
         float centre = (w_max + w_min) * RADE_FS / (2.0f * M_PI) / 2.0f;
-        rade_bpf_init(&tx->bpf, RADE_BPF_NTAP, RADE_FS, bandwidth, centre, RADE_FS);
+        rade_bpf_init(&tx->bpf, RADE_BPF_NTAP, RADE_FS, bandwidth, centre, RADE_FS, RADE_BPF_DIRECT);
     }
 
     /* EOO bits count: (Ns-1) * Nc * 2 (QPSK symbols) */
@@ -86,6 +83,8 @@ int rade_tx_init(rade_tx_state *tx, const RADEEnc *enc_model, int bottleneck, in
 
 void rade_tx_reset(rade_tx_state *tx) {
     rade_init_encoder(&tx->enc_state);
+    tx->n_z = 0;
+    tx->t_encoder = 0;
     if (tx->bpf_en) {
         rade_bpf_reset(&tx->bpf);
     }
@@ -95,6 +94,18 @@ void rade_tx_reset(rade_tx_state *tx) {
                            TRANSMISSION
 \*---------------------------------------------------------------------------*/
 
+/* Tx BPF in place, then clip the magnitude to 1.  Only samples over 1 pay
+   for the square root */
+static void tx_bpf_clip(rade_tx_state *tx, RADE_COMP *tx_out, int n) {
+    rade_bpf_process(&tx->bpf, tx_out, tx_out, n);
+    for (int i = 0; i < n; i++) {
+        float mag2 = rade_cabs2(tx_out[i]);
+        if (mag2 > 1.0f) {
+            tx_out[i] = rade_cscale(tx_out[i], 1.0f / sqrtf(mag2));
+        }
+    }
+}
+
 int rade_tx_n_features_in(const rade_tx_state *tx) {
     /* Features per modem frame: Nzmf * enc_stride * nb_total_features */
     return RADE_NZMF * RADE_FRAMES_PER_STEP * RADE_NB_TOTAL_FEATURES;
@@ -116,72 +127,103 @@ void rade_tx_state_set_eoo_bits(rade_tx_state *tx, const float *bits) {
     memcpy(tx->eoo_bits, bits, sizeof(float) * tx->n_eoo_bits);
 }
 
-int rade_tx_process(rade_tx_state *tx, RADE_COMP *tx_out, const float *features_in) {
-    int Nzmf = RADE_NZMF;
+int rade_tx_n_features_stride(void) {
+    return RADE_FRAMES_PER_STEP * RADE_NB_TOTAL_FEATURES;
+}
+
+int rade_tx_encode_stride(rade_tx_state *tx, const float *features_in) {
     int enc_stride = RADE_FRAMES_PER_STEP;
-    int latent_dim = RADE_LATENT_DIM;
     int num_features = tx->num_features;
     int num_used_features = RADE_NUM_FEATURES;
     int nb_total_features = RADE_NB_TOTAL_FEATURES;
-    int arch = 0;  /* CPU architecture for optimized routines */
 
-    /* Number of encoder calls per modem frame */
-    int n_feature_vecs = Nzmf * enc_stride;
-    int n_core_encoder = n_feature_vecs / enc_stride;  /* = Nzmf */
+    assert(tx->n_z < RADE_NZMF);
+    if (tx->n_z == 0) {
+        tx->enc_state_frame = tx->enc_state;
+    }
+
+    /* Extract and reformat features for encoder
+       Input format: [frame][feature] where feature is padded to 36
+       Encoder format: [frame][num_features] where num_features is 20 or 21 */
+    float enc_features[RADE_FRAMES_PER_STEP * RADE_NUM_FEATURES_AUX];
 
-    /* Latent vectors output buffer */
-    float z[RADE_NZMF * RADE_LATENT_DIM];
+    uint64_t t0 = rade_time_ns();
+    for (int i = 0; i < enc_stride; i++) {
+        int in_idx = i * nb_total_features;
 
-    /* Process each group of FRAMES_PER_STEP features through encoder */
-    for (int c = 0; c < n_core_encoder; c++) {
-        /* Extract and reformat features for encoder
-           Input format: [frame][feature] where feature is padded to 36
-           Encoder format: [frame][num_features] where num_features is 20 or 21 */
-        float enc_features[RADE_FRAMES_PER_STEP * RADE_NUM_FEATURES_AUX];
-
-        for (int i = 0; i < enc_stride; i++) {
-            int in_idx = (c * enc_stride + i) * nb_total_features;
-
-            /* Copy used features */
-            for (int j = 0; j < num_used_features; j++) {
-                enc_features[i * num_features + j] = features_in[in_idx + j];
-            }
-
-            /* Add auxiliary data symbol if enabled */
-            if (tx->auxdata) {
-                enc_features[i * num_features + num_used_features] = -1.0f;
-            }
+        /* Copy used features */
+        for (int j = 0; j < num_used_features; j++) {
+            enc_features[i * num_features + j] = features_in[in_idx + j];
         }
 
-        /* Run core encoder */
-        rade_core_encoder(&tx->enc_state, &tx->enc_model,
-                         &z[c * latent_dim], enc_features, arch, tx->bottleneck);
+        /* Add auxiliary data symbol if enabled */
+        if (tx->auxdata) {
+            enc_features[i * num_features + num_used_features] = -1.0f;
+        }
+    }
+
+    /* Run core encoder */
+    uint64_t tt = rade_trace_begin();
+    rade_core_encoder(&tx->enc_state, tx->enc_model,
+                     &tx->z[tx->n_z * RADE_LATENT_DIM], enc_features, tx->arch, tx->bottleneck);
+    rade_trace_end(RADE_TRACE_CORE_ENCODER, tt);
+    tx->n_z++;
+    tx->t_encoder += rade_time_ns() - t0;
+
+    return tx->n_z == RADE_NZMF;
+}
+
+/* Drop a partial modem frame from rade_tx_encode_stride(), and its strides'
+   effect on the encoder state */
+static void tx_discard_strides(rade_tx_state *tx) {
+    if (tx->n_z > 0) {
+        tx->enc_state = tx->enc_state_frame;
+    }
+    tx->n_z = 0;
+    tx->t_encoder = 0;
+}
+
+int rade_tx_process(rade_tx_state *tx, RADE_COMP *tx_out, const float *features_in) {
+    int n_stride = rade_tx_n_features_stride();
+
+    /* Process each group of FRAMES_PER_STEP features through encoder */
+    tx_discard_strides(tx);
+    for (int c = 0; c < RADE_NZMF; c++) {
+        rade_tx_encode_stride(tx, &features_in[c * n_stride]);
     }
 
+    return rade_tx_mod(tx, tx_out);
+}
+
+int rade_tx_mod(rade_tx_state *tx, RADE_COMP *tx_out) {
+    assert(tx->n_z == RADE_NZMF);
+
+    /* Encoder time is logged per modem frame, however the strides arrived */
+    rade_hist_add(&tx->hist_encoder, tx->t_encoder);
+    tx->n_z = 0;
+    tx->t_encoder = 0;
+
+    uint64_t t1 = rade_time_ns();
+    uint64_t tt = rade_trace_begin();
+
     /* Modulate latent vectors to IQ samples */
-    int n_out = rade_ofdm_mod_frame(&tx->ofdm, tx_out, z);
+    int n_out = rade_ofdm_mod_frame(&tx->ofdm, tx_out, tx->z);
 
     /* Apply Tx BPF if enabled */
     if (tx->bpf_en) {
-        RADE_COMP tx_filtered[RADE_NMF];
-        rade_bpf_process(&tx->bpf, tx_filtered, tx_out, n_out);
-
-        /* Clip magnitude to 1 after filtering */
-        for (int i = 0; i < n_out; i++) {
-            float mag = rade_cabs(tx_filtered[i]);
-            if (mag > 1.0f) {
-                tx_out[i] = rade_cscale(tx_filtered[i], 1.0f / mag);
-            } else {
-                tx_out[i] = tx_filtered[i];
-            }
-        }
+        tx_bpf_clip(tx, tx_out, n_out);
     }
+    rade_trace_end(RADE_TRACE_TX_MOD, tt);
+    rade_hist_add(&tx->hist_mod, rade_time_ns() - t1);
 
     return n_out;
 }
 
 int rade_tx_state_eoo(rade_tx_state *tx, RADE_COMP *tx_out) {
     int n_eoo;
+
+    /* A partial modem frame from rade_tx_encode_stride() ends with the over */
+    tx_discard_strides(tx);
     const RADE_COMP *eoo = rade_ofdm_get_eoo(&tx->ofdm, &n_eoo);
 
     /* Copy pre-computed EOO frame */
@@ -189,18 +231,7 @@ int rade_tx_state_eoo(rade_tx_state *tx, RADE_COMP *tx_out) {
 
     /* Apply Tx BPF if enabled */
     if (tx->bpf_en) {
-        RADE_COMP tx_filtered[RADE_NEOO];
-        rade_bpf_process(&tx->bpf, tx_filtered, tx_out, n_eoo);
-
-        /* Clip magnitude to 1 after filtering */
-        for (int i = 0; i < n_eoo; i++) {
-            float mag = rade_cabs(tx_filtered[i]);
-            if (mag > 1.0f) {
-                tx_out[i] = rade_cscale(tx_filtered[i], 1.0f / mag);
-            } else {
-                tx_out[i] = tx_filtered[i];
-            }
-        }
+        tx_bpf_clip(tx, tx_out, n_eoo);
     }
 
     return n_eoo;
@@ -41,6 +41,7 @@
 #include "rade_bpf.h"
 #include "rade_enc.h"
 #include "rade_core.h"
+#include "rade_stats.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -58,19 +59,32 @@ typedef struct {
     rade_bpf bpf;
     int bpf_en;
 
-    /* Core encoder */
-    RADEEnc enc_model;
+    /* Core encoder, weights are shared read only between transmitters */
+    const RADEEnc *enc_model;
     RADEEncState enc_state;
+    int arch;               /* CPU feature level for dnn kernels (0 = generic C) */
 
     /* Configuration */
     int bottleneck;
     int auxdata;
     int num_features;       /* 20 or 21 (with auxdata) */
 
+    /* Latents of the modem frame being built by rade_tx_encode_stride(),
+       and the encoder state before its first stride, put back if the
+       frame is discarded */
+    float z[RADE_NZMF * RADE_LATENT_DIM];
+    int n_z;                /* strides encoded so far, 0..RADE_NZMF */
+    RADEEncState enc_state_frame;
+    uint64_t t_encoder;     /* encoder time for those strides (ns) */
+
     /* EOO bits (for supplementary data channel) */
     float eoo_bits[RADE_NC * (RADE_NS - 1) * 2];  /* Nseoo * 2 */
     int n_eoo_bits;
 
+    /* Stage timers, written only by the thread running the transmitter */
+    rade_hist hist_encoder;
+    rade_hist hist_mod;
+
 } rade_tx_state;
 
 /*---------------------------------------------------------------------------*\
@@ -78,7 +92,8 @@ typedef struct {
 \*---------------------------------------------------------------------------*/
 
 /* Initialize transmitter
-   enc_model: pointer to encoder model weights (can be NULL to skip encoder init)
+   enc_model: encoder model weights, used by reference (not copied) so one
+              model can serve many transmitters; must outlive tx
    bottleneck: 1, 2, or 3 (PA saturation model)
    auxdata: 1 to enable auxiliary data symbols
    bpf_en: 1 to enable Tx bandpass filter
@@ -108,13 +123,33 @@ int rade_tx_n_eoo_bits(const rade_tx_state *tx);
    bits: array of n_eoo_bits floats (+1 or -1) */
 void rade_tx_state_set_eoo_bits(rade_tx_state *tx, const float *bits);
 
-/* Transmit one modem frame
+/* Transmit one modem frame, any strides queued by rade_tx_encode_stride()
+   are discarded, and the encoder state goes back to before them, as if
+   they had never been encoded
    features_in: input features [n_features_in] in padded format (36 floats per frame)
    tx_out: output IQ samples [n_samples_out]
    Returns number of samples written to tx_out */
 int rade_tx_process(rade_tx_state *tx, RADE_COMP *tx_out, const float *features_in);
 
-/* Transmit end-of-over frame
+/* Get number of input features per encoder stride (RADE_FRAMES_PER_STEP
+   feature frames) */
+int rade_tx_n_features_stride(void);
+
+/* Run the core encoder on one stride as soon as its features are ready,
+   rather than on a whole modem frame at once
+   features_in: input features [n_features_stride] in padded format
+   Returns 1 once RADE_NZMF strides are queued and rade_tx_mod() may be
+   called, 0 otherwise */
+int rade_tx_encode_stride(rade_tx_state *tx, const float *features_in);
+
+/* Modulate the latents queued by rade_tx_encode_stride(), which must have
+   returned 1, and start a new modem frame
+   tx_out: output IQ samples [n_samples_out]
+   Returns number of samples written to tx_out */
+int rade_tx_mod(rade_tx_state *tx, RADE_COMP *tx_out);
+
+/* Transmit end-of-over frame, any strides queued by rade_tx_encode_stride()
+   are discarded as for rade_tx_process()
    tx_out: output IQ samples [n_eoo_out]
    Returns number of samples written */
 int rade_tx_state_eoo(rade_tx_state *tx, RADE_COMP *tx_out);
@@ -0,0 +1,365 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_wav.c
+
+  Streaming WAV files for the tools, see rade_wav.h.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rade_wav.h"
+
+#define WAV_FMT_PCM         1
+#define WAV_FMT_FLOAT       3
+#define WAV_FMT_EXTENSIBLE  0xfffe
+#define WAV_HEADER_BYTES    44
+
+/*---------------------------------------------------------------------------*\
+                                 READING
+\*---------------------------------------------------------------------------*/
+
+/* Walk the chunks to the data, leaving f at its first sample */
+static int wav_parse(rade_wav_reader *w, uint32_t *data_size) {
+    FILE *f = w->f;
+    char tag[4];
+    uint32_t riff_size;
+    int fmt = -1;
+
+    if (fread(tag, 1, 4, f) != 4 || memcmp(tag, "RIFF", 4) != 0) return -1;
+    if (fread(&riff_size, 4, 1, f) != 1) return -1;
+    if (fread(tag, 1, 4, f) != 4 || memcmp(tag, "WAVE", 4) != 0) return -1;
+
+    while (1) {
+        char chunk_id[4];
+        uint32_t chunk_size;
+        if (fread(chunk_id, 1, 4, f) != 4) return -1;
+        if (fread(&chunk_size, 4, 1, f) != 1) return -1;
+
+        if (memcmp(chunk_id, "fmt ", 4) == 0) {
+            uint8_t buf[26];
+            uint32_t len = chunk_size < sizeof(buf) ? chunk_size : (uint32_t)sizeof(buf);
+            if (chunk_size < 16 || fread(buf, 1, len, f) != len) return -1;
+
+            uint16_t audio_fmt, nch, bps;
+            uint32_t sr;
+            memcpy(&audio_fmt, buf + 0,  2);
+            memcpy(&nch,       buf + 2,  2);
+            memcpy(&sr,        buf + 4,  4);
+            memcpy(&bps,       buf + 14, 2);
+            /* WAVE_FORMAT_EXTENSIBLE keeps the real format in its sub GUID */
+            if (audio_fmt == WAV_FMT_EXTENSIBLE && len >= 26) {
+                memcpy(&audio_fmt, buf + 24, 2);
+            }
+            fmt = audio_fmt;
+            w->sample_rate = (int)sr;
+            w->channels = (int)nch;
+            w->bits = (int)bps;
+            w->is_float = (audio_fmt == WAV_FMT_FLOAT);
+
+            if (fseek(f, (long)((chunk_size + 1) & ~1u) - (long)len, SEEK_CUR) != 0) return -1;
+        } else if (memcmp(chunk_id, "data", 4) == 0) {
+            if (fmt < 0) return -1;
+            w->data_offset = ftell(f);
+            *data_size = chunk_size;
+            break;
+        } else {
+            if (fseek(f, (long)((chunk_size + 1) & ~1u), SEEK_CUR) != 0) return -1;
+        }
+    }
+
+    if (fmt != WAV_FMT_PCM && fmt != WAV_FMT_FLOAT) return -2;
+    if (w->is_float) {
+        w->bytes = (w->bits == 32 || w->bits == 64) ? w->bits / 8 : 0;
+    } else {
+        w->bytes = (w->bits == 16 || w->bits == 24 || w->bits == 32) ? w->bits / 8 : 0;
+    }
+    if (w->bytes == 0 || w->channels < 1 || w->sample_rate < 1) return -2;
+    return 0;
+}
+
+int rade_wav_open(rade_wav_reader *w, const char *path) {
+    memset(w, 0, sizeof(*w));
+
+    w->f = fopen(path, "rb");
+    if (w->f == NULL) {
+        return -1;
+    }
+    uint32_t data_size = 0;
+    int ret = wav_parse(w, &data_size);
+    if (ret == 0) {
+        w->frames = data_size / ((uint32_t)w->bytes * (uint32_t)w->channels);
+        w->left = w->frames;
+        w->raw = (uint8_t *)malloc((size_t)RADE_WAV_BLOCK * w->channels * w->bytes);
+        w->mix = (float *)malloc((size_t)RADE_WAV_BLOCK * w->channels * sizeof(float));
+        w->buf = (char *)malloc(RADE_WAV_IO_BUF);
+        if (w->raw == NULL || w->mix == NULL) {
+            ret = -1;
+        } else if (w->buf != NULL) {
+            setvbuf(w->f, w->buf, _IOFBF, RADE_WAV_IO_BUF);
+        }
+    }
+    if (ret != 0) {
+        /* keep the format for the caller's error message */
+        int sample_rate = w->sample_rate, channels = w->channels, bits = w->bits;
+        rade_wav_close(w);
+        if (ret == -2) {
+            w->sample_rate = sample_rate;
+            w->channels = channels;
+            w->bits = bits;
+        }
+        return ret;
+    }
+
+    w->kern = rade_kernels_get();
+    return 0;
+}
+
+/* ns interleaved samples of raw to float, full scale 1.0 */
+static void wav_to_float(const rade_wav_reader *w, float *y, const uint8_t *raw, long ns) {
+    long i;
+    if (w->is_float && w->bytes == 4) {
+        memcpy(y, raw, (size_t)ns * sizeof(float));
+    } else if (w->is_float) {
+        for (i = 0; i < ns; i++) {
+            double v;
+            memcpy(&v, raw + 8 * i, 8);
+            y[i] = (float)v;
+        }
+    } else if (w->bytes == 2) {
+        w->kern->s16_to_float(y, (const int16_t *)raw, 1.0f / 32768.0f, (int)ns);
+    } else if (w->bytes == 3) {
+        for (i = 0; i < ns; i++) {
+            const uint8_t *p = raw + 3 * i;
+            int32_t v = ((int32_t)p[2] << 16) | (p[1] << 8) | p[0];
+            if (v & 0x800000) v |= (int32_t)0xFF000000;
+            y[i] = v / 8388608.0f;
+        }
+    } else {
+        for (i = 0; i < ns; i++) {
+            int32_t v;
+            memcpy(&v, raw + 4 * i, 4);
+            y[i] = v / 2147483648.0f;
+        }
+    }
+}
+
+long rade_wav_read(rade_wav_reader *w, float *out, long n) {
+    const int nch = w->channels;
+    const size_t frame_bytes = (size_t)nch * (size_t)w->bytes;
+    long done = 0;
+
+    if (w->f == NULL) {
+        return 0;
+    }
+    while (done < n && w->left > 0) {
+        long want = n - done;
+        if (want > RADE_WAV_BLOCK) want = RADE_WAV_BLOCK;
+        if ((uint64_t)want > w->left) want = (long)w->left;
+
+        long got = (long)fread(w->raw, frame_bytes, (size_t)want, w->f);
+        if (got == 0) {
+            w->left = 0;                            /* truncated data chunk */
+            break;
+        }
+        w->left -= (uint64_t)got;
+
+        float *y = out + done;
+        if (nch == 1) {
+            wav_to_float(w, y, w->raw, got);
+        } else {
+            wav_to_float(w, w->mix, w->raw, got * nch);
+            for (long i = 0; i < got; i++) {
+                const float *p = &w->mix[i * nch];
+                float sum = 0.0f;
+                for (int ch = 0; ch < nch; ch++) {
+                    sum += p[ch];
+                }
+                y[i] = sum / nch;
+            }
+        }
+        done += got;
+    }
+    return done;
+}
+
+float *rade_wav_read_all(rade_wav_reader *w, long *n) {
+    *n = 0;
+    if (w->f == NULL || w->left == 0) {
+        return NULL;
+    }
+    float *x = (float *)malloc((size_t)w->left * sizeof(float));
+    if (x == NULL) {
+        return NULL;
+    }
+    *n = rade_wav_read(w, x, (long)w->left);
+    return x;
+}
+
+int rade_wav_seek(rade_wav_reader *w, uint64_t frame) {
+    if (w->f == NULL) {
+        return -1;
+    }
+    if (frame > w->frames) {
+        frame = w->frames;
+    }
+    long pos = w->data_offset + (long)(frame * (uint64_t)w->channels * (uint64_t)w->bytes);
+    if (fseek(w->f, pos, SEEK_SET) != 0) {
+        return -1;
+    }
+    w->left = w->frames - frame;
+    return 0;
+}
+
+void rade_wav_close(rade_wav_reader *w) {
+    if (w->f != NULL) {
+        fclose(w->f);
+    }
+    free(w->buf);
+    free(w->raw);
+    free(w->mix);
+    memset(w, 0, sizeof(*w));
+}
+
+/*---------------------------------------------------------------------------*\
+                                 WRITING
+\*---------------------------------------------------------------------------*/
+
+static void put16(uint8_t *p, uint16_t v) { memcpy(p, &v, 2); }
+static void put32(uint8_t *p, uint32_t v) { memcpy(p, &v, 4); }
+
+static void wav_header(uint8_t *h, int sample_rate, uint32_t data_bytes) {
+    memcpy(h + 0, "RIFF", 4);
+    put32(h + 4, 36 + data_bytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put32(h + 16, 16);
+    put16(h + 20, WAV_FMT_PCM);
+    put16(h + 22, 1);                               /* mono */
+    put32(h + 24, (uint32_t)sample_rate);
+    put32(h + 28, (uint32_t)sample_rate * 2);       /* bytes/s */
+    put16(h + 32, 2);                               /* block align */
+    put16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    put32(h + 40, data_bytes);
+}
+
+int rade_wav_create(rade_wav_writer *w, const char *path, int sample_rate) {
+    memset(w, 0, sizeof(*w));
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    w->buf = (char *)malloc(RADE_WAV_IO_BUF);
+    if (w->buf != NULL) {
+        setvbuf(f, w->buf, _IOFBF, RADE_WAV_IO_BUF);
+    }
+
+    /* the sizes are filled in by rade_wav_finish() */
+    uint8_t h[WAV_HEADER_BYTES];
+    wav_header(h, sample_rate, 0);
+    if (fwrite(h, sizeof(h), 1, f) != 1) {
+        fclose(f);
+        free(w->buf);
+        memset(w, 0, sizeof(*w));
+        return -1;
+    }
+
+    w->f = f;
+    w->sample_rate = sample_rate;
+    w->kern = rade_kernels_get();
+    return 0;
+}
+
+static void wav_flush(rade_wav_writer *w) {
+    if (w->n > 0 && !w->error) {
+        if (fwrite(w->pcm, sizeof(int16_t), (size_t)w->n, w->f) != (size_t)w->n) {
+            w->error = 1;
+        } else {
+            w->data_bytes += (uint32_t)w->n * sizeof(int16_t);
+        }
+    }
+    w->n = 0;
+}
+
+void rade_wav_write(rade_wav_writer *w, const float *x, int n, float scale) {
+    if (w->f == NULL || w->error) {
+        return;
+    }
+    while (n > 0) {
+        int m = RADE_WAV_BLOCK - w->n;
+        if (m > n) m = n;
+        w->kern->float_to_s16(&w->pcm[w->n], x, scale, m);
+        w->n += m;
+        x += m;
+        n -= m;
+        if (w->n == RADE_WAV_BLOCK) {
+            wav_flush(w);
+        }
+    }
+}
+
+void rade_wav_write_s16(rade_wav_writer *w, const int16_t *x, int n) {
+    if (w->f == NULL || w->error) {
+        return;
+    }
+    while (n > 0) {
+        int m = RADE_WAV_BLOCK - w->n;
+        if (m > n) m = n;
+        memcpy(&w->pcm[w->n], x, (size_t)m * sizeof(int16_t));
+        w->n += m;
+        x += m;
+        n -= m;
+        if (w->n == RADE_WAV_BLOCK) {
+            wav_flush(w);
+        }
+    }
+}
+
+int rade_wav_finish(rade_wav_writer *w) {
+    if (w->f == NULL) {
+        return -1;
+    }
+    wav_flush(w);
+    int ret = w->error ? -1 : 0;
+
+    uint8_t h[WAV_HEADER_BYTES];
+    wav_header(h, w->sample_rate, w->data_bytes);
+    if (fseek(w->f, 0, SEEK_SET) != 0 || fwrite(h, sizeof(h), 1, w->f) != 1) {
+        ret = -1;                                   /* e.g. a pipe, the header stays at 0 */
+    }
+    if (fclose(w->f) != 0) {
+        ret = -1;
+    }
+    free(w->buf);
+    memset(w, 0, sizeof(*w));
+    return ret;
+}
@@ -0,0 +1,125 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_wav.h
+
+  Streaming WAV files for the tools: a reader that converts blocks of 16,
+  24 or 32 bit PCM or float samples to mono float with the SIMD kernels,
+  and a buffered writer of 16 bit mono PCM.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_WAV__
+#define __RADE_WAV__
+
+#include <stdint.h>
+#include <stdio.h>
+#include "rade_kernels.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADE_WAV_BLOCK      4096            /* frames converted per pass */
+#define RADE_WAV_IO_BUF     (64 * 1024)     /* stdio buffer for the reader and writer */
+
+/*---------------------------------------------------------------------------*\
+                                 READING
+\*---------------------------------------------------------------------------*/
+
+typedef struct {
+    FILE       *f;
+    char       *buf;                        /* stdio buffer */
+    int         sample_rate;
+    int         channels;
+    int         bits;                       /* bits per sample */
+    int         is_float;                   /* IEEE float rather than PCM */
+    int         bytes;                      /* per sample */
+    long        data_offset;                /* of the first sample */
+    uint64_t    frames;                     /* in the data chunk */
+    uint64_t    left;                       /* frames not read yet */
+    uint8_t    *raw;                        /* one block as read */
+    float      *mix;                        /* ... converted, before the downmix */
+    const rade_kernels *kern;
+} rade_wav_reader;
+
+/* Open path and parse the header, leaving it at the first sample.  Takes
+   16, 24 and 32 bit PCM and 32 and 64 bit float, any rate and channels.
+   Returns 0, -1 if it can't be opened or isn't a WAV file, -2 for a WAV
+   format we don't read (sample_rate, channels and bits are still set, for
+   the error message); w is zeroed on failure */
+int rade_wav_open(rade_wav_reader *w, const char *path);
+
+/* Read up to n frames as mono float (full scale 1.0, channels averaged).
+   Returns the frames read, 0 at the end of the data */
+long rade_wav_read(rade_wav_reader *w, float *out, long n);
+
+/* The whole rest of the file, malloc()ed, NULL if it's empty or on a
+   failed allocation.  *n is how many frames */
+float *rade_wav_read_all(rade_wav_reader *w, long *n);
+
+/* Position at frame (clamped to the end); 0 or -1 if the seek failed */
+int rade_wav_seek(rade_wav_reader *w, uint64_t frame);
+
+void rade_wav_close(rade_wav_reader *w);
+
+/*---------------------------------------------------------------------------*\
+                                 WRITING
+\*---------------------------------------------------------------------------*/
+
+typedef struct {
+    FILE       *f;
+    char       *buf;                        /* stdio buffer */
+    int         sample_rate;
+    uint32_t    data_bytes;                 /* written so far */
+    int         n;                          /* samples waiting in pcm */
+    int16_t     pcm[RADE_WAV_BLOCK];
+    int         error;                      /* a write failed, later ones are dropped */
+    const rade_kernels *kern;
+} rade_wav_writer;
+
+/* Create path as a 16 bit mono PCM WAV file at sample_rate.  The header
+   is filled in by rade_wav_finish().  Returns 0, or -1 with w zeroed */
+int rade_wav_create(rade_wav_writer *w, const char *path, int sample_rate);
+
+/* Append n samples x[i] * scale, rounded and clamped as float_to_s16 in
+   rade_kernels.h; scale 32768 for full scale 1.0 */
+void rade_wav_write(rade_wav_writer *w, const float *x, int n, float scale);
+
+/* Append n 16 bit samples */
+void rade_wav_write_s16(rade_wav_writer *w, const int16_t *x, int n);
+
+/* Flush, write the header and close.  Returns 0 if everything was written */
+int rade_wav_finish(rade_wav_writer *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_WAV__ */
@@ -0,0 +1,235 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_weights.c
+
+  Helpers for the RADE weight tables: int8 selection and weights blobs.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "rade_weights.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FLOAT_SUFFIX "_weights_float"
+#define INT8_SUFFIX  "_weights_int8"
+
+static int has_suffix(const char *name, const char *suffix, size_t *stem) {
+    size_t n = strlen(name), m = strlen(suffix);
+    if (n < m || strcmp(name + n - m, suffix) != 0) {
+        return 0;
+    }
+    *stem = n - m;
+    return 1;
+}
+
+/* The entry named stem + suffix, or NULL */
+static const WeightArray *sibling(const WeightArray *arrays, const char *name, size_t stem,
+                                  const char *suffix) {
+    for (const WeightArray *a = arrays; a->name != NULL; a++) {
+        size_t s;
+        if (has_suffix(a->name, suffix, &s) && s == stem &&
+            strncmp(a->name, name, stem) == 0) {
+            return a;
+        }
+    }
+    return NULL;
+}
+
+WeightArray *rade_weights_int8(const WeightArray *arrays) {
+    int n = 0;
+    while (arrays[n].name != NULL) {
+        n++;
+    }
+
+    WeightArray *out = (WeightArray *)malloc(sizeof(WeightArray) * (n + 1));
+    if (out == NULL) {
+        return NULL;
+    }
+
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        size_t stem;
+        if (has_suffix(arrays[i].name, FLOAT_SUFFIX, &stem) &&
+            sibling(arrays, arrays[i].name, stem, INT8_SUFFIX) != NULL) {
+            continue;
+        }
+        out[k++] = arrays[i];
+    }
+    memset(&out[k], 0, sizeof(WeightArray));
+    return out;
+}
+
+/* Whether a model initialised from arrays (int8 or not) reads a */
+static int array_used(const WeightArray *arrays, const WeightArray *a, int int8) {
+    size_t stem;
+    if (has_suffix(a->name, FLOAT_SUFFIX, &stem)) {
+        return !int8 || sibling(arrays, a->name, stem, INT8_SUFFIX) == NULL;
+    }
+    if (has_suffix(a->name, INT8_SUFFIX, &stem)) {
+        return int8 || sibling(arrays, a->name, stem, FLOAT_SUFFIX) == NULL;
+    }
+    return 0;
+}
+
+long rade_weights_bytes(const WeightArray *arrays, int int8) {
+    long bytes = 0;
+    for (const WeightArray *a = arrays; a->name != NULL; a++) {
+        if (array_used(arrays, a, int8)) {
+            bytes += a->size;
+        }
+    }
+    return bytes;
+}
+
+long rade_weights_prefault(const WeightArray *arrays, int int8) {
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) {
+        page = 4096;
+    }
+
+    /* Every array, not just the weights: biases and scales are small but
+       can still sit alone on a page */
+    long bytes = 0;
+    volatile unsigned char sink = 0;
+    for (const WeightArray *a = arrays; a->name != NULL; a++) {
+        size_t stem;
+        if ((has_suffix(a->name, FLOAT_SUFFIX, &stem) || has_suffix(a->name, INT8_SUFFIX, &stem)) &&
+            !array_used(arrays, a, int8)) {
+            continue;
+        }
+        const unsigned char *p = (const unsigned char *)a->data;
+        if (p == NULL || a->size <= 0) {
+            continue;
+        }
+        for (long i = 0; i < a->size; i += page) {
+            sink ^= p[i];
+        }
+        sink ^= p[a->size - 1];
+        bytes += a->size;
+    }
+    (void)sink;
+    return bytes;
+}
+
+/*---------------------------------------------------------------------------*\
+                              WEIGHTS BLOBS
+\*---------------------------------------------------------------------------*/
+
+int rade_weights_map(rade_weights_blob *blob, const char *path) {
+    memset(blob, 0, sizeof(*blob));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > 0x7fffffff) {
+        close(fd);
+        return -1;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    WeightArray *list = NULL;
+    int n = parse_weights(&list, data, (int)st.st_size);
+    if (n <= 0 || list == NULL) {
+        free(list);
+        munmap(data, (size_t)st.st_size);
+        return -1;
+    }
+
+    blob->data = data;
+    blob->len  = (size_t)st.st_size;
+    blob->list = list;
+    blob->n    = n;
+    return 0;
+}
+
+void rade_weights_unmap(rade_weights_blob *blob) {
+    free(blob->list);
+    if (blob->data != NULL) {
+        munmap(blob->data, blob->len);
+    }
+    memset(blob, 0, sizeof(*blob));
+}
+
+int rade_weights_write(const char *path, const WeightArray *const lists[], int n, int int8) {
+    static const unsigned char zeros[WEIGHT_BLOCK_SIZE] = {0};
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+
+    int ok = 1;
+    for (int l = 0; l < n && ok; l++) {
+        for (const WeightArray *a = lists[l]; a->name != NULL && ok; a++) {
+            size_t stem;
+            /* parse_weights() rejects empty records */
+            if (a->size <= 0) {
+                continue;
+            }
+            if (int8 && has_suffix(a->name, FLOAT_SUFFIX, &stem) &&
+                sibling(lists[l], a->name, stem, INT8_SUFFIX) != NULL) {
+                continue;
+            }
+
+            WeightHead h;
+            if (strlen(a->name) >= sizeof(h.name)) {
+                ok = 0;
+                break;
+            }
+            memset(&h, 0, sizeof(h));
+            memcpy(h.head, "DNNw", 4);
+            h.version    = WEIGHT_BLOB_VERSION;
+            h.type       = a->type;
+            h.size       = a->size;
+            h.block_size = (a->size + WEIGHT_BLOCK_SIZE - 1) / WEIGHT_BLOCK_SIZE * WEIGHT_BLOCK_SIZE;
+            strcpy(h.name, a->name);
+
+            ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+                 fwrite(a->data, 1, (size_t)a->size, f) == (size_t)a->size &&
+                 fwrite(zeros, 1, (size_t)(h.block_size - h.size), f) == (size_t)(h.block_size - h.size);
+        }
+    }
+
+    if (fclose(f) != 0) {
+        ok = 0;
+    }
+    return ok ? 0 : -1;
+}
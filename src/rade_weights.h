@@ -0,0 +1,102 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_weights.h
+
+  Helpers for the RADE weight tables: selecting the int8 quantised copy
+  of each layer instead of its float weights, and reading/writing the
+  tables as an Opus format weights blob so a model can be swapped without
+  a rebuild.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __RADE_WEIGHTS__
+#define __RADE_WEIGHTS__
+
+#include <stddef.h>
+#include "nnet.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The exported tables hold both int8 weights (with per row float scales)
+   and the float weights they were quantised from, for the dense, GRU,
+   GLU and conv layers.  Opus's linear layers use the float weights when
+   they are present, so dropping them from the list before init_radeenc()
+   or init_radedec() selects the int8 kernels, which stream a quarter of
+   the bytes.  Layers exported as float only (the input and output dense
+   layers) are kept as they are.
+
+   Returns a malloc()ed copy of arrays without the float weights that have
+   an int8 sibling, NULL terminated like the input, or NULL if out of
+   memory.  Free it with free() once the model is initialised, the model
+   points at the table data rather than the list */
+WeightArray *rade_weights_int8(const WeightArray *arrays);
+
+/* Number of bytes of weights a model initialised from arrays streams per
+   call, counting int8 weights where both are present and int8 is set,
+   otherwise float.  For reporting */
+long rade_weights_bytes(const WeightArray *arrays, int int8);
+
+/* Read one byte from every page of the tables a model initialised from
+   arrays uses (int8 as above), so they are resident before a real-time
+   thread first runs the layers rather than faulted in from the binary or
+   a blob mid-frame.  Returns the bytes covered */
+long rade_weights_prefault(const WeightArray *arrays, int int8);
+
+/* A weights blob mapped read only.  The pages are shared with every other
+   context and process mapping the same file, and are only read in from
+   disk as the layers first touch them */
+typedef struct {
+    void        *data;
+    size_t       len;
+    WeightArray *list;    /* from parse_weights(), points into data */
+    int          n;       /* entries in list */
+} rade_weights_blob;
+
+/* Map and parse the blob at path.  Returns 0 on success, -1 if the file
+   can't be mapped or is not a valid blob (blob is left zeroed) */
+int rade_weights_map(rade_weights_blob *blob, const char *path);
+
+/* Unmap a blob from rade_weights_map().  Any model initialised from it must
+   no longer be in use */
+void rade_weights_unmap(rade_weights_blob *blob);
+
+/* Write n NULL terminated lists (e.g. radeenc_arrays and radedec_arrays)
+   to path as one blob in the format parse_weights() reads.  With int8 set,
+   float weights that have an int8 sibling are left out.  Returns 0 on
+   success, -1 on error */
+int rade_weights_write(const char *path, const WeightArray *const lists[], int n, int int8);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RADE_WEIGHTS__ */
@@ -0,0 +1,195 @@
+#include "resampler.h"
+#include "resampler_c.h"
+
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <numeric>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* ── design parameters ───────────────────────────────────────────────── */
+
+static constexpr int    TAPS_PER_ZERO  = 32;      // taps per phase per unit of M/L
+static constexpr double PASS_FRAC      = 0.90;    // cutoff as a fraction of lower Nyquist
+static constexpr double KAISER_BETA    = 8.0;     // ~80 dB stopband
+static constexpr int    MAX_TABLE      = 1 << 16; // L × ntaps limit (floats)
+
+/* zeroth-order modified Bessel function, for the Kaiser window */
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    double q = x * x / 4.0;
+    for (int k = 1; k < 50; k++) {
+        term *= q / (static_cast<double>(k) * k);
+        sum  += term;
+        if (term < 1e-12 * sum) break;
+    }
+    return sum;
+}
+
+/* ── set up ──────────────────────────────────────────────────────────── */
+
+bool Resampler::init(unsigned int rate_in, unsigned int rate_out)
+{
+    if (rate_in == 0 || rate_out == 0) return false;
+
+    rate_in_  = rate_in;
+    rate_out_ = rate_out;
+
+    unsigned int g = std::gcd(rate_in, rate_out);
+    L_ = static_cast<int>(rate_out / g);
+    M_ = static_cast<int>(rate_in / g);
+    passthrough_ = (L_ == 1 && M_ == 1);
+
+    if (passthrough_) {
+        ntaps_ = 0;
+        phases_.clear();
+        hist_.clear();
+        reset();
+        return true;
+    }
+
+    /* longer filters when decimating so the transition band stays a
+       fixed fraction of the output rate */
+    int ratio = (M_ + L_ - 1) / L_;
+    ntaps_ = TAPS_PER_ZERO * (ratio > 1 ? ratio : 1);
+    if (static_cast<long>(L_) * ntaps_ > MAX_TABLE) return false;
+
+    /* prototype lowpass at the upsampled rate rate_in × L */
+    int    N      = L_ * ntaps_;
+    double fc     = PASS_FRAC * 0.5 / (L_ > M_ ? L_ : M_);   // cycles/sample
+    double centre = 0.5 * (N - 1);
+    double i0b    = bessel_i0(KAISER_BETA);
+
+    std::vector<double> h(static_cast<size_t>(N));
+    for (int k = 0; k < N; k++) {
+        double t = k - centre;
+        double x = 2.0 * fc * t;
+        double sinc = (std::fabs(x) < 1e-12) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+        double r = t / (0.5 * N);
+        double w = (std::fabs(r) < 1.0)
+                 ? bessel_i0(KAISER_BETA * std::sqrt(1.0 - r * r)) / i0b : 0.0;
+        h[static_cast<size_t>(k)] = 2.0 * fc * sinc * w * L_;   // gain L for zero stuffing
+    }
+
+    /* phase p uses taps h[p + m·L], m = 0 for the newest sample; store
+       oldest→newest so it lines up with the history window */
+    phases_.assign(static_cast<size_t>(N), 0.0f);
+    for (int p = 0; p < L_; p++)
+        for (int m = 0; m < ntaps_; m++)
+            phases_[static_cast<size_t>(p * ntaps_ + (ntaps_ - 1 - m))] =
+                static_cast<float>(h[static_cast<size_t>(p + m * L_)]);
+
+    hist_.assign(static_cast<size_t>(2 * ntaps_), 0.0f);
+    reset();
+    return true;
+}
+
+void Resampler::reset()
+{
+    std::fill(hist_.begin(), hist_.end(), 0.0f);
+    pos_   = 0;
+    phase_ = 0;
+}
+
+int Resampler::max_output(int n_in) const
+{
+    if (passthrough_) return n_in;
+    return static_cast<int>((static_cast<long>(n_in) * L_ + M_ - 1) / M_) + 1;
+}
+
+/* ── streaming conversion ────────────────────────────────────────────── */
+
+/* Four independent accumulators so the compiler can keep a vector
+   register per lane without needing -ffast-math to reassociate. */
+static inline float dot(const float* a, const float* b, int n)
+{
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    int k = 0;
+    for (; k + 4 <= n; k += 4) {
+        s0 += a[k]     * b[k];
+        s1 += a[k + 1] * b[k + 1];
+        s2 += a[k + 2] * b[k + 2];
+        s3 += a[k + 3] * b[k + 3];
+    }
+    for (; k < n; k++) s0 += a[k] * b[k];
+    return (s0 + s1) + (s2 + s3);
+}
+
+int Resampler::process(const float* in, int n_in, float* out, int max_out)
+{
+    if (passthrough_) {
+        int n = n_in < max_out ? n_in : max_out;
+        std::memcpy(out, in, static_cast<size_t>(n) * sizeof(float));
+        return n;
+    }
+
+    const int T = ntaps_;
+    int n_out = 0;
+
+    for (int i = 0; i < n_in; i++) {
+        /* push one input sample; window is hist_[pos_+1 .. pos_+T] */
+        pos_ = (pos_ + 1 == T) ? 0 : pos_ + 1;
+        hist_[static_cast<size_t>(pos_)]     = in[i];
+        hist_[static_cast<size_t>(pos_ + T)] = in[i];
+        const float* window = &hist_[static_cast<size_t>(pos_ + 1)];
+
+        /* every output whose upsampled position falls on this input */
+        while (phase_ < L_) {
+            if (n_out < max_out)
+                out[n_out++] = dot(&phases_[static_cast<size_t>(phase_ * T)], window, T);
+            phase_ += M_;
+        }
+        phase_ -= L_;
+    }
+
+    return n_out;
+}
+
+std::vector<float> Resampler::convert(const std::vector<float>& in,
+                                      unsigned int rate_in, unsigned int rate_out)
+{
+    Resampler rs;
+    if (!rs.init(rate_in, rate_out)) return {};
+
+    int n_in = static_cast<int>(in.size());
+    std::vector<float> out(static_cast<size_t>(rs.max_output(n_in)));
+    int n_out = rs.process(in.data(), n_in, out.data(), static_cast<int>(out.size()));
+    out.resize(static_cast<size_t>(n_out));
+    return out;
+}
+
+/* ── C interface ─────────────────────────────────────────────────────── */
+
+struct rade_resampler {
+    Resampler rs;
+};
+
+rade_resampler* rade_resampler_create(unsigned int rate_in, unsigned int rate_out)
+{
+    rade_resampler* r = new (std::nothrow) rade_resampler;
+    if (r && !r->rs.init(rate_in, rate_out)) {
+        delete r;
+        r = nullptr;
+    }
+    return r;
+}
+
+void rade_resampler_destroy(rade_resampler* rs)
+{
+    delete rs;
+}
+
+int rade_resampler_process(rade_resampler* rs, const float* in, int n_in,
+                           float* out, int max_out)
+{
+    return rs->rs.process(in, n_in, out, max_out);
+}
+
+int rade_resampler_max_output(const rade_resampler* rs, int n_in)
+{
+    return rs->rs.max_output(n_in);
+}
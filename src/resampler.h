@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+/* ── Resampler ─────────────────────────────────────────────────────────────
+ *
+ *  Streaming polyphase FIR sample rate converter for rational ratios
+ *  rate_out/rate_in = L/M (reduced by their gcd, e.g. 48k→8k is 1/6,
+ *  16k→48k is 3/1, 44.1k→8k is 80/441).
+ *
+ *  The Kaiser-windowed sinc prototype is split into L phase tables when
+ *  the ratio is set, so each output sample is a single contiguous dot
+ *  product against a double-length history buffer: integer arithmetic
+ *  only, no per-sample fractional positions, and process() performs no
+ *  heap allocation.  Equal rates are a straight copy.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+class Resampler {
+public:
+    Resampler() = default;
+
+    /* set up for rate_in → rate_out, clears the history.  Returns false if
+       either rate is zero or the reduced ratio needs too large a table. */
+    bool init(unsigned int rate_in, unsigned int rate_out);
+
+    /* clear the history without recomputing the tables */
+    void reset();
+
+    /* convert n_in samples, writing at most max_out.  Returns the number
+       of output samples written. */
+    int  process(const float* in, int n_in, float* out, int max_out);
+
+    /* upper bound on the output of process() for n_in input samples */
+    int  max_output(int n_in) const;
+
+    unsigned int rate_in()  const { return rate_in_; }
+    unsigned int rate_out() const { return rate_out_; }
+
+    /* one-shot conversion of a whole buffer (e.g. a WAV file) */
+    static std::vector<float> convert(const std::vector<float>& in,
+                                      unsigned int rate_in, unsigned int rate_out);
+
+private:
+    unsigned int rate_in_  = 0;
+    unsigned int rate_out_ = 0;
+    int          L_ = 1;          // interpolation factor
+    int          M_ = 1;          // decimation factor
+    int          ntaps_ = 0;      // taps per phase
+    bool         passthrough_ = true;
+
+    std::vector<float> phases_;   // L_ × ntaps_, each phase oldest→newest
+    std::vector<float> hist_;     // 2 × ntaps_: every sample stored twice
+    int          pos_   = 0;      // slot of the newest sample
+    int          phase_ = 0;      // next output's phase, relative to newest input
+};
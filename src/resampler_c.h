@@ -0,0 +1,30 @@
+#pragma once
+
+/* ── C interface to Resampler ──────────────────────────────────────────────
+ *
+ *  The polyphase Resampler (resampler.h) behind an opaque handle, for the
+ *  C tools.  Same semantics as the class; implemented in resampler.cpp.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct rade_resampler rade_resampler;
+
+/* rate_in → rate_out.  NULL if either rate is zero, the reduced ratio
+   needs too large a table, or out of memory */
+rade_resampler* rade_resampler_create(unsigned int rate_in, unsigned int rate_out);
+void            rade_resampler_destroy(rade_resampler* rs);
+
+/* convert n_in samples, writing at most max_out.  Returns the number of
+   output samples written. */
+int rade_resampler_process(rade_resampler* rs, const float* in, int n_in,
+                           float* out, int max_out);
+
+/* upper bound on the output of process() for n_in input samples */
+int rade_resampler_max_output(const rade_resampler* rs, int n_in);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,158 @@
+#include "rt_policy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+/* ── warnings, once per kind per process ─────────────────────────────── */
+
+static std::atomic<bool> g_warned_sched    {false};
+static std::atomic<bool> g_warned_affinity {false};
+static std::atomic<bool> g_warned_mlock    {false};
+
+static void warn_once(std::atomic<bool>& flag, const char* what, int err, const char* hint)
+{
+    if (flag.exchange(true)) return;
+    std::fprintf(stderr, "rt: %s refused (%s), carrying on without it%s%s\n",
+                 what, std::strerror(err), hint[0] ? "; " : "", hint);
+}
+
+/* ── threads ─────────────────────────────────────────────────────────── */
+
+bool rt_apply_thread(const RtPolicy& p, RtRole role, const char* name)
+{
+    pthread_t self = pthread_self();
+    bool ok = true;
+
+    /* names are 15 characters plus the NUL on Linux, macOS only names the
+       calling thread */
+    if (name) {
+        char n[16];
+        std::snprintf(n, sizeof n, "%s", name);
+#ifdef __APPLE__
+        pthread_setname_np(n);
+#else
+        pthread_setname_np(self, n);
+#endif
+    }
+
+    if (p.cpus != 0) {
+        char what[96];
+        std::snprintf(what, sizeof what, "CPU affinity %s", rt_format_cpus(p.cpus).c_str());
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c = 0; c < 64 && c < CPU_SETSIZE; c++)
+            if (p.cpus & (uint64_t(1) << c)) CPU_SET(c, &set);
+        int err = pthread_setaffinity_np(self, sizeof set, &set);
+        if (err != 0) {
+            warn_once(g_warned_affinity, what, err, "check the CPUs exist and are allowed");
+            ok = false;
+        }
+#else
+        /* no CPU sets outside Linux (macOS only has affinity hints) */
+        warn_once(g_warned_affinity, what, ENOTSUP, "only supported on Linux");
+        ok = false;
+#endif
+    }
+
+    if (p.priority > 0) {
+        int policy = p.round_robin ? SCHED_RR : SCHED_FIFO;
+        int lo = sched_get_priority_min(policy);
+        int hi = sched_get_priority_max(policy);
+        int prio = role == RT_IO ? p.priority : p.priority - 1;
+        sched_param sp {};
+        sp.sched_priority = std::min(hi, std::max(lo, prio));
+        int err = pthread_setschedparam(self, policy, &sp);
+        if (err != 0) {
+            char what[64];
+            std::snprintf(what, sizeof what, "%s priority %d",
+                          p.round_robin ? "SCHED_RR" : "SCHED_FIFO", sp.sched_priority);
+            warn_once(g_warned_sched, what, err,
+                      err == EPERM ? "needs CAP_SYS_NICE or an rtprio limit" : "");
+            ok = false;
+        }
+    }
+
+    if (p.prefault || p.lock_memory)
+        rt_prefault_stack();
+
+    return ok;
+}
+
+/* ── memory ──────────────────────────────────────────────────────────── */
+
+/* With MCL_ONFAULT pages are locked as they are first touched rather than
+   all populated up front, so the 8 MB thread stacks (ours and the GUI's)
+   only pin what they use.  The weights and our stacks are prefaulted
+   explicitly, see rade_prefault() and rt_prefault_stack() */
+bool rt_lock_memory()
+{
+#ifdef MCL_ONFAULT
+    if (mlockall(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT) == 0) return true;
+#else
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) return true;
+#endif
+    int err = errno;
+    warn_once(g_warned_mlock, "mlockall", err,
+              err == EPERM || err == ENOMEM ? "raise RLIMIT_MEMLOCK (ulimit -l, memlock in limits.conf)" : "");
+    return false;
+}
+
+/* Not inlined, so the buffer is a fresh frame below the caller's.  The
+   volatile pointer keeps the stores */
+__attribute__((noinline)) void rt_prefault_stack()
+{
+    unsigned char buf[RT_STACK_PREFAULT];
+    volatile unsigned char* p = buf;
+    for (unsigned long i = 0; i < RT_STACK_PREFAULT; i += 4096)
+        p[i] = 0;
+}
+
+/* ── CPU lists ───────────────────────────────────────────────────────── */
+
+bool rt_parse_cpus(const std::string& list, uint64_t* cpus)
+{
+    uint64_t mask = 0;
+    const char* s = list.c_str();
+
+    while (*s) {
+        char* end = nullptr;
+        long a = std::strtol(s, &end, 10);
+        if (end == s || a < 0 || a > 63) return false;
+        long b = a;
+        s = end;
+        if (*s == '-') {
+            b = std::strtol(s + 1, &end, 10);
+            if (end == s + 1 || b < a || b > 63) return false;
+            s = end;
+        }
+        for (long c = a; c <= b; c++) mask |= uint64_t(1) << c;
+        if (*s == ',') s++;
+        else if (*s) return false;
+    }
+
+    *cpus = mask;
+    return true;
+}
+
+std::string rt_format_cpus(uint64_t cpus)
+{
+    std::string out;
+    for (int c = 0; c < 64; c++) {
+        if (!(cpus & (uint64_t(1) << c))) continue;
+        int e = c;
+        while (e < 63 && (cpus & (uint64_t(1) << (e + 1)))) e++;
+        if (!out.empty()) out += ',';
+        out += std::to_string(c);
+        if (e > c) out += '-' + std::to_string(e);
+        c = e;
+    }
+    return out;
+}
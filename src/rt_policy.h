@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/* ── RtPolicy ──────────────────────────────────────────────────────────────
+ *
+ *  Scheduling and memory policy for the audio pipeline threads.  The
+ *  default is what a plain std::thread gets: normal priority on any CPU,
+ *  nothing locked.  RadaeDecoder and RadaeEncoder take one with
+ *  set_rt_policy() before open().
+ *
+ *  With priority set the capture and playback threads run SCHED_FIFO (or
+ *  SCHED_RR) at that priority, and the DSP, feature and synthesis threads
+ *  one below, so a long modem frame can't hold off the sound card.  This
+ *  needs CAP_SYS_NICE or an rtprio limit (e.g. "@audio - rtprio 95" in
+ *  /etc/security/limits.conf); without it the thread keeps normal
+ *  scheduling, a warning is printed once, and rt_denied() is set.  The
+ *  same goes for mlockall() and RLIMIT_MEMLOCK.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+struct RtPolicy {
+    int      priority    = 0;      // SCHED_FIFO priority of the I/O threads, 1..99, 0 = off
+    bool     round_robin = false;  // SCHED_RR rather than SCHED_FIFO
+    uint64_t cpus        = 0;      // affinity mask, bit n = CPU n, 0 = any CPU (Linux only)
+    bool     lock_memory = false;  // mlockall() at open(), weights and stacks stay resident
+    bool     prefault    = false;  // touch weight pages at open() and each thread's stack at start
+
+    bool is_default() const { return priority == 0 && cpus == 0 && !lock_memory && !prefault; }
+};
+
+enum RtRole {
+    RT_IO,                         // capture / playback: policy priority
+    RT_DSP,                        // modem, features, vocoder: one below
+};
+
+/* Apply policy to the calling thread and name it (15 chars max, shown by
+   top -H and in debuggers).  Returns false if any part was refused */
+bool rt_apply_thread(const RtPolicy& p, RtRole role, const char* name);
+
+/* mlockall(MCL_CURRENT | MCL_FUTURE), false if refused.  Every later
+   mapping counts against RLIMIT_MEMLOCK, so new threads can fail to start
+   unless it is unlimited ("@audio - memlock unlimited") or the process
+   has CAP_IPC_LOCK */
+bool rt_lock_memory();
+
+/* Touch the next RT_STACK_PREFAULT bytes of the calling thread's stack */
+constexpr unsigned long RT_STACK_PREFAULT = 256 * 1024;
+void rt_prefault_stack();
+
+/* "2,3" or "0-3,6" to a mask in cpus; "" is any CPU.  False on a bad
+   list or a CPU above 63 */
+bool        rt_parse_cpus(const std::string& list, uint64_t* cpus);
+std::string rt_format_cpus(uint64_t cpus);
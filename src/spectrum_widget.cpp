@@ -175,9 +175,13 @@ void spectrum_widget_update(GtkWidget* widget, const float* mag_dB, int n_bins,
     if (!st) return;
 
     if (mag_dB && n_bins > 0) {
+        if (sample_rate == st->sample_rate &&
+            std::equal(mag_dB, mag_dB + n_bins, st->bins.begin(), st->bins.end()))
+            return;
         st->bins.assign(mag_dB, mag_dB + n_bins);
         st->sample_rate = sample_rate;
     } else {
+        if (st->bins.empty()) return;
         st->bins.clear();
     }
 
@@ -6,6 +6,7 @@
  *   - mag_dB[] contains n_bins values in dB (0 dB = full-scale).
  *   - sample_rate is used for the frequency-axis labels.
  *   - Passing nullptr or n_bins==0 clears the display.
+ *   - Pushing the same data again doesn't redraw.
  */
 GtkWidget* spectrum_widget_new(void);
 void       spectrum_widget_update(GtkWidget* widget, const float* mag_dB, int n_bins,
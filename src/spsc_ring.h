@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+/* ── SpscRing ──────────────────────────────────────────────────────────────
+ *
+ *  Lock-free single-producer / single-consumer ring buffer of samples.
+ *  Used to decouple the audio capture, DSP and playback threads so a slow
+ *  modem frame never blocks the sound card.
+ *
+ *  Exactly one thread may call write() and exactly one other thread may
+ *  call read().  size()/space() may be called from any thread and are a
+ *  snapshot, always within [0, capacity].  reset() is not thread-safe;
+ *  call it before the threads start.  Capacity is rounded up to a power
+ *  of two.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+template <typename T>
+class SpscRing {
+public:
+    SpscRing() = default;
+
+    SpscRing(const SpscRing&)            = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    void reset(size_t min_capacity)
+    {
+        size_t cap = 1;
+        while (cap < min_capacity) cap <<= 1;
+        buf_.assign(cap, T{});
+        mask_ = cap - 1;
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+    /* producer: copy up to n samples in, returns number written */
+    size_t write(const T* src, size_t n)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t free_n = buf_.size() - (head - tail);
+        if (n > free_n) n = free_n;
+        if (n == 0) return 0;
+
+        size_t pos   = head & mask_;
+        size_t first = std::min(n, buf_.size() - pos);
+        std::memcpy(&buf_[pos], src, first * sizeof(T));
+        std::memcpy(&buf_[0], src + first, (n - first) * sizeof(T));
+
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    /* consumer: copy up to n samples out, returns number read */
+    size_t read(T* dst, size_t n)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t avail = head - tail;
+        if (n > avail) n = avail;
+        if (n == 0) return 0;
+
+        size_t pos   = tail & mask_;
+        size_t first = std::min(n, buf_.size() - pos);
+        std::memcpy(dst, &buf_[pos], first * sizeof(T));
+        std::memcpy(dst + first, &buf_[0], (n - first) * sizeof(T));
+
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    /* tail first: head only moves forward, so head - tail can't go
+       negative, but from a third thread both may move between the loads
+       and the difference run past capacity, hence the clamp */
+    size_t size() const
+    {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return std::min(head - tail, buf_.size());
+    }
+    size_t space()    const { return buf_.size() - size(); }
+    size_t capacity() const { return buf_.size(); }
+
+    /* fill level 0..1, for status displays */
+    float fill() const
+    {
+        return buf_.empty() ? 0.0f
+                            : static_cast<float>(size()) / static_cast<float>(buf_.size());
+    }
+
+private:
+    std::vector<T> buf_;
+    size_t         mask_ = 0;
+
+    /* producer and consumer indices on separate cache lines */
+    alignas(64) std::atomic<size_t> head_ {0};   // total samples written
+    alignas(64) std::atomic<size_t> tail_ {0};   // total samples read
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+extern "C" {
+#include "rade_api.h"
+}
+
+/* ── SnapshotBuffer ────────────────────────────────────────────────────────
+ *
+ *  Single-writer, many-reader snapshot of a trivially copyable struct.
+ *  The writer (a real-time DSP thread) publishes with publish() and never
+ *  waits; any number of other threads read() the latest complete copy and
+ *  never block the writer.
+ *
+ *  Three slots, each with a sequence count that is odd while the slot is
+ *  being written.  The writer always fills the slot after the current one,
+ *  so a reader copying the latest slot only has to retry if the writer
+ *  laps it twice mid-copy, which at one publish per modem frame doesn't
+ *  happen in practice.
+ * ──────────────────────────────────────────────────────────────────────── */
+
+template <typename T>
+class SnapshotBuffer {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SnapshotBuffer needs a trivially copyable type");
+public:
+    SnapshotBuffer() = default;
+
+    SnapshotBuffer(const SnapshotBuffer&)            = delete;
+    SnapshotBuffer& operator=(const SnapshotBuffer&) = delete;
+
+    /* writer: one thread at a time */
+    void publish(const T& v)
+    {
+        unsigned next = (latest_.load(std::memory_order_relaxed) + 1) % N_SLOTS;
+        Slot& s = slots_[next];
+
+        uint32_t seq = s.seq.load(std::memory_order_relaxed);
+        s.seq.store(seq + 1, std::memory_order_relaxed);      // odd: writing
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&s.data, &v, sizeof(T));
+        s.seq.store(seq + 2, std::memory_order_release);      // even: done
+
+        latest_.store(next, std::memory_order_release);
+    }
+
+    /* readers: any thread, a value-initialised T until the first publish */
+    void read(T& out) const
+    {
+        for (;;) {
+            const Slot& s = slots_[latest_.load(std::memory_order_acquire)];
+            uint32_t seq0 = s.seq.load(std::memory_order_acquire);
+            if (seq0 & 1) continue;
+            std::memcpy(&out, &s.data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) == seq0) return;
+        }
+    }
+
+    T read() const
+    {
+        T out;
+        read(out);
+        return out;
+    }
+
+private:
+    static constexpr unsigned N_SLOTS = 3;
+
+    struct Slot {
+        alignas(64) std::atomic<uint32_t> seq {0};
+        T data {};
+    };
+    Slot                  slots_[N_SLOTS];
+    std::atomic<unsigned> latest_ {0};
+};
+
+/* ── Telemetry ─────────────────────────────────────────────────────────────
+ *
+ *  Everything a display or exporter wants from a running pipeline, as one
+ *  consistent snapshot published by the DSP thread once per modem frame
+ *  (RadaeDecoder::telemetry(), RadaeEncoder::telemetry()).
+ * ──────────────────────────────────────────────────────────────────────── */
+
+struct Telemetry {
+    static constexpr int SPECTRUM_BINS = 256;
+    static constexpr int MAX_STAGES    = 16;
+    static constexpr int CALLSIGN_MAX  = 16;
+
+    uint64_t frame        = 0;        // modem frames processed since start()
+    bool     synced       = false;    // RX only
+    float    snr_dB       = 0.0f;     // RX, last estimate while in sync
+    float    freq_offset  = 0.0f;     // RX, Hz
+    float    input_level  = 0.0f;     // RMS, 0..1
+    float    output_level = 0.0f;     // RMS, 0..1
+
+    float    spectrum[SPECTRUM_BINS] = {};   // dB, 0..4 kHz
+    uint64_t spectrum_frame = 0;             // frame it was computed at, lags frame when shedding
+    char     callsign[CALLSIGN_MAX]  = {};   // RX: last EOO callsign, NUL terminated
+
+    int              n_stages = 0;           // as the pipeline's n_stages()
+    rade_stage_stats stages[MAX_STAGES] = {};
+
+    /* counters since start(), for exporters */
+    uint64_t audio_ns           = 0;  // modem audio the DSP thread has processed
+    uint64_t busy_ns            = 0;  // DSP thread time spent on it, busy/audio = real-time factor
+    uint32_t capture_overruns   = 0;
+    uint32_t playback_underruns = 0;
+
+    uint32_t syncs         = 0;       // RX: times sync was gained
+    float    first_sync_s  = -1.0f;   // RX: audio seconds from start() to first sync, <0 until then
+    uint32_t eoo_frames    = 0;       // RX: EOO frames received
+    uint32_t eoo_callsigns = 0;       // RX: ... of which the callsign decoded
+
+    rade_resync_stats resync  = {};   // RX: as RadaeDecoder::resync_stats()
+    rade_stage_stats  latency = {};   // RX: as RadaeDecoder::latency_stats()
+
+    int      shed_level   = 0;        // RX: LoadGovernor level, 0 = nothing shed
+    uint32_t shed_changes = 0;        // RX: times it changed
+    float    dsp_load     = 0.0f;     // RX: smoothed DSP time over audio time, as the governor sees it
+};
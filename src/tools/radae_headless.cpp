@@ -42,10 +42,14 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <vector>
 
 #include "rade_decoder.h"
 #include "rade_encoder.h"
 #include "audio_input.h"
+#include "metrics_exporter.h"
+#include "rade_trace.h"
 
 /* ── Configuration structure ──────────────────────────────────────────── */
 
@@ -55,6 +59,14 @@ struct Config {
     std::string frommic;
     std::string tospeaker;
     std::string call;
+    AudioTuning audio;       /* period=, periods=, avail_min=, mmap= */
+    RtPolicy    rt;          /* rt_priority=, rt_rr=, cpus=, mlock=, prefault= */
+    std::string metrics;     /* [ADDR:]PORT for Prometheus */
+    std::string statsd;      /* HOST:PORT */
+    int         statsd_interval = 10;   /* seconds */
+    std::string feature_send;    /* HOST:PORT, RX: send features to a remote vocoder */
+    std::string feature_listen;  /* [ADDR:]PORT, RX: be that remote vocoder */
+    std::string feature_format = "f32";
 };
 
 /* ── Global flag for signal handling ──────────────────────────────────── */
@@ -83,6 +95,10 @@ bool write_config_file(const char* filename, const Config& config) {
     return true;
 }
 
+static bool config_bool(const std::string& value) {
+    return value == "1" || value == "yes" || value == "true";
+}
+
 bool parse_config_file(const char* filename, Config& config) {
     std::ifstream file(filename);
     if (!file.is_open()) {
@@ -123,6 +139,38 @@ bool parse_config_file(const char* filename, Config& config) {
             config.tospeaker = value;
         } else if (key == "call") {
             config.call = value;
+        } else if (key == "period") {
+            config.audio.period_frames = strtoul(value.c_str(), NULL, 10);
+        } else if (key == "periods") {
+            config.audio.periods = static_cast<unsigned int>(strtoul(value.c_str(), NULL, 10));
+        } else if (key == "avail_min") {
+            config.audio.avail_min = strtoul(value.c_str(), NULL, 10);
+        } else if (key == "mmap") {
+            config.audio.mmap = config_bool(value);
+        } else if (key == "rt_priority") {
+            config.rt.priority = atoi(value.c_str());
+        } else if (key == "rt_rr") {
+            config.rt.round_robin = config_bool(value);
+        } else if (key == "cpus") {
+            if (!rt_parse_cpus(value, &config.rt.cpus))
+                fprintf(stderr, "Warning: bad cpus list '%s' in %s, ignored\n",
+                        value.c_str(), filename);
+        } else if (key == "mlock") {
+            config.rt.lock_memory = config_bool(value);
+        } else if (key == "prefault") {
+            config.rt.prefault = config_bool(value);
+        } else if (key == "metrics") {
+            config.metrics = value;
+        } else if (key == "statsd") {
+            config.statsd = value;
+        } else if (key == "statsd_interval") {
+            config.statsd_interval = atoi(value.c_str());
+        } else if (key == "feature_send") {
+            config.feature_send = value;
+        } else if (key == "feature_listen") {
+            config.feature_listen = value;
+        } else if (key == "feature_format") {
+            config.feature_format = value;
         }
     }
 
@@ -156,6 +204,68 @@ void list_devices(void) {
     fprintf(stderr, "\n");
 }
 
+/* ── Stage timing table ────────────────────────────────────────────────── */
+
+/* Works for RadaeDecoder and RadaeEncoder, which share the stage getters */
+template <typename Pipeline>
+static void print_stage_stats(const Pipeline& p) {
+    fprintf(stderr, "\n%-14s %8s %9s %9s %9s %9s\n",
+            "stage", "count", "p50 us", "p99 us", "max us", "mean us");
+    for (int i = 0; i < p.n_stages(); i++) {
+        rade_stage_stats st;
+        if (!p.stage_stats(i, &st) || st.count == 0) continue;
+        fprintf(stderr, "%-14s %8u %9.1f %9.1f %9.1f %9.1f\n",
+                p.stage_name(i), st.count, st.p50_us, st.p99_us, st.max_us, st.mean_us);
+    }
+}
+
+static void print_rx_stats(const RadaeDecoder& d) {
+    rade_stage_stats lat;
+    if (d.latency_stats(&lat))
+        fprintf(stderr, "rx latency: p50 %.1f ms  p99 %.1f ms  max %.1f ms\n",
+                lat.p50_us * 1e-3f, lat.p99_us * 1e-3f, lat.max_us * 1e-3f);
+    fprintf(stderr, "device delay: in %.1f ms  out %.1f ms  (period %lu / %lu frames)\n",
+            d.input_delay_ms(), d.output_delay_ms(), d.input_period(), d.output_period());
+
+    rade_resync_stats st;
+    if (!d.resync_stats(&st) || st.count == 0) return;
+    fprintf(stderr, "resync after fade: %u (%u warm)  last %.2f s  mean %.2f s  max %.2f s\n",
+            st.count, st.warm, st.last_s, st.mean_s, st.max_s);
+}
+
+/* ── Metrics ───────────────────────────────────────────────────────────── */
+
+/* Exporter for a started pipeline as configured by metrics= and statsd=,
+   or none.  Endpoints that can't be set up are reported and skipped */
+template <typename Pipeline>
+static std::unique_ptr<MetricsExporter> start_metrics(const Config& config, const char* mode,
+                                                      const Pipeline& p) {
+    if (config.metrics.empty() && config.statsd.empty()) return nullptr;
+
+    std::vector<std::string> names;
+    for (int i = 0; i < p.n_stages(); i++) names.push_back(p.stage_name(i));
+    std::unique_ptr<MetricsExporter> m(
+        new MetricsExporter(mode, [&p] { return p.telemetry(); }, names));
+
+    std::string addr;
+    int port = 0;
+    if (!config.metrics.empty()) {
+        if (!metrics_parse_endpoint(config.metrics, "", &addr, &port))
+            fprintf(stderr, "Warning: bad metrics endpoint '%s'\n", config.metrics.c_str());
+        else if (m->listen_http(addr, port))
+            fprintf(stderr, "Metrics: http://%s:%d/metrics\n", addr.empty() ? "*" : addr.c_str(), port);
+    }
+    if (!config.statsd.empty()) {
+        if (!metrics_parse_endpoint(config.statsd, "127.0.0.1", &addr, &port))
+            fprintf(stderr, "Warning: bad statsd endpoint '%s'\n", config.statsd.c_str());
+        else if (m->push_statsd(addr, port, config.statsd_interval * 1000))
+            fprintf(stderr, "Metrics: statsd %s:%d every %d s\n", addr.c_str(), port,
+                    config.statsd_interval);
+    }
+    m->start();
+    return m;
+}
+
 /* ── Usage information ─────────────────────────────────────────────────── */
 
 void usage(void) {
@@ -164,11 +274,39 @@ void usage(void) {
     fprintf(stderr, "  -d, --devices               List available audio devices and exit\n");
     fprintf(stderr, "  -c FILE                     Config file (default: radae_headless.conf)\n");
     fprintf(stderr, "  -t                          Transmit mode (default: receive mode)\n");
-    fprintf(stderr, "  --fromradio DEVICE    Audio device for radio input\n");
+    fprintf(stderr, "  --fromradio DEVICE    Audio device for radio input (shm:NAME for a\n");
+    fprintf(stderr, "                              shared memory ring)\n");
     fprintf(stderr, "  --toradio DEVICE      Audio device for radio output\n");
     fprintf(stderr, "  --frommic DEVICE     Audio device for microphone input\n");
-    fprintf(stderr, "  --tospeaker DEVICE         Audio device for speaker output\n");
+    fprintf(stderr, "  --tospeaker DEVICE         Audio device for speaker output (shm:NAME)\n");
     fprintf(stderr, "  --call CALLSIGN             Callsign (e.g., VK3TPM)\n");
+    fprintf(stderr, "  --stats SECS                Print per-stage timing every SECS seconds\n");
+    fprintf(stderr, "                              and on exit (0 = on exit only)\n");
+    fprintf(stderr, "  --low-latency               RX: start playback early and resume FARGAN\n");
+    fprintf(stderr, "                              after short sync drops\n");
+    fprintf(stderr, "  --tx-pipeline               TX: extract features on their own thread and\n");
+    fprintf(stderr, "                              encode each 40 ms stride as it arrives\n");
+    fprintf(stderr, "  --model FILE                Weights blob from rade_weights_dump\n");
+    fprintf(stderr, "                              (default: built-in weights)\n");
+    fprintf(stderr, "  --rt-priority N             SCHED_FIFO priority for the audio threads\n");
+    fprintf(stderr, "                              (DSP threads one below, 0 = normal)\n");
+    fprintf(stderr, "  --cpus LIST                 Pin the pipeline threads, e.g. 2,3 or 2-3\n");
+    fprintf(stderr, "  --mlock                     Lock memory and prefault weights and stacks\n");
+    fprintf(stderr, "  --metrics [ADDR:]PORT       Serve Prometheus metrics at /metrics\n");
+    fprintf(stderr, "  --statsd HOST:PORT          Push metrics to statsd over UDP\n");
+    fprintf(stderr, "  --iq-capture FILE           RX: record the modem input for rade_iq_replay\n");
+    fprintf(stderr, "  --no-load-shed              RX: never cut back spectrum, acquisition or\n");
+    fprintf(stderr, "                              display work when the CPU can't keep up\n");
+    fprintf(stderr, "  --acq-threads N             RX: split the pilot search across N threads\n");
+    fprintf(stderr, "                              for a faster lock (default 1)\n");
+    fprintf(stderr, "  --warm-reacquire SECONDS    RX: after a fade, also search near the last\n");
+    fprintf(stderr, "                              timing and frequency (5 is a good start)\n");
+    fprintf(stderr, "  --trace FILE                Write a Chrome trace of the pipeline stages to\n");
+    fprintf(stderr, "                              FILE on exit (open in ui.perfetto.dev)\n");
+    fprintf(stderr, "  --feature-send HOST:PORT    RX: send decoded features to a remote vocoder,\n");
+    fprintf(stderr, "                              --tospeaker optional\n");
+    fprintf(stderr, "  --feature-listen [ADDR:]PORT  RX: be the remote vocoder, needs only --tospeaker\n");
+    fprintf(stderr, "  --feature-format f32|q8     Feature stream encoding (default f32)\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Headless RADAE transceiver:\n");
     fprintf(stderr, "  RX mode: reads audio from --fromradio, decodes, plays to --tospeaker\n");
@@ -185,6 +323,10 @@ int main(int argc, char *argv[]) {
     int opt;
     const char* config_file = "radae_headless.conf";
     bool transmit_mode = false;
+    int stats_secs = -1;   /* -1: no stage timing output */
+    bool low_latency = false;
+    bool tx_pipeline = false;
+    std::string model_file;
     Config config;
     Config overrides;
 
@@ -194,6 +336,16 @@ int main(int argc, char *argv[]) {
     bool override_frommic = false;
     bool override_tospeaker = false;
     bool override_call = false;
+    int  rt_priority = -1;          /* -1: from the config file */
+    std::string rt_cpus;
+    bool rt_mlock = false;
+    std::string metrics, statsd;
+    std::string iq_capture;
+    std::string trace_path;
+    bool load_shed = true;
+    int acq_threads = 1;
+    float warm_s = 0.0f;
+    std::string feature_send, feature_listen, feature_format;
 
     static struct option long_options[] = {
         {"help",            no_argument,       NULL, 'h'},
@@ -203,6 +355,23 @@ int main(int argc, char *argv[]) {
         {"frommic",  required_argument, NULL, 'm'},
         {"tospeaker",      required_argument, NULL, 's'},
         {"call",            required_argument, NULL, 'a'},
+        {"stats",           required_argument, NULL, 'S'},
+        {"low-latency",     no_argument,       NULL, 'L'},
+        {"tx-pipeline",     no_argument,       NULL, 'P'},
+        {"model",           required_argument, NULL, 'M'},
+        {"rt-priority",     required_argument, NULL, 'R'},
+        {"cpus",            required_argument, NULL, 'C'},
+        {"mlock",           no_argument,       NULL, 'K'},
+        {"metrics",         required_argument, NULL, 'E'},
+        {"statsd",          required_argument, NULL, 'D'},
+        {"iq-capture",      required_argument, NULL, 'Q'},
+        {"trace",           required_argument, NULL, 'T'},
+        {"no-load-shed",    no_argument,       NULL, 'O'},
+        {"acq-threads",     required_argument, NULL, 'J'},
+        {"warm-reacquire",  required_argument, NULL, 'W'},
+        {"feature-send",    required_argument, NULL, 'F'},
+        {"feature-listen",  required_argument, NULL, 'N'},
+        {"feature-format",  required_argument, NULL, 'G'},
         {NULL,              0,                 NULL, 0}
     };
 
@@ -242,6 +411,59 @@ int main(int argc, char *argv[]) {
             overrides.call = optarg;
             override_call = true;
             break;
+        case 'S':
+            stats_secs = atoi(optarg);
+            if (stats_secs < 0) stats_secs = 0;
+            break;
+        case 'L':
+            low_latency = true;
+            break;
+        case 'P':
+            tx_pipeline = true;
+            break;
+        case 'M':
+            model_file = optarg;
+            break;
+        case 'R':
+            rt_priority = atoi(optarg);
+            if (rt_priority < 0) rt_priority = 0;
+            break;
+        case 'C':
+            rt_cpus = optarg;
+            break;
+        case 'K':
+            rt_mlock = true;
+            break;
+        case 'E':
+            metrics = optarg;
+            break;
+        case 'D':
+            statsd = optarg;
+            break;
+        case 'Q':
+            iq_capture = optarg;
+            break;
+        case 'T':
+            trace_path = optarg;
+            break;
+        case 'O':
+            load_shed = false;
+            break;
+        case 'J':
+            acq_threads = atoi(optarg);
+            break;
+        case 'W':
+            warm_s = (float)atof(optarg);
+            break;
+        case 'F':
+            feature_send = optarg;
+            break;
+        case 'N':
+            feature_listen = optarg;
+            break;
+        case 'G':
+            feature_format = optarg;
+            break;
         default:
             usage();
             return 1;
@@ -278,6 +500,42 @@ int main(int argc, char *argv[]) {
     if (override_frommic) config.frommic = overrides.frommic;
     if (override_tospeaker) config.tospeaker = overrides.tospeaker;
     if (override_call) config.call = overrides.call;
+    if (rt_priority >= 0) config.rt.priority = rt_priority;
+    if (!rt_cpus.empty() && !rt_parse_cpus(rt_cpus, &config.rt.cpus)) {
+        fprintf(stderr, "Error: bad --cpus list '%s'\n", rt_cpus.c_str());
+        return 1;
+    }
+    if (rt_mlock) config.rt.lock_memory = true;
+    if (!metrics.empty()) config.metrics = metrics;
+    if (!statsd.empty()) config.statsd = statsd;
+    if (!feature_send.empty()) config.feature_send = feature_send;
+    if (!feature_listen.empty()) config.feature_listen = feature_listen;
+    if (!feature_format.empty()) config.feature_format = feature_format;
+
+    /* Feature stream endpoints */
+    bool format_ok = false;
+    FeatEncoding feature_enc = featstream_parse_encoding(config.feature_format, &format_ok);
+    std::string send_host, listen_addr;
+    int send_port = 0, listen_port = 0;
+    if (!format_ok) {
+        fprintf(stderr, "Error: feature format must be f32 or q8, not '%s'\n",
+                config.feature_format.c_str());
+        return 1;
+    }
+    if (!config.feature_send.empty() &&
+        !metrics_parse_endpoint(config.feature_send, "", &send_host, &send_port)) {
+        fprintf(stderr, "Error: bad feature send endpoint '%s'\n", config.feature_send.c_str());
+        return 1;
+    }
+    if (!config.feature_listen.empty() &&
+        !metrics_parse_endpoint(config.feature_listen, "", &listen_addr, &listen_port)) {
+        fprintf(stderr, "Error: bad feature listen endpoint '%s'\n", config.feature_listen.c_str());
+        return 1;
+    }
+    if (send_port && send_host.empty()) {
+        fprintf(stderr, "Error: --feature-send needs HOST:PORT\n");
+        return 1;
+    }
 
     /* Validate configuration based on mode */
     if (transmit_mode) {
@@ -289,20 +547,42 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "Starting in TRANSMIT mode\n");
         fprintf(stderr, "  Microphone: %s\n", config.frommic.c_str());
         fprintf(stderr, "  Radio out:  %s\n", config.toradio.c_str());
+    } else if (listen_port) {
+        if (config.tospeaker.empty()) {
+            fprintf(stderr, "Error: --feature-listen requires --tospeaker\n");
+            usage();
+            return 1;
+        }
+        fprintf(stderr, "Starting in RECEIVE mode, vocoder for a remote demod\n");
+        fprintf(stderr, "  Features:  udp %s:%d\n", listen_addr.empty() ? "*" : listen_addr.c_str(),
+                listen_port);
+        fprintf(stderr, "  Speakers:  %s\n", config.tospeaker.c_str());
     } else {
-        if (config.fromradio.empty() || config.tospeaker.empty()) {
+        if (config.fromradio.empty() || (config.tospeaker.empty() && !send_port)) {
             fprintf(stderr, "Error: RX mode requires --fromradio and --tospeaker\n");
             usage();
             return 1;
         }
         fprintf(stderr, "Starting in RECEIVE mode\n");
         fprintf(stderr, "  Radio in:  %s\n", config.fromradio.c_str());
-        fprintf(stderr, "  Speakers:  %s\n", config.tospeaker.c_str());
+        fprintf(stderr, "  Speakers:  %s\n", config.tospeaker.empty() ? "none" : config.tospeaker.c_str());
+        if (send_port)
+            fprintf(stderr, "  Features:  udp %s:%d, %s\n", send_host.c_str(), send_port,
+                    featstream_encoding_name(feature_enc));
     }
 
     if (!config.call.empty()) {
         fprintf(stderr, "  Call:      %s\n", config.call.c_str());
     }
+    if (!config.rt.is_default()) {
+        std::string cpus = config.rt.cpus ? rt_format_cpus(config.rt.cpus) : "any";
+        char sched[32] = "normal priority";
+        if (config.rt.priority > 0)
+            snprintf(sched, sizeof sched, "%s %d",
+                     config.rt.round_robin ? "SCHED_RR" : "SCHED_FIFO", config.rt.priority);
+        fprintf(stderr, "  Threads:   %s  cpus %s%s%s\n", sched, cpus.c_str(), config.rt.lock_memory ? "  mlock" : "",
+                config.rt.prefault ? "  prefault" : "");
+    }
 
     /* Set up signal handler for graceful shutdown */
     signal(SIGINT, signal_handler);
@@ -310,10 +590,16 @@ int main(int argc, char *argv[]) {
 
     /* Initialize RADE */
     rade_initialize();
+    if (!trace_path.empty())
+        rade_trace_start(0);
 
     if (transmit_mode) {
         /* ── Transmit mode ─────────────────────────────────────────────── */
         RadaeEncoder encoder;
+        encoder.set_model_file(model_file);
+        encoder.set_tx_pipeline(tx_pipeline);
+        encoder.set_audio_tuning(config.audio);
+        encoder.set_rt_policy(config.rt);
 
         fprintf(stderr, "Opening audio devices...\n");
         if (!encoder.open(config.frommic, config.toradio)) {
@@ -324,39 +610,71 @@ int main(int argc, char *argv[]) {
 
         fprintf(stderr, "Starting encoder...\n");
         encoder.start();
+        auto metrics = start_metrics(config, "tx", encoder);
 
         fprintf(stderr, "Running... Press Ctrl+C to stop\n");
+        int secs = 0;
         while (g_running && encoder.is_running()) {
             sleep(1);
             /* Could print status here if desired */
             float input_level = encoder.get_input_level();
             float output_level = encoder.get_output_level();
             fprintf(stderr, "\rInput: %.2f  Output: %.2f  ", input_level, output_level);
+            if (stats_secs > 0 && ++secs % stats_secs == 0)
+                print_stage_stats(encoder);
             fflush(stderr);
         }
         fprintf(stderr, "\n");
 
         fprintf(stderr, "Stopping encoder...\n");
+        if (metrics) metrics->stop();
         encoder.stop();
+        if (stats_secs >= 0)
+            print_stage_stats(encoder);
         encoder.close();
 
     } else {
         /* ── Receive mode ──────────────────────────────────────────────── */
         RadaeDecoder decoder;
+        decoder.set_model_file(model_file);
+        decoder.set_audio_tuning(config.audio);
+        decoder.set_rt_policy(config.rt);
+        if (send_port)
+            decoder.set_feature_sink(send_host, send_port, feature_enc);
 
         fprintf(stderr, "Opening audio devices...\n");
-        if (!decoder.open(config.fromradio, config.tospeaker)) {
+        bool opened = listen_port ? decoder.open_remote(listen_addr, listen_port, config.tospeaker)
+                                  : decoder.open(config.fromradio, config.tospeaker);
+        if (!opened) {
             fprintf(stderr, "Error: Failed to open decoder devices\n");
             rade_finalize();
             return 1;
         }
 
         fprintf(stderr, "Starting decoder...\n");
+        decoder.set_low_latency(low_latency);
+        decoder.set_iq_capture(iq_capture);
+        decoder.set_load_shedding(load_shed);
+        decoder.set_acq_threads(acq_threads);
+        decoder.set_warm_reacquire(warm_s);
+        if (decoder.acq_threads() > 1)
+            fprintf(stderr, "Acquisition on %d threads\n", decoder.acq_threads());
         decoder.start();
+        auto metrics = start_metrics(config, "rx", decoder);
 
         fprintf(stderr, "Running... Press Ctrl+C to stop\n");
+        int secs = 0;
+        int shed_level = 0;
         while (g_running && decoder.is_running()) {
             sleep(1);
+            /* Report load shedding as it steps up or down */
+            Telemetry tel = decoder.telemetry();
+            if (tel.shed_level != shed_level) {
+                fprintf(stderr, "\nLoad shedding: level %d (%s), DSP load %.2f\n",
+                        tel.shed_level, LoadGovernor::level_name(tel.shed_level), tel.dsp_load);
+                shed_level = tel.shed_level;
+            }
+
             /* Print status */
             bool synced = decoder.is_synced();
             float snr = decoder.snr_dB();
@@ -366,15 +684,40 @@ int main(int argc, char *argv[]) {
 
             fprintf(stderr, "\r%s SNR: %.1f dB  Freq: %+.1f Hz  In: %.2f  Out: %.2f  ",
                     synced ? "SYNC" : "----", snr, freq_offset, input_level, output_level);
+            if (stats_secs > 0 && ++secs % stats_secs == 0) {
+                print_stage_stats(decoder);
+                print_rx_stats(decoder);
+            }
             fflush(stderr);
         }
         fprintf(stderr, "\n");
 
         fprintf(stderr, "Stopping decoder...\n");
+        if (metrics) metrics->stop();
         decoder.stop();
+        if (stats_secs >= 0) {
+            print_stage_stats(decoder);
+            print_rx_stats(decoder);
+        }
+        if (send_port || listen_port)
+            fprintf(stderr, "Feature packets: %llu %s, %llu %s\n",
+                    (unsigned long long)decoder.feature_packets(), listen_port ? "received" : "sent",
+                    (unsigned long long)decoder.feature_lost(), listen_port ? "lost" : "dropped");
+        if (!iq_capture.empty())
+            fprintf(stderr, "IQ capture: %llu frames to %s\n",
+                    (unsigned long long)decoder.iq_frames(), iq_capture.c_str());
         decoder.close();
     }
 
+    if (!trace_path.empty()) {
+        rade_trace_stop();
+        long n = rade_trace_write(trace_path.c_str());
+        if (n < 0)
+            fprintf(stderr, "Error: can't write trace %s\n", trace_path.c_str());
+        else
+            fprintf(stderr, "Trace: %ld events to %s\n", n, trace_path.c_str());
+    }
+
     /* Cleanup */
     rade_finalize();
     audio_terminate();
@@ -45,7 +45,7 @@
 void usage(void) {
     fprintf(stderr, "usage: radae_rx [options]\n");
     fprintf(stderr, "  -h, --help              Show this help\n");
-    fprintf(stderr, "  --model_name FILE       Path to model (ignored, uses built-in weights)\n");
+    fprintf(stderr, "  --model_name FILE       Weights blob (default built-in weights)\n");
     fprintf(stderr, "  -v LEVEL                Verbosity level (0, 1, or 2)\n");
     fprintf(stderr, "  --disable_unsync SECS   Test mode: disable unsync after SECS seconds (default 0 = disabled)\n");
     fprintf(stderr, "\n");
@@ -57,7 +57,7 @@ void usage(void) {
 
 int main(int argc, char *argv[]) {
     int opt;
-    char *model_name = "model19_check3/checkpoints/checkpoint_epoch_100.pth";
+    char *model_name = NULL;
     int flags = 0;
     float disable_unsync = 0.0f;
 
@@ -93,7 +93,7 @@ int main(int argc, char *argv[]) {
     /* Initialize RADE */
     rade_initialize();
 
-    struct rade *r = rade_open(model_name, flags);
+    struct rade *r = rade_open_rx_only(model_name, flags);
     if (r == NULL) {
         fprintf(stderr, "Failed to open RADE\n");
         return 1;
@@ -46,7 +46,7 @@
 void usage(void) {
     fprintf(stderr, "usage: radae_tx [options]\n");
     fprintf(stderr, "  -h, --help           Show this help\n");
-    fprintf(stderr, "  --model_name FILE    Path to model (ignored, uses built-in weights)\n");
+    fprintf(stderr, "  --model_name FILE    Weights blob (default built-in weights)\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Reads vocoder features from stdin, writes IQ samples to stdout.\n");
     fprintf(stderr, "Features format: float32, %d values per modem frame\n",
@@ -57,7 +57,7 @@ void usage(void) {
 
 int main(int argc, char *argv[]) {
     int opt;
-    char *model_name = "model19_check3/checkpoints/checkpoint_epoch_100.pth";
+    char *model_name = NULL;
 
     static struct option long_options[] = {
         {"help",       no_argument,       NULL, 'h'},
@@ -82,7 +82,7 @@ int main(int argc, char *argv[]) {
     /* Initialize RADE */
     rade_initialize();
 
-    struct rade *r = rade_open(model_name, 0);
+    struct rade *r = rade_open_tx_only(model_name, 0);
     if (r == NULL) {
         fprintf(stderr, "Failed to open RADE\n");
         return 1;
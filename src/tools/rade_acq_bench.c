@@ -0,0 +1,310 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_acq_bench.c
+
+  Benchmarks the coarse pilot acquisition engines (direct correlation vs
+  FFT cross-correlation) on synthetic signals, and checks that both make
+  the same detection decision.  Then compares the default +/- 50 Hz
+  search with the wide range search (rade_acq_set_range()) on signals
+  further off frequency, and times each engine split across threads
+  (rade_acq_set_threads()), checking the results are bit identical.
+
+  usage: rade_acq_bench [-n iterations] [-t trials] [-f range_Hz] [-j threads]
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "rade_dsp.h"
+#include "rade_ofdm.h"
+#include "rade_acq.h"
+
+#define BUF_SIZE (2 * RADE_NMF + RADE_M + RADE_NCP)
+
+/* Small deterministic PRNG so runs are repeatable across platforms */
+static unsigned int bench_seed = 1;
+
+static float bench_uniform(void) {
+    bench_seed = bench_seed * 1664525u + 1013904223u;
+    return ((bench_seed >> 8) + 0.5f) / 16777216.0f;
+}
+
+static RADE_COMP bench_gaussian(float sigma) {
+    float u1 = bench_uniform();
+    float u2 = bench_uniform();
+    float r = sigma * sqrtf(-2.0f * logf(u1));
+    return rade_cpolar(r, 2.0f * M_PI * u2);
+}
+
+/* Noise plus two pilots one modem frame apart, at timing t0 and
+   frequency offset foff.  snr_dB <= -100 gives noise only.  With data,
+   the other symbols carry random phases on the carriers at the pilots'
+   power, so the band is occupied as in a real signal */
+static void make_signal(RADE_COMP *rx, const rade_ofdm *ofdm, int t0, float foff, float snr_dB,
+                        int data) {
+    float sigma = 1.0f / sqrtf(2.0f);
+    for (int n = 0; n < BUF_SIZE; n++) {
+        rx[n] = bench_gaussian(sigma);
+    }
+    if (snr_dB <= -100.0f) {
+        return;
+    }
+
+    float amp = powf(10.0f, snr_dB / 20.0f);
+    float w = 2.0f * M_PI * foff / RADE_FS;
+
+    if (data) {
+        float p_pow = 0.0f;
+        for (int n = 0; n < RADE_M; n++) {
+            p_pow += rade_cabs2(ofdm->p[n]);
+        }
+        float a = amp * sqrtf(p_pow / RADE_M / RADE_NC);
+
+        int Nsym = RADE_M + RADE_NCP;
+        for (int start = t0 % Nsym - Nsym; start < BUF_SIZE; start += Nsym) {
+            if ((start - t0) % RADE_NMF == 0) {
+                continue;                       /* a pilot */
+            }
+            RADE_COMP ph[RADE_NC];
+            for (int c = 0; c < RADE_NC; c++) {
+                ph[c] = rade_cexp(2.0f * M_PI * bench_uniform());
+            }
+            for (int n = 0; n < Nsym; n++) {
+                if (start + n < 0 || start + n >= BUF_SIZE) {
+                    continue;
+                }
+                RADE_COMP s = rade_czero();
+                for (int c = 0; c < RADE_NC; c++) {
+                    s = rade_cadd(s, rade_cmul(ph[c], rade_cexp(ofdm->w[c] * n)));
+                }
+                rx[start + n] = rade_cadd(rx[start + n],
+                                          rade_cscale(rade_cmul(s, rade_cexp(w * (start + n))), a));
+            }
+        }
+    }
+    for (int k = 0; k < 2; k++) {
+        int start = t0 + k * RADE_NMF;
+        for (int n = 0; n < RADE_M && start + n < BUF_SIZE; n++) {
+            RADE_COMP s = rade_cscale(rade_cmul(ofdm->p[n], rade_cexp(w * (start + n))), amp);
+            rx[start + n] = rade_cadd(rx[start + n], s);
+        }
+    }
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1E-9 * ts.tv_nsec;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: rade_acq_bench [-n iterations] [-t trials] [-f range_Hz] [-j threads]\n");
+    fprintf(stderr, "  -n  timed detect_pilots calls per engine (default 50)\n");
+    fprintf(stderr, "  -t  random signals for the decision check (default 200)\n");
+    fprintf(stderr, "  -f  wide search range, +/- Hz (default 300)\n");
+    fprintf(stderr, "  -j  threads for the threaded search (default one per core)\n");
+}
+
+/* Found the signal: detected, on the pilot and within a bin or so of foff */
+static int found(int det, int tmax, float fmax, int t0, float foff) {
+    return det && abs(tmax - t0) <= 2 && fabsf(fmax - foff) <= 2.0f * RADE_ACQ_FSTEP;
+}
+
+/* Same search on one thread (a) and several (b): everything the caller
+   and rade_acq_check_pilots() see has to match bit for bit */
+static int same_search(const RADE_COMP *rx, rade_acq *a, rade_acq *b) {
+    int tmax_a, tmax_b;
+    float fmax_a, fmax_b;
+    int det_a = rade_acq_detect_pilots(a, rx, &tmax_a, &fmax_a);
+    int det_b = rade_acq_detect_pilots(b, rx, &tmax_b, &fmax_b);
+    return det_a == det_b && tmax_a == tmax_b && fmax_a == fmax_b &&
+           a->Dtmax12 == b->Dtmax12 && a->Dthresh == b->Dthresh && a->f_ind_max == b->f_ind_max &&
+           memcmp(a->row_abs_Dt1, b->row_abs_Dt1, sizeof(a->row_abs_Dt1)) == 0 &&
+           memcmp(a->row_abs_Dt2, b->row_abs_Dt2, sizeof(a->row_abs_Dt2)) == 0;
+}
+
+static double time_search(rade_acq *acq, const RADE_COMP *rx, int iterations) {
+    int tmax;
+    float fmax;
+    double t_start = now_s();
+    for (int i = 0; i < iterations; i++) {
+        rade_acq_detect_pilots(acq, rx, &tmax, &fmax);
+    }
+    return (now_s() - t_start) / iterations;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = 50;
+    int trials = 200;
+    float range_Hz = 300.0f;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    while ((opt = getopt(argc, argv, "hn:t:f:j:")) != -1) {
+        switch (opt) {
+            case 'n': iterations = atoi(optarg); break;
+            case 't': trials = atoi(optarg); break;
+            case 'f': range_Hz = (float)atof(optarg); break;
+            case 'j': threads = atoi(optarg); break;
+            case 'h': usage(); return 0;
+            default:  usage(); return 1;
+        }
+    }
+
+    static rade_ofdm ofdm;
+    static rade_acq acq_direct, acq_fft, acq_wide;
+    static rade_acq acq_direct_mt, acq_fft_mt, acq_wide_mt;
+    static RADE_COMP rx[BUF_SIZE];
+
+    rade_ofdm_init(&ofdm, 3, RADE_OFDM_ENGINE_FFT);
+    rade_acq_init(&acq_direct, &ofdm, RADE_ACQ_ENGINE_DIRECT);
+    rade_acq_init(&acq_fft, &ofdm, RADE_ACQ_ENGINE_FFT);
+    rade_acq_init(&acq_wide, &ofdm, RADE_ACQ_ENGINE_FFT);
+    rade_acq_set_range(&acq_wide, range_Hz, RADE_ACQ_WIDE_NWIN);
+    if (acq_fft.engine != RADE_ACQ_ENGINE_FFT) {
+        fprintf(stderr, "rade_acq_bench: FFT engine not available\n");
+        return 1;
+    }
+    rade_acq_init(&acq_direct_mt, &ofdm, RADE_ACQ_ENGINE_DIRECT);
+    rade_acq_init(&acq_fft_mt, &ofdm, RADE_ACQ_ENGINE_FFT);
+    rade_acq_init(&acq_wide_mt, &ofdm, RADE_ACQ_ENGINE_FFT);
+    rade_acq_set_range(&acq_wide_mt, range_Hz, RADE_ACQ_WIDE_NWIN);
+    rade_acq_set_threads(&acq_direct_mt, threads);
+    rade_acq_set_threads(&acq_fft_mt, threads);
+    threads = rade_acq_set_threads(&acq_wide_mt, threads);
+    int thread_mismatch = 0;
+
+    /* Decision check over signals with and without pilots */
+    int mismatch = 0;
+    int detections = 0;
+    float max_rel_err = 0.0f;
+
+    for (int i = 0; i < trials; i++) {
+        int t0 = (int)(bench_uniform() * RADE_NMF);
+        float foff = (bench_uniform() - 0.5f) * RADE_ACQ_FRANGE;
+        float snr_dB = (i % 4 == 0) ? -200.0f : -10.0f + 30.0f * bench_uniform();
+        make_signal(rx, &ofdm, t0, foff, snr_dB, 0);
+
+        int tmax_d, tmax_f;
+        float fmax_d, fmax_f;
+        int det_d = rade_acq_detect_pilots(&acq_direct, rx, &tmax_d, &fmax_d);
+        int det_f = rade_acq_detect_pilots(&acq_fft, rx, &tmax_f, &fmax_f);
+
+        detections += det_d;
+        if (det_d != det_f || tmax_d != tmax_f || fmax_d != fmax_f) {
+            mismatch++;
+            fprintf(stderr, "trial %d: direct det=%d t=%d f=%.1f  fft det=%d t=%d f=%.1f\n",
+                    i, det_d, tmax_d, fmax_d, det_f, tmax_f, fmax_f);
+        }
+
+        float rel_err = fabsf(acq_fft.Dtmax12 - acq_direct.Dtmax12) / acq_direct.Dtmax12;
+        if (rel_err > max_rel_err) max_rel_err = rel_err;
+        rel_err = fabsf(acq_fft.Dthresh - acq_direct.Dthresh) / acq_direct.Dthresh;
+        if (rel_err > max_rel_err) max_rel_err = rel_err;
+
+        thread_mismatch += !same_search(rx, &acq_direct, &acq_direct_mt);
+        thread_mismatch += !same_search(rx, &acq_fft, &acq_fft_mt);
+    }
+
+    /* Wide range check: signals anywhere in +/- range_Hz at -5 to 10 dB
+       SNR in 3 kHz, how often each search finds them, and false detections
+       on noise.  make_signal() scales the pilots, which have this rms */
+    float range_wide = acq_wide.wide_bins * RADE_ACQ_FSTEP;
+    float p_pow = 0.0f;
+    for (int n = 0; n < RADE_M; n++) {
+        p_pow += rade_cabs2(ofdm.p[n]);
+    }
+    float snr_3k_to_dB = 10.0f * log10f(3000.0f / RADE_FS) - 10.0f * log10f(p_pow / RADE_M);
+    int found_narrow = 0, found_wide = 0, n_signal = 0;
+    int false_narrow = 0, false_wide = 0, n_noise = 0;
+
+    for (int i = 0; i < trials; i++) {
+        int t0 = (int)(bench_uniform() * RADE_NMF);
+        float foff = (2.0f * bench_uniform() - 1.0f) * range_wide;
+        float snr_dB = (i % 4 == 0) ? -200.0f : -5.0f + 15.0f * bench_uniform() + snr_3k_to_dB;
+        make_signal(rx, &ofdm, t0, foff, snr_dB, 1);
+
+        int tmax_n, tmax_w;
+        float fmax_n, fmax_w;
+        int det_n = rade_acq_detect_pilots(&acq_fft, rx, &tmax_n, &fmax_n);
+        int det_w = rade_acq_detect_pilots(&acq_wide, rx, &tmax_w, &fmax_w);
+        thread_mismatch += !same_search(rx, &acq_wide, &acq_wide_mt);
+
+        if (snr_dB <= -100.0f) {
+            n_noise++;
+            false_narrow += det_n;
+            false_wide += det_w;
+        } else {
+            n_signal++;
+            found_narrow += found(det_n, tmax_n, fmax_n, t0, foff);
+            found_wide += found(det_w, tmax_w, fmax_w, t0, foff);
+        }
+    }
+
+    /* Timing, noise only input as seen by an idle receiver */
+    make_signal(rx, &ofdm, 0, 0.0f, -200.0f, 0);
+    double t_direct = time_search(&acq_direct, rx, iterations);
+    double t_fft = time_search(&acq_fft, rx, iterations);
+    double t_wide = time_search(&acq_wide, rx, iterations);
+    double t_direct_mt = time_search(&acq_direct_mt, rx, iterations);
+    double t_fft_mt = time_search(&acq_fft_mt, rx, iterations);
+    double t_wide_mt = time_search(&acq_wide_mt, rx, iterations);
+
+    double frame_s = (double)RADE_NMF / RADE_FS;
+    printf("detect_pilots  direct: %8.3f ms/frame (%5.1f%% of real time)\n",
+           1E3 * t_direct, 100.0 * t_direct / frame_s);
+    printf("detect_pilots     fft: %8.3f ms/frame (%5.1f%% of real time)  N=%d\n",
+           1E3 * t_fft, 100.0 * t_fft / frame_s, acq_fft.nfft);
+    printf("detect_pilots    wide: %8.3f ms/frame (%5.1f%% of real time)  +/- %.0f Hz in %d windows\n",
+           1E3 * t_wide, 100.0 * t_wide / frame_s, (double)range_wide, acq_wide.n_win);
+    printf("speedup: %.1fx\n", t_direct / t_fft);
+    printf("%2d threads  direct: %8.3f ms/frame (%.1fx)  fft: %8.3f ms/frame (%.1fx)  wide: %8.3f ms/frame (%.1fx)\n",
+           threads, 1E3 * t_direct_mt, t_direct / t_direct_mt, 1E3 * t_fft_mt, t_fft / t_fft_mt,
+           1E3 * t_wide_mt, t_wide / t_wide_mt);
+    printf("decision check: %d trials, %d detections, %d mismatches, max rel err %.2e\n",
+           trials, detections, mismatch, max_rel_err);
+    printf("wide check: +/- %.0f Hz, found %d/%d (+/- %.0f Hz search %d/%d), false detections %d/%d (%d/%d)\n",
+           (double)range_wide, found_wide, n_signal, (double)(RADE_ACQ_FRANGE / 2.0f), found_narrow, n_signal,
+           false_wide, n_noise, false_narrow, n_noise);
+    printf("thread check: %d searches, %d not bit identical\n", 3 * trials, thread_mismatch);
+
+    rade_acq_close(&acq_direct_mt);
+    rade_acq_close(&acq_fft_mt);
+    rade_acq_close(&acq_wide_mt);
+    return (mismatch || thread_mismatch) ? 1 : 0;
+}
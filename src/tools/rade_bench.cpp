@@ -0,0 +1,652 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_bench.cpp
+
+  Microbenchmarks for the RADAE DSP and neural network kernels, plus the
+  full rade_rx()/rade_tx() paths, on fixtures derived from a speech WAV
+  file.  Every result is quoted per 120 ms modem frame with a real time
+  factor, optionally as JSON for tracking regressions between builds.
+
+\*---------------------------------------------------------------------------*/
+
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+#include "resampler.h"
+#include "EooCallsignDecoder.hpp"
+
+extern "C" {
+#include "rade_api.h"
+#include "rade_dsp.h"
+#include "rade_wav.h"
+#include "rade_ofdm.h"
+#include "rade_acq.h"
+#include "rade_bpf.h"
+#include "rade_kernels.h"
+#include "rade_hilbert.h"
+#include "rade_spectrum.h"
+#include "rade_enc.h"
+#include "rade_dec.h"
+#include "rade_rx.h"
+#include "rade_stats.h"
+#include "fargan.h"
+#include "lpcnet.h"
+#include "cpu_support.h"
+}
+
+/* One modem frame of signal, the unit every result is quoted in */
+#define FRAME_S ((double)RADE_NMF / RADE_FS)
+
+/* Sound card rate used for the resampler benchmarks */
+#define AUDIO_RATE 48000
+
+/* ---- WAV input, mixed to mono ---- */
+
+static bool wav_read_mono(const char *path, std::vector<float> &out, int *sample_rate) {
+    rade_wav_reader w;
+    if (rade_wav_open(&w, path) != 0) return false;
+    out.resize((size_t)w.frames);
+    out.resize((size_t)rade_wav_read(&w, out.data(), (long)out.size()));
+    *sample_rate = w.sample_rate;
+    rade_wav_close(&w);
+    return !out.empty();
+}
+
+/* ---- Timing ---- */
+
+struct Result {
+    std::string name;
+    int         frames;
+    double      mean_ns;
+    double      p50_ns;
+    double      p99_ns;
+    double      rtf;          /* processing time / signal time, < 1 is faster than real time */
+};
+
+/* Time fn(i) once per modem frame for n frames, after a short warm up
+   so caches and branch predictors are settled */
+template <typename F>
+static Result bench(const char *name, int frames, F &&fn) {
+    int warmup = frames / 10 > 0 ? frames / 10 : 1;
+    for (int i = 0; i < warmup; i++) fn(i);
+
+    static rade_hist h;
+    rade_hist_init(&h);
+    for (int i = 0; i < frames; i++) {
+        uint64_t t0 = rade_time_ns();
+        fn(warmup + i);
+        rade_hist_add(&h, rade_time_ns() - t0);
+    }
+
+    rade_stage_stats st;
+    rade_hist_read(&h, &st);
+    Result r;
+    r.name    = name;
+    r.frames  = frames;
+    r.mean_ns = 1E3 * st.mean_us;
+    r.p50_ns  = 1E3 * st.p50_us;
+    r.p99_ns  = 1E3 * st.p99_us;
+    r.rtf     = 1E-9 * r.mean_ns / FRAME_S;
+    return r;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: rade_bench [-i speech.wav] [-n frames] [-k name] [-j out.json]\n");
+    fprintf(stderr, "  -i  speech used to build the fixtures (default voice.wav)\n");
+    fprintf(stderr, "  -n  timed modem frames per benchmark (default 200)\n");
+    fprintf(stderr, "  -k  only run benchmarks whose name contains this string\n");
+    fprintf(stderr, "  -j  also write the results as JSON to this file (- for stdout)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *wav_path = "voice.wav";
+    const char *json_path = NULL;
+    const char *filter = NULL;
+    int frames = 200;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "hi:n:k:j:")) != -1) {
+        switch (opt) {
+            case 'i': wav_path = optarg; break;
+            case 'n': frames = atoi(optarg); break;
+            case 'k': filter = optarg; break;
+            case 'j': json_path = optarg; break;
+            case 'h': usage(); return 0;
+            default:  usage(); return 1;
+        }
+    }
+    if (frames < 1) frames = 1;
+
+    int arch = opus_select_arch();
+
+    /* ---- Fixtures: speech -> features -> Tx IQ -> real -> Hilbert IQ ---- */
+
+    std::vector<float> speech;
+    int wav_rate = 0;
+    if (!wav_read_mono(wav_path, speech, &wav_rate)) {
+        fprintf(stderr, "rade_bench: can't read WAV '%s'\n", wav_path);
+        return 1;
+    }
+    if (wav_rate != RADE_FS_SPEECH) {
+        speech = Resampler::convert(speech, (unsigned)wav_rate, RADE_FS_SPEECH);
+    }
+
+    const int feat_frames_per_mf = RADE_NZMF * RADE_FRAMES_PER_STEP;
+    const int n_feat_mf = feat_frames_per_mf * RADE_NB_TOTAL_FEATURES;
+    int n_mf = (int)(speech.size() / (LPCNET_FRAME_SIZE * feat_frames_per_mf));
+    if (n_mf < 8) {
+        fprintf(stderr, "rade_bench: '%s' is too short, need at least 8 modem frames\n", wav_path);
+        return 1;
+    }
+    int n_ff = n_mf * feat_frames_per_mf;
+
+    std::vector<int16_t> pcm((size_t)n_ff * LPCNET_FRAME_SIZE);
+    rade_kernels_get()->float_to_s16(pcm.data(), speech.data(), 32768.0f, (int)pcm.size());
+
+    LPCNetEncState *lpcnet = lpcnet_encoder_create();
+    if (!lpcnet) {
+        fprintf(stderr, "rade_bench: lpcnet_encoder_create failed\n");
+        return 1;
+    }
+    std::vector<float> features((size_t)n_ff * RADE_NB_TOTAL_FEATURES);
+    for (int i = 0; i < n_ff; i++) {
+        lpcnet_compute_single_frame_features(lpcnet, &pcm[(size_t)i * LPCNET_FRAME_SIZE],
+                                             &features[(size_t)i * RADE_NB_TOTAL_FEATURES], arch);
+    }
+
+    rade_initialize();
+    struct rade *tx = rade_open_tx_only(NULL, RADE_VERBOSE_0);
+    if (!tx) return 1;
+
+    /* Tx signal with one extra window of wrap around, so any modem frame
+       can be the start of an Rx window */
+    const int n_win = RADE_RX_BUF_SIZE;
+    std::vector<RADE_COMP> tx_iq((size_t)n_mf * RADE_NMF + n_win);
+    for (int m = 0; m < n_mf; m++) {
+        rade_tx(tx, &tx_iq[(size_t)m * RADE_NMF], &features[(size_t)m * n_feat_mf]);
+    }
+    memcpy(&tx_iq[(size_t)n_mf * RADE_NMF], &tx_iq[0], sizeof(RADE_COMP) * n_win);
+
+    std::vector<float> rx_real(tx_iq.size());
+    for (size_t i = 0; i < tx_iq.size(); i++) rx_real[i] = tx_iq[i].real;
+
+    std::vector<RADE_COMP> rx_iq(rx_real.size());
+    {
+        static rade_hilbert hb;
+        rade_hilbert_init(&hb);
+        rade_hilbert_process(&hb, rx_iq.data(), rx_real.data(), (int)rx_real.size());
+    }
+
+    /* Latents for the decoder, straight from the encoder */
+    static RADEEnc enc_model;
+    static RADEDec dec_model;
+    if (init_radeenc(&enc_model, radeenc_arrays, RADE_NUM_FEATURES_AUX * RADE_FRAMES_PER_STEP) != 0 ||
+        init_radedec(&dec_model, radedec_arrays, RADE_NUM_FEATURES_AUX * RADE_FRAMES_PER_STEP) != 0) {
+        fprintf(stderr, "rade_bench: failed to initialise model weights\n");
+        return 1;
+    }
+
+    /* Encoder input, [frame][21] with the aux data symbol, as rade_tx() builds it */
+    const int enc_in = RADE_FRAMES_PER_STEP * RADE_NUM_FEATURES_AUX;
+    std::vector<float> enc_features((size_t)n_mf * RADE_NZMF * enc_in);
+    for (int i = 0; i < n_ff; i++) {
+        float *dst = &enc_features[(size_t)i * RADE_NUM_FEATURES_AUX];
+        memcpy(dst, &features[(size_t)i * RADE_NB_TOTAL_FEATURES], sizeof(float) * RADE_NUM_FEATURES);
+        dst[RADE_NUM_FEATURES] = -1.0f;
+    }
+
+    const int n_z = RADE_NZMF * RADE_LATENT_DIM;
+    std::vector<float> z((size_t)n_mf * n_z);
+    {
+        static RADEEncState es;
+        rade_init_encoder(&es);
+        for (int c = 0; c < n_mf * RADE_NZMF; c++) {
+            rade_core_encoder(&es, &enc_model, &z[(size_t)c * RADE_LATENT_DIM],
+                              &enc_features[(size_t)c * enc_in], arch, 3);
+        }
+    }
+
+    /* Timing and frequency of each Rx window, from one detection pass */
+    static rade_ofdm ofdm;
+    static rade_acq acq;
+    rade_ofdm_init(&ofdm, 3, RADE_OFDM_ENGINE_FFT);
+    rade_acq_init(&acq, &ofdm, RADE_ACQ_ENGINE_FFT);
+
+    std::vector<int>   win_t((size_t)n_mf);
+    std::vector<float> win_f((size_t)n_mf);
+    for (int m = 0; m < n_mf; m++) {
+        int t = 0;
+        float f = 0.0f;
+        rade_acq_detect_pilots(&acq, &rx_iq[(size_t)m * RADE_NMF], &t, &f);
+        if (t < RADE_NCP + 8) t = RADE_NCP + 8;
+        if (t > RADE_NMF - 8) t = RADE_NMF - 8;
+        win_t[(size_t)m] = t;
+        win_f[(size_t)m] = f;
+    }
+
+    fprintf(stderr, "rade_bench: %s, %d modem frames of fixture, %d timed frames, arch %d, %s kernels\n",
+            wav_path, n_mf, frames, arch, rade_kernels_get()->name);
+
+    /* ---- Benchmarks ---- */
+
+    /* JSON to stdout moves the human readable table to stderr */
+    FILE *table = (json_path && !strcmp(json_path, "-")) ? stderr : stdout;
+    std::vector<Result> results;
+    auto run = [&](const char *name, auto &&fn) {
+        if (filter && !strstr(name, filter)) return;
+        results.push_back(bench(name, frames, fn));
+        const Result &r = results.back();
+        fprintf(table, "%-18s %12.0f ns/frame  p50 %12.0f  p99 %12.0f  rtf %.5f\n",
+               r.name.c_str(), r.mean_ns, r.p50_ns, r.p99_ns, r.rtf);
+        fflush(table);
+    };
+    volatile float sink = 0.0f;
+
+    run("resample_in", [&](int i) {
+        /* capture side, AUDIO_RATE -> 8 kHz */
+        static Resampler rs;
+        static std::vector<float> in, out;
+        if (in.empty()) {
+            rs.init(AUDIO_RATE, RADE_FS);
+            in.assign((size_t)RADE_NMF * AUDIO_RATE / RADE_FS, 0.0f);
+            for (size_t k = 0; k < in.size(); k++) in[k] = rx_real[k % rx_real.size()];
+            out.resize((size_t)rs.max_output((int)in.size()));
+        }
+        (void)i;
+        sink += (float)rs.process(in.data(), (int)in.size(), out.data(), (int)out.size());
+    });
+
+    run("resample_out", [&](int i) {
+        /* playback side, 16 kHz speech -> AUDIO_RATE */
+        static Resampler rs;
+        static std::vector<float> out;
+        const int n = feat_frames_per_mf * LPCNET_FRAME_SIZE;
+        if (out.empty()) {
+            rs.init(RADE_FS_SPEECH, AUDIO_RATE);
+            out.resize((size_t)rs.max_output(n));
+        }
+        const float *in = &speech[(size_t)(i % n_mf) * n];
+        sink += (float)rs.process(in, n, out.data(), (int)out.size());
+    });
+
+    run("hilbert", [&](int i) {
+        static rade_hilbert hb;
+        static RADE_COMP out[RADE_NMF];
+        if (i == 0) rade_hilbert_init(&hb);
+        rade_hilbert_process(&hb, out, &rx_real[(size_t)(i % n_mf) * RADE_NMF], RADE_NMF);
+        sink += out[0].real;
+    });
+
+    run("spectrum", [&](int i) {
+        /* the GUI spectrum display, one 512 point spectrum per modem frame */
+        static rade_spectrum sp;
+        static float db[256];
+        if (i == 0) rade_spectrum_init(&sp, 512);
+        rade_spectrum_db(&sp, db, &rx_real[(size_t)(i % n_mf) * RADE_NMF]);
+        sink += db[0];
+    });
+
+    run("bpf", [&](int i) {
+        static rade_bpf bpf;
+        static RADE_COMP out[RADE_NMF];
+        if (i == 0) {
+            float w_min = ofdm.w[0], w_max = ofdm.w[RADE_NC - 1];
+            float bandwidth = 1.2f * (w_max - w_min) * RADE_FS / (2.0f * M_PI);
+            float centre = (w_max + w_min) * RADE_FS / (2.0f * M_PI) / 2.0f;
+            rade_bpf_init(&bpf, RADE_BPF_NTAP, RADE_FS, bandwidth, centre, RADE_FS, RADE_BPF_DIRECT);
+        }
+        rade_bpf_process(&bpf, out, &rx_iq[(size_t)(i % n_mf) * RADE_NMF], RADE_NMF);
+        sink += out[0].real;
+    });
+
+    run("acq_detect_pilots", [&](int i) {
+        int t;
+        float f;
+        sink += (float)rade_acq_detect_pilots(&acq, &rx_iq[(size_t)(i % n_mf) * RADE_NMF], &t, &f);
+    });
+
+    run("acq_refine", [&](int i) {
+        /* sync mode search, +/- 8 samples and +/- 1 Hz in 0.1 Hz steps */
+        int m = i % n_mf;
+        int t = win_t[(size_t)m];
+        float f = win_f[(size_t)m];
+        rade_acq_refine(&acq, &rx_iq[(size_t)m * RADE_NMF], &t, &f,
+                        t - 8, t + 8, f - 1.0f, f + 1.0f, 0.1f);
+        sink += f;
+    });
+
+    run("acq_check_pilots", [&](int i) {
+        int m = i % n_mf;
+        int candidate, endofover;
+        rade_acq_check_pilots(&acq, &rx_iq[(size_t)m * RADE_NMF], win_t[(size_t)m], win_f[(size_t)m],
+                              &candidate, &endofover);
+        sink += (float)candidate;
+    });
+
+    run("ofdm_demod_frame", [&](int i) {
+        int m = i % n_mf;
+        static float z_hat[RADE_NZMF * RADE_LATENT_DIM];
+        float snr;
+        const RADE_COMP *rx = &rx_iq[(size_t)m * RADE_NMF + win_t[(size_t)m] - RADE_NCP];
+        rade_ofdm_demod_frame(&ofdm, z_hat, rx, -16, 0, 1, &snr);
+        sink += z_hat[0];
+    });
+
+    run("ofdm_mod_frame", [&](int i) {
+        static RADE_COMP out[RADE_NMF];
+        rade_ofdm_mod_frame(&ofdm, out, &z[(size_t)(i % n_mf) * n_z]);
+        sink += out[0].real;
+    });
+
+    /* SIMD kernels, once per implementation this CPU supports: a modem
+       frame of the direct coarse search (both grid rows at every lag), of
+       pilot correlations, of the BPF mixer and FIR, of OFDM direct DFTs,
+       of the Tx PA model and of WAV PCM conversion.  Each is checked bit exact against the
+       scalar kernels first */
+    {
+        const RADE_COMP *x = rx_iq.data();
+        const int nh = RADE_BPF_NTAP - 1;
+        static float bpf_h[RADE_BPF_NTAP];
+        static float xr[RADE_BPF_NTAP - 1 + RADE_NMF], xi[RADE_BPF_NTAP - 1 + RADE_NMF];
+        for (int k = 0; k < RADE_BPF_NTAP; k++) bpf_h[k] = rade_sinc((k - nh / 2) * 0.3f) * 0.3f;
+        rade_csplit(xr, xi, x, nh + RADE_NMF);
+        RADE_COMP inc = rade_cexp(-2.0f * (float)M_PI * 1500.0f / RADE_FS);
+
+        /* |xl| sweeps 0..10, through both of the limiter's ranges */
+        static RADE_COMP xl[RADE_NMF];
+        for (int k = 0; k < RADE_NMF; k++) xl[k] = rade_cscale(rade_cexp(0.37f * k), 10.0f * k / RADE_NMF);
+
+        /* Every output of every kernel on one frame, for the cross check */
+        auto outputs = [&](const rade_kernels *k) {
+            std::vector<float> o;
+            float re[RADE_ACQ_NFREQ], im[RADE_ACQ_NFREQ];
+            for (int t = 0; t < RADE_NMF; t += 37) {
+                k->cvmmul_split(re, im, &x[t], &acq.p_w_re[0][0], &acq.p_w_im[0][0],
+                                RADE_ACQ_NFREQ, RADE_M, acq.n_fcoarse, 1);
+                o.insert(o.end(), re, re + acq.n_fcoarse);
+                o.insert(o.end(), im, im + acq.n_fcoarse);
+                RADE_COMP d = k->cdot(&x[t], acq.p, RADE_M, 1);
+                o.push_back(d.real);
+                o.push_back(d.imag);
+            }
+            std::vector<RADE_COMP> y(RADE_NMF), ph(RADE_NMF);
+            RADE_COMP phase = rade_cone();
+            k->rotate(y.data(), ph.data(), x, &phase, inc, RADE_NMF - 3);
+            k->cvmul(y.data(), y.data(), ph.data(), RADE_NMF - 3, 1);
+            for (const RADE_COMP &c : y) { o.push_back(c.real); o.push_back(c.imag); }
+            std::vector<float> yr(RADE_NMF), yi(RADE_NMF);
+            k->fir_sym_split(yr.data(), yi.data(), xr, xi, bpf_h, RADE_BPF_NTAP, RADE_NMF);
+            o.insert(o.end(), yr.begin(), yr.end());
+            o.insert(o.end(), yi.begin(), yi.end());
+            k->cmvmul_split(yr.data(), yi.data(), &ofdm.Wc_re[0][0], &ofdm.Wc_im[0][0], RADE_M,
+                            xr, xi, RADE_NC, RADE_M, 1);
+            o.insert(o.end(), yr.begin(), yr.begin() + RADE_NC);
+            o.insert(o.end(), yi.begin(), yi.begin() + RADE_NC);
+            k->climit(y.data(), xl, RADE_NMF - 3);
+            for (int n = 0; n < RADE_NMF - 3; n++) { o.push_back(y[n].real); o.push_back(y[n].imag); }
+            /* scaled so the peaks clip */
+            std::vector<int16_t> pcm(RADE_NMF);
+            k->float_to_s16(pcm.data(), xr, 32768.0f * 8.0f, RADE_NMF - 3);
+            k->s16_to_float(yr.data(), pcm.data(), 1.0f / 32768.0f, RADE_NMF - 3);
+            o.insert(o.end(), yr.begin(), yr.begin() + RADE_NMF - 3);
+            return o;
+        };
+        const std::vector<float> ref = outputs(rade_kernels_arch(RADE_KERNELS_SCALAR));
+
+        for (int a = 0; a < RADE_KERNELS_N; a++) {
+            const rade_kernels *k = rade_kernels_arch(a);
+            if (!k) continue;
+            if (a != RADE_KERNELS_SCALAR) {
+                std::vector<float> o = outputs(k);
+                bool same = o.size() == ref.size() && !memcmp(o.data(), ref.data(), sizeof(float) * o.size());
+                fprintf(stderr, "rade_bench: %s kernels %s the scalar kernels\n", k->name,
+                        same ? "bit exact with" : "DIFFER from");
+            }
+            std::string nm;
+
+            nm = std::string("kern_acq_grid_") + k->name;
+            run(nm.c_str(), [&](int i) {
+                (void)i;
+                float re[RADE_ACQ_NFREQ], im[RADE_ACQ_NFREQ];
+                for (int t = 0; t < RADE_NMF; t++) {
+                    k->cvmmul_split(re, im, &x[t], &acq.p_w_re[0][0], &acq.p_w_im[0][0],
+                                    RADE_ACQ_NFREQ, RADE_M, acq.n_fcoarse, 1);
+                    k->cvmmul_split(re, im, &x[t + RADE_NMF], &acq.p_w_re[0][0], &acq.p_w_im[0][0],
+                                    RADE_ACQ_NFREQ, RADE_M, acq.n_fcoarse, 1);
+                }
+                sink += re[0];
+            });
+
+            nm = std::string("kern_cdot_") + k->name;
+            run(nm.c_str(), [&](int i) {
+                (void)i;
+                RADE_COMP acc = rade_czero();
+                for (int t = 0; t < RADE_NMF; t++) acc = rade_cadd(acc, k->cdot(&x[t], acq.p, RADE_M, 1));
+                sink += acc.real;
+            });
+
+            nm = std::string("kern_bpf_") + k->name;
+            run(nm.c_str(), [&](int i) {
+                (void)i;
+                static RADE_COMP y[RADE_NMF], ph[RADE_NMF];
+                static float yr[RADE_NMF], yi[RADE_NMF];
+                RADE_COMP phase = rade_cone();
+                k->rotate(y, ph, x, &phase, inc, RADE_NMF);
+                k->fir_sym_split(yr, yi, xr, xi, bpf_h, RADE_BPF_NTAP, RADE_NMF);
+                rade_cjoin(y, yr, yi, RADE_NMF);
+                k->cvmul(y, y, ph, RADE_NMF, 1);
+                sink += y[0].real;
+            });
+
+            nm = std::string("kern_ofdm_dft_") + k->name;
+            run(nm.c_str(), [&](int i) {
+                (void)i;
+                float re[RADE_NC], im[RADE_NC];
+                for (int s = 0; s < RADE_NSYMB_MF; s++) {
+                    int n0 = s * (RADE_M + RADE_NCP);
+                    k->cmvmul_split(re, im, &ofdm.Wc_re[0][0], &ofdm.Wc_im[0][0], RADE_M,
+                                    &xr[n0], &xi[n0], RADE_NC, RADE_M, 1);
+                }
+                sink += re[0];
+            });
+
+            nm = std::string("kern_climit_") + k->name;
+            run(nm.c_str(), [&](int i) {
+                (void)i;
+                static RADE_COMP y[RADE_NMF];
+                k->climit(y, xl, RADE_NMF);
+                sink += y[0].real;
+            });
+
+            nm = std::string("kern_pcm_") + k->name;
+            run(nm.c_str(), [&](int i) {
+                (void)i;
+                static int16_t pcm[RADE_NMF];
+                static float y[RADE_NMF];
+                k->float_to_s16(pcm, xr, 32768.0f, RADE_NMF);
+                k->s16_to_float(y, pcm, 1.0f / 32768.0f, RADE_NMF);
+                sink += y[0];
+            });
+        }
+    }
+
+    run("core_encoder", [&](int i) {
+        static RADEEncState es;
+        static float zz[RADE_LATENT_DIM];
+        if (i == 0) rade_init_encoder(&es);
+        int m = i % n_mf;
+        for (int c = 0; c < RADE_NZMF; c++) {
+            rade_core_encoder(&es, &enc_model, zz,
+                              &enc_features[((size_t)m * RADE_NZMF + c) * enc_in], arch, 3);
+        }
+        sink += zz[0];
+    });
+
+    run("core_decoder", [&](int i) {
+        static RADEDecState ds;
+        static float out[RADE_FRAMES_PER_STEP * RADE_NUM_FEATURES_AUX];
+        if (i == 0) rade_init_decoder(&ds);
+        int m = i % n_mf;
+        for (int c = 0; c < RADE_NZMF; c++) {
+            rade_core_decoder(&ds, &dec_model, out, &z[(size_t)m * n_z + c * RADE_LATENT_DIM], arch);
+        }
+        sink += out[0];
+    });
+
+    run("lpcnet_features", [&](int i) {
+        float f[RADE_NB_TOTAL_FEATURES];
+        int m = i % n_mf;
+        for (int k = 0; k < feat_frames_per_mf; k++) {
+            lpcnet_compute_single_frame_features(
+                lpcnet, &pcm[((size_t)m * feat_frames_per_mf + k) * LPCNET_FRAME_SIZE], f, arch);
+        }
+        sink += f[0];
+    });
+
+    run("fargan", [&](int i) {
+        static FARGANState fargan;
+        float out[LPCNET_FRAME_SIZE];
+        if (i == 0) {
+            float packed[5 * NB_FEATURES];
+            float zeros[FARGAN_CONT_SAMPLES] = {0};
+            for (int k = 0; k < 5; k++) {
+                memcpy(&packed[k * NB_FEATURES], &features[(size_t)k * RADE_NB_TOTAL_FEATURES],
+                       sizeof(float) * NB_FEATURES);
+            }
+            fargan_init(&fargan);
+            fargan_cont(&fargan, zeros, packed);
+        }
+        int m = i % n_mf;
+        for (int k = 0; k < feat_frames_per_mf; k++) {
+            fargan_synthesize(&fargan, out,
+                              &features[((size_t)m * feat_frames_per_mf + k) * RADE_NB_TOTAL_FEATURES]);
+        }
+        sink += out[0];
+    });
+
+    /* EOO callsign decode on noise, the worst case: a false end of over
+       trigger never converges so runs every LDPC iteration.  The batch
+       variant decodes 8 channels per call */
+    const int n_eoo = rade_n_eoo_bits(tx);
+    const int n_eoo_bufs = 64;
+    std::vector<float> eoo_noise((size_t)n_eoo_bufs * n_eoo);
+    {
+        uint32_t seed = 1;
+        for (size_t k = 0; k < eoo_noise.size(); k++) {
+            seed = seed * 1664525u + 1013904223u;
+            eoo_noise[k] = (float)(seed >> 8) / (float)(1u << 24) - 0.5f;
+        }
+    }
+    EooCallsignDecoder eoo_dec;
+
+    run("eoo_ldpc_ref", [&](int i) {
+        std::string cs;
+        sink += eoo_dec.decodeReference(&eoo_noise[(size_t)(i % n_eoo_bufs) * n_eoo], n_eoo / 2, cs);
+    });
+
+    run("eoo_ldpc", [&](int i) {
+        std::string cs;
+        sink += eoo_dec.decode(&eoo_noise[(size_t)(i % n_eoo_bufs) * n_eoo], n_eoo / 2, cs);
+    });
+
+    run("eoo_ldpc_batch8", [&](int i) {
+        const int nb = EooCallsignDecoder::kBatchLanes;
+        const float *bufs[nb];
+        int sizes[nb];
+        std::string cs[nb];
+        bool ok[nb];
+        for (int k = 0; k < nb; k++) {
+            bufs[k] = &eoo_noise[(size_t)((i * nb + k) % n_eoo_bufs) * n_eoo];
+            sizes[k] = n_eoo / 2;
+        }
+        sink += eoo_dec.decodeBatch(bufs, sizes, nb, cs, ok);
+    });
+
+    /* End to end, one rade_rx()/rade_tx() call per frame.  rade_rx() treats
+       the fixture as a loop, so it acquires once and then stays in sync */
+    struct rade *rx = rade_open_rx_only(NULL, RADE_VERBOSE_0);
+    if (!rx) return 1;
+    std::vector<float> feat_out((size_t)rade_n_features_in_out(rx));
+    std::vector<float> eoo_out((size_t)rade_n_eoo_bits(rx));
+    size_t rx_pos = 0;
+
+    run("rade_rx", [&](int i) {
+        (void)i;
+        int nin = rade_nin(rx);
+        if (rx_pos + (size_t)nin > (size_t)n_mf * RADE_NMF) rx_pos = 0;
+        int has_eoo;
+        sink += (float)rade_rx(rx, feat_out.data(), &has_eoo, eoo_out.data(), &rx_iq[rx_pos]);
+        rx_pos += (size_t)nin;
+    });
+
+    run("rade_tx", [&](int i) {
+        static RADE_COMP out[RADE_NMF];
+        rade_tx(tx, out, &features[(size_t)(i % n_mf) * n_feat_mf]);
+        sink += out[0].real;
+    });
+
+    /* ---- Report ---- */
+
+    if (json_path) {
+        FILE *f = strcmp(json_path, "-") ? fopen(json_path, "w") : stdout;
+        if (!f) {
+            fprintf(stderr, "rade_bench: can't write '%s'\n", json_path);
+            return 1;
+        }
+        fprintf(f, "{\n  \"tool\": \"rade_bench\",\n  \"api_version\": %d,\n  \"arch\": %d,\n",
+                rade_version(), arch);
+        fprintf(f, "  \"fixture\": \"%s\",\n  \"fixture_frames\": %d,\n  \"frame_ms\": %.0f,\n",
+                wav_path, n_mf, 1E3 * FRAME_S);
+        fprintf(f, "  \"results\": [\n");
+        for (size_t k = 0; k < results.size(); k++) {
+            const Result &r = results[k];
+            fprintf(f, "    {\"name\": \"%s\", \"frames\": %d, \"ns_per_frame\": %.0f, "
+                       "\"p50_ns\": %.0f, \"p99_ns\": %.0f, \"rtf\": %.6f}%s\n",
+                    r.name.c_str(), r.frames, r.mean_ns, r.p50_ns, r.p99_ns, r.rtf,
+                    k + 1 < results.size() ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        if (f != stdout) fclose(f);
+    }
+
+    rade_close(rx);
+    rade_close(tx);
+    lpcnet_encoder_destroy(lpcnet);
+    rade_finalize();
+
+    return 0;
+}
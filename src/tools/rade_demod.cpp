@@ -3,7 +3,9 @@
   rade_demod.c
 
   RADAE WAV demodulator.  Reads a WAV file containing received RADE OFDM
-  audio and writes a WAV file containing the decoded voice audio.
+  audio and writes a WAV file containing the decoded voice audio.  In
+  batch mode decodes many files concurrently, one receiver per worker
+  thread.
 
   Combines real2iq (Hilbert), radae_rx (OFDM demod + neural decoder), and
   the FARGAN vocoder into a single command-line tool.
@@ -43,9 +45,22 @@
 #include <stdint.h>
 #include <math.h>
 #include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "rade_api.h"
 #include "rade_dsp.h"
+#include "rade_hilbert.h"
+#include "rade_wav.h"
+#include "resampler.h"
 extern "C" {
 #include "fargan.h"
 #include "lpcnet.h"
@@ -56,295 +71,65 @@ extern "C" {
 #define M_PI 3.14159265358979323846
 #endif
 
-/* ---- Hilbert transform  (coefficients match real2iq.c exactly) ---- */
+/* ---- Decoding one file ---- */
 
-#define HILBERT_NTAPS   127
-#define HILBERT_DELAY   ((HILBERT_NTAPS - 1) / 2)   /* 63 */
-
-static float hilbert_coeffs[HILBERT_NTAPS];
-
-static void init_hilbert(void) {
-    int center = HILBERT_DELAY;
-    for (int i = 0; i < HILBERT_NTAPS; i++) {
-        int n = i - center;
-        if (n == 0 || (n & 1) == 0) {
-            hilbert_coeffs[i] = 0.0f;
-        } else {
-            float h = 2.0f / (M_PI * n);
-            float w = 0.54f - 0.46f * cosf(2.0f * M_PI * i / (HILBERT_NTAPS - 1));
-            hilbert_coeffs[i] = h * w;
-        }
-    }
-}
-
-/* ---- WAV file I/O ---- */
-
-#define WAV_FMT_PCM   1
-#define WAV_FMT_FLOAT 3
+/* Input samples read per chunk, so memory use doesn't depend on file length */
+#define DEMOD_CHUNK 8192
 
 typedef struct {
-    int      sample_rate;
-    int      num_channels;
-    int      bits_per_sample;
-    int      is_float;          /* 1 if IEEE float format */
-    long     data_offset;       /* byte offset of audio data in file */
-    uint32_t data_size;         /* byte count of audio data */
-} wav_info;
-
-/* Parse WAV header.  On success the file position is at the first audio byte. */
-static int wav_read_header(FILE *f, wav_info *info) {
-    char     tag[4];
-    uint32_t riff_size;
-
-    if (fread(tag, 1, 4, f) != 4 || memcmp(tag, "RIFF", 4)) return -1;
-    if (fread(&riff_size, 4, 1, f) != 1) return -1;
-    if (fread(tag, 1, 4, f) != 4 || memcmp(tag, "WAVE", 4)) return -1;
-
-    info->data_offset = -1;
-
-    while (1) {
-        char     chunk_id[4];
-        uint32_t chunk_size;
-        if (fread(chunk_id, 1, 4, f) != 4) break;
-        if (fread(&chunk_size, 4, 1, f) != 1) break;
-
-        if (memcmp(chunk_id, "fmt ", 4) == 0) {
-            if (chunk_size < 16) return -1;
-            uint8_t buf[16];
-            if (fread(buf, 1, 16, f) != 16) return -1;
-
-            uint16_t audio_fmt, nch, bps;
-            uint32_t sr;
-            memcpy(&audio_fmt, buf + 0,  2);
-            memcpy(&nch,       buf + 2,  2);
-            memcpy(&sr,        buf + 4,  4);
-            memcpy(&bps,       buf + 14, 2);
-
-            info->sample_rate     = (int)sr;
-            info->num_channels    = (int)nch;
-            info->bits_per_sample = (int)bps;
-            info->is_float        = (audio_fmt == WAV_FMT_FLOAT);
-
-            if (chunk_size > 16)
-                fseek(f, (long)(chunk_size - 16), SEEK_CUR);
-
-        } else if (memcmp(chunk_id, "data", 4) == 0) {
-            info->data_offset = ftell(f);
-            info->data_size   = chunk_size;
-            break;
-        } else {
-            /* skip unknown chunk (pad to even byte boundary) */
-            fseek(f, (long)((chunk_size + 1) & ~1u), SEEK_CUR);
-        }
-    }
-    return (info->data_offset >= 0) ? 0 : -1;
-}
-
-/* Read the entire audio payload into a mono float buffer.
-   Multi-channel input is mixed down by averaging.  Caller must free(). */
-static float *wav_read_mono_float(FILE *f, const wav_info *info, long *n_out) {
-    int   bps  = info->bits_per_sample;
-    int   nch  = info->num_channels;
-    long  total = (long)info->data_size / (bps / 8);
-    long  mono  = total / nch;
-
-    float *buf = (float *)malloc((size_t)mono * sizeof(float));
-    if (!buf) return NULL;
-
-    for (long i = 0; i < mono; i++) {
-        float sum = 0.0f;
-        for (int ch = 0; ch < nch; ch++) {
-            float v = 0.0f;
-            if (info->is_float && bps == 32) {
-                float tmp;  fread(&tmp, 4, 1, f);  v = tmp;
-            } else if (info->is_float && bps == 64) {
-                double tmp; fread(&tmp, 8, 1, f);  v = (float)tmp;
-            } else if (bps == 16) {
-                int16_t tmp; fread(&tmp, 2, 1, f); v = tmp / 32768.0f;
-            } else if (bps == 24) {
-                uint8_t b[3]; fread(b, 1, 3, f);
-                int32_t raw = ((int32_t)b[2] << 16) | (b[1] << 8) | b[0];
-                if (raw & 0x800000) raw |= (int32_t)0xFF000000;
-                v = raw / 8388608.0f;
-            } else if (bps == 32) {
-                int32_t tmp; fread(&tmp, 4, 1, f); v = tmp / 2147483648.0f;
-            } else {
-                fprintf(stderr, "rade_demod: unsupported WAV format (%d-bit %s)\n",
-                        bps, info->is_float ? "float" : "int");
-                free(buf);
-                return NULL;
-            }
-            sum += v;
-        }
-        buf[i] = sum / nch;
-    }
-    *n_out = mono;
-    return buf;
-}
-
-/* Write a standard 44-byte PCM WAV header (16-bit, mono). */
-static void wav_write_header(FILE *f, int sample_rate, uint32_t data_bytes) {
-    uint16_t nch         = 1;
-    uint16_t bps         = 16;
-    uint16_t fmt         = WAV_FMT_PCM;
-    uint32_t fmt_size    = 16;
-    uint16_t block_align = (uint16_t)(nch * bps / 8);
-    uint32_t byte_rate   = (uint32_t)sample_rate * block_align;
-    uint32_t riff_size   = 36 + data_bytes;
-    uint32_t sr          = (uint32_t)sample_rate;
-
-    fwrite("RIFF",       1, 4, f);  fwrite(&riff_size,   4, 1, f);
-    fwrite("WAVE",       1, 4, f);
-    fwrite("fmt ",       1, 4, f);  fwrite(&fmt_size,    4, 1, f);
-    fwrite(&fmt,         2, 1, f);  fwrite(&nch,         2, 1, f);
-    fwrite(&sr,          4, 1, f);  fwrite(&byte_rate,   4, 1, f);
-    fwrite(&block_align, 2, 1, f);  fwrite(&bps,         2, 1, f);
-    fwrite("data",       1, 4, f);  fwrite(&data_bytes,  4, 1, f);
-}
-
-/* ---- Linear-interpolation resampler ---- */
-
-/* Resample *in (n_in samples at in_rate) to out_rate.
-   Returns a malloc'd buffer; caller must free().  Sets *n_out. */
-static float *resample_linear(const float *in, long n_in,
-                              int in_rate, int out_rate, long *n_out) {
-    if (in_rate == out_rate) {
-        float *out = (float *)malloc((size_t)n_in * sizeof(float));
-        if (out) memcpy(out, in, (size_t)n_in * sizeof(float));
-        *n_out = n_in;
-        return out;
-    }
-    if (n_in < 2) { *n_out = 0; return (float *)malloc(1); }
-
-    *n_out = (long)((double)n_in * out_rate / in_rate);
-    float *out = (float *)malloc((size_t)*n_out * sizeof(float));
-    if (!out) return NULL;
-
-    double step = (double)in_rate / (double)out_rate;   /* input samples per output sample */
-    for (long i = 0; i < *n_out; i++) {
-        double pos  = i * step;
-        long   idx  = (long)pos;
-        float  frac = (float)(pos - idx);
-        if (idx + 1 >= n_in) { idx = n_in - 2; frac = 1.0f; }
-        out[i] = in[idx] + frac * (in[idx + 1] - in[idx]);
-    }
-    return out;
-}
-
-/* ---- Usage ---- */
-
-static void usage(void) {
-    fprintf(stderr,
-            "usage: rade_demod [options] <input.wav> <output.wav>\n\n"
-            "  Reads a WAV file containing received RADE OFDM audio and writes\n"
-            "  a WAV file containing the decoded voice audio.\n\n"
-            "  Input WAV : any sample rate, mono or stereo\n"
-            "              (resampled to %d Hz / mixed to mono internally)\n"
-            "  Output WAV: mono 16-bit PCM @ %d Hz\n\n"
-            "options:\n"
-            "  -h, --help     Show this help\n"
-            "  -v LEVEL       Verbosity: 0=quiet  1=normal (default)  2=verbose\n",
-            RADE_FS, RADE_FS_SPEECH);
-}
-
-/* ---- Main ---- */
-
-int main(int argc, char *argv[]) {
-    int verbose = 1;
-    int opt;
-    static struct option long_options[] = {
-        {"help", no_argument, NULL, 'h'},
-        {NULL,   0,           NULL, 0 }
-    };
-
-    while ((opt = getopt_long(argc, argv, "hv:", long_options, NULL)) != -1) {
-        switch (opt) {
-            case 'h': usage(); return 0;
-            case 'v': verbose = atoi(optarg); break;
-            default:  usage(); return 1;
-        }
-    }
-    if (argc - optind != 2) { usage(); return 1; }
-
+    double      audio_s;    /* length of the input */
+    int         mf_count;   /* modem frames fed to Rx */
+    int         vld_count;  /* valid feature outputs */
+    uint32_t    out_bytes;  /* decoded speech written */
+    std::string callsign;   /* last EOO callsign decoded, if any */
+} demod_result;
+
+/* Stream input_file through Hilbert -> rade_rx() -> FARGAN into
+   output_file.  fargan is scratch state owned by the caller so batch
+   workers can reuse it.  Returns 0 on success. */
+static int demod_file(const char *input_file, const char *output_file, int verbose,
+                      FARGANState *fargan, demod_result *res) {
     EooCallsignDecoder eooCallsignDecoder;
-
-    const char *input_file  = argv[optind];
-    const char *output_file = argv[optind + 1];
-
-    /* ------------------------------------------------------------------ read input WAV */
-    FILE *fin = fopen(input_file, "rb");
-    if (!fin) {
-        fprintf(stderr, "rade_demod: can't open '%s'\n", input_file);
+    *res = demod_result();
+
+    /* ------------------------------------------------------------ open input WAV */
+    rade_wav_reader wav;
+    int wret = rade_wav_open(&wav, input_file);
+    if (wret == -2) {
+        fprintf(stderr, "rade_demod: unsupported WAV format (%d-bit, %d ch) in '%s'\n",
+                wav.bits, wav.channels, input_file);
         return 1;
     }
-
-    wav_info wav;
-    if (wav_read_header(fin, &wav) != 0) {
-        fprintf(stderr, "rade_demod: can't parse '%s' as WAV\n", input_file);
-        fclose(fin);
+    if (wret != 0) {
+        fprintf(stderr, "rade_demod: can't open '%s' as WAV\n", input_file);
         return 1;
     }
     if (verbose >= 1)
         fprintf(stderr, "Input: %s  %d Hz  %d ch  %d-bit %s\n",
-                input_file, wav.sample_rate, wav.num_channels,
-                wav.bits_per_sample, wav.is_float ? "float" : "int");
-
-    long  n_mono = 0;
-    float *mono  = wav_read_mono_float(fin, &wav, &n_mono);
-    fclose(fin);
-    if (!mono) return 1;
-
-    /* --------------------------------------------------------- resample → 8 kHz */
-    long  n_8k   = 0;
-    float *audio;
-    if (wav.sample_rate == RADE_FS) {
-        audio = mono;   /* already at modem rate – no copy needed */
-        n_8k  = n_mono;
-    } else {
-        audio = resample_linear(mono, n_mono, wav.sample_rate, RADE_FS, &n_8k);
-        free(mono);
-        if (!audio) {
-            fprintf(stderr, "rade_demod: resample failed\n");
-            return 1;
-        }
+                input_file, wav.sample_rate, wav.channels,
+                wav.bits, wav.is_float ? "float" : "int");
+
+    long n_mono = (long)wav.frames;
+    Resampler rs;
+    if (!rs.init((unsigned int)wav.sample_rate, RADE_FS)) {
+        fprintf(stderr, "rade_demod: can't resample %d Hz in '%s'\n", wav.sample_rate, input_file);
+        rade_wav_close(&wav);
+        return 1;
     }
+    long n_8k = (long)((double)n_mono * RADE_FS / wav.sample_rate);
+    res->audio_s = (double)n_8k / RADE_FS;
 
     if (verbose >= 1)
         fprintf(stderr, "Modem input: %ld samples @ %d Hz  (%.1f s)\n",
                 n_8k, RADE_FS, (double)n_8k / RADE_FS);
 
-    /* --------------------------------------------------------- Hilbert → IQ */
-    init_hilbert();
-    RADE_COMP *iq = (RADE_COMP *)malloc((size_t)n_8k * sizeof(RADE_COMP));
-    if (!iq) {
-        fprintf(stderr, "rade_demod: malloc failed (IQ buffer)\n");
-        free(audio);
-        return 1;
-    }
-    for (long i = 0; i < n_8k; i++) {
-        iq[i].real = (i >= HILBERT_DELAY) ? audio[i - HILBERT_DELAY] : 0.0f;
-
-        float imag = 0.0f;
-        for (int k = 0; k < HILBERT_NTAPS; k++) {
-            long idx = i - k;
-            if (idx >= 0 && idx < n_8k)
-                imag += hilbert_coeffs[k] * audio[idx];
-        }
-        iq[i].imag = imag;
-    }
-    free(audio);
-
     /* ------------------------------------------------------ open RADE receiver */
-    rade_initialize();
-
     int flags = (verbose < 2) ? RADE_VERBOSE_0 : 0;
-    /* model_name is ignored in the nopy build (built-in weights) */
-    const char *model_name = "model19_check3/checkpoints/checkpoint_epoch_100.pth";
-    struct rade *r = rade_open((char *)model_name, flags);
+    /* built-in weights */
+    struct rade *r = rade_open_rx_only(NULL, flags);
     if (!r) {
         fprintf(stderr, "rade_demod: rade_open failed\n");
-        free(iq);
-        rade_finalize();
+        rade_wav_close(&wav);
         return 1;
     }
 
@@ -352,19 +137,19 @@ int main(int argc, char *argv[]) {
     int n_features_out = rade_n_features_in_out(r);
     int n_eoo_bits     = rade_n_eoo_bits(r);
 
-    RADE_COMP *rx_buf     = (RADE_COMP *)malloc((size_t)nin_max        * sizeof(RADE_COMP));
-    float     *feat_buf   = (float *)   malloc((size_t)n_features_out * sizeof(float));
-    float     *eoo_buf    = (float *)   malloc((size_t)n_eoo_bits      * sizeof(float));
-    if (!rx_buf || !feat_buf || !eoo_buf) {
-        fprintf(stderr, "rade_demod: malloc failed\n");
-        free(iq); free(rx_buf); free(feat_buf); free(eoo_buf);
-        rade_close(r); rade_finalize();
-        return 1;
-    }
+    std::vector<float>     mono(DEMOD_CHUNK);
+    std::vector<float>     audio((size_t)rs.max_output(DEMOD_CHUNK));  /* 8 kHz */
+    std::vector<RADE_COMP> iq;             /* 8 kHz IQ waiting for rade_rx() */
+    std::vector<float>     feat_buf((size_t)n_features_out);
+    std::vector<float>     eoo_buf((size_t)n_eoo_bits);
+    std::vector<RADE_COMP> rx_buf((size_t)nin_max);
+    size_t iq_pos = 0;
+
+    rade_hilbert hb;
+    rade_hilbert_init(&hb);
 
-    /* ------------------------------------------------- open FARGAN vocoder */
-    FARGANState fargan;
-    fargan_init(&fargan);
+    /* ------------------------------------------------- reset FARGAN vocoder */
+    fargan_init(fargan);
 
     /* Buffer for the 5-frame warm-up required by fargan_cont().
        Layout: 5 consecutive NB_TOTAL_FEATURES-float frames. */
@@ -373,116 +158,301 @@ int main(int argc, char *argv[]) {
     int   cont_frames   = 0;
 
     /* ---------------------------------------------------- open output WAV */
-    FILE *fout = fopen(output_file, "wb");
-    if (!fout) {
+    rade_wav_writer out;
+    if (rade_wav_create(&out, output_file, RADE_FS_SPEECH) != 0) {
         fprintf(stderr, "rade_demod: can't open '%s' for writing\n", output_file);
-        free(iq); free(rx_buf); free(feat_buf); free(eoo_buf);
-        rade_close(r); rade_finalize();
+        rade_close(r);
+        rade_wav_close(&wav);
         return 1;
     }
-    /* Placeholder header – data_size patched at the end. */
-    wav_write_header(fout, RADE_FS_SPEECH, 0);
     uint32_t total_bytes = 0;
 
     /* ---------------------------------------------------- demodulation loop */
-    long iq_pos    = 0;
-    int  mf_count  = 0;   /* modem frames fed to RX */
-    int  vld_count = 0;   /* valid feature outputs */
-
-    while (iq_pos < n_8k) {
-        int  nin       = rade_nin(r);
-        long remaining = n_8k - iq_pos;
-
-        /* Copy samples into rx_buf; zero-pad the final short block so the
-           last modem frame has a chance to flush. */
-        if (remaining < nin) {
-            memset(rx_buf, 0, (size_t)nin * sizeof(RADE_COMP));
-            memcpy(rx_buf, &iq[iq_pos], (size_t)remaining * sizeof(RADE_COMP));
-            iq_pos = n_8k;
-        } else {
-            memcpy(rx_buf, &iq[iq_pos], (size_t)nin * sizeof(RADE_COMP));
-            iq_pos += nin;
-        }
+    long n_read = 0;
+    int  eof    = 0;
 
-        int has_eoo = 0;
-        int n_out   = rade_rx(r, feat_buf, &has_eoo, eoo_buf, rx_buf);
-        if(has_eoo) {
-            std::string callsign;
-            if(eooCallsignDecoder.decode(eoo_buf, nin, callsign)) {
-                fprintf(stderr, "Callsign = '%s'\n", callsign.c_str());
-            }
-        }
-        if (has_eoo && verbose >= 1)
-            fprintf(stderr, "End-of-over at modem frame %d\n", mf_count);
-
-        if (n_out > 0) {
-            vld_count++;
-            int n_frames = n_out / RADE_NB_TOTAL_FEATURES;
-
-            for (int fi = 0; fi < n_frames; fi++) {
-                float *feat = &feat_buf[fi * RADE_NB_TOTAL_FEATURES];
-
-                /* ---- fargan_cont warm-up: buffer the first 5 frames ---- */
-                if (!fargan_ready) {
-                    memcpy(&cont_buf[cont_frames * RADE_NB_TOTAL_FEATURES],
-                           feat, (size_t)RADE_NB_TOTAL_FEATURES * sizeof(float));
-                    if (++cont_frames >= 5) {
-                        /* fargan_cont expects features packed at stride
-                           NB_FEATURES – copy only the first NB_FEATURES of
-                           each buffered frame, matching lpcnet_demo behaviour. */
-                        float packed[5 * NB_FEATURES];
-                        for (int i = 0; i < 5; i++)
-                            memcpy(&packed[i * NB_FEATURES],
-                                   &cont_buf[i * NB_TOTAL_FEATURES],
-                                   (size_t)NB_FEATURES * sizeof(float));
-
-                        float zeros[FARGAN_CONT_SAMPLES];
-                        memset(zeros, 0, sizeof(zeros));
-                        fargan_cont(&fargan, zeros, packed);
-                        fargan_ready = 1;
-                    }
-                    continue;   /* warm-up frames are not synthesised */
-                }
+    while (!eof) {
+        /* next chunk of input, resampled to 8 kHz and converted to IQ */
+        long n = std::min((long)DEMOD_CHUNK, n_mono - n_read);
+        n = (n > 0) ? rade_wav_read(&wav, mono.data(), n) : 0;
+        n_read += n;
+        eof = (n == 0 || n_read >= n_mono);
 
-                /* ---- synthesise one 10-ms speech frame ---- */
-                float   fpcm[LPCNET_FRAME_SIZE];
-                int16_t pcm[LPCNET_FRAME_SIZE];
+        int n_audio = rs.process(mono.data(), (int)n, audio.data(), (int)audio.size());
 
-                fargan_synthesize(&fargan, fpcm, feat);
+        if (iq_pos > 0) {
+            iq.erase(iq.begin(), iq.begin() + (long)iq_pos);
+            iq_pos = 0;
+        }
+        size_t iq_len = iq.size();
+        iq.resize(iq_len + (size_t)n_audio);
+        rade_hilbert_process(&hb, &iq[iq_len], audio.data(), n_audio);
+
+        while (iq_pos < iq.size()) {
+            int    nin       = rade_nin(r);
+            size_t remaining = iq.size() - iq_pos;
+
+            /* Wait for a whole block, unless the input has run out, when we
+               zero-pad the final short block so the last modem frame has a
+               chance to flush. */
+            if (remaining < (size_t)nin) {
+                if (!eof) break;
+                std::fill(rx_buf.begin(), rx_buf.end(), RADE_COMP{0.0f, 0.0f});
+                memcpy(rx_buf.data(), &iq[iq_pos], remaining * sizeof(RADE_COMP));
+                iq_pos = iq.size();
+            } else {
+                memcpy(rx_buf.data(), &iq[iq_pos], (size_t)nin * sizeof(RADE_COMP));
+                iq_pos += (size_t)nin;
+            }
 
-                /* float → int16, matching lpcnet_demo rounding */
-                for (int s = 0; s < LPCNET_FRAME_SIZE; s++) {
-                    float v = fpcm[s] * 32768.0f;
-                    if (v >  32767.0f)  v =  32767.0f;
-                    if (v < -32767.0f)  v = -32767.0f;
-                    pcm[s] = (int16_t)floor(0.5 + (double)v);
+            int has_eoo = 0;
+            int n_out   = rade_rx(r, feat_buf.data(), &has_eoo, eoo_buf.data(), rx_buf.data());
+            if (has_eoo) {
+                /* the symbol count, as EooCallsignDecoder::decode() documents
+                   and RadaeDecoder passes: it normalises the RMS the soft
+                   decisions are scaled by */
+                std::string callsign;
+                if (eooCallsignDecoder.decode(eoo_buf.data(), n_eoo_bits / 2, callsign)) {
+                    if (verbose >= 1)
+                        fprintf(stderr, "Callsign = '%s'\n", callsign.c_str());
+                    res->callsign = callsign;
                 }
+            }
+            if (has_eoo && verbose >= 1)
+                fprintf(stderr, "End-of-over at modem frame %d\n", res->mf_count);
+
+            if (n_out > 0) {
+                res->vld_count++;
+                int n_frames = n_out / RADE_NB_TOTAL_FEATURES;
+
+                for (int fi = 0; fi < n_frames; fi++) {
+                    float *feat = &feat_buf[(size_t)fi * RADE_NB_TOTAL_FEATURES];
+
+                    /* ---- fargan_cont warm-up: buffer the first 5 frames ---- */
+                    if (!fargan_ready) {
+                        memcpy(&cont_buf[cont_frames * RADE_NB_TOTAL_FEATURES],
+                               feat, (size_t)RADE_NB_TOTAL_FEATURES * sizeof(float));
+                        if (++cont_frames >= 5) {
+                            /* fargan_cont expects features packed at stride
+                               NB_FEATURES – copy only the first NB_FEATURES of
+                               each buffered frame, matching lpcnet_demo behaviour. */
+                            float packed[5 * NB_FEATURES];
+                            for (int i = 0; i < 5; i++)
+                                memcpy(&packed[i * NB_FEATURES],
+                                       &cont_buf[i * NB_TOTAL_FEATURES],
+                                       (size_t)NB_FEATURES * sizeof(float));
+
+                            float zeros[FARGAN_CONT_SAMPLES];
+                            memset(zeros, 0, sizeof(zeros));
+                            fargan_cont(fargan, zeros, packed);
+                            fargan_ready = 1;
+                        }
+                        continue;   /* warm-up frames are not synthesised */
+                    }
 
-                fwrite(pcm, sizeof(int16_t), (size_t)LPCNET_FRAME_SIZE, fout);
-                total_bytes += (uint32_t)(LPCNET_FRAME_SIZE * (int)sizeof(int16_t));
+                    /* ---- synthesise one 10-ms speech frame ---- */
+                    float fpcm[LPCNET_FRAME_SIZE];
+                    fargan_synthesize(fargan, fpcm, feat);
+                    /* float → int16, matching lpcnet_demo rounding */
+                    rade_wav_write(&out, fpcm, LPCNET_FRAME_SIZE, 32768.0f);
+                    total_bytes += (uint32_t)(LPCNET_FRAME_SIZE * (int)sizeof(int16_t));
+                }
             }
+            res->mf_count++;
         }
-        mf_count++;
     }
+    rade_wav_close(&wav);
 
     /* -------------------------------------------------------- finalise WAV */
-    fseek(fout, 0, SEEK_SET);
-    wav_write_header(fout, RADE_FS_SPEECH, total_bytes);
-    fclose(fout);
+    if (rade_wav_finish(&out) != 0) {
+        fprintf(stderr, "rade_demod: error writing '%s'\n", output_file);
+        rade_close(r);
+        return 1;
+    }
+    res->out_bytes = total_bytes;
 
     /* ------------------------------------------------------------ summary */
     if (verbose >= 1) {
-        fprintf(stderr, "Modem frames: %d   valid: %d\n", mf_count, vld_count);
+        fprintf(stderr, "Modem frames: %d   valid: %d\n", res->mf_count, res->vld_count);
         fprintf(stderr, "Output: %s  %.1f s  (%u bytes)\n",
                 output_file, (double)total_bytes / (2.0 * RADE_FS_SPEECH), total_bytes);
     }
 
-    /* -----------------------------------------------------------  cleanup */
-    free(iq);
-    free(rx_buf);
-    free(feat_buf);
-    free(eoo_buf);
     rade_close(r);
-    rade_finalize();
     return 0;
 }
+
+/* ---- Batch mode ---- */
+
+namespace fs = std::filesystem;
+
+static bool is_wav(const fs::path &p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".wav";
+}
+
+/* Expand the command line into input files: a directory means every .wav
+   file in it, @list a text file with one path per line, anything else is
+   taken as a file */
+static bool collect_inputs(int argc, char *argv[], std::vector<std::string> &inputs) {
+    for (int i = 0; i < argc; i++) {
+        std::string arg = argv[i];
+        std::error_code ec;
+        if (arg.size() > 1 && arg[0] == '@') {
+            std::ifstream list(arg.substr(1));
+            if (!list) {
+                fprintf(stderr, "rade_demod: can't open file list '%s'\n", arg.c_str() + 1);
+                return false;
+            }
+            std::string line;
+            while (std::getline(list, line)) {
+                while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+                if (!line.empty() && line[0] != '#') inputs.push_back(line);
+            }
+        } else if (fs::is_directory(arg, ec)) {
+            std::vector<std::string> dir;
+            for (const auto &e : fs::directory_iterator(arg, ec))
+                if (e.is_regular_file(ec) && is_wav(e.path())) dir.push_back(e.path().string());
+            std::sort(dir.begin(), dir.end());
+            inputs.insert(inputs.end(), dir.begin(), dir.end());
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    return true;
+}
+
+static int demod_batch(const std::vector<std::string> &inputs, const std::string &out_dir,
+                       int n_threads) {
+    /* outputs are named after the inputs, so two inputs with the same name
+       would overwrite each other */
+    std::vector<std::string> outputs;
+    std::set<std::string> names;
+    for (const auto &in : inputs) {
+        std::string name = fs::path(in).stem().string() + ".wav";
+        if (!names.insert(name).second) {
+            fprintf(stderr, "rade_demod: more than one input named '%s'\n", name.c_str());
+            return 1;
+        }
+        outputs.push_back((fs::path(out_dir) / name).string());
+    }
+    std::error_code ec;
+    fs::create_directories(out_dir, ec);
+
+    if (n_threads < 1) n_threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    n_threads = std::min(n_threads, (int)inputs.size());
+
+    std::atomic<size_t> next{0};
+    std::atomic<int>    n_failed{0};
+    std::mutex          mtx;        /* stderr and the totals below */
+    double              audio_s = 0.0;
+    size_t              n_done  = 0;
+
+    auto t_start = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        /* one vocoder per worker, re-used for each file it decodes */
+        FARGANState *fargan = new FARGANState;
+        for (size_t k; (k = next.fetch_add(1)) < inputs.size(); ) {
+            demod_result res;
+            int ret = demod_file(inputs[k].c_str(), outputs[k].c_str(), 0, fargan, &res);
+
+            std::lock_guard<std::mutex> lock(mtx);
+            n_done++;
+            if (ret != 0) {
+                n_failed++;
+                fprintf(stderr, "[%zu/%zu] %s: FAILED\n", n_done, inputs.size(), inputs[k].c_str());
+                continue;
+            }
+            audio_s += res.audio_s;
+            fprintf(stderr, "[%zu/%zu] %s: %.1f s  valid: %d/%d%s%s\n",
+                    n_done, inputs.size(), inputs[k].c_str(), res.audio_s,
+                    res.vld_count, res.mf_count,
+                    res.callsign.empty() ? "" : "  callsign: ", res.callsign.c_str());
+        }
+        delete fargan;
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < n_threads; i++) pool.emplace_back(worker);
+    for (auto &t : pool) t.join();
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    fprintf(stderr, "Decoded %zu files (%d failed) on %d threads: %.1f s of audio in %.1f s, "
+                    "%.1f audio-s/wall-s\n",
+            inputs.size() - (size_t)n_failed.load(), n_failed.load(), n_threads,
+            audio_s, wall_s, wall_s > 0.0 ? audio_s / wall_s : 0.0);
+
+    return n_failed.load() ? 1 : 0;
+}
+
+/* ---- Usage ---- */
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: rade_demod [options] <input.wav> <output.wav>\n"
+            "       rade_demod [options] -b OUTDIR <input.wav|dir|@list>...\n\n"
+            "  Reads a WAV file containing received RADE OFDM audio and writes\n"
+            "  a WAV file containing the decoded voice audio.\n\n"
+            "  Input WAV : any sample rate, mono or stereo\n"
+            "              (resampled to %d Hz / mixed to mono internally)\n"
+            "  Output WAV: mono 16-bit PCM @ %d Hz\n\n"
+            "options:\n"
+            "  -h, --help     Show this help\n"
+            "  -v LEVEL       Verbosity: 0=quiet  1=normal (default)  2=verbose\n"
+            "  -b OUTDIR      Batch mode: decode every input (a file, every .wav in\n"
+            "                 a directory, or each path listed in @list) to\n"
+            "                 OUTDIR/<name>.wav, several files at a time\n"
+            "  -j THREADS     Batch mode worker threads (default: one per core)\n",
+            RADE_FS, RADE_FS_SPEECH);
+}
+
+/* ---- Main ---- */
+
+int main(int argc, char *argv[]) {
+    int verbose = 1;
+    int n_threads = 0;
+    const char *batch_dir = NULL;
+    int opt;
+    static struct option long_options[] = {
+        {"help", no_argument, NULL, 'h'},
+        {NULL,   0,           NULL, 0 }
+    };
+
+    while ((opt = getopt_long(argc, argv, "hv:b:j:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'h': usage(); return 0;
+            case 'v': verbose = atoi(optarg); break;
+            case 'b': batch_dir = optarg; break;
+            case 'j': n_threads = atoi(optarg); break;
+            default:  usage(); return 1;
+        }
+    }
+
+    rade_initialize();
+    int ret;
+
+    if (batch_dir) {
+        std::vector<std::string> inputs;
+        if (argc - optind < 1 || !collect_inputs(argc - optind, &argv[optind], inputs)) {
+            usage();
+            rade_finalize();
+            return 1;
+        }
+        if (inputs.empty()) {
+            fprintf(stderr, "rade_demod: no input files\n");
+            rade_finalize();
+            return 1;
+        }
+        ret = demod_batch(inputs, batch_dir, n_threads);
+    } else {
+        if (argc - optind != 2) { usage(); rade_finalize(); return 1; }
+
+        FARGANState fargan;
+        demod_result res;
+        ret = demod_file(argv[optind], argv[optind + 1], verbose, &fargan, &res);
+    }
+
+    rade_finalize();
+    return ret;
+}
@@ -0,0 +1,228 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_int8_check.cpp
+
+  Quality regression check for the int8 quantised network weights.  Runs
+  the encoder and decoder over the features of a speech WAV file with the
+  float and the int8 weights, and reports the feature MSE of each against
+  the input.  Exits non zero if int8 is worse than float by more than a
+  tolerance.
+
+\*---------------------------------------------------------------------------*/
+
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <getopt.h>
+#include <vector>
+
+#include "resampler.h"
+
+extern "C" {
+#include "rade_api.h"
+#include "rade_dsp.h"
+#include "rade_kernels.h"
+#include "rade_wav.h"
+#include "rade_enc.h"
+#include "rade_dec.h"
+#include "rade_weights.h"
+#include "lpcnet.h"
+#include "cpu_support.h"
+}
+
+/* ---- WAV input, mixed to mono ---- */
+
+static bool wav_read_mono(const char *path, std::vector<float> &out, int *sample_rate) {
+    rade_wav_reader w;
+    if (rade_wav_open(&w, path) != 0) return false;
+    out.resize((size_t)w.frames);
+    out.resize((size_t)rade_wav_read(&w, out.data(), (long)out.size()));
+    *sample_rate = w.sample_rate;
+    rade_wav_close(&w);
+    return !out.empty();
+}
+
+/* ---- Encoder -> decoder over the whole file, no channel ---- */
+
+static void run_model(const RADEEnc *enc_model, const RADEDec *dec_model, int arch,
+                      const std::vector<float> &enc_features, int n_steps,
+                      std::vector<float> &z, std::vector<float> &dec_features) {
+    const int enc_in = RADE_FRAMES_PER_STEP * RADE_NUM_FEATURES_AUX;
+    z.assign((size_t)n_steps * RADE_LATENT_DIM, 0.0f);
+    dec_features.assign((size_t)n_steps * enc_in, 0.0f);
+
+    static RADEEncState es;
+    static RADEDecState ds;
+    rade_init_encoder(&es);
+    rade_init_decoder(&ds);
+    for (int c = 0; c < n_steps; c++) {
+        rade_core_encoder(&es, enc_model, &z[(size_t)c * RADE_LATENT_DIM],
+                          &enc_features[(size_t)c * enc_in], arch, 3);
+        rade_core_decoder(&ds, dec_model, &dec_features[(size_t)c * enc_in],
+                          &z[(size_t)c * RADE_LATENT_DIM], arch);
+    }
+}
+
+/* MSE of the RADE_NUM_FEATURES vocoder features of each frame, skipping the
+   aux symbol.  lag delays b against a, the decoder output trails the input */
+static double feature_mse(const std::vector<float> &a, const std::vector<float> &b,
+                          int n_frames, int lag) {
+    double sum = 0.0;
+    long n = 0;
+    for (int i = 0; i + lag < n_frames; i++) {
+        const float *x = &a[(size_t)i * RADE_NUM_FEATURES_AUX];
+        const float *y = &b[(size_t)(i + lag) * RADE_NUM_FEATURES_AUX];
+        for (int k = 0; k < RADE_NUM_FEATURES; k++) {
+            double e = (double)x[k] - y[k];
+            sum += e * e;
+            n++;
+        }
+    }
+    return n ? sum / n : 0.0;
+}
+
+static double vec_mse(const std::vector<float> &a, const std::vector<float> &b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        double e = (double)a[i] - b[i];
+        sum += e * e;
+    }
+    return a.empty() ? 0.0 : sum / a.size();
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: rade_int8_check [-i speech.wav] [-t tol] [-l lag]\n");
+    fprintf(stderr, "  -i  speech to extract the features from (default voice.wav)\n");
+    fprintf(stderr, "  -t  fail if int8 feature MSE > float MSE * (1 + tol) (default 0.05)\n");
+    fprintf(stderr, "  -l  decoder output lag in feature frames when comparing (default 0)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *wav_path = "voice.wav";
+    double tol = 0.05;
+    int lag = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "hi:t:l:")) != -1) {
+        switch (opt) {
+            case 'i': wav_path = optarg; break;
+            case 't': tol = atof(optarg); break;
+            case 'l': lag = atoi(optarg); break;
+            case 'h': usage(); return 0;
+            default:  usage(); return 1;
+        }
+    }
+    if (lag < 0) lag = 0;
+
+    int arch = opus_select_arch();
+
+    std::vector<float> speech;
+    int wav_rate = 0;
+    if (!wav_read_mono(wav_path, speech, &wav_rate)) {
+        fprintf(stderr, "rade_int8_check: can't read WAV '%s'\n", wav_path);
+        return 1;
+    }
+    if (wav_rate != RADE_FS_SPEECH) {
+        speech = Resampler::convert(speech, (unsigned)wav_rate, RADE_FS_SPEECH);
+    }
+
+    int n_steps = (int)(speech.size() / (LPCNET_FRAME_SIZE * RADE_FRAMES_PER_STEP));
+    if (n_steps < 1) {
+        fprintf(stderr, "rade_int8_check: '%s' is too short\n", wav_path);
+        return 1;
+    }
+    int n_ff = n_steps * RADE_FRAMES_PER_STEP;
+
+    std::vector<int16_t> pcm((size_t)n_ff * LPCNET_FRAME_SIZE);
+    rade_kernels_get()->float_to_s16(pcm.data(), speech.data(), 32768.0f, (int)pcm.size());
+
+    LPCNetEncState *lpcnet = lpcnet_encoder_create();
+    if (!lpcnet) {
+        fprintf(stderr, "rade_int8_check: lpcnet_encoder_create failed\n");
+        return 1;
+    }
+
+    /* Encoder input, [frame][21] with the aux data symbol, as rade_tx() builds it */
+    std::vector<float> enc_features((size_t)n_ff * RADE_NUM_FEATURES_AUX);
+    for (int i = 0; i < n_ff; i++) {
+        float f[RADE_NB_TOTAL_FEATURES];
+        lpcnet_compute_single_frame_features(lpcnet, &pcm[(size_t)i * LPCNET_FRAME_SIZE], f, arch);
+        float *dst = &enc_features[(size_t)i * RADE_NUM_FEATURES_AUX];
+        memcpy(dst, f, sizeof(float) * RADE_NUM_FEATURES);
+        dst[RADE_NUM_FEATURES] = -1.0f;
+    }
+    lpcnet_encoder_destroy(lpcnet);
+
+    /* Same tables, with and without the float weights */
+    static RADEEnc enc_float, enc_int8;
+    static RADEDec dec_float, dec_int8;
+    WeightArray *enc_arrays_int8 = rade_weights_int8(radeenc_arrays);
+    WeightArray *dec_arrays_int8 = rade_weights_int8(radedec_arrays);
+    const int n_in = RADE_NUM_FEATURES_AUX * RADE_FRAMES_PER_STEP;
+    if (enc_arrays_int8 == NULL || dec_arrays_int8 == NULL ||
+        init_radeenc(&enc_float, radeenc_arrays, n_in) != 0 ||
+        init_radedec(&dec_float, radedec_arrays, n_in) != 0 ||
+        init_radeenc(&enc_int8, enc_arrays_int8, n_in) != 0 ||
+        init_radedec(&dec_int8, dec_arrays_int8, n_in) != 0) {
+        fprintf(stderr, "rade_int8_check: failed to initialise model weights\n");
+        return 1;
+    }
+    free(enc_arrays_int8);
+    free(dec_arrays_int8);
+
+    long bytes_float = rade_weights_bytes(radeenc_arrays, 0) + rade_weights_bytes(radedec_arrays, 0);
+    long bytes_int8  = rade_weights_bytes(radeenc_arrays, 1) + rade_weights_bytes(radedec_arrays, 1);
+    if (bytes_float == bytes_int8) {
+        fprintf(stderr, "rade_int8_check: no float weights in this build, comparing int8 with itself\n");
+    }
+
+    std::vector<float> z_float, z_int8, out_float, out_int8;
+    run_model(&enc_float, &dec_float, arch, enc_features, n_steps, z_float, out_float);
+    run_model(&enc_int8, &dec_int8, arch, enc_features, n_steps, z_int8, out_int8);
+
+    double mse_float = feature_mse(enc_features, out_float, n_ff, lag);
+    double mse_int8  = feature_mse(enc_features, out_int8, n_ff, lag);
+    double mse_cross = feature_mse(out_float, out_int8, n_ff, 0);
+    double z_cross   = vec_mse(z_float, z_int8);
+
+    printf("frames          %d (%.1f s)\n", n_ff, n_ff * (double)LPCNET_FRAME_SIZE / RADE_FS_SPEECH);
+    printf("weights         float %.2f MB  int8 %.2f MB\n", bytes_float / 1E6, bytes_int8 / 1E6);
+    printf("feature MSE     float %.5f  int8 %.5f  (%+.1f%%)\n", mse_float, mse_int8,
+           mse_float > 0.0 ? 100.0 * (mse_int8 / mse_float - 1.0) : 0.0);
+    printf("int8 vs float   latent MSE %.6f  feature MSE %.6f\n", z_cross, mse_cross);
+
+    bool pass = mse_int8 <= mse_float * (1.0 + tol);
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_iq_replay.c
+
+  Runs the receiver on an IQ capture (see rade_iq.h) as fast as the CPU
+  allows, straight from the mapped file, and reports the throughput and
+  per-stage times.  The features can be written out, or compared against
+  an earlier run's, so a change to the Rx DSP is checked on exactly the
+  samples a live receiver saw.
+
+  usage: rade_iq_replay [options] capture.iq
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "rade_api.h"
+#include "rade_dsp.h"
+#include "rade_iq.h"
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1E-9 * ts.tv_nsec;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: rade_iq_replay [options] capture.iq\n");
+    fprintf(stderr, "  -h, --help              Show this help\n");
+    fprintf(stderr, "  --model_name FILE       Weights blob (default built-in weights)\n");
+    fprintf(stderr, "  -8                      int8 network weights\n");
+    fprintf(stderr, "  -n PASSES               Decode the capture PASSES times, for timing (default 1)\n");
+    fprintf(stderr, "  -o FILE                 Write the features (float32) of the first pass\n");
+    fprintf(stderr, "  -c FILE                 Compare the features against FILE, exit 1 if they differ\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Every pass starts a fresh receiver, so passes are identical.  A capture\n");
+    fprintf(stderr, "is recorded with radae_headless --iq-capture, and replayed with the\n");
+    fprintf(stderr, "warm re-acquire, acquisition threads and load shedding it recorded.\n");
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    char *model_name = NULL;
+    int flags = RADE_VERBOSE_0;
+    int passes = 1;
+    const char *out_name = NULL;
+    const char *ref_name = NULL;
+
+    static struct option long_options[] = {
+        {"help",       no_argument,       NULL, 'h'},
+        {"model_name", required_argument, NULL, 'm'},
+        {NULL,         0,                 NULL, 0}
+    };
+
+    while ((opt = getopt_long(argc, argv, "h8n:o:c:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'm': model_name = optarg; break;
+            case '8': flags |= RADE_INT8_WEIGHTS; break;
+            case 'n': passes = atoi(optarg); break;
+            case 'o': out_name = optarg; break;
+            case 'c': ref_name = optarg; break;
+            case 'h': usage(); return 0;
+            default:  usage(); return 1;
+        }
+    }
+    if (optind != argc - 1 || passes < 1) {
+        usage();
+        return 1;
+    }
+
+    rade_iq_file iq;
+    if (rade_iq_map(&iq, argv[optind]) != 0) {
+        fprintf(stderr, "rade_iq_replay: can't read IQ capture %s\n", argv[optind]);
+        return 1;
+    }
+    if (iq.header->rade_version != (uint32_t)rade_version()) {
+        fprintf(stderr, "rade_iq_replay: recorded with API version %u, this is %d\n",
+                iq.header->rade_version, rade_version());
+    }
+    float warm_s = iq.header->warm_reacquire;
+    int acq_threads = (int)iq.header->acq_threads;
+    if (warm_s > 0.0f || acq_threads > 1) {
+        fprintf(stderr, "rade_iq_replay: warm re-acquire %.1f s, %d acquisition threads\n",
+                warm_s, acq_threads > 1 ? acq_threads : 1);
+    }
+
+    FILE *fout = NULL, *fref = NULL;
+    if (out_name && (fout = fopen(out_name, "wb")) == NULL) {
+        fprintf(stderr, "rade_iq_replay: can't create %s\n", out_name);
+        return 1;
+    }
+    if (ref_name && (fref = fopen(ref_name, "rb")) == NULL) {
+        fprintf(stderr, "rade_iq_replay: can't open %s\n", ref_name);
+        return 1;
+    }
+
+    rade_initialize();
+
+    /* Opened once up front so the buffers can be sized, and for the model
+       load message; each pass then gets its own context */
+    struct rade *r = rade_open_rx_only(model_name, flags);
+    if (r == NULL) {
+        fprintf(stderr, "rade_iq_replay: failed to open RADE\n");
+        return 1;
+    }
+    int nin_max = rade_nin_max(r);
+    int n_features_out = rade_n_features_in_out(r);
+    int n_eoo_bits = rade_n_eoo_bits(r);
+    rade_close(r);
+
+    /* rade_rx() takes a non-const rx_in, so each frame is copied out of the
+       read only mapping; a few kB per 120 ms frame is lost in the noise */
+    RADE_COMP *rx_in = (RADE_COMP *)malloc(sizeof(RADE_COMP) * nin_max);
+    float *features_out = (float *)malloc(sizeof(float) * n_features_out);
+    float *features_ref = (float *)malloc(sizeof(float) * n_features_out);
+    float *eoo_out = (float *)malloc(sizeof(float) * n_eoo_bits);
+    if (rx_in == NULL || features_out == NULL || features_ref == NULL || eoo_out == NULL) {
+        fprintf(stderr, "rade_iq_replay: out of memory\n");
+        return 1;
+    }
+
+    long frames = 0, valid = 0, eoo = 0, nin_mismatch = 0, samples = 0;
+    long ref_frames = 0;
+    float max_diff = 0.0f;
+    int ref_short = 0;
+    struct rade_stage_stats st[RADE_NSTAGES];
+    int have_st[RADE_NSTAGES] = {0};
+    double t_rx = 0.0;
+
+    for (int pass = 0; pass < passes; pass++) {
+        r = rade_open_rx_only(model_name, flags);
+        if (r == NULL) {
+            fprintf(stderr, "rade_iq_replay: failed to open RADE\n");
+            return 1;
+        }
+        if (acq_threads > 1) rade_set_acq_threads(r, acq_threads);
+        if (warm_s > 0.0f) rade_set_warm_reacquire(r, warm_s);
+        rade_iq_rewind(&iq);
+        int load_shed = 0;
+
+        int nin;
+        const RADE_COMP *rec;
+        double t_start = now_s();
+        while ((rec = rade_iq_next(&iq, &nin)) != NULL) {
+            /* The receiver is deterministic, so on the same build it asks
+               for what the live one did.  If not (e.g. a change to the
+               timing loop), feed the recorded frame anyway and count it */
+            if (nin != rade_nin(r)) nin_mismatch += pass == 0;
+            if (nin > nin_max) nin = nin_max;
+            memcpy(rx_in, rec, sizeof(RADE_COMP) * nin);
+            if (iq.load_shed != load_shed) {
+                load_shed = iq.load_shed;
+                rade_set_load_shed(r, load_shed);
+            }
+
+            int has_eoo = 0;
+            int n_out = rade_rx(r, features_out, &has_eoo, eoo_out, rx_in);
+            if (pass != 0) {
+                continue;
+            }
+
+            frames++;
+            samples += nin;
+            eoo += has_eoo != 0;
+            if (n_out <= 0) {
+                continue;
+            }
+            valid++;
+            if (fout) {
+                fwrite(features_out, sizeof(float), n_out, fout);
+            }
+            if (fref && !ref_short) {
+                if (fread(features_ref, sizeof(float), n_out, fref) != (size_t)n_out) {
+                    ref_short = 1;
+                    continue;
+                }
+                ref_frames++;
+                for (int i = 0; i < n_out; i++) {
+                    float d = fabsf(features_out[i] - features_ref[i]);
+                    if (d > max_diff || isnan(d)) max_diff = isnan(d) ? INFINITY : d;
+                }
+            }
+        }
+        t_rx += now_s() - t_start;
+
+        if (pass == passes - 1) {
+            for (int s = 0; s < RADE_NSTAGES; s++) {
+                have_st[s] = rade_get_stage_stats(r, s, &st[s]) == 0 && st[s].count > 0;
+            }
+        }
+        rade_close(r);
+    }
+
+    double audio_s = (double)samples / RADE_FS;
+    double per_pass = t_rx / passes;
+    printf("%s: %ld frames (%.1f s), %ld valid, %ld EOO, %ld nin mismatches\n",
+           argv[optind], frames, audio_s, valid, eoo, nin_mismatch);
+    printf("rade_rx: %.3f s per pass, %.2f ms/frame, rtf %.4f (%.0fx real time), %d passes\n",
+           per_pass, frames ? 1E3 * per_pass / frames : 0.0,
+           audio_s > 0.0 ? per_pass / audio_s : 0.0,
+           per_pass > 0.0 ? audio_s / per_pass : 0.0, passes);
+    for (int s = 0; s < RADE_NSTAGES; s++) {
+        if (have_st[s]) {
+            printf("  %-12s p50 %8.1f us  p99 %8.1f us  max %8.1f us  mean %8.1f us\n",
+                   rade_stage_name(s), st[s].p50_us, st[s].p99_us, st[s].max_us, st[s].mean_us);
+        }
+    }
+
+    int fail = 0;
+    if (fref) {
+        float extra;
+        if (!ref_short && fread(&extra, sizeof(float), 1, fref) == 1) {
+            ref_short = -1;
+        }
+        printf("compare %s: %ld frames, max abs diff %.3g%s\n", ref_name, ref_frames, max_diff,
+               ref_short > 0 ? ", reference is shorter" : ref_short < 0 ? ", reference is longer" : "");
+        fail = max_diff != 0.0f || ref_short != 0;
+        fclose(fref);
+    }
+    if (fout) {
+        fclose(fout);
+    }
+
+    free(rx_in);
+    free(features_out);
+    free(features_ref);
+    free(eoo_out);
+    rade_iq_unmap(&iq);
+    rade_finalize();
+
+    return fail;
+}
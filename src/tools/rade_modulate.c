@@ -7,7 +7,8 @@
   to rade_demod.
 
   Combines LPCNet feature extraction and radae_tx (RADE encoder + OFDM
-  modulation) into a single command-line tool.
+  modulation) into a single command-line tool.  With -b it encodes a
+  batch of files on a pool of worker threads.
 
 \*---------------------------------------------------------------------------*/
 
@@ -45,285 +46,108 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdint.h>
 #include <math.h>
+#include <errno.h>
+#include <time.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "rade_api.h"
 #include "rade_dsp.h"
+#include "rade_kernels.h"
+#include "rade_wav.h"
+#include "resampler_c.h"
 #include "lpcnet.h"
 #include "arch.h"
 #include "cpu_support.h"
 
-/* ---- WAV file I/O ---- */
-
-#define WAV_FMT_PCM   1
-#define WAV_FMT_FLOAT 3
-
-typedef struct {
-    int      sample_rate;
-    int      num_channels;
-    int      bits_per_sample;
-    int      is_float;          /* 1 if IEEE float format */
-    long     data_offset;       /* byte offset of audio data in file */
-    uint32_t data_size;         /* byte count of audio data */
-} wav_info;
-
-/* Parse WAV header.  On success the file position is at the first audio byte. */
-static int wav_read_header(FILE *f, wav_info *info) {
-    char     tag[4];
-    uint32_t riff_size;
-
-    if (fread(tag, 1, 4, f) != 4 || memcmp(tag, "RIFF", 4)) return -1;
-    if (fread(&riff_size, 4, 1, f) != 1) return -1;
-    if (fread(tag, 1, 4, f) != 4 || memcmp(tag, "WAVE", 4)) return -1;
-
-    info->data_offset = -1;
-
-    while (1) {
-        char     chunk_id[4];
-        uint32_t chunk_size;
-        if (fread(chunk_id, 1, 4, f) != 4) break;
-        if (fread(&chunk_size, 4, 1, f) != 1) break;
-
-        if (memcmp(chunk_id, "fmt ", 4) == 0) {
-            if (chunk_size < 16) return -1;
-            uint8_t buf[16];
-            if (fread(buf, 1, 16, f) != 16) return -1;
-
-            uint16_t audio_fmt, nch, bps;
-            uint32_t sr;
-            memcpy(&audio_fmt, buf + 0,  2);
-            memcpy(&nch,       buf + 2,  2);
-            memcpy(&sr,        buf + 4,  4);
-            memcpy(&bps,       buf + 14, 2);
-
-            info->sample_rate     = (int)sr;
-            info->num_channels    = (int)nch;
-            info->bits_per_sample = (int)bps;
-            info->is_float        = (audio_fmt == WAV_FMT_FLOAT);
-
-            if (chunk_size > 16)
-                fseek(f, (long)(chunk_size - 16), SEEK_CUR);
-
-        } else if (memcmp(chunk_id, "data", 4) == 0) {
-            info->data_offset = ftell(f);
-            info->data_size   = chunk_size;
-            break;
-        } else {
-            /* skip unknown chunk (pad to even byte boundary) */
-            fseek(f, (long)((chunk_size + 1) & ~1u), SEEK_CUR);
-        }
-    }
-    return (info->data_offset >= 0) ? 0 : -1;
-}
-
-/* Read the entire audio payload into a mono float buffer.
-   Multi-channel input is mixed down by averaging.  Caller must free(). */
-static float *wav_read_mono_float(FILE *f, const wav_info *info, long *n_out) {
-    int   bps  = info->bits_per_sample;
-    int   nch  = info->num_channels;
-    long  total = (long)info->data_size / (bps / 8);
-    long  mono  = total / nch;
-
-    float *buf = malloc((size_t)mono * sizeof(float));
-    if (!buf) return NULL;
-
-    for (long i = 0; i < mono; i++) {
-        float sum = 0.0f;
-        for (int ch = 0; ch < nch; ch++) {
-            float v = 0.0f;
-            if (info->is_float && bps == 32) {
-                float tmp;  fread(&tmp, 4, 1, f);  v = tmp;
-            } else if (info->is_float && bps == 64) {
-                double tmp; fread(&tmp, 8, 1, f);  v = (float)tmp;
-            } else if (bps == 16) {
-                int16_t tmp; fread(&tmp, 2, 1, f); v = tmp / 32768.0f;
-            } else if (bps == 24) {
-                uint8_t b[3]; fread(b, 1, 3, f);
-                int32_t raw = ((int32_t)b[2] << 16) | (b[1] << 8) | b[0];
-                if (raw & 0x800000) raw |= (int32_t)0xFF000000;
-                v = raw / 8388608.0f;
-            } else if (bps == 32) {
-                int32_t tmp; fread(&tmp, 4, 1, f); v = tmp / 2147483648.0f;
-            } else {
-                fprintf(stderr, "rade_modulate: unsupported WAV format (%d-bit %s)\n",
-                        bps, info->is_float ? "float" : "int");
-                free(buf);
-                return NULL;
-            }
-            sum += v;
-        }
-        buf[i] = sum / nch;
-    }
-    *n_out = mono;
-    return buf;
-}
-
-/* Write a standard 44-byte PCM WAV header (16-bit, mono). */
-static void wav_write_header(FILE *f, int sample_rate, uint32_t data_bytes) {
-    uint16_t nch         = 1;
-    uint16_t bps         = 16;
-    uint16_t fmt         = WAV_FMT_PCM;
-    uint32_t fmt_size    = 16;
-    uint16_t block_align = (uint16_t)(nch * bps / 8);
-    uint32_t byte_rate   = (uint32_t)sample_rate * block_align;
-    uint32_t riff_size   = 36 + data_bytes;
-    uint32_t sr          = (uint32_t)sample_rate;
-
-    fwrite("RIFF",       1, 4, f);  fwrite(&riff_size,   4, 1, f);
-    fwrite("WAVE",       1, 4, f);
-    fwrite("fmt ",       1, 4, f);  fwrite(&fmt_size,    4, 1, f);
-    fwrite(&fmt,         2, 1, f);  fwrite(&nch,         2, 1, f);
-    fwrite(&sr,          4, 1, f);  fwrite(&byte_rate,   4, 1, f);
-    fwrite(&block_align, 2, 1, f);  fwrite(&bps,         2, 1, f);
-    fwrite("data",       1, 4, f);  fwrite(&data_bytes,  4, 1, f);
-}
-
-/* ---- Linear-interpolation resampler ---- */
-
-/* Resample *in (n_in samples at in_rate) to out_rate.
-   Returns a malloc'd buffer; caller must free().  Sets *n_out. */
-static float *resample_linear(const float *in, long n_in,
-                              int in_rate, int out_rate, long *n_out) {
-    if (in_rate == out_rate) {
-        float *out = malloc((size_t)n_in * sizeof(float));
-        if (out) memcpy(out, in, (size_t)n_in * sizeof(float));
-        *n_out = n_in;
-        return out;
-    }
-    if (n_in < 2) { *n_out = 0; return malloc(1); }
-
-    *n_out = (long)((double)n_in * out_rate / in_rate);
-    float *out = malloc((size_t)*n_out * sizeof(float));
-    if (!out) return NULL;
-
-    double step = (double)in_rate / (double)out_rate;   /* input samples per output sample */
-    for (long i = 0; i < *n_out; i++) {
-        double pos  = i * step;
-        long   idx  = (long)pos;
-        float  frac = (float)(pos - idx);
-        if (idx + 1 >= n_in) { idx = n_in - 2; frac = 1.0f; }
-        out[i] = in[idx] + frac * (in[idx + 1] - in[idx]);
-    }
-    return out;
-}
+/* Input samples read per chunk, so memory use doesn't depend on file length */
+#define MOD_CHUNK 8192
 
 /* ---- Helper: write the real part of an IQ buffer as 16-bit PCM ---- */
 
-static uint32_t write_iq_real(FILE *f, int16_t *out_buf,
+static uint32_t write_iq_real(rade_wav_writer *w, float *out_buf,
                               const RADE_COMP *iq, int n) {
     for (int i = 0; i < n; i++) {
-        float v = iq[i].real * 32768.0f;
-        if (v >  32767.0f)  v =  32767.0f;
-        if (v < -32767.0f)  v = -32767.0f;
-        out_buf[i] = (int16_t)floor(0.5 + (double)v);
+        out_buf[i] = iq[i].real;
     }
-    fwrite(out_buf, sizeof(int16_t), (size_t)n, f);
+    rade_wav_write(w, out_buf, n, 32768.0f);
     return (uint32_t)(n * (int)sizeof(int16_t));
 }
 
-/* ---- Usage ---- */
+/* ---- Encoding one file ---- */
 
-static void usage(void) {
-    fprintf(stderr,
-            "usage: rade_modulate [options] <input.wav> <output.wav>\n\n"
-            "  Reads a WAV file containing speech audio and writes a WAV\n"
-            "  file containing RADE OFDM encoded audio.\n\n"
-            "  Input WAV : any sample rate, mono or stereo\n"
-            "              (resampled to %d Hz / mixed to mono internally)\n"
-            "  Output WAV: mono 16-bit PCM @ %d Hz (RADE modulated signal)\n\n"
-            "options:\n"
-            "  -h, --help     Show this help\n"
-            "  -v LEVEL       Verbosity: 0=quiet  1=normal (default)  2=verbose\n",
-            RADE_FS_SPEECH, RADE_FS);
+typedef struct {
+    double      audio_s;    /* length of the speech input */
+    double      cpu_s;      /* time spent encoding it */
+    int         mf_count;   /* modem frames transmitted, not counting the EOO */
+    uint32_t    out_bytes;  /* modem signal written */
+} mod_result;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
 }
 
-/* ---- Main ---- */
-
-int main(int argc, char *argv[]) {
-    int verbose = 1;
-    int opt;
-    static struct option long_options[] = {
-        {"help", no_argument, NULL, 'h'},
-        {NULL,   0,           NULL, 0 }
-    };
-
-    while ((opt = getopt_long(argc, argv, "hv:", long_options, NULL)) != -1) {
-        switch (opt) {
-            case 'h': usage(); return 0;
-            case 'v': verbose = atoi(optarg); break;
-            default:  usage(); return 1;
-        }
-    }
-    if (argc - optind != 2) { usage(); return 1; }
-
-    const char *input_file  = argv[optind];
-    const char *output_file = argv[optind + 1];
-
-    /* ------------------------------------------------------------------ read input WAV */
-    FILE *fin = fopen(input_file, "rb");
-    if (!fin) {
-        fprintf(stderr, "rade_modulate: can't open '%s'\n", input_file);
+/* Stream input_file through LPCNet -> rade_tx() into output_file.  net is
+   a feature extractor owned by the caller so batch workers can reuse it;
+   it's reset here.  Each file gets its own transmitter, so the output
+   doesn't depend on what a worker encoded before.  Returns 0 on success. */
+static int mod_file(const char *input_file, const char *output_file, int verbose,
+                    LPCNetEncState *net, mod_result *res) {
+    memset(res, 0, sizeof(*res));
+    double t_start = now_s();
+
+    /* ------------------------------------------------------------------ open input WAV */
+    rade_wav_reader wav;
+    int wret = rade_wav_open(&wav, input_file);
+    if (wret == -2) {
+        fprintf(stderr, "rade_modulate: unsupported WAV format (%d-bit, %d ch) in '%s'\n",
+                wav.bits, wav.channels, input_file);
         return 1;
     }
-
-    wav_info wav;
-    if (wav_read_header(fin, &wav) != 0) {
-        fprintf(stderr, "rade_modulate: can't parse '%s' as WAV\n", input_file);
-        fclose(fin);
+    if (wret != 0) {
+        fprintf(stderr, "rade_modulate: can't open '%s' as WAV\n", input_file);
         return 1;
     }
     if (verbose >= 1)
         fprintf(stderr, "Input: %s  %d Hz  %d ch  %d-bit %s\n",
-                input_file, wav.sample_rate, wav.num_channels,
-                wav.bits_per_sample, wav.is_float ? "float" : "int");
-
-    long  n_mono = 0;
-    float *mono  = wav_read_mono_float(fin, &wav, &n_mono);
-    fclose(fin);
-    if (!mono) return 1;
+                input_file, wav.sample_rate, wav.channels,
+                wav.bits, wav.is_float ? "float" : "int");
 
     /* --------------------------------------------------------- resample → 16 kHz (speech rate) */
-    long  n_16k  = 0;
-    float *audio;
-    if (wav.sample_rate == RADE_FS_SPEECH) {
-        audio = mono;   /* already at speech rate – no copy needed */
-        n_16k = n_mono;
-    } else {
-        audio = resample_linear(mono, n_mono, wav.sample_rate, RADE_FS_SPEECH, &n_16k);
-        free(mono);
-        if (!audio) {
-            fprintf(stderr, "rade_modulate: resample failed\n");
-            return 1;
-        }
+    rade_resampler *rs = rade_resampler_create((unsigned int)wav.sample_rate, RADE_FS_SPEECH);
+    if (!rs) {
+        fprintf(stderr, "rade_modulate: can't resample %d Hz in '%s'\n", wav.sample_rate, input_file);
+        rade_wav_close(&wav);
+        return 1;
     }
+    int  max_16k = rade_resampler_max_output(rs, MOD_CHUNK);
+    long n_16k   = (long)((double)wav.frames * RADE_FS_SPEECH / wav.sample_rate);
+    res->audio_s = (double)n_16k / RADE_FS_SPEECH;
 
     if (verbose >= 1)
         fprintf(stderr, "Speech input: %ld samples @ %d Hz  (%.1f s)\n",
                 n_16k, RADE_FS_SPEECH, (double)n_16k / RADE_FS_SPEECH);
 
-    /* --------------------------------------------------------- init LPCNet feature extractor */
+    /* --------------------------------------------------------- reset LPCNet feature extractor */
     int arch = opus_select_arch();
-    LPCNetEncState *net = lpcnet_encoder_create();
-    if (!net) {
-        fprintf(stderr, "rade_modulate: lpcnet_encoder_create failed\n");
-        free(audio);
-        return 1;
-    }
+    lpcnet_encoder_init(net);
 
     /* ------------------------------------------------------ open RADE transmitter */
-    rade_initialize();
-
     int flags = (verbose < 2) ? RADE_VERBOSE_0 : 0;
-    /* model_name is ignored in the nopy build (built-in weights) */
-    char *model_name = "model19_check3/checkpoints/checkpoint_epoch_100.pth";
-    struct rade *r = rade_open(model_name, flags);
+    /* built-in weights */
+    struct rade *r = rade_open_tx_only(NULL, flags);
     if (!r) {
         fprintf(stderr, "rade_modulate: rade_open failed\n");
-        lpcnet_encoder_destroy(net);
-        free(audio);
-        rade_finalize();
+        rade_resampler_destroy(rs);
+        rade_wav_close(&wav);
         return 1;
     }
 
@@ -336,61 +160,60 @@ int main(int argc, char *argv[]) {
     RADE_COMP *tx_out      = malloc((size_t)n_tx_out       * sizeof(RADE_COMP));
     RADE_COMP *eoo_out     = malloc((size_t)n_eoo_out      * sizeof(RADE_COMP));
 
-    /* int16 output scratch — sized to the larger of tx / eoo frames */
-    int      out_buf_n = (n_eoo_out > n_tx_out) ? n_eoo_out : n_tx_out;
-    int16_t *out_buf   = malloc((size_t)out_buf_n * sizeof(int16_t));
+    /* real part scratch — sized to the larger of tx / eoo frames */
+    int    out_buf_n = (n_eoo_out > n_tx_out) ? n_eoo_out : n_tx_out;
+    float *out_buf   = malloc((size_t)out_buf_n * sizeof(float));
 
-    if (!features_in || !tx_out || !eoo_out || !out_buf) {
+    /* one chunk of input, and its 16 kHz output on top of a part frame */
+    float *mono   = malloc((size_t)MOD_CHUNK * sizeof(float));
+    float *speech = malloc((size_t)(max_16k + LPCNET_FRAME_SIZE) * sizeof(float));
+
+    rade_wav_writer out;
+    int ret = 1;
+    if (!features_in || !tx_out || !eoo_out || !out_buf || !mono || !speech) {
         fprintf(stderr, "rade_modulate: malloc failed\n");
-        free(features_in); free(tx_out); free(eoo_out); free(out_buf);
-        free(audio);
-        lpcnet_encoder_destroy(net);
-        rade_close(r); rade_finalize();
-        return 1;
+        goto done;
     }
 
     /* ---------------------------------------------------- open output WAV */
-    FILE *fout = fopen(output_file, "wb");
-    if (!fout) {
+    if (rade_wav_create(&out, output_file, RADE_FS) != 0) {
         fprintf(stderr, "rade_modulate: can't open '%s' for writing\n", output_file);
-        free(features_in); free(tx_out); free(eoo_out); free(out_buf);
-        free(audio);
-        lpcnet_encoder_destroy(net);
-        rade_close(r); rade_finalize();
-        return 1;
+        goto done;
     }
-    /* Placeholder header – data_size patched at the end. */
-    wav_write_header(fout, RADE_FS, 0);
-    uint32_t total_bytes = 0;
+    const rade_kernels *kern = rade_kernels_get();
 
     /* ---------------------------------------------------- modulation loop */
-    long pcm_pos   = 0;     /* position in 16 kHz speech buffer */
+    long n_speech  = 0;     /* 16 kHz samples waiting in speech */
     int  feat_idx  = 0;     /* feature frames buffered in features_in */
-    int  mf_count  = 0;     /* modem frames transmitted */
-
-    while (pcm_pos + LPCNET_FRAME_SIZE <= n_16k) {
-        /* float → int16 for LPCNet (matching lpcnet_demo rounding) */
-        opus_int16 pcm[LPCNET_FRAME_SIZE];
-        for (int i = 0; i < LPCNET_FRAME_SIZE; i++) {
-            float v = audio[pcm_pos + i] * 32768.0f;
-            if (v >  32767.0f)  v =  32767.0f;
-            if (v < -32767.0f)  v = -32767.0f;
-            pcm[i] = (opus_int16)floor(0.5 + (double)v);
-        }
-        pcm_pos += LPCNET_FRAME_SIZE;
-
-        /* extract one 10-ms feature frame directly into the TX buffer */
-        lpcnet_compute_single_frame_features(net,
-            pcm, &features_in[feat_idx * RADE_NB_TOTAL_FEATURES], arch);
-        feat_idx++;
-
-        /* full modem frame accumulated – encode + modulate */
-        if (feat_idx >= frames_per_mf) {
-            int n_out = rade_tx(r, tx_out, features_in);
-            total_bytes += write_iq_real(fout, out_buf, tx_out, n_out);
-            feat_idx = 0;
-            mf_count++;
+    int  eof       = 0;
+
+    while (!eof) {
+        long n = wav.left < MOD_CHUNK ? (long)wav.left : MOD_CHUNK;
+        n = (n > 0) ? rade_wav_read(&wav, mono, n) : 0;
+        eof = (n == 0 || wav.left == 0);
+        n_speech += rade_resampler_process(rs, mono, (int)n, &speech[n_speech], max_16k);
+
+        long pcm_pos = 0;   /* position in the 16 kHz speech buffer */
+        for (; pcm_pos + LPCNET_FRAME_SIZE <= n_speech; pcm_pos += LPCNET_FRAME_SIZE) {
+            /* float → int16 for LPCNet (matching lpcnet_demo rounding) */
+            opus_int16 pcm[LPCNET_FRAME_SIZE];
+            kern->float_to_s16(pcm, &speech[pcm_pos], 32768.0f, LPCNET_FRAME_SIZE);
+
+            /* extract one 10-ms feature frame directly into the TX buffer */
+            lpcnet_compute_single_frame_features(net,
+                pcm, &features_in[feat_idx * RADE_NB_TOTAL_FEATURES], arch);
+            feat_idx++;
+
+            /* full modem frame accumulated – encode + modulate */
+            if (feat_idx >= frames_per_mf) {
+                int n_out = rade_tx(r, tx_out, features_in);
+                res->out_bytes += write_iq_real(&out, out_buf, tx_out, n_out);
+                feat_idx = 0;
+                res->mf_count++;
+            }
         }
+        n_speech -= pcm_pos;
+        memmove(speech, &speech[pcm_pos], (size_t)n_speech * sizeof(float));
     }
 
     /* ------------------------------------------------ flush partial modem frame */
@@ -399,36 +222,292 @@ int main(int argc, char *argv[]) {
         memset(&features_in[feat_idx * RADE_NB_TOTAL_FEATURES], 0,
                (size_t)(frames_per_mf - feat_idx) * RADE_NB_TOTAL_FEATURES * sizeof(float));
         int n_out = rade_tx(r, tx_out, features_in);
-        total_bytes += write_iq_real(fout, out_buf, tx_out, n_out);
-        mf_count++;
+        res->out_bytes += write_iq_real(&out, out_buf, tx_out, n_out);
+        res->mf_count++;
     }
 
     /* ---------------------------------------------------- end-of-over frame */
     {
         int n_out = rade_tx_eoo(r, eoo_out);
-        total_bytes += write_iq_real(fout, out_buf, eoo_out, n_out);
+        res->out_bytes += write_iq_real(&out, out_buf, eoo_out, n_out);
     }
 
     /* -------------------------------------------------------- finalise WAV */
-    fseek(fout, 0, SEEK_SET);
-    wav_write_header(fout, RADE_FS, total_bytes);
-    fclose(fout);
+    if (rade_wav_finish(&out) != 0) {
+        fprintf(stderr, "rade_modulate: error writing '%s'\n", output_file);
+        goto done;
+    }
+    ret = 0;
+    res->cpu_s = now_s() - t_start;
 
     /* ------------------------------------------------------------ summary */
     if (verbose >= 1) {
-        fprintf(stderr, "Modem frames: %d + EOO\n", mf_count);
+        fprintf(stderr, "Modem frames: %d + EOO\n", res->mf_count);
         fprintf(stderr, "Output: %s  %.1f s  (%u bytes)\n",
-                output_file, (double)total_bytes / (2.0 * RADE_FS), total_bytes);
+                output_file, (double)res->out_bytes / (2.0 * RADE_FS), res->out_bytes);
     }
 
+done:
     /* -----------------------------------------------------------  cleanup */
     free(features_in);
     free(tx_out);
     free(eoo_out);
     free(out_buf);
-    free(audio);
-    lpcnet_encoder_destroy(net);
+    free(mono);
+    free(speech);
+    rade_resampler_destroy(rs);
+    rade_wav_close(&wav);
     rade_close(r);
-    rade_finalize();
+    return ret;
+}
+
+/* ---- Batch mode ---- */
+
+static int is_wav(const char *path) {
+    size_t n = strlen(path);
+    return n > 4 && strcasecmp(path + n - 4, ".wav") == 0;
+}
+
+static int cmp_str(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+typedef struct {
+    char **v;
+    int    n, cap;
+} str_list;
+
+static void list_add(str_list *l, const char *s) {
+    if (l->n == l->cap) {
+        l->cap = l->cap ? 2 * l->cap : 64;
+        l->v = realloc(l->v, (size_t)l->cap * sizeof(char *));
+        if (!l->v) { fprintf(stderr, "rade_modulate: out of memory\n"); exit(1); }
+    }
+    l->v[l->n++] = strdup(s);
+}
+
+static void list_free(str_list *l) {
+    for (int i = 0; i < l->n; i++) free(l->v[i]);
+    free(l->v);
+    memset(l, 0, sizeof(*l));
+}
+
+/* Expand the command line into input files: a directory means every .wav
+   file in it, @list a text file with one path per line, anything else is
+   taken as a file (the same rules as rade_demod -b) */
+static int collect_inputs(int argc, char *argv[], str_list *inputs) {
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        struct stat st;
+        if (arg[0] == '@' && arg[1] != '\0') {
+            FILE *f = fopen(arg + 1, "r");
+            if (!f) {
+                fprintf(stderr, "rade_modulate: can't open file list '%s'\n", arg + 1);
+                return -1;
+            }
+            char line[4096];
+            while (fgets(line, sizeof(line), f)) {
+                size_t n = strlen(line);
+                while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r' || line[n - 1] == ' '))
+                    line[--n] = '\0';
+                if (n > 0 && line[0] != '#') list_add(inputs, line);
+            }
+            fclose(f);
+        } else if (stat(arg, &st) == 0 && S_ISDIR(st.st_mode)) {
+            DIR *d = opendir(arg);
+            if (!d) continue;
+            str_list dir = {0};
+            struct dirent *e;
+            while ((e = readdir(d)) != NULL) {
+                char path[4096];
+                snprintf(path, sizeof(path), "%s/%s", arg, e->d_name);
+                if (is_wav(path) && stat(path, &st) == 0 && S_ISREG(st.st_mode)) list_add(&dir, path);
+            }
+            closedir(d);
+            if (dir.n > 0) qsort(dir.v, (size_t)dir.n, sizeof(char *), cmp_str);
+            for (int k = 0; k < dir.n; k++) list_add(inputs, dir.v[k]);
+            list_free(&dir);
+        } else {
+            list_add(inputs, arg);
+        }
+    }
     return 0;
 }
+
+typedef struct {
+    const str_list *inputs;
+    const str_list *outputs;
+    int             next;       /* next input to take, atomic */
+    pthread_mutex_t mtx;        /* stderr and the totals below */
+    int             n_done;
+    int             n_failed;
+    double          audio_s;
+    double          cpu_s;
+} mod_batch;
+
+static void *mod_worker(void *arg) {
+    mod_batch *b = (mod_batch *)arg;
+    /* one feature extractor per worker, re-used for each file it encodes */
+    LPCNetEncState *net = lpcnet_encoder_create();
+    for (int k; (k = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED)) < b->inputs->n; ) {
+        mod_result res;
+        int ret = net ? mod_file(b->inputs->v[k], b->outputs->v[k], 0, net, &res) : 1;
+
+        pthread_mutex_lock(&b->mtx);
+        b->n_done++;
+        if (ret != 0) {
+            b->n_failed++;
+            fprintf(stderr, "[%d/%d] %s: FAILED\n", b->n_done, b->inputs->n, b->inputs->v[k]);
+        } else {
+            b->audio_s += res.audio_s;
+            b->cpu_s += res.cpu_s;
+            fprintf(stderr, "[%d/%d] %s: %.1f s  modem frames: %d  rtf: %.3f\n",
+                    b->n_done, b->inputs->n, b->inputs->v[k], res.audio_s, res.mf_count,
+                    res.audio_s > 0.0 ? res.cpu_s / res.audio_s : 0.0);
+        }
+        pthread_mutex_unlock(&b->mtx);
+    }
+    if (net) lpcnet_encoder_destroy(net);
+    return NULL;
+}
+
+static int mod_batch_run(const str_list *inputs, const char *out_dir, int n_threads) {
+    /* outputs are named after the inputs, so two inputs with the same name
+       would overwrite each other */
+    str_list outputs = {0};
+    int ret = 1;
+    for (int i = 0; i < inputs->n; i++) {
+        const char *base = strrchr(inputs->v[i], '/');
+        base = base ? base + 1 : inputs->v[i];
+        char path[4096];
+        int len = (int)strlen(base);
+        if (is_wav(base)) len -= 4;
+        snprintf(path, sizeof(path), "%s/%.*s.wav", out_dir, len, base);
+        for (int j = 0; j < outputs.n; j++) {
+            if (strcmp(outputs.v[j], path) == 0) {
+                fprintf(stderr, "rade_modulate: more than one input named '%.*s.wav'\n", len, base);
+                goto done;
+            }
+        }
+        list_add(&outputs, path);
+    }
+    if (mkdir(out_dir, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "rade_modulate: can't create '%s'\n", out_dir);
+        goto done;
+    }
+
+    if (n_threads < 1) n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_threads < 1) n_threads = 1;
+    if (n_threads > inputs->n) n_threads = inputs->n;
+
+    mod_batch b;
+    memset(&b, 0, sizeof(b));
+    b.inputs = inputs;
+    b.outputs = &outputs;
+    pthread_mutex_init(&b.mtx, NULL);
+
+    double t_start = now_s();
+    pthread_t *pool = malloc((size_t)n_threads * sizeof(pthread_t));
+    int n_started = 0;
+    for (int i = 0; pool && i < n_threads; i++) {
+        if (pthread_create(&pool[i], NULL, mod_worker, &b) != 0) break;
+        n_started++;
+    }
+    if (n_started == 0) {
+        mod_worker(&b);     /* no threads, encode them here */
+    }
+    for (int i = 0; i < n_started; i++) pthread_join(pool[i], NULL);
+    free(pool);
+    pthread_mutex_destroy(&b.mtx);
+
+    double wall_s = now_s() - t_start;
+    fprintf(stderr, "Encoded %d files (%d failed) on %d threads: %.1f s of speech in %.1f s, "
+                    "%.1f audio-s/wall-s, rtf %.3f per thread\n",
+            inputs->n - b.n_failed, b.n_failed, n_started ? n_started : 1,
+            b.audio_s, wall_s, wall_s > 0.0 ? b.audio_s / wall_s : 0.0,
+            b.audio_s > 0.0 ? b.cpu_s / b.audio_s : 0.0);
+    ret = b.n_failed ? 1 : 0;
+
+done:
+    list_free(&outputs);
+    return ret;
+}
+
+/* ---- Usage ---- */
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: rade_modulate [options] <input.wav> <output.wav>\n"
+            "       rade_modulate [options] -b OUTDIR <input.wav|dir|@list>...\n\n"
+            "  Reads a WAV file containing speech audio and writes a WAV\n"
+            "  file containing RADE OFDM encoded audio.\n\n"
+            "  Input WAV : any sample rate, mono or stereo\n"
+            "              (resampled to %d Hz / mixed to mono internally)\n"
+            "  Output WAV: mono 16-bit PCM @ %d Hz (RADE modulated signal)\n\n"
+            "options:\n"
+            "  -h, --help     Show this help\n"
+            "  -v LEVEL       Verbosity: 0=quiet  1=normal (default)  2=verbose\n"
+            "  -b OUTDIR      Batch mode: encode every input (a file, every .wav in\n"
+            "                 a directory, or each path listed in @list) to\n"
+            "                 OUTDIR/<name>.wav, several files at a time\n"
+            "  -j THREADS     Batch mode worker threads (default: one per core)\n",
+            RADE_FS_SPEECH, RADE_FS);
+}
+
+/* ---- Main ---- */
+
+int main(int argc, char *argv[]) {
+    int verbose = 1;
+    int n_threads = 0;
+    const char *batch_dir = NULL;
+    int opt;
+    static struct option long_options[] = {
+        {"help", no_argument, NULL, 'h'},
+        {NULL,   0,           NULL, 0 }
+    };
+
+    while ((opt = getopt_long(argc, argv, "hv:b:j:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'h': usage(); return 0;
+            case 'v': verbose = atoi(optarg); break;
+            case 'b': batch_dir = optarg; break;
+            case 'j': n_threads = atoi(optarg); break;
+            default:  usage(); return 1;
+        }
+    }
+
+    rade_initialize();
+    int ret;
+
+    if (batch_dir) {
+        str_list inputs = {0};
+        if (argc - optind < 1 || collect_inputs(argc - optind, &argv[optind], &inputs) != 0) {
+            usage();
+            list_free(&inputs);
+            rade_finalize();
+            return 1;
+        }
+        if (inputs.n == 0) {
+            fprintf(stderr, "rade_modulate: no input files\n");
+            rade_finalize();
+            return 1;
+        }
+        ret = mod_batch_run(&inputs, batch_dir, n_threads);
+        list_free(&inputs);
+    } else {
+        if (argc - optind != 2) { usage(); rade_finalize(); return 1; }
+
+        LPCNetEncState *net = lpcnet_encoder_create();
+        if (!net) {
+            fprintf(stderr, "rade_modulate: lpcnet_encoder_create failed\n");
+            rade_finalize();
+            return 1;
+        }
+        mod_result res;
+        ret = mod_file(argv[optind], argv[optind + 1], verbose, net, &res);
+        lpcnet_encoder_destroy(net);
+    }
+
+    rade_finalize();
+    return ret;
+}
@@ -0,0 +1,220 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_ofdm_bench.c
+
+  Checks the FFT OFDM DFT/IDFT engine against the direct engine on random
+  symbols and whole modem frames, and times both.
+
+  usage: rade_ofdm_bench [-n iterations] [-t trials]
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "rade_dsp.h"
+#include "rade_ofdm.h"
+
+/* Relative error limit for the equivalence check, both engines are single
+   precision so we expect errors of a few float epsilons */
+#define MAX_REL_ERR 1E-5f
+
+/* Small deterministic PRNG so runs are repeatable across platforms */
+static unsigned int bench_seed = 1;
+
+static float bench_uniform(void) {
+    bench_seed = bench_seed * 1664525u + 1013904223u;
+    return ((bench_seed >> 8) + 0.5f) / 16777216.0f;
+}
+
+static RADE_COMP bench_gaussian(float sigma) {
+    float u1 = bench_uniform();
+    float u2 = bench_uniform();
+    float r = sigma * sqrtf(-2.0f * logf(u1));
+    return rade_cpolar(r, 2.0f * M_PI * u2);
+}
+
+/* max |a - b| / rms(b) over n samples */
+static float rel_err(const RADE_COMP *a, const RADE_COMP *b, int n) {
+    float max_err = 0.0f;
+    float power = 0.0f;
+    for (int i = 0; i < n; i++) {
+        float e = rade_cabs(rade_csub(a[i], b[i]));
+        if (e > max_err) max_err = e;
+        power += rade_cabs2(b[i]);
+    }
+    return max_err / sqrtf(power / n + 1E-30f);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1E-9 * ts.tv_nsec;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: rade_ofdm_bench [-n iterations] [-t trials]\n");
+    fprintf(stderr, "  -n  timed modem frames per engine (default 2000)\n");
+    fprintf(stderr, "  -t  random symbols/frames for the equivalence check (default 200)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = 2000;
+    int trials = 200;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "hn:t:")) != -1) {
+        switch (opt) {
+            case 'n': iterations = atoi(optarg); break;
+            case 't': trials = atoi(optarg); break;
+            case 'h': usage(); return 0;
+            default:  usage(); return 1;
+        }
+    }
+
+    static rade_ofdm ofdm_direct, ofdm_fft, ofdm_direct_b2, ofdm_fft_b2;
+    rade_ofdm_init(&ofdm_direct, 3, RADE_OFDM_ENGINE_DIRECT);
+    rade_ofdm_init(&ofdm_fft, 3, RADE_OFDM_ENGINE_FFT);
+    rade_ofdm_init(&ofdm_direct_b2, 2, RADE_OFDM_ENGINE_DIRECT);
+    rade_ofdm_init(&ofdm_fft_b2, 2, RADE_OFDM_ENGINE_FFT);
+    if (ofdm_fft.engine != RADE_OFDM_ENGINE_FFT) {
+        fprintf(stderr, "rade_ofdm_bench: FFT engine not available\n");
+        return 1;
+    }
+
+    /* Equivalence check over random carriers / time domain symbols */
+    float max_idft = 0.0f, max_dft = 0.0f, max_mod = 0.0f, max_demod = 0.0f;
+    float z[RADE_NZMF * RADE_LATENT_DIM];
+    float z_direct[RADE_NZMF * RADE_LATENT_DIM], z_fft[RADE_NZMF * RADE_LATENT_DIM];
+    static RADE_COMP tx_direct[RADE_NMF], tx_fft[RADE_NMF];
+    static RADE_COMP rx[RADE_NMF + RADE_M + RADE_NCP];
+
+    for (int i = 0; i < trials; i++) {
+        RADE_COMP freq[RADE_NC], t_direct[RADE_M], t_fft[RADE_M];
+        RADE_COMP time[RADE_M], f_direct[RADE_NC], f_fft[RADE_NC];
+        float e;
+
+        for (int c = 0; c < RADE_NC; c++) freq[c] = bench_gaussian(1.0f);
+        rade_ofdm_idft(&ofdm_direct, t_direct, freq);
+        rade_ofdm_idft(&ofdm_fft, t_fft, freq);
+        e = rel_err(t_fft, t_direct, RADE_M);
+        if (e > max_idft) max_idft = e;
+
+        for (int n = 0; n < RADE_M; n++) time[n] = bench_gaussian(1.0f);
+        rade_ofdm_dft(&ofdm_direct, f_direct, time);
+        rade_ofdm_dft(&ofdm_fft, f_fft, time);
+        e = rel_err(f_fft, f_direct, RADE_NC);
+        if (e > max_dft) max_dft = e;
+
+        /* Whole modem frame, modulate then demodulate with each engine */
+        for (int k = 0; k < RADE_NZMF * RADE_LATENT_DIM; k++) z[k] = 2.0f * bench_uniform() - 1.0f;
+        /* Bottleneck 2 limits the symbols rather than the time samples */
+        rade_ofdm_mod_frame(&ofdm_direct_b2, tx_direct, z);
+        rade_ofdm_mod_frame(&ofdm_fft_b2, tx_fft, z);
+        e = rel_err(tx_fft, tx_direct, RADE_NMF);
+        if (e > max_mod) max_mod = e;
+
+        rade_ofdm_mod_frame(&ofdm_direct, tx_direct, z);
+        rade_ofdm_mod_frame(&ofdm_fft, tx_fft, z);
+        e = rel_err(tx_fft, tx_direct, RADE_NMF);
+        if (e > max_mod) max_mod = e;
+
+        memset(rx, 0, sizeof(rx));
+        memcpy(rx, tx_direct, sizeof(tx_direct));
+        memcpy(&rx[RADE_NMF], tx_direct, sizeof(RADE_COMP) * (RADE_M + RADE_NCP));
+        float snr_direct, snr_fft;
+        int nz = rade_ofdm_demod_frame(&ofdm_direct, z_direct, rx, 0, 0, 1, &snr_direct);
+        rade_ofdm_demod_frame(&ofdm_fft, z_fft, rx, 0, 0, 1, &snr_fft);
+        float max_e = 0.0f, power = 0.0f;
+        for (int k = 0; k < nz; k++) {
+            float d = fabsf(z_fft[k] - z_direct[k]);
+            if (d > max_e) max_e = d;
+            power += z_direct[k] * z_direct[k];
+        }
+        e = max_e / sqrtf(power / nz + 1E-30f);
+        if (e > max_demod) max_demod = e;
+    }
+
+    /* Timing, one modem frame = Ns+1 IDFTs on Tx or DFTs on Rx, and the
+       whole modulator with the PA model */
+    double t_start, t_idft[2], t_dft[2], t_mod[2];
+    const rade_ofdm *engines[2] = {&ofdm_direct, &ofdm_fft};
+    RADE_COMP freq[RADE_NC], time[RADE_M];
+    for (int c = 0; c < RADE_NC; c++) freq[c] = bench_gaussian(1.0f);
+    volatile float sink = 0.0f;
+
+    for (int e = 0; e < 2; e++) {
+        t_start = now_s();
+        for (int i = 0; i < iterations; i++) {
+            for (int s = 0; s < RADE_NS + 1; s++) {
+                rade_ofdm_idft(engines[e], time, freq);
+            }
+            sink += time[0].real;
+        }
+        t_idft[e] = (now_s() - t_start) / iterations;
+
+        t_start = now_s();
+        for (int i = 0; i < iterations; i++) {
+            for (int s = 0; s < RADE_NS + 1; s++) {
+                rade_ofdm_dft(engines[e], freq, time);
+            }
+            sink += freq[0].real;
+        }
+        t_dft[e] = (now_s() - t_start) / iterations;
+
+        t_start = now_s();
+        for (int i = 0; i < iterations; i++) {
+            rade_ofdm_mod_frame(engines[e], tx_fft, z);
+            sink += tx_fft[0].real;
+        }
+        t_mod[e] = (now_s() - t_start) / iterations;
+    }
+
+    printf("idft  direct: %8.2f us/frame  fft: %8.2f us/frame  speedup: %.1fx\n",
+           1E6 * t_idft[0], 1E6 * t_idft[1], t_idft[0] / t_idft[1]);
+    printf(" dft  direct: %8.2f us/frame  fft: %8.2f us/frame  speedup: %.1fx\n",
+           1E6 * t_dft[0], 1E6 * t_dft[1], t_dft[0] / t_dft[1]);
+    printf(" mod  direct: %8.2f us/frame  fft: %8.2f us/frame  speedup: %.1fx\n",
+           1E6 * t_mod[0], 1E6 * t_mod[1], t_mod[0] / t_mod[1]);
+    printf("state size: %zu bytes\n", sizeof(rade_ofdm));
+
+    float max_err = fmaxf(fmaxf(max_idft, max_dft), fmaxf(max_mod, max_demod));
+    printf("equivalence check: %d trials, max rel err idft %.2e dft %.2e mod %.2e demod %.2e: %s\n",
+           trials, max_idft, max_dft, max_mod, max_demod, max_err < MAX_REL_ERR ? "PASS" : "FAIL");
+
+    return max_err < MAX_REL_ERR ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_shm_cat.c
+
+  Copies stdin into a new shared memory sample ring, or a ring out to
+  stdout, for feeding webrx_rade_decode -i / radae_headless shm: devices
+  from a file or pipe, and as a reference writer for the ring protocol in
+  rade_shm.h.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "rade_shm.h"
+
+static void usage(void) {
+    fprintf(stderr, "usage: rade_shm_cat -w [options] NAME < samples\n");
+    fprintf(stderr, "       rade_shm_cat NAME > samples\n");
+    fprintf(stderr, "  -h, --help              Show this help\n");
+    fprintf(stderr, "  -w                      Create ring NAME and fill it from stdin\n");
+    fprintf(stderr, "  -f s16|f32              Sample format (default s16)\n");
+    fprintf(stderr, "  -c 1|2                  Channels, 2 for interleaved IQ (default 1)\n");
+    fprintf(stderr, "  -r RATE                 Sample rate in Hz (default 8000)\n");
+    fprintf(stderr, "  -n FRAMES               Ring size, rounded up to a power of two\n");
+    fprintf(stderr, "                          (default one second)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "The writer waits for the reader rather than dropping samples, and once\n");
+    fprintf(stderr, "stdin ends waits for the ring to drain before closing it.  The reader\n");
+    fprintf(stderr, "copies the ring to stdout until its writer closes it.\n");
+}
+
+static int cat_in(const char *name, int format, int channels, int rate, int frames) {
+    rade_shm r;
+    if (rade_shm_create(&r, name, format, channels, rate, frames) != 0) {
+        fprintf(stderr, "rade_shm_cat: can't create ring %s\n", name);
+        return 1;
+    }
+
+    /* read straight into the ring, a block at a time */
+    int block = (int)r.hdr->capacity / 4;
+    int partial = 0;                            /* bytes of a frame read so far */
+    while (1) {
+        if (rade_shm_write_wait(&r, block, -1) < block) {
+            break;
+        }
+        uint8_t *p = (uint8_t *)rade_shm_write_ptr(&r);
+        size_t len = (size_t)block * r.frame_bytes;
+        size_t got = fread(p + partial, 1, len - (size_t)partial, stdin) + (size_t)partial;
+        int n = (int)(got / r.frame_bytes);
+        partial = (int)(got % r.frame_bytes);
+        /* a trailing part frame is already at the new write point */
+        if (n > 0) {
+            rade_shm_write_end(&r, n);
+        }
+        if (got < len) {
+            break;                              /* end of input */
+        }
+    }
+
+    rade_shm_write_wait(&r, (int)r.hdr->capacity, -1);
+    rade_shm_close(&r);
+    return 0;
+}
+
+static int cat_out(const char *name) {
+    rade_shm r;
+    if (rade_shm_attach(&r, name) != 0) {
+        fprintf(stderr, "rade_shm_cat: no ring %s\n", name);
+        return 1;
+    }
+
+    int n;
+    while ((n = rade_shm_read_wait(&r, 1, -1)) > 0) {
+        size_t wrote = fwrite(rade_shm_read_ptr(&r), r.frame_bytes, (size_t)n, stdout);
+        rade_shm_read_end(&r, n);
+        if (wrote != (size_t)n) {
+            break;
+        }
+        fflush(stdout);
+    }
+    rade_shm_close(&r);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    int writer = 0;
+    int format = RADE_SHM_S16;
+    int channels = 1;
+    int rate = 8000;
+    int frames = 0;
+
+    static struct option long_options[] = {
+        {"help", no_argument, NULL, 'h'},
+        {NULL,   0,           NULL, 0}
+    };
+
+    while ((opt = getopt_long(argc, argv, "hwf:c:r:n:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'w': writer = 1; break;
+            case 'f':
+                if (strcmp(optarg, "s16") == 0) format = RADE_SHM_S16;
+                else if (strcmp(optarg, "f32") == 0) format = RADE_SHM_F32;
+                else { usage(); return 1; }
+                break;
+            case 'c': channels = atoi(optarg); break;
+            case 'r': rate = atoi(optarg); break;
+            case 'n': frames = atoi(optarg); break;
+            case 'h': usage(); return 0;
+            default:  usage(); return 1;
+        }
+    }
+    if (optind != argc - 1 || channels < 1 || channels > 2 || rate < 1) {
+        usage();
+        return 1;
+    }
+    if (frames <= 0) {
+        frames = rate;
+    }
+
+    return writer ? cat_in(argv[optind], format, channels, rate, frames)
+                  : cat_out(argv[optind]);
+}
@@ -0,0 +1,451 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_tables_gen.c
+
+  Build time generator for rade_tables.c (see rade_tables.h).  Computes
+  the OFDM, acquisition, FFT and Hilbert tables exactly as the init
+  functions used to, and writes them as hex float initialisers so the
+  library's tables are bit identical to the runtime computation.
+
+  usage: rade_tables_gen rade_tables.c
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "rade_dsp.h"
+#include "rade_fft.h"
+#include "rade_kernels.h"
+#include "rade_bpf.h"
+#include "rade_hilbert.h"
+#include "rade_tables.h"
+
+/* The tables are large, keep them off the stack */
+static rade_ofdm_tables ofdm;
+static rade_eoo_tables  eoo_linear, eoo_limited;
+static rade_acq_tables  acq;
+static rade_fft_state   fft_ofdm, fft_acq, fft_bpf;
+static float            hilbert_c[RADE_HILBERT_NFOLD];
+
+/*---------------------------------------------------------------------------*\
+                                  OFDM
+\*---------------------------------------------------------------------------*/
+
+/* Through the direct engine's kernel, as rade_ofdm_idft() */
+static void idft_direct(const rade_kernels *kern, RADE_COMP *time_out, const RADE_COMP *freq_in) {
+    int M = RADE_M;
+    float re[RADE_M], im[RADE_M];
+
+    kern->cvmmul_split(re, im, freq_in, &ofdm.Wc_re[0][0], &ofdm.Wc_im[0][0],
+                       RADE_M, RADE_NC, M, 0);
+    for (int n = 0; n < M; n++) {
+        time_out[n] = rade_cscale(rade_cmplx(re[n], im[n]), 1.0f / M);
+    }
+}
+
+static void gen_ofdm(void) {
+    int Nc = RADE_NC;
+    int M = RADE_M;
+    int Ncp = RADE_NCP;
+    float Fs = (float)RADE_FS;
+
+    ofdm.local_path_delay_s = 0.0025f;  /* 2.5ms assumed path delay */
+
+    /* Calculate carrier frequencies
+       Centre signal on 1500 Hz (middle of SSB passband)
+       Rs' = Fs/M is the symbol rate with pilots and CP */
+    float Rs_dash = Fs / M;
+    float carrier_1_freq = 1500.0f - Rs_dash * Nc / 2.0f;
+    int carrier_1_index = (int)roundf(carrier_1_freq / Rs_dash);
+
+    for (int c = 0; c < Nc; c++) {
+        ofdm.w[c] = 2.0f * M_PI * (carrier_1_index + c) / M;
+    }
+
+    /* DFT engine: roots of unity for the direct engine, computed in double
+       as k*n mod M indexing means every entry is used at full precision */
+    ofdm.k0 = carrier_1_index;
+    assert(ofdm.k0 >= 0 && ofdm.k0 + Nc <= M);
+    for (int n = 0; n < M; n++) {
+        double theta = 2.0 * M_PI * (double)n / (double)M;
+        ofdm.W[n] = rade_cmplx((float)cos(theta), (float)sin(theta));
+    }
+    for (int c = 0; c < Nc; c++) {
+        int k = ofdm.k0 + c;
+        int idx = 0;                            /* k*n mod M */
+        for (int n = 0; n < M; n++) {
+            ofdm.Wc_re[c][n] = ofdm.W[idx].real;
+            ofdm.Wc_im[c][n] = ofdm.W[idx].imag;
+            idx += k;
+            if (idx >= M) idx -= M;
+        }
+    }
+
+    /* Pilot symbols, then time-domain pilots p = IDFT(P) */
+    rade_barker_pilots(ofdm.P, Nc);
+    rade_eoo_pilots(ofdm.Pend, ofdm.P, Nc);
+
+    const rade_kernels *kern = rade_kernels_get();
+    idft_direct(kern, ofdm.p, ofdm.P);
+    idft_direct(kern, ofdm.pend, ofdm.Pend);
+
+    /* Time-domain pilots with the last Ncp samples copied to the front as
+       the cyclic prefix */
+    for (int n = 0; n < M; n++) {
+        ofdm.p_cp[Ncp + n] = ofdm.p[n];
+        ofdm.pend_cp[Ncp + n] = ofdm.pend[n];
+    }
+    for (int n = 0; n < Ncp; n++) {
+        ofdm.p_cp[n] = ofdm.p[M - Ncp + n];
+        ofdm.pend_cp[n] = ofdm.pend[M - Ncp + n];
+    }
+
+    /* Equalization matrices for 3-pilot LS fit
+       For each carrier c, we fit: h = g0 + g1*exp(-j*w[c]*a)
+       where a = local_path_delay_s * Fs
+       Using pilots at c-1, c, c+1 (edge carriers use adjusted indices) */
+    float a = ofdm.local_path_delay_s * Fs;
+
+    for (int c = 0; c < Nc; c++) {
+        int c_mid = c;
+        /* Handle edge carriers */
+        if (c == 0) c_mid = 1;
+        if (c == Nc - 1) c_mid = Nc - 2;
+
+        /* A = [[1, exp(-j*w[c_mid-1]*a)],
+               [1, exp(-j*w[c_mid]*a)],
+               [1, exp(-j*w[c_mid+1]*a)]] */
+        RADE_COMP A[3][2];
+        for (int i = 0; i < 3; i++) {
+            A[i][0] = rade_cone();
+            A[i][1] = rade_cexp(-ofdm.w[c_mid - 1 + i] * a);
+        }
+
+        /* A^H * A (2x2 Hermitian matrix) */
+        RADE_COMP AHA[2][2];
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 2; j++) {
+                AHA[i][j] = rade_czero();
+                for (int k = 0; k < 3; k++) {
+                    AHA[i][j] = rade_cadd(AHA[i][j], rade_cmul(rade_cconj(A[k][i]), A[k][j]));
+                }
+            }
+        }
+
+        /* (A^H * A)^-1 (2x2 inverse) */
+        RADE_COMP det = rade_csub(rade_cmul(AHA[0][0], AHA[1][1]), rade_cmul(AHA[0][1], AHA[1][0]));
+        RADE_COMP AHAinv[2][2];
+        AHAinv[0][0] = rade_cdiv(AHA[1][1], det);
+        AHAinv[0][1] = rade_cdiv(rade_cscale(AHA[0][1], -1.0f), det);
+        AHAinv[1][0] = rade_cdiv(rade_cscale(AHA[1][0], -1.0f), det);
+        AHAinv[1][1] = rade_cdiv(AHA[0][0], det);
+
+        /* Pmat = (A^H * A)^-1 * A^H (2x3 matrix) */
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 3; j++) {
+                ofdm.Pmat[c][i][j] = rade_czero();
+                for (int k = 0; k < 2; k++) {
+                    ofdm.Pmat[c][i][j] = rade_cadd(ofdm.Pmat[c][i][j],
+                        rade_cmul(AHAinv[i][k], rade_cconj(A[j][k])));
+                }
+            }
+        }
+    }
+}
+
+/* EOO frame:
+   Normal frame: ...PDDDDP...
+   EOO frame:    ...PE000E... (P=pilot, E=EOO pilot, D=data, 0=zeros)
+   Frame structure: [p_cp][pend_cp][zeros...][pend_cp] */
+static void gen_eoo(rade_eoo_tables *t, int bottleneck) {
+    int M = RADE_M;
+    int Ncp = RADE_NCP;
+    int Nmf = RADE_NMF;
+
+    /* Bottleneck 3 (PA saturation) backs the pilots off 2 dB */
+    if (bottleneck == 3) {
+        float pilot_backoff = powf(10.0f, -2.0f / 20.0f);
+        t->pilot_gain = pilot_backoff * M / sqrtf((float)RADE_NC);
+    } else {
+        t->pilot_gain = 1.0f;
+    }
+
+    memset(t->eoo, 0, sizeof(t->eoo));
+    for (int n = 0; n < M + Ncp; n++) {
+        t->eoo[n] = rade_cscale(ofdm.p_cp[n], t->pilot_gain);
+        t->eoo[M + Ncp + n] = rade_cscale(ofdm.pend_cp[n], t->pilot_gain);
+        t->eoo[Nmf + n] = rade_cscale(ofdm.pend_cp[n], t->pilot_gain);
+    }
+    if (bottleneck == 3) {
+        for (int n = 0; n < RADE_NEOO; n++) {
+            t->eoo[n] = rade_tanh_limit(t->eoo[n]);
+        }
+    }
+    t->n_eoo = Nmf + M + Ncp;
+}
+
+/*---------------------------------------------------------------------------*\
+                              ACQUISITION
+\*---------------------------------------------------------------------------*/
+
+/* FFT search engine: with N = Fs/fstep every coarse frequency offset is a
+   whole number of bins.  Leaves nfft 0 if the grid doesn't allow it */
+static void gen_acq_fft(float fstep) {
+    static RADE_COMP x[RADE_FFT_MAX_N], X[RADE_FFT_MAX_N];
+    int buf_len = 2 * RADE_NMF + RADE_M + RADE_NCP;
+
+    int nfft = (int)roundf((float)RADE_FS / fstep);
+    if (nfft < buf_len || nfft > RADE_FFT_MAX_N ||
+        fabsf(nfft * fstep - (float)RADE_FS) > 1E-3f) {
+        return;
+    }
+
+    for (int f_idx = 0; f_idx < acq.n_fcoarse; f_idx++) {
+        float f = acq.fcoarse_range[f_idx];
+        int k = (int)roundf(f * nfft / RADE_FS);
+        if (fabsf(k * (float)RADE_FS / nfft - f) > 1E-3f) {
+            return;
+        }
+        acq.k_fcoarse[f_idx] = k;
+    }
+
+    if (rade_fft_init(&fft_acq, nfft) != 0) {
+        return;
+    }
+    acq.nfft = nfft;
+
+    /* Pilot spectrum, the frequency shifted pilot p[n]*exp(j*2*pi*k*n/N)
+       has spectrum P[(m-k) mod N] */
+    memcpy(x, ofdm.p, sizeof(RADE_COMP) * RADE_M);
+    rade_fft(&fft_acq, X, x);
+    for (int m = 0; m < nfft; m++) {
+        acq.P_conj[m] = rade_cconj(X[m]);
+    }
+}
+
+static void gen_acq(void) {
+    float frange = RADE_ACQ_FRANGE;
+    float fstep = RADE_ACQ_FSTEP;
+
+    RADE_COMP p_dot = rade_cdot(ofdm.p, ofdm.p, RADE_M);
+    acq.sigma_p = sqrtf(p_dot.real);
+
+    acq.n_fcoarse = 0;
+    for (float f = -frange / 2.0f; f < frange / 2.0f && acq.n_fcoarse < RADE_ACQ_NFREQ; f += fstep) {
+        acq.fcoarse_range[acq.n_fcoarse++] = f;
+    }
+
+    /* Frequency-shifted pilots: p_w[n][f_idx] = p[n] * exp(j*w*n)
+       where w = 2*pi*f/Fs */
+    for (int f_idx = 0; f_idx < acq.n_fcoarse; f_idx++) {
+        float f = acq.fcoarse_range[f_idx];
+        float w = 2.0f * M_PI * f / RADE_FS;
+
+        for (int n = 0; n < RADE_M; n++) {
+            RADE_COMP p_w = rade_cmul(rade_cexp(w * n), ofdm.p[n]);
+            acq.p_w_re[n][f_idx] = p_w.real;
+            acq.p_w_im[n][f_idx] = p_w.imag;
+        }
+    }
+
+    gen_acq_fft(fstep);
+}
+
+/*---------------------------------------------------------------------------*\
+                                HILBERT
+\*---------------------------------------------------------------------------*/
+
+/* h[n] = 2/(pi*n) for odd n, Hamming window over the 127 taps (matches the
+   original real2iq.c) */
+static void gen_hilbert(void) {
+    for (int j = 0; j < RADE_HILBERT_NFOLD; j++) {
+        int n = 2 * j + 1;
+        int i = RADE_HILBERT_DELAY + n;
+        float h = 2.0f / (M_PI * n);
+        float w = 0.54f - 0.46f * cosf(2.0f * M_PI * i / (RADE_HILBERT_NTAPS - 1));
+        hilbert_c[j] = h * w;
+    }
+}
+
+/*---------------------------------------------------------------------------*\
+                                 OUTPUT
+\*---------------------------------------------------------------------------*/
+
+static FILE *fout;
+
+/* %a round trips every float exactly */
+static void put_floats(const float *x, int n, const char *indent) {
+    fprintf(fout, "{");
+    for (int i = 0; i < n; i++) {
+        if (i % 4 == 0) fprintf(fout, "\n%s    ", indent);
+        fprintf(fout, "%af,%s", x[i], i % 4 == 3 || i == n - 1 ? "" : " ");
+    }
+    fprintf(fout, "\n%s}", indent);
+}
+
+static void put_comps(const RADE_COMP *x, int n, const char *indent) {
+    fprintf(fout, "{");
+    for (int i = 0; i < n; i++) {
+        if (i % 2 == 0) fprintf(fout, "\n%s    ", indent);
+        fprintf(fout, "{%af, %af},%s", x[i].real, x[i].imag, i % 2 == 1 || i == n - 1 ? "" : " ");
+    }
+    fprintf(fout, "\n%s}", indent);
+}
+
+static void put_ints(const int *x, int n) {
+    fprintf(fout, "{");
+    for (int i = 0; i < n; i++) {
+        fprintf(fout, "%s%d", i ? ", " : "", x[i]);
+    }
+    fprintf(fout, "}");
+}
+
+static void put_float_rows(const float *x, int rows, int cols) {
+    fprintf(fout, "{\n");
+    for (int r = 0; r < rows; r++) {
+        fprintf(fout, "        ");
+        put_floats(&x[r * cols], cols, "        ");
+        fprintf(fout, ",\n");
+    }
+    fprintf(fout, "    }");
+}
+
+static void put_ofdm(void) {
+    fprintf(fout, "const rade_ofdm_tables rade_ofdm_tab = {\n");
+    fprintf(fout, "    .k0 = %d,\n", ofdm.k0);
+    fprintf(fout, "    .w = ");       put_floats(ofdm.w, RADE_NC, "    ");         fprintf(fout, ",\n");
+    fprintf(fout, "    .W = ");       put_comps(ofdm.W, RADE_M, "    ");          fprintf(fout, ",\n");
+    fprintf(fout, "    .Wc_re = ");   put_float_rows(&ofdm.Wc_re[0][0], RADE_NC, RADE_M); fprintf(fout, ",\n");
+    fprintf(fout, "    .Wc_im = ");   put_float_rows(&ofdm.Wc_im[0][0], RADE_NC, RADE_M); fprintf(fout, ",\n");
+    fprintf(fout, "    .P = ");       put_comps(ofdm.P, RADE_NC, "    ");         fprintf(fout, ",\n");
+    fprintf(fout, "    .Pend = ");    put_comps(ofdm.Pend, RADE_NC, "    ");      fprintf(fout, ",\n");
+    fprintf(fout, "    .p = ");       put_comps(ofdm.p, RADE_M, "    ");          fprintf(fout, ",\n");
+    fprintf(fout, "    .pend = ");    put_comps(ofdm.pend, RADE_M, "    ");       fprintf(fout, ",\n");
+    fprintf(fout, "    .p_cp = ");    put_comps(ofdm.p_cp, RADE_M + RADE_NCP, "    ");    fprintf(fout, ",\n");
+    fprintf(fout, "    .pend_cp = "); put_comps(ofdm.pend_cp, RADE_M + RADE_NCP, "    "); fprintf(fout, ",\n");
+    fprintf(fout, "    .local_path_delay_s = %af,\n", ofdm.local_path_delay_s);
+    fprintf(fout, "    .Pmat = {\n");
+    for (int c = 0; c < RADE_NC; c++) {
+        fprintf(fout, "        {");
+        for (int i = 0; i < 2; i++) {
+            put_comps(ofdm.Pmat[c][i], 3, "        ");
+            fprintf(fout, i == 0 ? ", " : "");
+        }
+        fprintf(fout, "},\n");
+    }
+    fprintf(fout, "    },\n");
+    fprintf(fout, "};\n\n");
+}
+
+static void put_eoo(const char *name, const rade_eoo_tables *t) {
+    fprintf(fout, "const rade_eoo_tables %s = {\n", name);
+    fprintf(fout, "    .pilot_gain = %af,\n", t->pilot_gain);
+    fprintf(fout, "    .n_eoo = %d,\n", t->n_eoo);
+    fprintf(fout, "    .eoo = "); put_comps(t->eoo, t->n_eoo, "    "); fprintf(fout, ",\n");
+    fprintf(fout, "};\n\n");
+}
+
+static void put_acq(void) {
+    fprintf(fout, "const rade_acq_tables rade_acq_tab = {\n");
+    fprintf(fout, "    .n_fcoarse = %d,\n", acq.n_fcoarse);
+    fprintf(fout, "    .fcoarse_range = "); put_floats(acq.fcoarse_range, acq.n_fcoarse, "    "); fprintf(fout, ",\n");
+    fprintf(fout, "    .p_w_re = "); put_float_rows(&acq.p_w_re[0][0], RADE_M, RADE_ACQ_NFREQ); fprintf(fout, ",\n");
+    fprintf(fout, "    .p_w_im = "); put_float_rows(&acq.p_w_im[0][0], RADE_M, RADE_ACQ_NFREQ); fprintf(fout, ",\n");
+    fprintf(fout, "    .sigma_p = %af,\n", acq.sigma_p);
+    fprintf(fout, "    .nfft = %d,\n", acq.nfft);
+    if (acq.nfft) {
+        fprintf(fout, "    .k_fcoarse = "); put_ints(acq.k_fcoarse, acq.n_fcoarse); fprintf(fout, ",\n");
+        fprintf(fout, "    .P_conj = "); put_comps(acq.P_conj, acq.nfft, "    "); fprintf(fout, ",\n");
+    }
+    fprintf(fout, "};\n\n");
+}
+
+/* Only the n twiddles a plan uses are written, the rest are zero */
+static void put_fft(const char *name, const rade_fft_state *st) {
+    fprintf(fout, "const rade_fft_state %s = {\n", name);
+    fprintf(fout, "    .n = %d,\n", st->n);
+    fprintf(fout, "    .nfactors = %d,\n", st->nfactors);
+    if (st->n) {
+        fprintf(fout, "    .factors = "); put_ints(st->factors, 2 * st->nfactors); fprintf(fout, ",\n");
+        fprintf(fout, "    .twiddles = "); put_comps(st->twiddles, st->n, "    "); fprintf(fout, ",\n");
+    }
+    fprintf(fout, "};\n\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: rade_tables_gen rade_tables.c\n");
+        return 1;
+    }
+
+    gen_ofdm();
+    gen_eoo(&eoo_linear, 1);
+    gen_eoo(&eoo_limited, 3);
+    gen_acq();
+    gen_hilbert();
+    if (rade_fft_init(&fft_ofdm, RADE_M) != 0 || rade_fft_init(&fft_bpf, RADE_BPF_NFFT) != 0) {
+        fprintf(stderr, "rade_tables_gen: can't plan the OFDM/BPF FFTs\n");
+        return 1;
+    }
+    if (acq.nfft == 0) {
+        fprintf(stderr, "rade_tables_gen: warning, fstep=%f doesn't suit the FFT acquisition "
+                "engine, the receiver will use the direct search\n", RADE_ACQ_FSTEP);
+    }
+
+    fout = fopen(argv[1], "w");
+    if (fout == NULL) {
+        fprintf(stderr, "rade_tables_gen: can't create %s\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(fout, "/* Generated by rade_tables_gen, do not edit (see rade_tables.h) */\n\n");
+    fprintf(fout, "#include \"rade_tables.h\"\n\n");
+    put_ofdm();
+    put_eoo("rade_eoo_linear", &eoo_linear);
+    put_eoo("rade_eoo_limited", &eoo_limited);
+    put_acq();
+    put_fft("rade_fft_ofdm", &fft_ofdm);
+    put_fft("rade_fft_acq", &fft_acq);
+    put_fft("rade_fft_bpf", &fft_bpf);
+    fprintf(fout, "const float rade_hilbert_c[RADE_HILBERT_NFOLD] = ");
+    put_floats(hilbert_c, RADE_HILBERT_NFOLD, "");
+    fprintf(fout, ";\n");
+
+    if (fclose(fout) != 0) {
+        fprintf(stderr, "rade_tables_gen: error writing %s\n", argv[1]);
+        remove(argv[1]);
+        return 1;
+    }
+    return 0;
+}
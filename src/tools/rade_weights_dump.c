@@ -0,0 +1,84 @@
+/*---------------------------------------------------------------------------*\
+
+  rade_weights_dump.c
+
+  Writes the built-in RADE encoder and decoder weights to a weights blob,
+  for rade_open()'s model_file.
+
+\*---------------------------------------------------------------------------*/
+
+/*
+  Copyright (C) 2024 David Rowe
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  - Redistributions of source code must retain the above copyright
+  notice, this list of conditions and the following disclaimer.
+
+  - Redistributions in binary form must reproduce the above copyright
+  notice, this list of conditions and the following disclaimer in the
+  documentation and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE FOUNDATION OR
+  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "rade_enc.h"
+#include "rade_dec.h"
+#include "rade_weights.h"
+
+static void usage(void) {
+    fprintf(stderr, "usage: rade_weights_dump [-8] out.bin\n");
+    fprintf(stderr, "  -8  int8 only, leave out the float copy of quantised layers\n");
+}
+
+int main(int argc, char *argv[]) {
+    int int8 = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "h8")) != -1) {
+        switch (opt) {
+            case '8': int8 = 1; break;
+            case 'h': usage(); return 0;
+            default:  usage(); return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage();
+        return 1;
+    }
+    const char *path = argv[optind];
+
+    const WeightArray *const lists[] = {radeenc_arrays, radedec_arrays};
+    if (rade_weights_write(path, lists, 2, int8) != 0) {
+        fprintf(stderr, "rade_weights_dump: error writing %s\n", path);
+        return 1;
+    }
+
+    /* Read it back the way rade_open() will */
+    rade_weights_blob blob;
+    if (rade_weights_map(&blob, path) != 0) {
+        fprintf(stderr, "rade_weights_dump: %s doesn't parse\n", path);
+        return 1;
+    }
+    fprintf(stderr, "rade_weights_dump: %s %d arrays %.2f MB%s\n", path, blob.n,
+            blob.len / 1E6, int8 ? " (int8)" : "");
+    rade_weights_unmap(&blob);
+    return 0;
+}
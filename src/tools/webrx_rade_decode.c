@@ -11,6 +11,15 @@
   Combines a streaming Hilbert transform, RADAE RX (OFDM demod + neural
   decoder), and the FARGAN vocoder into a single command-line tool.
 
+  Wideband mode (-r) instead reads interleaved 16-bit IQ at a higher
+  sample rate, digitally down converts and decimates each channel given
+  with -c to 8 kHz, and decodes the channels in parallel on a pool of
+  worker threads.
+
+  Either way the input can instead come from a shared memory ring (see
+  rade_shm.h) written by a co-located SDR server, read in place, and the
+  decoded speech go to one, so no pipe sits in the hot path.
+
 \*---------------------------------------------------------------------------*/
 
 /*
@@ -46,9 +55,14 @@
 #include <stdint.h>
 #include <math.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
 
 #include "rade_api.h"
 #include "rade_dsp.h"
+#include "rade_hilbert.h"
+#include "rade_shm.h"
 #include "fargan.h"
 #include "lpcnet.h"
 
@@ -56,45 +70,373 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-/* ---- Hilbert transform (coefficients match real2iq.c exactly) ---- */
+/* ---- Channel decoder: RADE RX + FARGAN for one 8 kHz IQ stream ---- */
 
-#define HILBERT_NTAPS   127
-#define HILBERT_DELAY   ((HILBERT_NTAPS - 1) / 2)   /* 63 */
+#define MAX_CHANNELS    64
+#define N_8K_PER_FRAME  (LPCNET_FRAME_SIZE / 2)     /* 80 */
 
-static float hilbert_coeffs[HILBERT_NTAPS];
-static float hilbert_history[HILBERT_NTAPS];
+typedef struct {
+    int        index;
+    struct rade *r;
+    int        n_features_out;
+    float     *feat_buf;
+    float     *eoo_buf;
 
-static void init_hilbert(void) {
-    int center = HILBERT_DELAY;
-    for (int i = 0; i < HILBERT_NTAPS; i++) {
-        int n = i - center;
-        if (n == 0 || (n & 1) == 0) {
-            hilbert_coeffs[i] = 0.0f;
-        } else {
-            float h = 2.0f / (M_PI * n);
-            float w = 0.54f - 0.46f * cosf(2.0f * M_PI * i / (HILBERT_NTAPS - 1));
-            hilbert_coeffs[i] = h * w;
+    /* FARGAN vocoder */
+    FARGANState fargan;
+    int        fargan_ready;
+    float      cont_buf[5 * NB_TOTAL_FEATURES];
+    int        cont_frames;
+    int        was_synced;
+
+    /* Decoded 8 kHz speech waiting to be written */
+    int16_t   *out;
+    int        n_out;
+    int        out_cap;
+
+    /* Wideband mode: NCO + decimating lowpass into an 8 kHz IQ FIFO */
+    float      freq;            /* dial frequency offset from IQ centre (Hz) */
+    RADE_COMP  nco_phase;
+    RADE_COMP  nco_inc;
+    RADE_COMP  up_phase;        /* 8 kHz: the passband back up to 0..3 kHz */
+    RADE_COMP  up_inc;
+    RADE_COMP *dec_hist;        /* 2*ntaps, double length ring */
+    int        dec_pos;
+    int        dec_count;
+    RADE_COMP *iq_fifo;
+    int        n_fifo;
+    FILE      *fout;
+    rade_shm   ring;            /* decoded speech, with -O */
+
+    int        verbose;
+    int        mf_count;
+    int        vld_count;
+} rx_channel;
+
+static int channel_open(rx_channel *ch, int index, int flags, int verbose, float squelch_dB,
+                        float acq_range, float warm_s) {
+    memset(ch, 0, sizeof(*ch));
+    ch->index = index;
+    ch->verbose = verbose;
+
+    ch->r = rade_open_rx_only(NULL, flags);
+    if (!ch->r) {
+        fprintf(stderr, "rade_decode: rade_open failed\n");
+        return -1;
+    }
+    if (squelch_dB > 0.0f)
+        rade_set_acq_squelch(ch->r, squelch_dB, 25, 10);
+    if (warm_s > 0.0f)
+        rade_set_warm_reacquire(ch->r, warm_s);
+    if (acq_range > 0.0f) {
+        float range = rade_set_acq_range(ch->r, acq_range);
+        if (verbose >= 1 && index == 0)
+            fprintf(stderr, "acquisition range: +/- %.0f Hz\n", (double)range);
+    }
+
+    ch->n_features_out = rade_n_features_in_out(ch->r);
+    int n_eoo_bits     = rade_n_eoo_bits(ch->r);
+
+    ch->feat_buf = malloc((size_t)ch->n_features_out * sizeof(float));
+    ch->eoo_buf  = malloc((size_t)n_eoo_bits         * sizeof(float));
+
+    /* enough for two modem frames of speech */
+    ch->out_cap  = 2 * (ch->n_features_out / RADE_NB_TOTAL_FEATURES) * N_8K_PER_FRAME;
+    ch->out      = malloc((size_t)ch->out_cap * sizeof(int16_t));
+    if (!ch->feat_buf || !ch->eoo_buf || !ch->out) {
+        fprintf(stderr, "rade_decode: malloc failed\n");
+        return -1;
+    }
+
+    fargan_init(&ch->fargan);
+    return 0;
+}
+
+static void channel_close(rx_channel *ch) {
+    free(ch->feat_buf);
+    free(ch->eoo_buf);
+    free(ch->out);
+    free(ch->dec_hist);
+    free(ch->iq_fifo);
+    if (ch->fout) fclose(ch->fout);
+    rade_shm_close(&ch->ring);
+    if (ch->r) rade_close(ch->r);
+}
+
+/* Run one modem frame of rade_nin() IQ samples through RADE RX and FARGAN,
+   appending any decoded speech to ch->out */
+static void channel_rx_frame(rx_channel *ch, RADE_COMP *iq_buf) {
+    struct rade *r = ch->r;
+
+    /* RADE RX */
+    int has_eoo = 0;
+    int n_out   = rade_rx(r, ch->feat_buf, &has_eoo, ch->eoo_buf, iq_buf);
+
+    if (has_eoo && ch->verbose >= 1) {
+        if (ch->iq_fifo)
+            fprintf(stderr, "ch %d: ", ch->index);
+        fprintf(stderr, "End-of-over at modem frame %d\n", ch->mf_count);
+    }
+
+    /* Re-init FARGAN when sync is newly acquired so we get a clean
+       warm-up for each transmission. */
+    int synced = rade_sync(r);
+    if (synced && !ch->was_synced) {
+        fargan_init(&ch->fargan);
+        ch->fargan_ready = 0;
+        ch->cont_frames  = 0;
+    }
+    ch->was_synced = synced;
+
+    if (n_out > 0) {
+        ch->vld_count++;
+        int n_frames = n_out / RADE_NB_TOTAL_FEATURES;
+
+        for (int fi = 0; fi < n_frames; fi++) {
+            float *feat = &ch->feat_buf[fi * RADE_NB_TOTAL_FEATURES];
+
+            /* ---- FARGAN warm-up: buffer the first 5 frames ---- */
+            if (!ch->fargan_ready) {
+                memcpy(&ch->cont_buf[ch->cont_frames * NB_TOTAL_FEATURES],
+                       feat, (size_t)NB_TOTAL_FEATURES * sizeof(float));
+                if (++ch->cont_frames >= 5) {
+                    /* fargan_cont expects features packed at stride
+                       NB_FEATURES – copy only the first NB_FEATURES of
+                       each buffered frame, matching lpcnet_demo. */
+                    float packed[5 * NB_FEATURES];
+                    for (int i = 0; i < 5; i++)
+                        memcpy(&packed[i * NB_FEATURES],
+                               &ch->cont_buf[i * NB_TOTAL_FEATURES],
+                               (size_t)NB_FEATURES * sizeof(float));
+
+                    float zeros[FARGAN_CONT_SAMPLES];
+                    memset(zeros, 0, sizeof(zeros));
+                    fargan_cont(&ch->fargan, zeros, packed);
+                    ch->fargan_ready = 1;
+                }
+                continue;   /* warm-up frames are not synthesised */
+            }
+
+            /* ---- synthesise one 10 ms speech frame (160 @ 16 kHz) ---- */
+            float fpcm[LPCNET_FRAME_SIZE];
+            fargan_synthesize(&ch->fargan, fpcm, feat);
+
+            /* ---- downsample 16 kHz → 8 kHz (2:1) ---- */
+            if (ch->n_out + N_8K_PER_FRAME > ch->out_cap)
+                continue;   /* can't happen, sized for two modem frames */
+            int16_t *pcm_out = &ch->out[ch->n_out];
+            for (int s = 0; s < N_8K_PER_FRAME; s++) {
+                float v = (fpcm[2 * s] + fpcm[2 * s + 1]) * 0.5f * 32768.0f;
+                if (v >  32767.0f) v =  32767.0f;
+                if (v < -32767.0f) v = -32767.0f;
+                pcm_out[s] = (int16_t)floor(0.5 + (double)v);
+            }
+            ch->n_out += N_8K_PER_FRAME;
+        }
+    }
+    ch->mf_count++;
+}
+
+/* ---- Wideband channelizer ---- */
+
+/* The same one sided 0..3 kHz band the Hilbert transform gives the
+   narrowband path, so nothing either side of the dial (the LSB image)
+   gets in.  The channel is mixed down to put the band's centre at DC,
+   lowpassed to +/- CHAN_HALFBW_HZ with real taps, decimated, then mixed
+   back up at 8 kHz */
+#define CHAN_CENTRE_HZ  1500.0f
+#define CHAN_HALFBW_HZ  1500.0f     /* keeps the 0.7-2.3 kHz RADE signal */
+
+typedef struct {
+    int    fs;                      /* wideband IQ sample rate */
+    int    decim;                   /* fs / RADE_FS */
+    int    ntaps;
+    float *h;                       /* lowpass, symmetric */
+    int    block_in;                /* IQ samples per block */
+    const int16_t *block;           /* current block, interleaved I/Q */
+} channelizer;
+
+static int channelizer_init(channelizer *cz, int fs) {
+    memset(cz, 0, sizeof(*cz));
+    if (fs < RADE_FS || fs % RADE_FS) {
+        fprintf(stderr, "webrx_rade_decode: sample rate %d must be a multiple of %d\n", fs, RADE_FS);
+        return -1;
+    }
+    cz->fs    = fs;
+    cz->decim = fs / RADE_FS;
+    cz->ntaps = 32 * cz->decim + 1;     /* ~800 Hz transition */
+    cz->block_in = cz->decim * RADE_M;      /* 20 ms */
+
+    /* Hamming windowed sinc lowpass, unity gain at DC */
+    cz->h = malloc((size_t)cz->ntaps * sizeof(float));
+    if (!cz->h) return -1;
+    float fc = CHAN_HALFBW_HZ / fs;
+    float sum = 0.0f;
+    int centre = (cz->ntaps - 1) / 2;
+    for (int i = 0; i < cz->ntaps; i++) {
+        float w = 0.54f - 0.46f * cosf(2.0f * M_PI * i / (cz->ntaps - 1));
+        cz->h[i] = 2.0f * fc * rade_sinc(2.0f * fc * (i - centre)) * w;
+        sum += cz->h[i];
+    }
+    for (int i = 0; i < cz->ntaps; i++)
+        cz->h[i] /= sum;
+    return 0;
+}
+
+static int channel_init_wideband(rx_channel *ch, const channelizer *cz, float freq) {
+    ch->freq      = freq;
+    ch->nco_phase = rade_cone();
+    ch->nco_inc   = rade_cexp(-2.0f * M_PI * (freq + CHAN_CENTRE_HZ) / cz->fs);
+    ch->up_phase  = rade_cone();
+    ch->up_inc    = rade_cexp(2.0f * M_PI * CHAN_CENTRE_HZ / RADE_FS);
+    ch->dec_hist  = calloc((size_t)(2 * cz->ntaps), sizeof(RADE_COMP));
+    ch->iq_fifo   = malloc((size_t)(rade_nin_max(ch->r) + RADE_M) * sizeof(RADE_COMP));
+    if (!ch->dec_hist || !ch->iq_fifo) {
+        fprintf(stderr, "rade_decode: malloc failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* Mix the channel to baseband, lowpass, decimate to 8 kHz and mix back up
+   to 0..3 kHz, then decode every complete modem frame in the FIFO */
+static void channel_process_block(rx_channel *ch, const channelizer *cz) {
+    int L = cz->ntaps;
+    const float *h = cz->h;
+
+    for (int n = 0; n < cz->block_in; n++) {
+        RADE_COMP x = rade_cmplx(cz->block[2 * n] / 32768.0f, cz->block[2 * n + 1] / 32768.0f);
+        x = rade_cmul(x, ch->nco_phase);
+        ch->nco_phase = rade_cmul(ch->nco_phase, ch->nco_inc);
+
+        ch->dec_hist[ch->dec_pos] = x;
+        ch->dec_hist[ch->dec_pos + L] = x;
+        if (++ch->dec_pos == L) ch->dec_pos = 0;
+
+        if (++ch->dec_count == cz->decim) {
+            ch->dec_count = 0;
+            /* oldest to newest is dec_hist[dec_pos .. dec_pos+L-1], h symmetric */
+            const RADE_COMP *hist = &ch->dec_hist[ch->dec_pos];
+            RADE_COMP acc = rade_czero();
+            for (int k = 0; k < L; k++)
+                acc = rade_cadd(acc, rade_cscale(hist[k], h[k]));
+            ch->iq_fifo[ch->n_fifo++] = rade_cmul(acc, ch->up_phase);
+            ch->up_phase = rade_cmul(ch->up_phase, ch->up_inc);
         }
     }
-    memset(hilbert_history, 0, sizeof(hilbert_history));
+
+    /* Stop the NCO magnitudes drifting */
+    ch->nco_phase = rade_cscale(ch->nco_phase, 1.0f / rade_cabs(ch->nco_phase));
+    ch->up_phase  = rade_cscale(ch->up_phase,  1.0f / rade_cabs(ch->up_phase));
+
+    int nin = rade_nin(ch->r);
+    while (ch->n_fifo >= nin) {
+        channel_rx_frame(ch, ch->iq_fifo);
+        ch->n_fifo -= nin;
+        memmove(ch->iq_fifo, &ch->iq_fifo[nin], (size_t)ch->n_fifo * sizeof(RADE_COMP));
+        nin = rade_nin(ch->r);
+    }
 }
 
-/* Process one sample through the streaming Hilbert transform.
-   history[0] = most recent sample, history[NTAPS-1] = oldest. */
-static RADE_COMP hilbert_one(float sample) {
-    memmove(&hilbert_history[1], &hilbert_history[0],
-            (HILBERT_NTAPS - 1) * sizeof(float));
-    hilbert_history[0] = sample;
+/* ---- Worker pool ----
+   Each block is a set of per-channel tasks.  Idle workers (and the main
+   thread) claim the next unprocessed channel from a shared atomic counter,
+   so a slow channel (say one running the neural decoder while the others
+   are searching) doesn't hold up the rest. */
+
+typedef struct {
+    pthread_t      *threads;
+    int             n_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t  start_cond;
+    pthread_cond_t  done_cond;
+    int             generation;
+    int             n_done;
+    int             quit;
+    atomic_int      next_task;
+    int             n_tasks;
+    rx_channel     *channels;
+    channelizer    *cz;
+} work_pool;
+
+static void pool_do_tasks(work_pool *pool) {
+    int t;
+    while ((t = atomic_fetch_add(&pool->next_task, 1)) < pool->n_tasks)
+        channel_process_block(&pool->channels[t], pool->cz);
+}
 
-    RADE_COMP out;
-    out.real = hilbert_history[HILBERT_DELAY];
+static void *pool_worker(void *arg) {
+    work_pool *pool = (work_pool *)arg;
+    int seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->quit && pool->generation == seen)
+            pthread_cond_wait(&pool->start_cond, &pool->lock);
+        if (pool->quit) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
 
-    float imag = 0.0f;
-    for (int k = 0; k < HILBERT_NTAPS; k++)
-        imag += hilbert_coeffs[k] * hilbert_history[k];
-    out.imag = imag;
+        pool_do_tasks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (++pool->n_done == pool->n_threads)
+            pthread_cond_signal(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static int pool_start(work_pool *pool, int n_threads, rx_channel *channels, channelizer *cz) {
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    atomic_init(&pool->next_task, 0);
+    pool->channels = channels;
+    pool->cz       = cz;
+
+    pool->threads = calloc((size_t)(n_threads > 0 ? n_threads : 1), sizeof(pthread_t));
+    if (!pool->threads) return -1;
+    for (int i = 0; i < n_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool) != 0) {
+            fprintf(stderr, "webrx_rade_decode: can't start worker thread\n");
+            break;
+        }
+        pool->n_threads++;
+    }
+    return 0;
+}
 
-    return out;
+/* Process all channels for the current block, returns when all are done */
+static void pool_run(work_pool *pool, int n_tasks) {
+    pthread_mutex_lock(&pool->lock);
+    pool->n_tasks = n_tasks;
+    atomic_store(&pool->next_task, 0);
+    pool->n_done = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_do_tasks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->n_done < pool->n_threads)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void pool_stop(work_pool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->n_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+    free(pool->threads);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start_cond);
+    pthread_cond_destroy(&pool->done_cond);
 }
 
 /* ---- Usage ---- */
@@ -107,164 +449,314 @@ static void usage(void) {
             "  at %d Hz to stdout.\n\n"
             "options:\n"
             "  -h, --help     Show this help\n"
-            "  -v LEVEL       Verbosity: 0=quiet  1=normal (default)  2=verbose\n",
-            RADE_FS, RADE_FS);
+            "  -v LEVEL       Verbosity: 0=quiet  1=normal (default)  2=verbose\n"
+            "  -q DB          Skip the pilot search on frames with no signal-like\n"
+            "                 energy DB above the noise in the RADE band (3 is a\n"
+            "                 good start), saves CPU on quiet channels\n"
+            "  -F HZ          Acquire signals up to HZ off frequency (default 50,\n"
+            "                 up to about 700), for stations tuned by ear\n"
+            "  -W SECONDS     After a fade, also look near the last timing and\n"
+            "                 frequency for this long (5 is a good start)\n\n"
+            "wideband options:\n"
+            "  -r RATE        Input is interleaved 16-bit IQ at RATE Hz (multiple of %d)\n"
+            "  -c FREQ        Decode the USB channel with dial frequency FREQ Hz\n"
+            "                 relative to the IQ centre (repeat for up to %d channels)\n"
+            "  -j THREADS     Worker threads (default: number of CPUs)\n"
+            "  -o PREFIX      Write channel k to PREFIXk.s16 (files or FIFOs made\n"
+            "                 with mkfifo).  Without -o, stdout carries frames of\n"
+            "                 [uint16 channel][uint16 n] followed by n S16 samples\n\n"
+            "shared memory options (see rade_shm.h):\n"
+            "  -i NAME        Read the input from shared memory ring NAME instead of\n"
+            "                 stdin: S16 mono at %d Hz, or S16 IQ for wideband mode\n"
+            "                 at the ring's rate\n"
+            "  -O NAME        Write the decoded speech to a ring NAME (NAMEk for\n"
+            "                 channel k in wideband mode), S16 mono at %d Hz\n",
+            RADE_FS, RADE_FS, RADE_FS, MAX_CHANNELS, RADE_FS, RADE_FS);
 }
 
-/* ---- Main ---- */
-
-int main(int argc, char *argv[]) {
-    int verbose = 1;
-    int opt;
-    static struct option long_options[] = {
-        {"help", no_argument, NULL, 'h'},
-        {NULL,   0,           NULL, 0 }
-    };
-
-    while ((opt = getopt_long(argc, argv, "hv:", long_options, NULL)) != -1) {
-        switch (opt) {
-            case 'h': usage(); return 0;
-            case 'v': verbose = atoi(optarg); break;
-            default:  usage(); return 1;
-        }
-    }
+/* ---- Narrowband mode: one real audio stream ---- */
 
+static int run_narrowband(int verbose, float squelch_dB, float acq_range, float warm_s,
+                          rade_shm *in, const char *shm_out) {
     /* ---- init Hilbert transform ---- */
-    init_hilbert();
+    rade_hilbert hilbert;
+    rade_hilbert_init(&hilbert);
 
     /* ---- init RADE receiver ---- */
-    rade_initialize();
-
     int flags = (verbose < 2) ? RADE_VERBOSE_0 : 0;
-    char *model_name = "model19_check3/checkpoints/checkpoint_epoch_100.pth";
-    struct rade *r = rade_open(model_name, flags);
-    if (!r) {
-        fprintf(stderr, "rade_decode: rade_open failed\n");
-        rade_finalize();
+    rx_channel *ch = calloc(1, sizeof(rx_channel));
+    if (!ch || channel_open(ch, 0, flags, verbose, squelch_dB, acq_range, warm_s) != 0) {
+        if (ch) channel_close(ch);
+        free(ch);
         return 1;
     }
 
-    int nin_max        = rade_nin_max(r);
-    int n_features_out = rade_n_features_in_out(r);
-    int n_eoo_bits     = rade_n_eoo_bits(r);
+    int nin_max    = rade_nin_max(ch->r);
+    int n_eoo_bits = rade_n_eoo_bits(ch->r);
 
     if (verbose >= 1)
         fprintf(stderr, "nin_max: %d  n_features_out: %d  n_eoo_bits: %d\n",
-                nin_max, n_features_out, n_eoo_bits);
+                nin_max, ch->n_features_out, n_eoo_bits);
 
-    int16_t   *pcm_in   = malloc((size_t)nin_max        * sizeof(int16_t));
-    RADE_COMP *iq_buf    = malloc((size_t)nin_max        * sizeof(RADE_COMP));
-    float     *feat_buf  = malloc((size_t)n_features_out * sizeof(float));
-    float     *eoo_buf   = malloc((size_t)n_eoo_bits     * sizeof(float));
-    if (!pcm_in || !iq_buf || !feat_buf || !eoo_buf) {
+    int16_t   *pcm_in = malloc((size_t)nin_max * sizeof(int16_t));
+    float     *f_in   = malloc((size_t)nin_max * sizeof(float));
+    RADE_COMP *iq_buf = malloc((size_t)nin_max * sizeof(RADE_COMP));
+    if (!pcm_in || !f_in || !iq_buf) {
         fprintf(stderr, "rade_decode: malloc failed\n");
-        free(pcm_in); free(iq_buf); free(feat_buf); free(eoo_buf);
-        rade_close(r); rade_finalize();
+        free(pcm_in); free(f_in); free(iq_buf);
+        channel_close(ch); free(ch);
+        return 1;
+    }
+    if (shm_out && rade_shm_create(&ch->ring, shm_out, RADE_SHM_S16, 1, RADE_FS, RADE_FS) != 0) {
+        fprintf(stderr, "webrx_rade_decode: can't create shared memory ring '%s'\n", shm_out);
+        free(pcm_in); free(f_in); free(iq_buf);
+        channel_close(ch); free(ch);
         return 1;
     }
-
-    /* ---- init FARGAN vocoder ---- */
-    FARGANState fargan;
-    fargan_init(&fargan);
-
-    int   fargan_ready = 0;
-    float cont_buf[5 * NB_TOTAL_FEATURES];
-    int   cont_frames  = 0;
-    int   was_synced   = 0;
 
     /* ---- main processing loop ---- */
-    int mf_count  = 0;
-    int vld_count = 0;
-
     while (1) {
-        int nin = rade_nin(r);
-
-        /* Read nin S16 samples from stdin */
-        size_t n_read = fread(pcm_in, sizeof(int16_t), (size_t)nin, stdin);
-        if (n_read != (size_t)nin)
+        int nin = rade_nin(ch->r);
+
+        /* nin S16 samples, in place in the ring or read from stdin */
+        const int16_t *pcm = pcm_in;
+        if (in) {
+            if (rade_shm_read_wait(in, nin, -1) < 0)
+                break;
+            pcm = rade_shm_read_ptr(in);
+        } else if (fread(pcm_in, sizeof(int16_t), (size_t)nin, stdin) != (size_t)nin) {
             break;
+        }
 
         /* S16 → float → streaming Hilbert → IQ */
-        for (int i = 0; i < nin; i++) {
-            float sample = pcm_in[i] / 32768.0f;
-            iq_buf[i] = hilbert_one(sample);
-        }
+        for (int i = 0; i < nin; i++)
+            f_in[i] = pcm[i] / 32768.0f;
+        if (in)
+            rade_shm_read_end(in, nin);
+        rade_hilbert_process(&hilbert, iq_buf, f_in, nin);
+
+        channel_rx_frame(ch, iq_buf);
+
+        if (ch->ring.hdr)
+            rade_shm_write(&ch->ring, ch->out, ch->n_out);
+        else
+            fwrite(ch->out, sizeof(int16_t), (size_t)ch->n_out, stdout);
+        ch->n_out = 0;
+    }
 
-        /* RADE RX */
-        int has_eoo = 0;
-        int n_out   = rade_rx(r, feat_buf, &has_eoo, eoo_buf, iq_buf);
+    if (verbose >= 1)
+        fprintf(stderr, "Modem frames: %d   valid: %d\n", ch->mf_count, ch->vld_count);
 
-        if (has_eoo && verbose >= 1)
-            fprintf(stderr, "End-of-over at modem frame %d\n", mf_count);
+    /* ---- cleanup ---- */
+    free(pcm_in);
+    free(f_in);
+    free(iq_buf);
+    channel_close(ch);
+    free(ch);
+    return 0;
+}
 
-        /* Re-init FARGAN when sync is newly acquired so we get a clean
-           warm-up for each transmission. */
-        int synced = rade_sync(r);
-        if (synced && !was_synced) {
-            fargan_init(&fargan);
-            fargan_ready = 0;
-            cont_frames  = 0;
+/* ---- Wideband mode: K channels from one IQ stream ---- */
+
+static int run_wideband(int verbose, float squelch_dB, float acq_range, float warm_s,
+                        int fs, const float *freqs, int n_channels, int n_threads,
+                        const char *out_prefix, rade_shm *in, const char *shm_out) {
+    channelizer cz;
+    if (channelizer_init(&cz, fs) != 0)
+        return 1;
+    if (in && (int)in->hdr->capacity < cz.block_in) {
+        fprintf(stderr, "webrx_rade_decode: ring holds %u frames, needs at least %d\n",
+                in->hdr->capacity, cz.block_in);
+        free(cz.h);
+        return 1;
+    }
+
+    int flags = (verbose < 2) ? RADE_VERBOSE_0 : 0;
+    rx_channel *channels = calloc((size_t)n_channels, sizeof(rx_channel));
+    int16_t *block = malloc((size_t)(2 * cz.block_in) * sizeof(int16_t));
+    int ret = 1;
+    int n_open = 0;
+    if (!channels || !block) {
+        fprintf(stderr, "rade_decode: malloc failed\n");
+        goto cleanup;
+    }
+
+    for (n_open = 0; n_open < n_channels; n_open++) {
+        rx_channel *ch = &channels[n_open];
+        if (channel_open(ch, n_open, flags, verbose, squelch_dB, acq_range, warm_s) != 0 ||
+            channel_init_wideband(ch, &cz, freqs[n_open]) != 0) {
+            n_open++;
+            goto cleanup;
         }
-        was_synced = synced;
-
-        if (n_out > 0) {
-            vld_count++;
-            int n_frames = n_out / RADE_NB_TOTAL_FEATURES;
-
-            for (int fi = 0; fi < n_frames; fi++) {
-                float *feat = &feat_buf[fi * RADE_NB_TOTAL_FEATURES];
-
-                /* ---- FARGAN warm-up: buffer the first 5 frames ---- */
-                if (!fargan_ready) {
-                    memcpy(&cont_buf[cont_frames * NB_TOTAL_FEATURES],
-                           feat, (size_t)NB_TOTAL_FEATURES * sizeof(float));
-                    if (++cont_frames >= 5) {
-                        /* fargan_cont expects features packed at stride
-                           NB_FEATURES – copy only the first NB_FEATURES of
-                           each buffered frame, matching lpcnet_demo. */
-                        float packed[5 * NB_FEATURES];
-                        for (int i = 0; i < 5; i++)
-                            memcpy(&packed[i * NB_FEATURES],
-                                   &cont_buf[i * NB_TOTAL_FEATURES],
-                                   (size_t)NB_FEATURES * sizeof(float));
-
-                        float zeros[FARGAN_CONT_SAMPLES];
-                        memset(zeros, 0, sizeof(zeros));
-                        fargan_cont(&fargan, zeros, packed);
-                        fargan_ready = 1;
-                    }
-                    continue;   /* warm-up frames are not synthesised */
-                }
+        if (out_prefix) {
+            char fname[1024];
+            snprintf(fname, sizeof(fname), "%s%d.s16", out_prefix, n_open);
+            ch->fout = fopen(fname, "wb");
+            if (!ch->fout) {
+                fprintf(stderr, "webrx_rade_decode: can't open '%s'\n", fname);
+                n_open++;
+                goto cleanup;
+            }
+        }
+        if (shm_out) {
+            char rname[64];
+            snprintf(rname, sizeof(rname), "%s%d", shm_out, n_open);
+            if (rade_shm_create(&ch->ring, rname, RADE_SHM_S16, 1, RADE_FS, RADE_FS) != 0) {
+                fprintf(stderr, "webrx_rade_decode: can't create shared memory ring '%s'\n", rname);
+                n_open++;
+                goto cleanup;
+            }
+        }
+        if (verbose >= 1)
+            fprintf(stderr, "ch %d: %.1f Hz\n", n_open, (double)freqs[n_open]);
+    }
 
-                /* ---- synthesise one 10 ms speech frame (160 @ 16 kHz) ---- */
-                float fpcm[LPCNET_FRAME_SIZE];
-                fargan_synthesize(&fargan, fpcm, feat);
-
-                /* ---- downsample 16 kHz → 8 kHz (2:1) and write S16 ---- */
-                int n_8k = LPCNET_FRAME_SIZE / 2;   /* 80 */
-                int16_t pcm_out[LPCNET_FRAME_SIZE / 2];
-                for (int s = 0; s < n_8k; s++) {
-                    float v = (fpcm[2 * s] + fpcm[2 * s + 1]) * 0.5f * 32768.0f;
-                    if (v >  32767.0f) v =  32767.0f;
-                    if (v < -32767.0f) v = -32767.0f;
-                    pcm_out[s] = (int16_t)floor(0.5 + (double)v);
-                }
+    /* the main thread works too, so start one fewer worker */
+    if (n_threads > n_channels) n_threads = n_channels;
+    work_pool pool;
+    if (pool_start(&pool, n_threads - 1, channels, &cz) != 0)
+        goto cleanup;
+    if (verbose >= 1)
+        fprintf(stderr, "wideband: %d Hz  decim: %d  taps: %d  channels: %d  threads: %d\n",
+                fs, cz.decim, cz.ntaps, n_channels, pool.n_threads + 1);
 
-                fwrite(pcm_out, sizeof(int16_t), (size_t)n_8k, stdout);
+    while (1) {
+        /* the channels all read the block in place in the ring */
+        if (in) {
+            if (rade_shm_read_wait(in, cz.block_in, -1) < 0)
+                break;
+            cz.block = rade_shm_read_ptr(in);
+        } else {
+            if (fread(block, 2 * sizeof(int16_t), (size_t)cz.block_in, stdin) != (size_t)cz.block_in)
+                break;
+            cz.block = block;
+        }
+        pool_run(&pool, n_channels);
+        if (in)
+            rade_shm_read_end(in, cz.block_in);
+
+        /* Output in channel order so the stream is deterministic */
+        for (int k = 0; k < n_channels; k++) {
+            rx_channel *ch = &channels[k];
+            if (ch->n_out == 0) continue;
+            if (ch->ring.hdr) {
+                rade_shm_write(&ch->ring, ch->out, ch->n_out);
+            } else if (ch->fout) {
+                fwrite(ch->out, sizeof(int16_t), (size_t)ch->n_out, ch->fout);
+                fflush(ch->fout);
+            } else {
+                uint16_t hdr[2] = {(uint16_t)k, (uint16_t)ch->n_out};
+                fwrite(hdr, sizeof(hdr), 1, stdout);
+                fwrite(ch->out, sizeof(int16_t), (size_t)ch->n_out, stdout);
             }
+            ch->n_out = 0;
         }
-        mf_count++;
+        fflush(stdout);
     }
 
+    pool_stop(&pool);
+
     if (verbose >= 1)
-        fprintf(stderr, "Modem frames: %d   valid: %d\n", mf_count, vld_count);
+        for (int k = 0; k < n_channels; k++)
+            fprintf(stderr, "ch %d: Modem frames: %d   valid: %d\n",
+                    k, channels[k].mf_count, channels[k].vld_count);
+    ret = 0;
+
+cleanup:
+    if (channels)
+        for (int k = 0; k < n_open; k++)
+            channel_close(&channels[k]);
+    free(channels);
+    free(block);
+    free(cz.h);
+    return ret;
+}
+
+/* ---- Main ---- */
+
+int main(int argc, char *argv[]) {
+    int verbose = 1;
+    float squelch_dB = 0.0f;
+    float acq_range = 0.0f;
+    float warm_s = 0.0f;
+    int fs_wideband = 0;
+    float freqs[MAX_CHANNELS];
+    int n_channels = 0;
+    int n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char *out_prefix = NULL;
+    const char *shm_in = NULL;
+    const char *shm_out = NULL;
+    int opt;
+    static struct option long_options[] = {
+        {"help", no_argument, NULL, 'h'},
+        {NULL,   0,           NULL, 0 }
+    };
+
+    while ((opt = getopt_long(argc, argv, "hv:q:F:W:r:c:j:o:i:O:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'h': usage(); return 0;
+            case 'v': verbose = atoi(optarg); break;
+            case 'q': squelch_dB = (float)atof(optarg); break;
+            case 'F': acq_range = (float)atof(optarg); break;
+            case 'W': warm_s = (float)atof(optarg); break;
+            case 'r': fs_wideband = atoi(optarg); break;
+            case 'c':
+                if (n_channels == MAX_CHANNELS) {
+                    fprintf(stderr, "webrx_rade_decode: at most %d channels\n", MAX_CHANNELS);
+                    return 1;
+                }
+                freqs[n_channels++] = (float)atof(optarg);
+                break;
+            case 'j': n_threads = atoi(optarg); break;
+            case 'o': out_prefix = optarg; break;
+            case 'i': shm_in = optarg; break;
+            case 'O': shm_out = optarg; break;
+            default:  usage(); return 1;
+        }
+    }
+    if (n_threads < 1) n_threads = 1;
+
+    /* A ring says what it carries: IQ means wideband at the ring's rate */
+    rade_shm in;
+    memset(&in, 0, sizeof(in));
+    if (shm_in) {
+        if (rade_shm_attach(&in, shm_in) != 0) {
+            fprintf(stderr, "webrx_rade_decode: can't attach to shared memory ring '%s'\n", shm_in);
+            return 1;
+        }
+        int iq = in.hdr->channels == 2;
+        int rate = (int)in.hdr->sample_rate;
+        if (in.hdr->format != RADE_SHM_S16 || (!iq && (rate != RADE_FS || fs_wideband)) ||
+            (iq && fs_wideband && fs_wideband != rate)) {
+            fprintf(stderr, "webrx_rade_decode: ring '%s' is %s %s at %d Hz, not what was asked for\n",
+                    shm_in, in.hdr->format == RADE_SHM_S16 ? "S16" : "F32", iq ? "IQ" : "mono", rate);
+            rade_shm_close(&in);
+            return 1;
+        }
+        if (iq)
+            fs_wideband = rate;
+    }
+
+    if (fs_wideband == 0 && n_channels > 0) {
+        fprintf(stderr, "webrx_rade_decode: -c needs wideband input (-r RATE)\n");
+        return 1;
+    }
+    if (fs_wideband != 0 && n_channels == 0) {
+        fprintf(stderr, "webrx_rade_decode: wideband input needs at least one -c FREQ\n");
+        return 1;
+    }
+
+    rade_initialize();
+
+    int ret;
+    rade_shm *ring_in = shm_in ? &in : NULL;
+    if (fs_wideband)
+        ret = run_wideband(verbose, squelch_dB, acq_range, warm_s, fs_wideband, freqs, n_channels,
+                           n_threads, out_prefix, ring_in, shm_out);
+    else
+        ret = run_narrowband(verbose, squelch_dB, acq_range, warm_s, ring_in, shm_out);
+    rade_shm_close(&in);
 
-    /* ---- cleanup ---- */
-    free(pcm_in);
-    free(iq_buf);
-    free(feat_buf);
-    free(eoo_buf);
-    rade_close(r);
     rade_finalize();
-    return 0;
+    return ret;
 }
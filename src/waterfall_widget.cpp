@@ -1,7 +1,7 @@
 #include "waterfall_widget.h"
 #include <cmath>
 #include <algorithm>
-#include <cstring>
+#include <cstdint>
 #include <vector>
 
 /* ── internal state ─────────────────────────────────────────────────────── */
@@ -12,11 +12,25 @@ static constexpr float       DB_MAX    =   0.f;
 static constexpr int         N_BINS    = 256;
 static constexpr int         N_ROWS    = 200;
 
+/* margins match spectrum_widget for horizontal alignment */
+static constexpr int         MARGIN_L  = 36;    // left  (same as spectrum dB-label area)
+static constexpr int         MARGIN_R  = 10;    // right
+static constexpr int         MARGIN_T  =  2;    // top   (tight — spectrum is directly above)
+static constexpr int         MARGIN_B  =  2;    // bottom
+
+/* The pixel buffer is a ring of rows: `head` is the newest line, shown at
+ * the top, with older lines below it wrapping round from the end of the
+ * buffer to the start.  A new line overwrites the oldest row and moves
+ * head back one, so nothing is scrolled in memory; on_draw() shows the
+ * ring as two blits, and only rows written since the last draw are
+ * marked dirty on the surface. */
 struct WaterfallState {
     std::vector<uint32_t> pixels;                // N_BINS * N_ROWS, ARGB32
     uint32_t              lut[256];              // dB-to-color lookup table
     cairo_surface_t*      surface  = nullptr;
     float                 sample_rate = 8000.f;
+    int                   head      = 0;         // row of the newest line
+    int                   new_rows  = 0;         // lines pushed since the last draw
 };
 
 /* ── colour lookup table ────────────────────────────────────────────────── */
@@ -72,27 +86,44 @@ static gboolean on_draw(GtkWidget* widget, cairo_t* cr, gpointer /*data*/)
     double W = alloc.width;
     double H = alloc.height;
 
-    /* margins match spectrum_widget for horizontal alignment */
-    constexpr double ml = 36;   // left  (same as spectrum dB-label area)
-    constexpr double mr = 10;   // right
-    constexpr double mt =  2;   // top   (tight — spectrum is directly above)
-    constexpr double mb =  2;   // bottom
-
+    constexpr double ml = MARGIN_L, mr = MARGIN_R, mt = MARGIN_T, mb = MARGIN_B;
     double pw = W - ml - mr;
     double ph = H - mt - mb;
     if (pw < 10 || ph < 10) return FALSE;
 
+    /* hand the rows written since the last draw to Cairo, all of them
+       at once if the UI fell behind (one or two bands as the ring wraps) */
+    if (st->new_rows > 0) {
+        int first = st->head;
+        int n0    = std::min(st->new_rows, N_ROWS - first);
+        cairo_surface_mark_dirty_rectangle(st->surface, 0, first, N_BINS, n0);
+        if (st->new_rows > n0)
+            cairo_surface_mark_dirty_rectangle(st->surface, 0, 0, N_BINS, st->new_rows - n0);
+        st->new_rows = 0;
+    }
+
     /* overall background */
     cairo_set_source_rgb(cr, 0.11, 0.11, 0.14);
     cairo_paint(cr);
 
-    /* scale the N_BINS x N_ROWS pixel buffer to fill the plot area */
+    /* scale the N_BINS x N_ROWS ring to fill the plot area: rows head..end
+       at the top, then rows 0..head-1 */
+    int top = N_ROWS - st->head;
     cairo_save(cr);
     cairo_translate(cr, ml, mt);
     cairo_scale(cr, pw / N_BINS, ph / N_ROWS);
-    cairo_set_source_surface(cr, st->surface, 0, 0);
+
+    cairo_set_source_surface(cr, st->surface, 0, -st->head);
     cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
-    cairo_paint(cr);
+    cairo_rectangle(cr, 0, 0, N_BINS, top);
+    cairo_fill(cr);
+
+    if (st->head > 0) {
+        cairo_set_source_surface(cr, st->surface, 0, top);
+        cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+        cairo_rectangle(cr, 0, top, N_BINS, st->head);
+        cairo_fill(cr);
+    }
     cairo_restore(cr);
 
     /* plot border */
@@ -147,29 +178,38 @@ void waterfall_widget_update(GtkWidget* widget, const float* mag_dB, int n_bins,
 
     /* nullptr / 0 bins → clear the display */
     if (!mag_dB || n_bins <= 0) {
+        if (st->surface) cairo_surface_flush(st->surface);
         std::fill(st->pixels.begin(), st->pixels.end(), st->lut[0]);
+        st->head     = 0;
+        st->new_rows = 0;
         if (st->surface) cairo_surface_mark_dirty(st->surface);
         gtk_widget_queue_draw(widget);
         return;
     }
 
-    /* scroll: shift all rows down by one */
-    std::memmove(st->pixels.data() + N_BINS,
-                 st->pixels.data(),
-                 static_cast<size_t>((N_ROWS - 1) * N_BINS) * sizeof(uint32_t));
+    /* the new line replaces the oldest row and becomes the head */
+    if (st->surface) cairo_surface_flush(st->surface);
+    st->head     = (st->head + N_ROWS - 1) % N_ROWS;
+    st->new_rows = std::min(st->new_rows + 1, N_ROWS);
+    uint32_t* row = st->pixels.data() + static_cast<size_t>(st->head) * N_BINS;
 
-    /* write the new top row from magnitude data */
     int count = std::min(n_bins, N_BINS);
     for (int i = 0; i < count; i++) {
         float clamped = std::max(DB_MIN, std::min(DB_MAX, mag_dB[i]));
         float t = (clamped - DB_MIN) / (DB_MAX - DB_MIN);
         int idx = static_cast<int>(t * 255.f);
         idx = std::max(0, std::min(255, idx));
-        st->pixels[static_cast<size_t>(i)] = st->lut[idx];
+        row[i] = st->lut[idx];
     }
     for (int i = count; i < N_BINS; i++)
-        st->pixels[static_cast<size_t>(i)] = st->lut[0];
-
-    if (st->surface) cairo_surface_mark_dirty(st->surface);
-    gtk_widget_queue_draw(widget);
+        row[i] = st->lut[0];
+
+    /* every line on screen moves, but the margins and anything else in the
+       widget don't, so only the plot area is invalidated.  GTK folds the
+       updates between two frames into a single draw */
+    int w = gtk_widget_get_allocated_width(widget);
+    int h = gtk_widget_get_allocated_height(widget);
+    gtk_widget_queue_draw_area(widget, MARGIN_L, MARGIN_T,
+                               std::max(0, w - MARGIN_L - MARGIN_R),
+                               std::max(0, h - MARGIN_T - MARGIN_B));
 }
@@ -2,7 +2,8 @@
 #include <gtk/gtk.h>
 
 /* Create a waterfall-display GtkDrawingArea.
- *   - Call waterfall_widget_update() regularly to push fresh magnitude data.
+ *   - Call waterfall_widget_update() regularly to push fresh magnitude data,
+ *     one line per call.  Lines pushed between two redraws are drawn together.
  *   - mag_dB[] contains n_bins values in dB (0 dB = full-scale).
  *   - sample_rate is used for frequency-axis scaling.
  *   - Passing nullptr or n_bins==0 clears the display.